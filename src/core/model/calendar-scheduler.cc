@@ -252,6 +252,49 @@ CalendarScheduler::Remove (const Event &ev)
   NS_ASSERT (false);
 }
 
+uint32_t
+CalendarScheduler::GetN (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_qSize;
+}
+
+uint32_t
+CalendarScheduler::DoCompact (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t removed = 0;
+  for (uint32_t bucket = 0; bucket < m_nBuckets; bucket++)
+    {
+      Bucket::iterator i = m_buckets[bucket].begin ();
+      while (i != m_buckets[bucket].end ())
+        {
+          if (i->impl->IsCancelled ())
+            {
+              i->impl->Unref ();
+              i = m_buckets[bucket].erase (i);
+              removed++;
+            }
+          else
+            {
+              ++i;
+            }
+        }
+    }
+  m_qSize -= removed;
+  // resize once to the number of buckets ResizeDown would reach
+  uint32_t newSize = m_nBuckets;
+  while (m_qSize < newSize / 2)
+    {
+      newSize /= 2;
+    }
+  if (newSize != m_nBuckets)
+    {
+      Resize (newSize);
+    }
+  return removed;
+}
+
 void
 CalendarScheduler::ResizeUp (void)
 {
@@ -127,6 +127,12 @@ DefaultSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
   m_events = scheduler;
 }
 
+Ptr<Scheduler>
+DefaultSimulatorImpl::GetScheduler (void) const
+{
+  return m_events;
+}
+
 // System ID for non-distributed simulation is always zero
 uint32_t 
 DefaultSimulatorImpl::GetSystemId (void) const
@@ -138,6 +144,7 @@ void
 DefaultSimulatorImpl::ProcessOneEvent (void)
 {
   Scheduler::Event next = m_events->RemoveNext ();
+  m_events->NotifyRemoveNext (next);
 
   NS_ASSERT (next.key.m_ts >= m_currentTs);
   m_unscheduledEvents--;
@@ -363,6 +370,12 @@ DefaultSimulatorImpl::Cancel (const EventId &id)
   if (!IsExpired (id))
     {
       id.PeekEventImpl ()->Cancel ();
+      if (id.GetUid () != 2)
+        {
+          // the event stays in the event list, unless the scheduler
+          // compacts it now
+          m_unscheduledEvents -= m_events->NotifyCancel ();
+        }
     }
 }
 
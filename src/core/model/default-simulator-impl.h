@@ -78,6 +78,14 @@ public:
   virtual uint32_t GetSystemId (void) const; 
   virtual uint32_t GetContext (void) const;
 
+  /**
+   * Get the scheduler of the event list, for instance to read the
+   * statistics of its cancelled events.
+   *
+   * \returns The scheduler.
+   */
+  Ptr<Scheduler> GetScheduler (void) const;
+
 private:
   virtual void DoDispose (void);
 
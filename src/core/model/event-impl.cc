@@ -21,6 +21,8 @@
 #include "event-impl.h"
 #include "log.h"
 
+#include <cstring>
+
 /**
  * \file
  * \ingroup events
@@ -66,4 +68,54 @@ EventImpl::IsCancelled (void)
   return m_cancel;
 }
 
+EventImpl::Target::Target ()
+  : object (0),
+    function (0)
+{
+}
+
+EventImpl::Target
+EventImpl::GetTarget (void) const
+{
+  return Target ();
+}
+
+const void *
+EventImpl::GetMemberFunction (const void *mem, std::size_t size, const void *obj)
+{
+#if defined (__GNUC__) && !defined (_WIN32)
+  // A pair of the function pointer, or of the vtable offset of a
+  // virtual method, and of the adjustment of the object pointer.
+  intptr_t words[2];
+  if (size != sizeof (words))
+    {
+      return 0;
+    }
+  std::memcpy (words, mem, sizeof (words));
+  intptr_t ptr = words[0];
+  intptr_t adj = words[1];
+#if defined (__arm__) || defined (__aarch64__)
+  // The ARM variant flags the virtual methods in the adjustment.
+  bool isVirtual = adj & 1;
+  adj >>= 1;
+#else
+  bool isVirtual = ptr & 1;
+  ptr -= isVirtual;
+#endif
+  if (!isVirtual)
+    {
+      return reinterpret_cast<const void *> (ptr);
+    }
+  if (obj == 0)
+    {
+      return 0;
+    }
+  const char *self = static_cast<const char *> (obj) + adj;
+  const char *vtable = *reinterpret_cast<const char * const *> (self);
+  return *reinterpret_cast<const void * const *> (vtable + ptr);
+#else
+  return 0;
+#endif
+}
+
 } // namespace ns3
@@ -21,6 +21,8 @@
 #define EVENT_IMPL_H
 
 #include <stdint.h>
+#include <cstddef>
+#include <typeinfo>
 #include "simple-ref-count.h"
 
 /**
@@ -66,6 +68,37 @@ public:
    */
   bool IsCancelled (void);
 
+  /** The method or function called by an event, for profiling. */
+  struct Target
+  {
+    /** Constructor: neither the object nor the function are known. */
+    Target ();
+    const std::type_info *object;  //!< The dynamic type of the object called, or 0.
+    const void *function;          //!< The address of the code called, or 0.
+  };
+  /**
+   * Get the method or function called by this event.
+   *
+   * The events made by MakeEvent() report the object and method,
+   * or the function, they call.  Other events report neither.
+   *
+   * \returns The event target.
+   */
+  virtual Target GetTarget (void) const;
+  /**
+   * Get the address of the code called through a pointer to member
+   * function, looking up virtual methods in the object.
+   *
+   * This decodes the Itanium C++ ABI representation of the pointers
+   * to member functions, used by GCC and Clang.
+   *
+   * \param [in] mem The pointer to member function.
+   * \param [in] size The size of the pointer to member function.
+   * \param [in] obj The object, as an instance of the class of the method.
+   * \returns The code address, or 0 if the representation is not known.
+   */
+  static const void * GetMemberFunction (const void *mem, std::size_t size, const void *obj);
+
 protected:
   /**
    * Implementation for Invoke().
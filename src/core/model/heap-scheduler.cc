@@ -243,5 +243,40 @@ HeapScheduler::Remove (const Event &ev)
   NS_ASSERT (false);
 }
 
+uint32_t
+HeapScheduler::GetN (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_heap.size () - 1;
+}
+
+uint32_t
+HeapScheduler::DoCompact (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t removed = 0;
+  uint32_t last = Root ();
+  for (uint32_t i = Root (); i < m_heap.size (); i++)
+    {
+      if (m_heap[i].impl->IsCancelled ())
+        {
+          m_heap[i].impl->Unref ();
+          removed++;
+        }
+      else
+        {
+          m_heap[last] = m_heap[i];
+          last++;
+        }
+    }
+  m_heap.resize (last);
+  // rebuild the heap from its lowest parents up
+  for (uint32_t i = Parent (Last ()); i >= Root (); i--)
+    {
+      TopDown (i);
+    }
+  return removed;
+}
+
 } // namespace ns3
 
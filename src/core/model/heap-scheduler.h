@@ -70,8 +70,12 @@ public:
   virtual Scheduler::Event PeekNext (void) const;
   virtual Scheduler::Event RemoveNext (void);
   virtual void Remove (const Scheduler::Event &ev);
+  virtual uint32_t GetN (void) const;
 
 private:
+  // Inherited
+  virtual uint32_t DoCompact (void);
+
   /** Event list type:  vector of Events, managed as a heap. */
   typedef std::vector<Scheduler::Event> BinaryHeap;
 
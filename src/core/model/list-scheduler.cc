@@ -108,4 +108,33 @@ ListScheduler::Remove (const Event &ev)
   NS_ASSERT (false);
 }
 
+uint32_t
+ListScheduler::GetN (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_events.size ();
+}
+
+uint32_t
+ListScheduler::DoCompact (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t removed = 0;
+  EventsI i = m_events.begin ();
+  while (i != m_events.end ())
+    {
+      if (i->impl->IsCancelled ())
+        {
+          i->impl->Unref ();
+          i = m_events.erase (i);
+          removed++;
+        }
+      else
+        {
+          i++;
+        }
+    }
+  return removed;
+}
+
 } // namespace ns3
@@ -0,0 +1,872 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "log-binary.h"
+
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <vector>
+#include "ns3/core-config.h"
+#include "fatal-error.h"
+#include "nstime.h"
+
+#ifdef HAVE_STDLIB_H
+#include <cstdlib>
+#endif
+
+/**
+ * \file
+ * \ingroup logbinary
+ * Binary logging backend implementation.
+ *
+ * The file starts with MAGIC, followed by chunks starting with a
+ * chunk type byte:
+ *   - SITE_CHUNK: uint32_t id, int32_t level, uint8_t kind,
+ *     int32_t line, and the component, function and file strings,
+ *     each as a uint32_t length and the characters.
+ *   - RECORD_CHUNK: uint32_t thread serial number, int32_t time
+ *     resolution, uint32_t length, and the records.
+ *
+ * A record is uint32_t length (of the whole record), uint32_t site
+ * id, uint8_t flags, int64_t time step if HAS_TIME, uint32_t context
+ * if HAS_NODE, and the arguments, each as a LogRecord::Tag byte and
+ * the value, or a uint32_t length and the characters for STRING and
+ * TEXT.
+ *
+ * This file doesn't log: it implements logging.
+ */
+
+namespace ns3 {
+
+/** The buffer of a record, and its text stream. */
+struct LogRecord::Frame
+{
+  std::vector<uint8_t> data;  //!< The record.
+  std::ostringstream text;    //!< Formats the arguments recorded as text.
+};
+
+namespace {
+
+/** The first bytes of a binary log file. */
+const char MAGIC[8] = { 'n', 's', '3', 'b', 'l', 'o', 'g', '1' };
+/** Chunk type of a call site. */
+const uint8_t SITE_CHUNK = 'S';
+/** Chunk type of the records of a thread buffer. */
+const uint8_t RECORD_CHUNK = 'R';
+
+/** Record flag: the component had LOG_PREFIX_FUNC. */
+const uint8_t PREFIX_FUNC = 0x01;
+/** Record flag: the component had LOG_PREFIX_LEVEL. */
+const uint8_t PREFIX_LEVEL = 0x02;
+/** Record flag: the record has a time step. */
+const uint8_t HAS_TIME = 0x04;
+/** Record flag: the record has a node context. */
+const uint8_t HAS_NODE = 0x08;
+
+/** Size above which a thread buffer is written to the file. */
+const uint32_t BUFFER_SIZE = 1 << 20;
+
+/** A registered call site. */
+struct SiteInfo
+{
+  std::string component;  //!< Log component name.
+  std::string function;   //!< Function name.
+  std::string file;       //!< Source file name.
+  int32_t line;           //!< Source line.
+  int32_t level;          //!< Log level of the message.
+  uint8_t kind;           //!< LogSite::Kind.
+};
+
+/** The binary log file, or 0. */
+std::ofstream *g_file = 0;
+/** Whether the binary backend is enabled. */
+bool g_enabled = false;
+/** The LogBinaryTimeSource. */
+LogBinaryTimeSource g_timeSource = 0;
+/** The LogBinaryNodeSource. */
+LogBinaryNodeSource g_nodeSource = 0;
+/** The next thread buffer serial number. */
+std::atomic<uint32_t> g_nextSerial (0);
+
+/**
+ * Get the mutex protecting the file and the call sites.
+ * \returns The mutex.
+ */
+std::mutex &
+GetMutex (void)
+{
+  static std::mutex mutex;
+  return mutex;
+}
+
+/**
+ * Get the registered call sites, indexed by id.
+ * \returns The call sites.
+ */
+std::vector<SiteInfo> &
+GetSites (void)
+{
+  static std::vector<SiteInfo> sites;
+  return sites;
+}
+
+/**
+ * Write bytes to a stream.
+ * \param [in,out] os The stream.
+ * \param [in] data The bytes.
+ * \param [in] size The number of bytes.
+ */
+void
+WriteBytes (std::ostream & os, const void *data, uint32_t size)
+{
+  os.write (static_cast<const char *> (data), size);
+}
+
+/**
+ * Write a length and the characters of a string to a stream.
+ * \param [in,out] os The stream.
+ * \param [in] s The string.
+ */
+void
+WriteString (std::ostream & os, const std::string & s)
+{
+  uint32_t size = s.size ();
+  WriteBytes (os, &size, sizeof (size));
+  WriteBytes (os, s.data (), size);
+}
+
+/**
+ * Write a call site chunk.  The mutex must be held.
+ * \param [in,out] os The stream.
+ * \param [in] id The call site id.
+ * \param [in] site The call site.
+ */
+void
+WriteSite (std::ostream & os, uint32_t id, const SiteInfo & site)
+{
+  WriteBytes (os, &SITE_CHUNK, 1);
+  WriteBytes (os, &id, sizeof (id));
+  WriteBytes (os, &site.level, sizeof (site.level));
+  WriteBytes (os, &site.kind, 1);
+  WriteBytes (os, &site.line, sizeof (site.line));
+  WriteString (os, site.component);
+  WriteString (os, site.function);
+  WriteString (os, site.file);
+}
+
+/** The records of a thread, and the frames of the records being built. */
+struct ThreadBuffer
+{
+  ThreadBuffer ();
+  ~ThreadBuffer ();
+  /** Write the records to the file, if it is open, and empty the buffer. */
+  void Write (void);
+
+  std::vector<uint8_t> records;         //!< Finished records.
+  std::deque<LogRecord::Frame> frames;  //!< Record frames, by nesting depth.
+  uint32_t depth;                       //!< Number of records being built.
+  uint32_t serial;                      //!< Thread serial number.
+};
+
+/** The buffer of each thread. */
+thread_local ThreadBuffer g_threadBuffer;
+
+/**
+ * Parse the \c binary=<file> token of the \c NS_LOG environment
+ * variable, once.
+ */
+void
+CheckEnvironment (void)
+{
+  static bool checked = false;
+  if (checked)
+    {
+      return;
+    }
+  checked = true;
+#ifdef HAVE_GETENV
+  char *envVar = getenv ("NS_LOG");
+  if (envVar == 0)
+    {
+      return;
+    }
+  std::string env = envVar;
+  std::string::size_type cur = 0;
+  std::string::size_type next = 0;
+  while (next != std::string::npos)
+    {
+      next = env.find_first_of (":", cur);
+      std::string tmp = std::string (env, cur, next - cur);
+      if (tmp.substr (0, 7) == "binary=")
+        {
+          LogBinaryEnable (tmp.substr (7));
+        }
+      cur = next + 1;
+    }
+#endif
+}
+
+} // unnamed namespace
+
+
+ThreadBuffer::ThreadBuffer ()
+  : depth (0),
+    serial (g_nextSerial++)
+{
+}
+
+ThreadBuffer::~ThreadBuffer ()
+{
+  Write ();
+}
+
+void
+ThreadBuffer::Write (void)
+{
+  if (records.empty ())
+    {
+      return;
+    }
+  {
+    std::lock_guard<std::mutex> lock (GetMutex ());
+    if (g_file != 0)
+      {
+        int32_t resolution = Time::GetResolution ();
+        uint32_t size = records.size ();
+        WriteBytes (*g_file, &RECORD_CHUNK, 1);
+        WriteBytes (*g_file, &serial, sizeof (serial));
+        WriteBytes (*g_file, &resolution, sizeof (resolution));
+        WriteBytes (*g_file, &size, sizeof (size));
+        WriteBytes (*g_file, &records[0], size);
+        g_file->flush ();
+      }
+  }
+  records.clear ();
+}
+
+
+void
+LogBinarySetSources (LogBinaryTimeSource time, LogBinaryNodeSource node)
+{
+  g_timeSource = time;
+  g_nodeSource = node;
+}
+
+void
+LogBinaryEnable (const std::string & file)
+{
+  CheckEnvironment ();
+  LogBinaryDisable ();
+
+  std::lock_guard<std::mutex> lock (GetMutex ());
+  g_file = new std::ofstream (file.c_str (), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!g_file->good ())
+    {
+      NS_FATAL_ERROR ("Could not open binary log file \"" << file << "\"");
+    }
+  WriteBytes (*g_file, MAGIC, sizeof (MAGIC));
+  std::vector<SiteInfo> & sites = GetSites ();
+  for (uint32_t i = 0; i < sites.size (); ++i)
+    {
+      WriteSite (*g_file, i, sites[i]);
+    }
+  g_file->flush ();
+  g_enabled = true;
+}
+
+void
+LogBinaryDisable (void)
+{
+  CheckEnvironment ();
+  if (g_file == 0)
+    {
+      return;
+    }
+  g_enabled = false;
+  LogBinaryFlush ();
+  std::lock_guard<std::mutex> lock (GetMutex ());
+  g_file->close ();
+  delete g_file;
+  g_file = 0;
+}
+
+bool
+LogBinaryIsEnabled (void)
+{
+  CheckEnvironment ();
+  return g_enabled;
+}
+
+void
+LogBinaryFlush (void)
+{
+  g_threadBuffer.Write ();
+}
+
+
+LogSite::LogSite (const LogComponent & component, const char *function,
+                  const char *file, int line, enum LogLevel level, enum Kind kind)
+  : m_kind (kind)
+{
+  SiteInfo site;
+  site.component = component.Name ();
+  site.function = function;
+  site.file = file;
+  site.line = line;
+  site.level = level;
+  site.kind = kind;
+
+  std::lock_guard<std::mutex> lock (GetMutex ());
+  std::vector<SiteInfo> & sites = GetSites ();
+  m_id = sites.size ();
+  sites.push_back (site);
+  if (g_file != 0)
+    {
+      WriteSite (*g_file, m_id, site);
+    }
+}
+
+uint32_t
+LogSite::GetId (void) const
+{
+  return m_id;
+}
+
+enum LogSite::Kind
+LogSite::GetKind (void) const
+{
+  return m_kind;
+}
+
+
+LogRecord::LogRecord (const LogSite & site, const LogComponent & component)
+  : m_parameters (site.GetKind () == LogSite::FUNCTION),
+    m_text (false)
+{
+  ThreadBuffer & thread = g_threadBuffer;
+  if (thread.depth == thread.frames.size ())
+    {
+      thread.frames.emplace_back ();
+    }
+  m_frame = &thread.frames[thread.depth++];
+  m_frame->data.clear ();
+
+  uint32_t length = 0;
+  uint32_t id = site.GetId ();
+  uint8_t flags = 0;
+  if (component.IsEnabled (LOG_PREFIX_FUNC))
+    {
+      flags |= PREFIX_FUNC;
+    }
+  if (component.IsEnabled (LOG_PREFIX_LEVEL))
+    {
+      flags |= PREFIX_LEVEL;
+    }
+  LogBinaryTimeSource timeSource = g_timeSource;
+  if (timeSource != 0 && component.IsEnabled (LOG_PREFIX_TIME))
+    {
+      flags |= HAS_TIME;
+    }
+  LogBinaryNodeSource nodeSource = g_nodeSource;
+  if (nodeSource != 0 && component.IsEnabled (LOG_PREFIX_NODE))
+    {
+      flags |= HAS_NODE;
+    }
+  Put (&length, sizeof (length));
+  Put (&id, sizeof (id));
+  Put (&flags, 1);
+  if (flags & HAS_TIME)
+    {
+      int64_t time = (*timeSource)();
+      Put (&time, sizeof (time));
+    }
+  if (flags & HAS_NODE)
+    {
+      uint32_t context = (*nodeSource)();
+      Put (&context, sizeof (context));
+    }
+}
+
+LogRecord::~LogRecord ()
+{
+  ThreadBuffer & thread = g_threadBuffer;
+  std::vector<uint8_t> & data = m_frame->data;
+  uint32_t length = data.size ();
+  std::memcpy (&data[0], &length, sizeof (length));
+  thread.records.insert (thread.records.end (), data.begin (), data.end ());
+  thread.depth--;
+  if (thread.records.size () >= BUFFER_SIZE)
+    {
+      thread.Write ();
+    }
+}
+
+void
+LogRecord::Put (const void *data, uint32_t size)
+{
+  const uint8_t *bytes = static_cast<const uint8_t *> (data);
+  m_frame->data.insert (m_frame->data.end (), bytes, bytes + size);
+}
+
+void
+LogRecord::PutString (enum Tag tag, const char *data, uint32_t size)
+{
+  uint8_t t = tag;
+  Put (&t, 1);
+  Put (&size, sizeof (size));
+  Put (data, size);
+}
+
+std::ostream &
+LogRecord::BeginText (void)
+{
+  std::ostringstream & text = m_frame->text;
+  if (!m_text)
+    {
+      // Start from the default format, as std::clog would.
+      m_text = true;
+      text.flags (std::ios::dec | std::ios::skipws);
+      text.precision (6);
+      text.width (0);
+      text.fill (' ');
+    }
+  text.str ("");
+  return text;
+}
+
+void
+LogRecord::EndText (void)
+{
+  std::string text = m_frame->text.str ();
+  PutString (TEXT, text.data (), text.size ());
+}
+
+/**
+ * Implement LogRecord::operator<< for a type recorded raw.
+ * \param [in] type The argument type.
+ * \param [in] tag The LogRecord::Tag.
+ */
+#define LOG_RECORD_RAW(type, tag)                       \
+  LogRecord &                                           \
+  LogRecord::operator<< (type value)                    \
+  {                                                     \
+    if (m_text)                                         \
+      {                                                 \
+        BeginText () << value;                          \
+        EndText ();                                     \
+      }                                                 \
+    else                                                \
+      {                                                 \
+        PutValue (tag, value);                          \
+      }                                                 \
+    return *this;                                       \
+  }
+
+LOG_RECORD_RAW (bool, BOOL)
+LOG_RECORD_RAW (char, CHAR)
+LOG_RECORD_RAW (signed char, SCHAR)
+LOG_RECORD_RAW (unsigned char, UCHAR)
+LOG_RECORD_RAW (short, SHORT)
+LOG_RECORD_RAW (unsigned short, USHORT)
+LOG_RECORD_RAW (int, INT)
+LOG_RECORD_RAW (unsigned int, UINT)
+LOG_RECORD_RAW (long, LONG)
+LOG_RECORD_RAW (unsigned long, ULONG)
+LOG_RECORD_RAW (long long, LLONG)
+LOG_RECORD_RAW (unsigned long long, ULLONG)
+LOG_RECORD_RAW (float, FLOAT)
+LOG_RECORD_RAW (double, DOUBLE)
+
+#undef LOG_RECORD_RAW
+
+LogRecord &
+LogRecord::operator<< (const std::string & value)
+{
+  if (m_text)
+    {
+      // ParameterLogger quotes strings.
+      if (m_parameters)
+        {
+          BeginText () << "\"" << value << "\"";
+        }
+      else
+        {
+          BeginText () << value;
+        }
+      EndText ();
+    }
+  else
+    {
+      PutString (STRING, value.data (), value.size ());
+    }
+  return *this;
+}
+
+LogRecord &
+LogRecord::operator<< (std::string & value)
+{
+  return (*this) << static_cast<const std::string &> (value);
+}
+
+LogRecord &
+LogRecord::operator<< (const char *value)
+{
+  if (value == 0)
+    {
+      return *this;
+    }
+  return (*this) << std::string (value);
+}
+
+LogRecord &
+LogRecord::operator<< (char *value)
+{
+  // Not quoted by ParameterLogger.
+  if (value == 0)
+    {
+      return *this;
+    }
+  if (m_text)
+    {
+      BeginText () << value;
+      EndText ();
+    }
+  else
+    {
+      PutString (TEXT, value, std::strlen (value));
+    }
+  return *this;
+}
+
+LogRecord &
+LogRecord::operator<< (std::ostream & (*manipulator)(std::ostream &))
+{
+  BeginText () << manipulator;
+  EndText ();
+  return *this;
+}
+
+LogRecord &
+LogRecord::operator<< (std::ios & (*manipulator)(std::ios &))
+{
+  BeginText () << manipulator;
+  EndText ();
+  return *this;
+}
+
+LogRecord &
+LogRecord::operator<< (std::ios_base & (*manipulator)(std::ios_base &))
+{
+  BeginText () << manipulator;
+  EndText ();
+  return *this;
+}
+
+
+namespace {
+
+/**
+ * Read bytes from a binary log file, and abort if it is truncated.
+ * \param [in,out] is The stream.
+ * \param [out] data The bytes.
+ * \param [in] size The number of bytes.
+ */
+void
+ReadBytes (std::istream & is, void *data, uint32_t size)
+{
+  is.read (static_cast<char *> (data), size);
+  if (static_cast<uint32_t> (is.gcount ()) != size)
+    {
+      NS_FATAL_ERROR ("Truncated binary log file");
+    }
+}
+
+/**
+ * Read a string from a binary log file.
+ * \param [in,out] is The stream.
+ * \returns The string.
+ */
+std::string
+ReadString (std::istream & is)
+{
+  uint32_t size;
+  ReadBytes (is, &size, sizeof (size));
+  std::string s (size, '\0');
+  if (size > 0)
+    {
+      ReadBytes (is, &s[0], size);
+    }
+  return s;
+}
+
+/** Read values from a record. */
+class RecordReader
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] data The record.
+   * \param [in] size The size of the record.
+   */
+  RecordReader (const uint8_t *data, uint32_t size)
+    : m_data (data), m_size (size), m_offset (0)
+  {
+  }
+  /** \returns \c true if all the record has been read. */
+  bool IsEnd (void) const
+  {
+    return m_offset == m_size;
+  }
+  /** \returns The next value. */
+  template <typename T>
+  T Read (void)
+  {
+    T value;
+    Check (sizeof (value));
+    std::memcpy (&value, m_data + m_offset, sizeof (value));
+    m_offset += sizeof (value);
+    return value;
+  }
+  /** \returns The next string. */
+  std::string ReadString (void)
+  {
+    uint32_t size = Read<uint32_t> ();
+    Check (size);
+    std::string s (reinterpret_cast<const char *> (m_data + m_offset), size);
+    m_offset += size;
+    return s;
+  }
+
+private:
+  /**
+   * Abort if fewer than \p size bytes are left.
+   * \param [in] size The number of bytes to read.
+   */
+  void Check (uint32_t size) const
+  {
+    if (m_size - m_offset < size)
+      {
+        NS_FATAL_ERROR ("Corrupt binary log record");
+      }
+  }
+  const uint8_t *m_data;  //!< The record.
+  uint32_t m_size;        //!< The size of the record.
+  uint32_t m_offset;      //!< The read position.
+};
+
+/**
+ * Print a time step as the default TimePrinter of the Simulator does.
+ * \param [in,out] os The output stream.
+ * \param [in] step The time step.
+ */
+void
+PrintTime (std::ostream & os, int64_t step)
+{
+  std::ios_base::fmtflags ff = os.flags ();
+  std::streamsize oldPrecision = os.precision ();
+  int precision;
+  switch (Time::GetResolution ())
+    {
+    case Time::NS: precision = 9;  break;
+    case Time::PS: precision = 12; break;
+    case Time::FS: precision = 15; break;
+    case Time::US: precision = 6;  break;
+    default:       precision = 5;  break;
+    }
+  os << std::fixed << std::setprecision (precision) << Time (step).As (Time::S);
+  os << std::setprecision (oldPrecision);
+  os.flags (ff);
+}
+
+/**
+ * Print the arguments of a record.
+ * \param [in,out] os The output stream.
+ * \param [in,out] reader The record, after the header.
+ * \param [in] parameters Whether to print as function parameters.
+ */
+void
+PrintArguments (std::ostream & os, RecordReader & reader, bool parameters)
+{
+  bool first = true;
+  while (!reader.IsEnd ())
+    {
+      if (parameters && !first)
+        {
+          os << ", ";
+        }
+      first = false;
+      uint8_t tag = reader.Read<uint8_t> ();
+      switch (tag)
+        {
+        case LogRecord::BOOL:   os << reader.Read<bool> ();               break;
+        case LogRecord::CHAR:   os << reader.Read<char> ();               break;
+        case LogRecord::SCHAR:  os << reader.Read<signed char> ();        break;
+        case LogRecord::UCHAR:  os << reader.Read<unsigned char> ();      break;
+        case LogRecord::SHORT:  os << reader.Read<short> ();              break;
+        case LogRecord::USHORT: os << reader.Read<unsigned short> ();     break;
+        case LogRecord::INT:    os << reader.Read<int> ();                break;
+        case LogRecord::UINT:   os << reader.Read<unsigned int> ();       break;
+        case LogRecord::LONG:   os << reader.Read<long> ();               break;
+        case LogRecord::ULONG:  os << reader.Read<unsigned long> ();      break;
+        case LogRecord::LLONG:  os << reader.Read<long long> ();          break;
+        case LogRecord::ULLONG: os << reader.Read<unsigned long long> (); break;
+        case LogRecord::FLOAT:  os << reader.Read<float> ();              break;
+        case LogRecord::DOUBLE: os << reader.Read<double> ();             break;
+        case LogRecord::POINTER:
+          os << reinterpret_cast<const void *> (reader.Read<uint64_t> ());
+          break;
+        case LogRecord::STRING:
+          if (parameters)
+            {
+              os << "\"" << reader.ReadString () << "\"";
+            }
+          else
+            {
+              os << reader.ReadString ();
+            }
+          break;
+        case LogRecord::TEXT:
+          os << reader.ReadString ();
+          break;
+        default:
+          NS_FATAL_ERROR ("Unknown argument type " << (int)tag << " in binary log record");
+        }
+    }
+}
+
+} // unnamed namespace
+
+void
+LogBinaryDecode (std::istream & is, std::ostream & os)
+{
+  char magic[sizeof (MAGIC)];
+  is.read (magic, sizeof (magic));
+  if (is.gcount () != sizeof (magic) || std::memcmp (magic, MAGIC, sizeof (MAGIC)) != 0)
+    {
+      NS_FATAL_ERROR ("Not a binary log file");
+    }
+
+  std::vector<SiteInfo> sites;
+  std::vector<uint8_t> records;
+  uint8_t chunk;
+  while (is.read (reinterpret_cast<char *> (&chunk), 1))
+    {
+      if (chunk == SITE_CHUNK)
+        {
+          uint32_t id;
+          SiteInfo site;
+          ReadBytes (is, &id, sizeof (id));
+          ReadBytes (is, &site.level, sizeof (site.level));
+          ReadBytes (is, &site.kind, 1);
+          ReadBytes (is, &site.line, sizeof (site.line));
+          site.component = ReadString (is);
+          site.function = ReadString (is);
+          site.file = ReadString (is);
+          if (id >= sites.size ())
+            {
+              sites.resize (id + 1);
+            }
+          sites[id] = site;
+          continue;
+        }
+      if (chunk != RECORD_CHUNK)
+        {
+          NS_FATAL_ERROR ("Unknown chunk type " << (int)chunk << " in binary log file");
+        }
+
+      uint32_t serial;
+      int32_t resolution;
+      uint32_t size;
+      ReadBytes (is, &serial, sizeof (serial));
+      ReadBytes (is, &resolution, sizeof (resolution));
+      ReadBytes (is, &size, sizeof (size));
+      records.resize (size);
+      if (size > 0)
+        {
+          ReadBytes (is, &records[0], size);
+        }
+      if (resolution != Time::GetResolution ())
+        {
+          Time::SetResolution (static_cast<enum Time::Unit> (resolution));
+        }
+
+      uint32_t offset = 0;
+      while (offset < size)
+        {
+          RecordReader header (&records[offset], size - offset);
+          uint32_t length = header.Read<uint32_t> ();
+          if (length < sizeof (uint32_t) || length > size - offset)
+            {
+              NS_FATAL_ERROR ("Corrupt binary log record");
+            }
+          RecordReader reader (&records[offset], length);
+          reader.Read<uint32_t> ();
+          uint32_t id = reader.Read<uint32_t> ();
+          uint8_t flags = reader.Read<uint8_t> ();
+          if (id >= sites.size () || sites[id].component.empty ())
+            {
+              NS_FATAL_ERROR ("Unknown call site " << id << " in binary log record");
+            }
+          const SiteInfo & site = sites[id];
+
+          if (flags & HAS_TIME)
+            {
+              PrintTime (os, reader.Read<int64_t> ());
+              os << " ";
+            }
+          if (flags & HAS_NODE)
+            {
+              uint32_t context = reader.Read<uint32_t> ();
+              if (context == 0xffffffff)
+                {
+                  os << "-1";
+                }
+              else
+                {
+                  os << context;
+                }
+              os << " ";
+            }
+          if (site.kind == LogSite::FUNCTION)
+            {
+              os << site.component << ":" << site.function << "(";
+              PrintArguments (os, reader, true);
+              os << ")" << std::endl;
+            }
+          else
+            {
+              if (flags & PREFIX_FUNC)
+                {
+                  os << site.component << ":" << site.function << "(): ";
+                }
+              if (flags & PREFIX_LEVEL)
+                {
+                  os << "[" << LogComponent::GetLevelLabel (static_cast<enum LogLevel> (site.level)) << "] ";
+                }
+              PrintArguments (os, reader, false);
+              os << std::endl;
+            }
+          offset += length;
+        }
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,372 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_LOG_BINARY_H
+#define NS3_LOG_BINARY_H
+
+#include <string>
+#include <iostream>
+#include <stdint.h>
+#include <type_traits>
+
+#include "log.h"
+
+/**
+ * \file
+ * \ingroup logging
+ * Binary logging backend.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup logging
+ * \defgroup logbinary Binary logging
+ *
+ * \brief Record log messages in binary form and format them after the run.
+ *
+ * Formatting every argument of a log message with \c operator<<,
+ * and writing it on \c std::clog, is most of the cost of logging.
+ * The binary backend instead records, for each message, the
+ * simulation time, the node context, a call site id and the raw
+ * arguments into a buffer of the calling thread, and writes the
+ * buffer to a file when it is full.  The file is turned into the
+ * same text that \c std::clog would have shown by LogBinaryDecode(),
+ * for example with the \c log-decode program in \c utils/:
+ * \code
+ *   $ NS_LOG='binary=run.nslog:Ipv4L3Protocol=info|prefix_all' ./waf --run ...
+ *   $ ./waf --run "log-decode --file=run.nslog"
+ * \endcode
+ *
+ * The backend is selected by the \c binary=<file> token of the
+ * \c NS_LOG environment variable, or by LogBinaryEnable(); the
+ * log call sites don't change.  Which components and levels are
+ * logged is still set by the other \c NS_LOG tokens or by
+ * LogComponentEnable().
+ *
+ * Numbers, characters, pointers and strings are recorded raw.
+ * Other arguments, and all the arguments of a message after a
+ * stream manipulator such as \c std::hex, are formatted at the call
+ * site and recorded as text, so the decoded message is the same as
+ * the text one.  The file local \c NS_LOG_APPEND_CONTEXT prefix is
+ * not recorded, and \c NS_LOG_UNCOND still writes on \c std::clog.
+ *
+ * Each thread has its own buffer, written whole to the file, so the
+ * messages of a thread are in order but the messages of several
+ * threads are interleaved by buffer.  A thread's buffer is written
+ * when it is full, when the thread exits, and by LogBinaryFlush().
+ * The file is in the byte order of the machine that wrote it.
+ */
+
+/**
+ * \ingroup logbinary
+ * Function signature for getting the simulation time of a binary
+ * log message, as a number of time steps of the current resolution.
+ *
+ * \returns The current simulation time step.
+ */
+typedef int64_t (*LogBinaryTimeSource)(void);
+/**
+ * \ingroup logbinary
+ * Function signature for getting the node context of a binary log
+ * message.
+ *
+ * \returns The current context.
+ */
+typedef uint32_t (*LogBinaryNodeSource)(void);
+
+/**
+ * \ingroup logbinary
+ * Set the functions giving the simulation time and node context
+ * of binary log messages, the counterparts of the LogTimePrinter
+ * and LogNodePrinter functions.
+ *
+ * \param [in] time The LogBinaryTimeSource function, or 0.
+ * \param [in] node The LogBinaryNodeSource function, or 0.
+ */
+void LogBinarySetSources (LogBinaryTimeSource time, LogBinaryNodeSource node);
+
+/**
+ * \ingroup logbinary
+ * Write the enabled log messages in binary form to \p file instead
+ * of \c std::clog.
+ *
+ * Same as running your program with the NS_LOG environment variable
+ * set as NS_LOG='binary=file'.
+ *
+ * \param [in] file The name of the binary log file.
+ */
+void LogBinaryEnable (const std::string & file);
+
+/**
+ * \ingroup logbinary
+ * Write the buffer of the calling thread, close the binary log file
+ * and go back to writing log messages on \c std::clog.
+ */
+void LogBinaryDisable (void);
+
+/**
+ * \ingroup logbinary
+ * Check if log messages are recorded in binary form.
+ *
+ * \returns \c true if the binary backend is enabled.
+ */
+bool LogBinaryIsEnabled (void);
+
+/**
+ * \ingroup logbinary
+ * Write the buffer of the calling thread to the binary log file.
+ */
+void LogBinaryFlush (void);
+
+/**
+ * \ingroup logbinary
+ * Format the messages of a binary log file as they would have been
+ * written on \c std::clog.
+ *
+ * \param [in] is The binary log file contents.
+ * \param [in,out] os The output stream to write the messages on.
+ */
+void LogBinaryDecode (std::istream & is, std::ostream & os);
+
+
+/**
+ * \ingroup logbinary
+ * A log message call site, registered the first time the message
+ * is recorded in binary form.
+ *
+ * \internal
+ * Logging implementation class; instances are created by the
+ * logging macros.
+ */
+class LogSite
+{
+public:
+  /** The kind of message of a call site. */
+  enum Kind
+  {
+    MESSAGE,   //!< NS_LOG and the NS_LOG_ERROR etc. macros.
+    FUNCTION   //!< NS_LOG_FUNCTION and NS_LOG_FUNCTION_NOARGS.
+  };
+
+  /**
+   * Register a call site.
+   *
+   * \param [in] component The log component of the call site.
+   * \param [in] function The function name.
+   * \param [in] file The source file name.
+   * \param [in] line The source line.
+   * \param [in] level The log level of the message.
+   * \param [in] kind The kind of message.
+   */
+  LogSite (const LogComponent & component, const char *function,
+           const char *file, int line, enum LogLevel level, enum Kind kind);
+  /**
+   * Get the id of this call site in the binary log file.
+   * \returns The call site id.
+   */
+  uint32_t GetId (void) const;
+  /**
+   * Get the kind of message of this call site.
+   * \returns The kind of message.
+   */
+  enum Kind GetKind (void) const;
+
+private:
+  uint32_t m_id;       //!< The call site id.
+  enum Kind m_kind;    //!< The kind of message.
+
+};  // class LogSite
+
+
+/**
+ * \ingroup logbinary
+ * Record one binary log message.
+ *
+ * The arguments are streamed into the record, as they would be into
+ * \c std::clog, and the record is added to the buffer of the calling
+ * thread by the destructor.
+ *
+ * \internal
+ * Logging implementation class; instances are created by the
+ * logging macros.
+ */
+class LogRecord
+{
+public:
+  /** The type tag of a recorded argument. */
+  enum Tag
+  {
+    BOOL = 1,    //!< bool
+    CHAR,        //!< char
+    SCHAR,       //!< signed char
+    UCHAR,       //!< unsigned char
+    SHORT,       //!< short
+    USHORT,      //!< unsigned short
+    INT,         //!< int
+    UINT,        //!< unsigned int
+    LONG,        //!< long
+    ULONG,       //!< unsigned long
+    LLONG,       //!< long long
+    ULLONG,      //!< unsigned long long
+    FLOAT,       //!< float
+    DOUBLE,      //!< double
+    POINTER,     //!< Any object pointer, printed as \c const \c void*.
+    STRING,      //!< \c std::string or \c const \c char*, quoted in function parameters.
+    TEXT         //!< An argument formatted at the call site.
+  };
+
+  /** The buffer of a record, and its text stream. */
+  struct Frame;
+
+  /**
+   * Start a record.
+   *
+   * \param [in] site The call site.
+   * \param [in] component The log component of the call site.
+   */
+  LogRecord (const LogSite & site, const LogComponent & component);
+  /** Add the record to the buffer of the calling thread. */
+  ~LogRecord ();
+
+  /**
+   * \name Record an argument.
+   * \param [in] value The argument.
+   * \returns This LogRecord, so it's chainable.
+   */
+  /**@{*/
+  LogRecord & operator<< (bool value);
+  LogRecord & operator<< (char value);
+  LogRecord & operator<< (signed char value);
+  LogRecord & operator<< (unsigned char value);
+  LogRecord & operator<< (short value);
+  LogRecord & operator<< (unsigned short value);
+  LogRecord & operator<< (int value);
+  LogRecord & operator<< (unsigned int value);
+  LogRecord & operator<< (long value);
+  LogRecord & operator<< (unsigned long value);
+  LogRecord & operator<< (long long value);
+  LogRecord & operator<< (unsigned long long value);
+  LogRecord & operator<< (float value);
+  LogRecord & operator<< (double value);
+  LogRecord & operator<< (const char *value);
+  LogRecord & operator<< (char *value);
+  LogRecord & operator<< (const std::string & value);
+  LogRecord & operator<< (std::ostream & (*manipulator)(std::ostream &));
+  LogRecord & operator<< (std::ios & (*manipulator)(std::ios &));
+  LogRecord & operator<< (std::ios_base & (*manipulator)(std::ios_base &));
+  template <typename T>
+  LogRecord & operator<< (T *value);
+  template <typename T>
+  LogRecord & operator<< (const T & value);
+  template <typename T>
+  LogRecord & operator<< (T & value);
+  LogRecord & operator<< (std::string & value);
+  /**@}*/
+
+private:
+  /**
+   * Append raw bytes to the record.
+   *
+   * \param [in] data The bytes.
+   * \param [in] size The number of bytes.
+   */
+  void Put (const void *data, uint32_t size);
+  /**
+   * Append a tagged raw value to the record.
+   *
+   * \param [in] tag The type tag.
+   * \param [in] value The value.
+   */
+  template <typename T>
+  void PutValue (enum Tag tag, T value);
+  /**
+   * Append a tagged string to the record.
+   *
+   * \param [in] tag The type tag.
+   * \param [in] data The characters.
+   * \param [in] size The number of characters.
+   */
+  void PutString (enum Tag tag, const char *data, uint32_t size);
+  /**
+   * Get the stream formatting the arguments of this record which
+   * can't be recorded raw, switching the rest of the record to text.
+   *
+   * \returns The text stream, emptied.
+   */
+  std::ostream & BeginText (void);
+  /** Append the contents of the text stream to the record. */
+  void EndText (void);
+
+  Frame *m_frame;      //!< The buffer of this record.
+  bool m_parameters;   //!< Record function parameters, separated by ", ".
+  bool m_text;         //!< Format all the following arguments as text.
+
+};  // class LogRecord
+
+
+template <typename T>
+void
+LogRecord::PutValue (enum Tag tag, T value)
+{
+  uint8_t t = tag;
+  Put (&t, 1);
+  Put (&value, sizeof (value));
+}
+
+template <typename T>
+LogRecord &
+LogRecord::operator<< (T *value)
+{
+  typedef typename std::remove_cv<T>::type Pointee;
+  // Like std::ostream, print function pointers as bool and
+  // signed and unsigned char pointers as strings.
+  if (m_text || std::is_function<T>::value
+      || std::is_same<Pointee, signed char>::value
+      || std::is_same<Pointee, unsigned char>::value)
+    {
+      BeginText () << value;
+      EndText ();
+    }
+  else
+    {
+      PutValue (POINTER, reinterpret_cast<uint64_t> (value));
+    }
+  return *this;
+}
+
+template <typename T>
+LogRecord &
+LogRecord::operator<< (const T & value)
+{
+  BeginText () << value;
+  EndText ();
+  return *this;
+}
+
+template <typename T>
+LogRecord &
+LogRecord::operator<< (T & value)
+{
+  // For the operator<< of the types which take a non const reference.
+  BeginText () << value;
+  EndText ();
+  return *this;
+}
+
+} // namespace ns3
+
+#endif /* NS3_LOG_BINARY_H */
@@ -90,6 +90,22 @@
     }                                                           \
 
 
+/**
+ * \ingroup logging
+ * Define the static LogSite \c ns3LogBinarySite of a log call site,
+ * registered the first time the call site is recorded in binary form.
+ * \internal
+ * Logging implementation macro; should not be called directly.
+ *
+ * \param [in] level The log level.
+ * \param [in] kind The LogSite::Kind.
+ */
+#define NS_LOG_BINARY_SITE(level, kind)                         \
+  static const ns3::LogSite ns3LogBinarySite (g_log, __FUNCTION__, \
+                                              __FILE__, __LINE__, \
+                                              level, kind)
+
+
 #ifndef NS_LOG_APPEND_CONTEXT
 /**
  * \ingroup logging
@@ -130,6 +146,48 @@
 #define NS_LOG_CONDITION
 #endif
 
+#ifndef NS3_LOG_LEVELS
+/**
+ * \ingroup logging
+ * The log levels compiled into the whole build, as a LogLevel mask.
+ *
+ * Set by the \c --log-levels option of \c waf \c configure; the
+ * logging statements of the other levels are removed at compile time,
+ * whatever the levels enabled at run time.
+ */
+#define NS3_LOG_LEVELS ns3::LOG_LEVEL_ALL
+#endif
+
+#ifndef NS_LOG_COMPILED_LEVELS
+/**
+ * \ingroup logging
+ * The log levels compiled into this file, as a LogLevel mask.
+ *
+ * This is defined locally in `.cc` files, before including any
+ * header, to remove the most frequent logging statements of a
+ * component from a build which keeps the others, for example:
+ * \code
+ *   #define NS_LOG_COMPILED_LEVELS (ns3::LOG_LEVEL_INFO)
+ * \endcode
+ * keeps the error, warn, debug and info levels and removes the
+ * function and logic ones.  The levels compiled are those of both
+ * this mask and NS3_LOG_LEVELS.
+ */
+#define NS_LOG_COMPILED_LEVELS ns3::LOG_LEVEL_ALL
+#endif
+
+/**
+ * \ingroup logging
+ * Check at compile time if the logging statements of \p level are
+ * compiled into this file.
+ * \internal
+ * Logging implementation macro; should not be called directly.
+ *
+ * \param [in] level The log level.
+ */
+#define NS_LOG_IS_COMPILED(level)                               \
+  (((level) & (NS3_LOG_LEVELS) & (NS_LOG_COMPILED_LEVELS)) != 0)
+
 /**
  * \ingroup logging
  *
@@ -153,8 +211,15 @@
   NS_LOG_CONDITION                                              \
   do                                                            \
     {                                                           \
-      if (g_log.IsEnabled (level))                              \
+      if (NS_LOG_IS_COMPILED (level)                            \
+          && g_log.IsEnabled (level))                           \
         {                                                       \
+          if (ns3::LogBinaryIsEnabled ())                       \
+            {                                                   \
+              NS_LOG_BINARY_SITE (level, ns3::LogSite::MESSAGE);\
+              ns3::LogRecord (ns3LogBinarySite, g_log) << msg;  \
+              break;                                            \
+            }                                                   \
           NS_LOG_APPEND_TIME_PREFIX;                            \
           NS_LOG_APPEND_NODE_PREFIX;                            \
           NS_LOG_APPEND_CONTEXT;                                \
@@ -177,8 +242,16 @@
   NS_LOG_CONDITION                                              \
   do                                                            \
     {                                                           \
-      if (g_log.IsEnabled (ns3::LOG_FUNCTION))                  \
+      if (NS_LOG_IS_COMPILED (ns3::LOG_FUNCTION)                \
+          && g_log.IsEnabled (ns3::LOG_FUNCTION))               \
         {                                                       \
+          if (ns3::LogBinaryIsEnabled ())                       \
+            {                                                   \
+              NS_LOG_BINARY_SITE (ns3::LOG_FUNCTION,            \
+                                  ns3::LogSite::FUNCTION);      \
+              ns3::LogRecord (ns3LogBinarySite, g_log);         \
+              break;                                            \
+            }                                                   \
           NS_LOG_APPEND_TIME_PREFIX;                            \
           NS_LOG_APPEND_NODE_PREFIX;                            \
           NS_LOG_APPEND_CONTEXT;                                \
@@ -214,8 +287,17 @@
   NS_LOG_CONDITION                                              \
   do                                                            \
     {                                                           \
-      if (g_log.IsEnabled (ns3::LOG_FUNCTION))                  \
+      if (NS_LOG_IS_COMPILED (ns3::LOG_FUNCTION)                \
+          && g_log.IsEnabled (ns3::LOG_FUNCTION))               \
         {                                                       \
+          if (ns3::LogBinaryIsEnabled ())                       \
+            {                                                   \
+              NS_LOG_BINARY_SITE (ns3::LOG_FUNCTION,            \
+                                  ns3::LogSite::FUNCTION);      \
+              ns3::LogRecord (ns3LogBinarySite, g_log)          \
+                << parameters;                                  \
+              break;                                            \
+            }                                                   \
           NS_LOG_APPEND_TIME_PREFIX;                            \
           NS_LOG_APPEND_NODE_PREFIX;                            \
           NS_LOG_APPEND_CONTEXT;                                \
@@ -268,13 +268,6 @@ LogComponent::EnvVarCheck (void)
 }
 
 
-bool 
-LogComponent::IsEnabled (const enum LogLevel level) const
-{
-  //  LogComponentEnableEnvVar ();
-  return (level & m_levels) ? 1 : 0;
-}
-
 bool
 LogComponent::IsNoneEnabled (void) const
 {
@@ -552,7 +545,11 @@ static void CheckEnvironmentVariables (void)
       else
         {
           component = tmp.substr (0, equal);
-          if (ComponentExists(component) || component == "*")
+          if (component == "binary")
+            {
+              // the file name of the binary backend, see log-binary.h
+            }
+          else if (ComponentExists(component) || component == "*")
             {
               std::string::size_type cur_lev;
               std::string::size_type next_lev = equal;
@@ -409,6 +409,12 @@ private:
 
 };  // class LogComponent
 
+inline bool
+LogComponent::IsEnabled (const enum LogLevel level) const
+{
+  return (level & m_levels) ? 1 : 0;
+}
+
   
 /**
  * Insert `, ` when streaming function arguments.
@@ -475,4 +481,7 @@ ParameterLogger::operator<< <const char *>(const char * param);
 
 /**@}*/  // \ingroup logging
 
+// The binary backend of the logging macros.
+#include "log-binary.h"
+
 #endif /* NS3_LOG_H */
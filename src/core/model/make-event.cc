@@ -47,6 +47,10 @@ public:
     virtual ~EventFunctionImpl0 ()
     {
     }
+    virtual Target GetTarget (void) const
+    {
+      return EventFunctionImplTarget (m_function);
+    }
 protected:
     virtual void Notify (void)
     {
@@ -355,6 +355,47 @@ struct EventMemberImplObjTraits<T *>
   }
 };
 
+/**
+ * \ingroup makeeventmemptr
+ * Helper for the MakeEvent functions which take a class method.
+ *
+ * This helper gets the target of an event calling a class method.
+ *
+ * \tparam C \deduced The class declaring the method.
+ * \tparam F \deduced The method signature.
+ * \tparam T \deduced The class type of the object.
+ * \param [in] mem_ptr Class method member function pointer.
+ * \param [in] obj Class instance.
+ * \returns The event target.
+ */
+template <typename C, typename F, typename T>
+EventImpl::Target EventMemberImplTarget (F C::*mem_ptr, T &obj)
+{
+  const C *self = &obj;
+  EventImpl::Target target;
+  target.object = &typeid (obj);
+  target.function = EventImpl::GetMemberFunction (&mem_ptr, sizeof (mem_ptr), self);
+  return target;
+}
+
+/**
+ * \ingroup makeeventfnptr
+ * Helper for the MakeEvent functions which take a function pointer.
+ *
+ * This helper gets the target of an event calling a function.
+ *
+ * \tparam F \deduced The function pointer type.
+ * \param [in] f The function pointer.
+ * \returns The event target.
+ */
+template <typename F>
+EventImpl::Target EventFunctionImplTarget (F f)
+{
+  EventImpl::Target target;
+  target.function = reinterpret_cast<const void *> (f);
+  return target;
+}
+
 template <typename MEM, typename OBJ>
 EventImpl * MakeEvent (MEM mem_ptr, OBJ obj)
 {
@@ -370,6 +411,10 @@ public:
     virtual ~EventMemberImpl0 ()
     {
     }
+    virtual Target GetTarget (void) const
+    {
+      return EventMemberImplTarget (m_function, EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+    }
 private:
     virtual void Notify (void)
     {
@@ -400,6 +445,11 @@ protected:
     virtual ~EventMemberImpl1 ()
     {
     }
+public:
+    virtual Target GetTarget (void) const
+    {
+      return EventMemberImplTarget (m_function, EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+    }
 private:
     virtual void Notify (void)
     {
@@ -431,6 +481,11 @@ protected:
     virtual ~EventMemberImpl2 ()
     {
     }
+public:
+    virtual Target GetTarget (void) const
+    {
+      return EventMemberImplTarget (m_function, EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+    }
 private:
     virtual void Notify (void)
     {
@@ -464,6 +519,11 @@ protected:
     virtual ~EventMemberImpl3 ()
     {
     }
+public:
+    virtual Target GetTarget (void) const
+    {
+      return EventMemberImplTarget (m_function, EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+    }
 private:
     virtual void Notify (void)
     {
@@ -499,6 +559,11 @@ protected:
     virtual ~EventMemberImpl4 ()
     {
     }
+public:
+    virtual Target GetTarget (void) const
+    {
+      return EventMemberImplTarget (m_function, EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+    }
 private:
     virtual void Notify (void)
     {
@@ -537,6 +602,11 @@ protected:
     virtual ~EventMemberImpl5 ()
     {
     }
+public:
+    virtual Target GetTarget (void) const
+    {
+      return EventMemberImplTarget (m_function, EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+    }
 private:
     virtual void Notify (void)
     {
@@ -577,6 +647,11 @@ protected:
     virtual ~EventMemberImpl6 ()
     {
     }
+public:
+    virtual Target GetTarget (void) const
+    {
+      return EventMemberImplTarget (m_function, EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+    }
 private:
     virtual void Notify (void)
     {
@@ -612,6 +687,11 @@ protected:
     virtual ~EventFunctionImpl1 ()
     {
     }
+public:
+    virtual Target GetTarget (void) const
+    {
+      return EventFunctionImplTarget (m_function);
+    }
 private:
     virtual void Notify (void)
     {
@@ -642,6 +722,11 @@ protected:
     virtual ~EventFunctionImpl2 ()
     {
     }
+public:
+    virtual Target GetTarget (void) const
+    {
+      return EventFunctionImplTarget (m_function);
+    }
 private:
     virtual void Notify (void)
     {
@@ -675,6 +760,11 @@ protected:
     virtual ~EventFunctionImpl3 ()
     {
     }
+public:
+    virtual Target GetTarget (void) const
+    {
+      return EventFunctionImplTarget (m_function);
+    }
 private:
     virtual void Notify (void)
     {
@@ -710,6 +800,11 @@ protected:
     virtual ~EventFunctionImpl4 ()
     {
     }
+public:
+    virtual Target GetTarget (void) const
+    {
+      return EventFunctionImplTarget (m_function);
+    }
 private:
     virtual void Notify (void)
     {
@@ -747,6 +842,11 @@ protected:
     virtual ~EventFunctionImpl5 ()
     {
     }
+public:
+    virtual Target GetTarget (void) const
+    {
+      return EventFunctionImplTarget (m_function);
+    }
 private:
     virtual void Notify (void)
     {
@@ -786,6 +886,11 @@ protected:
     virtual ~EventFunctionImpl6 ()
     {
     }
+public:
+    virtual Target GetTarget (void) const
+    {
+      return EventFunctionImplTarget (m_function);
+    }
 private:
     virtual void Notify (void)
     {
@@ -109,4 +109,33 @@ MapScheduler::Remove (const Event &ev)
   m_list.erase (i);
 }
 
+uint32_t
+MapScheduler::GetN (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_list.size ();
+}
+
+uint32_t
+MapScheduler::DoCompact (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t removed = 0;
+  EventMapI i = m_list.begin ();
+  while (i != m_list.end ())
+    {
+      if (i->second->IsCancelled ())
+        {
+          i->second->Unref ();
+          m_list.erase (i++);
+          removed++;
+        }
+      else
+        {
+          i++;
+        }
+    }
+  return removed;
+}
+
 } // namespace ns3
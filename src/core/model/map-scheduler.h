@@ -61,8 +61,12 @@ public:
   virtual Scheduler::Event PeekNext (void) const;
   virtual Scheduler::Event RemoveNext (void);
   virtual void Remove (const Scheduler::Event &ev);
+  virtual uint32_t GetN (void) const;
 
 private:
+  // Inherited
+  virtual uint32_t DoCompact (void);
+
   /** Event list type: a Map from EventKey to EventImpl. */
   typedef std::map<Scheduler::EventKey, EventImpl*> EventMap;
   /** EventMap iterator. */
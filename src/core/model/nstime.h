@@ -28,6 +28,7 @@
 #include <stdint.h>
 #include <limits>
 #include <cmath>
+#include <cstring>
 #include <ostream>
 #include <set>
 
@@ -428,6 +429,19 @@ public:
    */
   inline static Time FromInteger (uint64_t value, enum Unit unit)
   {
+    if (g_resolution == NS)
+      {
+        // Constant factors, when unit is known at compile time.
+        if (NsFromMul (unit))
+          {
+            value *= NsFactor (unit);
+          }
+        else
+          {
+            value /= NsFactor (unit);
+          }
+        return Time (value);
+      }
     struct Information *info = PeekInformation (unit);
     if (info->fromMul)
       {
@@ -441,6 +455,11 @@ public:
   }
   inline static Time FromDouble (double value, enum Unit unit)
   {
+    int64_t step;
+    if (FromDoubleExact (value, unit, step))
+      {
+        return Time (step);
+      }
     return From (int64x64_t (value), unit);
   }
   inline static Time From (const int64x64_t & value, enum Unit unit)
@@ -476,8 +495,21 @@ public:
    */
   inline int64_t ToInteger (enum Unit unit) const
   {
-    struct Information *info = PeekInformation (unit);
     int64_t v = m_data;
+    if (g_resolution == NS)
+      {
+        // Constant factors, when unit is known at compile time.
+        if (NsFromMul (unit))
+          {
+            v /= NsFactor (unit);
+          }
+        else
+          {
+            v *= NsFactor (unit);
+          }
+        return v;
+      }
+    struct Information *info = PeekInformation (unit);
     if (info->toMul)
       {
         v *= info->factor;
@@ -490,6 +522,11 @@ public:
   }
   inline double ToDouble (enum Unit unit) const
   {
+    double value;
+    if (ToDoubleExact (unit, value))
+      {
+        return value;
+      }
     return To (unit).GetDouble ();
   }
   inline int64x64_t To (enum Unit unit) const
@@ -569,6 +606,147 @@ private:
     return & (PeekResolution ()->info[timeUnit]);
   }
 
+  /**
+   *  Get the ratio of \p unit to the default nanosecond resolution,
+   *  or of the nanosecond to \p unit if it is smaller.
+   *
+   *  \param [in] unit The unit.
+   *  \return The ratio, the Information factor of \p unit at the
+   *           nanosecond resolution.
+   */
+  static inline constexpr int64_t NsFactor (enum Unit unit)
+  {
+    return unit == Y   ? 31536000000000000LL :
+           unit == D   ? 86400000000000LL :
+           unit == H   ? 3600000000000LL :
+           unit == MIN ? 60000000000LL :
+           unit == S   ? 1000000000LL :
+           unit == MS  ? 1000000LL :
+           unit == US  ? 1000LL :
+           unit == PS  ? 1000LL :
+           unit == FS  ? 1000000LL :
+           1LL;
+  }
+  /**
+   *  Check if converting from \p unit to the default nanosecond
+   *  resolution multiplies by NsFactor().
+   *
+   *  \param [in] unit The unit.
+   *  \return The Information fromMul of \p unit at the nanosecond
+   *           resolution.
+   */
+  static inline constexpr bool NsFromMul (enum Unit unit)
+  {
+    return unit <= NS;
+  }
+
+  /**
+   *  Convert a value in a unit at least as large as the resolution to
+   *  a time step with integer arithmetic, giving the same result as
+   *  From (int64x64_t (value), unit).
+   *
+   *  A double is \c mantissa * 2^\c exponent, so the conversion to
+   *  int64x64_t is exact when its smallest bit is not below 2^-64,
+   *  and the time step is the floor of \c mantissa * \c factor *
+   *  2^\c exponent.  Other values, and results which would overflow,
+   *  are left to the int64x64_t arithmetic.
+   *
+   *  \param [in] value The value, expressed in \p unit.
+   *  \param [in] unit The unit of \p value.
+   *  \param [out] step The time step, if converted.
+   *  \return \c true if \p value was converted.
+   */
+  static inline bool FromDoubleExact (double value, enum Unit unit, int64_t & step)
+  {
+#if defined (INT64X64_USE_128) && !defined (PYTHON_SCAN)
+    const struct Information *info = PeekInformation (unit);
+    // The factor of years overflows at resolutions below 1 ns.
+    if (!info->fromMul || info->factor <= 0)
+      {
+        return false;
+      }
+    uint64_t bits;
+    std::memcpy (&bits, &value, sizeof (bits));
+    const int biased = static_cast<int> ((bits >> 52) & 0x7ff);
+    if (biased == 0)
+      {
+        // Zero and subnormals are 0 in int64x64_t.
+        step = 0;
+        return true;
+      }
+    const int exponent = biased - 1075;
+    if (exponent < -64 || exponent > 62)
+      {
+        return false;
+      }
+    const bool negative = (bits >> 63) != 0;
+    const uint64_t mantissa = (bits & 0xfffffffffffffULL) | 0x10000000000000ULL;
+    uint128_t product = static_cast<uint128_t> (mantissa) * static_cast<uint64_t> (info->factor);
+    if (exponent >= 0)
+      {
+        if ((product >> (63 - exponent)) != 0)
+          {
+            return false;
+          }
+        product <<= exponent;
+      }
+    else
+      {
+        const int shift = -exponent;
+        const bool fraction = (product & ((static_cast<uint128_t> (1) << shift) - 1)) != 0;
+        product >>= shift;
+        // int64x64_t::GetHigh rounds negative values down.
+        if (negative && fraction)
+          {
+            ++product;
+          }
+        if ((product >> 63) != 0)
+          {
+            return false;
+          }
+      }
+    step = negative ? -static_cast<int64_t> (product) : static_cast<int64_t> (product);
+    return true;
+#else
+    return false;
+#endif
+  }
+  /**
+   *  Compute To (unit).GetDouble () with native 128 bit integers, when
+   *  \p unit is larger than the resolution, giving the same result as
+   *  int64x64_t::MulByInvert and int64x64_t::GetDouble without their
+   *  function calls.
+   *
+   *  \param [in] unit The unit.
+   *  \param [out] value This Time in \p unit, if computed.
+   *  \return \c true if \p value was computed.
+   */
+  inline bool ToDoubleExact (enum Unit unit, double & value) const
+  {
+#if defined (INT64X64_USE_128) && !defined (PYTHON_SCAN)
+    const struct Information *info = PeekInformation (unit);
+    if (info->toMul)
+      {
+        return false;
+      }
+    // The inverse of the factor is a Q0.128 value.
+    const uint64_t inverseHigh = info->timeTo.GetHigh ();
+    const uint64_t inverseLow = info->timeTo.GetLow ();
+    const bool negative = m_data < 0;
+    const uint64_t magnitude = negative ? -static_cast<uint64_t> (m_data) : m_data;
+    uint128_t result = static_cast<uint128_t> (magnitude) * inverseHigh;
+    result += (static_cast<uint128_t> (magnitude) * inverseLow) >> 64;
+    // Both halves convert exactly, as in int64x64_t::GetDouble.
+    const long double high = static_cast<uint64_t> (result >> 64);
+    const long double low = static_cast<uint64_t> (result) * (1.0L / 18446744073709551616.0L);
+    const long double retval = high + low;
+    value = negative ? -retval : retval;
+    return true;
+#else
+    return false;
+#endif
+  }
+
   /**
    *  Set the default resolution
    *
@@ -620,6 +798,11 @@ private:
    *  includes nstime.h.
    */
   static MarkedTimes * g_markingTimes;
+  /**
+   *  The current resolution, to check for the default nanosecond
+   *  resolution without a function call.
+   */
+  static enum Unit g_resolution;
 public:
   /**
    *  Function to force static initialization of Time.
@@ -97,11 +97,9 @@ Object::Object ()
   : m_tid (Object::GetTypeId ()),
     m_disposed (false),
     m_initialized (false),
-    m_aggregates ((struct Aggregates *) std::malloc (sizeof (struct Aggregates))),
-    m_getObjectCount (0)
+    m_aggregates (AllocateAggregates (1))
 {
   NS_LOG_FUNCTION (this);
-  m_aggregates->n = 1;
   m_aggregates->buffer[0] = this;
 }
 Object::~Object () 
@@ -121,10 +119,18 @@ Object::~Object ()
         }
     }
   // finally, if all objects have been removed from the list,
-  // delete the aggregate list
+  // delete the aggregate list. Otherwise, the lookup table still
+  // references this object: drop it and let the remaining objects
+  // fall back to a linear search until they are deleted too.
   if (m_aggregates->n == 0)
     {
-      std::free (m_aggregates);
+      FreeAggregates (m_aggregates);
+    }
+  else if (m_aggregates->cache != 0)
+    {
+      std::free (m_aggregates->cache);
+      m_aggregates->cache = 0;
+      m_aggregates->cacheMask = 0;
     }
   m_aggregates = 0;
 }
@@ -132,10 +138,8 @@ Object::Object (const Object &o)
   : m_tid (o.m_tid),
     m_disposed (false),
     m_initialized (false),
-    m_aggregates ((struct Aggregates *) std::malloc (sizeof (struct Aggregates))),
-    m_getObjectCount (0)
+    m_aggregates (AllocateAggregates (1))
 {
-  m_aggregates->n = 1;
   m_aggregates->buffer[0] = this;
 }
 void
@@ -151,6 +155,22 @@ Object::DoGetObject (TypeId tid) const
   NS_LOG_FUNCTION (this << tid);
   NS_ASSERT (CheckLoose ());
 
+  struct AggregatesCacheEntry *cache = m_aggregates->cache;
+  if (cache != 0)
+    {
+      // The table holds every TypeId implemented by the aggregates and
+      // always has free slots so, probing stops at the matching uid
+      // or at the first empty slot.
+      uint16_t uid = tid.GetUid ();
+      uint32_t mask = m_aggregates->cacheMask;
+      uint32_t i = uid & mask;
+      while (cache[i].uid != uid && cache[i].uid != 0)
+        {
+          i = (i + 1) & mask;
+        }
+      return cache[i].object;
+    }
+
   uint32_t n = m_aggregates->n;
   TypeId objectTid = Object::GetTypeId ();
   for (uint32_t i = 0; i < n; i++)
@@ -163,17 +183,6 @@ Object::DoGetObject (TypeId tid) const
         }
       if (cur == tid)
         {
-          // This is an attempt to 'cache' the result of this lookup.
-          // the idea is that if we perform a lookup for a TypeId on this object,
-          // we are likely to perform the same lookup later so, we make sure
-          // that the aggregate array is sorted by the number of accesses
-          // to each object.
-
-          // first, increment the access count
-          current->m_getObjectCount++;
-          // then, update the sort
-          UpdateSortedArray (m_aggregates, i);
-          // finally, return the match
           return const_cast<Object *> (current);
         }
     }
@@ -185,9 +194,8 @@ Object::Initialize (void)
   /**
    * Note: the code here is a bit tricky because we need to protect ourselves from
    * modifications in the aggregate array while DoInitialize is called. The user's
-   * implementation of the DoInitialize method could call GetObject (which could
-   * reorder the array) and it could call AggregateObject which would add an 
-   * object at the end of the array. To be safe, we restart iteration over the 
+   * implementation of the DoInitialize method could call AggregateObject which
+   * would add an object at the end of the array. To be safe, we restart iteration over the 
    * array whenever we call some user code, just in case.
    */
   NS_LOG_FUNCTION (this);
@@ -216,8 +224,8 @@ Object::Dispose (void)
   /**
    * Note: the code here is a bit tricky because we need to protect ourselves from
    * modifications in the aggregate array while DoDispose is called. The user's
-   * DoDispose implementation could call GetObject (which could reorder the array) 
-   * and it could call AggregateObject which would add an object at the end of the array.
+   * DoDispose implementation could call AggregateObject which would add an object
+   * at the end of the array.
    * So, to be safe, we restart the iteration over the array whenever we call some
    * user code.
    */
@@ -235,18 +243,83 @@ restart:
         }
     }
 }
+struct Object::Aggregates *
+Object::AllocateAggregates (uint32_t n)
+{
+  NS_LOG_FUNCTION (n);
+  NS_ASSERT (n > 0);
+  struct Aggregates *aggregates = 
+    (struct Aggregates *)std::malloc (sizeof(struct Aggregates)+(n-1)*sizeof(Object*));
+  aggregates->n = n;
+  aggregates->cacheMask = 0;
+  aggregates->cache = 0;
+  return aggregates;
+}
+void
+Object::FreeAggregates (struct Aggregates *aggregates)
+{
+  NS_LOG_FUNCTION (aggregates);
+  std::free (aggregates->cache);
+  std::free (aggregates);
+}
 void
-Object::UpdateSortedArray (struct Aggregates *aggregates, uint32_t j) const
+Object::BuildAggregatesCache (struct Aggregates *aggregates)
 {
-  NS_LOG_FUNCTION (this << aggregates << j);
-  while (j > 0 && 
-         aggregates->buffer[j]->m_getObjectCount > aggregates->buffer[j-1]->m_getObjectCount)
+  NS_LOG_FUNCTION (aggregates);
+  TypeId objectTid = Object::GetTypeId ();
+
+  // Count how many TypeIds we may have to insert, ancestors included.
+  uint32_t entries = 0;
+  for (uint32_t i = 0; i < aggregates->n; i++)
+    {
+      TypeId cur = aggregates->buffer[i]->GetInstanceTypeId ();
+      entries++;
+      while (cur != objectTid)
+        {
+          cur = cur.GetParent ();
+          entries++;
+        }
+    }
+
+  // Keep the load factor at or below one half so that probe
+  // sequences stay short and there is always an empty slot.
+  uint32_t size = 8;
+  while (size < 2 * entries)
+    {
+      size <<= 1;
+    }
+  struct AggregatesCacheEntry *cache = 
+    (struct AggregatesCacheEntry *)std::calloc (size, sizeof (struct AggregatesCacheEntry));
+  uint32_t mask = size - 1;
+
+  for (uint32_t i = 0; i < aggregates->n; i++)
     {
-      Object *tmp = aggregates->buffer[j-1];
-      aggregates->buffer[j-1] = aggregates->buffer[j];
-      aggregates->buffer[j] = tmp;
-      j--;
+      Object *current = aggregates->buffer[i];
+      TypeId cur = current->GetInstanceTypeId ();
+      while (true)
+        {
+          uint16_t uid = cur.GetUid ();
+          uint32_t j = uid & mask;
+          while (cache[j].uid != uid && cache[j].uid != 0)
+            {
+              j = (j + 1) & mask;
+            }
+          if (cache[j].uid == 0)
+            {
+              cache[j].uid = uid;
+              cache[j].object = current;
+            }
+          if (cur == objectTid)
+            {
+              break;
+            }
+          cur = cur.GetParent ();
+        }
     }
+
+  std::free (aggregates->cache);
+  aggregates->cache = cache;
+  aggregates->cacheMask = mask;
 }
 void 
 Object::AggregateObject (Ptr<Object> o)
@@ -260,9 +333,7 @@ Object::AggregateObject (Ptr<Object> o)
   Object *other = PeekPointer (o);
   // first create the new aggregate buffer.
   uint32_t total = m_aggregates->n + other->m_aggregates->n;
-  struct Aggregates *aggregates = 
-    (struct Aggregates *)std::malloc (sizeof(struct Aggregates)+(total-1)*sizeof(Object*));
-  aggregates->n = total;
+  struct Aggregates *aggregates = AllocateAggregates (total);
 
   // copy our buffer to the new buffer
   std::memcpy (&aggregates->buffer[0], 
@@ -281,9 +352,12 @@ Object::AggregateObject (Ptr<Object> o)
                           other->GetInstanceTypeId () <<
                           " on objects of type " << typeId);
         }
-      UpdateSortedArray (aggregates, m_aggregates->n + i);
     }
 
+  // index every TypeId of the new aggregate so that GetObject
+  // does not need to search the buffer anymore.
+  BuildAggregatesCache (aggregates);
+
   // keep track of the old aggregate buffers for the iteration
   // of NotifyNewAggregates
   struct Aggregates *a = m_aggregates;
@@ -314,8 +388,8 @@ Object::AggregateObject (Ptr<Object> o)
     }
 
   // Now that we are done with them, we can free our old aggregate buffers
-  std::free (a);
-  std::free (b);
+  FreeAggregates (a);
+  FreeAggregates (b);
 }
 /**
  * This function must be implemented in the stack that needs to notify
@@ -320,6 +320,14 @@ private:
   friend class AggregateIterator;
   friend struct ObjectDeleter;
 
+  /** An entry of the Aggregates lookup table. */
+  struct AggregatesCacheEntry {
+    /** The TypeId uid, or zero if the slot is empty. */
+    uint16_t uid;
+    /** The first aggregated Object which implements \c uid. */
+    Object *object;
+  };
+
   /**
    * The list of Objects aggregated to this one.
    *
@@ -335,6 +343,14 @@ private:
   struct Aggregates {
     /** The number of entries in \c buffer. */
     uint32_t n;
+    /** The number of slots in \c cache minus one (slots are a power of two). */
+    uint32_t cacheMask;
+    /**
+     * Open-addressed table mapping the uid of every TypeId implemented
+     * by an aggregated Object (including its ancestors) to that Object.
+     * Zero when the table has not been built.
+     */
+    struct AggregatesCacheEntry *cache;
     /** The array of Objects. */
     Object *buffer[1];
   };
@@ -387,12 +403,31 @@ private:
   void Construct (const AttributeConstructionList &attributes);
 
   /**
-   * Keep the list of aggregates in most-recently-used order
+   * Allocate an Aggregates array with room for \p n Objects.
+   *
+   * The lookup table is not built.
+   *
+   * \param [in] n The number of Objects in the array.
+   * \returns The new, uninitialized, array.
+   */
+  static struct Aggregates * AllocateAggregates (uint32_t n);
+  /**
+   * Release an Aggregates array and its lookup table.
+   *
+   * \param [in] aggregates The array to free.
+   */
+  static void FreeAggregates (struct Aggregates *aggregates);
+  /**
+   * Build the TypeId lookup table of an Aggregates array.
+   *
+   * Every Object in the array is inserted under its own TypeId and
+   * under each of its ancestors up to and including Object. When
+   * several Objects share an ancestor the first one in the array wins,
+   * so lookups are stable across calls.
    *
    * \param [in,out] aggregates The list of aggregated Objects.
-   * \param [in] i The most recently used entry in the list.
    */
-  void UpdateSortedArray (struct Aggregates *aggregates, uint32_t i) const;
+  static void BuildAggregatesCache (struct Aggregates *aggregates);
   /**
    * Attempt to delete this Object.
    *
@@ -424,14 +459,6 @@ private:
    * so the size of the array is indirectly a reference count.
    */
   struct Aggregates * m_aggregates;
-  /**
-   * The number of times the Object was accessed with a
-   * call to GetObject().
-   *
-   * This integer is used to implement a heuristic to sort
-   * the array of aggregates in most-frequently accessed order.
-   */
-  uint32_t m_getObjectCount;
 };
 
 template <typename T>
@@ -458,14 +485,17 @@ template <typename T>
 Ptr<T> 
 Object::GetObject () const
 {
-  // This is an optimization: if the cast works (which is likely),
-  // things will be pretty fast.
-  T *result = dynamic_cast<T *> (m_aggregates->buffer[0]);
-  if (result != 0)
+  // This is an optimization: if the Object is not aggregated yet, there
+  // is no lookup table and the cast is likely to work.
+  if (m_aggregates->cache == 0)
     {
-      return Ptr<T> (result);
+      T *result = dynamic_cast<T *> (m_aggregates->buffer[0]);
+      if (result != 0)
+        {
+          return Ptr<T> (result);
+        }
     }
-  // if the cast does not work, we try to do a full type check.
+  // Otherwise, look the TypeId up in the aggregates.
   Ptr<Object> found = DoGetObject (T::GetTypeId ());
   if (found != 0)
     {
@@ -0,0 +1,644 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "profiling-simulator-impl.h"
+#include "default-simulator-impl.h"
+#include "simulator.h"
+#include "string.h"
+#include "uinteger.h"
+#include "fatal-error.h"
+#include "log.h"
+
+#include "ns3/core-config.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#if (__GNUC__ >= 3)
+#include <cxxabi.h>
+#endif
+#ifdef HAVE_DLFCN_H
+#include <dlfcn.h>
+#endif
+
+/**
+ * \file
+ * \ingroup simulator
+ * Implementation of class ns3::ProfilingSimulatorImpl.
+ */
+
+namespace ns3 {
+
+// Note:  Logging in this file is largely avoided due to the
+// number of calls that are made to these functions.
+NS_LOG_COMPONENT_DEFINE ("ProfilingSimulatorImpl");
+
+NS_OBJECT_ENSURE_REGISTERED (ProfilingSimulatorImpl);
+
+namespace {
+
+/**
+ * \ingroup simulator
+ * \returns The factory of the DefaultSimulatorImpl.
+ */
+ObjectFactory
+GetDefaultSimulatorImplFactory (void)
+{
+  ObjectFactory factory;
+  factory.SetTypeId (DefaultSimulatorImpl::GetTypeId ());
+  return factory;
+}
+
+/**
+ * \ingroup simulator
+ * Demangle a C++ name.
+ * \param [in] mangled The mangled name.
+ * \returns The demangled name, or \p mangled if it cannot be demangled.
+ */
+std::string
+Demangle (const char *mangled)
+{
+  std::string name = mangled;
+#if (__GNUC__ >= 3)
+  int status;
+  char *demangled = abi::__cxa_demangle (mangled, NULL, NULL, &status);
+  if (status == 0)
+    {
+      name = demangled;
+    }
+  std::free (demangled);
+#endif
+  return name;
+}
+
+/**
+ * \ingroup simulator
+ * Get the name of the type of the object called by events.
+ * \param [in] type The C++ type.
+ * \returns The name of the TypeId registered under the name of
+ *          \p type, or the name of \p type.
+ */
+std::string
+GetTypeName (const std::type_info *type)
+{
+  if (type == 0)
+    {
+      return "";
+    }
+  std::string name = Demangle (type->name ());
+  TypeId tid;
+  if (TypeId::LookupByNameFailSafe (name, &tid))
+    {
+      return tid.GetName ();
+    }
+  return name;
+}
+
+/**
+ * \ingroup simulator
+ * Get the name of the method or function called by events.
+ * \param [in] event The type of the events.
+ * \param [in] function The code called, or 0.
+ * \returns The name of the symbol of \p function, or the name of
+ *          \p event and the address of \p function.
+ */
+std::string
+GetFunctionName (const std::type_info *event, const void *function)
+{
+#ifdef HAVE_DLFCN_H
+  Dl_info info;
+  if (function != 0
+      && dladdr (const_cast<void *> (function), &info) != 0
+      && info.dli_sname != 0
+      && info.dli_saddr == function)
+    {
+      return Demangle (info.dli_sname);
+    }
+#endif
+  std::ostringstream oss;
+  oss << Demangle (event->name ());
+  if (function != 0)
+    {
+      oss << " at " << function;
+    }
+  return oss.str ();
+}
+
+/**
+ * \ingroup simulator
+ * Compare entries by decreasing time.
+ * \param [in] a The first entry.
+ * \param [in] b The second entry.
+ * \returns \c true if \p a took more time than \p b.
+ */
+bool
+CompareTime (const ProfilingSimulatorImpl::Entry &a, const ProfilingSimulatorImpl::Entry &b)
+{
+  return a.nanoseconds > b.nanoseconds;
+}
+
+/**
+ * \ingroup simulator
+ * Print the cost of the events grouped by a label, by decreasing time.
+ * \param [in,out] os The output stream.
+ * \param [in] title The name of the label.
+ * \param [in] costs The cost of the events by label.
+ * \param [in] total The wall clock time of all the events.
+ * \param [in] maxRows The maximum number of rows, or 0 for all.
+ */
+void
+PrintTable (std::ostream &os, std::string title,
+            const std::map<std::string, ProfilingSimulatorImpl::Entry> &costs,
+            int64_t total, uint32_t maxRows)
+{
+  std::vector<std::pair<std::string, ProfilingSimulatorImpl::Entry> > rows (costs.begin (), costs.end ());
+  std::vector<ProfilingSimulatorImpl::Entry> entries;
+  for (std::size_t i = 0; i < rows.size (); ++i)
+    {
+      entries.push_back (rows[i].second);
+      entries.back ().function = rows[i].first;
+    }
+  std::stable_sort (entries.begin (), entries.end (), &CompareTime);
+
+  os << std::endl
+     << std::right << std::setw (12) << "Time (s)"
+     << std::setw (8) << "%"
+     << std::setw (12) << "Events"
+     << std::setw (12) << "Mean (ns)"
+     << "  " << title << std::endl;
+  std::size_t n = entries.size ();
+  if (maxRows != 0 && n > maxRows)
+    {
+      n = maxRows;
+    }
+  for (std::size_t i = 0; i < n; ++i)
+    {
+      const ProfilingSimulatorImpl::Entry &entry = entries[i];
+      os << std::fixed << std::setprecision (6) << std::setw (12) << entry.nanoseconds * 1e-9
+         << std::setprecision (1) << std::setw (8)
+         << (total > 0 ? 100.0 * entry.nanoseconds / total : 0.0)
+         << std::setw (12) << entry.events
+         << std::setw (12) << entry.nanoseconds / static_cast<int64_t> (entry.events)
+         << "  " << entry.function << std::endl;
+    }
+  if (n < entries.size ())
+    {
+      os << "  (" << entries.size () - n << " more)" << std::endl;
+    }
+}
+
+/**
+ * \ingroup simulator
+ * Add the cost of an entry to the cost of a label.
+ * \param [in,out] costs The cost of the events by label.
+ * \param [in] label The label.
+ * \param [in] entry The entry.
+ */
+void
+AddCost (std::map<std::string, ProfilingSimulatorImpl::Entry> &costs,
+         std::string label, const ProfilingSimulatorImpl::Entry &entry)
+{
+  std::map<std::string, ProfilingSimulatorImpl::Entry>::iterator i = costs.find (label);
+  if (i == costs.end ())
+    {
+      costs[label] = entry;
+    }
+  else
+    {
+      i->second.events += entry.events;
+      i->second.nanoseconds += entry.nanoseconds;
+    }
+}
+
+/**
+ * \ingroup simulator
+ * \param [in] context A context.
+ * \returns The name of \p context.
+ */
+std::string
+GetContextName (uint32_t context)
+{
+  if (context == Simulator::NO_CONTEXT)
+    {
+      return "no context";
+    }
+  std::ostringstream oss;
+  oss << "context " << context;
+  return oss.str ();
+}
+
+} // unnamed namespace
+
+
+/**
+ * \ingroup simulator
+ * An event measuring the wall clock time of the event it wraps.
+ */
+class ProfilingSimulatorImpl::ProfiledEvent : public EventImpl
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] profiler The simulator counting the event.
+   * \param [in] event The event measured.
+   */
+  ProfiledEvent (ProfilingSimulatorImpl *profiler, EventImpl *event)
+    : m_profiler (profiler),
+      m_event (event, false)
+  {
+  }
+  virtual Target GetTarget (void) const
+  {
+    return m_event->GetTarget ();
+  }
+
+private:
+  virtual void Notify (void)
+  {
+    // The wrapped event may have been cancelled through a reference
+    // kept by its creator.
+    if (m_event->IsCancelled ())
+      {
+        return;
+      }
+    Target target = m_event->GetTarget ();
+    uint32_t context = m_profiler->GetContext ();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+    m_event->Invoke ();
+    int64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>
+      (std::chrono::steady_clock::now () - start).count ();
+    m_profiler->Record (&typeid (*m_event), target, context, nanoseconds);
+  }
+
+  ProfilingSimulatorImpl *m_profiler;  //!< The simulator counting the event.
+  Ptr<EventImpl> m_event;              //!< The event measured.
+};
+
+
+bool
+ProfilingSimulatorImpl::Key::operator < (const Key &other) const
+{
+  if (function != other.function)
+    {
+      return function < other.function;
+    }
+  if (object != other.object)
+    {
+      return object < other.object;
+    }
+  if (event != other.event)
+    {
+      return event < other.event;
+    }
+  return context < other.context;
+}
+
+TypeId
+ProfilingSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ProfilingSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .SetGroupName ("Core")
+    .AddConstructor<ProfilingSimulatorImpl> ()
+    .AddAttribute ("SimulatorImplFactory",
+                   "Factory for the simulator implementation profiled.",
+                   ObjectFactoryValue (GetDefaultSimulatorImplFactory ()),
+                   MakeObjectFactoryAccessor (&ProfilingSimulatorImpl::m_simulatorImplFactory),
+                   MakeObjectFactoryChecker ())
+    .AddAttribute ("ReportFile",
+                   "The file of the report written by Simulator::Destroy, "
+                   "or empty for the standard output.",
+                   StringValue (""),
+                   MakeStringAccessor (&ProfilingSimulatorImpl::m_reportFile),
+                   MakeStringChecker ())
+    .AddAttribute ("FlameGraphFile",
+                   "The file of the folded stacks written by Simulator::Destroy, "
+                   "or empty for none.",
+                   StringValue (""),
+                   MakeStringAccessor (&ProfilingSimulatorImpl::m_flameGraphFile),
+                   MakeStringChecker ())
+    .AddAttribute ("MaxRows",
+                   "The maximum number of rows of each table of the report, "
+                   "or 0 for all.",
+                   UintegerValue (20),
+                   MakeUintegerAccessor (&ProfilingSimulatorImpl::m_maxRows),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+ProfilingSimulatorImpl::ProfilingSimulatorImpl ()
+  : m_runNanoseconds (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+ProfilingSimulatorImpl::~ProfilingSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+ProfilingSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_simulator)
+    {
+      m_simulator->Dispose ();
+      m_simulator = 0;
+    }
+  SimulatorImpl::DoDispose ();
+}
+
+void
+ProfilingSimulatorImpl::NotifyConstructionCompleted (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_simulator = m_simulatorImplFactory.Create<SimulatorImpl> ();
+  SimulatorImpl::NotifyConstructionCompleted ();
+}
+
+void
+ProfilingSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+  m_simulator->Destroy ();
+  Write ();
+}
+
+void
+ProfilingSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+  m_simulator->SetScheduler (schedulerFactory);
+}
+
+uint32_t
+ProfilingSimulatorImpl::GetSystemId (void) const
+{
+  return m_simulator->GetSystemId ();
+}
+
+bool
+ProfilingSimulatorImpl::IsFinished (void) const
+{
+  return m_simulator->IsFinished ();
+}
+
+void
+ProfilingSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  m_simulator->Run ();
+  m_runNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>
+    (std::chrono::steady_clock::now () - start).count ();
+}
+
+void
+ProfilingSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_simulator->Stop ();
+}
+
+void
+ProfilingSimulatorImpl::Stop (const Time &delay)
+{
+  NS_LOG_FUNCTION (this << delay);
+  m_simulator->Stop (delay);
+}
+
+EventImpl *
+ProfilingSimulatorImpl::Wrap (EventImpl *event)
+{
+  return new ProfiledEvent (this, event);
+}
+
+EventId
+ProfilingSimulatorImpl::Schedule (const Time &delay, EventImpl *event)
+{
+  return m_simulator->Schedule (delay, Wrap (event));
+}
+
+void
+ProfilingSimulatorImpl::ScheduleWithContext (uint32_t context, const Time &delay, EventImpl *event)
+{
+  m_simulator->ScheduleWithContext (context, delay, Wrap (event));
+}
+
+EventId
+ProfilingSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  return m_simulator->ScheduleNow (Wrap (event));
+}
+
+EventId
+ProfilingSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  return m_simulator->ScheduleDestroy (Wrap (event));
+}
+
+Time
+ProfilingSimulatorImpl::Now (void) const
+{
+  return m_simulator->Now ();
+}
+
+Time
+ProfilingSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  return m_simulator->GetDelayLeft (id);
+}
+
+void
+ProfilingSimulatorImpl::Remove (const EventId &id)
+{
+  m_simulator->Remove (id);
+}
+
+void
+ProfilingSimulatorImpl::Cancel (const EventId &id)
+{
+  m_simulator->Cancel (id);
+}
+
+bool
+ProfilingSimulatorImpl::IsExpired (const EventId &id) const
+{
+  return m_simulator->IsExpired (id);
+}
+
+Time
+ProfilingSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return m_simulator->GetMaximumSimulationTime ();
+}
+
+uint32_t
+ProfilingSimulatorImpl::GetContext (void) const
+{
+  return m_simulator->GetContext ();
+}
+
+void
+ProfilingSimulatorImpl::Record (const std::type_info *event, const EventImpl::Target &target,
+                                uint32_t context, int64_t nanoseconds)
+{
+  Key key;
+  key.event = event;
+  key.object = target.object;
+  key.function = target.function;
+  key.context = context;
+  Cost &cost = m_costs[key];
+  cost.events++;
+  cost.nanoseconds += nanoseconds;
+}
+
+std::vector<ProfilingSimulatorImpl::Entry>
+ProfilingSimulatorImpl::GetEntries (void) const
+{
+  NS_LOG_FUNCTION (this);
+  // Merge the keys with the same names, such as the instances of
+  // a template in several libraries.
+  typedef std::pair<std::string, std::string> Names;
+  std::map<Key, Names> names;
+  std::map<std::pair<Names, uint32_t>, Entry> merged;
+  for (std::map<Key, Cost>::const_iterator i = m_costs.begin (); i != m_costs.end (); ++i)
+    {
+      Key code = i->first;
+      code.context = 0;
+      std::map<Key, Names>::iterator j = names.find (code);
+      if (j == names.end ())
+        {
+          Names name (GetFunctionName (code.event, code.function), GetTypeName (code.object));
+          j = names.insert (std::make_pair (code, name)).first;
+        }
+      std::pair<Names, uint32_t> id (j->second, i->first.context);
+      std::map<std::pair<Names, uint32_t>, Entry>::iterator k = merged.find (id);
+      if (k == merged.end ())
+        {
+          Entry entry;
+          entry.function = j->second.first;
+          entry.type = j->second.second;
+          entry.context = i->first.context;
+          entry.events = 0;
+          entry.nanoseconds = 0;
+          k = merged.insert (std::make_pair (id, entry)).first;
+        }
+      k->second.events += i->second.events;
+      k->second.nanoseconds += i->second.nanoseconds;
+    }
+
+  std::vector<Entry> entries;
+  for (std::map<std::pair<Names, uint32_t>, Entry>::const_iterator i = merged.begin ();
+       i != merged.end (); ++i)
+    {
+      entries.push_back (i->second);
+    }
+  std::stable_sort (entries.begin (), entries.end (), &CompareTime);
+  return entries;
+}
+
+void
+ProfilingSimulatorImpl::PrintReport (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this << &os);
+  std::vector<Entry> entries = GetEntries ();
+  std::map<std::string, Entry> functions;
+  std::map<std::string, Entry> types;
+  std::map<std::string, Entry> contexts;
+  uint64_t events = 0;
+  int64_t total = 0;
+  for (std::size_t i = 0; i < entries.size (); ++i)
+    {
+      const Entry &entry = entries[i];
+      events += entry.events;
+      total += entry.nanoseconds;
+      AddCost (functions, entry.function, entry);
+      AddCost (types, entry.type.empty () ? "(function)" : entry.type, entry);
+      AddCost (contexts, GetContextName (entry.context), entry);
+    }
+
+  std::ios_base::fmtflags flags = os.flags ();
+  std::streamsize precision = os.precision ();
+  os << "Simulator profile: " << events << " events in "
+     << std::fixed << std::setprecision (6) << total * 1e-9 << " s, Run "
+     << m_runNanoseconds * 1e-9 << " s" << std::endl;
+  PrintTable (os, "Function", functions, total, m_maxRows);
+  PrintTable (os, "Type", types, total, m_maxRows);
+  PrintTable (os, "Context", contexts, total, m_maxRows);
+  os.flags (flags);
+  os.precision (precision);
+}
+
+void
+ProfilingSimulatorImpl::PrintFlameGraph (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this << &os);
+  std::vector<Entry> entries = GetEntries ();
+  std::map<std::string, int64_t> stacks;
+  for (std::size_t i = 0; i < entries.size (); ++i)
+    {
+      const Entry &entry = entries[i];
+      std::ostringstream stack;
+      if (!entry.type.empty ())
+        {
+          stack << entry.type << ";";
+        }
+      stack << entry.function << ";" << GetContextName (entry.context);
+      stacks[stack.str ()] += entry.nanoseconds;
+    }
+  for (std::map<std::string, int64_t>::const_iterator i = stacks.begin (); i != stacks.end (); ++i)
+    {
+      os << i->first << " " << i->second << std::endl;
+    }
+}
+
+void
+ProfilingSimulatorImpl::Write (void) const
+{
+  NS_LOG_FUNCTION (this);
+  if (m_reportFile.empty ())
+    {
+      PrintReport (std::cout);
+    }
+  else
+    {
+      std::ofstream os (m_reportFile.c_str ());
+      if (!os.good ())
+        {
+          NS_FATAL_ERROR ("Could not open \"" << m_reportFile << "\"");
+        }
+      PrintReport (os);
+    }
+  if (!m_flameGraphFile.empty ())
+    {
+      std::ofstream os (m_flameGraphFile.c_str ());
+      if (!os.good ())
+        {
+          NS_FATAL_ERROR ("Could not open \"" << m_flameGraphFile << "\"");
+        }
+      PrintFlameGraph (os);
+    }
+}
+
+} // namespace ns3
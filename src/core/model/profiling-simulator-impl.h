@@ -0,0 +1,206 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PROFILING_SIMULATOR_IMPL_H
+#define PROFILING_SIMULATOR_IMPL_H
+
+#include "simulator-impl.h"
+#include "event-impl.h"
+#include "object-factory.h"
+#include "ptr.h"
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup simulator
+ * Declaration of class ns3::ProfilingSimulatorImpl.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup simulator
+ *
+ * \brief A simulator implementation measuring the wall clock time
+ * spent in each event.
+ *
+ * This implementation wraps another one, by default the
+ * DefaultSimulatorImpl, and forwards it all the calls.  It wraps the
+ * events scheduled in turn, to measure the wall clock time of each
+ * of them.  The events are counted by the method or function they
+ * call, by the type of the object called and by the context, usually
+ * the node, they execute in.
+ *
+ * To use it, run the simulation with
+ * \verbatim
+   --SimulatorImplementationType=ns3::ProfilingSimulatorImpl \endverbatim
+ * or set the \c SimulatorImplementationType GlobalValue.
+ * Simulator::Destroy() writes the report, sorted by decreasing time,
+ * on the standard output or to the \c ReportFile, and the costs in the
+ * folded stack format of the FlameGraph tools to the \c FlameGraphFile:
+ * \verbatim
+   $ flamegraph.pl profile.folded > profile.svg \endverbatim
+ *
+ * The events made by MakeEvent() are attributed to the method or
+ * function they call, named from the symbols of the libraries and
+ * programs.  Functions without a dynamic symbol, such as static
+ * functions or the functions of programs not linked with \c -rdynamic,
+ * are named after the type of their event and their address.  The
+ * type of the object called is the name of its TypeId when the class
+ * is registered under its C++ name, and its C++ name otherwise.
+ *
+ * The wrapped implementation must not be looked up through
+ * Simulator::GetImplementation(), so this does not profile the
+ * distributed implementations or the real time features of the
+ * RealtimeSimulatorImpl.
+ */
+class ProfilingSimulatorImpl : public SimulatorImpl
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  ProfilingSimulatorImpl ();
+  /** Destructor. */
+  ~ProfilingSimulatorImpl ();
+
+  // Inherited
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (const Time &delay);
+  virtual EventId Schedule (const Time &delay, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, const Time &delay, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &id);
+  virtual void Cancel (const EventId &id);
+  virtual bool IsExpired (const EventId &id) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+
+  /** The cost of the events calling a function in a context. */
+  struct Entry
+  {
+    std::string function;  //!< The method or function called.
+    std::string type;      //!< The type of the object called, or empty.
+    uint32_t context;      //!< The context of the events.
+    uint64_t events;       //!< The number of events.
+    int64_t nanoseconds;   //!< The wall clock time of the events.
+  };
+
+  /**
+   * Get the cost of the events executed so far.
+   *
+   * \returns The entries, sorted by decreasing time.
+   */
+  std::vector<Entry> GetEntries (void) const;
+  /**
+   * Print the cost of the events by function, by type and by context,
+   * sorted by decreasing time.
+   *
+   * \param [in,out] os The output stream.
+   */
+  void PrintReport (std::ostream &os) const;
+  /**
+   * Print the cost of the events as folded stacks of the type, the
+   * function and the context, weighted by nanoseconds.
+   *
+   * \param [in,out] os The output stream.
+   */
+  void PrintFlameGraph (std::ostream &os) const;
+
+protected:
+  virtual void DoDispose (void);
+  virtual void NotifyConstructionCompleted (void);
+
+private:
+  class ProfiledEvent;
+
+  /**
+   * Wrap an event to measure it.
+   *
+   * \param [in] event The event.
+   * \returns The wrapping event.
+   */
+  EventImpl * Wrap (EventImpl *event);
+  /**
+   * Count the execution of an event.
+   *
+   * \param [in] event The type of the event.
+   * \param [in] target The method or function called by the event.
+   * \param [in] context The context of the event.
+   * \param [in] nanoseconds The wall clock time of the event.
+   */
+  void Record (const std::type_info *event, const EventImpl::Target &target,
+               uint32_t context, int64_t nanoseconds);
+  /** Write the report and the flame graph at the end of the simulation. */
+  void Write (void) const;
+
+  /** The events counted together. */
+  struct Key
+  {
+    const std::type_info *event;   //!< The type of the event.
+    const std::type_info *object;  //!< The type of the object called.
+    const void *function;          //!< The code called.
+    uint32_t context;              //!< The context.
+    /**
+     * Compare two keys.
+     * \param [in] other The other key.
+     * \returns \c true if this key is before \p other.
+     */
+    bool operator < (const Key &other) const;
+  };
+  /** The cost of the events of a Key. */
+  struct Cost
+  {
+    uint64_t events;       //!< The number of events.
+    int64_t nanoseconds;   //!< The wall clock time of the events.
+  };
+
+  /** The wrapped simulator. */
+  Ptr<SimulatorImpl> m_simulator;
+  /** The factory of the wrapped simulator. */
+  ObjectFactory m_simulatorImplFactory;
+  /** The cost of the events. */
+  std::map<Key, Cost> m_costs;
+  /** The wall clock time of Run. */
+  int64_t m_runNanoseconds;
+  /** The file of the report, or empty for the standard output. */
+  std::string m_reportFile;
+  /** The file of the folded stacks, or empty. */
+  std::string m_flameGraphFile;
+  /** The maximum number of rows of each table of the report. */
+  uint32_t m_maxRows;
+};
+
+} // namespace ns3
+
+#endif /* PROFILING_SIMULATOR_IMPL_H */
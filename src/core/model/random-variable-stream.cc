@@ -34,8 +34,10 @@
 #include "rng-stream.h"
 #include "rng-seed-manager.h"
 #include "unused.h"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <vector>
 
 /**
  * \file
@@ -47,6 +49,71 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("RandomVariableStream");
 
+/**
+ * \ingroup randomvariable
+ * Build the guide table of a non-decreasing CDF, for SearchCdf.
+ *
+ * The guide table has one entry per value of the CDF: entry \c g is
+ * the index of the first value of the CDF larger than \c g divided by
+ * the size of the table.
+ *
+ * \param [in] cdf The values of the CDF.
+ * \param [out] guide The guide table.
+ */
+static void
+BuildCdfGuide (const std::vector<double> &cdf, std::vector<uint32_t> &guide)
+{
+  uint32_t size = cdf.size ();
+  guide.resize (size);
+  uint32_t i = 0;
+  for (uint32_t g = 0; g < size; ++g)
+    {
+      double threshold = static_cast<double> (g) / size;
+      while (i < size && cdf[i] <= threshold)
+        {
+          i++;
+        }
+      guide[g] = i;
+    }
+}
+
+/**
+ * \ingroup randomvariable
+ * Find the first value of a CDF larger than \p u.
+ *
+ * The guide table gives the index to start the search from, so that
+ * the expected number of values compared is at most two, however the
+ * probabilities are distributed.  The result is the same as a linear
+ * or binary search.
+ *
+ * \param [in] cdf The values of the CDF.
+ * \param [in] guide The guide table built by BuildCdfGuide.
+ * \param [in] u The probability, in [0,1].
+ * \returns The index of the first value larger than \p u, or the size
+ *          of the CDF if there is none.
+ */
+static uint32_t
+SearchCdf (const std::vector<double> &cdf, const std::vector<uint32_t> &guide, double u)
+{
+  uint32_t size = cdf.size ();
+  if (size == 0)
+    {
+      return 0;
+    }
+  uint32_t g = static_cast<uint32_t> (u * size);
+  uint32_t i = guide[std::min (g, size - 1)];
+  // u * size may have been rounded up to the next bucket
+  while (i > 0 && cdf[i - 1] > u)
+    {
+      i--;
+    }
+  while (i < size && cdf[i] <= u)
+    {
+      i++;
+    }
+  return i;
+}
+
 NS_OBJECT_ENSURE_REGISTERED (RandomVariableStream);
 
 TypeId 
@@ -96,6 +163,15 @@ RandomVariableStream::IsAntithetic(void) const
   return m_isAntithetic;
 }
 void
+RandomVariableStream::GetValues (double *values, uint64_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  for (uint64_t i = 0; i < n; ++i)
+    {
+      values[i] = GetValue ();
+    }
+}
+void
 RandomVariableStream::SetStream (int64_t stream)
 {
   NS_LOG_FUNCTION (this << stream);
@@ -208,6 +284,29 @@ UniformRandomVariable::GetInteger (void)
   NS_LOG_FUNCTION (this);
   return (uint32_t)GetValue (m_min, m_max + 1);
 }
+void
+UniformRandomVariable::GetValues (double *values, uint64_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  Peek ()->RandU01 (values, n);
+  double min = m_min;
+  double max = m_max;
+  if (IsAntithetic ())
+    {
+      for (uint64_t i = 0; i < n; ++i)
+        {
+          double v = min + values[i] * (max - min);
+          values[i] = min + (max - v);
+        }
+    }
+  else
+    {
+      for (uint64_t i = 0; i < n; ++i)
+        {
+          values[i] = min + values[i] * (max - min);
+        }
+    }
+}
 
 NS_OBJECT_ENSURE_REGISTERED(ConstantRandomVariable);
 
@@ -445,6 +544,32 @@ ExponentialRandomVariable::GetInteger (void)
   NS_LOG_FUNCTION (this);
   return (uint32_t)GetValue (m_mean, m_bound);
 }
+void
+ExponentialRandomVariable::GetValues (double *values, uint64_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  bool antithetic = IsAntithetic ();
+  uint64_t filled = 0;
+  while (filled < n)
+    {
+      // Draw one uniform for each value still needed into the free
+      // part of the array, and keep the accepted values in order.
+      // A candidate gives at most one value, so no uniform is drawn
+      // that GetValue (void) would not have drawn.
+      uint64_t candidates = n - filled;
+      double *u = values + filled;
+      Peek ()->RandU01 (u, candidates);
+      for (uint64_t i = 0; i < candidates; ++i)
+        {
+          double v = antithetic ? (1 - u[i]) : u[i];
+          double r = -m_mean*std::log (v);
+          if (m_bound == 0 || r <= m_bound)
+            {
+              values[filled++] = r;
+            }
+        }
+    }
+}
 
 NS_OBJECT_ENSURE_REGISTERED(ParetoRandomVariable);
 
@@ -778,6 +903,65 @@ NormalRandomVariable::GetInteger (void)
   NS_LOG_FUNCTION (this);
   return (uint32_t)GetValue (m_mean, m_variance, m_bound);
 }
+void
+NormalRandomVariable::GetValues (double *values, uint64_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  uint64_t filled = 0;
+  if (n > 0 && m_nextValid)
+    { // use previously generated
+      m_nextValid = false;
+      values[filled++] = m_next;
+    }
+
+  // Number of candidate pairs drawn from the stream at once.
+  static const uint64_t BLOCK_PAIRS = 256;
+  double u[2 * BLOCK_PAIRS];
+  bool antithetic = IsAntithetic ();
+  double sd = std::sqrt (m_variance);
+  while (filled < n)
+    {
+      // Each pair gives at most two values, so drawing no more pairs
+      // than half the values still needed, rounded up, never draws
+      // a uniform that GetValue (void) would not have drawn.
+      uint64_t pairs = std::min ((n - filled + 1) / 2, BLOCK_PAIRS);
+      Peek ()->RandU01 (u, 2 * pairs);
+      for (uint64_t i = 0; i < pairs; ++i)
+        {
+          double u1 = u[2 * i];
+          double u2 = u[2 * i + 1];
+          if (antithetic)
+            {
+              u1 = (1 - u1);
+              u2 = (1 - u2);
+            }
+          double v1 = 2 * u1 - 1;
+          double v2 = 2 * u2 - 1;
+          double w = v1 * v1 + v2 * v2;
+          if (w <= 1.0)
+            { // Got good pair, same steps as GetValue (mean, variance, bound)
+              double y = std::sqrt ((-2 * std::log (w)) / w);
+              m_next = m_mean + v2 * y * sd;
+              m_nextValid = std::fabs (m_next - m_mean) <= m_bound;
+              double x1 = m_mean + v1 * y * sd;
+              if (std::fabs (x1 - m_mean) <= m_bound)
+                {
+                  values[filled++] = x1;
+                  if (m_nextValid && filled < n)
+                    {
+                      m_nextValid = false;
+                      values[filled++] = m_next;
+                    }
+                }
+              else if (m_nextValid)
+                {
+                  m_nextValid = false;
+                  values[filled++] = m_next;
+                }
+            }
+        }
+    }
+}
 
 NS_OBJECT_ENSURE_REGISTERED(LogNormalRandomVariable);
 
@@ -1303,6 +1487,9 @@ ZipfRandomVariable::GetTypeId (void)
   return tid;
 }
 ZipfRandomVariable::ZipfRandomVariable ()
+  : m_c (0.0),
+    m_tableN (0),
+    m_tableAlpha (0.0)
 {
   // m_n and m_alpha are initialized after constructor by attributes
   NS_LOG_FUNCTION (this);
@@ -1321,10 +1508,15 @@ ZipfRandomVariable::GetAlpha (void) const
   return m_alpha;
 }
 
-double 
-ZipfRandomVariable::GetValue (uint32_t n, double alpha)
+void
+ZipfRandomVariable::BuildTable (uint32_t n, double alpha)
 {
   NS_LOG_FUNCTION (this << n << alpha);
+  if (n == m_tableN && alpha == m_tableAlpha && m_cdf.size () == n)
+    {
+      return;
+    }
+
   // Calculate the normalization constant c.
   m_c = 0.0;
   for (uint32_t i = 1; i <= n; i++)
@@ -1333,6 +1525,27 @@ ZipfRandomVariable::GetValue (uint32_t n, double alpha)
     }
   m_c = 1.0 / m_c;
 
+  // The CDF is summed in the same order as the values are searched,
+  // so that each uniform value gives the same Zipf value as a linear
+  // search of the distribution.
+  m_cdf.resize (n);
+  double sum_prob = 0;
+  for (uint32_t i = 1; i <= n; i++)
+    {
+      sum_prob += m_c / std::pow ((double)i,alpha);
+      m_cdf[i - 1] = sum_prob;
+    }
+  BuildCdfGuide (m_cdf, m_guide);
+  m_tableN = n;
+  m_tableAlpha = alpha;
+}
+
+double 
+ZipfRandomVariable::GetValue (uint32_t n, double alpha)
+{
+  NS_LOG_FUNCTION (this << n << alpha);
+  BuildTable (n, alpha);
+
   // Get a uniform random variable in [0,1].
   double u = Peek ()->RandU01 ();
   if (IsAntithetic ())
@@ -1340,16 +1553,10 @@ ZipfRandomVariable::GetValue (uint32_t n, double alpha)
       u = (1 - u);
     }
 
-  double sum_prob = 0,zipf_value = 0;
-  for (uint32_t i = 1; i <= m_n; i++)
-    {
-      sum_prob += m_c / std::pow ((double)i,m_alpha);
-      if (sum_prob > u)
-        {
-          zipf_value = i;
-          break;
-        }
-    }
+  // The first value whose cumulative probability is larger than u;
+  // rounding may leave the last one below u, which gives 0.
+  uint32_t i = SearchCdf (m_cdf, m_guide, u);
+  double zipf_value = (i < m_cdf.size ()) ? i + 1 : 0;
   return zipf_value;
 }
 
@@ -1599,28 +1806,11 @@ EmpiricalRandomVariable::GetValue (void)
     {
       return emp.back ().value;  // Greater than last
     }
-  // Binary search
-  std::vector<ValueCDF>::size_type bottom = 0;
-  std::vector<ValueCDF>::size_type top = emp.size () - 1;
-  while (1)
-    {
-      std::vector<ValueCDF>::size_type c = (top + bottom) / 2;
-      if (r >= emp[c].cdf && r < emp[c + 1].cdf)
-        { // Found it
-          return Interpolate (emp[c].cdf, emp[c + 1].cdf,
-                              emp[c].value, emp[c + 1].value,
-                              r);
-        }
-      // Not here, adjust bounds
-      if (r < emp[c].cdf)
-        {
-          top    = c - 1;
-        }
-      else
-        {
-          bottom = c + 1;
-        }
-    }
+  // The point before the first one whose CDF is larger than r
+  std::vector<ValueCDF>::size_type c = SearchCdf (m_cdf, m_guide, r) - 1;
+  return Interpolate (emp[c].cdf, emp[c + 1].cdf,
+                      emp[c].value, emp[c + 1].value,
+                      r);
 }
 
 uint32_t 
@@ -1635,6 +1825,7 @@ void EmpiricalRandomVariable::CDF (double v, double c)
   // NOTE.   These MUST be inserted in non-decreasing order
   NS_LOG_FUNCTION (this << v << c);
   emp.push_back (ValueCDF (v, c));
+  validated = false;
 }
 
 void EmpiricalRandomVariable::Validate ()
@@ -1655,6 +1846,12 @@ void EmpiricalRandomVariable::Validate ()
         }
       prior = current;
     }
+  m_cdf.resize (emp.size ());
+  for (std::vector<ValueCDF>::size_type i = 0; i < emp.size (); ++i)
+    {
+      m_cdf[i] = emp[i].cdf;
+    }
+  BuildCdfGuide (m_cdf, m_guide);
   validated = true;
 }
 
@@ -30,6 +30,7 @@
 #include "object.h"
 #include "attribute-helper.h"
 #include <stdint.h>
+#include <vector>
 
 /**
  * \file
@@ -149,6 +150,20 @@ public:
    */
   virtual uint32_t GetInteger (void) = 0;
 
+  /**
+   * \brief Get the next \p n random values drawn from the distribution.
+   *
+   * The values, and the state of the stream afterwards, are the
+   * same as those of \p n successive calls to GetValue(void).
+   * This implementation makes those calls; subclasses override it
+   * to draw the uniforms for all the values with one call to the
+   * underlying RNG stream and transform them in a tight loop.
+   *
+   * \param [out] values The array to fill, of at least \p n elements.
+   * \param [in] n The number of values.
+   */
+  virtual void GetValues (double *values, uint64_t n);
+
 protected:
   /**
    * \brief Get the pointer to the underlying RNG stream.
@@ -293,6 +308,7 @@ public:
    * \note The upper limit is included in the output range.
    */
   virtual uint32_t GetInteger (void);
+  virtual void GetValues (double *values, uint64_t n);
   
 private:
   /** The lower bound on values that can be returned by this RNG stream. */
@@ -585,6 +601,7 @@ public:
   // Inherited from RandomVariableStream
   virtual double GetValue (void);
   virtual uint32_t GetInteger (void);
+  virtual void GetValues (double *values, uint64_t n);
 
 private:
   /** The mean value of the unbounded exponential distribution. */
@@ -1233,6 +1250,20 @@ public:
    */
   virtual uint32_t GetInteger (void);
 
+  /**
+   * \brief Get the next \p n random values from a normal distribution
+   * with the current mean, variance, and bound.
+   *
+   * The uniforms are drawn two per candidate pair, for no more
+   * pairs than the values still needed could use, so the stream
+   * and the saved second value of a pair end up as after \p n
+   * calls to GetValue(void).
+   *
+   * \param [out] values The array to fill, of at least \p n elements.
+   * \param [in] n The number of values.
+   */
+  virtual void GetValues (double *values, uint64_t n);
+
 private:
   /** The mean value for the normal distribution returned by this RNG stream. */
   double m_mean;
@@ -2095,6 +2126,13 @@ private:
  *   //               
  *   double value = x->GetValue ();
  * \endcode
+ *
+ * The cumulative distribution is computed once, when the first value
+ * is requested after N or Alpha has changed, in a table of N doubles
+ * with a guide table of N indices, so that each value takes a constant
+ * expected time.  Each value consumes exactly one uniform value of the
+ * stream, and is the smallest \f$ k \f$ whose cumulative probability
+ * is larger than it, as a linear search of the distribution would give.
  */
 class ZipfRandomVariable : public RandomVariableStream
 {
@@ -2191,9 +2229,27 @@ private:
   /** The alpha value for the Zipf distribution returned by this RNG stream. */
   double m_alpha;
 
+  /**
+   * Compute the cumulative distribution, unless it is already computed
+   * for \p n and \p alpha.
+   *
+   * \param [in] n N value for the Zipf distribution.
+   * \param [in] alpha Alpha value for the Zipf distribution.
+   */
+  void BuildTable (uint32_t n, double alpha);
+
   /** The normalization constant. */
   double m_c;
 
+  /** The cumulative probability of each value, from 1 to n. */
+  std::vector<double> m_cdf;
+  /** The guide table of the cumulative distribution. */
+  std::vector<uint32_t> m_guide;
+  /** The n value the cumulative distribution was computed for. */
+  uint32_t m_tableN;
+  /** The alpha value the cumulative distribution was computed for. */
+  double m_tableAlpha;
+
 };  // class ZipfRandomVariable
   
 
@@ -2437,6 +2493,12 @@ private:
  *   //                          
  *   double value = x->GetValue ();
  * \endcode
+ *
+ * The points are searched with a guide table, computed when the first
+ * value is requested after points were added, so that each value takes
+ * a constant expected time.  Each value consumes exactly one uniform
+ * value of the stream, and is interpolated between the same points as
+ * a binary search of the CDF would find.
  */
 class EmpiricalRandomVariable : public RandomVariableStream
 {
@@ -2541,6 +2603,10 @@ public:
   bool validated;
   /** The vector of CDF points. */
   std::vector<ValueCDF> emp; 
+  /** The CDF of each point, once validated. */
+  std::vector<double> m_cdf;
+  /** The guide table of the CDF, once validated. */
+  std::vector<uint32_t> m_guide;
 
 };  // class EmpiricalRandomVariable
   
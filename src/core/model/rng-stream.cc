@@ -366,6 +366,63 @@ double RngStream::RandU01 ()
   return u;
 }
 
+//-------------------------------------------------------------------------
+// Generate the next n random numbers.
+//
+// The first component is x[i] = a12 * x[i-2] - a13n * x[i-3], so
+// x[i] and x[i+1] both depend only on values already known and are
+// computed together; the second component has a lag 1 term and is
+// computed one value at a time.  Each value takes exactly the same
+// floating point operations as RandU01 (void).
+//
+void RngStream::RandU01 (double *values, uint64_t n)
+{
+  double s10 = m_currentState[0];
+  double s11 = m_currentState[1];
+  double s12 = m_currentState[2];
+  double s20 = m_currentState[3];
+  double s21 = m_currentState[4];
+  double s22 = m_currentState[5];
+
+  uint64_t i = 0;
+  for (; i + 1 < n; i += 2)
+    {
+      /* Component 1, two values */
+      double p1a = a12 * s11 - a13n * s10;
+      double p1b = a12 * s12 - a13n * s11;
+      int32_t ka = static_cast<int32_t> (p1a / m1);
+      int32_t kb = static_cast<int32_t> (p1b / m1);
+      p1a -= ka * m1;
+      p1b -= kb * m1;
+      p1a += (p1a < 0.0) ? m1 : 0.0;
+      p1b += (p1b < 0.0) ? m1 : 0.0;
+      s10 = s12; s11 = p1a; s12 = p1b;
+
+      /* Component 2, two values */
+      double p2a = a21 * s22 - a23n * s20;
+      int32_t k = static_cast<int32_t> (p2a / m2);
+      p2a -= k * m2;
+      p2a += (p2a < 0.0) ? m2 : 0.0;
+      double p2b = a21 * p2a - a23n * s21;
+      k = static_cast<int32_t> (p2b / m2);
+      p2b -= k * m2;
+      p2b += (p2b < 0.0) ? m2 : 0.0;
+      s20 = s22; s21 = p2a; s22 = p2b;
+
+      /* Combination */
+      values[i] = (p1a > p2a) ? (p1a - p2a) * norm : (p1a - p2a + m1) * norm;
+      values[i + 1] = (p1b > p2b) ? (p1b - p2b) * norm : (p1b - p2b + m1) * norm;
+    }
+
+  m_currentState[0] = s10; m_currentState[1] = s11; m_currentState[2] = s12;
+  m_currentState[3] = s20; m_currentState[4] = s21; m_currentState[5] = s22;
+
+  if (i < n)
+    {
+      values[i] = RandU01 ();
+    }
+}
+
 RngStream::RngStream (uint32_t seedNumber, uint64_t stream, uint64_t substream)
 {
   if (seedNumber >= m1 || seedNumber >= m2 || seedNumber == 0)
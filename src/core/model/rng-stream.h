@@ -70,6 +70,18 @@ public:
    * \returns The next random.
    */
   double RandU01 (void);
+  /**
+   * Generate the next \p n random numbers for this stream.
+   *
+   * The values are the same as those of \p n successive calls
+   * to RandU01(void), but the state is kept in local variables
+   * and the independent recurrences of consecutive values of the
+   * first component are computed together.
+   *
+   * \param [out] values The array to fill, of at least \p n elements.
+   * \param [in] n The number of randoms.
+   */
+  void RandU01 (double *values, uint64_t n);
 
 private:
   /**
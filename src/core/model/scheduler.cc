@@ -19,8 +19,12 @@
  */
 
 #include "scheduler.h"
+#include "event-impl.h"
+#include "double.h"
+#include "uinteger.h"
 #include "assert.h"
 #include "log.h"
+#include <vector>
 
 /**
  * \file
@@ -34,6 +38,16 @@ NS_LOG_COMPONENT_DEFINE ("Scheduler");
 
 NS_OBJECT_ENSURE_REGISTERED (Scheduler);
 
+Scheduler::Scheduler ()
+  : m_compactionThreshold (0.5),
+    m_compactionMinimum (1000),
+    m_cancelled (0),
+    m_compactions (0),
+    m_compacted (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
 Scheduler::~Scheduler ()
 {
   NS_LOG_FUNCTION (this);
@@ -45,8 +59,108 @@ Scheduler::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::Scheduler")
     .SetParent<Object> ()
     .SetGroupName ("Core")
+    .AddAttribute ("CompactionThreshold",
+                   "The fraction of cancelled events in the event list "
+                   "above which they are removed from it, "
+                   "or 1 to leave them until they reach its head.",
+                   DoubleValue (0.5),
+                   MakeDoubleAccessor (&Scheduler::m_compactionThreshold),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("CompactionMinimum",
+                   "The number of cancelled events below which "
+                   "the event list is never compacted.",
+                   UintegerValue (1000),
+                   MakeUintegerAccessor (&Scheduler::m_compactionMinimum),
+                   MakeUintegerChecker<uint32_t> ())
   ;
   return tid;
 }
 
+uint32_t
+Scheduler::NotifyCancel (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_cancelled++;
+  uint32_t n = GetN ();
+  if (n != 0 && m_cancelled >= m_compactionMinimum
+      && m_cancelled > m_compactionThreshold * n)
+    {
+      return Compact ();
+    }
+  return 0;
+}
+
+uint32_t
+Scheduler::Compact (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t removed = DoCompact ();
+  NS_LOG_LOGIC ("removed " << removed << " cancelled events, " << GetN () << " left");
+  m_cancelled = 0;
+  m_compactions++;
+  m_compacted += removed;
+  return removed;
+}
+
+uint32_t
+Scheduler::GetN (void) const
+{
+  return 0;
+}
+
+uint32_t
+Scheduler::GetCancelled (void) const
+{
+  return m_cancelled;
+}
+
+uint32_t
+Scheduler::GetCompactions (void) const
+{
+  return m_compactions;
+}
+
+uint64_t
+Scheduler::GetCompacted (void) const
+{
+  return m_compacted;
+}
+
+void
+Scheduler::NotifyRemoveNext (const Event &ev)
+{
+  // the count is only an estimate: the events cancelled without
+  // notification are not counted
+  if (m_cancelled != 0 && ev.impl->IsCancelled ())
+    {
+      m_cancelled--;
+    }
+}
+
+uint32_t
+Scheduler::DoCompact (void)
+{
+  NS_LOG_FUNCTION (this);
+  std::vector<Event> events;
+  events.reserve (GetN ());
+  while (!IsEmpty ())
+    {
+      events.push_back (RemoveNext ());
+    }
+  uint32_t removed = 0;
+  for (std::vector<Event>::const_iterator i = events.begin (); i != events.end (); i++)
+    {
+      if (i->impl->IsCancelled ())
+        {
+          i->impl->Unref ();
+          removed++;
+        }
+      else
+        {
+          Insert (*i);
+        }
+    }
+  return removed;
+}
+
 } // namespace ns3
@@ -62,6 +62,12 @@ class EventImpl;
  * calling EventId::Ref and SimpleRefCount::Unref at the right time.
  * Typically, EventId::Ref is called before Insert and SimpleRefCount::Unref is called
  * after a call to one of the Remove methods.
+ *
+ * The cancelled events stay in the event list until they reach its
+ * head.  The simulator notifies the scheduler of each cancellation with
+ * NotifyCancel, and when the cancelled events make more than the
+ * CompactionThreshold fraction of the event list, they are all removed
+ * from it at once (and unreferenced) by Compact.
  */
 class Scheduler : public Object
 {
@@ -72,6 +78,9 @@ public:
    */
   static TypeId GetTypeId (void);
 
+  /** Constructor. */
+  Scheduler ();
+
   /**
    * \ingroup events
    * Structure for sorting and comparing Events.
@@ -135,6 +144,74 @@ public:
    * \param [in] ev The event to remove
    */
   virtual void Remove (const Event &ev) = 0;
+  /**
+   * Get the number of events in the event list, including the cancelled
+   * events which have not been removed yet.
+   *
+   * The default implementation returns 0, which disables the compaction
+   * of the event list.
+   *
+   * \returns The number of events.
+   */
+  virtual uint32_t GetN (void) const;
+
+  /**
+   * Notify the scheduler that one of the events of its list has been
+   * cancelled, and compact the event list if the cancelled events make
+   * more than the CompactionThreshold fraction of it.
+   *
+   * \returns The number of cancelled events removed from the event list.
+   */
+  uint32_t NotifyCancel (void);
+  /**
+   * Account for an event removed by RemoveNext, which may have been
+   * cancelled.  The simulators which call NotifyCancel call this method
+   * for each event they get from RemoveNext.
+   *
+   * \param [in] ev The event removed.
+   */
+  void NotifyRemoveNext (const Event &ev);
+  /**
+   * Remove all the cancelled events from the event list, and unreference
+   * them.
+   *
+   * \returns The number of events removed.
+   */
+  uint32_t Compact (void);
+  /**
+   * \returns The number of cancelled events in the event list.
+   */
+  uint32_t GetCancelled (void) const;
+  /**
+   * \returns The number of compactions of the event list.
+   */
+  uint32_t GetCompactions (void) const;
+  /**
+   * \returns The number of cancelled events removed by the compactions.
+   */
+  uint64_t GetCompacted (void) const;
+
+private:
+  /**
+   * Remove and unreference the cancelled events.  This default
+   * implementation empties the event list and inserts the events which
+   * have not been cancelled back into it: the subclasses should filter
+   * their events in place.
+   *
+   * \returns The number of events removed.
+   */
+  virtual uint32_t DoCompact (void);
+
+  /** The fraction of cancelled events above which they are removed. */
+  double m_compactionThreshold;
+  /** The minimum number of cancelled events to compact the event list. */
+  uint32_t m_compactionMinimum;
+  /** The number of cancelled events in the event list. */
+  uint32_t m_cancelled;
+  /** The number of compactions. */
+  uint32_t m_compactions;
+  /** The number of events removed by the compactions. */
+  uint64_t m_compacted;
 };
 
 /**
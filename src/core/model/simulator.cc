@@ -132,6 +132,30 @@ NodePrinter (std::ostream &os)
     }
 }
 
+/**
+ * \ingroup logging
+ * Default LogBinaryTimeSource implementation.
+ *
+ * \returns The current simulation time step.
+ */
+static int64_t
+TimeSource (void)
+{
+  return Simulator::Now ().GetTimeStep ();
+}
+
+/**
+ * \ingroup logging
+ * Default LogBinaryNodeSource implementation.
+ *
+ * \returns The current context.
+ */
+static uint32_t
+NodeSource (void)
+{
+  return Simulator::GetContext ();
+}
+
 /**
  * \ingroup simulator
  * \brief Get the static SimulatorImpl instance.
@@ -182,6 +206,7 @@ static SimulatorImpl * GetImpl (void)
 //
       LogSetTimePrinter (&TimePrinter);
       LogSetNodePrinter (&NodePrinter);
+      LogBinarySetSources (&TimeSource, &NodeSource);
     }
   return *pimpl;
 }
@@ -203,6 +228,7 @@ Simulator::Destroy (void)
    */
   LogSetTimePrinter (0);
   LogSetNodePrinter (0);
+  LogBinarySetSources (0, 0);
   (*pimpl)->Destroy ();
   (*pimpl)->Unref ();
   *pimpl = 0;
@@ -419,6 +445,7 @@ Simulator::SetImplementation (Ptr<SimulatorImpl> impl)
 //
   LogSetTimePrinter (&TimePrinter);
   LogSetNodePrinter (&NodePrinter);
+  LogBinarySetSources (&TimeSource, &NodeSource);
 }
 
 Ptr<SimulatorImpl>
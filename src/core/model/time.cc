@@ -42,6 +42,8 @@ NS_LOG_COMPONENT_DEFINE_MASK ("Time", ns3::LOG_PREFIX_TIME);
 // static
 Time::MarkedTimes * Time::g_markingTimes = 0;
 
+enum Time::Unit Time::g_resolution = Time::NS;
+
 /**
  * \internal
  * Get mutex for critical sections around modification of Time::g_markingTimes
@@ -181,6 +183,7 @@ Time::SetResolution (enum Unit resolution)
 {
   NS_LOG_FUNCTION (resolution);
   SetResolution (resolution, PeekResolution ());
+  g_resolution = resolution;
 }
 
 
@@ -128,7 +128,13 @@ public:
    * \param [in] delay The amount of time until the timer expires.
    * \returns The scheduled EventId.
    */
-  virtual EventId Schedule (const Time &delay) = 0;
+  EventId Schedule (const Time &delay);
+  /**
+   * Make an event invoking the callback with the current arguments.
+   *
+   * \returns The event.
+   */
+  virtual EventImpl * MakeEvent (void) = 0;
   /** Invoke the expire function. */
   virtual void Invoke (void) = 0;
 };
@@ -270,9 +276,9 @@ MakeTimerImpl (IntToType<0>, FN fn)
       : m_fn (fn)
     {
     }
-    virtual EventId Schedule (const Time &delay)
+    virtual EventImpl * MakeEvent (void)
     {
-      return Simulator::Schedule (delay, m_fn);
+      return ns3::MakeEvent (m_fn);
     }
     virtual void Invoke (void)
     {
@@ -305,9 +311,9 @@ MakeTimerImpl (IntToType<1>, FN fn)
     {
       m_a1 = a1;
     }
-    virtual EventId Schedule (const Time &delay)
+    virtual EventImpl * MakeEvent (void)
     {
-      return Simulator::Schedule (delay, m_fn, m_a1);
+      return ns3::MakeEvent (m_fn, m_a1);
     }
     virtual void Invoke (void)
     {
@@ -345,9 +351,9 @@ MakeTimerImpl (IntToType<2>, FN fn)
       m_a1 = a1;
       m_a2 = a2;
     }
-    virtual EventId Schedule (const Time &delay)
+    virtual EventImpl * MakeEvent (void)
     {
-      return Simulator::Schedule (delay, m_fn, m_a1, m_a2);
+      return ns3::MakeEvent (m_fn, m_a1, m_a2);
     }
     virtual void Invoke (void)
     {
@@ -390,9 +396,9 @@ MakeTimerImpl (IntToType<3>, FN fn)
       m_a2 = a2;
       m_a3 = a3;
     }
-    virtual EventId Schedule (const Time &delay)
+    virtual EventImpl * MakeEvent (void)
     {
-      return Simulator::Schedule (delay, m_fn, m_a1, m_a2, m_a3);
+      return ns3::MakeEvent (m_fn, m_a1, m_a2, m_a3);
     }
     virtual void Invoke (void)
     {
@@ -440,9 +446,9 @@ MakeTimerImpl (IntToType<4>, FN fn)
       m_a3 = a3;
       m_a4 = a4;
     }
-    virtual EventId Schedule (const Time &delay)
+    virtual EventImpl * MakeEvent (void)
     {
-      return Simulator::Schedule (delay, m_fn, m_a1, m_a2, m_a3, m_a4);
+      return ns3::MakeEvent (m_fn, m_a1, m_a2, m_a3, m_a4);
     }
     virtual void Invoke (void)
     {
@@ -495,9 +501,9 @@ MakeTimerImpl (IntToType<5>, FN fn)
       m_a4 = a4;
       m_a5 = a5;
     }
-    virtual EventId Schedule (const Time &delay)
+    virtual EventImpl * MakeEvent (void)
     {
-      return Simulator::Schedule (delay, m_fn, m_a1, m_a2, m_a3, m_a4, m_a5);
+      return ns3::MakeEvent (m_fn, m_a1, m_a2, m_a3, m_a4, m_a5);
     }
     virtual void Invoke (void)
     {
@@ -555,9 +561,9 @@ MakeTimerImpl (IntToType<6>, FN fn)
       m_a5 = a5;
       m_a6 = a6;
     }
-    virtual EventId Schedule (const Time &delay)
+    virtual EventImpl * MakeEvent (void)
     {
-      return Simulator::Schedule (delay, m_fn, m_a1, m_a2, m_a3, m_a4, m_a5, m_a6);
+      return ns3::MakeEvent (m_fn, m_a1, m_a2, m_a3, m_a4, m_a5, m_a6);
     }
     virtual void Invoke (void)
     {
@@ -645,9 +651,9 @@ MakeTimerImpl (IntToType<0>, MEM_PTR memPtr, OBJ_PTR objPtr)
         m_objPtr (objPtr)
     {
     }
-    virtual EventId Schedule (const Time &delay)
+    virtual EventImpl * MakeEvent (void)
     {
-      return Simulator::Schedule (delay, m_memPtr, m_objPtr);
+      return ns3::MakeEvent (m_memPtr, m_objPtr);
     }
     virtual void Invoke (void)
     {
@@ -682,9 +688,9 @@ MakeTimerImpl (IntToType<1>, MEM_PTR memPtr, OBJ_PTR objPtr)
     {
       m_a1 = a1;
     }
-    virtual EventId Schedule (const Time &delay)
+    virtual EventImpl * MakeEvent (void)
     {
-      return Simulator::Schedule (delay, m_memPtr, m_objPtr, m_a1);
+      return ns3::MakeEvent (m_memPtr, m_objPtr, m_a1);
     }
     virtual void Invoke (void)
     {
@@ -724,9 +730,9 @@ MakeTimerImpl (IntToType<2>, MEM_PTR memPtr, OBJ_PTR objPtr)
       m_a1 = a1;
       m_a2 = a2;
     }
-    virtual EventId Schedule (const Time &delay)
+    virtual EventImpl * MakeEvent (void)
     {
-      return Simulator::Schedule (delay, m_memPtr, m_objPtr, m_a1, m_a2);
+      return ns3::MakeEvent (m_memPtr, m_objPtr, m_a1, m_a2);
     }
     virtual void Invoke (void)
     {
@@ -771,9 +777,9 @@ MakeTimerImpl (IntToType<3>, MEM_PTR memPtr, OBJ_PTR objPtr)
       m_a2 = a2;
       m_a3 = a3;
     }
-    virtual EventId Schedule (const Time &delay)
+    virtual EventImpl * MakeEvent (void)
     {
-      return Simulator::Schedule (delay, m_memPtr, m_objPtr, m_a1, m_a2, m_a3);
+      return ns3::MakeEvent (m_memPtr, m_objPtr, m_a1, m_a2, m_a3);
     }
     virtual void Invoke (void)
     {
@@ -823,9 +829,9 @@ MakeTimerImpl (IntToType<4>, MEM_PTR memPtr, OBJ_PTR objPtr)
       m_a3 = a3;
       m_a4 = a4;
     }
-    virtual EventId Schedule (const Time &delay)
+    virtual EventImpl * MakeEvent (void)
     {
-      return Simulator::Schedule (delay, m_memPtr, m_objPtr, m_a1, m_a2, m_a3, m_a4);
+      return ns3::MakeEvent (m_memPtr, m_objPtr, m_a1, m_a2, m_a3, m_a4);
     }
     virtual void Invoke (void)
     {
@@ -880,9 +886,9 @@ MakeTimerImpl (IntToType<5>, MEM_PTR memPtr, OBJ_PTR objPtr)
       m_a4 = a4;
       m_a5 = a5;
     }
-    virtual EventId Schedule (const Time &delay)
+    virtual EventImpl * MakeEvent (void)
     {
-      return Simulator::Schedule (delay, m_memPtr, m_objPtr, m_a1, m_a2, m_a3, m_a4, m_a5);
+      return ns3::MakeEvent (m_memPtr, m_objPtr, m_a1, m_a2, m_a3, m_a4, m_a5);
     }
     virtual void Invoke (void)
     {
@@ -942,9 +948,9 @@ MakeTimerImpl (IntToType<6>, MEM_PTR memPtr, OBJ_PTR objPtr)
       m_a5 = a5;
       m_a6 = a6;
     }
-    virtual EventId Schedule (const Time &delay)
+    virtual EventImpl * MakeEvent (void)
     {
-      return Simulator::Schedule (delay, m_memPtr, m_objPtr, m_a1, m_a2, m_a3, m_a4, m_a5, m_a6);
+      return ns3::MakeEvent (m_memPtr, m_objPtr, m_a1, m_a2, m_a3, m_a4, m_a5, m_a6);
     }
     virtual void Invoke (void)
     {
@@ -0,0 +1,384 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "timer-wheel.h"
+#include "simulator.h"
+#include "simulation-singleton.h"
+#include "assert.h"
+#include "log.h"
+#include <algorithm>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup timer
+ * ns3::TimerWheel implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TimerWheel");
+
+/**
+ * Compare the order in which two timers have been scheduled.
+ *
+ * \param [in] a The first timer.
+ * \param [in] b The second timer.
+ * \returns \c true if \p a has been scheduled before \p b.
+ */
+static bool
+IsScheduledBefore (const Ptr<TimerWheel::Event> &a, const Ptr<TimerWheel::Event> &b)
+{
+  return a->GetUid () < b->GetUid ();
+}
+
+TimerWheel::Event::Event ()
+  : m_wheel (0),
+    m_slot (0),
+    m_prev (0),
+    m_next (0),
+    m_tick (0),
+    m_uid (0),
+    m_level (0),
+    m_context (0)
+{
+}
+
+TimerWheel::Event::~Event ()
+{
+  NS_ASSERT (m_slot == 0);
+}
+
+bool
+TimerWheel::Event::IsRunning (void) const
+{
+  return m_slot != 0;
+}
+
+void
+TimerWheel::Event::Cancel (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_slot != 0)
+    {
+      m_event = 0;
+      m_wheel->Unlink (this);
+    }
+}
+
+uint64_t
+TimerWheel::Event::GetUid (void) const
+{
+  return m_uid;
+}
+
+Time
+TimerWheel::Event::GetDelayLeft (void) const
+{
+  if (m_slot == 0)
+    {
+      return TimeStep (0);
+    }
+  uint64_t expiration = m_tick * m_wheel->m_resolution;
+  uint64_t now = Simulator::Now ().GetTimeStep ();
+  return TimeStep (expiration > now ? expiration - now : 0);
+}
+
+TimerWheel::TimerWheel ()
+  : m_resolution (MilliSeconds (1).GetTimeStep ()),
+    m_currentTick (0),
+    m_uid (0),
+    m_expiring (0),
+    m_eventTick (0)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t level = 0; level < LEVELS; level++)
+    {
+      for (uint32_t index = 0; index < SLOTS; index++)
+        {
+          m_slots[level][index] = 0;
+        }
+      m_counts[level] = 0;
+    }
+}
+
+TimerWheel::TimerWheel (const Time &resolution)
+  : m_resolution (resolution.GetTimeStep ()),
+    m_currentTick (0),
+    m_uid (0),
+    m_expiring (0),
+    m_eventTick (0)
+{
+  NS_LOG_FUNCTION (this << resolution);
+  NS_ASSERT (resolution.IsStrictlyPositive ());
+  for (uint32_t level = 0; level < LEVELS; level++)
+    {
+      for (uint32_t index = 0; index < SLOTS; index++)
+        {
+          m_slots[level][index] = 0;
+        }
+      m_counts[level] = 0;
+    }
+}
+
+TimerWheel::~TimerWheel ()
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t level = 0; level < LEVELS; level++)
+    {
+      for (uint32_t index = 0; index < SLOTS; index++)
+        {
+          while (m_slots[level][index] != 0)
+            {
+              Event *event = m_slots[level][index];
+              event->m_wheel = 0;
+              event->m_event = 0;
+              Unlink (event);
+            }
+        }
+    }
+  m_event.Cancel ();
+}
+
+TimerWheel *
+TimerWheel::GetDefault (void)
+{
+  return SimulationSingleton<TimerWheel>::Get ();
+}
+
+void
+TimerWheel::SetResolution (const Time &resolution)
+{
+  NS_LOG_FUNCTION (this << resolution);
+  NS_ASSERT_MSG (GetN () == 0, "The resolution of a timer wheel cannot be changed while timers are running");
+  NS_ASSERT (resolution.IsStrictlyPositive ());
+  m_resolution = resolution.GetTimeStep ();
+  m_currentTick = 0;
+  m_event.Cancel ();
+}
+
+Time
+TimerWheel::GetResolution (void) const
+{
+  return TimeStep (m_resolution);
+}
+
+uint32_t
+TimerWheel::GetN (void) const
+{
+  uint32_t n = 0;
+  for (uint32_t level = 0; level < LEVELS; level++)
+    {
+      n += m_counts[level];
+    }
+  return n;
+}
+
+Ptr<TimerWheel::Event>
+TimerWheel::Schedule (const Time &delay, const Ptr<EventImpl> &event)
+{
+  NS_LOG_FUNCTION (this << delay << event);
+  NS_ASSERT (!delay.IsStrictlyNegative ());
+  Ptr<Event> timer = Create<Event> ();
+  timer->m_wheel = this;
+  timer->m_event = event;
+  timer->m_context = Simulator::GetContext ();
+  timer->m_uid = m_uid++;
+  // the ticks before now have no timer to process: they are skipped
+  uint64_t now = Simulator::Now ().GetTimeStep ();
+  m_currentTick = std::max ((now + m_resolution - 1) / m_resolution, m_currentTick);
+  uint64_t expiration = now + delay.GetTimeStep ();
+  timer->m_tick = std::max ((expiration + m_resolution - 1) / m_resolution, m_currentTick);
+  Arm (Link (PeekPointer (timer)));
+  return timer;
+}
+
+Ptr<TimerWheel::Event>
+TimerWheel::Schedule (const Time &delay, void (*f)(void))
+{
+  return Schedule (delay, Ptr<EventImpl> (MakeEvent (f), false));
+}
+
+uint64_t
+TimerWheel::Link (Event *event)
+{
+  NS_ASSERT (event->m_tick >= m_currentTick);
+  uint64_t tick = event->m_tick;
+  uint64_t range = uint64_t (1) << (LEVELS * SLOT_BITS);
+  if (tick - m_currentTick >= range)
+    {
+      // too far to be indexed: the timer is cascaded again later
+      tick = m_currentTick + range - 1;
+    }
+  uint32_t level = 0;
+  while ((tick - m_currentTick) >> ((level + 1) * SLOT_BITS) != 0)
+    {
+      level++;
+    }
+  uint32_t shift = level * SLOT_BITS;
+  Event **slot = &m_slots[level][(tick >> shift) & SLOT_MASK];
+
+  event->Ref ();
+  event->m_slot = slot;
+  event->m_level = level;
+  event->m_prev = 0;
+  event->m_next = *slot;
+  if (*slot != 0)
+    {
+      (*slot)->m_prev = event;
+    }
+  *slot = event;
+  m_counts[level]++;
+
+  // the timers of the upper levels are processed when they are cascaded
+  return (tick >> shift) << shift;
+}
+
+void
+TimerWheel::Unlink (Event *event)
+{
+  if (event->m_prev != 0)
+    {
+      event->m_prev->m_next = event->m_next;
+    }
+  else
+    {
+      *event->m_slot = event->m_next;
+    }
+  if (event->m_next != 0)
+    {
+      event->m_next->m_prev = event->m_prev;
+    }
+  m_counts[event->m_level]--;
+  event->m_slot = 0;
+  event->m_prev = 0;
+  event->m_next = 0;
+  event->Unref ();
+}
+
+void
+TimerWheel::Cascade (uint32_t level, uint32_t index)
+{
+  NS_LOG_FUNCTION (this << level << index);
+  while (m_slots[level][index] != 0)
+    {
+      Ptr<Event> event = m_slots[level][index];
+      Unlink (PeekPointer (event));
+      Link (PeekPointer (event));
+    }
+}
+
+uint64_t
+TimerWheel::GetNextTick (void) const
+{
+  uint64_t tick = m_currentTick;
+  for (uint32_t level = 0; level < LEVELS; level++)
+    {
+      uint32_t shift = level * SLOT_BITS;
+      // the slots from the current one to the end of the level map to
+      // the ticks of the current round of the level
+      for (uint64_t index = (tick >> shift) & SLOT_MASK; index < SLOTS; index++)
+        {
+          if (m_slots[level][index] != 0)
+            {
+              return tick + ((index - ((tick >> shift) & SLOT_MASK)) << shift);
+            }
+        }
+      // the next round starts when the upper level is cascaded, on its next
+      // boundary, which may be the current tick; the other slots of the
+      // level belong to this next round
+      uint64_t mask = (uint64_t (1) << (shift + SLOT_BITS)) - 1;
+      tick = (tick + mask) & ~mask;
+      if (m_counts[level] != 0)
+        {
+          break;
+        }
+    }
+  return tick;
+}
+
+void
+TimerWheel::Arm (uint64_t tick)
+{
+  if (m_event.IsRunning () && m_eventTick <= tick)
+    {
+      return;
+    }
+  m_event.Cancel ();
+  m_eventTick = tick;
+  Time delay = TimeStep (tick * m_resolution) - Simulator::Now ();
+  NS_LOG_LOGIC ("Next tick " << tick << " in " << delay);
+  m_event = Simulator::Schedule (delay, &TimerWheel::ProcessTick, this, tick);
+}
+
+void
+TimerWheel::ProcessTick (uint64_t tick)
+{
+  NS_LOG_FUNCTION (this << tick);
+  NS_ASSERT (tick >= m_currentTick);
+  // no timer is due between the last tick processed and this one
+  m_currentTick = tick;
+  for (uint32_t level = 1; level < LEVELS; level++)
+    {
+      uint32_t shift = level * SLOT_BITS;
+      if ((tick & ((uint64_t (1) << shift) - 1)) != 0)
+        {
+          break;
+        }
+      Cascade (level, (tick >> shift) & SLOT_MASK);
+    }
+
+  // the timers scheduled by the timers expired now go to the next ticks
+  m_currentTick = tick + 1;
+  Event **slot = &m_slots[0][tick & SLOT_MASK];
+  m_expiring = *slot;
+  *slot = 0;
+  std::vector<Ptr<Event> > expiring;
+  for (Event *event = m_expiring; event != 0; event = event->m_next)
+    {
+      event->m_slot = &m_expiring;
+      expiring.push_back (event);
+    }
+  // the cascades do not keep the order of the timers
+  std::sort (expiring.begin (), expiring.end (), &IsScheduledBefore);
+  uint32_t context = Simulator::GetContext ();
+  for (std::vector<Ptr<Event> >::const_iterator it = expiring.begin (); it != expiring.end (); it++)
+    {
+      Ptr<Event> event = *it;
+      if (!event->IsRunning ())
+        {
+          // cancelled by a timer expired before
+          continue;
+        }
+      Ptr<EventImpl> impl = event->m_event;
+      event->m_event = 0;
+      Unlink (PeekPointer (event));
+      if (event->m_context == context)
+        {
+          impl->Invoke ();
+        }
+      else
+        {
+          Simulator::ScheduleWithContext (event->m_context, Time (0), GetPointer (impl));
+        }
+    }
+
+  if (GetN () != 0)
+    {
+      Arm (GetNextTick ());
+    }
+}
+
+} // namespace ns3
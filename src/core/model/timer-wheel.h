@@ -0,0 +1,294 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include "nstime.h"
+#include "event-id.h"
+#include "event-impl.h"
+#include "make-event.h"
+#include "ptr.h"
+#include "simple-ref-count.h"
+
+/**
+ * \file
+ * \ingroup timer
+ * ns3::TimerWheel class declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup timer
+ * \brief A hierarchical timer wheel for coarse-grained timers.
+ *
+ * The timers of a wheel expire on the ticks of the wheel, whose period
+ * is the resolution of the wheel: a timer expires on the first tick at
+ * or after its expiration time.  All the timers which expire on a tick
+ * are invoked by a single simulator event, and a timer is cancelled by
+ * unlinking it from the wheel in constant time, so that protocols which
+ * cancel and reschedule their timers at a high rate do not fill the
+ * simulator scheduler with cancelled events.
+ *
+ * The wheel has four levels of 64 slots: the timers which expire in
+ * less than 64 ticks are in the slots of the first level, one per tick,
+ * and the later timers are in the slots of the upper levels, which are
+ * cascaded down to the lower levels as the time advances.  The simulator
+ * event of the wheel is only scheduled for the ticks which have timers
+ * to expire or to cascade.
+ *
+ * The timers are invoked in the context in which they were scheduled:
+ * those scheduled in another context than the tick event are invoked
+ * by an event scheduled with this context.
+ */
+class TimerWheel
+{
+public:
+  /**
+   * \brief A timer scheduled in a TimerWheel.
+   *
+   * The events are created by TimerWheel::Schedule.
+   */
+  class Event : public SimpleRefCount<Event>
+  {
+public:
+    Event ();
+    ~Event ();
+    /**
+     * \returns \c true if the timer has not expired nor been cancelled.
+     */
+    bool IsRunning (void) const;
+    /**
+     * Cancel the timer, removing it from its wheel.  Do nothing if the
+     * timer is not running.
+     */
+    void Cancel (void);
+    /**
+     * \returns The time left until the timer expires, or zero if it is
+     * not running.
+     */
+    Time GetDelayLeft (void) const;
+    /**
+     * \returns The rank of the timer in the order of the calls to
+     * TimerWheel::Schedule, which is the order of the timers expiring on
+     * the same tick.
+     */
+    uint64_t GetUid (void) const;
+
+private:
+    friend class TimerWheel;
+
+    TimerWheel *m_wheel;      //!< The wheel, or 0 if it has been destroyed.
+    Event **m_slot;           //!< The slot list, or 0 if the timer is not running.
+    Event *m_prev;            //!< The previous timer of the slot list.
+    Event *m_next;            //!< The next timer of the slot list.
+    uint64_t m_tick;          //!< The tick on which the timer expires.
+    uint64_t m_uid;           //!< The rank of the timer.
+    uint32_t m_level;         //!< The level of the slot.
+    uint32_t m_context;       //!< The context of the timer.
+    Ptr<EventImpl> m_event;   //!< The function to invoke.
+  };
+
+  /** Create a wheel with a resolution of one millisecond. */
+  TimerWheel ();
+  /**
+   * Create a wheel.
+   *
+   * \param [in] resolution The period of the ticks.
+   */
+  TimerWheel (const Time &resolution);
+  /** Destructor: the timers still running are cancelled. */
+  ~TimerWheel ();
+
+  /**
+   * Get the wheel shared by the whole simulation, which is deleted by
+   * Simulator::Destroy.
+   *
+   * \returns The default wheel.
+   */
+  static TimerWheel * GetDefault (void);
+
+  /**
+   * \param [in] resolution The period of the ticks.
+   *
+   * The resolution can only be changed when no timer is running.
+   */
+  void SetResolution (const Time &resolution);
+  /**
+   * \returns The period of the ticks.
+   */
+  Time GetResolution (void) const;
+  /**
+   * \returns The number of timers running.
+   */
+  uint32_t GetN (void) const;
+
+  /**
+   * Schedule a timer.
+   *
+   * \param [in] delay The delay after which the timer expires, rounded
+   *             up to the next tick.
+   * \param [in] event The event to invoke.
+   * \returns The timer, which can be cancelled.
+   */
+  Ptr<Event> Schedule (const Time &delay, const Ptr<EventImpl> &event);
+  /**
+   * Schedule a timer invoking a member function.
+   *
+   * \tparam MEM \deduced Class method function signature type.
+   * \tparam OBJ \deduced Class type of the object.
+   * \param [in] delay The delay after which the timer expires.
+   * \param [in] mem_ptr Member method pointer to invoke.
+   * \param [in] obj The object on which to invoke the member method.
+   * \returns The timer, which can be cancelled.
+   */
+  template <typename MEM, typename OBJ>
+  Ptr<Event> Schedule (const Time &delay, MEM mem_ptr, OBJ obj);
+  /**
+   * \copybrief Schedule(const Time&,MEM,OBJ)
+   *
+   * \tparam MEM \deduced Class method function signature type.
+   * \tparam OBJ \deduced Class type of the object.
+   * \tparam T1 \deduced Type of first argument.
+   * \param [in] delay The delay after which the timer expires.
+   * \param [in] mem_ptr Member method pointer to invoke.
+   * \param [in] obj The object on which to invoke the member method.
+   * \param [in] a1 The first argument to pass to the invoked method.
+   * \returns The timer, which can be cancelled.
+   */
+  template <typename MEM, typename OBJ, typename T1>
+  Ptr<Event> Schedule (const Time &delay, MEM mem_ptr, OBJ obj, T1 a1);
+  /**
+   * Schedule a timer invoking a function.
+   *
+   * \param [in] delay The delay after which the timer expires.
+   * \param [in] f The function to invoke.
+   * \returns The timer, which can be cancelled.
+   */
+  Ptr<Event> Schedule (const Time &delay, void (*f)(void));
+  /**
+   * \copybrief Schedule(const Time&,void(*)(void))
+   *
+   * \tparam U1 \deduced Formal type of the first argument to the function.
+   * \tparam T1 \deduced Actual type of the first argument.
+   * \param [in] delay The delay after which the timer expires.
+   * \param [in] f The function to invoke.
+   * \param [in] a1 The first argument to pass to the function.
+   * \returns The timer, which can be cancelled.
+   */
+  template <typename U1, typename T1>
+  Ptr<Event> Schedule (const Time &delay, void (*f)(U1), T1 a1);
+
+private:
+  /** Number of levels of the wheel. */
+  static const uint32_t LEVELS = 4;
+  /** Number of bits of the slot index in a level. */
+  static const uint32_t SLOT_BITS = 6;
+  /** Number of slots of a level. */
+  static const uint32_t SLOTS = 1 << SLOT_BITS;
+  /** Mask of the slot index in a level. */
+  static const uint64_t SLOT_MASK = SLOTS - 1;
+
+  /**
+   * Add a timer to the slot of its tick.
+   *
+   * \param [in] event The timer.
+   * \returns The first tick on which the wheel has to process the timer.
+   */
+  uint64_t Link (Event *event);
+  /**
+   * Remove a timer from its slot.
+   *
+   * \param [in] event The timer.
+   */
+  void Unlink (Event *event);
+  /**
+   * Move the timers of a slot to the lower levels.
+   *
+   * \param [in] level The level of the slot.
+   * \param [in] index The index of the slot.
+   */
+  void Cascade (uint32_t level, uint32_t index);
+  /**
+   * \returns The next tick on which the wheel has timers to expire or
+   * to cascade.
+   */
+  uint64_t GetNextTick (void) const;
+  /**
+   * Schedule the simulator event of the wheel, unless it is already
+   * scheduled earlier.
+   *
+   * \param [in] tick The tick of the event.
+   */
+  void Arm (uint64_t tick);
+  /**
+   * Cascade the upper levels and expire the timers of the current tick.
+   *
+   * \param [in] tick The current tick.
+   */
+  void ProcessTick (uint64_t tick);
+
+  /** The period of the ticks, in time steps. */
+  uint64_t m_resolution;
+  /** The first tick which has not been processed. */
+  uint64_t m_currentTick;
+  /** The rank of the next timer scheduled. */
+  uint64_t m_uid;
+  /** The slot lists of each level. */
+  Event *m_slots[LEVELS][SLOTS];
+  /** The number of timers in each level. */
+  uint32_t m_counts[LEVELS];
+  /** The timers of the tick being processed which have not expired yet. */
+  Event *m_expiring;
+  /** The simulator event of the wheel. */
+  EventId m_event;
+  /** The tick of the simulator event of the wheel. */
+  uint64_t m_eventTick;
+};
+
+} // namespace ns3
+
+
+/********************************************************************
+ *  Implementation of the templates declared above.
+ ********************************************************************/
+
+namespace ns3 {
+
+template <typename MEM, typename OBJ>
+Ptr<TimerWheel::Event>
+TimerWheel::Schedule (const Time &delay, MEM mem_ptr, OBJ obj)
+{
+  return Schedule (delay, Ptr<EventImpl> (MakeEvent (mem_ptr, obj), false));
+}
+
+template <typename MEM, typename OBJ, typename T1>
+Ptr<TimerWheel::Event>
+TimerWheel::Schedule (const Time &delay, MEM mem_ptr, OBJ obj, T1 a1)
+{
+  return Schedule (delay, Ptr<EventImpl> (MakeEvent (mem_ptr, obj, a1), false));
+}
+
+template <typename U1, typename T1>
+Ptr<TimerWheel::Event>
+TimerWheel::Schedule (const Time &delay, void (*f)(U1), T1 a1)
+{
+  return Schedule (delay, Ptr<EventImpl> (MakeEvent (f, a1), false));
+}
+
+} // namespace ns3
+
+#endif /* TIMER_WHEEL_H */
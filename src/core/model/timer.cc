@@ -36,6 +36,7 @@ Timer::Timer ()
   : m_flags (CHECK_ON_DESTROY),
     m_delay (FemtoSeconds (0)),
     m_event (),
+    m_wheel (0),
     m_impl (0)
 {
   NS_LOG_FUNCTION (this);
@@ -45,6 +46,7 @@ Timer::Timer (enum DestroyPolicy destroyPolicy)
   : m_flags (destroyPolicy),
     m_delay (FemtoSeconds (0)),
     m_event (),
+    m_wheel (0),
     m_impl (0)
 {
   NS_LOG_FUNCTION (this << destroyPolicy);
@@ -55,7 +57,7 @@ Timer::~Timer ()
   NS_LOG_FUNCTION (this);
   if (m_flags & CHECK_ON_DESTROY)
     {
-      if (m_event.IsRunning ())
+      if (m_event.IsRunning () || (m_wheelEvent && m_wheelEvent->IsRunning ()))
         {
           NS_FATAL_ERROR ("Event is still running while destroying.");
         }
@@ -68,6 +70,11 @@ Timer::~Timer ()
     {
       Simulator::Remove (m_event);
     }
+  if (m_wheelEvent)
+    {
+      // a timer of the wheel cannot be removed, only cancelled
+      m_wheelEvent->Cancel ();
+    }
   delete m_impl;
 }
 
@@ -83,6 +90,14 @@ Timer::GetDelay (void) const
   NS_LOG_FUNCTION (this);
   return m_delay;
 }
+void
+Timer::SetTimerWheel (TimerWheel *wheel)
+{
+  NS_LOG_FUNCTION (this << wheel);
+  NS_ASSERT_MSG (IsExpired (), "The timer wheel cannot be changed while the timer is running or suspended");
+  m_wheel = wheel;
+  m_wheelEvent = 0;
+}
 Time
 Timer::GetDelayLeft (void) const
 {
@@ -90,6 +105,10 @@ Timer::GetDelayLeft (void) const
   switch (GetState ())
     {
     case Timer::RUNNING:
+      if (m_wheel != 0)
+        {
+          return m_wheelEvent->GetDelayLeft ();
+        }
       return Simulator::GetDelayLeft (m_event);
       break;
     case Timer::EXPIRED:
@@ -110,23 +129,39 @@ Timer::Cancel (void)
 {
   NS_LOG_FUNCTION (this);
   Simulator::Cancel (m_event);
+  if (m_wheelEvent)
+    {
+      m_wheelEvent->Cancel ();
+    }
 }
 void
 Timer::Remove (void)
 {
   NS_LOG_FUNCTION (this);
   Simulator::Remove (m_event);
+  if (m_wheelEvent)
+    {
+      m_wheelEvent->Cancel ();
+    }
 }
 bool
 Timer::IsExpired (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_wheel != 0)
+    {
+      return !IsSuspended () && !(m_wheelEvent && m_wheelEvent->IsRunning ());
+    }
   return !IsSuspended () && m_event.IsExpired ();
 }
 bool
 Timer::IsRunning (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_wheel != 0)
+    {
+      return !IsSuspended () && m_wheelEvent && m_wheelEvent->IsRunning ();
+    }
   return !IsSuspended () && m_event.IsRunning ();
 }
 bool
@@ -166,11 +201,25 @@ Timer::Schedule (Time delay)
 {
   NS_LOG_FUNCTION (this << delay);
   NS_ASSERT (m_impl != 0);
-  if (m_event.IsRunning ())
+  if (m_event.IsRunning () || (m_wheelEvent && m_wheelEvent->IsRunning ()))
     {
       NS_FATAL_ERROR ("Event is still running while re-scheduling.");
     }
-  m_event = m_impl->Schedule (delay);
+  DoSchedule (delay);
+}
+
+void
+Timer::DoSchedule (Time delay)
+{
+  NS_LOG_FUNCTION (this << delay);
+  if (m_wheel != 0)
+    {
+      m_wheelEvent = m_wheel->Schedule (delay, Ptr<EventImpl> (m_impl->MakeEvent (), false));
+    }
+  else
+    {
+      m_event = m_impl->Schedule (delay);
+    }
 }
 
 void
@@ -178,8 +227,8 @@ Timer::Suspend (void)
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (IsRunning ());
-  m_delayLeft = Simulator::GetDelayLeft (m_event);
-  Simulator::Remove (m_event);
+  m_delayLeft = GetDelayLeft ();
+  Remove ();
   m_flags |= TIMER_SUSPENDED;
 }
 
@@ -188,10 +237,15 @@ Timer::Resume (void)
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (m_flags & TIMER_SUSPENDED);
-  m_event = m_impl->Schedule (m_delayLeft);
+  DoSchedule (m_delayLeft);
   m_flags &= ~TIMER_SUSPENDED;
 }
 
+EventId
+TimerImpl::Schedule (const Time &delay)
+{
+  return Simulator::Schedule (delay, Ptr<EventImpl> (MakeEvent (), false));
+}
 
 } // namespace ns3
 
@@ -23,6 +23,7 @@
 #include "fatal-error.h"
 #include "nstime.h"
 #include "event-id.h"
+#include "timer-wheel.h"
 #include "int-to-type.h"
 
 /**
@@ -201,6 +202,16 @@ public:
    * \returns The currently-configured delay for the next Schedule.
    */
   Time GetDelay (void) const;
+  /**
+   * \param [in] wheel The timer wheel, or 0 to use simulator events.
+   *
+   * Expire this timer on the ticks of a TimerWheel instead of with a
+   * simulator event, so that cancelling or rescheduling it does not leave
+   * a cancelled event in the simulator.  The delay of the timer is then
+   * rounded up to the next tick of the wheel.  The wheel cannot be changed
+   * while the timer is running or suspended.
+   */
+  void SetTimerWheel (TimerWheel *wheel);
   /**
    * \returns The amount of time left until this timer expires.
    *
@@ -263,6 +274,13 @@ public:
   void Resume (void);
 
 private:
+  /**
+   * Schedule the expiration event, with a simulator event or in the wheel.
+   *
+   * \param [in] delay The delay to use.
+   */
+  void DoSchedule (Time delay);
+
   /** Internal bit marking the suspended state. */
   enum InternalSuspended
   {
@@ -283,6 +301,10 @@ private:
   Time m_delay;
   /** The future event scheduled to expire the timer. */
   EventId m_event;
+  /** The timer wheel, or 0 if the timer uses simulator events. */
+  TimerWheel *m_wheel;
+  /** The timer of the wheel scheduled to expire the timer. */
+  Ptr<TimerWheel::Event> m_wheelEvent;
   /**
    * The timer implementation, which contains the bound callback
    * function and arguments.
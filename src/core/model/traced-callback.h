@@ -93,6 +93,15 @@ public:
    * \param [in] path Context path which was used to connect the Callback.
    */
   void Disconnect (const CallbackBase & callback, std::string path);
+  /**
+   * Check if the chain of Callbacks is empty.
+   *
+   * This allows the caller to skip building the arguments of a trace
+   * which nobody listens to.
+   *
+   * \return \c true if no Callback is connected.
+   */
+  bool IsEmpty (void) const;
   /**
    * \name Functors taking various numbers of arguments.
    *
@@ -314,6 +323,15 @@ TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::Disconnect (const CallbackBase & callba
   Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> realCb = cb.Bind (path);
   DisconnectWithoutContext (realCb);
 }
+template<typename T1, typename T2, 
+         typename T3, typename T4,
+         typename T5, typename T6,
+         typename T7, typename T8>
+bool
+TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::IsEmpty (void) const
+{
+  return m_callbackList.empty ();
+}
 template<typename T1, typename T2, 
          typename T3, typename T4,
          typename T5, typename T6,
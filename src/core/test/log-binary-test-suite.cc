@@ -0,0 +1,228 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/nstime.h"
+#include "ns3/simulator.h"
+
+/**
+ * \file
+ * \ingroup logbinary-tests
+ * Binary logging backend test suite.
+ */
+
+/**
+ * \ingroup core-tests
+ * \defgroup logbinary-tests Binary logging tests
+ */
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("LogBinaryTestSuite");
+
+namespace {
+
+/** A type printed with its own operator<<. */
+struct Loggable
+{
+  uint32_t value;  //!< The value printed.
+};
+
+/**
+ * Print a Loggable.
+ * \param [in,out] os The output stream.
+ * \param [in] loggable The Loggable.
+ * \returns The output stream.
+ */
+std::ostream &
+operator<< (std::ostream & os, const Loggable & loggable)
+{
+  os << "{" << loggable.value << "}";
+  return os;
+}
+
+/** A type whose operator<< logs a message of its own. */
+struct NestedLoggable
+{
+};
+
+/**
+ * Print a NestedLoggable, logging a message while doing it.
+ * \param [in,out] os The output stream.
+ * \param [in] loggable The NestedLoggable.
+ * \returns The output stream.
+ */
+std::ostream &
+operator<< (std::ostream & os, const NestedLoggable & loggable)
+{
+  NS_LOG_INFO ("nested " << 2);
+  os << "nested";
+  return os;
+}
+
+/**
+ * Log messages with arguments of all the recorded types.
+ * \param [in] k A value changing the messages.
+ */
+void
+LogMessages (uint32_t k)
+{
+  NS_LOG_FUNCTION (k << "param" << std::string ("string") << 2.5);
+  NS_LOG_FUNCTION_NOARGS ();
+
+  int i = -3;
+  unsigned int u = 4;
+  int64_t l = -5;
+  uint64_t ul = 6;
+  int16_t s = -7;
+  double d = 0.1;
+  float f = 1.5;
+  bool b = true;
+  char c = 'x';
+  uint8_t byte = 65;
+  std::string str ("text");
+  const char *cstr = "cstring";
+  void *p = &i;
+  void *null = 0;
+  Loggable loggable = { k };
+
+  NS_LOG_INFO ("ints " << i << " " << u << " " << l << " " << ul << " " << s << " " << k);
+  NS_LOG_DEBUG ("reals " << d << " " << f << " bool " << b << " char " << c << " byte " << byte);
+  NS_LOG_LOGIC ("strings " << str << " " << cstr << " pointers " << p << " " << null);
+  NS_LOG_WARN ("object " << loggable << " then " << k);
+  NS_LOG_ERROR ("hex " << std::hex << 255 << " " << k << std::dec << " width " << std::setw (6) << k);
+  NS_LOG_INFO ("time " << Seconds (1.5) << " " << std::setprecision (3) << d / 3);
+  NS_LOG_FUNCTION (&loggable << str << loggable);
+}
+
+} // unnamed namespace
+
+
+/**
+ * \ingroup logbinary-tests
+ * Check that decoding the binary log gives the text log.
+ */
+class LogBinaryDecodeTestCase : public TestCase
+{
+public:
+  LogBinaryDecodeTestCase ();
+  virtual ~LogBinaryDecodeTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /** Log messages outside and inside a simulation. */
+  void Run (void);
+  /**
+   * Decode a binary log file.
+   * \param [in] file The file name.
+   * \returns The decoded messages.
+   */
+  std::string Decode (std::string file);
+};
+
+LogBinaryDecodeTestCase::LogBinaryDecodeTestCase ()
+  : TestCase ("Decode binary log messages")
+{
+}
+
+LogBinaryDecodeTestCase::~LogBinaryDecodeTestCase ()
+{
+}
+
+void
+LogBinaryDecodeTestCase::Run (void)
+{
+  LogMessages (1);
+  Simulator::ScheduleWithContext (7, Seconds (2.5), &LogMessages, 2);
+  Simulator::Schedule (Seconds (3), &LogMessages, 3);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+std::string
+LogBinaryDecodeTestCase::Decode (std::string file)
+{
+  std::ifstream is (file.c_str (), std::ios::in | std::ios::binary);
+  std::ostringstream decoded;
+  LogBinaryDecode (is, decoded);
+  return decoded.str ();
+}
+
+void
+LogBinaryDecodeTestCase::DoRun (void)
+{
+  LogComponentEnable ("LogBinaryTestSuite", LogLevel (LOG_LEVEL_ALL | LOG_PREFIX_ALL));
+
+  std::ostringstream text;
+  std::streambuf *clog = std::clog.rdbuf (text.rdbuf ());
+  Run ();
+  std::clog.rdbuf (clog);
+
+  std::string file = CreateTempDirFilename ("log-binary.nslog");
+  LogBinaryEnable (file);
+  NS_TEST_ASSERT_MSG_EQ (LogBinaryIsEnabled (), true, "Binary logging not enabled");
+  Run ();
+  LogBinaryDisable ();
+  NS_TEST_ASSERT_MSG_EQ (LogBinaryIsEnabled (), false, "Binary logging not disabled");
+  NS_TEST_ASSERT_MSG_EQ (Decode (file), text.str (), "Decoded binary log differs from the text log");
+
+  // Without prefixes, and with the call sites already registered.
+  LogComponentDisable ("LogBinaryTestSuite", LOG_PREFIX_ALL);
+  text.str ("");
+  clog = std::clog.rdbuf (text.rdbuf ());
+  Run ();
+  std::clog.rdbuf (clog);
+
+  LogBinaryEnable (file);
+  Run ();
+  LogBinaryDisable ();
+  NS_TEST_ASSERT_MSG_EQ (Decode (file), text.str (), "Decoded binary log differs from the text log");
+
+  // A message logged while formatting another is recorded first.
+  LogBinaryEnable (file);
+  NestedLoggable nested;
+  NS_LOG_INFO ("outer " << nested << " " << 1);
+  LogBinaryDisable ();
+  NS_TEST_ASSERT_MSG_EQ (Decode (file), "nested 2\nouter nested 1\n", "Nested binary log messages");
+
+  LogComponentDisable ("LogBinaryTestSuite", LOG_LEVEL_ALL);
+}
+
+
+/**
+ * \ingroup logbinary-tests
+ * Binary logging test suite.
+ */
+class LogBinaryTestSuite : public TestSuite
+{
+public:
+  LogBinaryTestSuite ();
+};
+
+LogBinaryTestSuite::LogBinaryTestSuite ()
+  : TestSuite ("log-binary", UNIT)
+{
+  AddTestCase (new LogBinaryDecodeTestCase, TestCase::QUICK);
+}
+
+/** Static variable for test initialization. */
+static LogBinaryTestSuite g_logBinaryTestSuite;
@@ -341,6 +341,17 @@ AggregateObjectTestCase::DoRun (void)
   //
   NS_TEST_ASSERT_MSG_NE (baseB->GetObject<BaseB> (), 0, "Cannot GetObject (through baseB) for BaseB Object");
 
+  //
+  // Lookups through the aggregate must return the exact Objects which
+  // implement the requested TypeId, whether asked by template or by TypeId,
+  // and whichever member of the aggregate we ask.
+  //
+  NS_TEST_ASSERT_MSG_EQ (baseB->GetObject<BaseA> (), baseA, "GetObject (through baseB) returned the wrong BaseA Object");
+  NS_TEST_ASSERT_MSG_EQ (baseA->GetObject<BaseB> (), baseB, "GetObject (through baseA) returned the wrong BaseB Object");
+  NS_TEST_ASSERT_MSG_EQ (baseB->GetObject<Object> (BaseA::GetTypeId ()), baseA, "GetObject (BaseA TypeId) returned the wrong Object");
+  NS_TEST_ASSERT_MSG_EQ (baseA->GetObject<Object> (DerivedB::GetTypeId ()), baseB, "GetObject (DerivedB TypeId) returned the wrong Object");
+  NS_TEST_ASSERT_MSG_EQ (baseA->GetObject<Object> (Object::GetTypeId ()), baseA, "GetObject (Object TypeId) did not return the first aggregate");
+
   //
   // Make sure reference counting works in the aggregate.  Create two Objects
   // and aggregate them, then release one of them.  The aggregation should
@@ -0,0 +1,265 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/profiling-simulator-impl.h"
+#include "ns3/object.h"
+#include "ns3/string.h"
+
+/**
+ * \file
+ * \ingroup profiling-tests
+ * ProfilingSimulatorImpl test suite.
+ */
+
+/**
+ * \ingroup core-tests
+ * \defgroup profiling-tests ProfilingSimulatorImpl tests
+ */
+
+using namespace ns3;
+
+/**
+ * \ingroup profiling-tests
+ * An object whose methods are profiled.
+ */
+class ProfilingTestBase : public Object
+{
+public:
+  /**
+   * Register this type.
+   * \return The object TypeId.
+   */
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ProfilingTestBase")
+      .SetParent<Object> ()
+      .HideFromDocumentation ()
+    ;
+    return tid;
+  }
+  /**
+   * Handle an event.
+   * \param [in] value A value.
+   */
+  virtual void Handle (uint32_t value);
+  /** Handle an event with a non-virtual method. */
+  void Count (void);
+};
+
+void
+ProfilingTestBase::Handle (uint32_t value)
+{
+}
+
+void
+ProfilingTestBase::Count (void)
+{
+}
+
+/**
+ * \ingroup profiling-tests
+ * A derived object, overriding the virtual method.
+ */
+class ProfilingTestDerived : public ProfilingTestBase
+{
+public:
+  /**
+   * Register this type.
+   * \return The object TypeId.
+   */
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ProfilingTestDerived")
+      .SetParent<ProfilingTestBase> ()
+      .HideFromDocumentation ()
+      .AddConstructor<ProfilingTestDerived> ()
+    ;
+    return tid;
+  }
+  virtual void Handle (uint32_t value);
+};
+
+void
+ProfilingTestDerived::Handle (uint32_t value)
+{
+}
+
+/**
+ * \ingroup profiling-tests
+ * A function handling an event.
+ */
+void
+ProfilingTestFunction (void)
+{
+}
+
+
+/**
+ * \ingroup profiling-tests
+ * Check the attribution of the events to their methods, types and
+ * contexts.
+ */
+class ProfilingSimulatorTestCase : public TestCase
+{
+public:
+  ProfilingSimulatorTestCase ();
+  virtual ~ProfilingSimulatorTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Find the entry of a function in a context.
+   * \param [in] entries The entries.
+   * \param [in] function The function name.
+   * \param [in] context The context.
+   * \returns The entry, or an entry without events.
+   */
+  ProfilingSimulatorImpl::Entry Find (const std::vector<ProfilingSimulatorImpl::Entry> &entries,
+                                      std::string function, uint32_t context);
+  /**
+   * Read a file.
+   * \param [in] file The file name.
+   * \returns The content of the file.
+   */
+  std::string Read (std::string file);
+};
+
+ProfilingSimulatorTestCase::ProfilingSimulatorTestCase ()
+  : TestCase ("Attribute the events to their methods, types and contexts")
+{
+}
+
+ProfilingSimulatorTestCase::~ProfilingSimulatorTestCase ()
+{
+}
+
+ProfilingSimulatorImpl::Entry
+ProfilingSimulatorTestCase::Find (const std::vector<ProfilingSimulatorImpl::Entry> &entries,
+                                  std::string function, uint32_t context)
+{
+  for (std::size_t i = 0; i < entries.size (); ++i)
+    {
+      if (entries[i].function == function && entries[i].context == context)
+        {
+          return entries[i];
+        }
+    }
+  ProfilingSimulatorImpl::Entry none;
+  none.events = 0;
+  none.nanoseconds = 0;
+  return none;
+}
+
+std::string
+ProfilingSimulatorTestCase::Read (std::string file)
+{
+  std::ifstream is (file.c_str ());
+  std::ostringstream oss;
+  oss << is.rdbuf ();
+  return oss.str ();
+}
+
+void
+ProfilingSimulatorTestCase::DoRun (void)
+{
+  std::string report = CreateTempDirFilename ("profile.txt");
+  std::string folded = CreateTempDirFilename ("profile.folded");
+  ObjectFactory factory;
+  factory.SetTypeId (ProfilingSimulatorImpl::GetTypeId ());
+  factory.Set ("ReportFile", StringValue (report));
+  factory.Set ("FlameGraphFile", StringValue (folded));
+  Ptr<ProfilingSimulatorImpl> profiler = factory.Create<ProfilingSimulatorImpl> ();
+  Simulator::SetImplementation (profiler);
+
+  Ptr<ProfilingTestDerived> derived = CreateObject<ProfilingTestDerived> ();
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      Simulator::ScheduleWithContext (5, Seconds (i), &ProfilingTestBase::Handle, derived, i);
+    }
+  Simulator::ScheduleWithContext (7, Seconds (1), &ProfilingTestBase::Count, derived);
+  Simulator::ScheduleWithContext (7, Seconds (1), &ProfilingTestFunction);
+  Simulator::ScheduleWithContext (8, Seconds (1), &ProfilingTestFunction);
+  EventId cancelled = Simulator::Schedule (Seconds (2), &ProfilingTestFunction);
+  Simulator::Cancel (cancelled);
+  Simulator::ScheduleDestroy (&ProfilingTestBase::Count, derived);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  std::vector<ProfilingSimulatorImpl::Entry> entries = profiler->GetEntries ();
+  for (std::size_t i = 1; i < entries.size (); ++i)
+    {
+      NS_TEST_EXPECT_MSG_GT_OR_EQ (entries[i - 1].nanoseconds, entries[i].nanoseconds,
+                                   "Entries not sorted by decreasing time");
+    }
+
+  ProfilingSimulatorImpl::Entry entry = Find (entries, "ProfilingTestDerived::Handle(unsigned int)", 5);
+  NS_TEST_EXPECT_MSG_EQ (entry.events, 3, "Virtual method not resolved in the derived class");
+  NS_TEST_EXPECT_MSG_EQ (entry.type, "ProfilingTestDerived", "Wrong type of the object called");
+  entry = Find (entries, "ProfilingTestBase::Count()", 7);
+  NS_TEST_EXPECT_MSG_EQ (entry.events, 1, "Non-virtual method not counted");
+  NS_TEST_EXPECT_MSG_EQ (entry.type, "ProfilingTestDerived", "Wrong type of the object called");
+  entry = Find (entries, "ProfilingTestBase::Count()", Simulator::NO_CONTEXT);
+  NS_TEST_EXPECT_MSG_EQ (entry.events, 1, "Destroy event not counted");
+  entry = Find (entries, "ProfilingTestFunction()", 7);
+  NS_TEST_EXPECT_MSG_EQ (entry.events, 1, "Function not counted in its context");
+  NS_TEST_EXPECT_MSG_EQ (entry.type, "", "Function with an object type");
+  entry = Find (entries, "ProfilingTestFunction()", 8);
+  NS_TEST_EXPECT_MSG_EQ (entry.events, 1, "Function not counted in its context");
+  entry = Find (entries, "ProfilingTestFunction()", Simulator::NO_CONTEXT);
+  NS_TEST_EXPECT_MSG_EQ (entry.events, 0, "Cancelled event counted");
+
+  std::string text = Read (report);
+  NS_TEST_EXPECT_MSG_EQ ((text.find ("Simulator profile: 7 events") != std::string::npos), true,
+                         "Wrong number of events in the report");
+  NS_TEST_EXPECT_MSG_EQ ((text.find ("  ProfilingTestDerived::Handle(unsigned int)\n") != std::string::npos), true,
+                         "Function missing from the report");
+  NS_TEST_EXPECT_MSG_EQ ((text.find ("  context 5\n") != std::string::npos), true,
+                         "Context missing from the report");
+
+  text = Read (folded);
+  NS_TEST_EXPECT_MSG_EQ ((text.find ("ProfilingTestDerived;ProfilingTestDerived::Handle(unsigned int);context 5 ")
+                          != std::string::npos), true,
+                         "Stack missing from the folded stacks");
+  NS_TEST_EXPECT_MSG_EQ ((text.find ("\nProfilingTestFunction();context 8 ") != std::string::npos), true,
+                         "Stack missing from the folded stacks");
+}
+
+
+/**
+ * \ingroup profiling-tests
+ * ProfilingSimulatorImpl test suite.
+ */
+class ProfilingSimulatorTestSuite : public TestSuite
+{
+public:
+  ProfilingSimulatorTestSuite ();
+};
+
+ProfilingSimulatorTestSuite::ProfilingSimulatorTestSuite ()
+  : TestSuite ("profiling-simulator", UNIT)
+{
+  AddTestCase (new ProfilingSimulatorTestCase, TestCase::QUICK);
+}
+
+/** Static variable for test initialization. */
+static ProfilingSimulatorTestSuite g_profilingSimulatorTestSuite;
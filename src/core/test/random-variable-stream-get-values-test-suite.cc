@@ -0,0 +1,136 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <string>
+#include <vector>
+
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/object-factory.h"
+#include "ns3/test.h"
+#include "ns3/random-variable-stream.h"
+
+using namespace ns3;
+
+// ===========================================================================
+// Test case for getting many values of a random variable at once
+// ===========================================================================
+class RandomVariableStreamGetValuesTestCase : public TestCase
+{
+public:
+  RandomVariableStreamGetValuesTestCase ();
+  virtual ~RandomVariableStreamGetValuesTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Check GetValues against GetValue of a second variable of the
+   * same type and attributes, on the same stream, for arrays of
+   * several sizes, and check that both streams end up in the same
+   * state.
+   *
+   * \param [in] factory The factory of the random variables.
+   * \param [in] name The type of the random variables, for the messages.
+   */
+  void CheckValues (ObjectFactory factory, std::string name);
+};
+
+RandomVariableStreamGetValuesTestCase::RandomVariableStreamGetValuesTestCase ()
+  : TestCase ("Random Variable Stream Generator GetValues")
+{
+}
+
+RandomVariableStreamGetValuesTestCase::~RandomVariableStreamGetValuesTestCase ()
+{
+}
+
+void
+RandomVariableStreamGetValuesTestCase::CheckValues (ObjectFactory factory, std::string name)
+{
+  Ptr<RandomVariableStream> x = factory.Create<RandomVariableStream> ();
+  Ptr<RandomVariableStream> y = factory.Create<RandomVariableStream> ();
+  x->SetStream (1);
+  y->SetStream (1);
+
+  // Odd sizes leave a saved normal value, and sizes above the
+  // normal block size make several draws from the stream.
+  uint64_t sizes[] = { 0, 1, 7, 2, 1000, 1, 513 };
+  for (uint32_t s = 0; s < sizeof (sizes) / sizeof (sizes[0]); ++s)
+    {
+      std::vector<double> values (sizes[s] + 1, -1.0);
+      x->GetValues (&values[0], sizes[s]);
+      for (uint64_t i = 0; i < sizes[s]; ++i)
+        {
+          NS_TEST_ASSERT_MSG_EQ (values[i], y->GetValue (), name << " GetValues differs from GetValue");
+        }
+      NS_TEST_ASSERT_MSG_EQ (values[sizes[s]], -1.0, name << " GetValues wrote past the end of the array");
+    }
+  NS_TEST_ASSERT_MSG_EQ (x->GetValue (), y->GetValue (), name << " GetValues left a different stream state");
+}
+
+void
+RandomVariableStreamGetValuesTestCase::DoRun (void)
+{
+  for (uint32_t antithetic = 0; antithetic < 2; ++antithetic)
+    {
+      ObjectFactory factory;
+      factory.SetTypeId ("ns3::UniformRandomVariable");
+      factory.Set ("Antithetic", BooleanValue (antithetic));
+      factory.Set ("Min", DoubleValue (-3.0));
+      factory.Set ("Max", DoubleValue (5.0));
+      CheckValues (factory, "Uniform");
+
+      factory = ObjectFactory ();
+      factory.SetTypeId ("ns3::ExponentialRandomVariable");
+      factory.Set ("Antithetic", BooleanValue (antithetic));
+      factory.Set ("Mean", DoubleValue (2.0));
+      CheckValues (factory, "Exponential");
+      // With a bound, some candidates are rejected.
+      factory.Set ("Bound", DoubleValue (3.0));
+      CheckValues (factory, "Bounded exponential");
+
+      factory = ObjectFactory ();
+      factory.SetTypeId ("ns3::NormalRandomVariable");
+      factory.Set ("Antithetic", BooleanValue (antithetic));
+      factory.Set ("Mean", DoubleValue (5.0));
+      factory.Set ("Variance", DoubleValue (2.0));
+      CheckValues (factory, "Normal");
+      // With a bound, one or both values of a pair are rejected.
+      factory.Set ("Bound", DoubleValue (1.0));
+      CheckValues (factory, "Bounded normal");
+
+      // The base class implementation.
+      factory = ObjectFactory ();
+      factory.SetTypeId ("ns3::GammaRandomVariable");
+      factory.Set ("Antithetic", BooleanValue (antithetic));
+      CheckValues (factory, "Gamma");
+    }
+}
+
+
+class RandomVariableStreamGetValuesTestSuite : public TestSuite
+{
+public:
+  RandomVariableStreamGetValuesTestSuite ();
+};
+
+RandomVariableStreamGetValuesTestSuite::RandomVariableStreamGetValuesTestSuite ()
+  : TestSuite ("random-variable-stream-get-values", UNIT)
+{
+  AddTestCase (new RandomVariableStreamGetValuesTestCase, TestCase::QUICK);
+}
+
+static RandomVariableStreamGetValuesTestSuite randomVariableStreamGetValuesTestSuite;
@@ -0,0 +1,218 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// The distributions are checked with GSL by random-variable-stream-test-suite.cc;
+// these tests check the exact values of the variables and need no GSL.
+
+#include <cmath>
+#include <vector>
+
+#include "ns3/double.h"
+#include "ns3/integer.h"
+#include "ns3/test.h"
+#include "ns3/random-variable-stream.h"
+
+using namespace ns3;
+
+// ===========================================================================
+// Test case for the inverse CDF table of the Zipf random variable
+// ===========================================================================
+class RandomVariableStreamZipfTableTestCase : public TestCase
+{
+public:
+  static const uint32_t N_MEASUREMENTS = 100000;
+
+  RandomVariableStreamZipfTableTestCase ();
+  virtual ~RandomVariableStreamZipfTableTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Check the Zipf values against a linear search of the distribution,
+   * with a uniform variable on the same stream.
+   *
+   * \param [in] x The Zipf random variable.
+   * \param [in] u The uniform random variable.
+   * \param [in] n The n value for the Zipf distribution.
+   * \param [in] alpha The alpha value for the Zipf distribution.
+   */
+  void CheckValues (Ptr<ZipfRandomVariable> x, Ptr<UniformRandomVariable> u,
+                    uint32_t n, double alpha);
+};
+
+RandomVariableStreamZipfTableTestCase::RandomVariableStreamZipfTableTestCase ()
+  : TestCase ("Zipf Random Variable Stream Generator inverse CDF table")
+{
+}
+
+RandomVariableStreamZipfTableTestCase::~RandomVariableStreamZipfTableTestCase ()
+{
+}
+
+void
+RandomVariableStreamZipfTableTestCase::CheckValues (Ptr<ZipfRandomVariable> x, Ptr<UniformRandomVariable> u,
+                                                    uint32_t n, double alpha)
+{
+  double c = 0.0;
+  for (uint32_t i = 1; i <= n; i++)
+    {
+      c += (1.0 / std::pow ((double)i, alpha));
+    }
+  c = 1.0 / c;
+
+  for (uint32_t k = 0; k < N_MEASUREMENTS; ++k)
+    {
+      double r = u->GetValue ();
+      double expected = 0;
+      double sum = 0;
+      for (uint32_t i = 1; i <= n; i++)
+        {
+          sum += c / std::pow ((double)i, alpha);
+          if (sum > r)
+            {
+              expected = i;
+              break;
+            }
+        }
+      NS_TEST_ASSERT_MSG_EQ (x->GetValue (), expected, "Zipf value differs from a linear search");
+    }
+}
+
+void
+RandomVariableStreamZipfTableTestCase::DoRun (void)
+{
+  // The same stream gives the same uniform values to both variables.
+  Ptr<ZipfRandomVariable> x = CreateObject<ZipfRandomVariable> ();
+  Ptr<UniformRandomVariable> u = CreateObject<UniformRandomVariable> ();
+  x->SetStream (1);
+  u->SetStream (1);
+
+  x->SetAttribute ("N", IntegerValue (1000));
+  x->SetAttribute ("Alpha", DoubleValue (1.2));
+  CheckValues (x, u, 1000, 1.2);
+
+  // The table is computed again when the attributes change.
+  x->SetAttribute ("N", IntegerValue (10));
+  CheckValues (x, u, 10, 1.2);
+  x->SetAttribute ("Alpha", DoubleValue (0.5));
+  CheckValues (x, u, 10, 0.5);
+}
+
+// ===========================================================================
+// Test case for the guide table of the empirical random variable
+// ===========================================================================
+class RandomVariableStreamEmpiricalTableTestCase : public TestCase
+{
+public:
+  static const uint32_t N_MEASUREMENTS = 100000;
+
+  RandomVariableStreamEmpiricalTableTestCase ();
+  virtual ~RandomVariableStreamEmpiricalTableTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Check the empirical values against a linear search of the CDF,
+   * with a uniform variable on the same stream.
+   *
+   * \param [in] x The empirical random variable.
+   * \param [in] u The uniform random variable.
+   * \param [in] values The values of the points of the CDF.
+   * \param [in] cdf The CDF at each point.
+   */
+  void CheckValues (Ptr<EmpiricalRandomVariable> x, Ptr<UniformRandomVariable> u,
+                    const std::vector<double> &values, const std::vector<double> &cdf);
+};
+
+RandomVariableStreamEmpiricalTableTestCase::RandomVariableStreamEmpiricalTableTestCase ()
+  : TestCase ("Empirical Random Variable Stream Generator guide table")
+{
+}
+
+RandomVariableStreamEmpiricalTableTestCase::~RandomVariableStreamEmpiricalTableTestCase ()
+{
+}
+
+void
+RandomVariableStreamEmpiricalTableTestCase::CheckValues (Ptr<EmpiricalRandomVariable> x, Ptr<UniformRandomVariable> u,
+                                                         const std::vector<double> &values, const std::vector<double> &cdf)
+{
+  for (uint32_t k = 0; k < N_MEASUREMENTS; ++k)
+    {
+      double r = u->GetValue ();
+      double expected;
+      if (r <= cdf.front ())
+        {
+          expected = values.front ();
+        }
+      else if (r >= cdf.back ())
+        {
+          expected = values.back ();
+        }
+      else
+        {
+          uint32_t c = 0;
+          while (cdf[c + 1] <= r)
+            {
+              c++;
+            }
+          expected = values[c] + ((values[c + 1] - values[c]) / (cdf[c + 1] - cdf[c])) * (r - cdf[c]);
+        }
+      NS_TEST_ASSERT_MSG_EQ (x->GetValue (), expected, "Empirical value differs from a linear search");
+    }
+}
+
+void
+RandomVariableStreamEmpiricalTableTestCase::DoRun (void)
+{
+  Ptr<EmpiricalRandomVariable> x = CreateObject<EmpiricalRandomVariable> ();
+  Ptr<UniformRandomVariable> u = CreateObject<UniformRandomVariable> ();
+  x->SetStream (1);
+  u->SetStream (1);
+
+  // Uneven steps, with flat parts of the CDF, ending below 1.
+  std::vector<double> values;
+  std::vector<double> cdf;
+  for (uint32_t i = 0; i < 100; ++i)
+    {
+      values.push_back (i * 10.0);
+      cdf.push_back (0.1 + 0.0007 * (i / 3) * (i / 3));
+      x->CDF (values.back (), cdf.back ());
+    }
+  CheckValues (x, u, values, cdf);
+
+  // The table is computed again when points are added.
+  values.push_back (2000.0);
+  cdf.push_back (1.0);
+  x->CDF (values.back (), cdf.back ());
+  CheckValues (x, u, values, cdf);
+}
+
+
+class RandomVariableStreamTablesTestSuite : public TestSuite
+{
+public:
+  RandomVariableStreamTablesTestSuite ();
+};
+
+RandomVariableStreamTablesTestSuite::RandomVariableStreamTablesTestSuite ()
+  : TestSuite ("random-variable-stream-tables", UNIT)
+{
+  AddTestCase (new RandomVariableStreamZipfTableTestCase, TestCase::QUICK);
+  AddTestCase (new RandomVariableStreamEmpiricalTableTestCase, TestCase::QUICK);
+}
+
+static RandomVariableStreamTablesTestSuite randomVariableStreamTablesTestSuite;
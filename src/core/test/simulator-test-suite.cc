@@ -23,6 +23,9 @@
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/default-simulator-impl.h"
+#include "ns3/uinteger.h"
+#include <vector>
 
 using namespace ns3;
 
@@ -168,6 +171,163 @@ SimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (m_destroy, true, "Event should have run");
 }
 
+class SimulatorCompactionTestCase : public TestCase
+{
+public:
+  SimulatorCompactionTestCase (ObjectFactory schedulerFactory);
+  virtual void DoRun (void);
+  void Event (uint32_t i);
+  std::vector<uint32_t> m_events;
+  ObjectFactory m_schedulerFactory;
+};
+
+SimulatorCompactionTestCase::SimulatorCompactionTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check that cancelled events are compacted with " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory)
+{
+}
+
+void
+SimulatorCompactionTestCase::Event (uint32_t i)
+{
+  m_events.push_back (i);
+}
+
+void
+SimulatorCompactionTestCase::DoRun (void)
+{
+  m_schedulerFactory.Set ("CompactionMinimum", UintegerValue (10));
+  Simulator::SetScheduler (m_schedulerFactory);
+  Ptr<DefaultSimulatorImpl> impl = DynamicCast<DefaultSimulatorImpl> (Simulator::GetImplementation ());
+  if (impl == 0)
+    {
+      // the statistics are only available with the default implementation
+      Simulator::Destroy ();
+      return;
+    }
+  Ptr<Scheduler> scheduler = impl->GetScheduler ();
+
+  std::vector<EventId> ids;
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      ids.push_back (Simulator::Schedule (MicroSeconds (100 - i), &SimulatorCompactionTestCase::Event, this, i));
+    }
+  // cancel the events but those whose number is a multiple of 3
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      if (i % 3 != 0)
+        {
+          Simulator::Cancel (ids[i]);
+        }
+      if (i == 74)
+        {
+          // the 50 events cancelled so far are no more than half of the events
+          NS_TEST_EXPECT_MSG_EQ (scheduler->GetCancelled (), 50, "Cancelled events not counted");
+          NS_TEST_EXPECT_MSG_EQ (scheduler->GetCompactions (), 0, "Event list compacted too early");
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (scheduler->GetCompactions (), 1, "Event list not compacted");
+  NS_TEST_EXPECT_MSG_EQ (scheduler->GetCompacted (), 51, "Wrong number of events compacted");
+  NS_TEST_EXPECT_MSG_EQ (scheduler->GetCancelled (), 15, "Cancelled events not counted");
+  NS_TEST_EXPECT_MSG_EQ (scheduler->GetN (), 49, "Wrong number of events in the event list");
+
+  // a cancelled event removed at the head of the event list is not counted anymore
+  Simulator::Stop (MicroSeconds (2));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (scheduler->GetCancelled (), 14, "Cancelled event not uncounted");
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (scheduler->GetCancelled (), 0, "Cancelled events not uncounted");
+  NS_TEST_ASSERT_MSG_EQ (m_events.size (), 34, "Wrong number of events run");
+  for (uint32_t i = 0; i < 34; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_events[i], 99 - 3 * i, "Events run out of order");
+    }
+  Simulator::Destroy ();
+}
+
+/**
+ * A scheduler which does not override Scheduler::GetN, like the
+ * schedulers written before the compaction of the event list.
+ */
+class UncountedListScheduler : public ListScheduler
+{
+public:
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::UncountedListScheduler")
+      .SetParent<ListScheduler> ()
+      .SetGroupName ("Core")
+      .AddConstructor<UncountedListScheduler> ()
+    ;
+    return tid;
+  }
+  virtual uint32_t GetN (void) const
+  {
+    return Scheduler::GetN ();
+  }
+};
+
+class SimulatorUncountedCompactionTestCase : public TestCase
+{
+public:
+  SimulatorUncountedCompactionTestCase ();
+  virtual void DoRun (void);
+  void Event (uint32_t i);
+  std::vector<uint32_t> m_events;
+};
+
+SimulatorUncountedCompactionTestCase::SimulatorUncountedCompactionTestCase ()
+  : TestCase ("Check that a scheduler without GetN is never compacted")
+{
+}
+
+void
+SimulatorUncountedCompactionTestCase::Event (uint32_t i)
+{
+  m_events.push_back (i);
+}
+
+void
+SimulatorUncountedCompactionTestCase::DoRun (void)
+{
+  ObjectFactory factory;
+  factory.SetTypeId (UncountedListScheduler::GetTypeId ());
+  factory.Set ("CompactionMinimum", UintegerValue (10));
+  Simulator::SetScheduler (factory);
+  Ptr<DefaultSimulatorImpl> impl = DynamicCast<DefaultSimulatorImpl> (Simulator::GetImplementation ());
+  if (impl == 0)
+    {
+      Simulator::Destroy ();
+      return;
+    }
+  Ptr<Scheduler> scheduler = impl->GetScheduler ();
+
+  std::vector<EventId> ids;
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      ids.push_back (Simulator::Schedule (MicroSeconds (100 - i), &SimulatorUncountedCompactionTestCase::Event, this, i));
+    }
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      if (i % 3 != 0)
+        {
+          Simulator::Cancel (ids[i]);
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (scheduler->GetCompactions (), 0, "Event list compacted");
+  NS_TEST_EXPECT_MSG_EQ (scheduler->GetCancelled (), 66, "Cancelled events not counted");
+
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (scheduler->GetCancelled (), 0, "Cancelled events not uncounted");
+  NS_TEST_ASSERT_MSG_EQ (m_events.size (), 34, "Wrong number of events run");
+  for (uint32_t i = 0; i < 34; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_events[i], 99 - 3 * i, "Events run out of order");
+    }
+  Simulator::Destroy ();
+}
+
 class SimulatorTemplateTestCase : public TestCase
 {
 public:
@@ -475,5 +635,14 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (ListScheduler::GetTypeId ());
+    AddTestCase (new SimulatorCompactionTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (MapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorCompactionTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (HeapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorCompactionTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (CalendarScheduler::GetTypeId ());
+    AddTestCase (new SimulatorCompactionTestCase (factory), TestCase::QUICK);
+    AddTestCase (new SimulatorUncountedCompactionTestCase (), TestCase::QUICK);
   }
 } g_simulatorTestSuite;
@@ -20,10 +20,13 @@
  * TimeStep support by Emmanuelle Laprise <emmanuelle.laprise@bluekazoo.ca>
  */
 
+#include <algorithm>
+#include <cmath>
 #include <iomanip>
 #include <iostream>
 #include <string>
 #include <sstream>
+#include <vector>
 
 #include "ns3/nstime.h"
 #include "ns3/int64x64.h"
@@ -230,6 +233,98 @@ TimeInputOutputTestCase::DoRun (void)
   std::cout << std::endl;
 }
     
+class TimeConversionTestCase : public TestCase
+{
+public:
+  TimeConversionTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+TimeConversionTestCase::TimeConversionTestCase ()
+  : TestCase ("Check the integer conversions against int64x64_t")
+{
+}
+
+void
+TimeConversionTestCase::DoRun (void)
+{
+  std::ostringstream resolution;
+  resolution << "resolution " << TimeStep (1).As (Time::GetResolution ());
+
+  // Values with bits down to 2^-64 and below, around integers and
+  // with fractions which aren't exact in binary.
+  std::vector<double> values;
+  const double specials[] = { 0.0, 1.0, 0.5, 0.3, 0.1, 1e-5, 1.5e-9, 1e-12,
+                              std::ldexp (1.0, -11), std::ldexp (1.0, -12),
+                              std::ldexp (1.0, -64), 1e-300, 123.456, 4.0e9 };
+  for (std::size_t i = 0; i < sizeof (specials) / sizeof (specials[0]); ++i)
+    {
+      values.push_back (specials[i]);
+      values.push_back (-specials[i]);
+      values.push_back (std::nextafter (specials[i], 0.0));
+      values.push_back (std::nextafter (specials[i], 1e10));
+    }
+  uint64_t state = 1;
+  for (int i = 0; i < 2000; ++i)
+    {
+      state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+      double mantissa = static_cast<double> (state >> 11) / (1ULL << 53);
+      int exponent = static_cast<int> ((state >> 3) % 80) - 60;
+      double value = std::ldexp (mantissa, exponent);
+      values.push_back ((state & 1) ? value : -value);
+    }
+
+  for (int u = Time::Y; u < Time::LAST; ++u)
+    {
+      Time::Unit unit = static_cast<Time::Unit> (u);
+      double steps = std::max<int64_t> (1, Time::FromInteger (1, unit).GetTimeStep ());
+      for (std::size_t i = 0; i < values.size (); ++i)
+        {
+          if (std::fabs (values[i]) * steps > 1e18)
+            {
+              continue;
+            }
+          NS_TEST_ASSERT_MSG_EQ (Time::FromDouble (values[i], unit).GetTimeStep (),
+                                 Time::From (int64x64_t (values[i]), unit).GetTimeStep (),
+                                 "FromDouble (" << values[i] << ", " << u << ") at " << resolution.str ());
+        }
+
+      const int64_t integers[] = { 0, 1, 999, 1000, 1001, 123456789, 999999999999LL,
+                                   1000000000000000000LL };
+      for (std::size_t i = 0; i < sizeof (integers) / sizeof (integers[0]); ++i)
+        {
+          for (int sign = -1; sign <= 1; sign += 2)
+            {
+              Time t = TimeStep (sign * integers[i]);
+              if (Time::FromInteger (1, unit).GetTimeStep () == 0
+                  && std::fabs (t.GetDouble ()) > 1e18 / Time (1).To (unit).GetDouble ())
+                {
+                  continue;
+                }
+              NS_TEST_ASSERT_MSG_EQ (t.ToDouble (unit), t.To (unit).GetDouble (),
+                                     "ToDouble (" << u << ") of " << t.GetTimeStep ()
+                                     << " at " << resolution.str ());
+            }
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (Time::Max ().ToDouble (Time::S), Time::Max ().To (Time::S).GetDouble (),
+                         "ToDouble of Time::Max at " << resolution.str ());
+  NS_TEST_ASSERT_MSG_EQ (Time::Min ().ToDouble (Time::S), Time::Min ().To (Time::S).GetDouble (),
+                         "ToDouble of Time::Min at " << resolution.str ());
+
+  NS_TEST_ASSERT_MSG_EQ (MicroSeconds (1500).GetMilliSeconds (), 1,
+                         "1500us in ms at " << resolution.str ());
+  NS_TEST_ASSERT_MSG_EQ (MicroSeconds (-1500).GetMilliSeconds (), -1,
+                         "-1500us in ms at " << resolution.str ());
+  NS_TEST_ASSERT_MSG_EQ (MilliSeconds (3).GetMicroSeconds (), 3000,
+                         "3ms in us at " << resolution.str ());
+  NS_TEST_ASSERT_MSG_EQ (NanoSeconds (3).GetPicoSeconds (), 3000,
+                         "3ns in ps at " << resolution.str ());
+  NS_TEST_ASSERT_MSG_EQ (PicoSeconds (3000).GetNanoSeconds (), 3,
+                         "3000ps in ns at " << resolution.str ());
+}
+
 static class TimeTestSuite : public TestSuite
 {
 public:
@@ -238,8 +333,11 @@ public:
   {
     AddTestCase (new TimeWithSignTestCase (), TestCase::QUICK);
     AddTestCase (new TimeInputOutputTestCase (), TestCase::QUICK);
+    AddTestCase (new TimeConversionTestCase (), TestCase::QUICK);
     // This should be last, since it changes the resolution
     AddTestCase (new TimeSimpleTestCase (), TestCase::QUICK);
+    // Again at the resolution set by TimeSimpleTestCase
+    AddTestCase (new TimeConversionTestCase (), TestCase::QUICK);
   }
 } g_timeTestSuite;
 
@@ -0,0 +1,214 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/timer-wheel.h"
+#include "ns3/timer.h"
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+#include <vector>
+
+using namespace ns3;
+
+class TimerWheelExpirationTestCase : public TestCase
+{
+public:
+  TimerWheelExpirationTestCase ();
+  virtual void DoRun (void);
+  void Expire (Time expected);
+  void ScheduleNow (Time expected);
+  TimerWheel *m_wheel;
+  uint32_t m_expired;
+};
+
+TimerWheelExpirationTestCase::TimerWheelExpirationTestCase ()
+  : TestCase ("Check that the timers expire on the next tick of each level")
+{
+}
+
+void
+TimerWheelExpirationTestCase::Expire (Time expected)
+{
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), expected, "The timer did not expire at the expected time");
+  m_expired++;
+}
+
+void
+TimerWheelExpirationTestCase::ScheduleNow (Time expected)
+{
+  m_wheel->Schedule (Seconds (0), &TimerWheelExpirationTestCase::Expire, this, expected);
+}
+
+void
+TimerWheelExpirationTestCase::DoRun (void)
+{
+  TimerWheel wheel (MilliSeconds (1));
+  m_wheel = &wheel;
+  m_expired = 0;
+  // level 0, rounded up to the next tick
+  wheel.Schedule (MicroSeconds (500), &TimerWheelExpirationTestCase::Expire, this, MilliSeconds (1));
+  wheel.Schedule (MilliSeconds (1), &TimerWheelExpirationTestCase::Expire, this, MilliSeconds (1));
+  // levels 1 to 3, and beyond the range of the wheel
+  Time delays[] = { MilliSeconds (100), Seconds (5), Seconds (100), Seconds (3600), Seconds (36000) };
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      wheel.Schedule (delays[i], &TimerWheelExpirationTestCase::Expire, this, delays[i]);
+      wheel.Schedule (delays[i] + MicroSeconds (1), &TimerWheelExpirationTestCase::Expire, this,
+                      delays[i] + MilliSeconds (1));
+    }
+  // timers scheduled while the wheel is idle, and by a timer expiring
+  Simulator::Schedule (Seconds (50000) + MicroSeconds (10), &TimerWheelExpirationTestCase::ScheduleNow, this,
+                       Seconds (50000) + MilliSeconds (1));
+  Simulator::Schedule (Seconds (50001), &TimerWheelExpirationTestCase::ScheduleNow, this, Seconds (50001));
+  wheel.Schedule (MilliSeconds (200), &TimerWheelExpirationTestCase::ScheduleNow, this, MilliSeconds (201));
+  NS_TEST_EXPECT_MSG_EQ (wheel.GetN (), 13, "The timers are not all in the wheel");
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_expired, 15, "The timers did not all expire");
+  NS_TEST_EXPECT_MSG_EQ (wheel.GetN (), 0, "The wheel is not empty");
+  Simulator::Destroy ();
+}
+
+class TimerWheelCancelTestCase : public TestCase
+{
+public:
+  TimerWheelCancelTestCase ();
+  virtual void DoRun (void);
+  void Expire (uint32_t i);
+  std::vector<uint32_t> m_expired;
+};
+
+TimerWheelCancelTestCase::TimerWheelCancelTestCase ()
+  : TestCase ("Check that cancelled timers do not expire")
+{
+}
+
+void
+TimerWheelCancelTestCase::Expire (uint32_t i)
+{
+  m_expired.push_back (i);
+}
+
+void
+TimerWheelCancelTestCase::DoRun (void)
+{
+  TimerWheel wheel (MilliSeconds (10));
+  std::vector<Ptr<TimerWheel::Event> > timers;
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      timers.push_back (wheel.Schedule (MilliSeconds (i * 37), &TimerWheelCancelTestCase::Expire, this, i));
+    }
+  for (uint32_t i = 0; i < 1000; i += 2)
+    {
+      timers[i]->Cancel ();
+      NS_TEST_EXPECT_MSG_EQ (timers[i]->IsRunning (), false, "The timer is still running");
+      NS_TEST_EXPECT_MSG_EQ (timers[i]->GetDelayLeft (), Seconds (0), "The timer has time left");
+    }
+  NS_TEST_EXPECT_MSG_EQ (wheel.GetN (), 500, "The timers have not been removed from the wheel");
+  NS_TEST_EXPECT_MSG_EQ (timers[1]->GetDelayLeft (), MilliSeconds (40), "The timer has not the expected time left");
+
+  // a timer rescheduled many times expires once
+  Ptr<TimerWheel::Event> timer;
+  for (uint32_t i = 0; i < 10000; i++)
+    {
+      if (timer)
+        {
+          timer->Cancel ();
+        }
+      timer = wheel.Schedule (Seconds (1000 + i), &TimerWheelCancelTestCase::Expire, this, 1000);
+    }
+  NS_TEST_EXPECT_MSG_EQ (wheel.GetN (), 501, "The timers have not been removed from the wheel");
+
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_expired.size (), 501, "The timers did not all expire");
+  for (uint32_t i = 0; i < 500; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_expired[i], 2 * i + 1, "The timers did not expire in order");
+    }
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), Seconds (10999), "The last timer did not expire at the expected time");
+  Simulator::Destroy ();
+}
+
+class TimerWheelTimerTestCase : public TestCase
+{
+public:
+  TimerWheelTimerTestCase ();
+  virtual void DoRun (void);
+  void Expire (int i);
+  void Reschedule (Timer *timer, Time delay);
+  std::vector<Time> m_expired;
+};
+
+TimerWheelTimerTestCase::TimerWheelTimerTestCase ()
+  : TestCase ("Check a Timer using a timer wheel")
+{
+}
+
+void
+TimerWheelTimerTestCase::Expire (int i)
+{
+  m_expired.push_back (Simulator::Now ());
+}
+
+void
+TimerWheelTimerTestCase::Reschedule (Timer *timer, Time delay)
+{
+  timer->Schedule (delay);
+}
+
+void
+TimerWheelTimerTestCase::DoRun (void)
+{
+  TimerWheel::GetDefault ()->SetResolution (MilliSeconds (10));
+  Timer timer = Timer (Timer::CANCEL_ON_DESTROY);
+  timer.SetTimerWheel (TimerWheel::GetDefault ());
+  timer.SetFunction (&TimerWheelTimerTestCase::Expire, this);
+  timer.SetArguments (1);
+  timer.SetDelay (MilliSeconds (25));
+  NS_TEST_ASSERT_MSG_EQ (timer.GetState (), Timer::EXPIRED, "");
+  timer.Schedule ();
+  NS_TEST_ASSERT_MSG_EQ (timer.GetState (), Timer::RUNNING, "");
+  NS_TEST_ASSERT_MSG_EQ (timer.GetDelayLeft (), MilliSeconds (30), "");
+  timer.Suspend ();
+  NS_TEST_ASSERT_MSG_EQ (timer.GetState (), Timer::SUSPENDED, "");
+  NS_TEST_ASSERT_MSG_EQ (TimerWheel::GetDefault ()->GetN (), 0, "");
+  timer.Resume ();
+  NS_TEST_ASSERT_MSG_EQ (timer.GetState (), Timer::RUNNING, "");
+  timer.Cancel ();
+  NS_TEST_ASSERT_MSG_EQ (timer.GetState (), Timer::EXPIRED, "");
+  NS_TEST_ASSERT_MSG_EQ (TimerWheel::GetDefault ()->GetN (), 0, "");
+
+  // the arguments are those of the call to Schedule
+  timer.Schedule ();
+  timer.SetArguments (2);
+  Simulator::Schedule (MilliSeconds (100), &TimerWheelTimerTestCase::Reschedule, this, &timer, MilliSeconds (5));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_expired.size (), 2, "");
+  NS_TEST_EXPECT_MSG_EQ (m_expired[0], MilliSeconds (30), "");
+  NS_TEST_EXPECT_MSG_EQ (m_expired[1], MilliSeconds (110), "");
+  NS_TEST_ASSERT_MSG_EQ (timer.GetState (), Timer::EXPIRED, "");
+  Simulator::Destroy ();
+}
+
+static class TimerWheelTestSuite : public TestSuite
+{
+public:
+  TimerWheelTestSuite ()
+    : TestSuite ("timer-wheel", UNIT)
+  {
+    AddTestCase (new TimerWheelExpirationTestCase (), TestCase::QUICK);
+    AddTestCase (new TimerWheelCancelTestCase (), TestCase::QUICK);
+    AddTestCase (new TimerWheelTimerTestCase (), TestCase::QUICK);
+  }
+} g_timerWheelTestSuite;
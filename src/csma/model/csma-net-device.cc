@@ -220,6 +220,7 @@ CsmaNetDevice::DoDispose ()
   m_node = 0;
   m_queue = 0;
   m_queueInterface = 0;
+  m_pendingFrames.clear ();
   NetDevice::DoDispose ();
 }
 
@@ -252,6 +253,9 @@ CsmaNetDevice::NotifyNewAggregate (void)
       if (ndqi != 0)
         {
           m_queueInterface = ndqi;
+          // packets larger than the MTU are split when dequeued, which
+          // the LLC encapsulation does not allow
+          m_queueInterface->SetSegmentationOffload (m_encapMode == DIX);
         }
     }
   NetDevice::NotifyNewAggregate ();
@@ -263,6 +267,10 @@ CsmaNetDevice::SetEncapsulationMode (enum EncapsulationMode mode)
   NS_LOG_FUNCTION (mode);
 
   m_encapMode = mode;
+  if (m_queueInterface != 0)
+    {
+      m_queueInterface->SetSegmentationOffload (m_encapMode == DIX);
+    }
 
   NS_LOG_LOGIC ("m_encapMode = " << m_encapMode);
   NS_LOG_LOGIC ("m_mtu = " << m_mtu);
@@ -595,13 +603,13 @@ CsmaNetDevice::TransmitAbort (void)
   // get that out.  If the queue is empty we just wait until someone puts one
   // in.
   //
-  if (m_queue->IsEmpty ())
+  if (m_pendingFrames.empty () && m_queue->IsEmpty ())
     {
       return;
     }
   else
     {
-      Ptr<Packet> packet = m_queue->Dequeue ();
+      Ptr<Packet> packet = DequeueFrame ();
       NS_ASSERT_MSG (packet != 0, "CsmaNetDevice::TransmitAbort(): IsEmpty false but no Packet on queue?");
       m_currentPkt = packet;
       m_snifferTrace (m_currentPkt);
@@ -664,13 +672,13 @@ CsmaNetDevice::TransmitReadyEvent (void)
   //
   // Get the next packet from the queue for transmitting
   //
-  if (m_queue->IsEmpty ())
+  if (m_pendingFrames.empty () && m_queue->IsEmpty ())
     {
       return;
     }
   else
     {
-      Ptr<Packet> packet = m_queue->Dequeue ();
+      Ptr<Packet> packet = DequeueFrame ();
       NS_ASSERT_MSG (packet != 0, "CsmaNetDevice::TransmitReadyEvent(): IsEmpty false but no Packet on queue?");
       m_currentPkt = packet;
       m_snifferTrace (m_currentPkt);
@@ -679,6 +687,49 @@ CsmaNetDevice::TransmitReadyEvent (void)
     }
 }
 
+Ptr<Packet>
+CsmaNetDevice::DequeueFrame (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  if (!m_pendingFrames.empty ())
+    {
+      Ptr<Packet> frame = m_pendingFrames.front ();
+      m_pendingFrames.pop_front ();
+      return frame;
+    }
+
+  Ptr<Packet> p = m_queue->Dequeue ();
+  EthernetHeader header (false);
+  EthernetTrailer trailer;
+  if (p == 0 || m_queueInterface == 0 || m_encapMode != DIX
+      || p->GetSize () <= GetMtu () + header.GetSerializedSize () + trailer.GetSerializedSize ())
+    {
+      return p;
+    }
+
+  //
+  // Split a packet larger than the MTU, e.g., a TCP super-segment.  The
+  // packet is copied since trace sinks may hold the dequeued one.
+  //
+  Ptr<Packet> packet = p->Copy ();
+  packet->RemoveTrailer (trailer);
+  packet->RemoveHeader (header);
+  m_pendingFrames = m_queueInterface->Segment (header.GetLengthType (), packet);
+  if (m_pendingFrames.empty ())
+    {
+      return p;
+    }
+  NS_LOG_LOGIC ("Split a packet of size " << p->GetSize () << " into " << m_pendingFrames.size () << " frames");
+  for (std::list<Ptr<Packet> >::iterator it = m_pendingFrames.begin (); it != m_pendingFrames.end (); it++)
+    {
+      AddHeader (*it, header.GetSource (), header.GetDestination (), header.GetLengthType ());
+    }
+  Ptr<Packet> frame = m_pendingFrames.front ();
+  m_pendingFrames.pop_front ();
+  return frame;
+}
+
 bool
 CsmaNetDevice::Attach (Ptr<CsmaChannel> ch)
 {
@@ -1022,7 +1073,7 @@ CsmaNetDevice::SendFrom (Ptr<Packet> packet, const Address& src, const Address&
     {
       if (m_queue->IsEmpty () == false)
         {
-          Ptr<Packet> packet = m_queue->Dequeue ();
+          Ptr<Packet> packet = DequeueFrame ();
           NS_ASSERT_MSG (packet != 0, "CsmaNetDevice::SendFrom(): IsEmpty false but no Packet on queue?");
           m_currentPkt = packet;
           m_promiscSnifferTrace (m_currentPkt);
@@ -22,6 +22,7 @@
 #define CSMA_NET_DEVICE_H
 
 #include <cstring>
+#include <list>
 #include "ns3/node.h"
 #include "ns3/backoff.h"
 #include "ns3/address.h"
@@ -437,6 +438,18 @@ private:
    */
   void TransmitReadyEvent (void);
 
+  /**
+   * \brief Get the next frame to transmit.
+   *
+   * Frames left over from the split of a packet larger than the MTU come
+   * first. Otherwise, a packet is dequeued and, if larger than the MTU,
+   * split into frames by the network protocol through the
+   * NetDeviceQueueInterface (DIX encapsulation only).
+   *
+   * \returns the next frame, or 0 if there is nothing to transmit
+   */
+  Ptr<Packet> DequeueFrame (void);
+
   /**
    * Aborts the transmission of the current packet
    *
@@ -520,6 +533,12 @@ private:
    */
   Ptr<Packet> m_currentPkt;
 
+  /**
+   * Frames left over from the split of a packet larger than the MTU,
+   * transmitted before the next packet in the queue.
+   */
+  std::list<Ptr<Packet> > m_pendingFrames;
+
   /**
    * The CsmaChannel to which this CsmaNetDevice has been
    * attached.
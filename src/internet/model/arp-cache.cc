@@ -197,40 +197,40 @@ ArpCache::HandleWaitReplyTimeout (void)
   NS_LOG_FUNCTION (this);
   ArpCache::Entry* entry;
   bool restartWaitReplyTimer = false;
-  for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++) 
+  // only the entries in WAIT_REPLY state are visited; an entry leaves
+  // the list when it is marked dead, so the iterator is advanced first
+  std::list<ArpCache::Entry *>::iterator i = m_waitReplyEntries.begin ();
+  while (i != m_waitReplyEntries.end ())
     {
-      entry = (*i).second;
-      if (entry != 0 && entry->IsWaitReply ())
+      entry = *i++;
+      NS_ASSERT (entry->IsWaitReply ());
+      if (entry->GetRetries () < m_maxRetries)
         {
-          if (entry->GetRetries () < m_maxRetries)
-            {
-              NS_LOG_LOGIC ("node="<< m_device->GetNode ()->GetId () <<
-                            ", ArpWaitTimeout for " << entry->GetIpv4Address () <<
-                            " expired -- retransmitting arp request since retries = " <<
-                            entry->GetRetries ());
-              m_arpRequestCallback (this, entry->GetIpv4Address ());
-              restartWaitReplyTimer = true;
-              entry->IncrementRetries ();
-            }
-          else
+          NS_LOG_LOGIC ("node="<< m_device->GetNode ()->GetId () <<
+                        ", ArpWaitTimeout for " << entry->GetIpv4Address () <<
+                        " expired -- retransmitting arp request since retries = " <<
+                        entry->GetRetries ());
+          m_arpRequestCallback (this, entry->GetIpv4Address ());
+          restartWaitReplyTimer = true;
+          entry->IncrementRetries ();
+        }
+      else
+        {
+          NS_LOG_LOGIC ("node="<<m_device->GetNode ()->GetId () <<
+                        ", wait reply for " << entry->GetIpv4Address () <<
+                        " expired -- drop since max retries exceeded: " <<
+                        entry->GetRetries ());
+          entry->MarkDead ();
+          entry->ClearRetries ();
+          Ipv4PayloadHeaderPair pending = entry->DequeuePending ();
+          while (pending.first != 0)
             {
-              NS_LOG_LOGIC ("node="<<m_device->GetNode ()->GetId () <<
-                            ", wait reply for " << entry->GetIpv4Address () <<
-                            " expired -- drop since max retries exceeded: " <<
-                            entry->GetRetries ());
-              entry->MarkDead ();
-              entry->ClearRetries ();
-              Ipv4PayloadHeaderPair pending = entry->DequeuePending ();
-              while (pending.first != 0)
-                {
-                  // add the Ipv4 header for tracing purposes
-                  pending.first->AddHeader (pending.second);
-                  m_dropTrace (pending.first);
-                  pending = entry->DequeuePending ();
-                }
+              // add the Ipv4 header for tracing purposes
+              pending.first->AddHeader (pending.second);
+              m_dropTrace (pending.first);
+              pending = entry->DequeuePending ();
             }
         }
-
     }
   if (restartWaitReplyTimer)
     {
@@ -249,6 +249,7 @@ ArpCache::Flush (void)
       delete (*i).second;
     }
   m_arpCache.erase (m_arpCache.begin (), m_arpCache.end ());
+  NS_ASSERT (m_macIndex.empty () && m_waitReplyEntries.empty ());
   if (m_waitReplyTimer.IsRunning ())
     {
       NS_LOG_LOGIC ("Stopping WaitReplyTimer at " << Simulator::Now ().GetSeconds () << " due to ArpCache flush");
@@ -302,9 +303,10 @@ ArpCache::LookupInverse (Address to)
   NS_LOG_FUNCTION (this << to);
 
   std::list<ArpCache::Entry *> entryList;
-  for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++)
+  std::pair<MacIndexI, MacIndexI> range = m_macIndex.equal_range (AddressHash () (to));
+  for (MacIndexI i = range.first; i != range.second; i++)
     {
-      ArpCache::Entry *entry = (*i).second;
+      ArpCache::Entry *entry = i->second;
       if (entry->GetMacAddress () == to)
         {
           entryList.push_back (entry);
@@ -342,7 +344,16 @@ void
 ArpCache::Remove (ArpCache::Entry *entry)
 {
   NS_LOG_FUNCTION (this << entry);
-  
+
+  CacheI it = m_arpCache.find (entry->GetIpv4Address ());
+  if (it != m_arpCache.end () && it->second == entry)
+    {
+      m_arpCache.erase (it);
+      entry->ClearPendingPacket (); //clear the pending packets for entry's ipaddress
+      delete entry;
+      return;
+    }
+  // the address of the entry may have been changed after it was added
   for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++)
     {
       if ((*i).second == entry)
@@ -362,6 +373,17 @@ ArpCache::Entry::Entry (ArpCache *arp)
     m_retries (0)
 {
   NS_LOG_FUNCTION (this << arp);
+  m_macIndexIt = m_arp->m_macIndex.insert (std::make_pair (AddressHash () (m_macAddress), this));
+}
+
+ArpCache::Entry::~Entry ()
+{
+  NS_LOG_FUNCTION (this);
+  m_arp->m_macIndex.erase (m_macIndexIt);
+  if (m_state == WAIT_REPLY)
+    {
+      m_arp->m_waitReplyEntries.erase (m_waitReplyIt);
+    }
 }
 
 
@@ -396,7 +418,7 @@ ArpCache::Entry::MarkDead (void)
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (m_state == ALIVE || m_state == WAIT_REPLY || m_state == DEAD);
-  m_state = DEAD;
+  SetState (DEAD);
   ClearRetries ();
   UpdateSeen ();
 }
@@ -405,8 +427,8 @@ ArpCache::Entry::MarkAlive (Address macAddress)
 {
   NS_LOG_FUNCTION (this << macAddress);
   NS_ASSERT (m_state == WAIT_REPLY);
-  m_macAddress = macAddress;
-  m_state = ALIVE;
+  IndexMacAddress (macAddress);
+  SetState (ALIVE);
   ClearRetries ();
   UpdateSeen ();
 }
@@ -416,7 +438,7 @@ ArpCache::Entry::MarkPermanent (void)
   NS_LOG_FUNCTION (this << m_macAddress);
   NS_ASSERT (!m_macAddress.IsInvalid ());
 
-  m_state = PERMANENT;
+  SetState (PERMANENT);
   ClearRetries ();
   UpdateSeen ();
 }
@@ -444,7 +466,7 @@ ArpCache::Entry::MarkWaitReply (Ipv4PayloadHeaderPair waiting)
   NS_ASSERT (m_pending.empty ());
   NS_ASSERT_MSG (waiting.first, "Can not add a null packet to the ARP queue");
 
-  m_state = WAIT_REPLY;
+  SetState (WAIT_REPLY);
   m_pending.push_back (waiting);
   UpdateSeen ();
   m_arp->StartWaitReplyTimer ();
@@ -460,13 +482,13 @@ void
 ArpCache::Entry::SetMacAddresss (Address macAddress)
 {
   NS_LOG_FUNCTION (this);
-  m_macAddress = macAddress;
+  IndexMacAddress (macAddress);
 }
 void 
 ArpCache::Entry::SetMacAddress (Address macAddress)
 {
   NS_LOG_FUNCTION (this);
-  m_macAddress = macAddress;
+  IndexMacAddress (macAddress);
 }
 Ipv4Address 
 ArpCache::Entry::GetIpv4Address (void) const
@@ -480,6 +502,32 @@ ArpCache::Entry::SetIpv4Address (Ipv4Address destination)
   NS_LOG_FUNCTION (this << destination);
   m_ipv4Address = destination;
 }
+void
+ArpCache::Entry::SetState (ArpCacheEntryState_e state)
+{
+  NS_LOG_FUNCTION (this << state);
+  if (m_state == WAIT_REPLY && state != WAIT_REPLY)
+    {
+      m_arp->m_waitReplyEntries.erase (m_waitReplyIt);
+    }
+  else if (m_state != WAIT_REPLY && state == WAIT_REPLY)
+    {
+      m_waitReplyIt = m_arp->m_waitReplyEntries.insert (m_arp->m_waitReplyEntries.end (), this);
+    }
+  m_state = state;
+}
+void
+ArpCache::Entry::IndexMacAddress (Address macAddress)
+{
+  NS_LOG_FUNCTION (this << macAddress);
+  size_t hash = AddressHash () (macAddress);
+  if (hash != m_macIndexIt->first)
+    {
+      m_arp->m_macIndex.erase (m_macIndexIt);
+      m_macIndexIt = m_arp->m_macIndex.insert (std::make_pair (hash, this));
+    }
+  m_macAddress = macAddress;
+}
 Time
 ArpCache::Entry::GetTimeout (void) const
 {
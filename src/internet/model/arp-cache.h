@@ -22,6 +22,7 @@
 
 #include <stdint.h>
 #include <list>
+#include <map>
 #include "ns3/simulator.h"
 #include "ns3/callback.h"
 #include "ns3/packet.h"
@@ -138,6 +139,9 @@ public:
    * This method will schedule a timeout at WaitReplyTimeout interval
    * in the future, unless a timer is already running for the cache,
    * in which case this method does nothing.
+   *
+   * All the entries in WAIT_REPLY state share this timer, and are
+   * processed in a single event when it expires.
    */
   void StartWaitReplyTimer (void);
   /**
@@ -149,6 +153,10 @@ public:
   ArpCache::Entry *Lookup (Ipv4Address destination);
   /**
    * \brief Do lookup in the ARP cache against a MAC address
+   *
+   * The entries are indexed by MAC address, so that the cost of the lookup
+   * does not depend on the size of the cache.
+   *
    * \param destination The destination MAC address to lookup
    * of
    * \return A std::list of ArpCache::Entry with info about layer 2
@@ -192,6 +200,7 @@ public:
      * \param arp The ArpCache this entry belongs to
      */
     Entry (ArpCache *arp);
+    ~Entry ();
 
     /**
      * \brief Changes the state of this entry to dead
@@ -305,6 +314,18 @@ private:
      * \returns the entry timeout
      */
     Time GetTimeout (void) const;
+    /**
+     * \brief Change the state of the entry, and keep the list of the
+     * entries in WAIT_REPLY state of the cache up to date
+     * \param state the new state
+     */
+    void SetState (ArpCacheEntryState_e state);
+    /**
+     * \brief Change the MAC address of the entry, and keep the MAC address
+     * index of the cache up to date
+     * \param macAddress the new MAC address
+     */
+    void IndexMacAddress (Address macAddress);
 
     ArpCache *m_arp; //!< pointer to the ARP cache owning the entry
     ArpCacheEntryState_e m_state; //!< state of the entry
@@ -313,6 +334,8 @@ private:
     Ipv4Address m_ipv4Address; //!< entry's IP address
     std::list<Ipv4PayloadHeaderPair> m_pending; //!< list of pending packets for the entry's IP
     uint32_t m_retries; //!< rerty counter
+    std::multimap<size_t, ArpCache::Entry *>::iterator m_macIndexIt; //!< entry's position in the MAC address index
+    std::list<ArpCache::Entry *>::iterator m_waitReplyIt; //!< entry's position in the WAIT_REPLY list, if in WAIT_REPLY state
   };
 
 private:
@@ -324,6 +347,14 @@ private:
    * \brief ARP Cache container iterator
    */
   typedef sgi::hash_map<Ipv4Address, ArpCache::Entry *, Ipv4AddressHash>::iterator CacheI;
+  /**
+   * \brief Index of the entries by hash of their MAC address
+   */
+  typedef std::multimap<size_t, ArpCache::Entry *> MacIndex;
+  /**
+   * \brief Index of the entries by hash of their MAC address iterator
+   */
+  typedef std::multimap<size_t, ArpCache::Entry *>::iterator MacIndexI;
 
   virtual void DoDispose (void);
 
@@ -344,6 +375,8 @@ private:
   void HandleWaitReplyTimeout (void);
   uint32_t m_pendingQueueSize; //!< number of packets waiting for a resolution
   Cache m_arpCache; //!< the ARP cache
+  MacIndex m_macIndex; //!< the entries, indexed by MAC address
+  std::list<ArpCache::Entry *> m_waitReplyEntries; //!< the entries in WAIT_REPLY state, in the order they entered it
   TracedCallback<Ptr<const Packet> > m_dropTrace; //!< trace for packets dropped by the ARP cache queue
 };
 
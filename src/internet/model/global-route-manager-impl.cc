@@ -711,9 +711,8 @@ GlobalRouteManagerImpl::InitializeRoutes ()
       Ptr<GlobalRouter> rtr = 
         node->GetObject<GlobalRouter> ();
 
-      uint32_t systemId = MpiInterface::GetSystemId ();
-      // Ignore nodes that are not assigned to our systemId (distributed sim)
-      if (node->GetSystemId () != systemId) 
+      // Ignore nodes that are not simulated by this process (distributed sim)
+      if (!MpiInterface::IsLocal (node->GetSystemId ()))
         {
           continue;
         }
@@ -18,6 +18,8 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 
+#include <algorithm>
+#include <vector>
 #include "ipv4-end-point-demux.h"
 #include "ipv4-end-point.h"
 #include "ipv4-interface-address.h"
@@ -28,8 +30,43 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Ipv4EndPointDemux");
 
+bool
+Ipv4EndPointDemux::ConnectionKey::operator== (const ConnectionKey &other) const
+{
+  return m_localPort == other.m_localPort && m_peerPort == other.m_peerPort
+         && m_localAddress == other.m_localAddress && m_peerAddress == other.m_peerAddress;
+}
+
+size_t
+Ipv4EndPointDemux::ConnectionKeyHash::operator() (const ConnectionKey &key) const
+{
+  uint32_t h = key.m_peerAddress.Get () * 2654435761U;
+  h ^= ((static_cast<uint32_t> (key.m_peerPort) << 16) | key.m_localPort) * 2246822519U;
+  h ^= key.m_localAddress.Get () * 3266489917U;
+  return h ^ (h >> 15);
+}
+
+bool
+Ipv4EndPointDemux::ListenerKey::operator== (const ListenerKey &other) const
+{
+  return m_localPort == other.m_localPort && m_localAddress == other.m_localAddress;
+}
+
+size_t
+Ipv4EndPointDemux::ListenerKeyHash::operator() (const ListenerKey &key) const
+{
+  uint32_t h = key.m_localAddress.Get () * 2654435761U;
+  return h ^ key.m_localPort;
+}
+
+bool
+Ipv4EndPointDemux::AllocatedBefore (Ipv4EndPoint *a, Ipv4EndPoint *b)
+{
+  return a->m_order < b->m_order;
+}
+
 Ipv4EndPointDemux::Ipv4EndPointDemux ()
-  : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152)
+  : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152), m_nextOrder (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -37,36 +74,41 @@ Ipv4EndPointDemux::Ipv4EndPointDemux ()
 Ipv4EndPointDemux::~Ipv4EndPointDemux ()
 {
   NS_LOG_FUNCTION (this);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  for (OrderedEndPoints::iterator i = m_endPoints.begin (); i != m_endPoints.end (); i++)
     {
-      Ipv4EndPoint *endPoint = *i;
+      Ipv4EndPoint *endPoint = i->second;
+      endPoint->m_demux = 0;
       delete endPoint;
     }
   m_endPoints.clear ();
+  m_ports.clear ();
+  m_connections.clear ();
+  m_listeners.clear ();
 }
 
 bool
 Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
 {
   NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
-    {
-      if ((*i)->GetLocalPort  () == port) 
-        {
-          return true;
-        }
-    }
-  return false;
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool
 Ipv4EndPointDemux::LookupLocal (Ipv4Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  if (Find (addr, port, Ipv4Address::GetAny (), 0) != 0)
     {
-      if ((*i)->GetLocalPort () == port &&
-          (*i)->GetLocalAddress () == addr) 
+      return true;
+    }
+  std::map<uint16_t, OrderedEndPoints>::iterator it = m_ports.find (port);
+  if (it == m_ports.end ())
+    {
+      return false;
+    }
+  for (OrderedEndPoints::iterator i = it->second.begin (); i != it->second.end (); i++)
+    {
+      if (i->second->GetLocalAddress () == addr)
         {
           return true;
         }
@@ -85,7 +127,7 @@ Ipv4EndPointDemux::Allocate (void)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (Ipv4Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -101,7 +143,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -124,7 +166,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address, uint16_t port)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -134,21 +176,15 @@ Ipv4EndPointDemux::Allocate (Ipv4Address localAddress, uint16_t localPort,
                              Ipv4Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  if (Find (localAddress, localPort, peerAddress, peerPort) != 0)
     {
-      if ((*i)->GetLocalPort () == localPort &&
-          (*i)->GetLocalAddress () == localAddress &&
-          (*i)->GetPeerPort () == peerPort &&
-          (*i)->GetPeerAddress () == peerAddress) 
-        {
-          NS_LOG_WARN ("No way we can allocate this end-point.");
-          /* no way we can allocate this end-point. */
-          return 0;
-        }
+      NS_LOG_WARN ("No way we can allocate this end-point.");
+      /* no way we can allocate this end-point. */
+      return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
 
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
 
@@ -159,15 +195,21 @@ void
 Ipv4EndPointDemux::DeAllocate (Ipv4EndPoint *endPoint)
 {
   NS_LOG_FUNCTION (this << endPoint);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  if (endPoint->m_demux != this)
     {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
+      return;
     }
+  RemoveFromIndex (endPoint);
+  std::map<uint16_t, OrderedEndPoints>::iterator it = m_ports.find (endPoint->GetLocalPort ());
+  NS_ASSERT (it != m_ports.end ());
+  it->second.erase (endPoint->m_order);
+  if (it->second.empty ())
+    {
+      m_ports.erase (it);
+    }
+  m_endPoints.erase (endPoint->m_order);
+  endPoint->m_demux = 0;
+  delete endPoint;
 }
 
 /*
@@ -179,9 +221,9 @@ Ipv4EndPointDemux::GetAllEndPoints (void)
   NS_LOG_FUNCTION (this);
   EndPoints ret;
 
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  for (OrderedEndPoints::iterator i = m_endPoints.begin (); i != m_endPoints.end (); i++)
     {
-      Ipv4EndPoint* endP = *i;
+      Ipv4EndPoint* endP = i->second;
       ret.push_back (endP);
     }
   return ret;
@@ -205,8 +247,63 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
   EndPoints retval3; // Matches all but local address
   EndPoints retval4; // Exact match on all 4
 
+  bool subnetDirected = false;
+  Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
+  if (incomingInterface != 0)
+    {
+      for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
+        {
+          Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
+          if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
+              daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
+            {
+              subnetDirected = true;
+              incomingInterfaceAddr = addr.GetLocal ();
+            }
+        }
+    }
+  bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
+  NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
+
+  // Collect the endpoints whose local address is either the destination
+  // address, the address of the incoming interface or the wildcard, and
+  // whose peer is either the source or a (partial) wildcard.
+  Ipv4Address localAddresses[3] = { daddr, incomingInterfaceAddr, Ipv4Address::GetAny () };
+  Ipv4Address peerAddresses[2] = { saddr, Ipv4Address::GetAny () };
+  uint16_t peerPorts[2] = { sport, 0 };
+  std::vector<Ipv4EndPoint *> candidates;
+  for (uint32_t l = 0; l < 3; l++)
+    {
+      if ((l > 0 && localAddresses[l] == localAddresses[0])
+          || (l > 1 && localAddresses[l] == localAddresses[1]))
+        {
+          continue;
+        }
+      for (uint32_t a = 0; a < 2; a++)
+        {
+          if (a > 0 && peerAddresses[a] == peerAddresses[0])
+            {
+              continue;
+            }
+          for (uint32_t p = 0; p < 2; p++)
+            {
+              if (p > 0 && peerPorts[p] == peerPorts[0])
+                {
+                  continue;
+                }
+              EndPoints *found = Find (localAddresses[l], dport, peerAddresses[a], peerPorts[p]);
+              if (found != 0)
+                {
+                  candidates.insert (candidates.end (), found->begin (), found->end ());
+                }
+            }
+        }
+    }
+  // Report the matches in allocation order
+  std::sort (candidates.begin (), candidates.end (), AllocatedBefore);
+
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  for (std::vector<Ipv4EndPoint *>::iterator i = candidates.begin (); i != candidates.end (); i++) 
     {
       Ipv4EndPoint* endP = *i;
 
@@ -222,14 +319,7 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
           continue;
         }
 
-      if (endP->GetLocalPort () != dport) 
-        {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                             << " because endpoint dport "
-                                             << endP->GetLocalPort ()
-                                             << " does not match packet dport " << dport);
-          continue;
-        }
+      NS_ASSERT (endP->GetLocalPort () == dport);
       if (endP->GetBoundNetDevice ())
         {
           if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
@@ -241,20 +331,6 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
               continue;
             }
         }
-      bool subnetDirected = false;
-      Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
-      for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
-        {
-          Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
-          if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
-              daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
-            {
-              subnetDirected = true;
-              incomingInterfaceAddr = addr.GetLocal ();
-            }
-        }
-      bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
-      NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
       bool localAddressMatchesWildCard = 
         endP->GetLocalAddress () == Ipv4Address::GetAny ();
       bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
@@ -326,35 +402,36 @@ Ipv4EndPointDemux::SimpleLookup (Ipv4Address daddr,
 {
   NS_LOG_FUNCTION (this << daddr << dport << saddr << sport);
 
+  EndPoints *exact = Find (daddr, dport, saddr, sport);
+  if (exact != 0)
+    {
+      /* this is an exact match. */
+      return exact->front ();
+    }
+
   // this code is a copy/paste version of an old BSD ip stack lookup
   // function.
+  std::map<uint16_t, OrderedEndPoints>::iterator it = m_ports.find (dport);
+  if (it == m_ports.end ())
+    {
+      return 0;
+    }
   uint32_t genericity = 3;
   Ipv4EndPoint *generic = 0;
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  for (OrderedEndPoints::iterator i = it->second.begin (); i != it->second.end (); i++) 
     {
-      if ((*i)->GetLocalPort () != dport) 
-        {
-          continue;
-        }
-      if ((*i)->GetLocalAddress () == daddr &&
-          (*i)->GetPeerPort () == sport &&
-          (*i)->GetPeerAddress () == saddr) 
-        {
-          /* this is an exact match. */
-          return *i;
-        }
       uint32_t tmp = 0;
-      if ((*i)->GetLocalAddress () == Ipv4Address::GetAny ()) 
+      if (i->second->GetLocalAddress () == Ipv4Address::GetAny ()) 
         {
           tmp++;
         }
-      if ((*i)->GetPeerAddress () == Ipv4Address::GetAny ()) 
+      if (i->second->GetPeerAddress () == Ipv4Address::GetAny ()) 
         {
           tmp++;
         }
       if (tmp < genericity) 
         {
-          generic = (*i);
+          generic = i->second;
           genericity = tmp;
         }
     }
@@ -383,5 +460,92 @@ Ipv4EndPointDemux::AllocateEphemeralPort (void)
   return port;
 }
 
-} // namespace ns3
 
+void
+Ipv4EndPointDemux::Insert (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  NS_ASSERT (endPoint->m_demux == 0);
+  endPoint->m_demux = this;
+  endPoint->m_order = m_nextOrder++;
+  m_endPoints[endPoint->m_order] = endPoint;
+  m_ports[endPoint->GetLocalPort ()][endPoint->m_order] = endPoint;
+  AddToIndex (endPoint);
+}
+
+void
+Ipv4EndPointDemux::AddToIndex (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  EndPoints *bucket;
+  if (endPoint->GetPeerAddress () == Ipv4Address::GetAny () && endPoint->GetPeerPort () == 0)
+    {
+      ListenerKey key = { endPoint->GetLocalAddress (), endPoint->GetLocalPort () };
+      bucket = &m_listeners[key];
+    }
+  else
+    {
+      ConnectionKey key = { endPoint->GetLocalAddress (), endPoint->GetLocalPort (),
+                            endPoint->GetPeerAddress (), endPoint->GetPeerPort () };
+      bucket = &m_connections[key];
+    }
+  // keep the bucket in allocation order
+  EndPointsI i = bucket->end ();
+  while (i != bucket->begin ())
+    {
+      EndPointsI prev = i;
+      --prev;
+      if ((*prev)->m_order < endPoint->m_order)
+        {
+          break;
+        }
+      i = prev;
+    }
+  bucket->insert (i, endPoint);
+}
+
+void
+Ipv4EndPointDemux::RemoveFromIndex (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  if (endPoint->GetPeerAddress () == Ipv4Address::GetAny () && endPoint->GetPeerPort () == 0)
+    {
+      ListenerKey key = { endPoint->GetLocalAddress (), endPoint->GetLocalPort () };
+      ListenerMap::iterator it = m_listeners.find (key);
+      NS_ASSERT (it != m_listeners.end ());
+      it->second.remove (endPoint);
+      if (it->second.empty ())
+        {
+          m_listeners.erase (it);
+        }
+    }
+  else
+    {
+      ConnectionKey key = { endPoint->GetLocalAddress (), endPoint->GetLocalPort (),
+                            endPoint->GetPeerAddress (), endPoint->GetPeerPort () };
+      ConnectionMap::iterator it = m_connections.find (key);
+      NS_ASSERT (it != m_connections.end ());
+      it->second.remove (endPoint);
+      if (it->second.empty ())
+        {
+          m_connections.erase (it);
+        }
+    }
+}
+
+Ipv4EndPointDemux::EndPoints *
+Ipv4EndPointDemux::Find (Ipv4Address localAddress, uint16_t localPort,
+                         Ipv4Address peerAddress, uint16_t peerPort)
+{
+  if (peerAddress == Ipv4Address::GetAny () && peerPort == 0)
+    {
+      ListenerKey key = { localAddress, localPort };
+      ListenerMap::iterator it = m_listeners.find (key);
+      return it == m_listeners.end () ? 0 : &it->second;
+    }
+  ConnectionKey key = { localAddress, localPort, peerAddress, peerPort };
+  ConnectionMap::iterator it = m_connections.find (key);
+  return it == m_connections.end () ? 0 : &it->second;
+}
+
+} // namespace ns3
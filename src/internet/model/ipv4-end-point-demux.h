@@ -23,7 +23,9 @@
 
 #include <stdint.h>
 #include <list>
+#include <map>
 #include "ns3/ipv4-address.h"
+#include "ns3/sgi-hashmap.h"
 #include "ipv4-interface.h"
 
 namespace ns3 {
@@ -40,6 +42,14 @@ class Ipv4EndPoint;
  * of endpoints, and has APIs to add and find endpoints in this demux.  This
  * code is shared in common to TCP and UDP protocols in ns3.  This demux
  * sits between ns3's layer four and the socket layer
+ *
+ * The endpoints are indexed by two hash tables: endpoints with a peer are
+ * indexed by their four-tuple, while the endpoints without a peer (i.e.,
+ * listening or unconnected sockets) are indexed by their local address and
+ * port, the latter being enough for endpoints bound to the wildcard address.
+ * A lookup only probes the entries which may match the incoming packet, so
+ * its cost does not depend on the number of endpoints. The endpoints notify
+ * the demux when their addresses change, to keep the index up to date.
  */
 
 class Ipv4EndPointDemux {
@@ -163,6 +173,108 @@ public:
   void DeAllocate (Ipv4EndPoint *endPoint);
 
 private:
+  friend class Ipv4EndPoint;
+
+  /**
+   * \brief Key of the endpoints with a peer.
+   */
+  struct ConnectionKey
+  {
+    Ipv4Address m_localAddress; //!< local address
+    uint16_t m_localPort;       //!< local port
+    Ipv4Address m_peerAddress;  //!< peer address
+    uint16_t m_peerPort;        //!< peer port
+
+    /**
+     * \param other the key to compare
+     * \returns true if the keys are equal
+     */
+    bool operator== (const ConnectionKey &other) const;
+  };
+
+  /**
+   * \brief Hash function of a ConnectionKey.
+   */
+  struct ConnectionKeyHash
+  {
+    /**
+     * \param key the key
+     * \returns the hash of the key
+     */
+    size_t operator() (const ConnectionKey &key) const;
+  };
+
+  /**
+   * \brief Key of the endpoints without a peer.
+   */
+  struct ListenerKey
+  {
+    Ipv4Address m_localAddress; //!< local address
+    uint16_t m_localPort;       //!< local port
+
+    /**
+     * \param other the key to compare
+     * \returns true if the keys are equal
+     */
+    bool operator== (const ListenerKey &other) const;
+  };
+
+  /**
+   * \brief Hash function of a ListenerKey.
+   */
+  struct ListenerKeyHash
+  {
+    /**
+     * \param key the key
+     * \returns the hash of the key
+     */
+    size_t operator() (const ListenerKey &key) const;
+  };
+
+  /// Endpoints sorted by allocation order
+  typedef std::map<uint64_t, Ipv4EndPoint *> OrderedEndPoints;
+  /// Endpoints with a peer, by four-tuple
+  typedef sgi::hash_map<ConnectionKey, EndPoints, ConnectionKeyHash> ConnectionMap;
+  /// Endpoints without a peer, by local address and port
+  typedef sgi::hash_map<ListenerKey, EndPoints, ListenerKeyHash> ListenerMap;
+
+  /**
+   * \brief Compare the allocation order of two endpoints.
+   * \param a an endpoint
+   * \param b another endpoint
+   * \returns true if a was allocated before b
+   */
+  static bool AllocatedBefore (Ipv4EndPoint *a, Ipv4EndPoint *b);
+
+  /**
+   * \brief Register a new endpoint.
+   * \param endPoint the endpoint
+   */
+  void Insert (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Add an endpoint to the hash table matching its current addresses.
+   * \param endPoint the endpoint
+   */
+  void AddToIndex (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Remove an endpoint from the hash table matching its current addresses.
+   * \param endPoint the endpoint
+   */
+  void RemoveFromIndex (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Find the endpoints with exactly the given addresses and ports.
+   * \param localAddress local address
+   * \param localPort local port
+   * \param peerAddress peer address
+   * \param peerPort peer port
+   * \returns the endpoints, or 0 if there is none
+   */
+  EndPoints *Find (Ipv4Address localAddress, uint16_t localPort,
+                   Ipv4Address peerAddress, uint16_t peerPort);
+
 
   /**
    * \brief Allocate an ephemeral port.
@@ -186,9 +298,29 @@ private:
   uint16_t m_portFirst;
 
   /**
-   * \brief A list of IPv4 end points.
+   * \brief The allocation order of the next end point.
+   */
+  uint64_t m_nextOrder;
+
+  /**
+   * \brief The IPv4 end points, in allocation order.
+   */
+  OrderedEndPoints m_endPoints;
+
+  /**
+   * \brief The IPv4 end points, by local port and allocation order.
+   */
+  std::map<uint16_t, OrderedEndPoints> m_ports;
+
+  /**
+   * \brief The IPv4 end points with a peer.
+   */
+  ConnectionMap m_connections;
+
+  /**
+   * \brief The IPv4 end points without a peer.
    */
-  EndPoints m_endPoints;
+  ListenerMap m_listeners;
 };
 
 } // namespace ns3
@@ -32,6 +32,7 @@ namespace ns3 {
 
 class Header;
 class Packet;
+class Ipv4EndPointDemux;
 
 /**
  * \ingroup ipv4
@@ -183,6 +184,8 @@ public:
   bool IsRxEnabled (void);
 
 private:
+  friend class Ipv4EndPointDemux;
+
   /**
    * \brief The local address.
    */
@@ -227,6 +230,16 @@ private:
    * \brief true if the endpoint can receive packets.
    */
   bool m_rxEnabled;
+
+  /**
+   * \brief The demux holding the endpoint (if any), which indexes it by its addresses.
+   */
+  Ipv4EndPointDemux *m_demux;
+
+  /**
+   * \brief The allocation order of the endpoint in its demux.
+   */
+  uint64_t m_order;
 };
 
 } // namespace ns3
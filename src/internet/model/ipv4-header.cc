@@ -41,6 +41,7 @@ Ipv4Header::Ipv4Header ()
     m_fragmentOffset (0),
     m_checksum (0),
     m_goodChecksum (true),
+    m_checksumValid (false),
     m_headerSize(5*4)
 {
 }
@@ -57,6 +58,7 @@ Ipv4Header::SetPayloadSize (uint16_t size)
 {
   NS_LOG_FUNCTION (this << size);
   m_payloadSize = size;
+  m_checksumValid = false;
 }
 uint16_t
 Ipv4Header::GetPayloadSize (void) const
@@ -76,12 +78,21 @@ Ipv4Header::SetIdentification (uint16_t identification)
 {
   NS_LOG_FUNCTION (this << identification);
   m_identification = identification;
+  m_checksumValid = false;
 }
 
 void 
 Ipv4Header::SetTos (uint8_t tos)
 {
   NS_LOG_FUNCTION (this << static_cast<uint32_t> (tos));
+  if (m_checksumValid)
+    {
+      // the TOS shares a 16-bit word with the version and the IHL, which
+      // is 5 when the checksum is valid
+      m_checksum = Buffer::Iterator::UpdateIpChecksum (m_checksum,
+                                                       0x45 | (m_tos << 8),
+                                                       0x45 | (tos << 8));
+    }
   m_tos = tos;
 }
 
@@ -89,16 +100,16 @@ void
 Ipv4Header::SetDscp (DscpType dscp)
 {
   NS_LOG_FUNCTION (this << dscp);
-  m_tos &= 0x3; // Clear out the DSCP part, retain 2 bits of ECN
-  m_tos |= (dscp << 2);
+  // Clear out the DSCP part, retain 2 bits of ECN
+  SetTos ((m_tos & 0x3) | (dscp << 2));
 }
 
 void
 Ipv4Header::SetEcn (EcnType ecn)
 {
   NS_LOG_FUNCTION (this << ecn);
-  m_tos &= 0xFC; // Clear out the ECN part, retain 6 bits of DSCP
-  m_tos |= ecn;
+  // Clear out the ECN part, retain 6 bits of DSCP
+  SetTos ((m_tos & 0xFC) | ecn);
 }
 
 Ipv4Header::DscpType 
@@ -201,12 +212,14 @@ Ipv4Header::SetMoreFragments (void)
 {
   NS_LOG_FUNCTION (this);
   m_flags |= MORE_FRAGMENTS;
+  m_checksumValid = false;
 }
 void
 Ipv4Header::SetLastFragment (void)
 {
   NS_LOG_FUNCTION (this);
   m_flags &= ~MORE_FRAGMENTS;
+  m_checksumValid = false;
 }
 bool 
 Ipv4Header::IsLastFragment (void) const
@@ -220,12 +233,14 @@ Ipv4Header::SetDontFragment (void)
 {
   NS_LOG_FUNCTION (this);
   m_flags |= DONT_FRAGMENT;
+  m_checksumValid = false;
 }
 void 
 Ipv4Header::SetMayFragment (void)
 {
   NS_LOG_FUNCTION (this);
   m_flags &= ~DONT_FRAGMENT;
+  m_checksumValid = false;
 }
 bool 
 Ipv4Header::IsDontFragment (void) const
@@ -241,6 +256,7 @@ Ipv4Header::SetFragmentOffset (uint16_t offsetBytes)
   // check if the user is trying to set an invalid offset
   NS_ABORT_MSG_IF ((offsetBytes & 0x7), "offsetBytes must be multiple of 8 bytes");
   m_fragmentOffset = offsetBytes;
+  m_checksumValid = false;
 }
 uint16_t 
 Ipv4Header::GetFragmentOffset (void) const
@@ -259,6 +275,13 @@ void
 Ipv4Header::SetTtl (uint8_t ttl)
 {
   NS_LOG_FUNCTION (this << static_cast<uint32_t> (ttl));
+  if (m_checksumValid)
+    {
+      // the TTL shares a 16-bit word with the protocol
+      m_checksum = Buffer::Iterator::UpdateIpChecksum (m_checksum,
+                                                       m_ttl | (m_protocol << 8),
+                                                       ttl | (m_protocol << 8));
+    }
   m_ttl = ttl;
 }
 uint8_t 
@@ -279,6 +302,7 @@ Ipv4Header::SetProtocol (uint8_t protocol)
 {
   NS_LOG_FUNCTION (this << static_cast<uint32_t> (protocol));
   m_protocol = protocol;
+  m_checksumValid = false;
 }
 
 void 
@@ -286,6 +310,7 @@ Ipv4Header::SetSource (Ipv4Address source)
 {
   NS_LOG_FUNCTION (this << source);
   m_source = source;
+  m_checksumValid = false;
 }
 Ipv4Address
 Ipv4Header::GetSource (void) const
@@ -299,6 +324,7 @@ Ipv4Header::SetDestination (Ipv4Address dst)
 {
   NS_LOG_FUNCTION (this << dst);
   m_destination = dst;
+  m_checksumValid = false;
 }
 Ipv4Address
 Ipv4Header::GetDestination (void) const
@@ -405,11 +431,19 @@ Ipv4Header::Serialize (Buffer::Iterator start) const
   i.WriteU8 (frag);
   i.WriteU8 (m_ttl);
   i.WriteU8 (m_protocol);
-  i.WriteHtonU16 (0);
+  if (m_calcChecksum && m_checksumValid)
+    {
+      // the checksum received was kept up to date by SetTtl
+      i.WriteU16 (m_checksum);
+    }
+  else
+    {
+      i.WriteHtonU16 (0);
+    }
   i.WriteHtonU32 (m_source.Get ());
   i.WriteHtonU32 (m_destination.Get ());
 
-  if (m_calcChecksum) 
+  if (m_calcChecksum && !m_checksumValid)
     {
       i = start;
       uint16_t checksum = i.CalculateIpChecksum (20);
@@ -470,6 +504,10 @@ Ipv4Header::Deserialize (Buffer::Iterator start)
 
       m_goodChecksum = (checksum == 0);
     }
+  // Serialize writes a 20-byte header with the reserved flag cleared, so
+  // the checksum received can be reused only if it was correct and
+  // covered neither options nor the reserved flag
+  m_checksumValid = m_calcChecksum && m_goodChecksum && (headerSize == 5*4) && !(flags & (1<<7));
   return GetSerializedSize ();
 }
 
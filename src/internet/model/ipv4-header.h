@@ -143,6 +143,11 @@ public:
    */
   void SetFragmentOffset (uint16_t offsetBytes);
   /**
+   * If the header was deserialized with a correct checksum, the checksum
+   * is updated incrementally (RFC 1624) rather than recomputed when the
+   * header is serialized again.  The same holds for the TOS, DSCP and
+   * ECN fields.
+   *
    * \param ttl the ipv4 TTL
    */
   void SetTtl (uint8_t ttl);
@@ -256,6 +261,7 @@ private:
   Ipv4Address m_destination; //!< destination address
   uint16_t m_checksum; //!< checksum
   bool m_goodChecksum; //!< true if checksum is correct
+  bool m_checksumValid; //!< true if m_checksum matches the other fields
   uint16_t m_headerSize; //!< IP header size
 };
 
@@ -33,6 +33,8 @@
 #include "ns3/boolean.h"
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/traffic-control-layer.h"
+#include "ns3/net-device-queue-interface.h"
+#include <vector>
 
 #include "loopback-net-device.h"
 #include "arp-l3-protocol.h"
@@ -41,6 +43,9 @@
 #include "icmpv4-l4-protocol.h"
 #include "ipv4-interface.h"
 #include "ipv4-raw-socket-impl.h"
+#include "tcp-header.h"
+#include "tcp-l4-protocol.h"
+#include "tcp-segmentation-tag.h"
 
 namespace ns3 {
 
@@ -69,6 +74,13 @@ Ipv4L3Protocol::GetTypeId (void)
                    TimeValue (Seconds (30)),
                    MakeTimeAccessor (&Ipv4L3Protocol::m_fragmentExpirationTimeout),
                    MakeTimeChecker ())
+    .AddAttribute ("FragmentBufferSize",
+                   "The maximum number of bytes of fragments buffered for "
+                   "reassembly, 0 for no limit. When it is exceeded, the "
+                   "oldest fragmented packets are dropped.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&Ipv4L3Protocol::m_fragmentBufferSize),
+                   MakeUintegerChecker<uint32_t> ())
     .AddTraceSource ("Tx",
                      "Send ipv4 packet to outgoing interface.",
                      MakeTraceSourceAccessor (&Ipv4L3Protocol::m_txTrace),
@@ -108,6 +120,7 @@ Ipv4L3Protocol::GetTypeId (void)
 }
 
 Ipv4L3Protocol::Ipv4L3Protocol()
+  : m_fragmentsBytes (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -307,17 +320,14 @@ Ipv4L3Protocol::DoDispose (void)
       it->second = 0;
     }
 
-  for (MapFragmentsTimers_t::iterator it = m_fragmentsTimers.begin (); it != m_fragmentsTimers.end (); it++)
+  m_fragments.clear ();
+  m_timeoutEventList.clear ();
+  m_fragmentsBytes = 0;
+  if (m_timeoutEvent.IsRunning ())
     {
-      if (it->second.IsRunning ())
-        {
-          it->second.Cancel ();
-        }
+      m_timeoutEvent.Cancel ();
     }
 
-  m_fragments.clear ();
-  m_fragmentsTimers.clear ();
-
   Object::DoDispose ();
 }
 
@@ -389,6 +399,14 @@ Ipv4L3Protocol::AddInterface (Ptr<NetDevice> device)
   interface->SetTrafficControl (tc);
   interface->SetForwarding (m_ipForward);
   tc->SetupDevice (device);
+
+  // let the device split the TCP super-segments it transmits
+  Ptr<NetDeviceQueueInterface> ndqi = device->GetObject<NetDeviceQueueInterface> ();
+  if (ndqi != 0)
+    {
+      ndqi->SetSegmentationCallback (Ipv4L3Protocol::PROT_NUMBER,
+                                     MakeCallback (&Ipv4L3Protocol::Segment, this));
+    }
   return AddIpv4Interface (interface);
 }
 
@@ -711,6 +729,11 @@ void
 Ipv4L3Protocol::CallTxTrace (const Ipv4Header & ipHeader, Ptr<Packet> packet,
                                     Ptr<Ipv4> ipv4, uint32_t interface)
 {
+  if (m_txTrace.IsEmpty ())
+    {
+      // do not pay for a copy of the packet which nobody looks at
+      return;
+    }
   Ptr<Packet> packetCopy = packet->Copy ();
   packetCopy->AddHeader (ipHeader);
   m_txTrace (packetCopy, ipv4, interface);
@@ -879,16 +902,10 @@ Ipv4L3Protocol::BuildHeader (
   ipHeader.SetTtl (ttl);
   ipHeader.SetTos (tos);
 
-  uint64_t src = source.Get ();
-  uint64_t dst = destination.Get ();
-  uint64_t srcDst = dst | (src << 32);
-  std::pair<uint64_t, uint8_t> key = std::make_pair (srcDst, protocol);
-
   if (mayFragment == true)
     {
       ipHeader.SetMayFragment ();
-      ipHeader.SetIdentification (m_identification[key]);
-      m_identification[key]++;
+      ipHeader.SetIdentification (NextIdentification (source, destination, protocol));
     }
   else
     {
@@ -897,8 +914,7 @@ Ipv4L3Protocol::BuildHeader (
       // identification requirement:
       // >> Originating sources MAY set the IPv4 ID field of atomic datagrams
       //    to any value.
-      ipHeader.SetIdentification (m_identification[key]);
-      m_identification[key]++;
+      ipHeader.SetIdentification (NextIdentification (source, destination, protocol));
     }
   if (Node::ChecksumEnabled ())
     {
@@ -907,6 +923,16 @@ Ipv4L3Protocol::BuildHeader (
   return ipHeader;
 }
 
+uint16_t
+Ipv4L3Protocol::NextIdentification (Ipv4Address source, Ipv4Address destination, uint8_t protocol)
+{
+  uint64_t src = source.Get ();
+  uint64_t dst = destination.Get ();
+  uint64_t srcDst = dst | (src << 32);
+  std::pair<uint64_t, uint8_t> key = std::make_pair (srcDst, protocol);
+  return m_identification[key]++;
+}
+
 void
 Ipv4L3Protocol::SendRealOut (Ptr<Ipv4Route> route,
                              Ptr<Packet> packet,
@@ -925,12 +951,36 @@ Ipv4L3Protocol::SendRealOut (Ptr<Ipv4Route> route,
   Ptr<Ipv4Interface> outInterface = GetInterface (interface);
   NS_LOG_LOGIC ("Send via NetDevice ifIndex " << outDev->GetIfIndex () << " ipv4InterfaceIndex " << interface);
 
+  // A TCP super-segment goes down as a whole to a device which splits it
+  // into segments fitting its MTU, and is split here otherwise
+  bool superSegment = false;
+  TcpSegmentationTag tsoTag;
+  if (packet->PeekPacketTag (tsoTag))
+    {
+      Ptr<NetDeviceQueueInterface> ndqi = outDev->GetObject<NetDeviceQueueInterface> ();
+      TcpHeader tcpHeader;
+      packet->PeekHeader (tcpHeader);
+      if (ndqi == 0 || !ndqi->GetSegmentationOffload ()
+          || ipHeader.GetSerializedSize () + tcpHeader.GetSerializedSize ()
+             + tsoTag.GetSegmentSize () > outDev->GetMtu ())
+        {
+          std::list<Ipv4PayloadHeaderPair> listSegments;
+          DoSegmentation (packet, ipHeader, tsoTag.GetSegmentSize (), listSegments);
+          for (std::list<Ipv4PayloadHeaderPair>::iterator it = listSegments.begin (); it != listSegments.end (); it++)
+            {
+              SendRealOut (route, it->first, it->second);
+            }
+          return;
+        }
+      superSegment = true;
+    }
+
   if (!route->GetGateway ().IsEqual (Ipv4Address ("0.0.0.0")))
     {
       if (outInterface->IsUp ())
         {
           NS_LOG_LOGIC ("Send to gateway " << route->GetGateway ());
-          if ( packet->GetSize () + ipHeader.GetSerializedSize () > outInterface->GetDevice ()->GetMtu () )
+          if (!superSegment && packet->GetSize () + ipHeader.GetSerializedSize () > outInterface->GetDevice ()->GetMtu ())
             {
               std::list<Ipv4PayloadHeaderPair> listFragments;
               DoFragmentation (packet, ipHeader, outInterface->GetDevice ()->GetMtu (), listFragments);
@@ -957,7 +1007,7 @@ Ipv4L3Protocol::SendRealOut (Ptr<Ipv4Route> route,
       if (outInterface->IsUp ())
         {
           NS_LOG_LOGIC ("Send to destination " << ipHeader.GetDestination ());
-          if ( packet->GetSize () + ipHeader.GetSerializedSize () > outInterface->GetDevice ()->GetMtu () )
+          if (!superSegment && packet->GetSize () + ipHeader.GetSerializedSize () > outInterface->GetDevice ()->GetMtu ())
             {
               std::list<Ipv4PayloadHeaderPair> listFragments;
               DoFragmentation (packet, ipHeader, outInterface->GetDevice ()->GetMtu (), listFragments);
@@ -1054,6 +1104,27 @@ Ipv4L3Protocol::IpForward (Ptr<Ipv4Route> rtentry, Ptr<const Packet> p, const Ip
     }
 
   m_unicastForwardTrace (ipHeader, packet, interface);
+
+  // Fast path: the route is already resolved, so a packet which fits the
+  // MTU of an interface which is up is handed straight to the interface.
+  // TCP super-segments, fragmentation and drops go through SendRealOut.
+  NS_ASSERT (interface >= 0);
+  Ptr<Ipv4Interface> outInterface = m_interfaces[interface];
+  TcpSegmentationTag tsoTag;
+  if (outInterface->IsUp ()
+      && packet->GetSize () + ipHeader.GetSerializedSize () <= outInterface->GetDevice ()->GetMtu ()
+      && !packet->PeekPacketTag (tsoTag))
+    {
+      Ipv4Address nextHop = rtentry->GetGateway ();
+      if (nextHop.IsEqual (Ipv4Address::GetAny ()))
+        {
+          nextHop = ipHeader.GetDestination ();
+        }
+      CallTxTrace (ipHeader, packet, m_node->GetObject<Ipv4> (), interface);
+      outInterface->Send (packet, ipHeader, nextHop);
+      return;
+    }
+
   SendRealOut (rtentry, packet, ipHeader);
 }
 
@@ -1495,6 +1566,89 @@ Ipv4L3Protocol::DoFragmentation (Ptr<Packet> packet, const Ipv4Header & ipv4Head
   return;
 }
 
+void
+Ipv4L3Protocol::DoSegmentation (Ptr<Packet> packet, const Ipv4Header & ipv4Header, uint16_t segmentSize, std::list<Ipv4PayloadHeaderPair>& listSegments)
+{
+  NS_LOG_FUNCTION (this << *packet << segmentSize << &listSegments);
+  NS_ASSERT (segmentSize > 0);
+
+  Ptr<Packet> p = packet->Copy ();
+  TcpSegmentationTag tsoTag;
+  p->RemovePacketTag (tsoTag);
+  TcpHeader tcpHeader;
+  p->RemoveHeader (tcpHeader);
+
+  uint32_t size = p->GetSize ();
+  uint32_t offset = 0;
+  do
+    {
+      uint32_t length = std::min<uint32_t> (segmentSize, size - offset);
+      Ptr<Packet> segment = p->CreateFragment (offset, length);
+
+      TcpHeader segmentTcpHeader = tcpHeader;
+      segmentTcpHeader.SetSequenceNumber (tcpHeader.GetSequenceNumber () + SequenceNumber32 (offset));
+      uint8_t flags = tcpHeader.GetFlags ();
+      if (offset + length < size)
+        {
+          flags &= ~(TcpHeader::FIN | TcpHeader::PSH);
+        }
+      if (offset > 0)
+        {
+          flags &= ~TcpHeader::CWR;
+        }
+      segmentTcpHeader.SetFlags (flags);
+      if (Node::ChecksumEnabled ())
+        {
+          segmentTcpHeader.EnableChecksums ();
+        }
+      segmentTcpHeader.InitializeChecksum (ipv4Header.GetSource (), ipv4Header.GetDestination (),
+                                           TcpL4Protocol::PROT_NUMBER);
+      segment->AddHeader (segmentTcpHeader);
+
+      Ipv4Header segmentHeader = ipv4Header;
+      segmentHeader.SetPayloadSize (segment->GetSize ());
+      if (offset > 0)
+        {
+          segmentHeader.SetIdentification (NextIdentification (ipv4Header.GetSource (),
+                                                               ipv4Header.GetDestination (),
+                                                               ipv4Header.GetProtocol ()));
+        }
+      if (Node::ChecksumEnabled ())
+        {
+          segmentHeader.EnableChecksum ();
+        }
+
+      NS_LOG_LOGIC ("New segment " << segmentTcpHeader << " of size " << length);
+      listSegments.push_back (Ipv4PayloadHeaderPair (segment, segmentHeader));
+      offset += length;
+    }
+  while (offset < size);
+}
+
+std::list<Ptr<Packet> >
+Ipv4L3Protocol::Segment (Ptr<Packet> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+
+  std::list<Ptr<Packet> > segments;
+  TcpSegmentationTag tsoTag;
+  if (!packet->PeekPacketTag (tsoTag))
+    {
+      return segments;
+    }
+  Ptr<Packet> p = packet->Copy ();
+  Ipv4Header ipHeader;
+  p->RemoveHeader (ipHeader);
+  std::list<Ipv4PayloadHeaderPair> listSegments;
+  DoSegmentation (p, ipHeader, tsoTag.GetSegmentSize (), listSegments);
+  for (std::list<Ipv4PayloadHeaderPair>::iterator it = listSegments.begin (); it != listSegments.end (); it++)
+    {
+      it->first->AddHeader (it->second);
+      segments.push_back (it->first);
+    }
+  return segments;
+}
+
 bool
 Ipv4L3Protocol::ProcessFragment (Ptr<Packet>& packet, Ipv4Header& ipHeader, uint32_t iif)
 {
@@ -1516,9 +1670,7 @@ Ipv4L3Protocol::ProcessFragment (Ptr<Packet>& packet, Ipv4Header& ipHeader, uint
     {
       fragments = Create<Fragments> ();
       m_fragments.insert (std::make_pair (key, fragments));
-      m_fragmentsTimers[key] = Simulator::Schedule (m_fragmentExpirationTimeout,
-                                                    &Ipv4L3Protocol::HandleFragmentsTimeout, this,
-                                                    key, ipHeader, iif);
+      fragments->SetTimeoutIter (SetTimeout (key, ipHeader, iif));
     }
   else
     {
@@ -1527,27 +1679,32 @@ Ipv4L3Protocol::ProcessFragment (Ptr<Packet>& packet, Ipv4Header& ipHeader, uint
 
   NS_LOG_LOGIC ("Adding fragment - Size: " << packet->GetSize ( ) << " - Offset: " << (ipHeader.GetFragmentOffset ()) );
 
+  uint32_t size = fragments->GetSize ();
   fragments->AddFragment (p, ipHeader.GetFragmentOffset (), !ipHeader.IsLastFragment () );
+  m_fragmentsBytes += fragments->GetSize () - size;
 
   if ( fragments->IsEntire () )
     {
       packet = fragments->GetPacket ();
+      m_fragmentsBytes -= fragments->GetSize ();
+      // the timeout event is left running: it finds nothing to expire
+      m_timeoutEventList.erase (fragments->GetTimeoutIter ());
       fragments = 0;
       m_fragments.erase (key);
-      if (m_fragmentsTimers[key].IsRunning ())
-        {
-          NS_LOG_LOGIC ("Stopping WaitFragmentsTimer at " << Simulator::Now ().GetSeconds () << " due to complete packet");
-          m_fragmentsTimers[key].Cancel ();
-        }
-      m_fragmentsTimers.erase (key);
       ret = true;
     }
+  else if (m_fragmentBufferSize > 0 && m_fragmentsBytes > m_fragmentBufferSize)
+    {
+      EvictFragments ();
+    }
 
   return ret;
 }
 
 Ipv4L3Protocol::Fragments::Fragments ()
-  : m_moreFragment (0)
+  : m_moreFragment (0),
+    m_lastOffset (-1),
+    m_size (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -1562,22 +1719,52 @@ Ipv4L3Protocol::Fragments::AddFragment (Ptr<Packet> fragment, uint16_t fragmentO
 {
   NS_LOG_FUNCTION (this << fragment << fragmentOffset << moreFragment);
 
-  std::list<std::pair<Ptr<Packet>, uint16_t> >::iterator it;
+  if (int32_t (fragmentOffset) >= m_lastOffset)
+    {
+      m_lastOffset = fragmentOffset;
+      m_moreFragment = moreFragment;
+    }
+
+  uint32_t start = fragmentOffset;
+  uint32_t end = start + fragment->GetSize ();
 
-  for (it = m_fragments.begin (); it != m_fragments.end (); it++)
+  // The fragments are overlapping.
+  // We do not overwrite the "old" with the "new": only the bytes which
+  // fill the holes between the intervals already received are kept.
+  // This is different from what Linux does.
+  // It is not possible to emulate a fragmentation attack.
+  uint32_t intervalStart = start;
+  uint32_t intervalEnd = end;
+  uint32_t position = start;
+  std::map<uint32_t, uint32_t>::iterator it = m_intervals.upper_bound (start);
+  if (it != m_intervals.begin ())
     {
-      if (it->second > fragmentOffset)
+      std::map<uint32_t, uint32_t>::iterator previous = it;
+      previous--;
+      if (previous->second >= start)
         {
-          break;
+          intervalStart = previous->first;
+          intervalEnd = std::max (end, previous->second);
+          position = std::max (start, previous->second);
+          m_intervals.erase (previous);
         }
     }
-
-  if (it == m_fragments.end ())
+  for ( ; it != m_intervals.end () && it->first <= end; m_intervals.erase (it++))
     {
-      m_moreFragment = moreFragment;
+      if (it->first > position)
+        {
+          m_fragments[position] = fragment->CreateFragment (position - start, it->first - position);
+          m_size += it->first - position;
+        }
+      position = it->second;
+      intervalEnd = std::max (intervalEnd, it->second);
     }
-
-  m_fragments.insert (it, std::pair<Ptr<Packet>, uint16_t> (fragment, fragmentOffset));
+  if (position < end)
+    {
+      m_fragments[position] = (position == start) ? fragment : fragment->CreateFragment (position - start, end - position);
+      m_size += end - position;
+    }
+  m_intervals[intervalStart] = intervalEnd;
 }
 
 bool
@@ -1585,29 +1772,7 @@ Ipv4L3Protocol::Fragments::IsEntire () const
 {
   NS_LOG_FUNCTION (this);
 
-  bool ret = !m_moreFragment && m_fragments.size () > 0;
-
-  if (ret)
-    {
-      uint16_t lastEndOffset = 0;
-
-      for (std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_fragments.begin (); it != m_fragments.end (); it++)
-        {
-          // overlapping fragments do exist
-          NS_LOG_LOGIC ("Checking overlaps " << lastEndOffset << " - " << it->second );
-
-          if (lastEndOffset < it->second)
-            {
-              ret = false;
-              break;
-            }
-          // fragments might overlap in strange ways
-          uint16_t fragmentEnd = it->first->GetSize () + it->second;
-          lastEndOffset = std::max ( lastEndOffset, fragmentEnd );
-        }
-    }
-
-  return ret;
+  return !m_moreFragment && m_intervals.size () == 1 && m_intervals.begin ()->first == 0;
 }
 
 Ptr<Packet>
@@ -1615,72 +1780,66 @@ Ipv4L3Protocol::Fragments::GetPacket () const
 {
   NS_LOG_FUNCTION (this);
 
-  std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_fragments.begin ();
+  return Assemble (m_intervals.begin ()->second);
+}
 
-  Ptr<Packet> p = it->first->Copy ();
-  uint16_t lastEndOffset = p->GetSize ();
-  it++;
+Ptr<Packet>
+Ipv4L3Protocol::Fragments::GetPartialPacket () const
+{
+  NS_LOG_FUNCTION (this);
 
-  for ( ; it != m_fragments.end (); it++)
+  if (m_intervals.empty () || m_intervals.begin ()->first > 0)
     {
-      if ( lastEndOffset > it->second )
-        {
-          // The fragments are overlapping.
-          // We do not overwrite the "old" with the "new" because we do not know when each arrived.
-          // This is different from what Linux does.
-          // It is not possible to emulate a fragmentation attack.
-          uint32_t newStart = lastEndOffset - it->second;
-          if ( it->first->GetSize () > newStart )
-            {
-              uint32_t newSize = it->first->GetSize () - newStart;
-              Ptr<Packet> tempFragment = it->first->CreateFragment (newStart, newSize);
-              p->AddAtEnd (tempFragment);
-            }
-        }
-      else
-        {
-          NS_LOG_LOGIC ("Adding: " << *(it->first) );
-          p->AddAtEnd (it->first);
-        }
-      lastEndOffset = p->GetSize ();
+      return Create<Packet> ();
     }
-
-  return p;
+  return Assemble (m_intervals.begin ()->second);
 }
 
 Ptr<Packet>
-Ipv4L3Protocol::Fragments::GetPartialPacket () const
+Ipv4L3Protocol::Fragments::Assemble (uint32_t end) const
 {
-  NS_LOG_FUNCTION (this);
-  
-  std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_fragments.begin ();
+  NS_LOG_FUNCTION (this << end);
 
-  Ptr<Packet> p = Create<Packet> ();
-  uint16_t lastEndOffset = 0;
-
-  if ( m_fragments.begin ()->second > 0 )
+  // the fragments are merged pairwise, so that each byte is copied a
+  // logarithmic number of times
+  std::vector<Ptr<Packet> > parts;
+  for (std::map<uint32_t, Ptr<Packet> >::const_iterator it = m_fragments.begin ();
+       it != m_fragments.end () && it->first < end; it++)
     {
-      return p;
+      parts.push_back (it->second->Copy ());
     }
-
-  for ( it = m_fragments.begin (); it != m_fragments.end (); it++)
+  for (uint32_t step = 1; step < parts.size (); step *= 2)
     {
-      if ( lastEndOffset > it->second )
+      for (uint32_t i = 0; i + step < parts.size (); i += 2 * step)
         {
-          uint32_t newStart = lastEndOffset - it->second;
-          uint32_t newSize = it->first->GetSize () - newStart;
-          Ptr<Packet> tempFragment = it->first->CreateFragment (newStart, newSize);
-          p->AddAtEnd (tempFragment);
+          parts[i]->AddAtEnd (parts[i + step]);
         }
-      else if ( lastEndOffset == it->second )
-        {
-          NS_LOG_LOGIC ("Adding: " << *(it->first) );
-          p->AddAtEnd (it->first);
-        }
-      lastEndOffset = p->GetSize ();
     }
+  return parts.empty () ? Create<Packet> () : parts.front ();
+}
 
-  return p;
+uint32_t
+Ipv4L3Protocol::Fragments::GetSize () const
+{
+  NS_LOG_FUNCTION (this);
+
+  return m_size;
+}
+
+void
+Ipv4L3Protocol::Fragments::SetTimeoutIter (FragmentsTimeoutsListI_t iter)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_timeoutIter = iter;
+}
+
+Ipv4L3Protocol::FragmentsTimeoutsListI_t
+Ipv4L3Protocol::Fragments::GetTimeoutIter ()
+{
+  NS_LOG_FUNCTION (this);
+
+  return m_timeoutIter;
 }
 
 void
@@ -1700,9 +1859,68 @@ Ipv4L3Protocol::HandleFragmentsTimeout (std::pair<uint64_t, uint32_t> key, Ipv4H
   m_dropTrace (ipHeader, packet, DROP_FRAGMENT_TIMEOUT, m_node->GetObject<Ipv4> (), iif);
 
   // clear the buffers
+  m_fragmentsBytes -= it->second->GetSize ();
   it->second = 0;
 
   m_fragments.erase (key);
-  m_fragmentsTimers.erase (key);
+}
+
+Ipv4L3Protocol::FragmentsTimeoutsListI_t
+Ipv4L3Protocol::SetTimeout (FragmentKey_t key, Ipv4Header ipHeader, uint32_t iif)
+{
+  NS_LOG_FUNCTION (this << &key << ipHeader << iif);
+
+  // the timeouts all have the same duration, so the list is sorted by
+  // expiration time, and the event expires the first one
+  Time expiration = Simulator::Now () + m_fragmentExpirationTimeout;
+  if (!m_timeoutEvent.IsRunning ())
+    {
+      m_timeoutEvent = Simulator::Schedule (m_fragmentExpirationTimeout, &Ipv4L3Protocol::HandleTimeout, this);
+    }
+  m_timeoutEventList.push_back (std::make_tuple (expiration, key, ipHeader, iif));
+  return --m_timeoutEventList.end ();
+}
+
+void
+Ipv4L3Protocol::HandleTimeout (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Time now = Simulator::Now ();
+  while (!m_timeoutEventList.empty () && std::get<0> (m_timeoutEventList.front ()) <= now)
+    {
+      FragmentKey_t key = std::get<1> (m_timeoutEventList.front ());
+      Ipv4Header ipHeader = std::get<2> (m_timeoutEventList.front ());
+      uint32_t iif = std::get<3> (m_timeoutEventList.front ());
+      m_timeoutEventList.pop_front ();
+      HandleFragmentsTimeout (key, ipHeader, iif);
+    }
+
+  if (!m_timeoutEventList.empty ())
+    {
+      Time delay = std::get<0> (m_timeoutEventList.front ()) - now;
+      m_timeoutEvent = Simulator::Schedule (delay, &Ipv4L3Protocol::HandleTimeout, this);
+    }
+}
+
+void
+Ipv4L3Protocol::EvictFragments (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  while (m_fragmentsBytes > m_fragmentBufferSize && !m_timeoutEventList.empty ())
+    {
+      FragmentKey_t key = std::get<1> (m_timeoutEventList.front ());
+      Ipv4Header ipHeader = std::get<2> (m_timeoutEventList.front ());
+      uint32_t iif = std::get<3> (m_timeoutEventList.front ());
+      m_timeoutEventList.pop_front ();
+
+      MapFragments_t::iterator it = m_fragments.find (key);
+      NS_LOG_LOGIC ("Evicting fragmented packet of " << it->second->GetSize () << " bytes, " <<
+                    m_fragmentsBytes << " bytes buffered");
+      m_fragmentsBytes -= it->second->GetSize ();
+      m_dropTrace (ipHeader, it->second->GetPartialPacket (), DROP_FRAGMENT_TIMEOUT, m_node->GetObject<Ipv4> (), iif);
+      m_fragments.erase (it);
+    }
 }
 } // namespace ns3
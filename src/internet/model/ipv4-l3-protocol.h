@@ -24,6 +24,7 @@
 #include <list>
 #include <map>
 #include <vector>
+#include <tuple>
 #include <stdint.h>
 #include "ns3/ipv4-address.h"
 #include "ns3/ptr.h"
@@ -316,6 +317,15 @@ private:
     uint8_t tos,
     bool mayFragment);
 
+  /**
+   * \brief Get the next identification of a {src, dst, proto} tuple.
+   * \param source source IPv4 address
+   * \param destination destination IPv4 address
+   * \param protocol L4 protocol
+   * \return the identification to use in the next IPv4 header
+   */
+  uint16_t NextIdentification (Ipv4Address source, Ipv4Address destination, uint8_t protocol);
+
   /**
    * \brief Send packet with route.
    * \param route route
@@ -405,6 +415,31 @@ private:
    */
   void DoFragmentation (Ptr<Packet> packet, const Ipv4Header& ipv4Header, uint32_t outIfaceMtu, std::list<Ipv4PayloadHeaderPair>& listFragments);
 
+  /**
+   * \brief Split a TCP super-segment into segments
+   *
+   * Each segment gets a copy of the TCP and IPv4 headers of the super-segment,
+   * with its own sequence number and IPv4 identification. FIN and PSH are only
+   * kept on the last segment, CWR on the first one.
+   *
+   * \param packet the super-segment, starting with the TCP header
+   * \param ipv4Header the IPv4 header
+   * \param segmentSize the size of the data carried by each segment
+   * \param listSegments the list of segments
+   */
+  void DoSegmentation (Ptr<Packet> packet, const Ipv4Header& ipv4Header, uint16_t segmentSize, std::list<Ipv4PayloadHeaderPair>& listSegments);
+
+  /**
+   * \brief Split a TCP super-segment on behalf of a device
+   *
+   * This is the segmentation callback set on the NetDeviceQueueInterface
+   * of the devices.
+   *
+   * \param packet the packet, starting with the IPv4 header
+   * \return the segments, or an empty list if the packet is not a super-segment
+   */
+  std::list<Ptr<Packet> > Segment (Ptr<Packet> packet);
+
   /**
    * \brief Process a packet fragment
    * \param packet the packet
@@ -422,6 +457,19 @@ private:
    */
   void HandleFragmentsTimeout ( std::pair<uint64_t, uint32_t> key, Ipv4Header & ipHeader, uint32_t iif);
 
+  /**
+   * \brief Expire all the fragmented packets whose timeout is due.
+   *
+   * A single event serves the timeouts of all the fragmented packets.
+   */
+  void HandleTimeout (void);
+
+  /**
+   * \brief Drop the oldest fragmented packets until the buffered
+   * fragments fit in FragmentBufferSize.
+   */
+  void EvictFragments (void);
+
   /**
    * \brief Make a copy of the packet, add the header and invoke the TX trace callback
    * \param ipHeader the IP header that will be added to the packet
@@ -492,8 +540,30 @@ private:
 
   SocketList m_sockets; //!< List of IPv4 raw sockets.
 
+  /// Key identifying a fragmented packet: (src+dst addr, identification+proto)
+  typedef std::pair<uint64_t, uint32_t> FragmentKey_t;
+
+  /// Container of fragment timeouts: (expiration time, key, IP header, input interface), by expiration time
+  typedef std::list< std::tuple <Time, FragmentKey_t, Ipv4Header, uint32_t > > FragmentsTimeoutsList_t;
+  /// Container Iterator of fragment timeouts
+  typedef std::list< std::tuple <Time, FragmentKey_t, Ipv4Header, uint32_t > >::iterator FragmentsTimeoutsListI_t;
+
+  /**
+   * \brief Start the timeout of a fragmented packet.
+   * \param key representing the packet fragments
+   * \param ipHeader the IP header of the original packet
+   * \param iif Input Interface
+   * \return an iterator to the timeout
+   */
+  FragmentsTimeoutsListI_t SetTimeout (FragmentKey_t key, Ipv4Header ipHeader, uint32_t iif);
+
   /**
    * \brief A Set of Fragment belonging to the same packet (src, dst, identification and proto)
+   *
+   * The parts of the fragments which overlap the bytes already received are
+   * discarded, and the intervals received so far are coalesced, so that the
+   * entire packet is a single interval. The packet is assembled only once,
+   * when it is entire.
    */
   class Fragments : public SimpleRefCount<Fragments>
   {
@@ -534,27 +604,72 @@ public:
      */
     Ptr<Packet> GetPartialPacket () const;
 
+    /**
+     * \brief Get the number of bytes of the fragments, without their overlaps.
+     * \return the number of bytes stored
+     */
+    uint32_t GetSize () const;
+
+    /**
+     * \brief Set the Timeout iterator.
+     * \param iter The iterator.
+     */
+    void SetTimeoutIter (FragmentsTimeoutsListI_t iter);
+
+    /**
+     * \brief Get the Timeout iterator.
+     * \returns The iterator.
+     */
+    FragmentsTimeoutsListI_t GetTimeoutIter ();
+
 private:
+    /**
+     * \brief Assemble the fragments which start before an offset.
+     * \param end the offset
+     * \return the packet
+     */
+    Ptr<Packet> Assemble (uint32_t end) const;
+
     /**
      * \brief True if other fragments will be sent.
      */
     bool m_moreFragment;
 
     /**
-     * \brief The current fragments.
+     * \brief The offset of the last fragment, or -1 if none has been added.
+     */
+    int32_t m_lastOffset;
+
+    /**
+     * \brief The current fragments, without overlaps, indexed by offset.
+     */
+    std::map<uint32_t, Ptr<Packet> > m_fragments;
+
+    /**
+     * \brief The intervals received: end offset indexed by start offset.
      */
-    std::list<std::pair<Ptr<Packet>, uint16_t> > m_fragments;
+    std::map<uint32_t, uint32_t> m_intervals;
 
+    /**
+     * \brief The number of bytes of the current fragments.
+     */
+    uint32_t m_size;
+
+    /**
+     * \brief Timeout iterator to "event" handler
+     */
+    FragmentsTimeoutsListI_t m_timeoutIter;
   };
 
   /// Container of fragments, stored as pairs(src+dst addr, src+dst port) / fragment
   typedef std::map< std::pair<uint64_t, uint32_t>, Ptr<Fragments> > MapFragments_t;
-  /// Container of fragment timeout event, stored as pairs(src+dst addr, src+dst port) / EventId
-  typedef std::map< std::pair<uint64_t, uint32_t>, EventId > MapFragmentsTimers_t;
 
   MapFragments_t       m_fragments; //!< Fragmented packets.
   Time                 m_fragmentExpirationTimeout; //!< Expiration timeout
-  MapFragmentsTimers_t m_fragmentsTimers; //!< Expiration events.
+  FragmentsTimeoutsList_t m_timeoutEventList; //!< Timeouts of the fragmented packets, oldest first.
+  EventId              m_timeoutEvent; //!< Event expiring the fragmented packets.
+  uint32_t             m_fragmentBufferSize; //!< Maximum number of bytes of fragments, 0 for no limit.
+  uint32_t             m_fragmentsBytes; //!< Number of bytes of fragments buffered.
 
 };
 
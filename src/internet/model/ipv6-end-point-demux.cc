@@ -18,6 +18,8 @@
  * Author: Sebastien Vincent <vincent@clarinet.u-strasbg.fr>
  */
 
+#include <algorithm>
+#include <vector>
 #include "ipv6-end-point-demux.h"
 #include "ipv6-end-point.h"
 #include "ns3/log.h"
@@ -26,10 +28,42 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Ipv6EndPointDemux");
 
+bool Ipv6EndPointDemux::ConnectionKey::operator== (const ConnectionKey &other) const
+{
+  return m_localPort == other.m_localPort && m_peerPort == other.m_peerPort
+         && m_localAddress == other.m_localAddress && m_peerAddress == other.m_peerAddress;
+}
+
+size_t Ipv6EndPointDemux::ConnectionKeyHash::operator() (const ConnectionKey &key) const
+{
+  Ipv6AddressHash hash;
+  size_t h = hash (key.m_peerAddress) * 2654435761U;
+  h ^= ((static_cast<uint32_t> (key.m_peerPort) << 16) | key.m_localPort) * 2246822519U;
+  h ^= hash (key.m_localAddress);
+  return h;
+}
+
+bool Ipv6EndPointDemux::ListenerKey::operator== (const ListenerKey &other) const
+{
+  return m_localPort == other.m_localPort && m_localAddress == other.m_localAddress;
+}
+
+size_t Ipv6EndPointDemux::ListenerKeyHash::operator() (const ListenerKey &key) const
+{
+  Ipv6AddressHash hash;
+  return hash (key.m_localAddress) ^ key.m_localPort;
+}
+
+bool Ipv6EndPointDemux::AllocatedBefore (Ipv6EndPoint *a, Ipv6EndPoint *b)
+{
+  return a->m_order < b->m_order;
+}
+
 Ipv6EndPointDemux::Ipv6EndPointDemux ()
   : m_ephemeral (49152),
     m_portFirst (49152),
-    m_portLast (65535)
+    m_portLast (65535),
+    m_nextOrder (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -37,34 +71,39 @@ Ipv6EndPointDemux::Ipv6EndPointDemux ()
 Ipv6EndPointDemux::~Ipv6EndPointDemux ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  for (OrderedEndPoints::iterator i = m_endPoints.begin (); i != m_endPoints.end (); i++)
     {
-      Ipv6EndPoint *endPoint = *i;
+      Ipv6EndPoint *endPoint = i->second;
+      endPoint->m_demux = 0;
       delete endPoint;
     }
   m_endPoints.clear ();
+  m_ports.clear ();
+  m_connections.clear ();
+  m_listeners.clear ();
 }
 
 bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
 {
   NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
-    {
-      if ((*i)->GetLocalPort  () == port)
-        {
-          return true;
-        }
-    }
-  return false;
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool Ipv6EndPointDemux::LookupLocal (Ipv6Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  if (Find (addr, port, Ipv6Address::GetAny (), 0) != 0)
+    {
+      return true;
+    }
+  std::map<uint16_t, OrderedEndPoints>::iterator it = m_ports.find (port);
+  if (it == m_ports.end ())
+    {
+      return false;
+    }
+  for (OrderedEndPoints::iterator i = it->second.begin (); i != it->second.end (); i++)
     {
-      if ((*i)->GetLocalPort () == port
-          && (*i)->GetLocalAddress () == addr)
+      if (i->second->GetLocalAddress () == addr)
         {
           return true;
         }
@@ -82,7 +121,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate ()
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (Ipv6Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -97,7 +136,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address)
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -118,7 +157,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address, uint16_t port)
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -127,21 +166,15 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address localAddress, uint16_t lo
                                            Ipv6Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  if (Find (localAddress, localPort, peerAddress, peerPort) != 0)
     {
-      if ((*i)->GetLocalPort () == localPort
-          && (*i)->GetLocalAddress () == localAddress
-          && (*i)->GetPeerPort () == peerPort
-          && (*i)->GetPeerAddress () == peerAddress)
-        {
-          NS_LOG_WARN ("No way we can allocate this end-point.");
-          /* no way we can allocate this end-point. */
-          return 0;
-        }
+      NS_LOG_WARN ("No way we can allocate this end-point.");
+      /* no way we can allocate this end-point. */
+      return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
 
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
 
@@ -151,15 +184,21 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address localAddress, uint16_t lo
 void Ipv6EndPointDemux::DeAllocate (Ipv6EndPoint *endPoint)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  if (endPoint->m_demux != this)
     {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
+      return;
+    }
+  RemoveFromIndex (endPoint);
+  std::map<uint16_t, OrderedEndPoints>::iterator it = m_ports.find (endPoint->GetLocalPort ());
+  NS_ASSERT (it != m_ports.end ());
+  it->second.erase (endPoint->m_order);
+  if (it->second.empty ())
+    {
+      m_ports.erase (it);
     }
+  m_endPoints.erase (endPoint->m_order);
+  endPoint->m_demux = 0;
+  delete endPoint;
 }
 
 /*
@@ -178,8 +217,44 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
   EndPoints retval3; /* Matches all but local address */
   EndPoints retval4; /* Exact match on all 4 */
 
+  /* Collect the endpoints whose local address is either the destination
+     address or the wildcard, and whose peer is either the source or a
+     (partial) wildcard. */
+  Ipv6Address localAddresses[2] = { daddr, Ipv6Address::GetAny () };
+  Ipv6Address peerAddresses[2] = { saddr, Ipv6Address::GetAny () };
+  uint16_t peerPorts[2] = { sport, 0 };
+  std::vector<Ipv6EndPoint *> candidates;
+  for (uint32_t l = 0; l < 2; l++)
+    {
+      if (l > 0 && localAddresses[l] == localAddresses[0])
+        {
+          continue;
+        }
+      for (uint32_t a = 0; a < 2; a++)
+        {
+          if (a > 0 && peerAddresses[a] == peerAddresses[0])
+            {
+              continue;
+            }
+          for (uint32_t p = 0; p < 2; p++)
+            {
+              if (p > 0 && peerPorts[p] == peerPorts[0])
+                {
+                  continue;
+                }
+              EndPoints *found = Find (localAddresses[l], dport, peerAddresses[a], peerPorts[p]);
+              if (found != 0)
+                {
+                  candidates.insert (candidates.end (), found->begin (), found->end ());
+                }
+            }
+        }
+    }
+  /* Report the matches in allocation order */
+  std::sort (candidates.begin (), candidates.end (), AllocatedBefore);
+
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  for (std::vector<Ipv6EndPoint *>::iterator i = candidates.begin (); i != candidates.end (); i++)
     {
       Ipv6EndPoint* endP = *i;
 
@@ -195,14 +270,7 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
           continue;
         }
 
-      if (endP->GetLocalPort () != dport)
-        {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                             << " because endpoint dport "
-                                             << endP->GetLocalPort ()
-                                             << " does not match packet dport " << dport);
-          continue;
-        }
+      NS_ASSERT (endP->GetLocalPort () == dport);
 
       if (endP->GetBoundNetDevice ())
         {
@@ -293,38 +361,38 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
 
 Ipv6EndPoint* Ipv6EndPointDemux::SimpleLookup (Ipv6Address dst, uint16_t dport, Ipv6Address src, uint16_t sport)
 {
+  EndPoints *exact = Find (dst, dport, src, sport);
+  if (exact != 0)
+    {
+      /* this is an exact match. */
+      return exact->front ();
+    }
+
+  std::map<uint16_t, OrderedEndPoints>::iterator it = m_ports.find (dport);
+  if (it == m_ports.end ())
+    {
+      return 0;
+    }
   uint32_t genericity = 3;
   Ipv6EndPoint *generic = 0;
 
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  for (OrderedEndPoints::iterator i = it->second.begin (); i != it->second.end (); i++)
     {
       uint32_t tmp = 0;
 
-      if ((*i)->GetLocalPort () != dport)
-        {
-          continue;
-        }
-
-      if ((*i)->GetLocalAddress () == dst && (*i)->GetPeerPort () == sport
-          && (*i)->GetPeerAddress () == src)
-        {
-          /* this is an exact match. */
-          return *i;
-        }
-
-      if ((*i)->GetLocalAddress () == Ipv6Address::GetAny ())
+      if (i->second->GetLocalAddress () == Ipv6Address::GetAny ())
         {
           tmp++;
         }
 
-      if ((*i)->GetPeerAddress () == Ipv6Address::GetAny ())
+      if (i->second->GetPeerAddress () == Ipv6Address::GetAny ())
         {
           tmp++;
         }
 
       if (tmp < genericity)
         {
-          generic = (*i);
+          generic = i->second;
           genericity = tmp;
         }
     }
@@ -355,8 +423,97 @@ uint16_t Ipv6EndPointDemux::AllocateEphemeralPort ()
 
 Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::GetEndPoints () const
 {
-  return m_endPoints;
+  EndPoints ret;
+  for (OrderedEndPoints::const_iterator i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+    {
+      ret.push_back (i->second);
+    }
+  return ret;
+}
+
+void Ipv6EndPointDemux::Insert (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  NS_ASSERT (endPoint->m_demux == 0);
+  endPoint->m_demux = this;
+  endPoint->m_order = m_nextOrder++;
+  m_endPoints[endPoint->m_order] = endPoint;
+  m_ports[endPoint->GetLocalPort ()][endPoint->m_order] = endPoint;
+  AddToIndex (endPoint);
 }
 
+void Ipv6EndPointDemux::AddToIndex (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  EndPoints *bucket;
+  if (endPoint->GetPeerAddress () == Ipv6Address::GetAny () && endPoint->GetPeerPort () == 0)
+    {
+      ListenerKey key = { endPoint->GetLocalAddress (), endPoint->GetLocalPort () };
+      bucket = &m_listeners[key];
+    }
+  else
+    {
+      ConnectionKey key = { endPoint->GetLocalAddress (), endPoint->GetLocalPort (),
+                            endPoint->GetPeerAddress (), endPoint->GetPeerPort () };
+      bucket = &m_connections[key];
+    }
+  // keep the bucket in allocation order
+  EndPointsI i = bucket->end ();
+  while (i != bucket->begin ())
+    {
+      EndPointsI prev = i;
+      --prev;
+      if ((*prev)->m_order < endPoint->m_order)
+        {
+          break;
+        }
+      i = prev;
+    }
+  bucket->insert (i, endPoint);
+}
+
+void Ipv6EndPointDemux::RemoveFromIndex (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  if (endPoint->GetPeerAddress () == Ipv6Address::GetAny () && endPoint->GetPeerPort () == 0)
+    {
+      ListenerKey key = { endPoint->GetLocalAddress (), endPoint->GetLocalPort () };
+      ListenerMap::iterator it = m_listeners.find (key);
+      NS_ASSERT (it != m_listeners.end ());
+      it->second.remove (endPoint);
+      if (it->second.empty ())
+        {
+          m_listeners.erase (it);
+        }
+    }
+  else
+    {
+      ConnectionKey key = { endPoint->GetLocalAddress (), endPoint->GetLocalPort (),
+                            endPoint->GetPeerAddress (), endPoint->GetPeerPort () };
+      ConnectionMap::iterator it = m_connections.find (key);
+      NS_ASSERT (it != m_connections.end ());
+      it->second.remove (endPoint);
+      if (it->second.empty ())
+        {
+          m_connections.erase (it);
+        }
+    }
+}
+
+Ipv6EndPointDemux::EndPoints* Ipv6EndPointDemux::Find (Ipv6Address localAddress, uint16_t localPort,
+                         Ipv6Address peerAddress, uint16_t peerPort)
+{
+  if (peerAddress == Ipv6Address::GetAny () && peerPort == 0)
+    {
+      ListenerKey key = { localAddress, localPort };
+      ListenerMap::iterator it = m_listeners.find (key);
+      return it == m_listeners.end () ? 0 : &it->second;
+    }
+  ConnectionKey key = { localAddress, localPort, peerAddress, peerPort };
+  ConnectionMap::iterator it = m_connections.find (key);
+  return it == m_connections.end () ? 0 : &it->second;
+}
+
+
 } /* namespace ns3 */
 
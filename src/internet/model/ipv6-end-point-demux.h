@@ -23,7 +23,9 @@
 
 #include <stdint.h>
 #include <list>
+#include <map>
 #include "ns3/ipv6-address.h"
+#include "ns3/sgi-hashmap.h"
 #include "ipv6-interface.h"
 
 namespace ns3 {
@@ -34,6 +36,12 @@ class Ipv6EndPoint;
  * \ingroup ipv6
  *
  * \brief Demultiplexer for end points.
+ *
+ * The endpoints are indexed by two hash tables: endpoints with a peer are
+ * indexed by their four-tuple, while the endpoints without a peer are
+ * indexed by their local address and port. A lookup only probes the entries
+ * which may match the incoming packet, so its cost does not depend on the
+ * number of endpoints.
  */
 class Ipv6EndPointDemux
 {
@@ -147,6 +155,108 @@ public:
   EndPoints GetEndPoints () const;
 
 private:
+  friend class Ipv6EndPoint;
+
+  /**
+   * \brief Key of the endpoints with a peer.
+   */
+  struct ConnectionKey
+  {
+    Ipv6Address m_localAddress; //!< local address
+    uint16_t m_localPort;       //!< local port
+    Ipv6Address m_peerAddress;  //!< peer address
+    uint16_t m_peerPort;        //!< peer port
+
+    /**
+     * \param other the key to compare
+     * \returns true if the keys are equal
+     */
+    bool operator== (const ConnectionKey &other) const;
+  };
+
+  /**
+   * \brief Hash function of a ConnectionKey.
+   */
+  struct ConnectionKeyHash
+  {
+    /**
+     * \param key the key
+     * \returns the hash of the key
+     */
+    size_t operator() (const ConnectionKey &key) const;
+  };
+
+  /**
+   * \brief Key of the endpoints without a peer.
+   */
+  struct ListenerKey
+  {
+    Ipv6Address m_localAddress; //!< local address
+    uint16_t m_localPort;       //!< local port
+
+    /**
+     * \param other the key to compare
+     * \returns true if the keys are equal
+     */
+    bool operator== (const ListenerKey &other) const;
+  };
+
+  /**
+   * \brief Hash function of a ListenerKey.
+   */
+  struct ListenerKeyHash
+  {
+    /**
+     * \param key the key
+     * \returns the hash of the key
+     */
+    size_t operator() (const ListenerKey &key) const;
+  };
+
+  /// Endpoints sorted by allocation order
+  typedef std::map<uint64_t, Ipv6EndPoint *> OrderedEndPoints;
+  /// Endpoints with a peer, by four-tuple
+  typedef sgi::hash_map<ConnectionKey, EndPoints, ConnectionKeyHash> ConnectionMap;
+  /// Endpoints without a peer, by local address and port
+  typedef sgi::hash_map<ListenerKey, EndPoints, ListenerKeyHash> ListenerMap;
+
+  /**
+   * \brief Compare the allocation order of two endpoints.
+   * \param a an endpoint
+   * \param b another endpoint
+   * \returns true if a was allocated before b
+   */
+  static bool AllocatedBefore (Ipv6EndPoint *a, Ipv6EndPoint *b);
+
+  /**
+   * \brief Register a new endpoint.
+   * \param endPoint the endpoint
+   */
+  void Insert (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Add an endpoint to the hash table matching its current addresses.
+   * \param endPoint the endpoint
+   */
+  void AddToIndex (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Remove an endpoint from the hash table matching its current addresses.
+   * \param endPoint the endpoint
+   */
+  void RemoveFromIndex (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Find the endpoints with exactly the given addresses and ports.
+   * \param localAddress local address
+   * \param localPort local port
+   * \param peerAddress peer address
+   * \param peerPort peer port
+   * \returns the endpoints, or 0 if there is none
+   */
+  EndPoints *Find (Ipv6Address localAddress, uint16_t localPort,
+                   Ipv6Address peerAddress, uint16_t peerPort);
+
   /**
    * \brief Allocate a ephemeral port.
    * \return a port
@@ -169,9 +279,29 @@ private:
   uint16_t m_portLast;
 
   /**
-   * \brief A list of IPv6 end points.
+   * \brief The allocation order of the next end point.
+   */
+  uint64_t m_nextOrder;
+
+  /**
+   * \brief The IPv6 end points, in allocation order.
+   */
+  OrderedEndPoints m_endPoints;
+
+  /**
+   * \brief The IPv6 end points, by local port and allocation order.
+   */
+  std::map<uint16_t, OrderedEndPoints> m_ports;
+
+  /**
+   * \brief The IPv6 end points with a peer.
+   */
+  ConnectionMap m_connections;
+
+  /**
+   * \brief The IPv6 end points without a peer.
    */
-  EndPoints m_endPoints;
+  ListenerMap m_listeners;
 };
 
 } /* namespace ns3 */
@@ -34,6 +34,7 @@ namespace ns3
 
 class Header;
 class Packet;
+class Ipv6EndPointDemux;
 
 /**
  * \ingroup ipv6
@@ -192,6 +193,8 @@ public:
   bool IsRxEnabled (void);
 
 private:
+  friend class Ipv6EndPointDemux;
+
   /**
    * \brief The local address.
    */
@@ -236,6 +239,16 @@ private:
    * \brief true if the endpoint can receive packets.
    */
   bool m_rxEnabled;
+
+  /**
+   * \brief The demux holding the endpoint (if any), which indexes it by its addresses.
+   */
+  Ipv6EndPointDemux *m_demux;
+
+  /**
+   * \brief The allocation order of the endpoint in its demux.
+   */
+  uint64_t m_order;
 };
 
 } /* namespace ns3 */
@@ -19,6 +19,7 @@
  */
 
 #include <list>
+#include <vector>
 #include <ctime>
 
 #include "ns3/log.h"
@@ -315,11 +316,19 @@ TypeId Ipv6ExtensionFragment::GetTypeId ()
     .SetParent<Ipv6Extension> ()
     .SetGroupName ("Internet")
     .AddConstructor<Ipv6ExtensionFragment> ()
+    .AddAttribute ("FragmentBufferSize",
+                   "The maximum number of bytes of fragments buffered for "
+                   "reassembly, 0 for no limit. When it is exceeded, the "
+                   "oldest fragmented packets are dropped.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&Ipv6ExtensionFragment::m_fragmentBufferSize),
+                   MakeUintegerChecker<uint32_t> ())
   ;
   return tid;
 }
 
 Ipv6ExtensionFragment::Ipv6ExtensionFragment ()
+  : m_fragmentsBytes (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -339,6 +348,12 @@ void Ipv6ExtensionFragment::DoDispose ()
     }
 
   m_fragments.clear ();
+  m_timeoutEventList.clear ();
+  m_fragmentsBytes = 0;
+  if (m_timeoutEvent.IsRunning ())
+    {
+      m_timeoutEvent.Cancel ();
+    }
   Ipv6Extension::DoDispose ();
 }
 
@@ -387,16 +402,14 @@ uint8_t Ipv6ExtensionFragment::Process (Ptr<Packet>& packet,
     {
       fragments = Create<Fragments> ();
       m_fragments.insert (std::make_pair (fragmentsId, fragments));
-      EventId timeout = Simulator::Schedule (Seconds (60),
-                                             &Ipv6ExtensionFragment::HandleFragmentsTimeout, this,
-                                             fragmentsId, ipHeader);
-      fragments->SetTimeoutEventId (timeout);
+      fragments->SetTimeoutIter (SetTimeout (fragmentsId, ipHeader));
     }
   else
     {
       fragments = it->second;
     }
 
+  uint32_t size = fragments->GetSize ();
   if (fragmentOffset == 0)
     {
       Ptr<Packet> unfragmentablePart = packet->Copy ();
@@ -405,16 +418,23 @@ uint8_t Ipv6ExtensionFragment::Process (Ptr<Packet>& packet,
     }
 
   fragments->AddFragment (p, fragmentOffset, moreFragment);
+  m_fragmentsBytes += fragments->GetSize () - size;
 
   if (fragments->IsEntire ())
     {
       packet = fragments->GetPacket ();
-      fragments->CancelTimeout ();
+      m_fragmentsBytes -= fragments->GetSize ();
+      // the timeout event is left running: it finds nothing to expire
+      m_timeoutEventList.erase (fragments->GetTimeoutIter ());
       m_fragments.erase (fragmentsId);
       stopProcessing = false;
     }
   else
     {
+      if (m_fragmentBufferSize > 0 && m_fragmentsBytes > m_fragmentBufferSize)
+        {
+          EvictFragments ();
+        }
       stopProcessing = true;
     }
 
@@ -618,11 +638,70 @@ void Ipv6ExtensionFragment::HandleFragmentsTimeout (std::pair<Ipv6Address, uint3
   ipL3->ReportDrop (ipHeader, packet, Ipv6L3Protocol::DROP_FRAGMENT_TIMEOUT);
 
   // clear the buffers
+  m_fragmentsBytes -= fragments->GetSize ();
   m_fragments.erase (fragmentsId);
 }
 
+Ipv6ExtensionFragment::FragmentsTimeoutsListI_t Ipv6ExtensionFragment::SetTimeout (FragmentKey_t key, Ipv6Header ipHeader)
+{
+  NS_LOG_FUNCTION (this << &key << ipHeader);
+
+  // the timeouts all have the same duration, so the list is sorted by
+  // expiration time, and the event expires the first one
+  Time expiration = Simulator::Now () + Seconds (60);
+  if (!m_timeoutEvent.IsRunning ())
+    {
+      m_timeoutEvent = Simulator::Schedule (Seconds (60), &Ipv6ExtensionFragment::HandleTimeout, this);
+    }
+  m_timeoutEventList.push_back (std::make_tuple (expiration, key, ipHeader));
+  return --m_timeoutEventList.end ();
+}
+
+void Ipv6ExtensionFragment::HandleTimeout (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Time now = Simulator::Now ();
+  while (!m_timeoutEventList.empty () && std::get<0> (m_timeoutEventList.front ()) <= now)
+    {
+      FragmentKey_t key = std::get<1> (m_timeoutEventList.front ());
+      Ipv6Header ipHeader = std::get<2> (m_timeoutEventList.front ());
+      m_timeoutEventList.pop_front ();
+      HandleFragmentsTimeout (key, ipHeader);
+    }
+
+  if (!m_timeoutEventList.empty ())
+    {
+      Time delay = std::get<0> (m_timeoutEventList.front ()) - now;
+      m_timeoutEvent = Simulator::Schedule (delay, &Ipv6ExtensionFragment::HandleTimeout, this);
+    }
+}
+
+void Ipv6ExtensionFragment::EvictFragments (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Ptr<Ipv6L3Protocol> ipL3 = GetNode ()->GetObject<Ipv6L3Protocol> ();
+  while (m_fragmentsBytes > m_fragmentBufferSize && !m_timeoutEventList.empty ())
+    {
+      FragmentKey_t key = std::get<1> (m_timeoutEventList.front ());
+      Ipv6Header ipHeader = std::get<2> (m_timeoutEventList.front ());
+      m_timeoutEventList.pop_front ();
+
+      MapFragments_t::iterator it = m_fragments.find (key);
+      NS_LOG_LOGIC ("Evicting fragmented packet of " << it->second->GetSize () << " bytes, " <<
+                    m_fragmentsBytes << " bytes buffered");
+      m_fragmentsBytes -= it->second->GetSize ();
+      ipL3->ReportDrop (ipHeader, it->second->GetPartialPacket (), Ipv6L3Protocol::DROP_FRAGMENT_TIMEOUT);
+      m_fragments.erase (it);
+    }
+}
+
 Ipv6ExtensionFragment::Fragments::Fragments ()
-  : m_moreFragment (0)
+  : m_moreFragment (0),
+    m_lastOffset (-1),
+    m_overlap (false),
+    m_size (0)
 {
 }
 
@@ -632,22 +711,51 @@ Ipv6ExtensionFragment::Fragments::~Fragments ()
 
 void Ipv6ExtensionFragment::Fragments::AddFragment (Ptr<Packet> fragment, uint16_t fragmentOffset, bool moreFragment)
 {
-  std::list<std::pair<Ptr<Packet>, uint16_t> >::iterator it;
+  if (int32_t (fragmentOffset) >= m_lastOffset)
+    {
+      m_lastOffset = fragmentOffset;
+      m_moreFragment = moreFragment;
+    }
+
+  uint32_t start = fragmentOffset;
+  uint32_t end = start + fragment->GetSize ();
 
-  for (it = m_packetFragments.begin (); it != m_packetFragments.end (); it++)
+  // only the bytes which fill the holes between the intervals already
+  // received are kept, and an overlap prevents the reassembly
+  uint32_t intervalStart = start;
+  uint32_t intervalEnd = end;
+  uint32_t position = start;
+  std::map<uint32_t, uint32_t>::iterator it = m_intervals.upper_bound (start);
+  if (it != m_intervals.begin ())
     {
-      if (it->second > fragmentOffset)
+      std::map<uint32_t, uint32_t>::iterator previous = it;
+      previous--;
+      if (previous->second >= start)
         {
-          break;
+          m_overlap = m_overlap || previous->second > start;
+          intervalStart = previous->first;
+          intervalEnd = std::max (end, previous->second);
+          position = std::max (start, previous->second);
+          m_intervals.erase (previous);
         }
     }
-
-  if (it == m_packetFragments.end ())
+  for ( ; it != m_intervals.end () && it->first <= end; m_intervals.erase (it++))
     {
-      m_moreFragment = moreFragment;
+      m_overlap = m_overlap || it->first < end;
+      if (it->first > position)
+        {
+          m_packetFragments[position] = fragment->CreateFragment (position - start, it->first - position);
+          m_size += it->first - position;
+        }
+      position = it->second;
+      intervalEnd = std::max (intervalEnd, it->second);
     }
-
-  m_packetFragments.insert (it, std::pair<Ptr<Packet>, uint16_t> (fragment, fragmentOffset));
+  if (position < end)
+    {
+      m_packetFragments[position] = (position == start) ? fragment : fragment->CreateFragment (position - start, end - position);
+      m_size += end - position;
+    }
+  m_intervals[intervalStart] = intervalEnd;
 }
 
 void Ipv6ExtensionFragment::Fragments::SetUnfragmentablePart (Ptr<Packet> unfragmentablePart)
@@ -657,77 +765,65 @@ void Ipv6ExtensionFragment::Fragments::SetUnfragmentablePart (Ptr<Packet> unfrag
 
 bool Ipv6ExtensionFragment::Fragments::IsEntire () const
 {
-  bool ret = !m_moreFragment && m_packetFragments.size () > 0;
-
-  if (ret)
-    {
-      uint16_t lastEndOffset = 0;
-
-      for (std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_packetFragments.begin (); it != m_packetFragments.end (); it++)
-        {
-          if (lastEndOffset != it->second)
-            {
-              ret = false;
-              break;
-            }
-
-          lastEndOffset += it->first->GetSize ();
-        }
-    }
-
-  return ret;
+  return !m_moreFragment && !m_overlap && m_intervals.size () == 1 && m_intervals.begin ()->first == 0;
 }
 
 Ptr<Packet> Ipv6ExtensionFragment::Fragments::GetPacket () const
 {
   Ptr<Packet> p =  m_unfragmentable->Copy ();
-
-  for (std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_packetFragments.begin (); it != m_packetFragments.end (); it++)
-    {
-      p->AddAtEnd (it->first);
-    }
-
+  p->AddAtEnd (Assemble (m_intervals.begin ()->second));
   return p;
 }
 
 Ptr<Packet> Ipv6ExtensionFragment::Fragments::GetPartialPacket () const
 {
-  Ptr<Packet> p;
-
-  if ( m_unfragmentable )
+  if (!m_unfragmentable)
     {
-      p = m_unfragmentable->Copy ();
+      return Create<Packet> ();
     }
-  else
+
+  Ptr<Packet> p = m_unfragmentable->Copy ();
+  if (!m_intervals.empty () && m_intervals.begin ()->first == 0)
     {
-      return p;
+      p->AddAtEnd (Assemble (m_intervals.begin ()->second));
     }
+  return p;
+}
 
-  uint16_t lastEndOffset = 0;
-
-  for (std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_packetFragments.begin (); it != m_packetFragments.end (); it++)
+Ptr<Packet> Ipv6ExtensionFragment::Fragments::Assemble (uint32_t end) const
+{
+  // the fragments are merged pairwise, so that each byte is copied a
+  // logarithmic number of times
+  std::vector<Ptr<Packet> > parts;
+  for (std::map<uint32_t, Ptr<Packet> >::const_iterator it = m_packetFragments.begin ();
+       it != m_packetFragments.end () && it->first < end; it++)
+    {
+      parts.push_back (it->second->Copy ());
+    }
+  for (uint32_t step = 1; step < parts.size (); step *= 2)
     {
-      if (lastEndOffset != it->second)
+      for (uint32_t i = 0; i + step < parts.size (); i += 2 * step)
         {
-          break;
+          parts[i]->AddAtEnd (parts[i + step]);
         }
-      p->AddAtEnd (it->first);
-      lastEndOffset += it->first->GetSize ();
     }
+  return parts.empty () ? Create<Packet> () : parts.front ();
+}
 
-  return p;
+uint32_t Ipv6ExtensionFragment::Fragments::GetSize () const
+{
+  return m_size + (m_unfragmentable ? m_unfragmentable->GetSize () : 0);
 }
 
-void Ipv6ExtensionFragment::Fragments::SetTimeoutEventId (EventId event)
+void Ipv6ExtensionFragment::Fragments::SetTimeoutIter (FragmentsTimeoutsListI_t iter)
 {
-  m_timeoutEventId = event;
+  m_timeoutIter = iter;
   return;
 }
 
-void Ipv6ExtensionFragment::Fragments::CancelTimeout ()
+Ipv6ExtensionFragment::FragmentsTimeoutsListI_t Ipv6ExtensionFragment::Fragments::GetTimeoutIter ()
 {
-  m_timeoutEventId.Cancel ();
-  return;
+  return m_timeoutIter;
 }
 
 
@@ -23,6 +23,7 @@
 
 #include <map>
 #include <list>
+#include <tuple>
 
 #include "ns3/object.h"
 #include "ns3/node.h"
@@ -316,10 +317,24 @@ protected:
   virtual void DoDispose ();
 
 private:
+  /**
+   * \brief Key identifying a fragmented packet: source address and identification.
+   */
+  typedef std::pair<Ipv6Address, uint32_t> FragmentKey_t;
+
+  /// Container for fragment timeouts.
+  typedef std::list< std::tuple <Time, FragmentKey_t, Ipv6Header > > FragmentsTimeoutsList_t;
+  /// Container Iterator for fragment timeouts.
+  typedef std::list< std::tuple <Time, FragmentKey_t, Ipv6Header > >::iterator FragmentsTimeoutsListI_t;
+
   /**
    * \ingroup ipv6HeaderExt
    *
    * \brief This class stores the fragments of a packet waiting to be rebuilt.
+   *
+   * The parts of the fragments which overlap the bytes already received are
+   * discarded, and the intervals received so far are coalesced. The packet
+   * is assembled only once, when it is entire.
    */
   class Fragments : public SimpleRefCount<Fragments>
   {
@@ -367,26 +382,60 @@ public:
     Ptr<Packet> GetPartialPacket () const;
 
     /**
-     * \brief Set the Timeout EventId.
-     * \param event The event.
+     * \brief Get the number of bytes buffered, unfragmentable part included.
+     * \return the number of bytes
+     */
+    uint32_t GetSize () const;
+
+    /**
+     * \brief Set the Timeout iterator.
+     * \param iter The iterator.
      */
-    void SetTimeoutEventId (EventId event);
+    void SetTimeoutIter (FragmentsTimeoutsListI_t iter);
 
     /**
-     * \brief Cancel the timeout event
+     * \brief Get the Timeout iterator.
+     * \returns The iterator.
      */
-    void CancelTimeout ();
+    FragmentsTimeoutsListI_t GetTimeoutIter ();
 
 private:
+    /**
+     * \brief Assemble the fragments which start before an offset.
+     * \param end the offset
+     * \return the packet, without the unfragmentable part
+     */
+    Ptr<Packet> Assemble (uint32_t end) const;
+
     /**
      * \brief If other fragments will be sent.
      */
     bool m_moreFragment;
 
     /**
-     * \brief The current fragments.
+     * \brief The offset of the last fragment, or -1 if none has been added.
+     */
+    int32_t m_lastOffset;
+
+    /**
+     * \brief True if two fragments overlapped (RFC 5722).
+     */
+    bool m_overlap;
+
+    /**
+     * \brief The current fragments, without overlaps, indexed by offset.
+     */
+    std::map<uint32_t, Ptr<Packet> > m_packetFragments;
+
+    /**
+     * \brief The intervals received: end offset indexed by start offset.
+     */
+    std::map<uint32_t, uint32_t> m_intervals;
+
+    /**
+     * \brief The number of bytes of the current fragments.
      */
-    std::list<std::pair<Ptr<Packet>, uint16_t> > m_packetFragments;
+    uint32_t m_size;
 
     /**
      * \brief The unfragmentable part.
@@ -394,9 +443,9 @@ private:
     Ptr<Packet> m_unfragmentable;
 
     /**
-     * \brief Timeout handler event
+     * \brief Timeout iterator to "event" handler
      */
-    EventId m_timeoutEventId;
+    FragmentsTimeoutsListI_t m_timeoutIter;
   };
 
   /**
@@ -407,31 +456,38 @@ private:
   void HandleFragmentsTimeout (std::pair<Ipv6Address, uint32_t> key, Ipv6Header ipHeader);
 
   /**
-   * \brief Get the packet parts so far received.
-   * \return the partial packet
+   * \brief Set a new timeout "event" for a fragmented packet
+   * \param key the fragment identification
+   * \param ipHeader the IPv6 header of the fragmented packet
+   * \return an iterator to the inserted "event"
    */
-  Ptr<Packet> GetPartialPacket () const;
+  FragmentsTimeoutsListI_t SetTimeout (FragmentKey_t key, Ipv6Header ipHeader);
 
   /**
-   * \brief Set the Timeout EventId.
-   * \param event The event.
+   * \brief Handles a fragmented packet timeout
    */
-  void SetTimeoutEventId (EventId event);
+  void HandleTimeout (void);
 
   /**
-   * \brief Cancel the timeout event
+   * \brief Drop the oldest fragmented packets until the buffered bytes fit
+   * the FragmentBufferSize attribute.
    */
-  void CancelTimeout ();
+  void EvictFragments (void);
 
   /**
    * \brief Container for the packet fragments.
    */
-  typedef std::map<std::pair<Ipv6Address, uint32_t>, Ptr<Fragments> > MapFragments_t;
+  typedef std::map<FragmentKey_t, Ptr<Fragments> > MapFragments_t;
 
   /**
    * \brief The hash of fragmented packets.
    */
   MapFragments_t m_fragments;
+
+  FragmentsTimeoutsList_t m_timeoutEventList;  //!< Timeout "events" container, sorted by expiration time
+  EventId m_timeoutEvent;  //!< Event for the next scheduled timeout
+  uint32_t m_fragmentBufferSize;  //!< Maximum number of bytes of fragments buffered, 0 for no limit
+  uint32_t m_fragmentsBytes;  //!< Number of bytes of fragments buffered
 };
 
 /**
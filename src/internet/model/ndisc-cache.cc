@@ -64,6 +64,7 @@ void NdiscCache::DoDispose ()
 {
   NS_LOG_FUNCTION_NOARGS ();
   Flush ();
+  m_nudEvent.Cancel ();
   m_device = 0;
   m_interface = 0;
   Object::DoDispose ();
@@ -105,9 +106,10 @@ std::list<NdiscCache::Entry*> NdiscCache::LookupInverse (Address dst)
   NS_LOG_FUNCTION (this << dst);
 
   std::list<NdiscCache::Entry *> entryList;
-  for (CacheI i = m_ndCache.begin (); i != m_ndCache.end (); i++)
+  std::pair<MacIndexI, MacIndexI> range = m_macIndex.equal_range (AddressHash () (dst));
+  for (MacIndexI i = range.first; i != range.second; i++)
     {
-      NdiscCache::Entry *entry = (*i).second;
+      NdiscCache::Entry *entry = i->second;
       if (entry->GetMacAddress () == dst)
         {
           entryList.push_back (entry);
@@ -132,6 +134,15 @@ void NdiscCache::Remove (NdiscCache::Entry* entry)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
+  CacheI it = m_ndCache.find (entry->GetIpv6Address ());
+  if (it != m_ndCache.end () && it->second == entry)
+    {
+      m_ndCache.erase (it);
+      entry->ClearWaitingPacket ();
+      delete entry;
+      return;
+    }
+  /* the address of the entry may have been changed after it was added */
   for (CacheI i = m_ndCache.begin (); i != m_ndCache.end (); i++)
     {
       if ((*i).second == entry)
@@ -154,6 +165,43 @@ void NdiscCache::Flush ()
     }
 
   m_ndCache.erase (m_ndCache.begin (), m_ndCache.end ());
+  NS_ASSERT (m_macIndex.empty () && m_nudTimers.empty ());
+}
+
+void NdiscCache::ScheduleNudEvent ()
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_nudTimers.empty ())
+    {
+      return;
+    }
+  /* an event which expires before the first timer is kept: the timers which
+   * are cancelled or restarted do not reschedule it, it just finds nothing
+   * to do when it expires */
+  Time first = m_nudTimers.begin ()->first;
+  if (m_nudEvent.IsRunning () && m_nudEventTime <= first)
+    {
+      return;
+    }
+  m_nudEvent.Cancel ();
+  m_nudEventTime = first;
+  m_nudEvent = Simulator::Schedule (first - Simulator::Now (), &NdiscCache::HandleNudTimeouts, this);
+}
+
+void NdiscCache::HandleNudTimeouts ()
+{
+  NS_LOG_FUNCTION (this);
+
+  /* the expiration of a timer may restart it, or remove any entry, so the
+   * first timer is looked up again after each expiration */
+  while (!m_nudTimers.empty () && m_nudTimers.begin ()->first <= Simulator::Now ())
+    {
+      NdiscCache::Entry *entry = m_nudTimers.begin ()->second;
+      m_nudTimers.erase (m_nudTimers.begin ());
+      entry->ExpireNudTimer ();
+    }
+  ScheduleNudEvent ();
 }
 
 void NdiscCache::SetUnresQlen (uint32_t unresQlen)
@@ -223,11 +271,20 @@ NdiscCache::Entry::Entry (NdiscCache* nd)
   : m_ndCache (nd),
     m_waiting (),
     m_router (false),
-    m_nudTimer (Timer::CANCEL_ON_DESTROY),
+    m_nudFunction (0),
+    m_nudTimerRunning (false),
     m_lastReachabilityConfirmation (Seconds (0.0)),
     m_nsRetransmit (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
+  m_macIndexIt = m_ndCache->m_macIndex.insert (std::make_pair (AddressHash () (m_macAddress), this));
+}
+
+NdiscCache::Entry::~Entry ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  CancelNudTimer ();
+  m_ndCache->m_macIndex.erase (m_macIndexIt);
 }
 
 void NdiscCache::Entry::SetRouter (bool router)
@@ -408,24 +465,52 @@ void NdiscCache::Entry::SetIpv6Address (Ipv6Address ipv6Address)
   m_ipv6Address = ipv6Address;
 }
 
+Ipv6Address NdiscCache::Entry::GetIpv6Address () const
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return m_ipv6Address;
+}
+
 Time NdiscCache::Entry::GetLastReachabilityConfirmation () const
 {
   NS_LOG_FUNCTION_NOARGS ();
   return m_lastReachabilityConfirmation;
 }
 
-void NdiscCache::Entry::StartReachableTimer ()
+void NdiscCache::Entry::ExpireNudTimer ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  m_nudTimerRunning = false;
+  (this->*m_nudFunction)();
+}
+
+void NdiscCache::Entry::ScheduleNudTimer (void (NdiscCache::Entry::*function)(), Time delay)
+{
+  NS_LOG_FUNCTION (this << delay);
+  NS_ASSERT (function != 0);
+  CancelNudTimer ();
+  m_nudFunction = function;
+  m_nudDelay = delay;
+  m_nudTimerIt = m_ndCache->m_nudTimers.insert (std::make_pair (Simulator::Now () + delay, this));
+  m_nudTimerRunning = true;
+  m_ndCache->ScheduleNudEvent ();
+}
+
+void NdiscCache::Entry::CancelNudTimer ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  if (m_nudTimer.IsRunning ())
+  if (m_nudTimerRunning)
     {
-      m_nudTimer.Cancel ();
+      m_ndCache->m_nudTimers.erase (m_nudTimerIt);
+      m_nudTimerRunning = false;
     }
+}
 
+void NdiscCache::Entry::StartReachableTimer ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
   m_lastReachabilityConfirmation = Simulator::Now ();
-  m_nudTimer.SetFunction (&NdiscCache::Entry::FunctionReachableTimeout, this);
-  m_nudTimer.SetDelay (MilliSeconds (Icmpv6L4Protocol::REACHABLE_TIME));
-  m_nudTimer.Schedule ();
+  ScheduleNudTimer (&NdiscCache::Entry::FunctionReachableTimeout, MilliSeconds (Icmpv6L4Protocol::REACHABLE_TIME));
 }
 
 void NdiscCache::Entry::UpdateReachableTimer ()
@@ -435,54 +520,32 @@ void NdiscCache::Entry::UpdateReachableTimer ()
   if (m_state == REACHABLE)
     {
       m_lastReachabilityConfirmation = Simulator::Now ();
-      if (m_nudTimer.IsRunning ())
-        {
-          m_nudTimer.Cancel ();
-        }
-      m_nudTimer.Schedule ();
+      ScheduleNudTimer (m_nudFunction, m_nudDelay);
     }
 }
 
 void NdiscCache::Entry::StartProbeTimer ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  if (m_nudTimer.IsRunning ())
-    {
-      m_nudTimer.Cancel ();
-    }
-  m_nudTimer.SetFunction (&NdiscCache::Entry::FunctionProbeTimeout, this);
-  m_nudTimer.SetDelay (MilliSeconds (Icmpv6L4Protocol::RETRANS_TIMER));
-  m_nudTimer.Schedule ();
+  ScheduleNudTimer (&NdiscCache::Entry::FunctionProbeTimeout, MilliSeconds (Icmpv6L4Protocol::RETRANS_TIMER));
 }
 
 void NdiscCache::Entry::StartDelayTimer ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  if (m_nudTimer.IsRunning ())
-    {
-      m_nudTimer.Cancel ();
-    }
-  m_nudTimer.SetFunction (&NdiscCache::Entry::FunctionDelayTimeout, this);
-  m_nudTimer.SetDelay (Seconds (Icmpv6L4Protocol::DELAY_FIRST_PROBE_TIME));
-  m_nudTimer.Schedule ();
+  ScheduleNudTimer (&NdiscCache::Entry::FunctionDelayTimeout, Seconds (Icmpv6L4Protocol::DELAY_FIRST_PROBE_TIME));
 }
 
 void NdiscCache::Entry::StartRetransmitTimer ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  if (m_nudTimer.IsRunning ())
-    {
-      m_nudTimer.Cancel ();
-    }
-  m_nudTimer.SetFunction (&NdiscCache::Entry::FunctionRetransmitTimeout, this);
-  m_nudTimer.SetDelay (MilliSeconds (Icmpv6L4Protocol::RETRANS_TIMER));
-  m_nudTimer.Schedule ();
+  ScheduleNudTimer (&NdiscCache::Entry::FunctionRetransmitTimeout, MilliSeconds (Icmpv6L4Protocol::RETRANS_TIMER));
 }
 
 void NdiscCache::Entry::StopNudTimer ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  m_nudTimer.Cancel ();
+  CancelNudTimer ();
   m_nsRetransmit = 0;
 }
 
@@ -501,7 +564,7 @@ std::list<NdiscCache::Ipv6PayloadHeaderPair> NdiscCache::Entry::MarkReachable (A
 {
   NS_LOG_FUNCTION (this << mac);
   m_state = REACHABLE;
-  m_macAddress = mac;
+  IndexMacAddress (mac);
   return m_waiting;
 }
 
@@ -527,7 +590,7 @@ std::list<NdiscCache::Ipv6PayloadHeaderPair> NdiscCache::Entry::MarkStale (Addre
 {
   NS_LOG_FUNCTION (this << mac);
   m_state = STALE;
-  m_macAddress = mac;
+  IndexMacAddress (mac);
   return m_waiting;
 }
 
@@ -589,6 +652,18 @@ Address NdiscCache::Entry::GetMacAddress () const
 void NdiscCache::Entry::SetMacAddress (Address mac)
 {
   NS_LOG_FUNCTION (this << mac << int(m_state));
+  IndexMacAddress (mac);
+}
+
+void NdiscCache::Entry::IndexMacAddress (Address mac)
+{
+  NS_LOG_FUNCTION (this << mac);
+  size_t hash = AddressHash () (mac);
+  if (hash != m_macIndexIt->first)
+    {
+      m_ndCache->m_macIndex.erase (m_macIndexIt);
+      m_macIndexIt = m_ndCache->m_macIndex.insert (std::make_pair (hash, this));
+    }
   m_macAddress = mac;
 }
 
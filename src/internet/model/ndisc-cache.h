@@ -23,13 +23,14 @@
 
 #include <stdint.h>
 #include <list>
+#include <map>
 
 #include "ns3/packet.h"
 #include "ns3/nstime.h"
 #include "ns3/net-device.h"
 #include "ns3/ipv6-address.h"
 #include "ns3/ptr.h"
-#include "ns3/timer.h"
+#include "ns3/simulator.h"
 #include "ns3/sgi-hashmap.h"
 #include "ns3/output-stream-wrapper.h"
 
@@ -92,6 +93,10 @@ public:
 
   /**
    * \brief Lookup in the cache for a MAC address.
+   *
+   * The entries are indexed by MAC address, so that the cost of the lookup
+   * does not depend on the size of the cache.
+   *
    * \param dst destination MAC address.
    * \return a list of matching entries.
    */
@@ -160,6 +165,11 @@ public:
      */
     Entry (NdiscCache* nd);
 
+    /**
+     * \brief Destructor.
+     */
+    ~Entry ();
+
     /**
      * \brief Changes the state to this entry to INCOMPLETE.
      * \param p packet that wait to be sent
@@ -334,13 +344,44 @@ public:
      */
     void FunctionDelayTimeout ();
 
+    /**
+     * \brief Function called by the NdiscCache when the NUD timer expires.
+     * It calls the function of the timer that was started last.
+     */
+    void ExpireNudTimer ();
+
     /**
      * \brief Set the IPv6 address.
      * \param ipv6Address IPv6 address
      */
     void SetIpv6Address (Ipv6Address ipv6Address);
 
+    /**
+     * \brief Get the IPv6 address.
+     * \return the IPv6 address
+     */
+    Ipv6Address GetIpv6Address () const;
+
 private:
+    /**
+     * \brief Start the NUD timer, replacing the one which may be running.
+     * \param function the function to call when the timer expires.
+     * \param delay the delay of the timer.
+     */
+    void ScheduleNudTimer (void (NdiscCache::Entry::*function)(), Time delay);
+
+    /**
+     * \brief Cancel the NUD timer, if it is running.
+     */
+    void CancelNudTimer ();
+
+    /**
+     * \brief Set the MAC address, and keep the MAC address index of the
+     * NdiscCache up to date.
+     * \param mac the MAC address.
+     */
+    void IndexMacAddress (Address mac);
+
     /**
      * \brief The IPv6 address.
      */
@@ -385,9 +426,29 @@ private:
     bool m_router;
 
     /**
-     * \brief Timer (used for NUD).
+     * \brief Function of the NUD timer.
+     */
+    void (NdiscCache::Entry::*m_nudFunction)();
+
+    /**
+     * \brief Delay of the NUD timer.
+     */
+    Time m_nudDelay;
+
+    /**
+     * \brief True if the NUD timer is running.
+     */
+    bool m_nudTimerRunning;
+
+    /**
+     * \brief Position of the NUD timer in the NdiscCache timers, if running.
      */
-    Timer m_nudTimer;
+    std::multimap<Time, NdiscCache::Entry *>::iterator m_nudTimerIt;
+
+    /**
+     * \brief Position of the entry in the NdiscCache MAC address index.
+     */
+    std::multimap<size_t, NdiscCache::Entry *>::iterator m_macIndexIt;
 
     /**
      * \brief Last time we see a reachability confirmation.
@@ -409,6 +470,22 @@ private:
    * \brief Neighbor Discovery Cache container iterator
    */
   typedef sgi::hash_map<Ipv6Address, NdiscCache::Entry *, Ipv6AddressHash>::iterator CacheI;
+  /**
+   * \brief Running NUD timers, by expiration time
+   */
+  typedef std::multimap<Time, NdiscCache::Entry *> NudTimers;
+  /**
+   * \brief Running NUD timers iterator
+   */
+  typedef std::multimap<Time, NdiscCache::Entry *>::iterator NudTimersI;
+  /**
+   * \brief Index of the entries by hash of their MAC address
+   */
+  typedef std::multimap<size_t, NdiscCache::Entry *> MacIndex;
+  /**
+   * \brief Index of the entries by hash of their MAC address iterator
+   */
+  typedef std::multimap<size_t, NdiscCache::Entry *>::iterator MacIndexI;
 
   /**
    * \brief Copy constructor.
@@ -430,6 +507,17 @@ private:
    */
   void DoDispose ();
 
+  /**
+   * \brief Schedule the NUD event at the expiration time of the first
+   * NUD timer, unless it is already scheduled earlier.
+   */
+  void ScheduleNudEvent ();
+
+  /**
+   * \brief Expire all the NUD timers which are due, in a single event.
+   */
+  void HandleNudTimeouts ();
+
   /**
    * \brief The NetDevice.
    */
@@ -445,6 +533,26 @@ private:
    */
   Cache m_ndCache;
 
+  /**
+   * \brief The entries, indexed by MAC address.
+   */
+  MacIndex m_macIndex;
+
+  /**
+   * \brief The running NUD timers of the entries.
+   */
+  NudTimers m_nudTimers;
+
+  /**
+   * \brief The event expiring the NUD timers.
+   */
+  EventId m_nudEvent;
+
+  /**
+   * \brief The expiration time of m_nudEvent.
+   */
+  Time m_nudEventTime;
+
   /**
    * \brief Max number of packet stored in m_waiting.
    */
@@ -32,6 +32,7 @@
 
 #include "tcp-l4-protocol.h"
 #include "tcp-header.h"
+#include "tcp-segmentation-tag.h"
 #include "ipv4-end-point-demux.h"
 #include "ipv6-end-point-demux.h"
 #include "ipv4-end-point.h"
@@ -547,7 +548,9 @@ TcpL4Protocol::SendPacketV4 (Ptr<Packet> packet, const TcpHeader &outgoing,
   TcpHeader outgoingHeader = outgoing;
   /** \todo UrgentPointer */
   /* outgoingHeader.SetUrgentPointer (0); */
-  if (Node::ChecksumEnabled ())
+  // the segments of a super-segment get their checksum once split
+  TcpSegmentationTag tsoTag;
+  if (Node::ChecksumEnabled () && !packet->PeekPacketTag (tsoTag))
     {
       outgoingHeader.EnableChecksums ();
     }
@@ -156,29 +156,64 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
       if (maxSeq < tailSeq) tailSeq = maxSeq;
       if (tailSeq < headSeq) headSeq = tailSeq;
     }
-  // Remove overlapped bytes from packet
-  BufIterator i = m_data.begin ();
-  while (i != m_data.end () && i->first <= tailSeq)
-    {
-      SequenceNumber32 lastByteSeq = i->first + SequenceNumber32 (i->second->GetSize ());
-      if (lastByteSeq > headSeq)
+
+  if (headSeq == m_nextRxSeq
+      && (m_data.empty () || m_data.rbegin ()->second.m_tail == m_nextRxSeq))
+    { // Fast path: in-order data, and nothing buffered out of order
+      if (headSeq >= tailSeq)
+        {
+          NS_LOG_LOGIC ("Nothing to buffer");
+          return false;
+        }
+      p = p->CreateFragment (headSeq - tcph.GetSequenceNumber (), tailSeq - headSeq);
+      p->RemoveAllPacketTags ();
+      if (m_data.empty ())
         {
-          if (i->first > headSeq && lastByteSeq < tailSeq)
-            { // Rare case: Existing packet is embedded fully in the new packet
-              m_size -= i->second->GetSize ();
-              m_data.erase (i++);
-              continue;
-            }
-          if (i->first <= headSeq)
-            { // Incoming head is overlapped
-              headSeq = lastByteSeq;
-            }
-          if (lastByteSeq >= tailSeq)
-            { // Incoming tail is overlapped
-              tailSeq = i->first;
-            }
+          m_data[headSeq].m_tail = headSeq;
+        }
+      DataBlock &block = m_data.rbegin ()->second;
+      block.m_packets.push_back (p);
+      block.m_tail = tailSeq;
+      m_size += p->GetSize ();
+      m_availBytes += p->GetSize ();
+      m_nextRxSeq = tailSeq;
+      if (!m_sackList.empty ())
+        {
+          ClearSackList (m_nextRxSeq);
+        }
+      NS_LOG_LOGIC ("Appended in-order packet of seqno=" << headSeq << " len=" << p->GetSize ()
+                    << ", buffer occupancy=" << m_size << " nextRxSeq=" << m_nextRxSeq);
+      if (m_gotFin && m_nextRxSeq == m_finSeq)
+        { // Account for the FIN packet
+          ++m_nextRxSeq;
+        };
+      return true;
+    }
+
+  // Remove overlapped bytes from packet. Since the blocks are disjoint, only
+  // the block containing the head and the ones starting before the tail
+  // can overlap the packet.
+  BufIterator i = m_data.upper_bound (headSeq);
+  if (i != m_data.begin ())
+    {
+      BufIterator prev = i;
+      --prev;
+      if (prev->second.m_tail > headSeq)
+        { // Incoming head is overlapped
+          headSeq = prev->second.m_tail;
+        }
+    }
+  while (i != m_data.end () && i->first < tailSeq)
+    {
+      if (i->second.m_tail < tailSeq)
+        { // Rare case: Existing block is embedded fully in the new packet
+          m_size -= i->second.m_tail - i->first;
+          m_data.erase (i++);
+          continue;
         }
-      ++i;
+      // Incoming tail is overlapped
+      tailSeq = i->first;
+      break;
     }
   // We now know how much we are going to store, trim the packet
   if (headSeq >= tailSeq)
@@ -192,10 +227,34 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
       uint32_t length = tailSeq - headSeq;
       p = p->CreateFragment (start, length);
       NS_ASSERT (length == p->GetSize ());
+      // The extracted data does not carry packet tags; they are removed
+      // from the fragment, not from the packet of the caller.
+      p->RemoveAllPacketTags ();
+    }
+
+  // Insert packet into buffer, coalescing it with the adjacent blocks
+  BufIterator block = m_data.upper_bound (headSeq);
+  bool appended = false;
+  if (block != m_data.begin ())
+    {
+      --block;
+      appended = (block->second.m_tail == headSeq);
+    }
+  if (!appended)
+    {
+      NS_ASSERT (m_data.find (headSeq) == m_data.end ()); // Shouldn't be there yet
+      block = m_data.insert (std::make_pair (headSeq, DataBlock ())).first;
+    }
+  block->second.m_packets.push_back (p);
+  block->second.m_tail = tailSeq;
+  BufIterator next = block;
+  ++next;
+  if (next != m_data.end () && next->first == tailSeq)
+    {
+      block->second.m_packets.splice (block->second.m_packets.end (), next->second.m_packets);
+      block->second.m_tail = next->second.m_tail;
+      m_data.erase (next);
     }
-  // Insert packet into buffer
-  NS_ASSERT (m_data.find (headSeq) == m_data.end ()); // Shouldn't be there yet
-  m_data [ headSeq ] = p;
 
   if (headSeq > m_nextRxSeq)
     {
@@ -203,21 +262,14 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
       UpdateSackList (headSeq, tailSeq);
     }
 
-  NS_LOG_LOGIC ("Buffered packet of seqno=" << headSeq << " len=" << p->GetSize ());
+  NS_LOG_LOGIC ("Buffered packet of seqno=" << headSeq << " len=" << p->GetSize ()
+                << " in block [" << block->first << ", " << block->second.m_tail << ")");
   // Update variables
   m_size += p->GetSize ();      // Occupancy
-  for (BufIterator i = m_data.begin (); i != m_data.end (); ++i)
-    {
-      if (i->first < m_nextRxSeq)
-        {
-          continue;
-        }
-      else if (i->first > m_nextRxSeq)
-        {
-          break;
-        };
-      m_nextRxSeq = i->first + SequenceNumber32 (i->second->GetSize ());
-      m_availBytes += i->second->GetSize ();
+  if (block->first <= m_nextRxSeq && block->second.m_tail > m_nextRxSeq)
+    { // The hole at the head of the buffer has been filled
+      m_availBytes += block->second.m_tail - m_nextRxSeq.Get ();
+      m_nextRxSeq = block->second.m_tail;
       ClearSackList (m_nextRxSeq);
     }
   NS_LOG_LOGIC ("Updated buffer occupancy=" << m_size << " nextRxSeq=" << m_nextRxSeq);
@@ -338,8 +390,8 @@ TcpRxBuffer::ClearSackList (const SequenceNumber32 &seq)
 {
   NS_LOG_FUNCTION (this << seq);
 
-  TcpOptionSack::SackList::iterator it;
-  for (it = m_sackList.begin (); it != m_sackList.end (); ++it)
+  TcpOptionSack::SackList::iterator it = m_sackList.begin ();
+  while (it != m_sackList.end ())
     {
       TcpOptionSack::SackBlock block = *it;
       NS_ASSERT (block.first < block.second);
@@ -348,6 +400,10 @@ TcpRxBuffer::ClearSackList (const SequenceNumber32 &seq)
         {
           it = m_sackList.erase (it);
         }
+      else
+        {
+          ++it;
+        }
     }
 }
 
@@ -366,39 +422,53 @@ TcpRxBuffer::Extract (uint32_t maxSize)
   NS_LOG_LOGIC ("Requested to extract " << extractSize << " bytes from TcpRxBuffer of size=" << m_size);
   if (extractSize == 0) return 0;  // No contiguous block to return
   NS_ASSERT (m_data.size ()); // At least we have something to extract
-  Ptr<Packet> outPkt = Create<Packet> (); // The packet that contains all the data to return
-  BufIterator i;
-  while (extractSize)
+  // All the in-sequence data is held by the first block
+  BufIterator i = m_data.begin ();
+  NS_ASSERT (i->first <= m_nextRxSeq); // in-sequence data expected
+  DataBlock &block = i->second;
+  Ptr<Packet> outPkt = 0; // The packet that contains all the data to return
+  uint32_t remaining = extractSize;
+  while (remaining)
     { // Check the buffered data for delivery
-      i = m_data.begin ();
-      NS_ASSERT (i->first <= m_nextRxSeq); // in-sequence data expected
+      NS_ASSERT (!block.m_packets.empty ());
+      Ptr<Packet> front = block.m_packets.front ();
+      uint32_t pktSize = front->GetSize ();
+      Ptr<Packet> chunk;
       // Check if we send the whole pkt or just a partial
-      uint32_t pktSize = i->second->GetSize ();
-      if (pktSize <= extractSize)
-        { // Whole packet is extracted
-          outPkt->AddAtEnd (i->second);
-          m_data.erase (i);
-          m_size -= pktSize;
-          m_availBytes -= pktSize;
-          extractSize -= pktSize;
+      if (pktSize <= remaining)
+        { // Whole packet is extracted, without copying it
+          chunk = front;
+          block.m_packets.pop_front ();
+          remaining -= pktSize;
         }
       else
         { // Partial is extracted and done
-          outPkt->AddAtEnd (i->second->CreateFragment (0, extractSize));
-          m_data[i->first + SequenceNumber32 (extractSize)] = i->second->CreateFragment (extractSize, pktSize - extractSize);
-          m_data.erase (i);
-          m_size -= extractSize;
-          m_availBytes -= extractSize;
-          extractSize = 0;
+          chunk = front->CreateFragment (0, remaining);
+          front->RemoveAtStart (remaining);
+          remaining = 0;
+        }
+      if (outPkt == 0)
+        {
+          outPkt = chunk;
+        }
+      else
+        {
+          outPkt->AddAtEnd (chunk);
         }
     }
-  if (outPkt->GetSize () == 0)
+  m_size -= extractSize;
+  m_availBytes -= extractSize;
+  // Move the head of the block past the extracted data
+  SequenceNumber32 head = i->first + SequenceNumber32 (extractSize);
+  if (head < block.m_tail)
     {
-      NS_LOG_LOGIC ("Nothing extracted.");
-      return 0;
+      DataBlock &moved = m_data[head];
+      moved.m_tail = block.m_tail;
+      moved.m_packets.swap (block.m_packets);
     }
+  m_data.erase (i);
   NS_LOG_LOGIC ("Extracted " << outPkt->GetSize ( ) << " bytes, bufsize=" << m_size
-                             << ", num pkts in buffer=" << m_data.size ());
+                             << ", num blocks in buffer=" << m_data.size ());
   return outPkt;
 }
 
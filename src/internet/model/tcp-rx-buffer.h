@@ -21,6 +21,7 @@
 #ifndef TCP_RX_BUFFER_H
 #define TCP_RX_BUFFER_H
 
+#include <list>
 #include <map>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
@@ -53,6 +54,22 @@ class Packet;
  * To store data, use Add; for retrieving a certain amount of ordered data, use
  * the method Extract.
  *
+ * Reassembly
+ * ----------
+ *
+ * The buffered data is kept as a set of disjoint intervals of sequence
+ * numbers. Each interval is a maximal contiguous range of bytes, held by the
+ * list of packets that filled it; adjacent intervals are coalesced as soon as
+ * the hole between them is filled, without copying any data. The first
+ * interval, when it starts at or before NextRxSequence, holds all the bytes
+ * which can be read by the application.
+ *
+ * The overlaps of an incoming segment are resolved by looking up only the
+ * intervals surrounding it, and a segment arriving in order when no
+ * out-of-order data is buffered is simply appended to the first interval.
+ * Extract returns the buffered packets themselves, instead of a copy of their
+ * data, whenever the requested amount ends at a packet boundary.
+ *
  * SACK list
  * ---------
  *
@@ -211,15 +228,27 @@ private:
 
   TcpOptionSack::SackList m_sackList; //!< Sack list (updated constantly)
 
+  /**
+   * \brief A contiguous range of buffered bytes
+   *
+   * The range starts at the sequence number used as key in m_data and ends
+   * before m_tail. The packets of the list are contiguous.
+   */
+  struct DataBlock
+  {
+    SequenceNumber32 m_tail;            //!< Sequence number following the last byte
+    std::list<Ptr<Packet> > m_packets;  //!< Packets holding the bytes, in order
+  };
+
   /// container for data stored in the buffer
-  typedef std::map<SequenceNumber32, Ptr<Packet> >::iterator BufIterator;
+  typedef std::map<SequenceNumber32, DataBlock>::iterator BufIterator;
   TracedValue<SequenceNumber32> m_nextRxSeq; //!< Seqnum of the first missing byte in data (RCV.NXT)
   SequenceNumber32 m_finSeq;                 //!< Seqnum of the FIN packet
   bool m_gotFin;                             //!< Did I received FIN packet?
   uint32_t m_size;                           //!< Number of total data bytes in the buffer, not necessarily contiguous
   uint32_t m_maxBuffer;                      //!< Upper bound of the number of data bytes in buffer (RCV.WND)
   uint32_t m_availBytes;                     //!< Number of bytes available to read, i.e. contiguous block at head
-  std::map<SequenceNumber32, Ptr<Packet> > m_data; //!< Corresponding data (may be null)
+  std::map<SequenceNumber32, DataBlock> m_data; //!< Disjoint intervals of data, keyed by their first sequence number
 };
 
 } //namepsace ns3
@@ -0,0 +1,92 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "tcp-segmentation-tag.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpSegmentationTag");
+
+NS_OBJECT_ENSURE_REGISTERED (TcpSegmentationTag);
+
+TcpSegmentationTag::TcpSegmentationTag ()
+  : m_segmentSize (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TcpSegmentationTag::TcpSegmentationTag (uint16_t segmentSize)
+  : m_segmentSize (segmentSize)
+{
+  NS_LOG_FUNCTION (this << segmentSize);
+}
+
+void
+TcpSegmentationTag::SetSegmentSize (uint16_t segmentSize)
+{
+  NS_LOG_FUNCTION (this << segmentSize);
+  m_segmentSize = segmentSize;
+}
+
+uint16_t
+TcpSegmentationTag::GetSegmentSize (void) const
+{
+  return m_segmentSize;
+}
+
+TypeId
+TcpSegmentationTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpSegmentationTag")
+    .SetParent<Tag> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<TcpSegmentationTag> ()
+  ;
+  return tid;
+}
+
+TypeId
+TcpSegmentationTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+TcpSegmentationTag::GetSerializedSize (void) const
+{
+  return sizeof (uint16_t);
+}
+
+void
+TcpSegmentationTag::Serialize (TagBuffer i) const
+{
+  i.WriteU16 (m_segmentSize);
+}
+
+void
+TcpSegmentationTag::Deserialize (TagBuffer i)
+{
+  m_segmentSize = i.ReadU16 ();
+}
+
+void
+TcpSegmentationTag::Print (std::ostream &os) const
+{
+  os << "SegmentSize=" << m_segmentSize;
+}
+
+} // namespace ns3
@@ -0,0 +1,77 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TCP_SEGMENTATION_TAG_H
+#define TCP_SEGMENTATION_TAG_H
+
+#include "ns3/tag.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Marks a TCP super-segment, i.e., a packet carrying several
+ * segments worth of data behind a single TCP header.
+ *
+ * TcpSocketBase attaches this tag when the TsoMaxSegments attribute allows
+ * it to send more than one segment at once. The super-segment is split
+ * into segments of the size carried by the tag either by the device, when
+ * it declares the segmentation offload capability through its
+ * NetDeviceQueueInterface, or by Ipv4L3Protocol before the transmission.
+ * The tag is removed from the resulting segments.
+ */
+class TcpSegmentationTag : public Tag
+{
+public:
+  TcpSegmentationTag ();
+
+  /**
+   * \brief Constructor
+   * \param segmentSize the size of the data carried by each segment
+   */
+  TcpSegmentationTag (uint16_t segmentSize);
+
+  /**
+   * \brief Set the size of the data carried by each segment
+   * \param segmentSize the segment size
+   */
+  void SetSegmentSize (uint16_t segmentSize);
+
+  /**
+   * \brief Get the size of the data carried by each segment
+   * \returns the segment size
+   */
+  uint16_t GetSegmentSize (void) const;
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (TagBuffer i) const;
+  virtual void Deserialize (TagBuffer i);
+  virtual void Print (std::ostream &os) const;
+
+private:
+  uint16_t m_segmentSize; //!< Size of the data carried by each segment
+};
+
+} // namespace ns3
+
+#endif /* TCP_SEGMENTATION_TAG_H */
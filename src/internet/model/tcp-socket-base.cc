@@ -51,6 +51,7 @@
 #include "tcp-option-ts.h"
 #include "tcp-option-sack-permitted.h"
 #include "tcp-option-sack.h"
+#include "tcp-segmentation-tag.h"
 #include "rtt-estimator.h"
 #include "tcp-congestion-ops.h"
 
@@ -63,6 +64,10 @@ NS_LOG_COMPONENT_DEFINE ("TcpSocketBase");
 
 NS_OBJECT_ENSURE_REGISTERED (TcpSocketBase);
 
+/// Largest data size of a super-segment, so that it fits the IPv4 total
+/// length along with the IPv4 header and the largest TCP header
+static const uint32_t MAX_SUPER_SEGMENT_SIZE = 65535 - 20 - 60;
+
 TypeId
 TcpSocketBase::GetTypeId (void)
 {
@@ -135,6 +140,13 @@ TcpSocketBase::GetTypeId (void)
                    BooleanValue (true),
                    MakeBooleanAccessor (&TcpSocketBase::m_limitedTx),
                    MakeBooleanChecker ())
+    .AddAttribute ("TsoMaxSegments",
+                   "Maximum number of full-sized segments of new data sent "
+                   "at once as a single super-segment, to be split by the "
+                   "device or by IPv4 (segmentation offload). 1 disables it.",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&TcpSocketBase::m_tsoMaxSegments),
+                   MakeUintegerChecker<uint32_t> (1))
     .AddTraceSource ("RTO",
                      "Retransmission timeout",
                      MakeTraceSourceAccessor (&TcpSocketBase::m_rto),
@@ -331,6 +343,7 @@ TcpSocketBase::TcpSocketBase (void)
     m_recover (0),
     m_retxThresh (3),
     m_limitedTx (false),
+    m_tsoMaxSegments (1),
     m_congestionControl (0),
     m_isFirstPartialAck (true)
 {
@@ -407,6 +420,7 @@ TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
     m_recover (sock.m_recover),
     m_retxThresh (sock.m_retxThresh),
     m_limitedTx (sock.m_limitedTx),
+    m_tsoMaxSegments (sock.m_tsoMaxSegments),
     m_isFirstPartialAck (sock.m_isFirstPartialAck),
     m_txTrace (sock.m_txTrace),
     m_rxTrace (sock.m_rxTrace)
@@ -2632,8 +2646,24 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
       isRetransmission = true;
     }
 
-  Ptr<Packet> p = m_txBuffer->CopyFromSequence (maxSize, seq);
+  Ptr<Packet> p = m_txBuffer->CopyFromSequence (std::min (maxSize, m_tcb->m_segmentSize), seq);
   uint32_t sz = p->GetSize (); // Size of packet
+  // A super-segment is assembled one segment at a time, so that the
+  // scoreboard keeps the granularity of the segments put on the wire
+  bool superSegment = false;
+  while (maxSize > m_tcb->m_segmentSize && sz < maxSize && sz > 0
+         && sz % m_tcb->m_segmentSize == 0)
+    {
+      Ptr<Packet> segment = m_txBuffer->CopyFromSequence (std::min (maxSize - sz, m_tcb->m_segmentSize),
+                                                          seq + SequenceNumber32 (sz));
+      if (segment->GetSize () == 0)
+        {
+          break;
+        }
+      p->AddAtEnd (segment);
+      sz += segment->GetSize ();
+      superSegment = true;
+    }
   uint8_t flags = withAck ? TcpHeader::ACK : 0;
   uint32_t remainingData = m_txBuffer->SizeFromSequence (seq + SequenceNumber32 (sz));
 
@@ -2685,6 +2715,11 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
       p->ReplacePacketTag (priorityTag);
     }
 
+  if (superSegment)
+    {
+      p->AddPacketTag (TcpSegmentationTag (m_tcb->m_segmentSize));
+    }
+
   if (m_closeOnEmpty && (remainingData == 0))
     {
       flags |= TcpHeader::FIN;
@@ -2745,7 +2780,18 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
                     ". Header " << header);
     }
 
-  UpdateRttHistory (seq, sz, isRetransmission);
+  if (superSegment)
+    {
+      for (uint32_t offset = 0; offset < sz; offset += m_tcb->m_segmentSize)
+        {
+          UpdateRttHistory (seq + SequenceNumber32 (offset),
+                            std::min (sz - offset, m_tcb->m_segmentSize), isRetransmission);
+        }
+    }
+  else
+    {
+      UpdateRttHistory (seq, sz, isRetransmission);
+    }
 
   // Notify the application of the data being sent unless this is a retransmit
   if (seq + sz > m_tcb->m_highTxMark)
@@ -2849,6 +2895,22 @@ TcpSocketBase::SendPendingData (bool withAck)
 
           uint32_t s = std::min (availableWindow, m_tcb->m_segmentSize);
 
+          // With segmentation offload, new data is sent in a single
+          // super-segment made of as many full-sized segments as allowed
+          // by the window, the data available and the IPv4 total length
+          if (m_tsoMaxSegments > 1 && m_endPoint != 0 && next == m_tcb->m_highTxMark
+              && m_tcb->m_congState == TcpSocketState::CA_OPEN)
+            {
+              uint32_t tso = std::min (availableWindow, availableData);
+              tso = std::min (tso, m_tsoMaxSegments * m_tcb->m_segmentSize);
+              tso = std::min (tso, MAX_SUPER_SEGMENT_SIZE);
+              tso -= tso % m_tcb->m_segmentSize;
+              if (tso > m_tcb->m_segmentSize)
+                {
+                  s = tso;
+                }
+            }
+
           // (C.2) If any of the data octets sent in (C.1) are below HighData,
           //       HighRxt MUST be set to the highest sequence number of the
           //       retransmitted segment unless NextSeg () rule (4) was
@@ -652,6 +652,9 @@ protected:
    * \param maxSize the maximum data block to be transmitted (in bytes)
    * \param withAck forces an ACK to be sent
    * \returns the number of bytes sent
+   *
+   * A maxSize larger than the segment size makes a super-segment, tagged
+   * with a TcpSegmentationTag, which is split on its way to the wire.
    */
   uint32_t SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool withAck);
 
@@ -1144,6 +1147,7 @@ protected:
   SequenceNumber32       m_recover;      //!< Previous highest Tx seqnum for fast recovery
   uint32_t               m_retxThresh;   //!< Fast Retransmit threshold
   bool                   m_limitedTx;    //!< perform limited transmit
+  uint32_t               m_tsoMaxSegments; //!< Max number of segments in a super-segment
 
   // Transmission Control Block
   Ptr<TcpSocketState>    m_tcb;               //!< Congestion control informations
@@ -112,7 +112,10 @@ TcpTxBuffer::GetTypeId (void)
  * initialized below is insignificant.
  */
 TcpTxBuffer::TcpTxBuffer (uint32_t n)
-  : m_maxBuffer (32768), m_size (0), m_sentSize (0), m_firstByteSeq (n)
+  : m_maxBuffer (32768), m_size (0), m_sentSize (0), m_sackedOut (0),
+    m_sackedBytes (0), m_lostBytes (0), m_retransBytes (0), m_firstByteSeq (n),
+    m_retxCursor (n), m_lostBoundaryValid (false), m_bytesInFlightValid (false),
+    m_bytesInFlight (0), m_cacheKey (0, 0)
 {
 }
 
@@ -180,6 +183,7 @@ TcpTxBuffer::SetHeadSequence (const SequenceNumber32& seq)
   // if you change the head with data already sent, something bad will happen
   NS_ASSERT (m_sentList.size () == 0);
   m_highestSack = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
+  m_retxCursor = seq;
 }
 
 bool
@@ -249,7 +253,10 @@ TcpTxBuffer::CopyFromSequence (uint32_t numBytes, const SequenceNumber32& seq)
       // already sent this block completely
       outItem = GetTransmittedSegment (s, seq);
       NS_ASSERT (outItem != 0);
+      RemoveFromCounters (outItem);
       outItem->m_retrans = true;
+      AddToCounters (outItem);
+      AdvanceRetxCursor ();
 
       NS_LOG_DEBUG ("Retransmitting [" << seq << ";" << seq + s << "|" << s <<
                     "] from " << *this);
@@ -284,8 +291,10 @@ TcpTxBuffer::CopyFromSequence (uint32_t numBytes, const SequenceNumber32& seq)
       return CopyFromSequence (numBytes, seq);
     }
 
+  RemoveFromCounters (outItem);
   outItem->m_lost = false;
   outItem->m_lastSent = Simulator::Now ();
+  AddToCounters (outItem);
   Ptr<Packet> toRet = outItem->m_packet->Copy ();
 
   NS_ASSERT (toRet->GetSize () == s);
@@ -301,7 +310,7 @@ TcpTxBuffer::GetNewSegment (uint32_t numBytes)
   SequenceNumber32 startOfAppList = m_firstByteSeq + m_sentSize;
 
   bool listEdited = false;
-  TcpTxItem *item = GetPacketFromList (m_appList, startOfAppList,
+  TcpTxItem *item = GetPacketFromList (m_appList, m_appList.begin (), startOfAppList,
                                        numBytes, startOfAppList, &listEdited);
 
   (void) listEdited;
@@ -311,8 +320,17 @@ TcpTxBuffer::GetNewSegment (uint32_t numBytes)
   NS_ASSERT (it != m_appList.end ());
 
   m_appList.erase (it);
-  m_sentList.insert (m_sentList.end (), item);
+  it = m_sentList.insert (m_sentList.end (), item);
+  m_sentIndex.insert (m_sentIndex.end (), std::make_pair (startOfAppList, it));
+
+  // The new segment follows the highest SACKed one, if it was the last sent
+  if (m_sackedOut > 0 && m_highestSack.first == m_sentList.end ()
+      && m_highestSack.second == startOfAppList)
+    {
+      m_highestSack.first = it;
+    }
   m_sentSize += item->m_packet->GetSize ();
+  AddToCounters (item);
 
   return item;
 }
@@ -326,11 +344,35 @@ TcpTxBuffer::GetTransmittedSegment (uint32_t numBytes, const SequenceNumber32 &s
 
   bool listEdited = false;
 
-  TcpTxItem *item = GetPacketFromList (m_sentList, m_firstByteSeq, numBytes, seq, &listEdited);
+  // Start the walk from the segment which holds seq
+  SequenceNumber32 beginOfSegment;
+  PacketList::iterator it = FindSentSegment (seq, &beginOfSegment);
+
+  TcpTxItem *item = GetPacketFromList (m_sentList, it, beginOfSegment, numBytes, seq, &listEdited);
 
   if (listEdited && m_highestSack.second >= m_firstByteSeq)
     {
-      m_highestSack = GetHighestSacked ();
+      // Fragments keep the flags of their segment: unless a merge took the
+      // highest SACKed segment, it still ends at the same sequence
+      SentIndex::const_iterator next = m_sentIndex.lower_bound (m_highestSack.second);
+      PacketList::const_iterator sacked = m_sentList.end ();
+      if (next == m_sentIndex.end () && m_highestSack.second == m_firstByteSeq + m_sentSize)
+        {
+          m_highestSack.first = m_sentList.end ();
+          --sacked;
+        }
+      else if (next != m_sentIndex.end () && next != m_sentIndex.begin ()
+               && next->first == m_highestSack.second)
+        {
+          m_highestSack.first = next->second;
+          sacked = next->second;
+          --sacked;
+        }
+
+      if (sacked == m_sentList.end () || !(*sacked)->m_sacked)
+        {
+          m_highestSack = GetHighestSacked ();
+        }
     }
 
   return item;
@@ -341,25 +383,204 @@ TcpTxBuffer::GetHighestSacked () const
 {
   NS_LOG_FUNCTION (this);
 
-  PacketList::const_iterator it;
-  std::pair <TcpTxBuffer::PacketList::const_iterator, SequenceNumber32> ret;
-  SequenceNumber32 beginOfCurrentPacket = m_firstByteSeq;
+  if (m_sackedOut == 0)
+    {
+      return std::make_pair (m_sentList.end (), SequenceNumber32 (0));
+    }
 
-  ret = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
+  PacketList::const_iterator it = m_sentList.end ();
+  SequenceNumber32 endOfCurrentPacket = m_firstByteSeq + m_sentSize;
 
-  for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
+  while (it != m_sentList.begin ())
     {
+      PacketList::const_iterator next = it--;
       const TcpTxItem *item = *it;
       if (item->m_sacked)
         {
-          ret = std::make_pair (it, beginOfCurrentPacket);
+          return std::make_pair (next, endOfCurrentPacket);
+        }
+      endOfCurrentPacket -= item->m_packet->GetSize ();
+    }
+
+  NS_FATAL_ERROR ("SACKed segments are accounted, but none is in the sent list");
+}
+
+SequenceNumber32
+TcpTxBuffer::GetLostBoundary (uint32_t dupThresh, uint32_t segmentSize) const
+{
+  NS_LOG_FUNCTION (this << dupThresh << segmentSize);
+
+  if (!IsSackThresholdReached (m_sackedOut, m_sackedBytes, dupThresh, segmentSize))
+    {
+      return m_firstByteSeq;
+    }
+
+  std::pair<uint32_t, uint32_t> key (dupThresh, segmentSize);
+  if (m_lostBoundaryValid && m_cacheKey == key)
+    {
+      return m_lostBoundary;
+    }
+  if (m_cacheKey != key)
+    {
+      m_cacheKey = key;
+      m_bytesInFlightValid = false;
+    }
+
+  // Nothing above the highest SACK is SACKed
+  uint32_t sackedSegments = 0;
+  uint32_t sackedBytes = 0;
+  SequenceNumber32 beginOfCurrentPacket = m_highestSack.second;
+  PacketList::const_iterator it = m_highestSack.first;
+
+  while (it != m_sentList.begin ())
+    {
+      const TcpTxItem *item = *(--it);
+      beginOfCurrentPacket -= item->m_packet->GetSize ();
+
+      if (item->m_sacked)
+        {
+          ++sackedSegments;
+          sackedBytes += item->m_packet->GetSize ();
+          if (IsSackThresholdReached (sackedSegments, sackedBytes, dupThresh, segmentSize))
+            {
+              m_lostBoundary = beginOfCurrentPacket;
+              m_lostBoundaryValid = true;
+              return m_lostBoundary;
+            }
+        }
+    }
+
+  NS_FATAL_ERROR ("SACKed data is accounted, but it is not in the sent list");
+}
+
+bool
+TcpTxBuffer::IsSackThresholdReached (uint32_t sackedSegments, uint32_t sackedBytes,
+                                     uint32_t dupThresh, uint32_t segmentSize) const
+{
+  // IsLost counts the SACKed segments as they are met: without any of them,
+  // nothing is lost, whatever the threshold
+  return sackedSegments > 0
+         && ((sackedSegments >= dupThresh) || (sackedBytes > (dupThresh - 1) * segmentSize));
+}
+
+uint32_t
+TcpTxBuffer::GetLostPerSackBytes (const SequenceNumber32 &lostBoundary) const
+{
+  NS_LOG_FUNCTION (this << lostBoundary);
+
+  SentIndex::const_iterator index = m_sentIndex.upper_bound (m_retxCursor);
+  if (index != m_sentIndex.begin ())
+    {
+      --index;
+    }
+  if (index == m_sentIndex.end ())
+    {
+      return 0;
+    }
+
+  uint32_t bytes = 0;
+  SequenceNumber32 beginOfCurrentPacket = index->first;
+  PacketList::const_iterator it;
+
+  for (it = index->second; it != m_sentList.end () && beginOfCurrentPacket < lostBoundary; ++it)
+    {
+      const TcpTxItem *item = *it;
+      if (!item->m_sacked && !item->m_lost && !item->m_retrans)
+        {
+          bytes += item->m_packet->GetSize ();
         }
       beginOfCurrentPacket += item->m_packet->GetSize ();
     }
 
-  return ret;
+  return bytes;
 }
 
+void
+TcpTxBuffer::AdvanceRetxCursor ()
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_retxCursor < m_firstByteSeq)
+    {
+      m_retxCursor = m_firstByteSeq;
+    }
+  if (m_retxCursor >= m_firstByteSeq + m_sentSize)
+    {
+      return;
+    }
+
+  // Each segment is walked once, until the scoreboard is reset
+  SequenceNumber32 beginOfCurrentPacket;
+  PacketList::iterator it = FindSentSegment (m_retxCursor, &beginOfCurrentPacket);
+
+  while (it != m_sentList.end () && ((*it)->m_sacked || (*it)->m_retrans))
+    {
+      beginOfCurrentPacket += (*it)->m_packet->GetSize ();
+      ++it;
+    }
+
+  m_retxCursor = beginOfCurrentPacket;
+}
+
+TcpTxBuffer::PacketList::iterator
+TcpTxBuffer::FindSentSegment (const SequenceNumber32 &seq, SequenceNumber32 *begin)
+{
+  NS_LOG_FUNCTION (this << seq);
+
+  SentIndex::iterator it = m_sentIndex.upper_bound (seq);
+  NS_ASSERT (it != m_sentIndex.begin ());
+  --it;
+
+  *begin = it->first;
+  return it->second;
+}
+
+void
+TcpTxBuffer::AddToCounters (const TcpTxItem *item)
+{
+  uint32_t size = item->m_packet->GetSize ();
+
+  m_bytesInFlightValid = false;
+  if (item->m_sacked)
+    {
+      m_lostBoundaryValid = false;
+      ++m_sackedOut;
+      m_sackedBytes += size;
+    }
+  else if (item->m_lost)
+    {
+      m_lostBytes += size;
+    }
+  else if (item->m_retrans)
+    {
+      m_retransBytes += size;
+    }
+}
+
+void
+TcpTxBuffer::RemoveFromCounters (const TcpTxItem *item)
+{
+  uint32_t size = item->m_packet->GetSize ();
+
+  m_bytesInFlightValid = false;
+  if (item->m_sacked)
+    {
+      m_lostBoundaryValid = false;
+      NS_ASSERT (m_sackedOut > 0 && m_sackedBytes >= size);
+      --m_sackedOut;
+      m_sackedBytes -= size;
+    }
+  else if (item->m_lost)
+    {
+      NS_ASSERT (m_lostBytes >= size);
+      m_lostBytes -= size;
+    }
+  else if (item->m_retrans)
+    {
+      NS_ASSERT (m_retransBytes >= size);
+      m_retransBytes -= size;
+    }
+}
 
 void
 TcpTxBuffer::SplitItems (TcpTxItem &t1, TcpTxItem &t2, uint32_t size) const
@@ -376,9 +597,10 @@ TcpTxBuffer::SplitItems (TcpTxItem &t1, TcpTxItem &t2, uint32_t size) const
 }
 
 TcpTxItem*
-TcpTxBuffer::GetPacketFromList (PacketList &list, const SequenceNumber32 &listStartFrom,
+TcpTxBuffer::GetPacketFromList (PacketList &list, PacketList::iterator start,
+                                const SequenceNumber32 &listStartFrom,
                                 uint32_t numBytes, const SequenceNumber32 &seq,
-                                bool *listEdited) const
+                                bool *listEdited)
 {
   NS_LOG_FUNCTION (this << numBytes << seq);
 
@@ -407,12 +629,16 @@ TcpTxBuffer::GetPacketFromList (PacketList &list, const SequenceNumber32 &listSt
    * In (1), things are pretty easy, it's just a matter of walking the list and
    * defragment packets, if needed (e.g. seq is the beginning of the first packet
    * while maxBytes is the end of some packet next in the list).
+   *
+   * Fragment and merge operations on the sent list have to be reflected in
+   * its index and in the scoreboard counters.
    */
 
+  bool isSentList = (&list == &m_sentList);
   Ptr<Packet> currentPacket = 0;
   TcpTxItem *currentItem = 0;
   TcpTxItem *outItem = 0;
-  PacketList::iterator it = list.begin ();
+  PacketList::iterator it = start;
   SequenceNumber32 beginOfCurrentPacket = listStartFrom;
 
   while (it != list.end ())
@@ -443,13 +669,25 @@ TcpTxBuffer::GetPacketFromList (PacketList &list, const SequenceNumber32 &listSt
                            " and now we recurse because packet ends at "
                                         << beginOfCurrentPacket + currentPacket->GetSize ());
               TcpTxItem *firstPart = new TcpTxItem ();
+              if (isSentList)
+                {
+                  RemoveFromCounters (currentItem);
+                }
               SplitItems (*firstPart, *currentItem, seq - beginOfCurrentPacket);
 
               // insert firstPart before currentItem
-              list.insert (it, firstPart);
+              PacketList::iterator firstIt = list.insert (it, firstPart);
+              if (isSentList)
+                {
+                  AddToCounters (firstPart);
+                  AddToCounters (currentItem);
+                  m_sentIndex[beginOfCurrentPacket] = firstIt;
+                  m_sentIndex[seq] = it;
+                }
               *listEdited = true;
 
-              return GetPacketFromList (list, listStartFrom, numBytes, seq, listEdited);
+              // currentItem now starts at seq
+              return GetPacketFromList (list, it, seq, numBytes, seq, listEdited);
             }
           else
             {
@@ -475,38 +713,31 @@ TcpTxBuffer::GetPacketFromList (PacketList &list, const SequenceNumber32 &listSt
           // the end boundary is inside the current packet
           if (numBytes == currentPacket->GetSize ())
             {
-              // the end boundary is exactly the end of the current packet. Hurray!
-              if (currentItem->m_packet == outItem->m_packet)
-                {
-                  // A perfect match!
-                  return outItem;
-                }
-              else
-                {
-                  // the end is exactly the end of current packet, but
-                  // current > outPacket in the list. Merge current with the
-                  // previous, and recurse.
-                  NS_ASSERT (it != list.begin ());
-                  TcpTxItem *previous = *(--it);
-
-                  list.erase (it);
-
-                  MergeItems (*previous, *currentItem);
-                  delete currentItem;
-                  *listEdited = true;
-
-                  return GetPacketFromList (list, listStartFrom, numBytes, seq, listEdited);
-                }
+              // the end boundary is exactly the end of the current packet,
+              // which starts at seq. A perfect match!
+              NS_ASSERT (currentItem == outItem);
+              return outItem;
             }
           else if (numBytes < currentPacket->GetSize ())
             {
               // the end is inside the current packet, but it isn't exactly
               // the packet end. Just fragment, fix the list, and return.
               TcpTxItem *firstPart = new TcpTxItem ();
+              if (isSentList)
+                {
+                  RemoveFromCounters (currentItem);
+                }
               SplitItems (*firstPart, *currentItem, numBytes);
 
               // insert firstPart before currentItem
-              list.insert (it, firstPart);
+              PacketList::iterator firstIt = list.insert (it, firstPart);
+              if (isSentList)
+                {
+                  AddToCounters (firstPart);
+                  AddToCounters (currentItem);
+                  m_sentIndex[seq] = firstIt;
+                  m_sentIndex[seq + numBytes] = it;
+                }
               *listEdited = true;
 
               return firstPart;
@@ -516,7 +747,8 @@ TcpTxBuffer::GetPacketFromList (PacketList &list, const SequenceNumber32 &listSt
         {
           // The end isn't inside current packet, but there is an exception for
           // the merge and recurse strategy...
-          if (++it == list.end ())
+          PacketList::iterator nextIt = it;
+          if (++nextIt == list.end ())
             {
               // ...current is the last packet we sent. We have not more data;
               // Go for this one.
@@ -528,17 +760,26 @@ TcpTxBuffer::GetPacketFromList (PacketList &list, const SequenceNumber32 &listSt
 
           // The current packet does not contain the requested end. Merge current
           // with the packet that follows, and recurse
-          TcpTxItem *next = (*it); // Please remember we have incremented it
-                                   // in the previous if
+          TcpTxItem *next = (*nextIt);
 
+          if (isSentList)
+            {
+              RemoveFromCounters (currentItem);
+              RemoveFromCounters (next);
+              m_sentIndex.erase (beginOfCurrentPacket + currentPacket->GetSize ());
+            }
           MergeItems (*currentItem, *next);
-          list.erase (it);
+          list.erase (nextIt);
+          if (isSentList)
+            {
+              AddToCounters (currentItem);
+            }
 
           delete next;
 
           *listEdited = true;
 
-          return GetPacketFromList (list, listStartFrom, numBytes, seq, listEdited);
+          return GetPacketFromList (list, it, beginOfCurrentPacket, numBytes, seq, listEdited);
         }
     }
 
@@ -605,6 +846,8 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
 
       if (offset >= pktSize)
         { // This packet is behind the seqnum. Remove this packet from the buffer
+          RemoveFromCounters (item);
+          m_sentIndex.erase (m_firstByteSeq);
           m_size -= pktSize;
           m_sentSize -= pktSize;
           offset -= pktSize;
@@ -619,11 +862,15 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
       else if (offset > 0)
         { // Part of the packet is behind the seqnum. Fragment
           pktSize -= offset;
+          RemoveFromCounters (item);
+          m_sentIndex.erase (m_firstByteSeq);
           // PacketTags are preserved when fragmenting
           item->m_packet = item->m_packet->CreateFragment (offset, pktSize);
           m_size -= offset;
           m_sentSize -= offset;
           m_firstByteSeq += offset;
+          m_sentIndex[m_firstByteSeq] = i;
+          AddToCounters (item);
           NS_LOG_INFO ("Fragmented one packet by size " << offset <<
                        ", new size=" << pktSize);
           break;
@@ -643,9 +890,16 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
           // It is not possible to have the UNA sacked; otherwise, it would
           // have been ACKed. This is, most likely, our wrong guessing
           // when crafting the SACK option for a non-SACK receiver.
+          RemoveFromCounters (head);
           head->m_sacked = false;
+          AddToCounters (head);
+          if (!head->m_retrans)
+            {
+              m_retxCursor = m_firstByteSeq;
+            }
         }
     }
+  AdvanceRetxCursor ();
 
   if (m_highestSack.second <= m_firstByteSeq)
     {
@@ -671,8 +925,15 @@ TcpTxBuffer::Update (const TcpOptionSack::SackList &list)
       TcpTxItem *item;
       const TcpOptionSack::SackBlock b = (*option_it);
 
-      PacketList::iterator item_it = m_sentList.begin ();
-      SequenceNumber32 beginOfCurrentPacket = m_firstByteSeq;
+      // Start from the first segment which begins inside the block
+      PacketList::iterator item_it = m_sentList.end ();
+      SequenceNumber32 beginOfCurrentPacket;
+      SentIndex::const_iterator index_it = m_sentIndex.lower_bound (b.first);
+      if (index_it != m_sentIndex.end ())
+        {
+          item_it = index_it->second;
+          beginOfCurrentPacket = index_it->first;
+        }
 
       while (item_it != m_sentList.end ())
         {
@@ -693,7 +954,9 @@ TcpTxBuffer::Update (const TcpOptionSack::SackList &list)
                 }
               else
                 {
+                  RemoveFromCounters (item);
                   item->m_sacked = true;
+                  AddToCounters (item);
                   NS_LOG_INFO ("Received block [" << b.first << ";" << b.second <<
                                ", checking sentList for block " << beginOfCurrentPacket <<
                                ";" << beginOfCurrentPacket + current->GetSize () <<
@@ -724,6 +987,11 @@ TcpTxBuffer::Update (const TcpOptionSack::SackList &list)
 
   NS_ASSERT ((*(m_sentList.begin ()))->m_sacked == false);
 
+  if (modified)
+    {
+      AdvanceRetxCursor ();
+    }
+
   return modified;
 }
 
@@ -732,12 +1000,6 @@ TcpTxBuffer::IsLost (const SequenceNumber32 &seq, const PacketList::const_iterat
                      uint32_t dupThresh, uint32_t segmentSize) const
 {
   NS_LOG_FUNCTION (this << seq << dupThresh << segmentSize);
-  uint32_t count = 0;
-  uint32_t bytes = 0;
-  PacketList::const_iterator it;
-  TcpTxItem *item;
-  Ptr<const Packet> current;
-  SequenceNumber32 beginOfCurrentPacket = seq;
 
   NS_LOG_INFO ("Checking if seq=" << seq << " is lost from the buffer ");
 
@@ -758,34 +1020,15 @@ TcpTxBuffer::IsLost (const SequenceNumber32 &seq, const PacketList::const_iterat
   // > sequences have arrived above 'seq' or more than (dupThresh - 1) * SMSS bytes
   // > with sequence numbers greater than 'SeqNum' have been SACKed.  Otherwise, the
   // > routine returns false.
-  for (it = segment; it != m_highestSack.first; ++it)
+  // The SACKed data above a sequence only decreases while the sequence grows,
+  // so this holds exactly for the segments below the lost boundary.
+  if (seq < GetLostBoundary (dupThresh, segmentSize))
     {
-      if (beginOfCurrentPacket >= m_highestSack.second)
-        {
-          NS_LOG_INFO ("seq=" << seq << " is not lost because there are no sacked segment ahead");
-          return false;
-        }
-
-      item = *it;
-      current = item->m_packet;
-
-      if (item->m_sacked)
-        {
-          NS_LOG_INFO ("Segment [" << beginOfCurrentPacket << ", " <<
-                       beginOfCurrentPacket+item->m_packet->GetSize () <<
-                       "] found to be SACKed");
-          ++count;
-          bytes += current->GetSize ();
-          if ((count >= dupThresh) || (bytes > (dupThresh-1) * segmentSize))
-            {
-              NS_LOG_INFO ("seq=" << seq << " is lost because of 3 sacked blocks ahead");
-              return true;
-            }
-        }
-
-      beginOfCurrentPacket += current->GetSize ();
+      NS_LOG_INFO ("seq=" << seq << " is lost because of 3 sacked blocks ahead");
+      return true;
     }
 
+  NS_LOG_INFO ("seq=" << seq << " is not lost because there is not enough SACKed data ahead");
   return false;
 }
 
@@ -795,28 +1038,19 @@ TcpTxBuffer::IsLost (const SequenceNumber32 &seq, uint32_t dupThresh,
 {
   NS_LOG_FUNCTION (this << seq << dupThresh);
 
-  SequenceNumber32 beginOfCurrentPacket = m_firstByteSeq;
-  PacketList::const_iterator it;
-
   if (seq >= m_highestSack.second)
     {
       return false;
     }
 
-  // This O(n) method is called only once, and outside this class.
-  // It should not harm the performance
-  for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
+  // Search for the first segment starting at or after seq before calling IsLost()
+  SentIndex::const_iterator it = m_sentIndex.lower_bound (seq);
+  if (it == m_sentIndex.end ())
     {
-      // Search for the right iterator before calling IsLost()
-      if (beginOfCurrentPacket >= seq)
-        {
-          return IsLost (beginOfCurrentPacket, it, dupThresh, segmentSize);
-        }
-
-      beginOfCurrentPacket += (*it)->m_packet->GetSize ();
+      return false;
     }
 
-  return false;
+  return IsLost (it->first, it->second, dupThresh, segmentSize);
 }
 
 bool
@@ -839,25 +1073,49 @@ TcpTxBuffer::NextSeg (SequenceNumber32 *seq, uint32_t dupThresh,
    *
    *     (1.c) IsLost (S2) returns true.
    */
-  PacketList::const_iterator it;
+  PacketList::const_iterator it = m_sentList.end ();
   TcpTxItem *item;
   SequenceNumber32 seqPerRule3;
   bool isSeqPerRule3Valid = false;
-  SequenceNumber32 beginOfCurrentPkt = m_firstByteSeq;
+  SequenceNumber32 beginOfCurrentPkt;
 
-  for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
+  // Unsacked segments below the boundary are lost per SACK; above it,
+  // only the segments marked as lost are.
+  SequenceNumber32 lostBoundary = GetLostBoundary (dupThresh, segmentSize);
+
+  // The segments before the cursor are SACKed or retransmitted (1.a): no
+  // candidate there, neither for rule (1) nor for rule (3)
+  SentIndex::const_iterator index = m_sentIndex.upper_bound (m_retxCursor);
+  if (index != m_sentIndex.begin ())
     {
+      --index;
+    }
+  if (index != m_sentIndex.end ())
+    {
+      it = index->second;
+      beginOfCurrentPkt = index->first;
+    }
+
+  for (; it != m_sentList.end (); ++it)
+    {
+      if (beginOfCurrentPkt >= lostBoundary && m_lostBytes == 0
+          && (isSeqPerRule3Valid || !isRecovery))
+        {
+          // No more candidates for rule (1) nor for rule (3)
+          break;
+        }
+
       item = *it;
 
       // Condition 1.a , 1.b , and 1.c
       if (item->m_retrans == false && item->m_sacked == false)
         {
-          if (IsLost (beginOfCurrentPkt, it, dupThresh, segmentSize))
+          if (item->m_lost || beginOfCurrentPkt < lostBoundary)
             {
               *seq = beginOfCurrentPkt;
               return true;
             }
-          else if (seqPerRule3.GetValue () == 0 && isRecovery)
+          else if (!isSeqPerRule3Valid && isRecovery)
             {
               isSeqPerRule3Valid = true;
               seqPerRule3 = beginOfCurrentPkt;
@@ -910,36 +1168,37 @@ TcpTxBuffer::NextSeg (SequenceNumber32 *seq, uint32_t dupThresh,
 uint32_t
 TcpTxBuffer::BytesInFlight (uint32_t dupThresh, uint32_t segmentSize) const
 {
-  PacketList::const_iterator it;
-  TcpTxItem *item;
-  uint32_t size = 0; // "pipe" in RFC
-  SequenceNumber32 beginOfCurrentPkt = m_firstByteSeq;
-
   // After initializing pipe to zero, the following steps are taken for each
   // octet 'S1' in the sequence space between HighACK and HighData that has not
   // been SACKed:
-  for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
+  // (a) If IsLost (S1) returns false: Pipe is incremented by 1 octet.
+  // (b) If S1 <= HighRxt: Pipe is incremented by 1 octet.
+  // (NOTE: we use the m_retrans flag instead of keeping and updating
+  // another variable). Only if the item is not marked as lost
+  //
+  // Hence, an unsacked segment not marked as lost is counted if it is above
+  // the boundary of the segments lost per SACK, or if it is retransmitted.
+
+  if (!IsSackThresholdReached (m_sackedOut, m_sackedBytes, dupThresh, segmentSize))
     {
-      item = *it;
-      if (!item->m_sacked)
-        {
-          // (a) If IsLost (S1) returns false: Pipe is incremented by 1 octet.
-          if (!IsLost (beginOfCurrentPkt, it, dupThresh, segmentSize))
-            {
-              size += item->m_packet->GetSize ();
-            }
-          // (b) If S1 <= HighRxt: Pipe is incremented by 1 octet.
-          // (NOTE: we use the m_retrans flag instead of keeping and updating
-          // another variable). Only if the item is not marked as lost
-          else if (item->m_retrans && !item->m_lost)
-            {
-              size += item->m_packet->GetSize ();
-            }
-        }
-      beginOfCurrentPkt += item->m_packet->GetSize ();
+      // No segment is lost per SACK
+      return m_sentSize - m_sackedBytes - m_lostBytes;
+    }
+
+  SequenceNumber32 lostBoundary = GetLostBoundary (dupThresh, segmentSize);
+  if (m_bytesInFlightValid)
+    {
+      return m_bytesInFlight;
     }
 
-  return size;
+  // Of the unsacked bytes not marked as lost, the ones below the boundary
+  // which are not retransmitted are not counted
+  uint32_t lostPerSack = GetLostPerSackBytes (lostBoundary);
+  NS_ASSERT (m_sentSize - m_sackedBytes - m_lostBytes >= lostPerSack);
+  m_bytesInFlight = m_sentSize - m_sackedBytes - m_lostBytes - lostPerSack;
+  m_bytesInFlightValid = true;
+
+  return m_bytesInFlight;
 }
 
 void
@@ -952,11 +1211,15 @@ TcpTxBuffer::ResetScoreboard ()
 
   for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
     {
+      RemoveFromCounters (*it);
       (*it)->m_sacked = false;
+      AddToCounters (*it);
       beginOfCurrentPkt += (*it)->m_packet->GetSize ();
     }
 
   m_highestSack = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
+  m_retxCursor = m_firstByteSeq;
+  AdvanceRetxCursor ();
 }
 
 void
@@ -969,18 +1232,23 @@ TcpTxBuffer::ResetSentList ()
   while (m_sentList.size () > 1)
     {
       item = m_sentList.back ();
+      RemoveFromCounters (item);
       item->m_retrans = item->m_sacked = false;
       m_appList.push_front (item);
       m_sentList.pop_back ();
     }
 
+  m_sentIndex.clear ();
   if (m_sentList.size () > 0)
     {
       item = m_sentList.back ();
+      RemoveFromCounters (item);
       item->m_lost = true;
       item->m_sacked = false;
       item->m_retrans = false;
+      AddToCounters (item);
       m_sentSize = item->m_packet->GetSize ();
+      m_sentIndex[m_firstByteSeq] = m_sentList.begin ();
     }
   else
     {
@@ -988,6 +1256,7 @@ TcpTxBuffer::ResetSentList ()
     }
 
   m_highestSack = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
+  m_retxCursor = m_firstByteSeq;
 }
 
 void
@@ -998,9 +1267,18 @@ TcpTxBuffer::ResetLastSegmentSent ()
     {
       TcpTxItem *item = m_sentList.back ();
 
+      RemoveFromCounters (item);
       m_sentList.pop_back ();
       m_sentSize -= item->m_packet->GetSize ();
+      m_sentIndex.erase (m_firstByteSeq + m_sentSize);
       m_appList.insert (m_appList.begin (), item);
+
+      // The highest SACK could point to the removed segment
+      m_highestSack = GetHighestSacked ();
+      if (m_retxCursor > m_firstByteSeq + m_sentSize)
+        {
+          m_retxCursor = m_firstByteSeq + m_sentSize;
+        }
     }
 }
 
@@ -1013,7 +1291,9 @@ TcpTxBuffer::SetSentListLost ()
 
   for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
     {
+      RemoveFromCounters (*it);
       (*it)->m_lost = true;
+      AddToCounters (*it);
     }
 }
 
@@ -1155,6 +1435,7 @@ operator<< (std::ostream & os, TcpTxBuffer const & tcpTxBuf)
     " m_sentSize = " << tcpTxBuf.m_sentSize;
 
   NS_ASSERT (sentSize == tcpTxBuf.m_sentSize);
+  NS_ASSERT (tcpTxBuf.m_sentIndex.size () == tcpTxBuf.m_sentList.size ());
   NS_ASSERT (tcpTxBuf.m_size - tcpTxBuf.m_sentSize == appSize);
   return os;
 }
@@ -27,6 +27,8 @@
 #include "ns3/sequence-number.h"
 #include "ns3/nstime.h"
 #include "ns3/tcp-option-sack.h"
+#include <list>
+#include <map>
 
 namespace ns3 {
 class Packet;
@@ -106,18 +108,41 @@ public:
  * documentation) and maintaining the scoreboard is a matter of travelling the
  * list and set the SACK flag on the corresponding segment sent.
  *
- * Inefficiencies
- * --------------
+ * Indexing and counters
+ * ---------------------
  *
- * The algorithms outlined in RFC 6675 are full of inefficiencies. In
- * particular, traveling all the sent list each time it is needed to compute
- * the bytes in flight is expensive. We try to overcome the issue by
- * maintaining a pointer to the highest sequence SACKed; in this way, we can
- * avoid traveling all the list in some cases. Another option could be keeping
- * a count of each critical value (e.g., the number of packets sacked).
- * However, this would be different from the algorithms in RFC. There are some
- * other possible improvements; if you wish, take a look and try  to add some
- * earlier exit conditions in the loops.
+ * The algorithms outlined in RFC 6675 are full of inefficiencies: taken
+ * literally, computing the bytes in flight calls IsLost on every segment,
+ * and each IsLost travels the sent list up to the highest SACKed segment,
+ * which makes the cost of each ACK quadratic in the number of outstanding
+ * segments. To overcome the issue, the buffer keeps:
+ *
+ * - an index of the sent list, keyed by the first sequence number of each
+ *   segment, so that the segment holding a given sequence (for a
+ *   retransmission, a SACK block or a call to IsLost) is found in
+ *   logarithmic time, instead of walking the list from its head;
+ * - the number of SACKed segments and the number of SACKed, lost and
+ *   retransmitted bytes in the sent list, updated each time a segment
+ *   changes, so that BytesInFlight is computed in constant time when the
+ *   SACKed data is not enough to declare any segment lost;
+ * - a pointer to the highest sequence SACKed, which bounds the walks
+ *   needed otherwise.
+ *
+ * Since the number of SACKed segments above a sequence only decreases
+ * while the sequence grows, the segments lost according to the SACK
+ * information are all below a boundary, found by walking the sent list
+ * backwards from the highest SACKed segment until enough SACKed data is
+ * met. The boundary is cached until the SACKed segments change, and
+ * IsLost compares its sequence with it.
+ *
+ * The buffer also keeps a cursor on the first segment which is neither
+ * SACKed nor retransmitted: the segments before it cannot be returned by
+ * NextSeg, which starts its walk from the cursor. The cursor moves forward
+ * when a SACK block or a retransmission covers it, and goes back to the
+ * head when the scoreboard or the sent list are reset. BytesInFlight
+ * subtracts from the counters the bytes lost per SACK which are not
+ * retransmitted yet, which lie between the cursor and the boundary, and
+ * is cached until the scoreboard changes.
  *
  * \see Size
  * \see SizeFromSequence
@@ -320,6 +345,8 @@ private:
   friend std::ostream & operator<< (std::ostream & os, TcpTxBuffer const & tcpTxBuf);
 
   typedef std::list<TcpTxItem*> PacketList; //!< container for data stored in the buffer
+  /// Index of the sent list, keyed by the first sequence number of each item
+  typedef std::map<SequenceNumber32, PacketList::iterator> SentIndex;
 
   /**
    * \brief Check if a segment is lost per RFC 6675
@@ -332,6 +359,81 @@ private:
   bool IsLost (const SequenceNumber32 &seq, const PacketList::const_iterator &segment, uint32_t dupThresh,
                uint32_t segmentSize) const;
 
+  /**
+   * \brief Check if enough data has been SACKed to declare lost what is below it
+   *
+   * This is the condition of RFC 6675 IsLost on the SACKed data above a sequence.
+   *
+   * \param sackedSegments number of SACKed segments above the sequence
+   * \param sackedBytes number of SACKed bytes above the sequence
+   * \param dupThresh dupAck threshold
+   * \param segmentSize segment size
+   * \return true if the segments below are lost
+   */
+  bool IsSackThresholdReached (uint32_t sackedSegments, uint32_t sackedBytes,
+                               uint32_t dupThresh, uint32_t segmentSize) const;
+
+  /**
+   * \brief Get the boundary below which the SACK information declares the
+   * segments lost
+   *
+   * The boundary is cached until the SACKed segments change. It is
+   * computed walking the sent list backwards from the highest SACKed
+   * segment until enough SACKed data is found, so that the segments sent
+   * after the highest SACK are not walked.
+   *
+   * \param dupThresh dupAck threshold
+   * \param segmentSize segment size
+   * \return the first sequence number of the SACKed segment which reaches
+   * the threshold, or HeadSequence () if no segment is lost per SACK
+   */
+  SequenceNumber32 GetLostBoundary (uint32_t dupThresh, uint32_t segmentSize) const;
+
+  /**
+   * \brief Get the bytes which are lost per SACK, but neither marked as lost
+   * nor retransmitted
+   *
+   * These bytes are below the lost boundary, and, as they are not SACKed
+   * nor retransmitted, not below the retransmission cursor: only the
+   * segments in between are walked.
+   *
+   * \param lostBoundary the lost boundary
+   * \return the number of bytes
+   */
+  uint32_t GetLostPerSackBytes (const SequenceNumber32 &lostBoundary) const;
+
+  /**
+   * \brief Move the retransmission cursor past the segments which are
+   * SACKed or retransmitted
+   */
+  void AdvanceRetxCursor ();
+
+  /**
+   * \brief Find the sent segment which holds a sequence number
+   *
+   * \param seq the sequence number, which must be in the sent list
+   * \param begin output parameter, set to the first sequence number of the segment
+   * \return an iterator to the segment in m_sentList
+   */
+  PacketList::iterator FindSentSegment (const SequenceNumber32 &seq, SequenceNumber32 *begin);
+
+  /**
+   * \brief Account an item of the sent list in the scoreboard counters
+   *
+   * The counters change with the scoreboard, which makes the cached
+   * BytesInFlight, and the cached lost boundary when the item is SACKed,
+   * out of date.
+   *
+   * \param item the item
+   */
+  void AddToCounters (const TcpTxItem *item);
+
+  /**
+   * \brief Remove an item of the sent list from the scoreboard counters
+   * \param item the item
+   */
+  void RemoveFromCounters (const TcpTxItem *item);
+
   /**
    * \brief Get a block of data not transmitted yet and move it into SentList
    *
@@ -427,16 +529,22 @@ private:
    * MSS can change, but it is stable, and retransmissions do not happen for
    * each segment).
    *
+   * The walk starts from \p start, which must not be after the requested
+   * block. When the list is the sent list, the index and the scoreboard
+   * counters are kept up to date with the fragment and merge operations.
+   *
    * \param list List to extract block from
-   * \param startingSeq Starting sequence of the list
+   * \param start Item of the list where the walk starts
+   * \param startingSeq Starting sequence of the start item
    * \param numBytes Bytes to extract, starting from requestedSeq
    * \param requestedSeq Requested sequence
    * \param listEdited output parameter which indicates if the list has been edited
    * \return the item that contains the right packet
    */
-  TcpTxItem* GetPacketFromList (PacketList &list, const SequenceNumber32 &startingSeq,
+  TcpTxItem* GetPacketFromList (PacketList &list, PacketList::iterator start,
+                                const SequenceNumber32 &startingSeq,
                                 uint32_t numBytes, const SequenceNumber32 &requestedSeq,
-                                bool *listEdited) const;
+                                bool *listEdited);
 
   /**
    * \brief Merge two TcpTxItem
@@ -463,7 +571,12 @@ private:
 
   /**
    * \brief Find the highest SACK byte
-   * \return a pair with the highest byte and an iterator inside m_sentList
+   *
+   * The sent list is walked backwards, down to the highest SACKed segment.
+   *
+   * \return a pair with an iterator to the segment following the highest
+   * SACKed one inside m_sentList, and the sequence number following the
+   * highest SACKed byte
    */
   std::pair <TcpTxBuffer::PacketList::const_iterator, SequenceNumber32>
   GetHighestSacked () const;
@@ -474,10 +587,25 @@ private:
   uint32_t m_size;       //!< Size of all data in this buffer
   uint32_t m_sentSize;   //!< Size of sent (and not discarded) segments
 
+  SentIndex m_sentIndex;   //!< Index of m_sentList
+  uint32_t m_sackedOut;    //!< Number of SACKed segments in m_sentList
+  uint32_t m_sackedBytes;  //!< SACKed bytes in m_sentList
+  uint32_t m_lostBytes;    //!< Bytes marked as lost, and not SACKed, in m_sentList
+  uint32_t m_retransBytes; //!< Bytes retransmitted, and neither lost nor SACKed, in m_sentList
+
   TracedValue<SequenceNumber32> m_firstByteSeq; //!< Sequence number of the first byte in data (SND.UNA)
 
   std::pair <PacketList::const_iterator, SequenceNumber32> m_highestSack; //!< Highest SACK byte
 
+  /// The segments starting below are all SACKed or retransmitted
+  SequenceNumber32 m_retxCursor;
+
+  mutable bool m_lostBoundaryValid;              //!< True if m_lostBoundary is up to date
+  mutable SequenceNumber32 m_lostBoundary;       //!< Cached lost boundary
+  mutable bool m_bytesInFlightValid;             //!< True if m_bytesInFlight is up to date
+  mutable uint32_t m_bytesInFlight;              //!< Cached BytesInFlight
+  mutable std::pair<uint32_t, uint32_t> m_cacheKey; //!< dupThresh and segment size of the cached values
+
 };
 
 /**
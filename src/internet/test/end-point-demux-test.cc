@@ -0,0 +1,223 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/ipv4-interface-address.h"
+#include "../model/ipv4-end-point.h"
+#include "../model/ipv4-end-point-demux.h"
+#include "../model/ipv6-end-point.h"
+#include "../model/ipv6-end-point-demux.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Ipv4EndPointDemux lookup test
+ *
+ * Checks the precedence of the matches, the reindexing of the endpoints
+ * whose addresses change, and the removal of the endpoints.
+ */
+class Ipv4EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv4EndPointDemuxTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Lookup an endpoint and check that it is the only match.
+   * \param demux the demux
+   * \param daddr destination address
+   * \param dport destination port
+   * \param saddr source address
+   * \param sport source port
+   * \param expected the expected endpoint, or 0 for no match
+   * \param msg the message to print on failure
+   */
+  void CheckLookup (Ipv4EndPointDemux &demux, Ipv4Address daddr, uint16_t dport,
+                    Ipv4Address saddr, uint16_t sport, Ipv4EndPoint *expected,
+                    std::string msg);
+
+  Ptr<Ipv4Interface> m_interface; //!< the incoming interface
+};
+
+Ipv4EndPointDemuxTestCase::Ipv4EndPointDemuxTestCase ()
+  : TestCase ("Ipv4EndPointDemux lookup")
+{
+}
+
+void
+Ipv4EndPointDemuxTestCase::CheckLookup (Ipv4EndPointDemux &demux, Ipv4Address daddr, uint16_t dport,
+                                        Ipv4Address saddr, uint16_t sport, Ipv4EndPoint *expected,
+                                        std::string msg)
+{
+  Ipv4EndPointDemux::EndPoints found = demux.Lookup (daddr, dport, saddr, sport, m_interface);
+  NS_TEST_EXPECT_MSG_EQ (found.size (), (expected == 0 ? 0 : 1), msg);
+  if (expected != 0 && found.size () == 1)
+    {
+      NS_TEST_EXPECT_MSG_EQ (found.front (), expected, msg);
+    }
+}
+
+void
+Ipv4EndPointDemuxTestCase::DoRun (void)
+{
+  m_interface = CreateObject<Ipv4Interface> ();
+  m_interface->AddAddress (Ipv4InterfaceAddress (Ipv4Address ("10.0.0.1"), Ipv4Mask ("255.255.255.0")));
+
+  Ipv4Address local ("10.0.0.1");
+  Ipv4EndPointDemux demux;
+  Ipv4EndPoint *listener = demux.Allocate (80);
+  Ipv4EndPoint *bound = demux.Allocate (local, 80);
+  Ipv4EndPoint *connected = demux.Allocate (local, 80, Ipv4Address ("10.0.0.2"), 1000);
+  Ipv4EndPoint *wildConnected = demux.Allocate (Ipv4Address::GetAny (), 80, Ipv4Address ("10.0.0.3"), 2000);
+
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate (local, 80), 0, "Duplicate address and port allowed");
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate (local, 80, Ipv4Address ("10.0.0.2"), 1000), 0,
+                         "Duplicate four-tuple allowed");
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (80), true, "Port 80 should be in use");
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (81), false, "Port 81 should be free");
+
+  CheckLookup (demux, local, 80, Ipv4Address ("10.0.0.2"), 1000, connected, "Exact match expected");
+  CheckLookup (demux, local, 80, Ipv4Address ("10.0.0.3"), 2000, wildConnected, "Match on all but local address expected");
+  CheckLookup (demux, local, 80, Ipv4Address ("10.0.0.4"), 3000, bound, "Match on local address and port expected");
+  CheckLookup (demux, Ipv4Address ("10.0.1.1"), 80, Ipv4Address ("10.0.0.4"), 3000, listener, "Match on local port expected");
+  CheckLookup (demux, local, 81, Ipv4Address ("10.0.0.2"), 1000, 0, "No match expected");
+
+  // a subnet-directed broadcast matches the bound and wildcard endpoints,
+  // in allocation order
+  Ipv4EndPointDemux::EndPoints found = demux.Lookup (Ipv4Address ("10.0.0.255"), 80,
+                                                     Ipv4Address ("10.0.0.4"), 3000, m_interface);
+  NS_TEST_EXPECT_MSG_EQ (found.size (), 2, "Two endpoints should receive the broadcast");
+  NS_TEST_EXPECT_MSG_EQ (found.front (), listener, "Matches not in allocation order");
+  NS_TEST_EXPECT_MSG_EQ (found.back (), bound, "Matches not in allocation order");
+
+  // an endpoint whose addresses change is found with its new addresses only
+  Ipv4EndPoint *client = demux.Allocate ();
+  uint16_t port = client->GetLocalPort ();
+  CheckLookup (demux, local, port, Ipv4Address ("10.0.0.5"), 80, client, "Unconnected endpoint expected");
+  client->SetLocalAddress (local);
+  client->SetPeer (Ipv4Address ("10.0.0.5"), 80);
+  CheckLookup (demux, local, port, Ipv4Address ("10.0.0.5"), 80, client, "Connected endpoint expected");
+  CheckLookup (demux, local, port, Ipv4Address ("10.0.0.6"), 80, 0, "Stale match on the old addresses");
+  NS_TEST_EXPECT_MSG_EQ (demux.SimpleLookup (local, port, Ipv4Address ("10.0.0.5"), 80), client,
+                         "Exact simple lookup expected");
+  demux.Allocate (8080);
+  Ipv4EndPoint *bound8080 = demux.Allocate (local, 8080);
+  NS_TEST_EXPECT_MSG_EQ (demux.SimpleLookup (local, 8080, Ipv4Address ("10.0.0.9"), 9), bound8080,
+                         "Most specific simple lookup expected");
+  client->SetRxEnabled (false);
+  CheckLookup (demux, local, port, Ipv4Address ("10.0.0.5"), 80, 0, "Endpoint with Rx disabled matched");
+
+  // removal
+  demux.DeAllocate (connected);
+  CheckLookup (demux, local, 80, Ipv4Address ("10.0.0.2"), 1000, bound, "Removed endpoint matched");
+  NS_TEST_EXPECT_MSG_NE (demux.Allocate (local, 80, Ipv4Address ("10.0.0.2"), 1000), 0,
+                         "Four-tuple not released");
+  demux.DeAllocate (client);
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (port), false, "Ephemeral port not released");
+  NS_TEST_EXPECT_MSG_EQ (demux.GetAllEndPoints ().size (), 6, "Unexpected number of endpoints");
+
+  // many connections to the same listening port
+  for (uint16_t i = 0; i < 1000; i++)
+    {
+      demux.Allocate (local, 80, Ipv4Address ("10.1.0.1"), 1024 + i);
+    }
+  Ipv4EndPoint *last = demux.Allocate (local, 80, Ipv4Address ("10.1.0.2"), 1024);
+  CheckLookup (demux, local, 80, Ipv4Address ("10.1.0.2"), 1024, last, "Exact match expected among many");
+  CheckLookup (demux, local, 80, Ipv4Address ("10.1.0.2"), 1025, bound, "Bound endpoint expected among many");
+
+  m_interface = 0;
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Ipv6EndPointDemux lookup test
+ */
+class Ipv6EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv6EndPointDemuxTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+Ipv6EndPointDemuxTestCase::Ipv6EndPointDemuxTestCase ()
+  : TestCase ("Ipv6EndPointDemux lookup")
+{
+}
+
+void
+Ipv6EndPointDemuxTestCase::DoRun (void)
+{
+  Ipv6Address local ("2001:1::1");
+  Ipv6Address peer ("2001:1::2");
+  Ipv6EndPointDemux demux;
+  Ipv6EndPoint *listener = demux.Allocate (80);
+  Ipv6EndPoint *bound = demux.Allocate (local, 80);
+  Ipv6EndPoint *connected = demux.Allocate (local, 80, peer, 1000);
+
+  Ipv6EndPointDemux::EndPoints found = demux.Lookup (local, 80, peer, 1000, 0);
+  NS_TEST_EXPECT_MSG_EQ ((found.size () == 1 && found.front () == connected), true, "Exact match expected");
+  found = demux.Lookup (local, 80, peer, 1001, 0);
+  NS_TEST_EXPECT_MSG_EQ ((found.size () == 1 && found.front () == bound), true,
+                         "Match on local address and port expected");
+  found = demux.Lookup (Ipv6Address ("2001:1::3"), 80, peer, 1001, 0);
+  NS_TEST_EXPECT_MSG_EQ ((found.size () == 1 && found.front () == listener), true,
+                         "Match on local port expected");
+
+  Ipv6EndPoint *client = demux.Allocate ();
+  uint16_t port = client->GetLocalPort ();
+  client->SetLocalAddress (local);
+  client->SetPeer (peer, 80);
+  found = demux.Lookup (local, port, peer, 80, 0);
+  NS_TEST_EXPECT_MSG_EQ ((found.size () == 1 && found.front () == client), true,
+                         "Connected endpoint expected");
+  NS_TEST_EXPECT_MSG_EQ (demux.SimpleLookup (local, port, peer, 80), client, "Exact simple lookup expected");
+
+  demux.DeAllocate (connected);
+  found = demux.Lookup (local, 80, peer, 1000, 0);
+  NS_TEST_EXPECT_MSG_EQ ((found.size () == 1 && found.front () == bound), true, "Removed endpoint matched");
+  demux.DeAllocate (client);
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (port), false, "Ephemeral port not released");
+  NS_TEST_EXPECT_MSG_EQ (demux.GetEndPoints ().size (), 2, "Unexpected number of endpoints");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief End point demux TestSuite
+ */
+class EndPointDemuxTestSuite : public TestSuite
+{
+public:
+  EndPointDemuxTestSuite ()
+    : TestSuite ("end-point-demux", UNIT)
+  {
+    AddTestCase (new Ipv4EndPointDemuxTestCase, TestCase::QUICK);
+    AddTestCase (new Ipv6EndPointDemuxTestCase, TestCase::QUICK);
+  }
+};
+
+static EndPointDemuxTestSuite g_endPointDemuxTestSuite; //!< Static variable for test initialization
@@ -48,6 +48,7 @@
 #include "ns3/error-channel.h"
 
 #include <string>
+#include <vector>
 #include <limits>
 #include <netinet/in.h>
 
@@ -512,6 +513,182 @@ Ipv4FragmentationTest::DoRun (void)
 }
 
 
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief IPv4 Reassembly Test: out of order, overlapping and duplicate
+ * fragments, many small fragments, timeouts and memory limit.
+ */
+class Ipv4FragmentReassemblyTest : public TestCase
+{
+  Ptr<Ipv4L3Protocol> m_ipv4;     //!< IPv4 of the receiving node.
+  Ptr<NetDevice> m_device;        //!< Device of the receiving node.
+  uint8_t m_data[8000];           //!< Payload of the packets.
+  std::vector<Ptr<Packet> > m_delivered; //!< Reassembled packets.
+  std::vector<Time> m_timeouts;   //!< Times of the fragment drops.
+
+public:
+  virtual void DoRun (void);
+  Ipv4FragmentReassemblyTest ();
+
+  /**
+   * \brief Receive a fragment of a packet.
+   * \param id The identification of the packet.
+   * \param offset The offset of the fragment, multiple of 8.
+   * \param size The size of the fragment.
+   * \param last True if it is the last fragment.
+   */
+  void ReceiveFragment (uint16_t id, uint16_t offset, uint16_t size, bool last);
+  /**
+   * \brief Trace the packets delivered locally.
+   * \param header The IPv4 header.
+   * \param packet The packet.
+   * \param iif The interface.
+   */
+  void LocalDeliver (const Ipv4Header &header, Ptr<const Packet> packet, uint32_t iif);
+  /**
+   * \brief Trace the packets dropped.
+   * \param header The IPv4 header.
+   * \param packet The packet.
+   * \param reason The drop reason.
+   * \param ipv4 The IPv4 protocol.
+   * \param iif The interface.
+   */
+  void Drop (const Ipv4Header &header, Ptr<const Packet> packet, Ipv4L3Protocol::DropReason reason,
+             Ptr<Ipv4> ipv4, uint32_t iif);
+  /**
+   * \brief Check that a packet has been reassembled.
+   * \param size The size of the packet.
+   * \param msg The test message.
+   */
+  void CheckDelivered (uint32_t size, std::string msg);
+};
+
+Ipv4FragmentReassemblyTest::Ipv4FragmentReassemblyTest ()
+  : TestCase ("Reassemble IPv4 fragments")
+{
+  for (uint32_t i = 0; i < sizeof (m_data); i++)
+    {
+      m_data[i] = i * 7 + i / 251;
+    }
+}
+
+void
+Ipv4FragmentReassemblyTest::ReceiveFragment (uint16_t id, uint16_t offset, uint16_t size, bool last)
+{
+  Ptr<Packet> p = Create<Packet> (m_data + offset, size);
+  Ipv4Header header;
+  header.SetSource (Ipv4Address ("10.0.0.2"));
+  header.SetDestination (Ipv4Address ("10.0.0.1"));
+  header.SetProtocol (253);
+  header.SetIdentification (id);
+  header.SetPayloadSize (size);
+  header.SetFragmentOffset (offset);
+  if (last)
+    {
+      header.SetLastFragment ();
+    }
+  else
+    {
+      header.SetMoreFragments ();
+    }
+  p->AddHeader (header);
+  m_ipv4->Receive (m_device, p, Ipv4L3Protocol::PROT_NUMBER, m_device->GetBroadcast (),
+                   m_device->GetAddress (), NetDevice::PACKET_HOST);
+}
+
+void
+Ipv4FragmentReassemblyTest::LocalDeliver (const Ipv4Header &header, Ptr<const Packet> packet, uint32_t iif)
+{
+  m_delivered.push_back (packet->Copy ());
+}
+
+void
+Ipv4FragmentReassemblyTest::Drop (const Ipv4Header &header, Ptr<const Packet> packet, Ipv4L3Protocol::DropReason reason,
+                                  Ptr<Ipv4> ipv4, uint32_t iif)
+{
+  if (reason == Ipv4L3Protocol::DROP_FRAGMENT_TIMEOUT)
+    {
+      m_timeouts.push_back (Simulator::Now ());
+    }
+}
+
+void
+Ipv4FragmentReassemblyTest::CheckDelivered (uint32_t size, std::string msg)
+{
+  NS_TEST_ASSERT_MSG_EQ (m_delivered.size (), 1, msg << ": packet not reassembled");
+  NS_TEST_EXPECT_MSG_EQ (m_delivered[0]->GetSize (), size, msg << ": packet size not correct");
+  uint8_t buffer[sizeof (m_data)];
+  m_delivered[0]->CopyData (buffer, size);
+  NS_TEST_EXPECT_MSG_EQ (memcmp (buffer, m_data, size), 0, msg << ": packet content differs");
+  m_delivered.clear ();
+}
+
+void
+Ipv4FragmentReassemblyTest::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  SimpleNetDeviceHelper helperChannel;
+  NetDeviceContainer net = helperChannel.Install (node);
+  InternetStackHelper internet;
+  internet.Install (node);
+
+  m_device = net.Get (0);
+  m_ipv4 = node->GetObject<Ipv4L3Protocol> ();
+  uint32_t netdev_idx = m_ipv4->AddInterface (m_device);
+  m_ipv4->AddAddress (netdev_idx, Ipv4InterfaceAddress (Ipv4Address ("10.0.0.1"), Ipv4Mask (0xffff0000U)));
+  m_ipv4->SetUp (netdev_idx);
+  m_ipv4->TraceConnectWithoutContext ("LocalDeliver", MakeCallback (&Ipv4FragmentReassemblyTest::LocalDeliver, this));
+  m_ipv4->TraceConnectWithoutContext ("Drop", MakeCallback (&Ipv4FragmentReassemblyTest::Drop, this));
+
+  // out of order, overlapping and duplicate fragments
+  ReceiveFragment (1, 2400, 1600, true);
+  ReceiveFragment (1, 0, 1000, false);
+  ReceiveFragment (1, 800, 1200, false);
+  ReceiveFragment (1, 0, 1000, false);
+  ReceiveFragment (1, 1000, 600, false);
+  NS_TEST_EXPECT_MSG_EQ (m_delivered.size (), 0, "Packet reassembled with a hole");
+  ReceiveFragment (1, 1600, 1600, false);
+  CheckDelivered (4000, "Overlapping fragments");
+
+  // many small fragments, in reverse order
+  for (int32_t offset = 8000 - 8; offset >= 0; offset -= 8)
+    {
+      ReceiveFragment (2, offset, 8, offset == 8000 - 8);
+    }
+  CheckDelivered (8000, "Small fragments");
+
+  // a single timer expires the incomplete packets in order
+  for (uint16_t id = 3; id < 6; id++)
+    {
+      Simulator::Schedule (Seconds (id), &Ipv4FragmentReassemblyTest::ReceiveFragment, this, id, 0, 1000, false);
+    }
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_timeouts.size (), 3, "Incomplete packets not expired");
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_timeouts[i], Seconds (33 + i), "Incomplete packet expired at the wrong time");
+    }
+  m_timeouts.clear ();
+
+  // the oldest packets are dropped when the buffer is full
+  m_ipv4->SetAttribute ("FragmentBufferSize", UintegerValue (3000));
+  for (uint16_t id = 10; id < 14; id++)
+    {
+      ReceiveFragment (id, 0, 1000, false);
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_timeouts.size (), 1, "Oldest packet not evicted");
+  ReceiveFragment (11, 1000, 1000, true);
+  CheckDelivered (2000, "Packet after eviction");
+  ReceiveFragment (10, 1000, 1000, true);
+  NS_TEST_EXPECT_MSG_EQ (m_delivered.size (), 0, "Evicted packet reassembled");
+  NS_TEST_EXPECT_MSG_EQ (m_timeouts.size (), 1, "Packet evicted below the limit");
+
+  Simulator::Destroy ();
+}
+
+
 /**
  * \ingroup internet-test
  * \ingroup tests
@@ -528,6 +705,7 @@ Ipv4FragmentationTestSuite::Ipv4FragmentationTestSuite ()
   : TestSuite ("ipv4-fragmentation", UNIT)
 {
   AddTestCase (new Ipv4FragmentationTest, TestCase::QUICK);
+  AddTestCase (new Ipv4FragmentReassemblyTest, TestCase::QUICK);
 }
 
 static Ipv4FragmentationTestSuite g_ipv4fragmentationTestSuite; //!< Static variable for test initialization
@@ -265,6 +265,89 @@ Ipv4HeaderTest::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief IPv4 Header incremental checksum Test
+ *
+ * Checks that the checksum of a deserialized header stays correct while
+ * its TTL and TOS are updated incrementally, and once another field is
+ * changed.
+ */
+class Ipv4HeaderChecksumTest : public TestCase
+{
+public:
+  Ipv4HeaderChecksumTest ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Serialize a header and read it back with checksums enabled.
+   * \param header the header to serialize
+   * \return the header read back
+   */
+  Ipv4Header RoundTrip (const Ipv4Header &header);
+};
+
+Ipv4HeaderChecksumTest::Ipv4HeaderChecksumTest ()
+  : TestCase ("IPv4 Header incremental checksum Test")
+{
+}
+
+Ipv4Header
+Ipv4HeaderChecksumTest::RoundTrip (const Ipv4Header &header)
+{
+  Ptr<Packet> p = Create<Packet> (100);
+  p->AddHeader (header);
+  Ipv4Header received;
+  received.EnableChecksum ();
+  p->RemoveHeader (received);
+  return received;
+}
+
+void
+Ipv4HeaderChecksumTest::DoRun (void)
+{
+  Ipv4Header header;
+  header.EnableChecksum ();
+  header.SetSource (Ipv4Address ("10.1.2.3"));
+  header.SetDestination (Ipv4Address ("192.168.200.1"));
+  header.SetProtocol (17);
+  header.SetPayloadSize (100);
+  header.SetIdentification (0xbeef);
+  header.SetTtl (255);
+
+  Ipv4Header forwarded = RoundTrip (header);
+  NS_TEST_ASSERT_MSG_EQ (forwarded.IsChecksumOk (), true, "Bad checksum of the original header");
+  // every TTL value crosses a carry of the one's complement sum at some point
+  for (uint32_t ttl = 254; ttl > 0; ttl--)
+    {
+      forwarded.SetTtl (forwarded.GetTtl () - 1);
+      forwarded = RoundTrip (forwarded);
+      NS_TEST_EXPECT_MSG_EQ (forwarded.IsChecksumOk (), true, "Bad checksum after setting the TTL to " << ttl);
+      NS_TEST_EXPECT_MSG_EQ (static_cast<uint32_t> (forwarded.GetTtl ()), ttl, "Unexpected TTL");
+    }
+
+  // the TOS is updated incrementally too
+  forwarded.SetTtl (64);
+  forwarded.SetEcn (Ipv4Header::ECN_CE);
+  forwarded = RoundTrip (forwarded);
+  NS_TEST_EXPECT_MSG_EQ (forwarded.IsChecksumOk (), true, "Bad checksum after setting the ECN field");
+  NS_TEST_EXPECT_MSG_EQ (forwarded.GetEcn (), Ipv4Header::ECN_CE, "Unexpected ECN field");
+  forwarded.SetDscp (Ipv4Header::DSCP_EF);
+  forwarded = RoundTrip (forwarded);
+  NS_TEST_EXPECT_MSG_EQ (forwarded.IsChecksumOk (), true, "Bad checksum after setting the DSCP field");
+
+  // the other fields force a full computation
+  forwarded.SetTtl (63);
+  forwarded.SetIdentification (1);
+  forwarded = RoundTrip (forwarded);
+  NS_TEST_EXPECT_MSG_EQ (forwarded.IsChecksumOk (), true, "Bad checksum after setting the identification");
+  NS_TEST_EXPECT_MSG_EQ (static_cast<uint32_t> (forwarded.GetTtl ()), 63, "Unexpected TTL");
+}
+
 /**
  * \ingroup internet-test
  * \ingroup tests
@@ -277,6 +360,7 @@ public:
   Ipv4HeaderTestSuite () : TestSuite ("ipv4-header", UNIT)
   {
     AddTestCase (new Ipv4HeaderTest, TestCase::QUICK);
+    AddTestCase (new Ipv4HeaderChecksumTest, TestCase::QUICK);
   }
 };
 
@@ -56,8 +56,13 @@
 #include "ns3/traffic-control-layer.h"
 #include "ns3/internet-stack-helper.h"
 #include "ns3/error-channel.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/ipv6-extension.h"
+#include "ns3/ipv6-extension-demux.h"
+#include "ns3/ipv6-extension-header.h"
 
 #include <string>
+#include <vector>
 #include <limits>
 #include <netinet/in.h>
 
@@ -524,6 +529,176 @@ Ipv6FragmentationTest::DoRun (void)
 }
 
 
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief IPv6 Reassembly Test: out of order and overlapping fragments,
+ * many small fragments, timeouts and memory limit.
+ */
+class Ipv6FragmentReassemblyTest : public TestCase
+{
+  Ptr<Ipv6L3Protocol> m_ipv6;     //!< IPv6 of the receiving node.
+  Ptr<NetDevice> m_device;        //!< Device of the receiving node.
+  uint8_t m_data[8000];           //!< Payload of the packets.
+  std::vector<Ptr<Packet> > m_delivered; //!< Reassembled packets.
+  std::vector<Time> m_timeouts;   //!< Times of the fragment drops.
+
+public:
+  virtual void DoRun (void);
+  Ipv6FragmentReassemblyTest ();
+
+  /**
+   * \brief Receive a fragment of a packet.
+   * \param id The identification of the packet.
+   * \param offset The offset of the fragment, multiple of 8.
+   * \param size The size of the fragment.
+   * \param last True if it is the last fragment.
+   */
+  void ReceiveFragment (uint32_t id, uint16_t offset, uint16_t size, bool last);
+  /**
+   * \brief Trace the packets dropped.
+   *
+   * The reassembled packets carry an unknown protocol, so that they are
+   * dropped too.
+   *
+   * \param header The IPv6 header.
+   * \param packet The packet.
+   * \param reason The drop reason.
+   * \param ipv6 The IPv6 protocol.
+   * \param iif The interface.
+   */
+  void Drop (const Ipv6Header &header, Ptr<const Packet> packet, Ipv6L3Protocol::DropReason reason,
+             Ptr<Ipv6> ipv6, uint32_t iif);
+  /**
+   * \brief Check that a packet has been reassembled.
+   * \param size The size of the packet.
+   * \param msg The test message.
+   */
+  void CheckDelivered (uint32_t size, std::string msg);
+};
+
+Ipv6FragmentReassemblyTest::Ipv6FragmentReassemblyTest ()
+  : TestCase ("Reassemble IPv6 fragments")
+{
+  for (uint32_t i = 0; i < sizeof (m_data); i++)
+    {
+      m_data[i] = i * 7 + i / 251;
+    }
+}
+
+void
+Ipv6FragmentReassemblyTest::ReceiveFragment (uint32_t id, uint16_t offset, uint16_t size, bool last)
+{
+  Ptr<Packet> p = Create<Packet> (m_data + offset, size);
+  Ipv6ExtensionFragmentHeader fragmentHeader;
+  fragmentHeader.SetNextHeader (253);
+  fragmentHeader.SetIdentification (id);
+  fragmentHeader.SetOffset (offset);
+  fragmentHeader.SetMoreFragment (!last);
+  p->AddHeader (fragmentHeader);
+  Ipv6Header header;
+  header.SetSourceAddress (Ipv6Address ("2001::2"));
+  header.SetDestinationAddress (Ipv6Address ("2001::1"));
+  header.SetNextHeader (Ipv6Header::IPV6_EXT_FRAGMENTATION);
+  header.SetPayloadLength (p->GetSize ());
+  header.SetHopLimit (64);
+  p->AddHeader (header);
+  m_ipv6->Receive (m_device, p, Ipv6L3Protocol::PROT_NUMBER, m_device->GetBroadcast (),
+                   m_device->GetAddress (), NetDevice::PACKET_HOST);
+}
+
+void
+Ipv6FragmentReassemblyTest::Drop (const Ipv6Header &header, Ptr<const Packet> packet, Ipv6L3Protocol::DropReason reason,
+                                  Ptr<Ipv6> ipv6, uint32_t iif)
+{
+  if (reason == Ipv6L3Protocol::DROP_UNKNOWN_PROTOCOL)
+    {
+      m_delivered.push_back (packet->Copy ());
+    }
+  else if (reason == Ipv6L3Protocol::DROP_FRAGMENT_TIMEOUT)
+    {
+      m_timeouts.push_back (Simulator::Now ());
+    }
+}
+
+void
+Ipv6FragmentReassemblyTest::CheckDelivered (uint32_t size, std::string msg)
+{
+  NS_TEST_ASSERT_MSG_EQ (m_delivered.size (), 1, msg << ": packet not reassembled");
+  NS_TEST_EXPECT_MSG_EQ (m_delivered[0]->GetSize (), size, msg << ": packet size not correct");
+  uint8_t buffer[sizeof (m_data)];
+  m_delivered[0]->CopyData (buffer, size);
+  NS_TEST_EXPECT_MSG_EQ (memcmp (buffer, m_data, size), 0, msg << ": packet content differs");
+  m_delivered.clear ();
+}
+
+void
+Ipv6FragmentReassemblyTest::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  SimpleNetDeviceHelper helperChannel;
+  NetDeviceContainer net = helperChannel.Install (node);
+  InternetStackHelper internet;
+  internet.SetIpv4StackInstall (false);
+  internet.Install (node);
+
+  m_device = net.Get (0);
+  m_ipv6 = node->GetObject<Ipv6L3Protocol> ();
+  uint32_t netdev_idx = m_ipv6->AddInterface (m_device);
+  m_ipv6->AddAddress (netdev_idx, Ipv6InterfaceAddress (Ipv6Address ("2001::1"), Ipv6Prefix (32)));
+  m_ipv6->SetUp (netdev_idx);
+  m_ipv6->TraceConnectWithoutContext ("Drop", MakeCallback (&Ipv6FragmentReassemblyTest::Drop, this));
+
+  // out of order fragments
+  ReceiveFragment (1, 2400, 1600, false);
+  ReceiveFragment (1, 4000, 1000, true);
+  ReceiveFragment (1, 1000, 1400, false);
+  NS_TEST_EXPECT_MSG_EQ (m_delivered.size (), 0, "Packet reassembled with a hole");
+  ReceiveFragment (1, 0, 1000, false);
+  CheckDelivered (5000, "Out of order fragments");
+
+  // many small fragments, in reverse order
+  for (int32_t offset = 8000 - 8; offset >= 0; offset -= 8)
+    {
+      ReceiveFragment (2, offset, 8, offset == 8000 - 8);
+    }
+  CheckDelivered (8000, "Small fragments");
+
+  // overlapping fragments are not reassembled (RFC 5722), and a single
+  // timer expires the incomplete packets in order
+  ReceiveFragment (3, 0, 1000, false);
+  ReceiveFragment (3, 800, 1200, true);
+  NS_TEST_EXPECT_MSG_EQ (m_delivered.size (), 0, "Overlapping fragments reassembled");
+  for (uint32_t id = 4; id < 6; id++)
+    {
+      Simulator::Schedule (Seconds (id), &Ipv6FragmentReassemblyTest::ReceiveFragment, this, id, 0, 1000, false);
+    }
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_timeouts.size (), 3, "Incomplete packets not expired");
+  NS_TEST_EXPECT_MSG_EQ (m_timeouts[0], Seconds (60), "Incomplete packet expired at the wrong time");
+  NS_TEST_EXPECT_MSG_EQ (m_timeouts[1], Seconds (64), "Incomplete packet expired at the wrong time");
+  NS_TEST_EXPECT_MSG_EQ (m_timeouts[2], Seconds (65), "Incomplete packet expired at the wrong time");
+  m_timeouts.clear ();
+
+  // the oldest packets are dropped when the buffer is full
+  Ptr<Ipv6ExtensionDemux> demux = node->GetObject<Ipv6ExtensionDemux> ();
+  demux->GetExtension (Ipv6ExtensionFragment::EXT_NUMBER)->SetAttribute ("FragmentBufferSize", UintegerValue (3000));
+  for (uint32_t id = 10; id < 14; id++)
+    {
+      ReceiveFragment (id, 0, 1000, false);
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_timeouts.size (), 1, "Oldest packet not evicted");
+  ReceiveFragment (11, 1000, 1000, true);
+  CheckDelivered (2000, "Packet after eviction");
+  ReceiveFragment (10, 1000, 1000, true);
+  NS_TEST_EXPECT_MSG_EQ (m_delivered.size (), 0, "Evicted packet reassembled");
+  NS_TEST_EXPECT_MSG_EQ (m_timeouts.size (), 1, "Packet evicted below the limit");
+
+  Simulator::Destroy ();
+}
+
+
 /**
  * \ingroup internet-test
  * \ingroup tests
@@ -536,6 +711,7 @@ public:
   Ipv6FragmentationTestSuite () : TestSuite ("ipv6-fragmentation", UNIT)
   {
     AddTestCase (new Ipv6FragmentationTest, TestCase::QUICK);
+    AddTestCase (new Ipv6FragmentReassemblyTest, TestCase::QUICK);
   }
 };
 
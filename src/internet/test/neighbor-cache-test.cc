@@ -0,0 +1,332 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/mac48-address.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv6-header.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/ipv6-interface.h"
+#include "ns3/arp-cache.h"
+#include "ns3/ndisc-cache.h"
+#include "ns3/icmpv6-l4-protocol.h"
+
+using namespace ns3;
+
+/// Number of hosts on the L2 segment
+static const uint32_t N_HOSTS = 5000;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief ArpCache test on a large L2 segment
+ *
+ * The cache of the first host holds an entry for each of the other hosts.
+ * Checks the lookups by MAC address, and the retries and the drops of the
+ * entries waiting for a reply.
+ */
+class ArpCacheScalingTestCase : public TestCase
+{
+public:
+  ArpCacheScalingTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Count an ARP request.
+   * \param cache the ARP cache
+   * \param address the requested address
+   */
+  void ArpRequest (Ptr<const ArpCache> cache, Ipv4Address address);
+  /**
+   * \brief Count a dropped packet.
+   * \param packet the packet
+   */
+  void Drop (Ptr<const Packet> packet);
+  /**
+   * \brief Resolve the entries of some hosts.
+   * \param hosts the indices of the hosts
+   */
+  void Resolve (std::vector<uint32_t> hosts);
+
+  Ptr<ArpCache> m_cache; //!< the ARP cache
+  NetDeviceContainer m_devices; //!< the devices of the segment
+  std::vector<ArpCache::Entry *> m_entries; //!< the entry of each host
+  uint32_t m_requests; //!< number of ARP requests
+  uint32_t m_drops; //!< number of dropped packets
+};
+
+ArpCacheScalingTestCase::ArpCacheScalingTestCase ()
+  : TestCase ("ArpCache with one entry per host of a large segment")
+{
+}
+
+void
+ArpCacheScalingTestCase::ArpRequest (Ptr<const ArpCache> cache, Ipv4Address address)
+{
+  m_requests++;
+}
+
+void
+ArpCacheScalingTestCase::Drop (Ptr<const Packet> packet)
+{
+  m_drops++;
+}
+
+void
+ArpCacheScalingTestCase::Resolve (std::vector<uint32_t> hosts)
+{
+  for (std::vector<uint32_t>::const_iterator i = hosts.begin (); i != hosts.end (); i++)
+    {
+      m_entries[*i]->MarkAlive (m_devices.Get (*i)->GetAddress ());
+      m_entries[*i]->ClearPendingPacket ();
+    }
+}
+
+void
+ArpCacheScalingTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (N_HOSTS);
+  SimpleNetDeviceHelper simple;
+  m_devices = simple.Install (nodes);
+
+  m_cache = CreateObject<ArpCache> ();
+  m_cache->SetDevice (m_devices.Get (0), 0);
+  m_cache->SetArpRequestCallback (MakeCallback (&ArpCacheScalingTestCase::ArpRequest, this));
+  m_cache->TraceConnectWithoutContext ("Drop", MakeCallback (&ArpCacheScalingTestCase::Drop, this));
+  m_requests = 0;
+  m_drops = 0;
+
+  m_entries.resize (N_HOSTS, 0);
+  for (uint32_t i = 1; i < N_HOSTS; i++)
+    {
+      m_entries[i] = m_cache->Add (Ipv4Address (Ipv4Address ("10.0.0.0").Get () + i));
+      m_entries[i]->SetMacAddress (m_devices.Get (i)->GetAddress ());
+    }
+  // a router with several addresses
+  ArpCache::Entry *alias1 = m_cache->Add (Ipv4Address ("10.1.0.1"));
+  alias1->SetMacAddress (m_devices.Get (1)->GetAddress ());
+  ArpCache::Entry *alias2 = m_cache->Add (Ipv4Address ("10.1.0.2"));
+  alias2->SetMacAddress (m_devices.Get (1)->GetAddress ());
+
+  bool found = true;
+  for (uint32_t i = 2; i < N_HOSTS; i++)
+    {
+      std::list<ArpCache::Entry *> entries = m_cache->LookupInverse (m_devices.Get (i)->GetAddress ());
+      found = found && entries.size () == 1 && entries.front () == m_entries[i];
+    }
+  NS_TEST_EXPECT_MSG_EQ (found, true, "Each host should have its own entry");
+  NS_TEST_EXPECT_MSG_EQ (m_cache->LookupInverse (m_devices.Get (1)->GetAddress ()).size (), 3,
+                         "The router should have three entries");
+  NS_TEST_EXPECT_MSG_EQ (m_cache->LookupInverse (Mac48Address ("00:00:00:ff:ff:ff")).size (), 0,
+                         "Unknown MAC address found");
+
+  // an address of unknown type matches the MAC address of the same value
+  uint8_t buffer[Address::MAX_SIZE];
+  uint32_t len = m_devices.Get (2)->GetAddress ().CopyTo (buffer);
+  NS_TEST_EXPECT_MSG_EQ (m_cache->LookupInverse (Address (0, buffer, len)).size (), 1,
+                         "Address of unknown type not found");
+
+  // the index follows the changes of MAC address and the removals
+  alias2->SetMacAddress (m_devices.Get (2)->GetAddress ());
+  NS_TEST_EXPECT_MSG_EQ (m_cache->LookupInverse (m_devices.Get (1)->GetAddress ()).size (), 2,
+                         "Stale MAC address index");
+  NS_TEST_EXPECT_MSG_EQ (m_cache->LookupInverse (m_devices.Get (2)->GetAddress ()).size (), 2,
+                         "Stale MAC address index");
+  m_cache->Remove (alias2);
+  m_cache->Remove (alias1);
+  NS_TEST_EXPECT_MSG_EQ (m_cache->LookupInverse (m_devices.Get (1)->GetAddress ()).size (), 1,
+                         "Removed entry found");
+  NS_TEST_EXPECT_MSG_EQ (m_cache->Lookup (Ipv4Address ("10.1.0.1")), 0, "Removed entry found");
+
+  // one host out of 50 is waiting for a reply; half of them get it
+  std::vector<uint32_t> resolved;
+  uint32_t waiting = 0;
+  for (uint32_t i = 1; i < N_HOSTS; i += 50)
+    {
+      m_entries[i]->MarkDead ();
+      m_entries[i]->MarkWaitReply (ArpCache::Ipv4PayloadHeaderPair (Create<Packet> (100), Ipv4Header ()));
+      if (waiting % 2 == 0)
+        {
+          resolved.push_back (i);
+        }
+      waiting++;
+    }
+  Simulator::Schedule (MilliSeconds (1500), &ArpCacheScalingTestCase::Resolve, this, resolved);
+  Simulator::Run ();
+
+  // the resolved hosts are retried once, the others until the maximum
+  UintegerValue maxRetries;
+  m_cache->GetAttribute ("MaxRetries", maxRetries);
+  uint32_t unresolved = waiting - resolved.size ();
+  NS_TEST_EXPECT_MSG_EQ (m_requests, resolved.size () + unresolved * maxRetries.Get (),
+                         "Unexpected number of ARP requests");
+  NS_TEST_EXPECT_MSG_EQ (m_drops, unresolved, "Unexpected number of dropped packets");
+  uint32_t dead = 0;
+  uint32_t alive = 0;
+  for (uint32_t i = 1; i < N_HOSTS; i++)
+    {
+      dead += m_entries[i]->IsDead () ? 1 : 0;
+      alive += m_entries[i]->IsAlive () ? 1 : 0;
+    }
+  NS_TEST_EXPECT_MSG_EQ (dead, unresolved, "Unexpected number of dead entries");
+  NS_TEST_EXPECT_MSG_EQ (alive, N_HOSTS - 1 - unresolved, "Unexpected number of alive entries");
+
+  m_cache->Flush ();
+  NS_TEST_EXPECT_MSG_EQ (m_cache->LookupInverse (m_devices.Get (2)->GetAddress ()).size (), 0,
+                         "Flushed entry found");
+
+  m_cache->Dispose ();
+  m_cache = 0;
+  m_devices = NetDeviceContainer ();
+  m_entries.clear ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief NdiscCache test on a large L2 segment
+ *
+ * The cache of the first host holds a reachable entry for each of the
+ * other hosts. Half of the hosts confirm their reachability after a
+ * while: the reachable timers of the others expire together, then the
+ * ones of the confirmed hosts.
+ */
+class NdiscCacheScalingTestCase : public TestCase
+{
+public:
+  NdiscCacheScalingTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Confirm the reachability of the odd hosts, by MAC address.
+   */
+  void Confirm (void);
+  /**
+   * \brief Check the number of reachable entries.
+   * \param expected the expected number of reachable entries
+   */
+  void CheckReachable (uint32_t expected);
+
+  Ptr<NdiscCache> m_cache; //!< the neighbor discovery cache
+  NetDeviceContainer m_devices; //!< the devices of the segment
+  std::vector<NdiscCache::Entry *> m_entries; //!< the entry of each host
+};
+
+NdiscCacheScalingTestCase::NdiscCacheScalingTestCase ()
+  : TestCase ("NdiscCache with one entry per host of a large segment")
+{
+}
+
+void
+NdiscCacheScalingTestCase::Confirm (void)
+{
+  bool found = true;
+  for (uint32_t i = 1; i < N_HOSTS; i += 2)
+    {
+      std::list<NdiscCache::Entry *> entries = m_cache->LookupInverse (m_devices.Get (i)->GetAddress ());
+      found = found && entries.size () == 1 && entries.front () == m_entries[i];
+      for (std::list<NdiscCache::Entry *>::iterator j = entries.begin (); j != entries.end (); j++)
+        {
+          (*j)->UpdateReachableTimer ();
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (found, true, "Each host should have its own entry");
+}
+
+void
+NdiscCacheScalingTestCase::CheckReachable (uint32_t expected)
+{
+  uint32_t reachable = 0;
+  for (uint32_t i = 1; i < N_HOSTS; i++)
+    {
+      reachable += m_entries[i]->IsReachable () ? 1 : 0;
+    }
+  NS_TEST_EXPECT_MSG_EQ (reachable, expected, "Unexpected number of reachable entries at " << Simulator::Now ());
+}
+
+void
+NdiscCacheScalingTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (N_HOSTS);
+  SimpleNetDeviceHelper simple;
+  m_devices = simple.Install (nodes);
+
+  m_cache = CreateObject<NdiscCache> ();
+  m_cache->SetDevice (m_devices.Get (0), 0);
+  m_entries.resize (N_HOSTS, 0);
+  for (uint32_t i = 1; i < N_HOSTS; i++)
+    {
+      Mac48Address mac = Mac48Address::ConvertFrom (m_devices.Get (i)->GetAddress ());
+      m_entries[i] = m_cache->Add (Ipv6Address::MakeAutoconfiguredAddress (mac, Ipv6Address ("2001:db8::")));
+      m_entries[i]->MarkIncomplete (NdiscCache::Ipv6PayloadHeaderPair (0, Ipv6Header ()));
+      m_entries[i]->MarkReachable (mac);
+      m_entries[i]->StartReachableTimer ();
+    }
+
+  Time reachable = MilliSeconds (Icmpv6L4Protocol::REACHABLE_TIME);
+  uint32_t odd = N_HOSTS / 2; // hosts 1, 3, ..., confirmed at 10 s
+  Simulator::Schedule (Seconds (10), &NdiscCacheScalingTestCase::Confirm, this);
+  Simulator::Schedule (reachable - NanoSeconds (1), &NdiscCacheScalingTestCase::CheckReachable, this, N_HOSTS - 1);
+  Simulator::Schedule (reachable + NanoSeconds (1), &NdiscCacheScalingTestCase::CheckReachable, this, odd);
+  Simulator::Schedule (Seconds (10) + reachable - NanoSeconds (1), &NdiscCacheScalingTestCase::CheckReachable, this, odd);
+  Simulator::Schedule (Seconds (10) + reachable + NanoSeconds (1), &NdiscCacheScalingTestCase::CheckReachable, this, 0);
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_entries[2]->IsStale (), true, "Entry should be stale");
+  m_cache->Remove (m_entries[2]);
+  NS_TEST_EXPECT_MSG_EQ (m_cache->LookupInverse (m_devices.Get (2)->GetAddress ()).size (), 0,
+                         "Removed entry found");
+
+  m_cache->Dispose ();
+  m_cache = 0;
+  m_devices = NetDeviceContainer ();
+  m_entries.clear ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief ArpCache and NdiscCache TestSuite
+ */
+class NeighborCacheTestSuite : public TestSuite
+{
+public:
+  NeighborCacheTestSuite ()
+    : TestSuite ("neighbor-cache", UNIT)
+  {
+    AddTestCase (new ArpCacheScalingTestCase, TestCase::QUICK);
+    AddTestCase (new NdiscCacheScalingTestCase, TestCase::QUICK);
+  }
+};
+
+static NeighborCacheTestSuite g_neighborCacheTestSuite; //!< Static variable for test initialization
@@ -17,10 +17,13 @@
 
 #include "ns3/test.h"
 #include "ns3/packet.h"
+#include "ns3/socket.h"
 #include "ns3/log.h"
 
 #include "ns3/tcp-rx-buffer.h"
 
+#include <vector>
+
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE ("TcpRxBufferTestSuite");
@@ -44,6 +47,14 @@ private:
    * \brief Test the SACK list update.
    */
   void TestUpdateSACKList ();
+  /**
+   * \brief Test the reassembly of out-of-order and overlapping segments.
+   */
+  void TestReassembly ();
+  /**
+   * \brief Test that the packets of the caller keep their packet tags.
+   */
+  void TestPacketTags ();
 };
 
 TcpRxBufferTestCase::TcpRxBufferTestCase ()
@@ -55,6 +66,8 @@ void
 TcpRxBufferTestCase::DoRun ()
 {
   TestUpdateSACKList ();
+  TestReassembly ();
+  TestPacketTags ();
 }
 
 void
@@ -338,6 +351,129 @@ TcpRxBufferTestCase::TestUpdateSACKList ()
                          "SACK list should contain no element");
 }
 
+/**
+ * \brief Create a packet whose bytes are the low-order bytes of their
+ * sequence numbers.
+ * \param seq sequence number of the first byte
+ * \param size number of bytes
+ * \returns the packet
+ */
+static Ptr<Packet>
+CreateNumberedPacket (uint32_t seq, uint32_t size)
+{
+  std::vector<uint8_t> data (size);
+  for (uint32_t i = 0; i < size; ++i)
+    {
+      data[i] = static_cast<uint8_t> (seq + i);
+    }
+  return Create<Packet> (&data[0], size);
+}
+
+void
+TcpRxBufferTestCase::TestReassembly ()
+{
+  TcpRxBuffer rxBuf;
+  TcpHeader h;
+  rxBuf.SetNextRxSequence (SequenceNumber32 (1));
+
+  // Three out-of-order segments which end up in a single block
+  h.SetSequenceNumber (SequenceNumber32 (201));
+  rxBuf.Add (CreateNumberedPacket (201, 100), h);
+  h.SetSequenceNumber (SequenceNumber32 (401));
+  rxBuf.Add (CreateNumberedPacket (401, 100), h);
+  h.SetSequenceNumber (SequenceNumber32 (301));
+  rxBuf.Add (CreateNumberedPacket (301, 100), h);
+
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.Size (), 300, "Buffer occupancy differs from expected");
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.Available (), 0, "No data should be available");
+  TcpOptionSack::SackList sackList = rxBuf.GetSackList ();
+  NS_TEST_ASSERT_MSG_EQ (sackList.size (), 1, "SACK list should contain one element");
+  NS_TEST_ASSERT_MSG_EQ (sackList.begin ()->first, SequenceNumber32 (201),
+                         "SACK block different than expected");
+  NS_TEST_ASSERT_MSG_EQ (sackList.begin ()->second, SequenceNumber32 (501),
+                         "SACK block different than expected");
+
+  // A segment overlapping the head of the block, and a duplicate
+  h.SetSequenceNumber (SequenceNumber32 (151));
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.Add (CreateNumberedPacket (151, 300), h), true,
+                         "Only the overlapping part should have been discarded");
+  h.SetSequenceNumber (SequenceNumber32 (251));
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.Add (CreateNumberedPacket (251, 100), h), false,
+                         "A duplicate segment should not be buffered");
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.Size (), 350, "Buffer occupancy differs from expected");
+
+  // A segment spanning a whole block and the holes around it
+  h.SetSequenceNumber (SequenceNumber32 (601));
+  rxBuf.Add (CreateNumberedPacket (601, 50), h);
+  h.SetSequenceNumber (SequenceNumber32 (551));
+  rxBuf.Add (CreateNumberedPacket (551, 200), h);
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.Size (), 550, "Buffer occupancy differs from expected");
+
+  // Fill the holes
+  h.SetSequenceNumber (SequenceNumber32 (1));
+  rxBuf.Add (CreateNumberedPacket (1, 150), h);
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.NextRxSequence (), SequenceNumber32 (501),
+                         "Sequence number differs from expected");
+  h.SetSequenceNumber (SequenceNumber32 (501));
+  rxBuf.Add (CreateNumberedPacket (501, 50), h);
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.NextRxSequence (), SequenceNumber32 (751),
+                         "Sequence number differs from expected");
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.Available (), 750, "Data available differs from expected");
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.GetSackListSize (), 0, "SACK list should be empty");
+
+  // In-order segment
+  h.SetSequenceNumber (SequenceNumber32 (751));
+  rxBuf.Add (CreateNumberedPacket (751, 250), h);
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.Available (), 1000, "Data available differs from expected");
+
+  // Extract the data with partial and whole reads, and check its content
+  uint32_t reads[] = { 120, 30, 400, 1000 };
+  uint32_t seq = 1;
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      Ptr<Packet> p = rxBuf.Extract (reads[i]);
+      uint32_t expected = std::min<uint32_t> (reads[i], 1001 - seq);
+      NS_TEST_ASSERT_MSG_EQ (p->GetSize (), expected, "Extracted size differs from expected");
+      std::vector<uint8_t> data (expected);
+      p->CopyData (&data[0], expected);
+      for (uint32_t j = 0; j < expected; ++j)
+        {
+          NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (data[j]), ((seq + j) & 0xff),
+                                 "Extracted data differs from expected");
+        }
+      seq += expected;
+    }
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.Size (), 0, "The buffer should be empty");
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.Available (), 0, "No data should be available");
+  NS_TEST_ASSERT_MSG_EQ (rxBuf.Extract (100), 0, "Nothing should be extracted");
+}
+
+void
+TcpRxBufferTestCase::TestPacketTags ()
+{
+  TcpRxBuffer rxBuf;
+  TcpHeader h;
+  rxBuf.SetNextRxSequence (SequenceNumber32 (1));
+  SocketIpTtlTag tag;
+  tag.SetTtl (7);
+
+  // In-order, out-of-order and overlapping segments
+  uint32_t seqs[] = { 1, 151, 101 };
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      Ptr<Packet> p = CreateNumberedPacket (seqs[i], 100);
+      p->AddPacketTag (tag);
+      h.SetSequenceNumber (SequenceNumber32 (seqs[i]));
+      rxBuf.Add (p, h);
+      NS_TEST_ASSERT_MSG_EQ (p->PeekPacketTag (tag), true, "The packet of the caller lost its tag");
+      NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 100, "The packet of the caller was changed");
+    }
+
+  Ptr<Packet> p = rxBuf.Extract (250);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 250, "Extracted size differs from expected");
+  NS_TEST_ASSERT_MSG_EQ (p->PeekPacketTag (tag), false, "The extracted data carries a packet tag");
+}
+
 void
 TcpRxBufferTestCase::DoTeardown ()
 {
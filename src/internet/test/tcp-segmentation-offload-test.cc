@@ -0,0 +1,347 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/global-value.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/node.h"
+#include "ns3/socket.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/net-device-queue-interface.h"
+#include "ns3/tcp-header.h"
+#include "ns3/tcp-socket-base.h"
+#include "ns3/tcp-segmentation-tag.h"
+#include <set>
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Split of a TCP super-segment on behalf of a device
+ *
+ * Hands a super-segment to the segmentation callback that Ipv4L3Protocol
+ * sets on the NetDeviceQueueInterface of the devices, and checks the
+ * sequence numbers, flags, sizes and identifications of the segments.
+ */
+class TcpSegmentationSplitTestCase : public TestCase
+{
+public:
+  TcpSegmentationSplitTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TcpSegmentationSplitTestCase::TcpSegmentationSplitTestCase ()
+  : TestCase ("Split of a TCP super-segment by Ipv4L3Protocol")
+{
+}
+
+void
+TcpSegmentationSplitTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.SetIpv6StackInstall (false);
+  internet.Install (node);
+  Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+  device->SetAddress (Mac48Address::Allocate ());
+  node->AddDevice (device);
+  node->GetObject<Ipv4> ()->AddInterface (device);
+
+  Ptr<NetDeviceQueueInterface> ndqi = device->GetObject<NetDeviceQueueInterface> ();
+  NS_TEST_ASSERT_MSG_NE (ndqi, 0, "No NetDeviceQueueInterface aggregated to the device");
+
+  // a packet without the tag is left alone
+  Ptr<Packet> p = Create<Packet> (4000);
+  NS_TEST_EXPECT_MSG_EQ (ndqi->Segment (Ipv4L3Protocol::PROT_NUMBER, p).size (), 0,
+                         "A packet without the tag must not be split");
+
+  TcpHeader tcpHeader;
+  tcpHeader.SetSequenceNumber (SequenceNumber32 (1000));
+  tcpHeader.SetFlags (TcpHeader::ACK | TcpHeader::PSH | TcpHeader::FIN);
+  p->AddHeader (tcpHeader);
+  Ipv4Header ipHeader;
+  ipHeader.SetSource (Ipv4Address ("10.0.0.1"));
+  ipHeader.SetDestination (Ipv4Address ("10.0.0.2"));
+  ipHeader.SetProtocol (6);
+  ipHeader.SetPayloadSize (p->GetSize ());
+  ipHeader.SetIdentification (7);
+  p->AddHeader (ipHeader);
+  p->AddPacketTag (TcpSegmentationTag (1448));
+
+  std::list<Ptr<Packet> > segments = ndqi->Segment (Ipv4L3Protocol::PROT_NUMBER, p);
+  NS_TEST_ASSERT_MSG_EQ (segments.size (), 3, "4000 bytes should make three segments");
+
+  uint32_t sizes[] = { 1448, 1448, 1104 };
+  uint8_t flags[] = { TcpHeader::ACK, TcpHeader::ACK, TcpHeader::ACK | TcpHeader::PSH | TcpHeader::FIN };
+  uint32_t offset = 0;
+  uint32_t i = 0;
+  std::set<uint16_t> identifications;
+  for (std::list<Ptr<Packet> >::iterator it = segments.begin (); it != segments.end (); it++, i++)
+    {
+      TcpSegmentationTag tag;
+      NS_TEST_EXPECT_MSG_EQ ((*it)->PeekPacketTag (tag), false, "Segment " << i << " still tagged");
+      Ipv4Header segmentIpHeader;
+      (*it)->RemoveHeader (segmentIpHeader);
+      TcpHeader segmentTcpHeader;
+      (*it)->RemoveHeader (segmentTcpHeader);
+      NS_TEST_EXPECT_MSG_EQ ((*it)->GetSize (), sizes[i], "Unexpected size of segment " << i);
+      NS_TEST_EXPECT_MSG_EQ (segmentIpHeader.GetPayloadSize (), sizes[i] + segmentTcpHeader.GetSerializedSize (),
+                             "Unexpected IPv4 payload size of segment " << i);
+      NS_TEST_EXPECT_MSG_EQ (segmentTcpHeader.GetSequenceNumber (), SequenceNumber32 (1000 + offset),
+                             "Unexpected sequence number of segment " << i);
+      NS_TEST_EXPECT_MSG_EQ (static_cast<uint32_t> (segmentTcpHeader.GetFlags ()), static_cast<uint32_t> (flags[i]),
+                             "Unexpected flags of segment " << i);
+      identifications.insert (segmentIpHeader.GetIdentification ());
+      offset += sizes[i];
+    }
+  NS_TEST_EXPECT_MSG_EQ (identifications.size (), 3, "The segments must have distinct identifications");
+  NS_TEST_EXPECT_MSG_EQ (identifications.count (7), 1, "The first segment must keep the identification");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Bulk transfer with super-segments over a device without offload
+ *
+ * The super-segments are split by Ipv4L3Protocol, so that every packet
+ * handed to the device fits its MTU. The transfer must complete, with
+ * distinct IPv4 identifications and, when enabled, valid checksums.
+ */
+class TcpSegmentationTransferTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   * \param checksum whether to enable the checksums
+   */
+  TcpSegmentationTransferTestCase (bool checksum);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Fill the transmission buffer of the sender
+   * \param socket the sending socket
+   * \param available the space available in the buffer
+   */
+  void Send (Ptr<Socket> socket, uint32_t available);
+
+  /**
+   * \brief Accept a connection on the receiver
+   * \param socket the socket of the connection
+   * \param from the address of the sender
+   */
+  void Accept (Ptr<Socket> socket, const Address &from);
+
+  /**
+   * \brief Read the data available on the receiver
+   * \param socket the receiving socket
+   */
+  void Receive (Ptr<Socket> socket);
+
+  /**
+   * \brief Trace the packets sent by the socket
+   * \param packet the packet
+   * \param header the TCP header
+   * \param socket the socket
+   */
+  void SocketTx (Ptr<const Packet> packet, const TcpHeader &header, Ptr<const TcpSocketBase> socket);
+
+  /**
+   * \brief Trace the packets sent by IPv4
+   * \param packet the packet, with its IPv4 header
+   * \param ipv4 the IPv4 object
+   * \param interface the interface index
+   */
+  void IpTx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
+
+  bool m_checksum;                //!< Whether to enable the checksums
+  uint32_t m_toSend;              //!< Bytes left to send
+  bool m_closed;                  //!< Whether the sender has been closed
+  uint32_t m_received;            //!< Bytes received
+  uint32_t m_superSegments;       //!< Number of super-segments sent by the socket
+  uint32_t m_dataPackets;         //!< Number of data packets sent by IPv4
+  uint32_t m_largest;             //!< Largest packet sent by IPv4
+  std::set<uint16_t> m_identifications; //!< Identifications of the data packets
+};
+
+static const uint32_t TRANSFER_SIZE = 500000; //!< Bytes to transfer
+static const uint32_t TRANSFER_MSS = 1448;    //!< Segment size of the sender
+
+TcpSegmentationTransferTestCase::TcpSegmentationTransferTestCase (bool checksum)
+  : TestCase (std::string ("Bulk transfer with TCP super-segments, checksums ") + (checksum ? "enabled" : "disabled")),
+    m_checksum (checksum),
+    m_toSend (0),
+    m_closed (false),
+    m_received (0),
+    m_superSegments (0),
+    m_dataPackets (0),
+    m_largest (0)
+{
+}
+
+void
+TcpSegmentationTransferTestCase::Send (Ptr<Socket> socket, uint32_t available)
+{
+  while (m_toSend > 0 && socket->GetTxAvailable () > 0)
+    {
+      uint32_t size = std::min (m_toSend, socket->GetTxAvailable ());
+      int sent = socket->Send (Create<Packet> (size));
+      if (sent <= 0)
+        {
+          break;
+        }
+      m_toSend -= sent;
+    }
+  if (m_toSend == 0 && !m_closed)
+    {
+      socket->Close ();
+      m_closed = true;
+    }
+}
+
+void
+TcpSegmentationTransferTestCase::Accept (Ptr<Socket> socket, const Address &from)
+{
+  socket->SetRecvCallback (MakeCallback (&TcpSegmentationTransferTestCase::Receive, this));
+}
+
+void
+TcpSegmentationTransferTestCase::Receive (Ptr<Socket> socket)
+{
+  Ptr<Packet> p;
+  while ((p = socket->Recv ()))
+    {
+      m_received += p->GetSize ();
+    }
+}
+
+void
+TcpSegmentationTransferTestCase::SocketTx (Ptr<const Packet> packet, const TcpHeader &header,
+                                           Ptr<const TcpSocketBase> socket)
+{
+  if (packet->GetSize () > TRANSFER_MSS)
+    {
+      m_superSegments++;
+    }
+}
+
+void
+TcpSegmentationTransferTestCase::IpTx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  m_largest = std::max (m_largest, packet->GetSize ());
+  Ptr<Packet> p = packet->Copy ();
+  Ipv4Header ipHeader;
+  p->RemoveHeader (ipHeader);
+  TcpHeader tcpHeader;
+  p->RemoveHeader (tcpHeader);
+  if (p->GetSize () > 0)
+    {
+      m_dataPackets++;
+      m_identifications.insert (ipHeader.GetIdentification ());
+    }
+}
+
+void
+TcpSegmentationTransferTestCase::DoRun (void)
+{
+  GlobalValue::Bind ("ChecksumEnabled", BooleanValue (m_checksum));
+
+  NodeContainer nodes;
+  nodes.Create (2);
+  SimpleNetDeviceHelper simple;
+  simple.SetDeviceAttribute ("DataRate", StringValue ("100Mbps"));
+  simple.SetChannelAttribute ("Delay", StringValue ("1ms"));
+  NetDeviceContainer devices = simple.Install (nodes);
+  for (uint32_t i = 0; i < devices.GetN (); i++)
+    {
+      devices.Get (i)->SetMtu (1500);
+    }
+  InternetStackHelper internet;
+  internet.SetIpv6StackInstall (false);
+  internet.Install (nodes);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.0.0.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = ipv4.Assign (devices);
+
+  Ptr<Socket> listener = Socket::CreateSocket (nodes.Get (1), TcpSocketFactory::GetTypeId ());
+  listener->Bind (InetSocketAddress (Ipv4Address::GetAny (), 5000));
+  listener->Listen ();
+  listener->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                               MakeCallback (&TcpSegmentationTransferTestCase::Accept, this));
+
+  Ptr<Socket> sender = Socket::CreateSocket (nodes.Get (0), TcpSocketFactory::GetTypeId ());
+  sender->SetAttribute ("SegmentSize", UintegerValue (TRANSFER_MSS));
+  sender->SetAttribute ("TsoMaxSegments", UintegerValue (16));
+  sender->TraceConnectWithoutContext ("Tx", MakeCallback (&TcpSegmentationTransferTestCase::SocketTx, this));
+  sender->SetSendCallback (MakeCallback (&TcpSegmentationTransferTestCase::Send, this));
+  nodes.Get (0)->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext (
+    "Tx", MakeCallback (&TcpSegmentationTransferTestCase::IpTx, this));
+
+  m_toSend = TRANSFER_SIZE;
+  sender->Bind ();
+  sender->Connect (InetSocketAddress (interfaces.GetAddress (1), 5000));
+  Simulator::Schedule (Seconds (0.1), &TcpSegmentationTransferTestCase::Send, this, sender, 0);
+
+  Simulator::Stop (Seconds (20));
+  Simulator::Run ();
+  Simulator::Destroy ();
+  GlobalValue::Bind ("ChecksumEnabled", BooleanValue (false));
+
+  NS_TEST_EXPECT_MSG_EQ (m_received, TRANSFER_SIZE, "Transfer not complete");
+  NS_TEST_EXPECT_MSG_GT (m_superSegments, 0, "No super-segment sent");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (m_largest, 1500, "Packet larger than the MTU sent to the device");
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (m_dataPackets, (TRANSFER_SIZE + TRANSFER_MSS - 1) / TRANSFER_MSS,
+                               "Too few data packets");
+  NS_TEST_EXPECT_MSG_EQ (m_identifications.size (), m_dataPackets,
+                         "The data packets must have distinct identifications");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP segmentation offload TestSuite
+ */
+class TcpSegmentationOffloadTestSuite : public TestSuite
+{
+public:
+  TcpSegmentationOffloadTestSuite ()
+    : TestSuite ("tcp-segmentation-offload", UNIT)
+  {
+    AddTestCase (new TcpSegmentationSplitTestCase, TestCase::QUICK);
+    AddTestCase (new TcpSegmentationTransferTestCase (false), TestCase::QUICK);
+    AddTestCase (new TcpSegmentationTransferTestCase (true), TestCase::QUICK);
+  }
+};
+
+static TcpSegmentationOffloadTestSuite g_tcpSegmentationOffloadTestSuite; //!< Static variable for test initialization
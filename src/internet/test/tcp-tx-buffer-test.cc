@@ -49,6 +49,10 @@ private:
   void TestNextSeg ();
   /** \brief Test the scoreboard with emulated SACK */
   void TestUpdateScoreboardWithCraftedSACK ();
+  /** \brief Test the scoreboard with many outstanding segments */
+  void TestLargeScoreboard ();
+  /** \brief Test the retransmission cursor and the cached lost boundary */
+  void TestScoreboardCursor ();
 };
 
 TcpTxBufferTestCase::TcpTxBufferTestCase ()
@@ -82,6 +86,10 @@ TcpTxBufferTestCase::DoRun ()
                        &TcpTxBufferTestCase::TestNextSeg, this);
   Simulator::Schedule (Seconds (0.0),
                        &TcpTxBufferTestCase::TestUpdateScoreboardWithCraftedSACK, this);
+  Simulator::Schedule (Seconds (0.0),
+                       &TcpTxBufferTestCase::TestLargeScoreboard, this);
+  Simulator::Schedule (Seconds (0.0),
+                       &TcpTxBufferTestCase::TestScoreboardCursor, this);
 
   Simulator::Run ();
   Simulator::Destroy ();
@@ -390,6 +398,153 @@ TcpTxBufferTestCase::TestUpdateScoreboardWithCraftedSACK ()
                          "Data inside the buffer");
 }
 
+void
+TcpTxBufferTestCase::TestLargeScoreboard ()
+{
+  TcpTxBuffer txBuf;
+  SequenceNumber32 head (1);
+  uint32_t dupThresh = 3;
+  uint32_t segmentSize = 100;
+  txBuf.SetHeadSequence (head);
+  txBuf.SetMaxBufferSize (10000);
+  txBuf.Add (Create<Packet> (10000));
+
+  // Send 100 segments
+  for (uint32_t i = 0; i < 100; ++i)
+    {
+      txBuf.CopyFromSequence (segmentSize, head + (segmentSize * i));
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (txBuf.BytesInFlight (dupThresh, segmentSize), 10000,
+                         "Without SACK information, everything is in flight");
+
+  // SACK the segments with an even index, from 50 to 98
+  TcpOptionSack::SackList sackList;
+  for (uint32_t i = 50; i < 100; i += 2)
+    {
+      sackList.push_back (TcpOptionSack::SackBlock (head + (segmentSize * i),
+                                                    head + (segmentSize * (i + 1))));
+    }
+  NS_TEST_ASSERT_MSG_EQ (txBuf.Update (sackList), true, "Scoreboard not updated");
+
+  // Segments 98, 96 and 94 are enough to declare lost everything below 94;
+  // only 95, 97 and 99 are still in flight
+  NS_TEST_ASSERT_MSG_EQ (txBuf.BytesInFlight (dupThresh, segmentSize), 300,
+                         "Wrong bytes in flight with SACK information");
+  NS_TEST_ASSERT_MSG_EQ (txBuf.IsLost (head + (segmentSize * 93), dupThresh, segmentSize), true,
+                         "Segment 93 should be lost");
+  NS_TEST_ASSERT_MSG_EQ (txBuf.IsLost (head + (segmentSize * 95), dupThresh, segmentSize), false,
+                         "Segment 95 should not be lost");
+
+  SequenceNumber32 ret;
+  NS_TEST_ASSERT_MSG_EQ (txBuf.NextSeg (&ret, dupThresh, segmentSize, true), true,
+                         "NextSeg should find a lost segment");
+  NS_TEST_ASSERT_MSG_EQ (ret, head, "The first segment should be retransmitted");
+
+  // Retransmit the first segment, and half of the 10th
+  txBuf.CopyFromSequence (segmentSize, head);
+  txBuf.CopyFromSequence (segmentSize / 2, head + (segmentSize * 10));
+  NS_TEST_ASSERT_MSG_EQ (txBuf.BytesInFlight (dupThresh, segmentSize), 450,
+                         "Retransmitted data should be in flight");
+  NS_TEST_ASSERT_MSG_EQ (txBuf.IsLost (head + (segmentSize * 10) + (segmentSize / 2),
+                                       dupThresh, segmentSize), true,
+                         "The second half of segment 10 should be lost");
+  NS_TEST_ASSERT_MSG_EQ (txBuf.NextSeg (&ret, dupThresh, segmentSize, true), true,
+                         "NextSeg should find a lost segment");
+  NS_TEST_ASSERT_MSG_EQ (ret, head + segmentSize, "The second segment should be retransmitted");
+
+  // Cumulative ACK up to the middle of segment 50
+  txBuf.DiscardUpTo (head + (segmentSize * 50) + (segmentSize / 2));
+  NS_TEST_ASSERT_MSG_EQ (txBuf.BytesInFlight (dupThresh, segmentSize), 300,
+                         "Retransmitted data should have been acknowledged");
+
+  txBuf.SetSentListLost ();
+  NS_TEST_ASSERT_MSG_EQ (txBuf.BytesInFlight (dupThresh, segmentSize), 0,
+                         "Nothing should be in flight after an RTO");
+
+  txBuf.DiscardUpTo (head + 10000);
+  NS_TEST_ASSERT_MSG_EQ (txBuf.Size (), 0, "Data inside the buffer");
+}
+
+void
+TcpTxBufferTestCase::TestScoreboardCursor ()
+{
+  TcpTxBuffer txBuf;
+  SequenceNumber32 head (1);
+  uint32_t dupThresh = 3;
+  uint32_t segmentSize = 100;
+  txBuf.SetHeadSequence (head);
+  txBuf.SetMaxBufferSize (2000);
+  txBuf.Add (Create<Packet> (2000));
+
+  // Send 10 segments, and SACK the last one
+  for (uint32_t i = 0; i < 10; ++i)
+    {
+      txBuf.CopyFromSequence (segmentSize, head + (segmentSize * i));
+    }
+  TcpOptionSack::SackList sackList;
+  sackList.push_back (TcpOptionSack::SackBlock (head + (segmentSize * 9),
+                                                head + (segmentSize * 10)));
+  NS_TEST_ASSERT_MSG_EQ (txBuf.Update (sackList), true, "Scoreboard not updated");
+
+  // Segments sent after the highest SACKed one, and SACKs below it
+  txBuf.CopyFromSequence (segmentSize, head + (segmentSize * 10));
+  txBuf.CopyFromSequence (segmentSize, head + (segmentSize * 11));
+  sackList.clear ();
+  sackList.push_back (TcpOptionSack::SackBlock (head + (segmentSize * 5),
+                                                head + (segmentSize * 6)));
+  sackList.push_back (TcpOptionSack::SackBlock (head + (segmentSize * 7),
+                                                head + (segmentSize * 8)));
+  NS_TEST_ASSERT_MSG_EQ (txBuf.Update (sackList), true, "Scoreboard not updated");
+
+  // Segments 9, 7 and 5 declare lost everything below 5; 6, 8, 10 and 11
+  // are still in flight
+  NS_TEST_ASSERT_MSG_EQ (txBuf.BytesInFlight (dupThresh, segmentSize), 400,
+                         "Wrong bytes in flight with SACK information");
+  NS_TEST_ASSERT_MSG_EQ (txBuf.IsLost (head + (segmentSize * 4), dupThresh, segmentSize), true,
+                         "Segment 4 should be lost");
+  NS_TEST_ASSERT_MSG_EQ (txBuf.IsLost (head + (segmentSize * 6), dupThresh, segmentSize), false,
+                         "Segment 6 should not be lost");
+
+  // NextSeg returns the lost segments in order, as they are retransmitted
+  SequenceNumber32 ret;
+  for (uint32_t i = 0; i < 5; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (txBuf.NextSeg (&ret, dupThresh, segmentSize, true), true,
+                             "NextSeg should find a lost segment");
+      NS_TEST_ASSERT_MSG_EQ (ret, head + (segmentSize * i), "Wrong segment to retransmit");
+      txBuf.CopyFromSequence (segmentSize, ret);
+    }
+  NS_TEST_ASSERT_MSG_EQ (txBuf.BytesInFlight (dupThresh, segmentSize), 900,
+                         "Retransmitted data should be in flight");
+
+  // Then the unsent data
+  NS_TEST_ASSERT_MSG_EQ (txBuf.NextSeg (&ret, dupThresh, segmentSize, true), true,
+                         "NextSeg should find unsent data");
+  NS_TEST_ASSERT_MSG_EQ (ret, head + (segmentSize * 12), "Unsent data should be sent");
+
+  // Without the SACK information, the segments not retransmitted are
+  // candidates again for rule (3)
+  txBuf.ResetScoreboard ();
+  NS_TEST_ASSERT_MSG_EQ (txBuf.BytesInFlight (dupThresh, segmentSize), 1200,
+                         "Without SACK information, everything is in flight");
+  txBuf.DiscardUpTo (head + (segmentSize * 12));
+  NS_TEST_ASSERT_MSG_EQ (txBuf.NextSeg (&ret, dupThresh, segmentSize, true), true,
+                         "NextSeg should find unsent data");
+  NS_TEST_ASSERT_MSG_EQ (ret, head + (segmentSize * 12), "Unsent data should be sent");
+
+  // After an RTO, the head is retransmitted first
+  txBuf.CopyFromSequence (segmentSize, head + (segmentSize * 12));
+  txBuf.CopyFromSequence (segmentSize, head + (segmentSize * 13));
+  txBuf.ResetSentList ();
+  NS_TEST_ASSERT_MSG_EQ (txBuf.NextSeg (&ret, dupThresh, segmentSize, false), true,
+                         "NextSeg should find the lost head");
+  NS_TEST_ASSERT_MSG_EQ (ret, head + (segmentSize * 12), "The head should be retransmitted");
+
+  txBuf.DiscardUpTo (head + 2000);
+  NS_TEST_ASSERT_MSG_EQ (txBuf.Size (), 0, "Data inside the buffer");
+}
+
 void
 TcpTxBufferTestCase::TestTransmittedBlock ()
 {
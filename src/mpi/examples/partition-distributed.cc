@@ -0,0 +1,230 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ * PartitionDistributed creates a ring of routers, each with a star of
+ * leaf nodes, and lets the MpiPartitionHelper assign the nodes to the
+ * logical processors, whatever their number.
+ *
+ *     l l         l l
+ *      \|         |/
+ *       r0 ------ r1
+ *       |          |
+ *       r3 ------ r2
+ *      /|          |\
+ *     l l          l l
+ *
+ * The ring links are longer than the leaf links, so that the helper
+ * only cuts ring links as long as the load is balanced within 25%, and
+ * the routers are weighted by the number of their leaves.  The
+ * partition report is printed by the first logical processor.
+ *
+ * Each leaf sends one packet to the leaf of the same index on the
+ * opposite router of the ring; the packet sinks output logging
+ * information when they receive the packet.
+ *
+ * With --threads, the logical processors are threads of a single
+ * process, run by the ThreadedSimulatorImpl, and MPI is not used; the
+ * routes are then computed by the global routing, as the nix-vector
+ * routing computes them while the simulation runs.
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mpi-interface.h"
+#include "ns3/mpi-partition-helper.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-nix-vector-helper.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/on-off-helper.h"
+#include "ns3/packet-sink-helper.h"
+#include "ns3/packet-sink.h"
+
+#include <iostream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("PartitionDistributed");
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t nRouters = 8;
+  uint32_t nLeaves = 4;
+  bool nullmsg = false;
+  uint32_t nThreads = 0;
+
+  // Parse command line
+  CommandLine cmd;
+  cmd.AddValue ("routers", "Number of routers of the ring", nRouters);
+  cmd.AddValue ("leaves", "Number of leaf nodes of each router", nLeaves);
+  cmd.AddValue ("nullmsg", "Enable the use of null-message synchronization", nullmsg);
+  cmd.AddValue ("threads", "Number of threads, to run without MPI", nThreads);
+  cmd.Parse (argc, argv);
+
+#ifndef NS3_MPI
+  if (nThreads == 0)
+    {
+      NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+    }
+#endif
+
+  // Distributed simulation setup; by default use granted time window algorithm.
+  if (nThreads > 0)
+    {
+      GlobalValue::Bind ("SimulatorImplementationType",
+                         StringValue ("ns3::ThreadedSimulatorImpl"));
+      Config::SetDefault ("ns3::ThreadedSimulatorImpl::Threads", UintegerValue (nThreads));
+    }
+  else if (nullmsg)
+    {
+      GlobalValue::Bind ("SimulatorImplementationType",
+                         StringValue ("ns3::NullMessageSimulatorImpl"));
+    }
+  else
+    {
+      GlobalValue::Bind ("SimulatorImplementationType",
+                         StringValue ("ns3::DistributedSimulatorImpl"));
+    }
+
+  // Enable parallel simulator with the command line arguments
+  MpiInterface::Enable (&argc, &argv);
+
+  LogComponentEnable ("PacketSink", LOG_LEVEL_INFO);
+
+  uint32_t systemId = MpiInterface::GetSystemId ();
+  uint32_t systemCount = MpiInterface::GetSize ();
+
+  Config::SetDefault ("ns3::OnOffApplication::PacketSize", UintegerValue (512));
+  Config::SetDefault ("ns3::OnOffApplication::DataRate", StringValue ("1Mbps"));
+  Config::SetDefault ("ns3::OnOffApplication::MaxBytes", UintegerValue (512));
+
+  // Describe the topology: the routers are the nodes 0 to nRouters - 1,
+  // and the leaves of router r follow, from nRouters + r * nLeaves
+  MpiPartitionHelper partition;
+  uint32_t firstRouter = partition.AddNodes (nRouters, nLeaves);
+  uint32_t firstLeaf = partition.AddNodes (nRouters * nLeaves);
+  for (uint32_t r = 0; r < nRouters; ++r)
+    {
+      partition.AddLink (firstRouter + r, firstRouter + (r + 1) % nRouters, MilliSeconds (10));
+      for (uint32_t l = 0; l < nLeaves; ++l)
+        {
+          partition.AddLink (firstRouter + r, firstLeaf + r * nLeaves + l, MilliSeconds (1));
+        }
+    }
+  // A larger lookahead is worth some imbalance between the logical processors
+  partition.SetImbalance (0.25);
+  partition.Partition (systemCount);
+  if (systemId == 0)
+    {
+      partition.Report (std::cout);
+    }
+
+  // Create the nodes with the system id of their logical processor
+  NodeContainer nodes = partition.Create ();
+
+  PointToPointHelper ringLink;
+  ringLink.SetDeviceAttribute ("DataRate", StringValue ("5Mbps"));
+  ringLink.SetChannelAttribute ("Delay", StringValue ("10ms"));
+
+  PointToPointHelper leafLink;
+  leafLink.SetDeviceAttribute ("DataRate", StringValue ("1Mbps"));
+  leafLink.SetChannelAttribute ("Delay", StringValue ("1ms"));
+
+  InternetStackHelper stack;
+  Ipv4NixVectorHelper nixRouting;
+  if (nThreads == 0)
+    {
+      stack.SetRoutingHelper (nixRouting);
+    }
+  stack.Install (nodes);
+
+  Ipv4AddressHelper ringAddress;
+  ringAddress.SetBase ("10.1.1.0", "255.255.255.0");
+  Ipv4AddressHelper leafAddress;
+  leafAddress.SetBase ("10.2.1.0", "255.255.255.0");
+
+  std::vector<Ipv4Address> leafAddresses;
+  for (uint32_t r = 0; r < nRouters; ++r)
+    {
+      NetDeviceContainer ringDevices = ringLink.Install (nodes.Get (firstRouter + r),
+                                                         nodes.Get (firstRouter + (r + 1) % nRouters));
+      ringAddress.Assign (ringDevices);
+      ringAddress.NewNetwork ();
+      for (uint32_t l = 0; l < nLeaves; ++l)
+        {
+          NetDeviceContainer leafDevices = leafLink.Install (nodes.Get (firstLeaf + r * nLeaves + l),
+                                                             nodes.Get (firstRouter + r));
+          Ipv4InterfaceContainer leafInterfaces = leafAddress.Assign (leafDevices);
+          leafAddresses.push_back (leafInterfaces.GetAddress (0));
+          leafAddress.NewNetwork ();
+        }
+    }
+  if (nThreads > 0)
+    {
+      Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+    }
+
+  // Install the applications of the leaves of this logical processor,
+  // or of all the leaves when the logical processors are threads
+  uint16_t port = 50000;
+  Address sinkLocalAddress (InetSocketAddress (Ipv4Address::GetAny (), port));
+  PacketSinkHelper sinkHelper ("ns3::UdpSocketFactory", sinkLocalAddress);
+  OnOffHelper clientHelper ("ns3::UdpSocketFactory", Address ());
+  clientHelper.SetAttribute
+    ("OnTime", StringValue ("ns3::ConstantRandomVariable[Constant=1]"));
+  clientHelper.SetAttribute
+    ("OffTime", StringValue ("ns3::ConstantRandomVariable[Constant=0]"));
+  ApplicationContainer apps;
+  for (uint32_t i = 0; i < nRouters * nLeaves; ++i)
+    {
+      Ptr<Node> leaf = nodes.Get (firstLeaf + i);
+      if (nThreads == 0 && leaf->GetSystemId () != systemId)
+        {
+          continue;
+        }
+      uint32_t peer = (i + (nRouters / 2) * nLeaves) % (nRouters * nLeaves);
+      AddressValue remoteAddress (InetSocketAddress (leafAddresses[peer], port));
+      clientHelper.SetAttribute ("Remote", remoteAddress);
+      apps.Add (clientHelper.Install (leaf));
+      apps.Add (sinkHelper.Install (leaf));
+    }
+  apps.Start (Seconds (1.0));
+  apps.Stop (Seconds (5));
+
+  Simulator::Stop (Seconds (5));
+  Simulator::Run ();
+
+  // The logs of the threads may be interleaved: sum up what the sinks
+  // of this logical processor received
+  uint64_t totalRx = 0;
+  for (ApplicationContainer::Iterator i = apps.Begin (); i != apps.End (); ++i)
+    {
+      Ptr<PacketSink> sink = DynamicCast<PacketSink> (*i);
+      if (sink)
+        {
+          totalRx += sink->GetTotalRx ();
+        }
+    }
+  std::cout << "Rank " << systemId << ": the sinks received "
+            << totalRx << " bytes" << std::endl;
+
+  Simulator::Destroy ();
+  // Exit the MPI execution environment
+  MpiInterface::Disable ();
+  return 0;
+}
@@ -0,0 +1,530 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "mpi-partition-helper.h"
+
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "ns3/node.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MpiPartitionHelper");
+
+/** The number of refinement passes of an assignment. */
+static const uint32_t REFINEMENT_PASSES = 10;
+
+/**
+ * \param parents The parent of each node of a union-find forest.
+ * \param node A node.
+ * \return The root of the tree of the node.
+ */
+static uint32_t
+FindRoot (std::vector<uint32_t> &parents, uint32_t node)
+{
+  while (parents[node] != node)
+    {
+      parents[node] = parents[parents[node]];
+      node = parents[node];
+    }
+  return node;
+}
+
+/** Order groups by decreasing weight, then by index. */
+struct HeavierGroup
+{
+  /**
+   * \param weights The weight of each group.
+   */
+  HeavierGroup (const std::vector<double> &weights)
+    : m_weights (weights)
+  {
+  }
+  /**
+   * \param a A group.
+   * \param b Another group.
+   * \return Whether \p a comes before \p b.
+   */
+  bool operator () (uint32_t a, uint32_t b) const
+  {
+    if (m_weights[a] != m_weights[b])
+      {
+        return m_weights[a] > m_weights[b];
+      }
+    return a < b;
+  }
+  const std::vector<double> &m_weights; //!< The weight of each group.
+};
+
+MpiPartitionHelper::MpiPartitionHelper ()
+  : m_imbalance (0.1),
+    m_nRanks (0)
+{
+}
+
+uint32_t
+MpiPartitionHelper::AddNode (double weight)
+{
+  NS_LOG_FUNCTION (this << weight);
+  NS_ASSERT (weight >= 0);
+  m_weights.push_back (weight);
+  m_nRanks = 0;
+  return m_weights.size () - 1;
+}
+
+uint32_t
+MpiPartitionHelper::AddNodes (uint32_t n, double weight)
+{
+  NS_LOG_FUNCTION (this << n << weight);
+  NS_ASSERT (weight >= 0);
+  uint32_t first = m_weights.size ();
+  m_weights.resize (first + n, weight);
+  m_nRanks = 0;
+  return first;
+}
+
+void
+MpiPartitionHelper::SetWeight (uint32_t node, double weight)
+{
+  NS_LOG_FUNCTION (this << node << weight);
+  NS_ASSERT (node < m_weights.size () && weight >= 0);
+  m_weights[node] = weight;
+  m_nRanks = 0;
+}
+
+uint32_t
+MpiPartitionHelper::GetNNodes (void) const
+{
+  return m_weights.size ();
+}
+
+void
+MpiPartitionHelper::AddLink (uint32_t a, uint32_t b, Time delay)
+{
+  NS_LOG_FUNCTION (this << a << b << delay);
+  NS_ASSERT (a < m_weights.size () && b < m_weights.size ());
+  Link link = { a, b, delay, true };
+  m_links.push_back (link);
+  m_nRanks = 0;
+}
+
+void
+MpiPartitionHelper::AddLocalLink (uint32_t a, uint32_t b)
+{
+  NS_LOG_FUNCTION (this << a << b);
+  NS_ASSERT (a < m_weights.size () && b < m_weights.size ());
+  Link link = { a, b, Time (0), false };
+  m_links.push_back (link);
+  m_nRanks = 0;
+}
+
+void
+MpiPartitionHelper::SetImbalance (double imbalance)
+{
+  NS_LOG_FUNCTION (this << imbalance);
+  NS_ASSERT (imbalance >= 0);
+  m_imbalance = imbalance;
+}
+
+uint32_t
+MpiPartitionHelper::Contract (Time lookahead, std::vector<uint32_t> &groups) const
+{
+  std::vector<uint32_t> parents (m_weights.size ());
+  for (uint32_t i = 0; i < parents.size (); ++i)
+    {
+      parents[i] = i;
+    }
+  for (std::vector<Link>::const_iterator i = m_links.begin (); i != m_links.end (); ++i)
+    {
+      if (!i->remote || i->delay < lookahead)
+        {
+          parents[FindRoot (parents, i->a)] = FindRoot (parents, i->b);
+        }
+    }
+  // number the groups in the order of their first node
+  uint32_t nGroups = 0;
+  std::vector<uint32_t> numbers (m_weights.size (), m_weights.size ());
+  groups.resize (m_weights.size ());
+  for (uint32_t i = 0; i < m_weights.size (); ++i)
+    {
+      uint32_t root = FindRoot (parents, i);
+      if (numbers[root] == m_weights.size ())
+        {
+          numbers[root] = nGroups++;
+        }
+      groups[i] = numbers[root];
+    }
+  return nGroups;
+}
+
+double
+MpiPartitionHelper::Assign (const std::vector<uint32_t> &groups, uint32_t nGroups,
+                            Time lookahead, std::vector<uint32_t> &parts) const
+{
+  NS_LOG_FUNCTION (this << nGroups << lookahead);
+  std::vector<double> weights (nGroups, 0);
+  double total = 0;
+  for (uint32_t i = 0; i < m_weights.size (); ++i)
+    {
+      weights[groups[i]] += m_weights[i];
+      total += m_weights[i];
+    }
+  double maxLoad = (1 + m_imbalance) * total / m_nRanks;
+
+  // the graph of the groups, weighted by the number of links between them
+  std::vector<std::pair<uint32_t, uint32_t> > pairs;
+  for (std::vector<Link>::const_iterator i = m_links.begin (); i != m_links.end (); ++i)
+    {
+      uint32_t a = groups[i->a];
+      uint32_t b = groups[i->b];
+      if (i->remote && i->delay >= lookahead && a != b)
+        {
+          pairs.push_back (std::make_pair (std::min (a, b), std::max (a, b)));
+        }
+    }
+  std::sort (pairs.begin (), pairs.end ());
+  std::vector<std::vector<std::pair<uint32_t, uint32_t> > > neighbors (nGroups);
+  for (uint32_t i = 0; i < pairs.size (); )
+    {
+      uint32_t j = i;
+      while (j < pairs.size () && pairs[j] == pairs[i])
+        {
+          ++j;
+        }
+      neighbors[pairs[i].first].push_back (std::make_pair (pairs[i].second, j - i));
+      neighbors[pairs[i].second].push_back (std::make_pair (pairs[i].first, j - i));
+      i = j;
+    }
+
+  std::vector<uint32_t> order (nGroups);
+  for (uint32_t i = 0; i < nGroups; ++i)
+    {
+      order[i] = i;
+    }
+  std::sort (order.begin (), order.end (), HeavierGroup (weights));
+
+  // grow each rank from the heaviest group left, by adding the groups
+  // which have the most links to it, until it has its share of the load
+  const uint32_t unassigned = m_nRanks;
+  parts.assign (nGroups, unassigned);
+  std::vector<double> loads (m_nRanks, 0);
+  std::vector<uint32_t> connections (nGroups, 0);
+  double left = total;
+  uint32_t next = 0;
+  for (uint32_t rank = 0; rank + 1 < m_nRanks; ++rank)
+    {
+      double target = left / (m_nRanks - rank);
+      std::priority_queue<std::pair<uint32_t, uint32_t> > frontier;
+      std::vector<uint32_t> touched;
+      while (loads[rank] < target)
+        {
+          uint32_t group = nGroups;
+          while (!frontier.empty () && group == nGroups)
+            {
+              std::pair<uint32_t, uint32_t> top = frontier.top ();
+              frontier.pop ();
+              if (parts[top.second] == unassigned && top.first == connections[top.second]
+                  && loads[rank] + weights[top.second] <= maxLoad)
+                {
+                  group = top.second;
+                }
+            }
+          if (group == nGroups)
+            {
+              while (next < nGroups && parts[order[next]] != unassigned)
+                {
+                  ++next;
+                }
+              for (uint32_t i = next; i < nGroups; ++i)
+                {
+                  if (parts[order[i]] == unassigned && loads[rank] + weights[order[i]] <= maxLoad)
+                    {
+                      group = order[i];
+                      break;
+                    }
+                }
+              if (group == nGroups)
+                {
+                  break;
+                }
+            }
+          parts[group] = rank;
+          loads[rank] += weights[group];
+          left -= weights[group];
+          for (uint32_t i = 0; i < neighbors[group].size (); ++i)
+            {
+              uint32_t neighbor = neighbors[group][i].first;
+              if (parts[neighbor] == unassigned)
+                {
+                  connections[neighbor] += neighbors[group][i].second;
+                  frontier.push (std::make_pair (connections[neighbor], neighbor));
+                  touched.push_back (neighbor);
+                }
+            }
+        }
+      for (uint32_t i = 0; i < touched.size (); ++i)
+        {
+          connections[touched[i]] = 0;
+        }
+    }
+  for (uint32_t group = 0; group < nGroups; ++group)
+    {
+      if (parts[group] == unassigned)
+        {
+          parts[group] = m_nRanks - 1;
+          loads[m_nRanks - 1] += weights[group];
+        }
+    }
+
+  // if the growth left the last rank overloaded, place the heaviest
+  // groups first on the least loaded ranks instead
+  if (*std::max_element (loads.begin (), loads.end ()) > maxLoad)
+    {
+      NS_LOG_LOGIC ("Unbalanced growth, largest load " << *std::max_element (loads.begin (), loads.end ()));
+      std::fill (loads.begin (), loads.end (), 0);
+      for (uint32_t i = 0; i < nGroups; ++i)
+        {
+          uint32_t rank = std::min_element (loads.begin (), loads.end ()) - loads.begin ();
+          parts[order[i]] = rank;
+          loads[rank] += weights[order[i]];
+        }
+    }
+
+  // move the groups to the rank with which they have the most links, or
+  // to a less loaded rank when this does not increase the links between
+  // ranks
+  std::vector<uint32_t> links (m_nRanks);
+  for (uint32_t pass = 0; pass < REFINEMENT_PASSES; ++pass)
+    {
+      bool moved = false;
+      for (uint32_t group = 0; group < nGroups; ++group)
+        {
+          uint32_t from = parts[group];
+          std::fill (links.begin (), links.end (), 0);
+          for (uint32_t i = 0; i < neighbors[group].size (); ++i)
+            {
+              links[parts[neighbors[group][i].first]] += neighbors[group][i].second;
+            }
+          uint32_t to = from;
+          int64_t bestGain = 0;
+          for (uint32_t rank = 0; rank < m_nRanks; ++rank)
+            {
+              double load = loads[rank] + weights[group];
+              if (rank == from || load > maxLoad)
+                {
+                  continue;
+                }
+              int64_t gain = int64_t (links[rank]) - int64_t (links[from]);
+              if (gain > bestGain
+                  || (gain == bestGain && load < (to == from ? loads[from] : loads[to] + weights[group])))
+                {
+                  to = rank;
+                  bestGain = gain;
+                }
+            }
+          if (to != from)
+            {
+              parts[group] = to;
+              loads[from] -= weights[group];
+              loads[to] += weights[group];
+              moved = true;
+            }
+        }
+      if (!moved)
+        {
+          break;
+        }
+    }
+  return *std::max_element (loads.begin (), loads.end ());
+}
+
+void
+MpiPartitionHelper::Partition (uint32_t nRanks)
+{
+  NS_LOG_FUNCTION (this << nRanks);
+  NS_ASSERT (nRanks > 0);
+  m_nRanks = nRanks;
+  double total = 0;
+  for (uint32_t i = 0; i < m_weights.size (); ++i)
+    {
+      total += m_weights[i];
+    }
+  double maxLoad = (1 + m_imbalance) * total / m_nRanks;
+
+  // the candidate lookaheads are the delays of the links, from the
+  // largest one, down to 0 where no link is contracted
+  std::vector<Time> lookaheads;
+  lookaheads.push_back (Time (0));
+  for (std::vector<Link>::const_iterator i = m_links.begin (); i != m_links.end (); ++i)
+    {
+      if (i->remote)
+        {
+          lookaheads.push_back (i->delay);
+        }
+    }
+  std::sort (lookaheads.begin (), lookaheads.end (), std::greater<Time> ());
+  lookaheads.erase (std::unique (lookaheads.begin (), lookaheads.end ()), lookaheads.end ());
+
+  // the largest group only grows with the lookahead: skip the lookaheads
+  // for which it does not fit in a rank
+  std::vector<uint32_t> groups;
+  uint32_t low = 0;
+  uint32_t high = lookaheads.size () - 1;
+  while (low < high)
+    {
+      uint32_t middle = (low + high) / 2;
+      uint32_t nGroups = Contract (lookaheads[middle], groups);
+      std::vector<double> weights (nGroups, 0);
+      for (uint32_t i = 0; i < m_weights.size (); ++i)
+        {
+          weights[groups[i]] += m_weights[i];
+        }
+      if (*std::max_element (weights.begin (), weights.end ()) <= maxLoad)
+        {
+          high = middle;
+        }
+      else
+        {
+          low = middle + 1;
+        }
+    }
+
+  std::vector<uint32_t> parts;
+  for (uint32_t i = low; i < lookaheads.size (); ++i)
+    {
+      uint32_t nGroups = Contract (lookaheads[i], groups);
+      double load = Assign (groups, nGroups, lookaheads[i], parts);
+      NS_LOG_LOGIC ("Lookahead " << lookaheads[i] << ": " << nGroups << " groups, largest load " << load);
+      if (load <= maxLoad)
+        {
+          break;
+        }
+    }
+
+  m_systemIds.resize (m_weights.size ());
+  for (uint32_t i = 0; i < m_weights.size (); ++i)
+    {
+      m_systemIds[i] = parts[groups[i]];
+    }
+}
+
+uint32_t
+MpiPartitionHelper::GetSystemId (uint32_t node) const
+{
+  NS_ASSERT_MSG (m_nRanks != 0, "The topology has not been partitioned");
+  NS_ASSERT (node < m_systemIds.size ());
+  return m_systemIds[node];
+}
+
+NodeContainer
+MpiPartitionHelper::Create (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (m_nRanks != 0, "The topology has not been partitioned");
+  NodeContainer nodes;
+  for (uint32_t i = 0; i < m_systemIds.size (); ++i)
+    {
+      nodes.Add (CreateObject<Node> (m_systemIds[i]));
+    }
+  return nodes;
+}
+
+uint32_t
+MpiPartitionHelper::GetCutSize (void) const
+{
+  NS_ASSERT_MSG (m_nRanks != 0, "The topology has not been partitioned");
+  uint32_t cut = 0;
+  for (std::vector<Link>::const_iterator i = m_links.begin (); i != m_links.end (); ++i)
+    {
+      if (m_systemIds[i->a] != m_systemIds[i->b])
+        {
+          cut++;
+        }
+    }
+  return cut;
+}
+
+Time
+MpiPartitionHelper::GetLookahead (void) const
+{
+  NS_ASSERT_MSG (m_nRanks != 0, "The topology has not been partitioned");
+  Time lookahead = Time::Max ();
+  for (std::vector<Link>::const_iterator i = m_links.begin (); i != m_links.end (); ++i)
+    {
+      if (m_systemIds[i->a] != m_systemIds[i->b])
+        {
+          lookahead = std::min (lookahead, i->delay);
+        }
+    }
+  return lookahead;
+}
+
+double
+MpiPartitionHelper::GetLoad (uint32_t rank) const
+{
+  NS_ASSERT_MSG (m_nRanks != 0, "The topology has not been partitioned");
+  double load = 0;
+  for (uint32_t i = 0; i < m_weights.size (); ++i)
+    {
+      if (m_systemIds[i] == rank)
+        {
+          load += m_weights[i];
+        }
+    }
+  return load;
+}
+
+void
+MpiPartitionHelper::Report (std::ostream &os) const
+{
+  NS_ASSERT_MSG (m_nRanks != 0, "The topology has not been partitioned");
+  std::vector<uint32_t> counts (m_nRanks, 0);
+  std::vector<double> loads (m_nRanks, 0);
+  double total = 0;
+  for (uint32_t i = 0; i < m_weights.size (); ++i)
+    {
+      counts[m_systemIds[i]]++;
+      loads[m_systemIds[i]] += m_weights[i];
+      total += m_weights[i];
+    }
+  os << "Partition of " << m_weights.size () << " nodes on " << m_nRanks << " ranks" << std::endl;
+  os << "  Links between ranks: " << GetCutSize () << std::endl;
+  os << "  Lookahead: ";
+  if (GetCutSize () == 0)
+    {
+      os << "none";
+    }
+  else
+    {
+      os << GetLookahead ().As (Time::MS);
+    }
+  os << std::endl;
+  for (uint32_t rank = 0; rank < m_nRanks; ++rank)
+    {
+      os << "  Rank " << rank << ": " << counts[rank] << " nodes, load " << loads[rank];
+      if (total > 0)
+        {
+          os << " (" << 100 * loads[rank] * m_nRanks / total << "% of the average)";
+        }
+      os << std::endl;
+    }
+}
+
+} // namespace ns3
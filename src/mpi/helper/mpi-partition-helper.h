@@ -0,0 +1,193 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_MPI_PARTITION_HELPER_H
+#define NS3_MPI_PARTITION_HELPER_H
+
+#include <stdint.h>
+#include <ostream>
+#include <vector>
+
+#include "ns3/nstime.h"
+#include "ns3/node-container.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup mpi
+ *
+ * \brief Assign the nodes of a topology to the MPI ranks.
+ *
+ * The topology is described to the helper before the nodes are created:
+ * each node is added with a weight, which is its expected share of the
+ * events of the simulation (for instance the number of flows it sends
+ * or receives), and each link is added with its delay.  Only the
+ * point-to-point links, added with AddLink, can cross ranks, where they
+ * become remote links; the other channels, such as CSMA or wireless
+ * channels, are added with AddLocalLink and are kept inside a rank.
+ *
+ * Partition computes an assignment which balances the weight of the
+ * ranks within the allowed imbalance, and which maximizes the lookahead,
+ * the smallest delay of the links between ranks: the links shorter
+ * than the lookahead are never cut.  Among the assignments with this
+ * lookahead, the number of links between ranks is then reduced by
+ * moving nodes to the rank of their neighbors.
+ *
+ * Create then creates the nodes with the system id of their rank, in
+ * the order in which they were added, so that the index of a node in
+ * the helper is its index in the container.
+ *
+ * \code
+ *   MpiPartitionHelper partition;
+ *   uint32_t router = partition.AddNode (4);
+ *   uint32_t leaf = partition.AddNode ();
+ *   partition.AddLink (router, leaf, MilliSeconds (2));
+ *   ...
+ *   partition.Partition (MpiInterface::GetSize ());
+ *   NodeContainer nodes = partition.Create ();
+ * \endcode
+ */
+class MpiPartitionHelper
+{
+public:
+  MpiPartitionHelper ();
+
+  /**
+   * Add a node to the topology.
+   *
+   * \param weight The expected event load of the node.
+   * \return The index of the node.
+   */
+  uint32_t AddNode (double weight = 1.0);
+  /**
+   * Add nodes to the topology.
+   *
+   * \param n The number of nodes.
+   * \param weight The expected event load of each node.
+   * \return The index of the first node.
+   */
+  uint32_t AddNodes (uint32_t n, double weight = 1.0);
+  /**
+   * \param node The index of a node.
+   * \param weight The expected event load of the node.
+   */
+  void SetWeight (uint32_t node, double weight);
+  /**
+   * \return The number of nodes of the topology.
+   */
+  uint32_t GetNNodes (void) const;
+  /**
+   * Add a point-to-point link, which may cross ranks.
+   *
+   * \param a The index of a node.
+   * \param b The index of the other node.
+   * \param delay The delay of the link.
+   */
+  void AddLink (uint32_t a, uint32_t b, Time delay);
+  /**
+   * Add a link which cannot cross ranks.
+   *
+   * \param a The index of a node.
+   * \param b The index of the other node.
+   */
+  void AddLocalLink (uint32_t a, uint32_t b);
+  /**
+   * \param imbalance The fraction by which the weight of a rank may
+   *        exceed the average weight of the ranks (0.1 by default).
+   */
+  void SetImbalance (double imbalance);
+
+  /**
+   * Assign the nodes to the ranks.
+   *
+   * \param nRanks The number of ranks.
+   */
+  void Partition (uint32_t nRanks);
+  /**
+   * \param node The index of a node.
+   * \return The rank of the node.
+   */
+  uint32_t GetSystemId (uint32_t node) const;
+  /**
+   * Create the nodes, with the system id of their rank.
+   *
+   * \return The nodes, in the order of their indices.
+   */
+  NodeContainer Create (void) const;
+
+  /**
+   * \return The number of links between ranks.
+   */
+  uint32_t GetCutSize (void) const;
+  /**
+   * \return The smallest delay of the links between ranks, or Time::Max
+   *         if no link crosses ranks.
+   */
+  Time GetLookahead (void) const;
+  /**
+   * \param rank A rank.
+   * \return The weight of the nodes of the rank.
+   */
+  double GetLoad (uint32_t rank) const;
+  /**
+   * Print the predicted cut size, lookahead and load of each rank.
+   *
+   * \param os The output stream.
+   */
+  void Report (std::ostream &os) const;
+
+private:
+  /** A link of the topology. */
+  struct Link
+  {
+    uint32_t a;   //!< The index of a node.
+    uint32_t b;   //!< The index of the other node.
+    Time delay;   //!< The delay of the link.
+    bool remote;  //!< Whether the link may cross ranks.
+  };
+
+  /**
+   * Group the nodes which are connected by a local link, or by a link
+   * shorter than a lookahead.
+   *
+   * \param lookahead The lookahead.
+   * \param [out] groups The group of each node.
+   * \return The number of groups.
+   */
+  uint32_t Contract (Time lookahead, std::vector<uint32_t> &groups) const;
+  /**
+   * Assign groups of nodes to the ranks.
+   *
+   * \param groups The group of each node.
+   * \param nGroups The number of groups.
+   * \param lookahead The lookahead: the links shorter than it are inside
+   *        the groups.
+   * \param [out] parts The rank of each group.
+   * \return The largest weight of a rank.
+   */
+  double Assign (const std::vector<uint32_t> &groups, uint32_t nGroups,
+                 Time lookahead, std::vector<uint32_t> &parts) const;
+
+  std::vector<double> m_weights;    //!< The weight of each node.
+  std::vector<Link> m_links;        //!< The links.
+  double m_imbalance;               //!< The allowed imbalance.
+  uint32_t m_nRanks;                //!< The number of ranks, or 0 before Partition.
+  std::vector<uint32_t> m_systemIds; //!< The rank of each node.
+};
+
+} // namespace ns3
+
+#endif /* NS3_MPI_PARTITION_HELPER_H */
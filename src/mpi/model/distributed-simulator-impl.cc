@@ -28,9 +28,12 @@
 #include "ns3/node-container.h"
 #include "ns3/ptr.h"
 #include "ns3/pointer.h"
+#include "ns3/uinteger.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 
 #ifdef NS3_MPI
@@ -43,38 +46,27 @@ NS_LOG_COMPONENT_DEFINE ("DistributedSimulatorImpl");
 
 NS_OBJECT_ENSURE_REGISTERED (DistributedSimulatorImpl);
 
-LbtsMessage::~LbtsMessage ()
-{
-}
+namespace {
 
-Time
-LbtsMessage::GetSmallestTime ()
-{
-  return m_smallestTime;
-}
-
-uint32_t
-LbtsMessage::GetTxCount ()
-{
-  return m_txCount;
-}
+/**
+ * The number of events processed between two checks of the round of
+ * the LBTS computation, which only progresses within MPI calls.
+ */
+const uint32_t LBTS_POLL_EVENTS = 64;
 
-uint32_t
-LbtsMessage::GetRxCount ()
-{
-  return m_rxCount;
-}
-uint32_t
-LbtsMessage::GetMyId ()
+/**
+ * \param a A time, in time steps.
+ * \param b A delay, in time steps.
+ * \param infinity The maximum simulation time, in time steps.
+ * \return a + b, or infinity if it is larger.
+ */
+uint64_t
+SaturatedAdd (uint64_t a, uint64_t b, uint64_t infinity)
 {
-  return m_myId;
+  return (a >= infinity || b >= infinity - a) ? infinity : a + b;
 }
 
-bool
-LbtsMessage::IsFinished ()
-{
-  return m_isFinished;
-}
+} // anonymous namespace
 
 Time DistributedSimulatorImpl::m_lookAhead = Seconds (-1);
 
@@ -85,6 +77,25 @@ DistributedSimulatorImpl::GetTypeId (void)
     .SetParent<SimulatorImpl> ()
     .SetGroupName ("Mpi")
     .AddConstructor<DistributedSimulatorImpl> ()
+    .AddAttribute ("Windows",
+                   "The number of rounds of the LBTS computation of the last run.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&DistributedSimulatorImpl::m_nWindows),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("Events",
+                   "The number of events processed by this task in the last run.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&DistributedSimulatorImpl::m_nEvents),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("IdleTime",
+                   "The wall-clock time this task spent waiting for the other "
+                   "tasks in the last run.",
+                   TypeId::ATTR_GET,
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&DistributedSimulatorImpl::GetIdleTime),
+                   MakeTimeChecker ())
   ;
   return tid;
 }
@@ -97,8 +108,6 @@ DistributedSimulatorImpl::DistributedSimulatorImpl ()
   m_myId = MpiInterface::GetSystemId ();
   m_systemCount = MpiInterface::GetSize ();
 
-  // Allocate the LBTS message buffer
-  m_pLBTS = new LbtsMessage[m_systemCount];
   m_grantedTime = Seconds (0);
 #else
   NS_UNUSED (m_systemCount);
@@ -118,6 +127,10 @@ DistributedSimulatorImpl::DistributedSimulatorImpl ()
   m_currentContext = Simulator::NO_CONTEXT;
   m_unscheduledEvents = 0;
   m_events = 0;
+  m_lbtsPending = false;
+  m_nWindows = 0;
+  m_nEvents = 0;
+  m_idleTime = 0;
 }
 
 DistributedSimulatorImpl::~DistributedSimulatorImpl ()
@@ -136,7 +149,6 @@ DistributedSimulatorImpl::DoDispose (void)
       next.impl->Unref ();
     }
   m_events = 0;
-  delete [] m_pLBTS;
   SimulatorImpl::DoDispose ();
 }
 
@@ -166,6 +178,10 @@ DistributedSimulatorImpl::CalculateLookAhead (void)
   NS_LOG_FUNCTION (this);
 
 #ifdef NS3_MPI
+  uint64_t infinity = GetMaximumSimulationTime ().GetTimeStep ();
+  // Smallest delay of the remote links from this task to each task
+  std::vector<uint64_t> delays (m_systemCount, infinity);
+
   if (MpiInterface::GetSize () <= 1)
     {
       m_lookAhead = Seconds (0);
@@ -177,6 +193,7 @@ DistributedSimulatorImpl::CalculateLookAhead (void)
           m_lookAhead = GetMaximumSimulationTime ();
         }
       // else it was already set by SetLookAhead
+      Time maxLookAhead = m_lookAhead;
 
       NodeContainer c = NodeContainer::GetGlobal ();
       for (NodeContainer::Iterator iter = c.Begin (); iter != c.End (); ++iter)
@@ -227,6 +244,17 @@ DistributedSimulatorImpl::CalculateLookAhead (void)
                 {
                   m_lookAhead = delay.Get ();
                 }
+              uint64_t &remoteDelay = delays[remoteNode->GetSystemId ()];
+              remoteDelay = std::min (remoteDelay, static_cast<uint64_t> (delay.Get ().GetTimeStep ()));
+            }
+        }
+
+      // A lookahead set by SetMaximumLookAhead also bounds the delays
+      for (uint32_t i = 0; i < m_systemCount; ++i)
+        {
+          if (delays[i] != infinity)
+            {
+              delays[i] = std::min (delays[i], static_cast<uint64_t> (maxLookAhead.GetTimeStep ()));
             }
         }
     }
@@ -276,6 +304,36 @@ DistributedSimulatorImpl::CalculateLookAhead (void)
       m_grantedTime = m_lookAhead;
     }
 
+  /*
+   * Gather the delays of all the tasks, and find the smallest delay of
+   * a path of remote links from each task to each task, with the
+   * Floyd-Warshall algorithm.  A packet sent by a task at time t
+   * cannot cause an event on another task before t plus the delay of
+   * their path, which may go through other tasks, or back to the task
+   * itself.
+   */
+  std::vector<uint64_t> paths (m_systemCount * m_systemCount);
+  MPI_Allgather (&delays[0], m_systemCount, MPI_UINT64_T, &paths[0], m_systemCount,
+                 MPI_UINT64_T, MPI_COMM_WORLD);
+  for (uint32_t k = 0; k < m_systemCount; ++k)
+    {
+      for (uint32_t i = 0; i < m_systemCount; ++i)
+        {
+          uint64_t ik = paths[i * m_systemCount + k];
+          if (ik == infinity)
+            {
+              continue;
+            }
+          for (uint32_t j = 0; j < m_systemCount; ++j)
+            {
+              uint64_t &ij = paths[i * m_systemCount + j];
+              ij = std::min (ij, SaturatedAdd (ik, paths[k * m_systemCount + j], infinity));
+            }
+        }
+    }
+  m_pathLookAhead.assign (paths.begin () + m_myId * m_systemCount,
+                          paths.begin () + (m_myId + 1) * m_systemCount);
+
 #else
   NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
 #endif
@@ -319,6 +377,7 @@ DistributedSimulatorImpl::ProcessOneEvent (void)
   NS_LOG_FUNCTION (this);
 
   Scheduler::Event next = m_events->RemoveNext ();
+  m_events->NotifyRemoveNext (next);
 
   NS_ASSERT (next.key.m_ts >= m_currentTs);
   m_unscheduledEvents--;
@@ -365,6 +424,105 @@ DistributedSimulatorImpl::Next (void) const
   return TimeStep (NextTs ());
 }
 
+void
+DistributedSimulatorImpl::StartLbts (void)
+{
+  NS_LOG_FUNCTION (this);
+
+#ifdef NS3_MPI
+  NS_ASSERT (!m_lbtsPending);
+  // First send the packets of the window, and receive the pending ones
+  GrantedTimeWindowMpiInterface::FlushSendBuffers ();
+  GrantedTimeWindowMpiInterface::ReceiveMessages ();
+  // And check for send completes
+  GrantedTimeWindowMpiInterface::TestSendComplete ();
+
+  // Then start the round with the packet counts, and with the time
+  // before which each task may receive a packet from this task
+  uint64_t infinity = GetMaximumSimulationTime ().GetTimeStep ();
+  uint64_t next = NextTs ();
+  m_lbtsTimes.resize (m_systemCount + 2);
+  m_lbtsGrantedTimes.resize (m_systemCount + 2);
+  for (uint32_t i = 0; i < m_systemCount; ++i)
+    {
+      m_lbtsTimes[i] = SaturatedAdd (next, m_pathLookAhead[i], infinity);
+    }
+  m_lbtsTimes[m_systemCount] = next;
+  m_lbtsTimes[m_systemCount + 1] = IsLocalFinished () ? 1 : 0;
+  m_lbtsCounts[0] = GrantedTimeWindowMpiInterface::GetTxCount ();
+  m_lbtsCounts[1] = GrantedTimeWindowMpiInterface::GetRxCount ();
+  MPI_Iallreduce (&m_lbtsTimes[0], &m_lbtsGrantedTimes[0], m_systemCount + 2, MPI_UINT64_T,
+                  MPI_MIN, MPI_COMM_WORLD, &m_lbtsRequests[0]);
+  MPI_Iallreduce (m_lbtsCounts, m_lbtsTotalCounts, 2, MPI_UINT64_T,
+                  MPI_SUM, MPI_COMM_WORLD, &m_lbtsRequests[1]);
+  m_lbtsPending = true;
+  // The packets sent from now on are only sent by the next StartLbts,
+  // once all the tasks have counted their packets for this round:  a
+  // packet received before the count of its receiver, but not counted
+  // by its sender, could otherwise make up for a packet still in transit
+  GrantedTimeWindowMpiInterface::DeferSends (true);
+#else
+  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+#endif
+}
+
+bool
+DistributedSimulatorImpl::TestLbts (void)
+{
+#ifdef NS3_MPI
+  int completed;
+  MPI_Testall (2, m_lbtsRequests, &completed, MPI_STATUSES_IGNORE);
+  if (!completed)
+    {
+      return false;
+    }
+  m_lbtsPending = false;
+  GrantedTimeWindowMpiInterface::DeferSends (false);
+  m_nWindows++;
+
+  // The sent and received counts insure there are no transient
+  // messages;  if they differ, there are transients, so we don't
+  // update the granted time.
+  if (m_lbtsTotalCounts[0] == m_lbtsTotalCounts[1])
+    {
+      uint64_t infinity = GetMaximumSimulationTime ().GetTimeStep ();
+      uint64_t grantedTs = m_lbtsGrantedTimes[m_myId];
+      uint64_t smallestTs = m_lbtsGrantedTimes[m_systemCount];
+      m_globalFinished = m_lbtsGrantedTimes[m_systemCount + 1] == 1;
+      // A task which no other task can reach uses the largest lookahead
+      // of the tasks, so that the tasks advance at a similar rate,
+      // unless no task has remote links.
+      if (grantedTs == infinity && m_lookAhead.IsStrictlyPositive ()
+          && m_lookAhead != GetMaximumSimulationTime ())
+        {
+          grantedTs = SaturatedAdd (smallestTs, m_lookAhead.GetTimeStep (), infinity);
+        }
+      if (grantedTs > static_cast<uint64_t> (m_grantedTime.GetTimeStep ()))
+        {
+          m_grantedTime = TimeStep (grantedTs);
+        }
+      NS_LOG_LOGIC ("granted time " << m_grantedTime);
+    }
+
+  // Start the next round at once, so that it progresses while the
+  // events of the window are processed
+  if (!m_globalFinished)
+    {
+      StartLbts ();
+    }
+  return true;
+#else
+  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+  return false;
+#endif
+}
+
+Time
+DistributedSimulatorImpl::GetIdleTime (void) const
+{
+  return NanoSeconds (m_idleTime);
+}
+
 void
 DistributedSimulatorImpl::Run (void)
 {
@@ -373,73 +531,47 @@ DistributedSimulatorImpl::Run (void)
 #ifdef NS3_MPI
   CalculateLookAhead ();
   m_stop = false;
+  m_globalFinished = false;
+  m_nWindows = 0;
+  m_nEvents = 0;
+  m_idleTime = 0;
+  StartLbts ();
+  uint32_t polls = 0;
   while (!m_globalFinished)
     {
-      Time nextTime = Next ();
-
-      // If local event is beyond grantedTime then need to synchronize
-      // with other tasks to determine new time window. If local task
-      // is finished then continue to participate in allgather
-      // synchronizations with other tasks until all tasks have
-      // completed.
-      if (nextTime > m_grantedTime || IsLocalFinished () )
+      // Execute next event if it is within the current time window.
+      // Local task may be completed.
+      if (!IsLocalFinished () && NextTs () <= static_cast<uint64_t> (m_grantedTime.GetTimeStep ()))
         {
-          // Can't process next event, calculate a new LBTS
-          // First receive any pending messages
-          GrantedTimeWindowMpiInterface::ReceiveMessages ();
-          // reset next time
-          nextTime = Next ();
-          // And check for send completes
-          GrantedTimeWindowMpiInterface::TestSendComplete ();
-          // Finally calculate the lbts
-          LbtsMessage lMsg (GrantedTimeWindowMpiInterface::GetRxCount (), GrantedTimeWindowMpiInterface::GetTxCount (), 
-                            m_myId, IsLocalFinished (), nextTime);
-          m_pLBTS[m_myId] = lMsg;
-          MPI_Allgather (&lMsg, sizeof (LbtsMessage), MPI_BYTE, m_pLBTS,
-                         sizeof (LbtsMessage), MPI_BYTE, MPI_COMM_WORLD);
-          Time smallestTime = m_pLBTS[0].GetSmallestTime ();
-          // The totRx and totTx counts insure there are no transient
-          // messages;  If totRx != totTx, there are transients,
-          // so we don't update the granted time.
-          uint32_t totRx = m_pLBTS[0].GetRxCount ();
-          uint32_t totTx = m_pLBTS[0].GetTxCount ();
-          m_globalFinished = m_pLBTS[0].IsFinished ();
-
-          for (uint32_t i = 1; i < m_systemCount; ++i)
-            {
-              if (m_pLBTS[i].GetSmallestTime () < smallestTime)
-                {
-                  smallestTime = m_pLBTS[i].GetSmallestTime ();
-                }
-              totRx += m_pLBTS[i].GetRxCount ();
-              totTx += m_pLBTS[i].GetTxCount ();
-              m_globalFinished &= m_pLBTS[i].IsFinished ();
-            }
-          if (totRx == totTx)
+          ProcessOneEvent ();
+          m_nEvents++;
+          // Let the round progress, as the other tasks may be waiting for it
+          if (++polls == LBTS_POLL_EVENTS)
             {
-              // If lookahead is infinite then granted time should be as well.
-              // Covers the edge case if all the tasks have no inter tasks
-              // links, prevents overflow of granted time.
-              if (m_lookAhead == GetMaximumSimulationTime ())
-                {
-                  m_grantedTime = GetMaximumSimulationTime ();
-                }
-              else
-                {
-                  // Overflow is possible here if near end of representable time.
-                  m_grantedTime = smallestTime + m_lookAhead;
-                }
+              polls = 0;
+              TestLbts ();
             }
+          continue;
         }
 
-      // Execute next event if it is within the current time window.
-      // Local task may be completed.
-      if ( (nextTime <= m_grantedTime) && (!IsLocalFinished ()) )
-        { // Safe to process
-          ProcessOneEvent ();
+      // If local event is beyond grantedTime then need to wait for a
+      // round of the LBTS computation.  If local task is finished then
+      // continue to participate in the rounds until all tasks have
+      // completed.
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+      while (!TestLbts ())
+        {
+          GrantedTimeWindowMpiInterface::ReceiveMessages ();
         }
+      m_idleTime += std::chrono::duration_cast<std::chrono::nanoseconds>
+          (std::chrono::steady_clock::now () - start).count ();
     }
 
+  NS_LOG_INFO ("task " << m_myId << ": " << m_nWindows << " windows, "
+               << m_nEvents << " events, "
+               << (m_nWindows != 0 ? double (m_nEvents) / m_nWindows : 0)
+               << " events per window, idle " << GetIdleTime ().GetSeconds () << "s");
+
   // If the simulator stopped naturally by lack of events, make a
   // consistency test to check that we didn't lose any events along the way.
   NS_ASSERT (!m_events->IsEmpty () || m_unscheduledEvents == 0);
@@ -592,6 +724,12 @@ DistributedSimulatorImpl::Cancel (const EventId &id)
   if (!IsExpired (id))
     {
       id.PeekEventImpl ()->Cancel ();
+      if (id.GetUid () != 2)
+        {
+          // the event stays in the event list, unless the scheduler
+          // compacts it now
+          m_unscheduledEvents -= m_events->NotifyCancel ();
+        }
     }
 }
 
@@ -26,77 +26,41 @@
 #include "ns3/ptr.h"
 
 #include <list>
+#include <vector>
 
-namespace ns3 {
-
-/**
- * \ingroup mpi
- *
- * \brief Structure used for all-reduce LBTS computation
- */
-class LbtsMessage
-{
-public:
-  LbtsMessage ()
-    : m_txCount (0),
-      m_rxCount (0),
-      m_myId (0),
-      m_isFinished (false)
-  {
-  }
-
-  /**
-   * \param rxc received count
-   * \param txc transmitted count
-   * \param id mpi rank
-   * \param isFinished whether message is finished
-   * \param t smallest time
-   */
-  LbtsMessage (uint32_t rxc, uint32_t txc, uint32_t id, bool isFinished, const Time& t)
-    : m_txCount (txc),
-      m_rxCount (rxc),
-      m_myId (id),
-      m_smallestTime (t),
-      m_isFinished (isFinished)
-  {
-  }
-
-  ~LbtsMessage ();
-
-  /**
-   * \return smallest time
-   */
-  Time GetSmallestTime ();
-  /**
-   * \return transmitted count
-   */
-  uint32_t GetTxCount ();
-  /**
-   * \return received count
-   */
-  uint32_t GetRxCount ();
-  /**
-   * \return id which corresponds to mpi rank
-   */
-  uint32_t GetMyId ();
-  /**
-   * \return true if system is finished
-   */
-  bool IsFinished ();
+#ifdef NS3_MPI
+#include "mpi.h"
+#else
+typedef void* MPI_Request;
+#endif
 
-private:
-  uint32_t m_txCount;
-  uint32_t m_rxCount;
-  uint32_t m_myId;
-  Time     m_smallestTime;
-  bool     m_isFinished;
-};
+namespace ns3 {
 
 /**
  * \ingroup simulator
  * \ingroup mpi
  *
  * \brief Distributed simulator implementation using lookahead
+ *
+ * The tasks are synchronized by granted time windows.  Each task may
+ * process its events up to its granted time, beyond which it could
+ * still receive packets from the other tasks: the smallest time, over
+ * all the tasks, of their next event plus the smallest delay of a path
+ * of remote links from them to this task.  The lookahead thus depends
+ * on the pair of tasks, and a task far from the others, in delay, gets
+ * larger windows.
+ *
+ * The granted times are computed in rounds of non-blocking reductions
+ * of the next event times of the tasks, each started as soon as the
+ * previous one has completed, so that a round progresses while the
+ * tasks process the events of their windows, and a task only waits
+ * when it has reached its granted time before the round has completed.
+ * A round whose sent and received packet counts differ, as packets were
+ * in transit, is ignored.
+ *
+ * The number of windows, the number of events and the time spent
+ * waiting for the other tasks in the last run are available as the
+ * read-only attributes Windows, Events and IdleTime.
  */
 class DistributedSimulatorImpl : public SimulatorImpl
 {
@@ -135,6 +99,23 @@ private:
   void ProcessOneEvent (void);
   uint64_t NextTs (void) const;
   Time Next (void) const;
+  /**
+   * Send the pending packets, and start a round of the LBTS
+   * computation with the next event time and the packet counts of
+   * this task.
+   */
+  void StartLbts (void);
+  /**
+   * Check whether the round of the LBTS computation has completed,
+   * and update the granted time and start the next round if so.
+   *
+   * \return true if the round has completed.
+   */
+  bool TestLbts (void);
+  /**
+   * \return the time spent waiting for the other tasks in the last run
+   */
+  Time GetIdleTime (void) const;
   typedef std::list<EventId> DestroyEvents;
 
   DestroyEvents m_destroyEvents;
@@ -149,12 +130,29 @@ private:
   // not counting the "destroy" events; this is used for validation
   int m_unscheduledEvents;
 
-  LbtsMessage* m_pLBTS;       // Allocated once we know how many systems
   uint32_t     m_myId;        // MPI Rank
   uint32_t     m_systemCount; // MPI Size
   Time         m_grantedTime; // Last LBTS
   static Time  m_lookAhead;   // Lookahead value
 
+  // Smallest delay of a path of remote links from this task to each
+  // task, in time steps; the maximum simulation time if there is none
+  std::vector<uint64_t> m_pathLookAhead;
+  // Values reduced by a round of the LBTS computation: the time before
+  // which each task may receive a packet from this task, and whether
+  // this task is finished, with the minimum; the sent and received
+  // packet counts, with the sum
+  std::vector<uint64_t> m_lbtsTimes;
+  std::vector<uint64_t> m_lbtsGrantedTimes;
+  uint64_t     m_lbtsCounts[2];
+  uint64_t     m_lbtsTotalCounts[2];
+  MPI_Request  m_lbtsRequests[2];
+  bool         m_lbtsPending; // Is a round in progress
+
+  uint64_t     m_nWindows;    // Completed rounds of the last run
+  uint64_t     m_nEvents;     // Events processed in the last run
+  int64_t      m_idleTime;    // Time waiting for rounds, in nanoseconds
+
 };
 
 } // namespace ns3
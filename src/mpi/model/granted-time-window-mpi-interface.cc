@@ -22,7 +22,7 @@
 
 #include <iostream>
 #include <iomanip>
-#include <list>
+#include <cstring>
 
 #include "granted-time-window-mpi-interface.h"
 #include "mpi-receiver.h"
@@ -44,49 +44,13 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("GrantedTimeWindowMpiInterface");
 
-SentBuffer::SentBuffer ()
-{
-  m_buffer = 0;
-  m_request = 0;
-}
-
-SentBuffer::~SentBuffer ()
-{
-  delete [] m_buffer;
-}
-
-uint8_t*
-SentBuffer::GetBuffer ()
-{
-  return m_buffer;
-}
-
-void
-SentBuffer::SetBuffer (uint8_t* buffer)
-{
-  m_buffer = buffer;
-}
-
-#ifdef NS3_MPI
-MPI_Request*
-SentBuffer::GetRequest ()
-{
-  return &m_request;
-}
-#endif
-
 uint32_t              GrantedTimeWindowMpiInterface::m_sid = 0;
 uint32_t              GrantedTimeWindowMpiInterface::m_size = 1;
 bool                  GrantedTimeWindowMpiInterface::m_initialized = false;
 bool                  GrantedTimeWindowMpiInterface::m_enabled = false;
 uint32_t              GrantedTimeWindowMpiInterface::m_rxCount = 0;
 uint32_t              GrantedTimeWindowMpiInterface::m_txCount = 0;
-std::list<SentBuffer> GrantedTimeWindowMpiInterface::m_pendingTx;
-
-#ifdef NS3_MPI
-MPI_Request* GrantedTimeWindowMpiInterface::m_requests;
-char**       GrantedTimeWindowMpiInterface::m_pRxBuffers;
-#endif
+MpiMessageBatcher     GrantedTimeWindowMpiInterface::m_batcher;
 
 TypeId 
 GrantedTimeWindowMpiInterface::GetTypeId (void)
@@ -104,14 +68,7 @@ GrantedTimeWindowMpiInterface::Destroy ()
   NS_LOG_FUNCTION (this);
 
 #ifdef NS3_MPI
-  for (uint32_t i = 0; i < GetSize (); ++i)
-    {
-      delete [] m_pRxBuffers[i];
-    }
-  delete [] m_pRxBuffers;
-  delete [] m_requests;
-
-  m_pendingTx.clear ();
+  m_batcher.Destroy ();
 #endif
 }
 
@@ -173,15 +130,8 @@ GrantedTimeWindowMpiInterface::Enable (int* pargc, char*** pargv)
   MPI_Comm_size (MPI_COMM_WORLD, reinterpret_cast <int *> (&m_size));
   m_enabled = true;
   m_initialized = true;
-  // Post a non-blocking receive for all peers
-  m_pRxBuffers = new char*[m_size];
-  m_requests = new MPI_Request[m_size];
-  for (uint32_t i = 0; i < GetSize (); ++i)
-    {
-      m_pRxBuffers[i] = new char[MAX_MPI_MSG_SIZE];
-      MPI_Irecv (m_pRxBuffers[i], MAX_MPI_MSG_SIZE, MPI_CHAR, MPI_ANY_SOURCE, 0,
-                 MPI_COMM_WORLD, &m_requests[i]);
-    }
+  // One batch of packets for each peer
+  m_batcher.Initialize (m_size);
 #else
   NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
 #endif
@@ -193,29 +143,19 @@ GrantedTimeWindowMpiInterface::SendPacket (Ptr<Packet> p, const Time& rxTime, ui
   NS_LOG_FUNCTION (this << p << rxTime.GetTimeStep () << node << dev);
 
 #ifdef NS3_MPI
-  SentBuffer sendBuf;
-  m_pendingTx.push_back (sendBuf);
-  std::list<SentBuffer>::reverse_iterator i = m_pendingTx.rbegin (); // Points to the last element
+  // Find the system id for the destination node
+  Ptr<Node> destNode = NodeList::GetNode (node);
+  uint32_t nodeSysId = destNode->GetSystemId ();
 
   uint32_t serializedSize = p->GetSerializedSize ();
-  uint8_t* buffer =  new uint8_t[serializedSize + 16];
-  i->SetBuffer (buffer);
+  uint8_t* buffer = m_batcher.Append (nodeSysId, serializedSize + 16);
   // Add the time, dest node and dest device
   uint64_t t = rxTime.GetInteger ();
-  uint64_t* pTime = reinterpret_cast <uint64_t *> (buffer);
-  *pTime++ = t;
-  uint32_t* pData = reinterpret_cast<uint32_t *> (pTime);
-  *pData++ = node;
-  *pData++ = dev;
+  std::memcpy (buffer, &t, sizeof (t));
+  std::memcpy (buffer + 8, &node, sizeof (node));
+  std::memcpy (buffer + 12, &dev, sizeof (dev));
   // Serialize the packet
-  p->Serialize (reinterpret_cast<uint8_t *> (pData), serializedSize);
-
-  // Find the system id for the destination node
-  Ptr<Node> destNode = NodeList::GetNode (node);
-  uint32_t nodeSysId = destNode->GetSystemId ();
-
-  MPI_Isend (reinterpret_cast<void *> (i->GetBuffer ()), serializedSize + 16, MPI_CHAR, nodeSysId,
-             0, MPI_COMM_WORLD, (i->GetRequest ()));
+  p->Serialize (buffer + 16, serializedSize);
   m_txCount++;
 #else
   NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
@@ -228,59 +168,84 @@ GrantedTimeWindowMpiInterface::ReceiveMessages ()
   NS_LOG_FUNCTION_NOARGS ();
 
 #ifdef NS3_MPI
-  // Poll the non-block reads to see if data arrived
-  while (true)
+  // Poll for the batches which have arrived
+  uint32_t source;
+  while (m_batcher.Receive (false, &source) != 0)
     {
-      int flag = 0;
-      int index = 0;
-      MPI_Status status;
-
-      MPI_Testany (MpiInterface::GetSize (), m_requests, &index, &flag, &status);
-      if (!flag)
+      uint32_t offset = 0;
+      uint32_t count;
+      const uint8_t* record;
+      while ((record = m_batcher.GetRecord (&offset, &count)) != 0)
         {
-          break;        // No more messages
+          ReceivePacket (record, count);
         }
-      int count;
-      MPI_Get_count (&status, MPI_CHAR, &count);
-      m_rxCount++; // Count this receive
+    }
+#else
+  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+#endif
+}
 
-      // Get the meta data first
-      uint64_t* pTime = reinterpret_cast<uint64_t *> (m_pRxBuffers[index]);
-      uint64_t time = *pTime++;
-      uint32_t* pData = reinterpret_cast<uint32_t *> (pTime);
-      uint32_t node = *pData++;
-      uint32_t dev  = *pData++;
+void
+GrantedTimeWindowMpiInterface::ReceivePacket (const uint8_t* record, uint32_t count)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  m_rxCount++; // Count this receive
 
-      Time rxTime (time);
+  // Get the meta data first
+  uint64_t time;
+  uint32_t node;
+  uint32_t dev;
+  std::memcpy (&time, record, sizeof (time));
+  std::memcpy (&node, record + 8, sizeof (node));
+  std::memcpy (&dev, record + 12, sizeof (dev));
 
-      count -= sizeof (time) + sizeof (node) + sizeof (dev);
+  Time rxTime (time);
 
-      Ptr<Packet> p = Create<Packet> (reinterpret_cast<uint8_t *> (pData), count, true);
+  count -= sizeof (time) + sizeof (node) + sizeof (dev);
 
-      // Find the correct node/device to schedule receive event
-      Ptr<Node> pNode = NodeList::GetNode (node);
-      Ptr<MpiReceiver> pMpiRec = 0;
-      uint32_t nDevices = pNode->GetNDevices ();
-      for (uint32_t i = 0; i < nDevices; ++i)
+  Ptr<Packet> p = Create<Packet> (record + 16, count, true);
+
+  // Find the correct node/device to schedule receive event
+  Ptr<Node> pNode = NodeList::GetNode (node);
+  Ptr<MpiReceiver> pMpiRec = 0;
+  uint32_t nDevices = pNode->GetNDevices ();
+  for (uint32_t i = 0; i < nDevices; ++i)
+    {
+      Ptr<NetDevice> pThisDev = pNode->GetDevice (i);
+      if (pThisDev->GetIfIndex () == dev)
         {
-          Ptr<NetDevice> pThisDev = pNode->GetDevice (i);
-          if (pThisDev->GetIfIndex () == dev)
-            {
-              pMpiRec = pThisDev->GetObject<MpiReceiver> ();
-              break;
-            }
+          pMpiRec = pThisDev->GetObject<MpiReceiver> ();
+          break;
         }
+    }
 
-      NS_ASSERT (pNode && pMpiRec);
+  NS_ASSERT (pNode && pMpiRec);
 
-      // Schedule the rx event
-      Simulator::ScheduleWithContext (pNode->GetId (), rxTime - Simulator::Now (),
-                                      &MpiReceiver::Receive, pMpiRec, p);
+  // Schedule the rx event
+  Simulator::ScheduleWithContext (pNode->GetId (), rxTime - Simulator::Now (),
+                                  &MpiReceiver::Receive, pMpiRec, p);
+}
 
-      // Re-queue the next read
-      MPI_Irecv (m_pRxBuffers[index], MAX_MPI_MSG_SIZE, MPI_CHAR, MPI_ANY_SOURCE, 0,
-                 MPI_COMM_WORLD, &m_requests[index]);
-    }
+void
+GrantedTimeWindowMpiInterface::FlushSendBuffers ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+#ifdef NS3_MPI
+  m_batcher.FlushAll ();
+#else
+  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+#endif
+}
+
+void
+GrantedTimeWindowMpiInterface::DeferSends (bool deferred)
+{
+  NS_LOG_FUNCTION (deferred);
+
+#ifdef NS3_MPI
+  m_batcher.SetDeferred (deferred);
 #else
   NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
 #endif
@@ -292,19 +257,7 @@ GrantedTimeWindowMpiInterface::TestSendComplete ()
   NS_LOG_FUNCTION_NOARGS ();
 
 #ifdef NS3_MPI
-  std::list<SentBuffer>::iterator i = m_pendingTx.begin ();
-  while (i != m_pendingTx.end ())
-    {
-      MPI_Status status;
-      int flag = 0;
-      MPI_Test (i->GetRequest (), &flag, &status);
-      std::list<SentBuffer>::iterator current = i; // Save current for erasing
-      i++;                                    // Advance to next
-      if (flag)
-        { // This message is complete
-          m_pendingTx.erase (current);
-        }
-    }
+  m_batcher.TestSendComplete ();
 #else
   NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
 #endif
@@ -24,59 +24,15 @@
 #define NS3_GRANTED_TIME_WINDOW_MPI_INTERFACE_H
 
 #include <stdint.h>
-#include <list>
 
 #include "ns3/nstime.h"
 #include "ns3/buffer.h"
 
 #include "parallel-communication-interface.h"
-
-#ifdef NS3_MPI
-#include "mpi.h"
-#else
-typedef void* MPI_Request;
-#endif
+#include "mpi-message-batcher.h"
 
 namespace ns3 {
 
-/**
- * maximum MPI message size for easy
- * buffer creation
- */
-const uint32_t MAX_MPI_MSG_SIZE = 2000;
-
-/**
- * \ingroup mpi
- *
- * \brief Tracks non-blocking sends
- *
- * This class is used to keep track of the asynchronous non-blocking
- * sends that have been posted.
- */
-class SentBuffer
-{
-public:
-  SentBuffer ();
-  ~SentBuffer ();
-
-  /**
-   * \return pointer to sent buffer
-   */
-  uint8_t* GetBuffer ();
-  /**
-   * \param buffer pointer to sent buffer
-   */
-  void SetBuffer (uint8_t* buffer);
-  /**
-   * \return MPI request
-   */
-  MPI_Request* GetRequest ();
-
-private:
-  uint8_t* m_buffer;
-  MPI_Request m_request;
-};
-
 class Packet;
 
 /**
@@ -87,6 +43,9 @@ class Packet;
  * Implements the interface used by the singleton parallel controller
  * to interface between NS3 and the communications layer being
  * used for inter-task packet transfers.
+ *
+ * The packets sent to a task are aggregated in a single MPI message,
+ * which is sent when the granted time window ends, by FlushSendBuffers.
  */
 class GrantedTimeWindowMpiInterface : public ParallelCommunicationInterface, Object
 {
@@ -128,9 +87,30 @@ public:
    * \param node destination node
    * \param dev destination device
    *
-   * Serialize and send a packet to the specified node and net device
+   * Serialize a packet for the specified node and net device, in the
+   * batch of packets to the task of the node.
+   *
+   * \internal
+   * The record of a packet in the batch holds:
+   *
+   * uint64_t time the packet should be delivered
+   * uint32_t node id of destination
+   * uint32_t dev id on destination
+   * uint8_t[] serialized packet
    */
   virtual void SendPacket (Ptr<Packet> p, const Time &rxTime, uint32_t node, uint32_t dev);
+  /**
+   * Send the batches of packets to the other tasks
+   */
+  static void FlushSendBuffers ();
+  /**
+   * \param deferred whether the batches are only sent by FlushSendBuffers
+   *
+   * Keep the packets in their batch whatever its size, so that no packet
+   * is sent between the time a task counts its packets for a round of
+   * the LBTS computation and the end of the round
+   */
+  static void DeferSends (bool deferred);
   /**
    * Check for received messages complete
    */
@@ -149,6 +129,14 @@ public:
   static uint32_t GetTxCount ();
 
 private:
+  /**
+   * \param record record of a received packet
+   * \param count size of the record
+   *
+   * Deserialize a received packet and schedule its reception
+   */
+  static void ReceivePacket (const uint8_t* record, uint32_t count);
+
   static uint32_t m_sid;
   static uint32_t m_size;
 
@@ -160,14 +148,8 @@ private:
   static bool     m_initialized;
   static bool     m_enabled;
 
-  // Pending non-blocking receives
-  static MPI_Request* m_requests;
-
-  // Data buffers for non-blocking reads
-  static char**   m_pRxBuffers;
-
-  // List of pending non-blocking sends
-  static std::list<SentBuffer> m_pendingTx;
+  // Batches of packets to send, and buffers of received batches
+  static MpiMessageBatcher m_batcher;
 };
 
 } // namespace ns3
@@ -24,9 +24,13 @@
 #include <ns3/global-value.h>
 #include <ns3/string.h>
 #include <ns3/log.h>
+#include <ns3/core-config.h>
 
 #include "null-message-mpi-interface.h"
 #include "granted-time-window-mpi-interface.h"
+#ifdef HAVE_PTHREAD_H
+#include "threaded-communication-interface.h"
+#endif
 
 namespace ns3 {
 
@@ -72,6 +76,19 @@ MpiInterface::IsEnabled ()
     }
 }
 
+bool
+MpiInterface::IsLocal (uint32_t systemId)
+{
+  if (g_parallelCommunicationInterface)
+    {
+      return g_parallelCommunicationInterface->IsLocal (systemId);
+    }
+  else
+    {
+      return systemId == 0;
+    }
+}
+
 void
 MpiInterface::Enable (int* pargc, char*** pargv)
 {
@@ -94,6 +111,13 @@ MpiInterface::Enable (int* pargc, char*** pargv)
           g_parallelCommunicationInterface = new GrantedTimeWindowMpiInterface ();
           useDefault = false;
         }
+#ifdef HAVE_PTHREAD_H
+      else if (simulationType.compare ("ns3::ThreadedSimulatorImpl") == 0)
+        {
+          g_parallelCommunicationInterface = new ThreadedCommunicationInterface ();
+          useDefault = false;
+        }
+#endif
     }
 
   // User did not specify a valid parallel simulator; use the default.
@@ -70,6 +70,14 @@ public:
    * \return true if parallel communication is enabled
    */
   static bool IsEnabled ();
+  /**
+   * \param systemId system identification
+   * \return true if the nodes of the system are simulated by this process
+   *
+   * This is the case of the current system only, unless the systems are
+   * the threads of a single process.
+   */
+  static bool IsLocal (uint32_t systemId);
   /**
    * \param pargc number of command line arguments
    * \param pargv command line arguments
@@ -0,0 +1,234 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "mpi-message-batcher.h"
+
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+#include <cstring>
+
+#ifdef NS3_MPI
+#include <mpi.h>
+#endif
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MpiMessageBatcher");
+
+/** The size of the header of a record, which holds its size. */
+static const uint32_t RECORD_HEADER_SIZE = 8;
+
+/**
+ * \param size A size.
+ * \return The size rounded up to a multiple of 8 bytes.
+ */
+static uint32_t
+Pad (uint32_t size)
+{
+  return (size + 7) & ~uint32_t (7);
+}
+
+MpiMessageBatcher::MpiMessageBatcher ()
+  : m_receivedSize (0),
+    m_nMessages (0),
+    m_deferred (false)
+{
+}
+
+MpiMessageBatcher::~MpiMessageBatcher ()
+{
+}
+
+void
+MpiMessageBatcher::Initialize (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  m_batches.clear ();
+  m_batches.resize (size);
+}
+
+void
+MpiMessageBatcher::Destroy (void)
+{
+  NS_LOG_FUNCTION (this);
+#ifdef NS3_MPI
+  for (std::list<PendingSend>::iterator i = m_pending.begin (); i != m_pending.end (); ++i)
+    {
+      int flag = 0;
+      MPI_Test (&i->request, &flag, MPI_STATUS_IGNORE);
+      if (!flag)
+        {
+          MPI_Cancel (&i->request);
+          MPI_Request_free (&i->request);
+        }
+    }
+#endif
+  m_pending.clear ();
+  m_batches.clear ();
+  m_pool.clear ();
+  std::vector<uint8_t> ().swap (m_received);
+  m_receivedSize = 0;
+}
+
+void
+MpiMessageBatcher::GetBuffer (std::vector<uint8_t> &buffer)
+{
+  if (!m_pool.empty ())
+    {
+      buffer.swap (m_pool.back ());
+      m_pool.pop_back ();
+    }
+  buffer.clear ();
+}
+
+void
+MpiMessageBatcher::SetDeferred (bool deferred)
+{
+  NS_LOG_FUNCTION (this << deferred);
+  m_deferred = deferred;
+}
+
+uint8_t *
+MpiMessageBatcher::Append (uint32_t rank, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << rank << size);
+  NS_ASSERT (rank < m_batches.size ());
+  uint32_t recordSize = RECORD_HEADER_SIZE + Pad (size);
+  if (!m_deferred && !m_batches[rank].empty () && m_batches[rank].size () + recordSize > FLUSH_SIZE)
+    {
+      Flush (rank);
+    }
+  std::vector<uint8_t> &batch = m_batches[rank];
+  uint32_t offset = batch.size ();
+  batch.resize (offset + recordSize);
+  std::memcpy (&batch[offset], &size, sizeof (size));
+  return &batch[offset + RECORD_HEADER_SIZE];
+}
+
+void
+MpiMessageBatcher::Flush (uint32_t rank)
+{
+  NS_LOG_FUNCTION (this << rank);
+  NS_ASSERT (rank < m_batches.size ());
+  if (m_batches[rank].empty ())
+    {
+      return;
+    }
+#ifdef NS3_MPI
+  // the batch is swapped into the pending send, so that its data does
+  // not move while MPI sends it
+  m_pending.push_back (PendingSend ());
+  PendingSend &send = m_pending.back ();
+  send.buffer.swap (m_batches[rank]);
+  GetBuffer (m_batches[rank]);
+  MPI_Isend (&send.buffer[0], send.buffer.size (), MPI_BYTE, rank, 0,
+             MPI_COMM_WORLD, &send.request);
+  m_nMessages++;
+#endif
+}
+
+void
+MpiMessageBatcher::FlushAll (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t rank = 0; rank < m_batches.size (); ++rank)
+    {
+      Flush (rank);
+    }
+}
+
+void
+MpiMessageBatcher::TestSendComplete (void)
+{
+  NS_LOG_FUNCTION (this);
+#ifdef NS3_MPI
+  std::list<PendingSend>::iterator i = m_pending.begin ();
+  while (i != m_pending.end ())
+    {
+      int flag = 0;
+      MPI_Test (&i->request, &flag, MPI_STATUS_IGNORE);
+      if (flag)
+        {
+          m_pool.push_back (std::vector<uint8_t> ());
+          m_pool.back ().swap (i->buffer);
+          i = m_pending.erase (i);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+#endif
+}
+
+uint32_t
+MpiMessageBatcher::Receive (bool blocking, uint32_t *source)
+{
+  NS_LOG_FUNCTION (this << blocking);
+  m_receivedSize = 0;
+#ifdef NS3_MPI
+  int flag = 0;
+  MPI_Status status;
+  if (blocking)
+    {
+      MPI_Probe (MPI_ANY_SOURCE, 0, MPI_COMM_WORLD, &status);
+      flag = 1;
+    }
+  else
+    {
+      MPI_Iprobe (MPI_ANY_SOURCE, 0, MPI_COMM_WORLD, &flag, &status);
+    }
+  if (!flag)
+    {
+      return 0;
+    }
+  int count;
+  MPI_Get_count (&status, MPI_BYTE, &count);
+  if (m_received.size () < static_cast<uint32_t> (count))
+    {
+      m_received.resize (count);
+    }
+  MPI_Recv (&m_received[0], count, MPI_BYTE, status.MPI_SOURCE, 0,
+            MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+  *source = status.MPI_SOURCE;
+  m_receivedSize = count;
+#endif
+  return m_receivedSize;
+}
+
+const uint8_t *
+MpiMessageBatcher::GetRecord (uint32_t *offset, uint32_t *size) const
+{
+  if (*offset >= m_receivedSize)
+    {
+      return 0;
+    }
+  NS_ASSERT (*offset + RECORD_HEADER_SIZE <= m_receivedSize);
+  std::memcpy (size, &m_received[*offset], sizeof (*size));
+  const uint8_t *record = &m_received[*offset + RECORD_HEADER_SIZE];
+  *offset += RECORD_HEADER_SIZE + Pad (*size);
+  NS_ASSERT (*offset <= m_receivedSize);
+  return record;
+}
+
+uint64_t
+MpiMessageBatcher::GetNMessages (void) const
+{
+  return m_nMessages;
+}
+
+} // namespace ns3
@@ -0,0 +1,145 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_MPI_MESSAGE_BATCHER_H
+#define NS3_MPI_MESSAGE_BATCHER_H
+
+#include <stdint.h>
+#include <list>
+#include <vector>
+
+#ifdef NS3_MPI
+#include "mpi.h"
+#else
+typedef void* MPI_Request;
+#endif
+
+namespace ns3 {
+
+/**
+ * \ingroup mpi
+ *
+ * \brief Aggregate the messages sent to each remote rank.
+ *
+ * The records appended for a rank are accumulated in a batch, which is
+ * sent as a single MPI message by Flush, or when it reaches the flush
+ * size unless the sends are deferred.  The buffers of the batches are kept in a pool once their send
+ * has completed, so that the same memory is used again by the next
+ * batches.  The messages are received with a probe, in a buffer which
+ * grows to the size of the largest batch.
+ *
+ * Each record is preceded by its size, and padded so that all the
+ * records start on an 8-byte boundary.
+ */
+class MpiMessageBatcher
+{
+public:
+  MpiMessageBatcher ();
+  ~MpiMessageBatcher ();
+
+  /**
+   * Allocate the batches.
+   *
+   * \param size The number of ranks.
+   */
+  void Initialize (uint32_t size);
+  /**
+   * Cancel the sends which have not completed and release the buffers.
+   */
+  void Destroy (void);
+  /**
+   * Defer the sends of the batches which reach the flush size, so that
+   * the batches are only sent by Flush and FlushAll.
+   *
+   * \param deferred Whether the sends are deferred.
+   */
+  void SetDeferred (bool deferred);
+  /**
+   * Reserve a record in the batch to a rank.  The batch is sent first if
+   * the record would make it larger than the flush size, and the sends
+   * are not deferred.
+   *
+   * \param rank The destination rank.
+   * \param size The size of the record.
+   * \return The record, to fill before the next call.
+   */
+  uint8_t * Append (uint32_t rank, uint32_t size);
+  /**
+   * Send the batch to a rank, if it is not empty.
+   *
+   * \param rank The destination rank.
+   */
+  void Flush (uint32_t rank);
+  /**
+   * Send the batches to all the ranks.
+   */
+  void FlushAll (void);
+  /**
+   * Release the buffers of the completed sends to the pool.
+   */
+  void TestSendComplete (void);
+  /**
+   * Receive the next message.
+   *
+   * \param blocking Wait for a message if none has arrived.
+   * \param [out] source The rank which sent the message.
+   * \return The size of the message, or 0 if no message has arrived.
+   */
+  uint32_t Receive (bool blocking, uint32_t *source);
+  /**
+   * Get a record of the message received last.
+   *
+   * \param [in,out] offset The offset of the record in the message,
+   *                 advanced to the next record.
+   * \param [out] size The size of the record.
+   * \return The record, or 0 after the last record.
+   */
+  const uint8_t * GetRecord (uint32_t *offset, uint32_t *size) const;
+  /**
+   * \return The number of MPI messages sent.
+   */
+  uint64_t GetNMessages (void) const;
+
+private:
+  /** A batch being sent. */
+  struct PendingSend
+  {
+    std::vector<uint8_t> buffer; //!< The content of the batch.
+    MPI_Request request;         //!< The request of the send.
+  };
+
+  /**
+   * Get an empty buffer from the pool.
+   *
+   * \param [out] buffer The buffer, swapped with the one of the pool.
+   */
+  void GetBuffer (std::vector<uint8_t> &buffer);
+
+  /** The size of a batch above which it is sent. */
+  static const uint32_t FLUSH_SIZE = 65536;
+
+  std::vector<std::vector<uint8_t> > m_batches; //!< The batch of each rank.
+  std::list<PendingSend> m_pending;             //!< The sends in progress.
+  std::vector<std::vector<uint8_t> > m_pool;    //!< The free buffers.
+  std::vector<uint8_t> m_received;              //!< The message received last.
+  uint32_t m_receivedSize;                      //!< The size of the message received last.
+  uint64_t m_nMessages;                         //!< The number of messages sent.
+  bool m_deferred;                              //!< Whether the sends are deferred.
+};
+
+} // namespace ns3
+
+#endif /* NS3_MPI_MESSAGE_BATCHER_H */
@@ -37,60 +37,20 @@
 #include <mpi.h>
 #endif
 
+#include <cstring>
 #include <iostream>
 #include <iomanip>
-#include <list>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("NullMessageMpiInterface");
 
-/**
- * maximum MPI message size for easy
- * buffer creation
- */
-#ifdef NS3_MPI
-const uint32_t NULL_MESSAGE_MAX_MPI_MSG_SIZE = 2000;
-#endif
-
-NullMessageSentBuffer::NullMessageSentBuffer ()
-{
-  m_buffer = 0;
-  m_request = 0;
-}
-
-NullMessageSentBuffer::~NullMessageSentBuffer ()
-{
-  delete [] m_buffer;
-}
-
-uint8_t*
-NullMessageSentBuffer::GetBuffer ()
-{
-  return m_buffer;
-}
-
-void
-NullMessageSentBuffer::SetBuffer (uint8_t* buffer)
-{
-  m_buffer = buffer;
-}
-
-MPI_Request*
-NullMessageSentBuffer::GetRequest ()
-{
-  return &m_request;
-}
-
 uint32_t              NullMessageMpiInterface::g_sid = 0;
 uint32_t              NullMessageMpiInterface::g_size = 1;
 uint32_t              NullMessageMpiInterface::g_numNeighbors = 0;
 bool                  NullMessageMpiInterface::g_initialized = false;
 bool                  NullMessageMpiInterface::g_enabled = false;
-std::list<NullMessageSentBuffer> NullMessageMpiInterface::g_pendingTx;
-
-MPI_Request* NullMessageMpiInterface::g_requests;
-char**       NullMessageMpiInterface::g_pRxBuffers;
+MpiMessageBatcher     NullMessageMpiInterface::g_batcher;
 
 NullMessageMpiInterface::NullMessageMpiInterface ()
 {
@@ -175,21 +135,8 @@ NullMessageMpiInterface::InitializeSendReceiveBuffers(void)
 
   g_numNeighbors = RemoteChannelBundleManager::Size();
 
-  // Post a non-blocking receive for all peers
-  g_requests = new MPI_Request[g_numNeighbors];
-  g_pRxBuffers = new char*[g_numNeighbors];
-  int index = 0;
-  for (uint32_t rank = 0; rank < g_size; ++rank)
-    {
-      Ptr<RemoteChannelBundle> bundle = RemoteChannelBundleManager::Find(rank);
-      if (bundle) 
-        {
-          g_pRxBuffers[index] = new char[NULL_MESSAGE_MAX_MPI_MSG_SIZE];
-          MPI_Irecv (g_pRxBuffers[index], NULL_MESSAGE_MAX_MPI_MSG_SIZE, MPI_CHAR, rank, 0,
-                     MPI_COMM_WORLD, &g_requests[index]);
-          ++index;
-        }
-    }
+  // One batch of records for each task
+  g_batcher.Initialize (g_size);
 #endif
 }
 
@@ -206,30 +153,18 @@ NullMessageMpiInterface::SendPacket (Ptr<Packet> p, const Time& rxTime, uint32_t
   Ptr<Node> destNode = NodeList::GetNode (node);
   uint32_t nodeSysId = destNode->GetSystemId ();
 
-  NullMessageSentBuffer sendBuf;
-  g_pendingTx.push_back (sendBuf);
-  std::list<NullMessageSentBuffer>::reverse_iterator iter = g_pendingTx.rbegin (); // Points to the last element
-
   uint32_t serializedSize = p->GetSerializedSize ();
-  uint32_t bufferSize = serializedSize + ( 2 * sizeof (uint64_t) ) + ( 2 * sizeof (uint32_t) );
-  uint8_t* buffer =  new uint8_t[bufferSize];
-  iter->SetBuffer (buffer);
-  // Add the time, dest node and dest device
+  uint8_t* buffer = g_batcher.Append (nodeSysId, serializedSize + 2 * sizeof (uint64_t) + 2 * sizeof (uint32_t));
+  // Add the time, guarantee time, dest node and dest device
   uint64_t t = rxTime.GetInteger ();
-  uint64_t* pTime = reinterpret_cast <uint64_t *> (buffer);
-  *pTime++ = t;
-
+  std::memcpy (buffer, &t, sizeof (t));
   Time guarantee_update = NullMessageSimulatorImpl::GetInstance ()->CalculateGuaranteeTime (nodeSysId);
-  *pTime++ = guarantee_update.GetTimeStep ();
-
-  uint32_t* pData = reinterpret_cast<uint32_t *> (pTime);
-  *pData++ = node;
-  *pData++ = dev;
+  uint64_t guarantee = guarantee_update.GetTimeStep ();
+  std::memcpy (buffer + 8, &guarantee, sizeof (guarantee));
+  std::memcpy (buffer + 16, &node, sizeof (node));
+  std::memcpy (buffer + 20, &dev, sizeof (dev));
   // Serialize the packet
-  p->Serialize (reinterpret_cast<uint8_t *> (pData), serializedSize);
-
-  MPI_Isend (reinterpret_cast<void *> (iter->GetBuffer ()), bufferSize, MPI_CHAR, nodeSysId,
-             0, MPI_COMM_WORLD, (iter->GetRequest ()));
+  p->Serialize (buffer + 24, serializedSize);
 
   NullMessageSimulatorImpl::GetInstance ()->RescheduleNullMessageEvent (nodeSysId);
 
@@ -245,29 +180,25 @@ NullMessageMpiInterface::SendNullMessage (const Time& guarantee_update, Ptr<Remo
 
 #ifdef NS3_MPI
 
-  NullMessageSentBuffer sendBuf;
-  g_pendingTx.push_back (sendBuf);
-  std::list<NullMessageSentBuffer>::reverse_iterator iter = g_pendingTx.rbegin (); // Points to the last element
-
-  uint32_t bufferSize = 2 * sizeof (uint64_t) + 2 * sizeof (uint32_t);
-  uint8_t* buffer =  new uint8_t[bufferSize];
-  iter->SetBuffer (buffer);
-  // Add the time, dest node and dest device
-  uint64_t* pTime = reinterpret_cast <uint64_t *> (buffer);
-  *pTime++ = 0;
-  *pTime++ = guarantee_update.GetInteger ();
-  uint32_t* pData = reinterpret_cast<uint32_t *> (pTime);
-  *pData++ = 0;
-  *pData++ = 0;
-
   // Find the system id for the destination MPI rank
   uint32_t nodeSysId = bundle->GetSystemId ();
 
-  MPI_Isend (reinterpret_cast<void *> (iter->GetBuffer ()), bufferSize, MPI_CHAR, nodeSysId,
-             0, MPI_COMM_WORLD, (iter->GetRequest ()));
+  uint8_t* buffer = g_batcher.Append (nodeSysId, 2 * sizeof (uint64_t) + 2 * sizeof (uint32_t));
+  // Zero time, dest node and dest device for a Null Message
+  std::memset (buffer, 0, 2 * sizeof (uint64_t) + 2 * sizeof (uint32_t));
+  uint64_t guarantee = guarantee_update.GetInteger ();
+  std::memcpy (buffer + 8, &guarantee, sizeof (guarantee));
 #endif
 }
 
+void
+NullMessageMpiInterface::FlushSendBuffers ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  g_batcher.FlushAll ();
+}
+
 void
 NullMessageMpiInterface::ReceiveMessagesBlocking ()
 {
@@ -295,46 +226,33 @@ NullMessageMpiInterface::ReceiveMessages (bool blocking)
 
 #ifdef NS3_MPI
 
-  // stop flag set to true when no more messages are found to
-  // process.
-  bool stop = false;
-
-
   if (!g_numNeighbors) {
     // Not communicating with anyone.
     return;
   }
 
-  do
+  uint32_t source;
+  // When blocking, wait for the first message only
+  uint32_t size = g_batcher.Receive (blocking, &source);
+  while (size != 0)
     {
-      int messageReceived = 0;
-      int index = 0;
-      MPI_Status status;
+      Ptr<RemoteChannelBundle> bundle = RemoteChannelBundleManager::Find (source);
+      NS_ASSERT (bundle);
 
-      if (blocking)
+      uint32_t offset = 0;
+      uint32_t count;
+      const uint8_t* record;
+      while ((record = g_batcher.GetRecord (&offset, &count)) != 0)
         {
-          MPI_Waitany (g_numNeighbors, g_requests, &index, &status);
-          messageReceived = 1; /* Wait always implies message was received */
-          stop = true;
-        }
-      else
-        {
-          MPI_Testany (g_numNeighbors, g_requests, &index, &messageReceived, &status);
-        }
-
-      if (messageReceived)
-        {
-          int count;
-          MPI_Get_count (&status, MPI_CHAR, &count);
-
           // Get the meta data first
-          uint64_t* pTime = reinterpret_cast<uint64_t *> (g_pRxBuffers[index]);
-          uint64_t time = *pTime++;
-          uint64_t guaranteeUpdate = *pTime++;
-
-          uint32_t* pData = reinterpret_cast<uint32_t *> (pTime);
-          uint32_t node = *pData++;
-          uint32_t dev  = *pData++;
+          uint64_t time;
+          uint64_t guaranteeUpdate;
+          uint32_t node;
+          uint32_t dev;
+          std::memcpy (&time, record, sizeof (time));
+          std::memcpy (&guaranteeUpdate, record + 8, sizeof (guaranteeUpdate));
+          std::memcpy (&node, record + 16, sizeof (node));
+          std::memcpy (&dev, record + 20, sizeof (dev));
 
           Time rxTime (time);
 
@@ -343,7 +261,7 @@ NullMessageMpiInterface::ReceiveMessages (bool blocking)
             {
               count -= sizeof (time) + sizeof (guaranteeUpdate) + sizeof (node) + sizeof (dev);
 
-              Ptr<Packet> p = Create<Packet> (reinterpret_cast<uint8_t *> (pData), count, true);
+              Ptr<Packet> p = Create<Packet> (record + 24, count, true);
 
               // Find the correct node/device to schedule receive event
               Ptr<Node> pNode = NodeList::GetNode (node);
@@ -367,23 +285,12 @@ NullMessageMpiInterface::ReceiveMessages (bool blocking)
             }
 
           // Update guarantee time for both packet receives and Null Messages.
-          Ptr<RemoteChannelBundle> bundle = RemoteChannelBundleManager::Find (status.MPI_SOURCE);
-          NS_ASSERT (bundle);
-
           bundle->SetGuaranteeTime (Time (guaranteeUpdate));
-
-          // Re-queue the next read
-          MPI_Irecv (g_pRxBuffers[index], NULL_MESSAGE_MAX_MPI_MSG_SIZE, MPI_CHAR, status.MPI_SOURCE, 0,
-                     MPI_COMM_WORLD, &g_requests[index]);
-
-        }
-      else
-        {
-          // if non-blocking and no message received in testany then stop message loop
-          stop = true;
         }
+
+      // Then process the messages already arrived without blocking
+      size = g_batcher.Receive (false, &source);
     }
-  while (!stop);
 #endif
 }
 
@@ -394,21 +301,7 @@ NullMessageMpiInterface::TestSendComplete ()
 
   NS_ASSERT (g_enabled);
 
-#ifdef NS3_MPI
-  std::list<NullMessageSentBuffer>::iterator iter = g_pendingTx.begin ();
-  while (iter != g_pendingTx.end ())
-    {
-      MPI_Status status;
-      int flag = 0;
-      MPI_Test (iter->GetRequest (), &flag, &status);
-      std::list<NullMessageSentBuffer>::iterator current = iter; // Save current for erasing
-      ++iter; // Advance to next
-      if (flag)
-        { // This message is complete
-          g_pendingTx.erase (current);
-        }
-    }
-#endif
+  g_batcher.TestSendComplete ();
 }
 
 void
@@ -421,32 +314,10 @@ NullMessageMpiInterface::Disable ()
   MPI_Initialized (&flag);
   if (flag)
     {
-
-      for (std::list<NullMessageSentBuffer>::iterator iter = g_pendingTx.begin ();
-           iter != g_pendingTx.end ();
-           ++iter)
-        {
-          MPI_Cancel (iter->GetRequest ());
-          MPI_Request_free (iter->GetRequest ());
-        }
-
-      for (uint32_t i = 0; i < g_numNeighbors; ++i)
-        {
-          MPI_Cancel (&g_requests[i]);
-          MPI_Request_free (&g_requests[i]);
-        }
+      g_batcher.Destroy ();
 
       MPI_Finalize ();
 
-      for (uint32_t i = 0; i < g_numNeighbors; ++i)
-        {
-          delete [] g_pRxBuffers[i];
-        }
-      delete [] g_pRxBuffers;
-      delete [] g_requests;
-
-      g_pendingTx.clear ();
-
       g_enabled = false;
       g_initialized = false;
 
@@ -27,63 +27,22 @@
 #include <ns3/nstime.h>
 #include <ns3/buffer.h>
 
-#ifdef NS3_MPI
-#include "mpi.h"
-#else
-typedef void* MPI_Request;
-#endif
-
-#include <list>
+#include "mpi-message-batcher.h"
 
 namespace ns3 {
 
 class RemoteChannelBundle;
 class Packet;
 
-/**
- * \ingroup mpi
- *
- * \brief Non-blocking send buffers for Null Message implementation.
- * 
- * One buffer is allocated for each non-blocking send.
- */
-class NullMessageSentBuffer
-{
-public:
-  NullMessageSentBuffer ();
-  ~NullMessageSentBuffer ();
-
-  /**
-   * \return pointer to sent buffer
-   */
-  uint8_t* GetBuffer ();
-  /**
-   * \param buffer pointer to sent buffer
-   */
-  void SetBuffer (uint8_t* buffer);
-  /**
-   * \return MPI request
-   */
-  MPI_Request* GetRequest ();
-
-private:
-
-  /**
-   * Buffer for send.
-   */
-  uint8_t* m_buffer;
-
-  /**
-   * MPI request posted for the send.
-   */
-  MPI_Request m_request;
-};
-
 /**
  * \ingroup mpi
  *
  * \brief Interface between ns-3 and MPI for the Null Message
  * distributed simulation implementation.
+ *
+ * The packets and Null Messages sent to a task are aggregated in a
+ * single MPI message, which is sent when the simulator has processed
+ * all the events of the current time.
  */
 class NullMessageMpiInterface : public ParallelCommunicationInterface
 {
@@ -128,10 +87,12 @@ public:
    * \param node destination node
    * \param dev destination device
    *
-   * Serialize and send a packet to the specified node and net device.
+   * Serialize a packet to the specified node and net device into the
+   * message to its task.
    *
    * \internal
-   * The MPI buffer format packs a delivery information and the serialized packet.
+   * The record of the packet in the message packs a delivery information
+   * and the serialized packet.
    *
    * uint64_t time the packed should be delivered
    * uint64_t guarantee time for the Null Message algorithm.
@@ -155,7 +116,7 @@ public:
    * MPI task.
    *
    * \internal
-   * The Null Message MPI buffer format is based on the format for sending a packet with
+   * The Null Message record format is based on the format for sending a packet with
    * several fields set to 0 to signal that it is a Null Message.  Overloading the normal packet
    * format simplifies receive logic.
    *
@@ -165,6 +126,11 @@ public:
    * uint32_t 0 must be zero for Null Message
    */
   static void SendNullMessage (const Time& guaranteeUpdate, Ptr<RemoteChannelBundle> bundle);
+  /**
+   * Send the messages aggregating the packets and Null Messages to
+   * each task.
+   */
+  static void FlushSendBuffers ();
   /**
    * Non-blocking check for received messages complete.  Will
    * receive all messages that are queued up locally.
@@ -211,14 +177,8 @@ private:
   static bool     g_initialized;
   static bool     g_enabled;
 
-  // Pending non-blocking receives
-  static MPI_Request* g_requests;
-
-  // Data buffers for non-blocking receives
-  static char**   g_pRxBuffers;
-
-  // List of pending non-blocking sends
-  static std::list<NullMessageSentBuffer> g_pendingTx;
+  // Messages to and from the other tasks
+  static MpiMessageBatcher g_batcher;
 };
 
 } // namespace ns3
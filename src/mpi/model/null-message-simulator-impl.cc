@@ -232,6 +232,7 @@ NullMessageSimulatorImpl::ProcessOneEvent (void)
   NS_LOG_FUNCTION (this);
 
   Scheduler::Event next = m_events->RemoveNext ();
+  m_events->NotifyRemoveNext (next);
 
   NS_ASSERT (next.key.m_ts >= m_currentTs);
   m_unscheduledEvents--;
@@ -314,11 +315,17 @@ NullMessageSimulatorImpl::Run (void)
       if ( nextTime <= GetSafeTime () )
         {
           ProcessOneEvent ();
+          if (IsFinished () || Next () > Now ())
+            {
+              // The messages of the current time are complete
+              NullMessageMpiInterface::FlushSendBuffers ();
+            }
           HandleArrivingMessagesNonBlocking ();
         }
       else
         {
           // Block until packet or Null Message has been received.
+          NullMessageMpiInterface::FlushSendBuffers ();
           HandleArrivingMessagesBlocking ();
         }
     }
@@ -524,6 +531,12 @@ NullMessageSimulatorImpl::Cancel (const EventId &id)
   if (!IsExpired (id))
     {
       id.PeekEventImpl ()->Cancel ();
+      if (id.GetUid () != 2)
+        {
+          // the event stays in the event list, unless the scheduler
+          // compacts it now
+          m_unscheduledEvents -= m_events->NotifyCancel ();
+        }
     }
 }
 
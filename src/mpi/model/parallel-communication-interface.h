@@ -69,6 +69,14 @@ public:
    * \return true if parallel communication is enabled
    */
   virtual bool IsEnabled () = 0;
+  /**
+   * \param systemId system identification
+   * \return true if the nodes of the system are simulated by this process
+   */
+  virtual bool IsLocal (uint32_t systemId)
+  {
+    return systemId == GetSystemId ();
+  }
   /**
    * \param pargc number of command line arguments
    * \param pargv command line arguments
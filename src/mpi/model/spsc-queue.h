@@ -0,0 +1,153 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_SPSC_QUEUE_H
+#define NS3_SPSC_QUEUE_H
+
+#include <stdint.h>
+#include <atomic>
+
+namespace ns3 {
+
+/**
+ * \ingroup mpi
+ *
+ * \brief Unbounded lock-free queue between a single producer thread
+ * and a single consumer thread.
+ *
+ * The items are stored in a linked list of blocks.  The producer only
+ * writes the tail block, and publishes each item by advancing the end
+ * index of the block, or the block itself by linking it to the tail;
+ * the consumer only reads the head block, and deletes it once it has
+ * read all its items and the producer has moved to the next block.
+ *
+ * \tparam T The type of the items, which must be default constructible
+ *         and copyable.
+ */
+template <typename T>
+class SpscQueue
+{
+public:
+  SpscQueue ();
+  ~SpscQueue ();
+
+  /**
+   * Append an item.  Only called by the producer thread.
+   *
+   * \param item The item.
+   */
+  void Push (const T &item);
+  /**
+   * Remove the oldest item.  Only called by the consumer thread.
+   *
+   * \param [out] item The item.
+   * \return true if an item was removed, false if the queue was empty.
+   */
+  bool Pop (T &item);
+
+private:
+  /** The number of items of a block. */
+  static const uint32_t BLOCK_SIZE = 256;
+
+  /** A block of items. */
+  struct Block
+  {
+    Block ()
+      : end (0),
+        next (0)
+    {
+    }
+    T items[BLOCK_SIZE];         //!< The items.
+    std::atomic<uint32_t> end;   //!< The number of items written.
+    std::atomic<Block *> next;   //!< The next block.
+  };
+
+  SpscQueue (const SpscQueue &);
+  SpscQueue & operator = (const SpscQueue &);
+
+  Block *m_head;     //!< The block read by the consumer.
+  uint32_t m_begin;  //!< The index of the next item read by the consumer.
+  /** Keep the consumer and producer sides on different cache lines. */
+  char m_padding[64];
+  Block *m_tail;     //!< The block written by the producer.
+};
+
+template <typename T>
+SpscQueue<T>::SpscQueue ()
+  : m_head (new Block ()),
+    m_begin (0)
+{
+  m_tail = m_head;
+}
+
+template <typename T>
+SpscQueue<T>::~SpscQueue ()
+{
+  while (m_head != 0)
+    {
+      Block *next = m_head->next.load (std::memory_order_relaxed);
+      delete m_head;
+      m_head = next;
+    }
+}
+
+template <typename T>
+void
+SpscQueue<T>::Push (const T &item)
+{
+  uint32_t end = m_tail->end.load (std::memory_order_relaxed);
+  if (end == BLOCK_SIZE)
+    {
+      Block *block = new Block ();
+      m_tail->next.store (block, std::memory_order_release);
+      m_tail = block;
+      end = 0;
+    }
+  m_tail->items[end] = item;
+  m_tail->end.store (end + 1, std::memory_order_release);
+}
+
+template <typename T>
+bool
+SpscQueue<T>::Pop (T &item)
+{
+  while (true)
+    {
+      if (m_begin < m_head->end.load (std::memory_order_acquire))
+        {
+          item = m_head->items[m_begin++];
+          return true;
+        }
+      if (m_begin < BLOCK_SIZE)
+        {
+          return false;
+        }
+      // the producer has filled this block; it only links the next one
+      // once it has stopped writing this one
+      Block *next = m_head->next.load (std::memory_order_acquire);
+      if (next == 0)
+        {
+          return false;
+        }
+      delete m_head;
+      m_head = next;
+      m_begin = 0;
+    }
+}
+
+} // namespace ns3
+
+#endif /* NS3_SPSC_QUEUE_H */
@@ -0,0 +1,136 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "threaded-communication-interface.h"
+#include "threaded-simulator-impl.h"
+#include "mpi-receiver.h"
+
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/make-event.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ThreadedCommunicationInterface");
+
+ThreadedCommunicationInterface::ThreadedCommunicationInterface ()
+  : m_impl (0),
+    m_enabled (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+ThreadedCommunicationInterface::~ThreadedCommunicationInterface ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+ThreadedCommunicationInterface::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint32_t
+ThreadedCommunicationInterface::GetSystemId ()
+{
+  return m_impl->GetSystemId ();
+}
+
+uint32_t
+ThreadedCommunicationInterface::GetSize ()
+{
+  return m_impl->GetNPartitions ();
+}
+
+bool
+ThreadedCommunicationInterface::IsEnabled ()
+{
+  return m_enabled;
+}
+
+bool
+ThreadedCommunicationInterface::IsLocal (uint32_t systemId)
+{
+  return systemId < GetSize ();
+}
+
+void
+ThreadedCommunicationInterface::Enable (int* pargc, char*** pargv)
+{
+  NS_LOG_FUNCTION (this << pargc << pargv);
+  m_impl = dynamic_cast<ThreadedSimulatorImpl *> (PeekPointer (Simulator::GetImplementation ()));
+  NS_ABORT_MSG_IF (m_impl == 0, "ThreadedCommunicationInterface requires ns3::ThreadedSimulatorImpl");
+  m_enabled = true;
+}
+
+void
+ThreadedCommunicationInterface::Disable ()
+{
+  NS_LOG_FUNCTION (this);
+  m_enabled = false;
+}
+
+void
+ThreadedCommunicationInterface::SendPacket (Ptr<Packet> p, const Time& rxTime, uint32_t node, uint32_t dev)
+{
+  NS_LOG_FUNCTION (this << p << rxTime.GetTimeStep () << node << dev);
+
+  EventImpl *event;
+  if (m_impl->GetNodePartition (node) == m_impl->GetSystemId ())
+    {
+      event = MakeEvent (&ThreadedCommunicationInterface::ReceivePacket, this, node, dev, p);
+    }
+  else
+    {
+      // the packet is deep copied: its copies would share reference
+      // counts with the packets of this thread.  The copy is only
+      // referenced by the event once this block ends, and the event is
+      // only touched by the receiving thread once it has been scheduled
+      Ptr<Packet> copy = p->DeepCopy ();
+      event = MakeEvent (&ThreadedCommunicationInterface::ReceivePacket, this, node, dev, copy);
+    }
+  Simulator::ScheduleWithContext (node, rxTime - Simulator::Now (), event);
+}
+
+void
+ThreadedCommunicationInterface::ReceivePacket (uint32_t node, uint32_t dev, Ptr<Packet> p)
+{
+  NS_LOG_FUNCTION (this << node << dev << p);
+
+  // NodeList::GetNode would touch the reference count of the node
+  // list, which is shared by the threads
+  Node *pNode = m_impl->PeekNode (node);
+  Ptr<MpiReceiver> pMpiRec = 0;
+  uint32_t nDevices = pNode->GetNDevices ();
+  for (uint32_t i = 0; i < nDevices; ++i)
+    {
+      Ptr<NetDevice> pThisDev = pNode->GetDevice (i);
+      if (pThisDev->GetIfIndex () == dev)
+        {
+          pMpiRec = pThisDev->GetObject<MpiReceiver> ();
+          break;
+        }
+    }
+
+  NS_ASSERT (pMpiRec);
+  pMpiRec->Receive (p);
+}
+
+} // namespace ns3
@@ -0,0 +1,111 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_THREADED_COMMUNICATION_INTERFACE_H
+#define NS3_THREADED_COMMUNICATION_INTERFACE_H
+
+#include "parallel-communication-interface.h"
+
+#include <ns3/nstime.h>
+
+namespace ns3 {
+
+class Packet;
+class ThreadedSimulatorImpl;
+
+/**
+ * \ingroup mpi
+ *
+ * \brief Interface between the remote channels and the threads of a
+ * ThreadedSimulatorImpl.
+ *
+ * The logical processors are the partitions of the simulator, so that
+ * the distributed scripts run in a single process, without MPI.  A
+ * packet sent to a node of another partition is scheduled as an event
+ * of that partition, which the simulator hands over by pointer.  The
+ * packet itself is replaced by a copy made by Packet::DeepCopy, which
+ * shares no buffer, tags or metadata with it, since the copies of a
+ * packet share them through reference counts which are not atomic.
+ * The copy is handed over by pointer too, without serialization.  A
+ * packet sent to a node of the same partition is scheduled as it is.
+ */
+class ThreadedCommunicationInterface : public ParallelCommunicationInterface
+{
+public:
+  ThreadedCommunicationInterface ();
+  ~ThreadedCommunicationInterface ();
+
+  /**
+   * Nothing to release
+   */
+  virtual void Destroy ();
+  /**
+   * \return partition of the calling thread
+   */
+  virtual uint32_t GetSystemId ();
+  /**
+   * \return number of partitions
+   */
+  virtual uint32_t GetSize ();
+  /**
+   * \return true if interface is enabled
+   */
+  virtual bool IsEnabled ();
+  /**
+   * \param systemId system identification
+   * \return true, as all the partitions are threads of this process
+   */
+  virtual bool IsLocal (uint32_t systemId);
+  /**
+   * \param pargc number of command line arguments
+   * \param pargv command line arguments
+   *
+   * Bind the interface to the simulator, which must be a
+   * ThreadedSimulatorImpl; the command line arguments are not used.
+   */
+  virtual void Enable (int* pargc, char*** pargv);
+  /**
+   * Resets m_enabled
+   */
+  virtual void Disable ();
+  /**
+   * \param p packet to send
+   * \param rxTime received time at destination node
+   * \param node destination node
+   * \param dev destination device
+   *
+   * Schedule the reception of a packet on the partition of its
+   * destination node.
+   */
+  virtual void SendPacket (Ptr<Packet> p, const Time &rxTime, uint32_t node, uint32_t dev);
+
+private:
+  /**
+   * \param node destination node
+   * \param dev destination device
+   * \param p packet
+   *
+   * Pass a packet to the MpiReceiver of its destination device
+   */
+  void ReceivePacket (uint32_t node, uint32_t dev, Ptr<Packet> p);
+
+  ThreadedSimulatorImpl *m_impl;  //!< The simulator
+  bool m_enabled;                 //!< Has the interface been enabled
+};
+
+} // namespace ns3
+
+#endif /* NS3_THREADED_COMMUNICATION_INTERFACE_H */
@@ -0,0 +1,747 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "threaded-simulator-impl.h"
+#include "mpi-interface.h"
+
+#include "ns3/simulator.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/channel.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/packet.h"
+#include "ns3/uinteger.h"
+#include "ns3/system-thread.h"
+#include "ns3/assert.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+
+#include <thread>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ThreadedSimulatorImpl");
+
+NS_OBJECT_ENSURE_REGISTERED (ThreadedSimulatorImpl);
+
+namespace {
+
+/** The time of a partition which has no event left. */
+const uint64_t NO_EVENT = 0xffffffffffffffffULL;
+
+} // anonymous namespace
+
+/**
+ * The partition run by the calling thread, or 0 outside of Run.  The
+ * calling thread of Run runs the first partition.
+ */
+static thread_local void *g_partition = 0;
+
+ThreadedSimulatorImpl::Partition::Partition ()
+  : id (0),
+    // uids are allocated from 4.
+    // uid 0 is "invalid" events
+    // uid 1 is "now" events
+    // uid 2 is "destroy" events
+    uid (4),
+    // before ::Run is entered, the currentUid will be zero
+    currentUid (0),
+    currentTs (0),
+    currentContext (Simulator::NO_CONTEXT),
+    unscheduledEvents (0),
+    stop (false),
+    windowEnd (0),
+    sense (false)
+{
+}
+
+void
+ThreadedSimulatorImpl::Worker::Run (void)
+{
+  impl->RunPartition (&impl->m_partitions[partition]);
+}
+
+TypeId
+ThreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ThreadedSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .SetGroupName ("Mpi")
+    .AddConstructor<ThreadedSimulatorImpl> ()
+    .AddAttribute ("Threads",
+                   "The number of logical processors, each run by a thread.",
+                   UintegerValue (2),
+                   MakeUintegerAccessor (&ThreadedSimulatorImpl::m_nPartitions),
+                   MakeUintegerChecker<uint32_t> (1))
+  ;
+  return tid;
+}
+
+ThreadedSimulatorImpl::ThreadedSimulatorImpl ()
+  : m_nPartitions (2),
+    m_nextTs (0),
+    m_barrierCount (0),
+    m_barrierSense (false),
+    m_stopTs (NO_EVENT),
+    m_stop (false),
+    m_running (false),
+    m_lookahead (0),
+    m_nWindows (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+ThreadedSimulatorImpl::~ThreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+ThreadedSimulatorImpl::NotifyConstructionCompleted (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_partitions.resize (m_nPartitions);
+  for (uint32_t i = 0; i < m_nPartitions; ++i)
+    {
+      m_partitions[i].id = i;
+    }
+  m_queues.resize (m_nPartitions * m_nPartitions, 0);
+  for (uint32_t i = 0; i < m_queues.size (); ++i)
+    {
+      if (i / m_nPartitions != i % m_nPartitions)
+        {
+          m_queues[i] = new SpscQueue<RemoteEvent> ();
+        }
+    }
+  m_nextTs = new std::atomic<uint64_t>[m_nPartitions];
+  SimulatorImpl::NotifyConstructionCompleted ();
+}
+
+void
+ThreadedSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t i = 0; i < m_nPartitions; ++i)
+    {
+      Partition *p = &m_partitions[i];
+      ReceiveEvents (p);
+      while (!p->events->IsEmpty ())
+        {
+          Scheduler::Event next = p->events->RemoveNext ();
+          next.impl->Unref ();
+        }
+      p->events = 0;
+    }
+  for (uint32_t i = 0; i < m_queues.size (); ++i)
+    {
+      delete m_queues[i];
+    }
+  m_queues.clear ();
+  delete [] m_nextTs;
+  m_nextTs = 0;
+  m_nodes.clear ();
+  SimulatorImpl::DoDispose ();
+}
+
+void
+ThreadedSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_destroyEvents.empty ())
+    {
+      Ptr<EventImpl> ev = m_destroyEvents.front ().PeekEventImpl ();
+      m_destroyEvents.pop_front ();
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+        }
+    }
+  if (MpiInterface::IsEnabled ())
+    {
+      MpiInterface::Destroy ();
+    }
+}
+
+void
+ThreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+  for (uint32_t i = 0; i < m_nPartitions; ++i)
+    {
+      Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+      Partition *p = &m_partitions[i];
+      if (p->events != 0)
+        {
+          while (!p->events->IsEmpty ())
+            {
+              Scheduler::Event next = p->events->RemoveNext ();
+              scheduler->Insert (next);
+            }
+        }
+      p->events = scheduler;
+    }
+}
+
+ThreadedSimulatorImpl::Partition *
+ThreadedSimulatorImpl::GetPartition (void) const
+{
+  if (g_partition != 0)
+    {
+      return static_cast<Partition *> (g_partition);
+    }
+  return const_cast<Partition *> (&m_partitions[0]);
+}
+
+uint32_t
+ThreadedSimulatorImpl::GetNPartitions (void) const
+{
+  return m_nPartitions;
+}
+
+uint32_t
+ThreadedSimulatorImpl::GetNodePartition (uint32_t node) const
+{
+  if (m_running)
+    {
+      return node < m_nodePartitions.size () ? m_nodePartitions[node] : GetSystemId ();
+    }
+  if (node < NodeList::GetNNodes ())
+    {
+      uint32_t systemId = NodeList::GetNode (node)->GetSystemId ();
+      NS_ABORT_MSG_UNLESS (systemId < m_nPartitions,
+                           "Node " << node << " has system id " << systemId <<
+                           " but there are only " << m_nPartitions << " threads");
+      return systemId;
+    }
+  return GetSystemId ();
+}
+
+Node *
+ThreadedSimulatorImpl::PeekNode (uint32_t node) const
+{
+  NS_ASSERT (m_running && node < m_nodes.size ());
+  return m_nodes[node];
+}
+
+Time
+ThreadedSimulatorImpl::GetLookahead (void) const
+{
+  return TimeStep (m_lookahead);
+}
+
+uint64_t
+ThreadedSimulatorImpl::GetNWindows (void) const
+{
+  return m_nWindows;
+}
+
+uint32_t
+ThreadedSimulatorImpl::Insert (Partition *p, uint64_t ts, uint32_t context, EventImpl *event)
+{
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = ts;
+  ev.key.m_context = context;
+  ev.key.m_uid = p->uid;
+  p->uid++;
+  p->unscheduledEvents++;
+  p->events->Insert (ev);
+  return ev.key.m_uid;
+}
+
+void
+ThreadedSimulatorImpl::PrepareRun (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t nNodes = NodeList::GetNNodes ();
+  m_nodePartitions.resize (nNodes);
+  m_nodes.resize (nNodes);
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      m_nodePartitions[i] = GetNodePartition (i);
+      m_nodes[i] = PeekPointer (NodeList::GetNode (i));
+    }
+
+  // the lookahead is the smallest delay of the point-to-point links
+  // between partitions, as in DistributedSimulatorImpl
+  m_lookahead = NO_EVENT;
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      Ptr<Node> node = NodeList::GetNode (i);
+      for (uint32_t j = 0; j < node->GetNDevices (); ++j)
+        {
+          Ptr<NetDevice> localNetDevice = node->GetDevice (j);
+          // only works for p2p links currently
+          if (!localNetDevice->IsPointToPoint ())
+            {
+              continue;
+            }
+          Ptr<Channel> channel = localNetDevice->GetChannel ();
+          if (channel == 0 || channel->GetNDevices () != 2)
+            {
+              continue;
+            }
+          // grab the adjacent node
+          Ptr<Node> remoteNode;
+          if (channel->GetDevice (0) == localNetDevice)
+            {
+              remoteNode = (channel->GetDevice (1))->GetNode ();
+            }
+          else
+            {
+              remoteNode = (channel->GetDevice (0))->GetNode ();
+            }
+          if (m_nodePartitions[remoteNode->GetId ()] == m_nodePartitions[i])
+            {
+              continue;
+            }
+          // the remote channels look up their peers when they are
+          // initialized, which must not be left to the threads
+          channel->Initialize ();
+          TimeValue delay;
+          channel->GetAttribute ("Delay", delay);
+          NS_ABORT_MSG_UNLESS (delay.Get ().IsStrictlyPositive (),
+                               "The links between threads must have a positive delay");
+          m_lookahead = std::min (m_lookahead, static_cast<uint64_t> (delay.Get ().GetTimeStep ()));
+        }
+    }
+  NS_LOG_LOGIC ("lookahead " << m_lookahead);
+}
+
+void
+ThreadedSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (!m_running, "Simulator::Run is not reentrant");
+  PrepareRun ();
+  m_stop = false;
+  m_stopTs = NO_EVENT;
+  m_nWindows = 0;
+  m_barrierCount = m_nPartitions;
+  m_barrierSense = false;
+  for (uint32_t i = 0; i < m_nPartitions; ++i)
+    {
+      m_partitions[i].stop = false;
+      m_partitions[i].windowEnd = m_partitions[i].currentTs;
+      m_partitions[i].sense = false;
+    }
+  m_running = true;
+  // the packets are created and destroyed by the threads from now on
+  Packet::EnableThreads (m_nPartitions);
+
+  std::vector<Worker> workers (m_nPartitions);
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 1; i < m_nPartitions; ++i)
+    {
+      workers[i].impl = this;
+      workers[i].partition = i;
+      threads.push_back (Create<SystemThread> (MakeCallback (&Worker::Run, &workers[i])));
+      threads.back ()->Start ();
+    }
+  RunPartition (&m_partitions[0]);
+  for (uint32_t i = 0; i < threads.size (); ++i)
+    {
+      threads[i]->Join ();
+    }
+  Packet::DisableThreads ();
+
+  m_running = false;
+  m_nodes.clear ();
+}
+
+void
+ThreadedSimulatorImpl::RunPartition (Partition *p)
+{
+  NS_LOG_FUNCTION (this << p->id);
+  g_partition = p;
+  while (true)
+    {
+      ReceiveEvents (p);
+      uint64_t next = NO_EVENT;
+      if (!p->events->IsEmpty () && !p->stop)
+        {
+          next = p->events->PeekNext ().key.m_ts;
+        }
+      m_nextTs[p->id].store (next, std::memory_order_relaxed);
+      Barrier (p);
+
+      uint64_t lbts = NO_EVENT;
+      for (uint32_t i = 0; i < m_nPartitions; ++i)
+        {
+          lbts = std::min (lbts, m_nextTs[i].load (std::memory_order_relaxed));
+        }
+      if (lbts == NO_EVENT)
+        {
+          break;
+        }
+      // a stop requested in a previous window is seen by all the
+      // partitions, and one requested in this window, which some
+      // partitions may see, is not before the end of this window
+      uint64_t stopTs = m_stopTs.load (std::memory_order_relaxed);
+      if (lbts >= stopTs)
+        {
+          if (p->id == 0)
+            {
+              m_stop = true;
+            }
+          break;
+        }
+      if (p->id == 0)
+        {
+          m_nWindows++;
+        }
+      uint64_t end = lbts + std::min (m_lookahead, NO_EVENT - lbts);
+      end = std::min (end, stopTs);
+      p->windowEnd = end;
+      NS_LOG_LOGIC ("partition " << p->id << " window [" << lbts << ", " << end << ")");
+      // the stops requested by the other partitions during this window
+      // are not before its end, so only the ones of this partition
+      // matter here
+      while (!p->events->IsEmpty () && !p->stop &&
+             p->events->PeekNext ().key.m_ts < std::min (end, m_stopTs.load (std::memory_order_relaxed)))
+        {
+          ProcessOneEvent (p);
+        }
+      // the events sent during this window are received once all the
+      // partitions have finished it
+      Barrier (p);
+    }
+  g_partition = 0;
+
+  // If the partition stopped naturally by lack of events, make a
+  // consistency test to check that we didn't lose any events along the way.
+  NS_ASSERT (!p->events->IsEmpty () || p->unscheduledEvents == 0);
+}
+
+void
+ThreadedSimulatorImpl::ReceiveEvents (Partition *p)
+{
+  for (uint32_t i = 0; i < m_nPartitions; ++i)
+    {
+      SpscQueue<RemoteEvent> *queue = m_queues[i * m_nPartitions + p->id];
+      if (queue == 0)
+        {
+          continue;
+        }
+      RemoteEvent remote;
+      while (queue->Pop (remote))
+        {
+          Insert (p, remote.ts, remote.context, remote.impl);
+        }
+    }
+}
+
+void
+ThreadedSimulatorImpl::ProcessOneEvent (Partition *p)
+{
+  Scheduler::Event next = p->events->RemoveNext ();
+  p->events->NotifyRemoveNext (next);
+
+  NS_ASSERT (next.key.m_ts >= p->currentTs);
+  p->unscheduledEvents--;
+
+  NS_LOG_LOGIC ("handle " << next.key.m_ts);
+  p->currentTs = next.key.m_ts;
+  p->currentContext = next.key.m_context;
+  p->currentUid = next.key.m_uid;
+  next.impl->Invoke ();
+  next.impl->Unref ();
+}
+
+void
+ThreadedSimulatorImpl::Barrier (Partition *p)
+{
+  // sense-reversing barrier: the last partition to arrive resets the
+  // count and releases the others by flipping the sense
+  p->sense = !p->sense;
+  if (m_barrierCount.fetch_sub (1, std::memory_order_acq_rel) == 1)
+    {
+      m_barrierCount.store (m_nPartitions, std::memory_order_relaxed);
+      m_barrierSense.store (p->sense, std::memory_order_release);
+    }
+  else
+    {
+      while (m_barrierSense.load (std::memory_order_acquire) != p->sense)
+        {
+          std::this_thread::yield ();
+        }
+    }
+}
+
+bool
+ThreadedSimulatorImpl::IsFinished (void) const
+{
+  if (m_stop)
+    {
+      return true;
+    }
+  for (uint32_t i = 0; i < m_nPartitions; ++i)
+    {
+      if (!m_partitions[i].events->IsEmpty () && !m_partitions[i].stop)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+ThreadedSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_running)
+    {
+      RequestStop (GetPartition ()->currentTs);
+      return;
+    }
+  m_stop = true;
+}
+
+void
+ThreadedSimulatorImpl::RequestStop (uint64_t ts)
+{
+  NS_LOG_FUNCTION (this << ts);
+  // the other partitions may have processed the events up to the end
+  // of the current window
+  if (m_nPartitions > 1)
+    {
+      ts = std::max (ts, GetPartition ()->windowEnd);
+    }
+  uint64_t current = m_stopTs.load (std::memory_order_relaxed);
+  while (ts < current &&
+         !m_stopTs.compare_exchange_weak (current, ts, std::memory_order_relaxed))
+    {
+    }
+}
+
+void
+ThreadedSimulatorImpl::StopPartition (void)
+{
+  NS_LOG_FUNCTION (this);
+  GetPartition ()->stop = true;
+}
+
+void
+ThreadedSimulatorImpl::Stop (Time const &delay)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep ());
+  if (m_running)
+    {
+      RequestStop (GetPartition ()->currentTs + delay.GetTimeStep ());
+      return;
+    }
+  for (uint32_t i = 0; i < m_nPartitions; ++i)
+    {
+      Partition *p = &m_partitions[i];
+      Insert (p, p->currentTs + delay.GetTimeStep (), Simulator::NO_CONTEXT,
+              MakeEvent (&ThreadedSimulatorImpl::StopPartition, this));
+    }
+}
+
+//
+// Schedule an event for a _relative_ time in the future.
+//
+EventId
+ThreadedSimulatorImpl::Schedule (Time const &delay, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep () << event);
+
+  Partition *p = GetPartition ();
+  Time tAbsolute = delay + TimeStep (p->currentTs);
+
+  NS_ASSERT (tAbsolute.IsPositive ());
+  NS_ASSERT (tAbsolute >= TimeStep (p->currentTs));
+  uint64_t ts = tAbsolute.GetTimeStep ();
+  uint32_t uid = Insert (p, ts, p->currentContext, event);
+  return EventId (event, ts, p->currentContext, uid);
+}
+
+void
+ThreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << context << delay.GetTimeStep () << event);
+
+  Partition *p = GetPartition ();
+  uint64_t ts = p->currentTs + delay.GetTimeStep ();
+  uint32_t target = GetNodePartition (context);
+  if (target == p->id)
+    {
+      Insert (p, ts, context, event);
+    }
+  else if (!m_running)
+    {
+      Insert (&m_partitions[target], ts, context, event);
+    }
+  else
+    {
+      NS_ABORT_MSG_IF (static_cast<uint64_t> (delay.GetTimeStep ()) < m_lookahead,
+                       "Event scheduled on node " << context << " of another thread "
+                       "within the lookahead");
+      RemoteEvent remote;
+      remote.impl = event;
+      remote.ts = ts;
+      remote.context = context;
+      m_queues[p->id * m_nPartitions + target]->Push (remote);
+    }
+}
+
+EventId
+ThreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << event);
+  Partition *p = GetPartition ();
+  uint32_t uid = Insert (p, p->currentTs, p->currentContext, event);
+  return EventId (event, p->currentTs, p->currentContext, uid);
+}
+
+EventId
+ThreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << event);
+  EventId id (Ptr<EventImpl> (event, false), GetPartition ()->currentTs, 0xffffffff, 2);
+  CriticalSection cs (m_destroyMutex);
+  m_destroyEvents.push_back (id);
+  return id;
+}
+
+Time
+ThreadedSimulatorImpl::Now (void) const
+{
+  // Do not add function logging here, to avoid stack overflow
+  return TimeStep (GetPartition ()->currentTs);
+}
+
+Time
+ThreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  else
+    {
+      return TimeStep (id.GetTs () - GetPartition ()->currentTs);
+    }
+}
+
+void
+ThreadedSimulatorImpl::Remove (const EventId &id)
+{
+  if (id.GetUid () == 2)
+    {
+      // destroy events.
+      CriticalSection cs (m_destroyMutex);
+      for (DestroyEvents::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              m_destroyEvents.erase (i);
+              break;
+            }
+        }
+      return;
+    }
+  if (IsExpired (id))
+    {
+      return;
+    }
+  Partition *p = GetPartition ();
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  p->events->Remove (event);
+  event.impl->Cancel ();
+  // whenever we remove an event from the event list, we have to unref it.
+  event.impl->Unref ();
+
+  p->unscheduledEvents--;
+}
+
+void
+ThreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (!IsExpired (id))
+    {
+      id.PeekEventImpl ()->Cancel ();
+      if (id.GetUid () != 2)
+        {
+          // the event stays in the event list, unless the scheduler
+          // compacts it now
+          Partition *p = GetPartition ();
+          p->unscheduledEvents -= p->events->NotifyCancel ();
+        }
+    }
+}
+
+bool
+ThreadedSimulatorImpl::IsExpired (const EventId &id) const
+{
+  if (id.GetUid () == 2)
+    {
+      if (id.PeekEventImpl () == 0 ||
+          id.PeekEventImpl ()->IsCancelled ())
+        {
+          return true;
+        }
+      // destroy events.
+      CriticalSection cs (const_cast<SystemMutex &> (m_destroyMutex));
+      for (DestroyEvents::const_iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+  const Partition *p = GetPartition ();
+  if (id.PeekEventImpl () == 0 ||
+      id.GetTs () < p->currentTs ||
+      (id.GetTs () == p->currentTs &&
+       id.GetUid () <= p->currentUid) ||
+      id.PeekEventImpl ()->IsCancelled ())
+    {
+      return true;
+    }
+  else
+    {
+      return false;
+    }
+}
+
+Time
+ThreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return TimeStep (0x7fffffffffffffffLL);
+}
+
+uint32_t
+ThreadedSimulatorImpl::GetSystemId (void) const
+{
+  return GetPartition ()->id;
+}
+
+uint32_t
+ThreadedSimulatorImpl::GetContext (void) const
+{
+  return GetPartition ()->currentContext;
+}
+
+} // namespace ns3
@@ -0,0 +1,255 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_THREADED_SIMULATOR_IMPL_H
+#define NS3_THREADED_SIMULATOR_IMPL_H
+
+#include "ns3/simulator-impl.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/system-mutex.h"
+#include "ns3/ptr.h"
+
+#include "spsc-queue.h"
+
+#include <atomic>
+#include <list>
+#include <vector>
+
+namespace ns3 {
+
+class Node;
+
+/**
+ * \ingroup simulator
+ * \ingroup mpi
+ *
+ * \brief Distributed simulator implementation running the logical
+ * processors as threads of a single process.
+ *
+ * Each logical processor, or partition, owns the nodes whose system id
+ * is its index, and has its own event list, clock and context.  The
+ * first partition runs in the thread which calls Run, and the others
+ * in threads started by Run.  The events scheduled with the context of
+ * a node of another partition are handed to that partition through a
+ * lock-free single producer, single consumer queue, without copy.
+ *
+ * The partitions are synchronized by windows, as the granted time
+ * window algorithm of the DistributedSimulatorImpl: at the start of a
+ * window, each partition receives the events of its queues and
+ * publishes the time of its next event; the window ends one lookahead
+ * after the smallest of these times, so that no event of the window
+ * can be caused by an event of another partition of the same window.
+ * The windows are delimited by barriers on atomic counters.  The
+ * lookahead is the smallest delay of the point-to-point links between
+ * the partitions.
+ *
+ * Simulator::Stop with a delay, called before Run, stops all the
+ * partitions at the same time.  Called while the simulation runs,
+ * Simulator::Stop stops all the partitions at the same time too: the
+ * requested time, or the end of the current window if the other
+ * partitions may already have gone past the requested time, which a
+ * delay of at least the lookahead avoids.  The events of the stop time
+ * are not processed.
+ *
+ * The objects of the simulation are shared by the threads, so each of
+ * them must only be used by the events of its partition: the events
+ * may not touch the nodes of other partitions, the attributes and the
+ * random streams must be set up before Run, and the topology must be
+ * static while the simulation runs, which excludes for instance the
+ * nix-vector routing.
+ */
+class ThreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  static TypeId GetTypeId (void);
+
+  ThreadedSimulatorImpl ();
+  ~ThreadedSimulatorImpl ();
+
+  // virtual from SimulatorImpl
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (Time const &delay);
+  virtual EventId Schedule (Time const &delay, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &id);
+  virtual void Cancel (const EventId &id);
+  virtual bool IsExpired (const EventId &id) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+
+  /**
+   * \return The number of partitions.
+   */
+  uint32_t GetNPartitions (void) const;
+  /**
+   * \param node The id of a node.
+   * \return The partition of the node.
+   */
+  uint32_t GetNodePartition (uint32_t node) const;
+  /**
+   * Get a node without touching its reference count, which may be
+   * changed at the same time by the thread of another partition.  Only
+   * valid while the simulation runs.
+   *
+   * \param node The id of a node.
+   * \return The node.
+   */
+  Node * PeekNode (uint32_t node) const;
+  /**
+   * \return The lookahead of the last run.
+   */
+  Time GetLookahead (void) const;
+  /**
+   * \return The number of windows of the last run.
+   */
+  uint64_t GetNWindows (void) const;
+
+private:
+  /** An event handed to another partition. */
+  struct RemoteEvent
+  {
+    EventImpl *impl;   //!< The event.
+    uint64_t ts;       //!< The time of the event.
+    uint32_t context;  //!< The context of the event.
+  };
+
+  /** The state of a logical processor. */
+  struct Partition
+  {
+    Partition ();
+
+    uint32_t id;                //!< The index of the partition.
+    Ptr<Scheduler> events;      //!< The event list.
+    uint32_t uid;               //!< The next event uid.
+    uint32_t currentUid;        //!< The uid of the current event.
+    uint64_t currentTs;         //!< The time of the current event.
+    uint32_t currentContext;    //!< The context of the current event.
+    /**
+     * The number of events inserted but not yet processed, not counting
+     * the destroy events; used for validation.
+     */
+    int unscheduledEvents;
+    bool stop;                  //!< Stopped by a stop event.
+    uint64_t windowEnd;         //!< The end of the current window.
+    bool sense;                 //!< The barrier phase of the partition.
+  };
+
+  /** Run a partition in a thread. */
+  struct Worker
+  {
+    ThreadedSimulatorImpl *impl;  //!< The simulator.
+    uint32_t partition;           //!< The partition run by the thread.
+    /** Run the partition. */
+    void Run (void);
+  };
+
+  virtual void DoDispose (void);
+  virtual void NotifyConstructionCompleted (void);
+
+  /**
+   * \return The partition of the calling thread, the first partition
+   *         outside of Run.
+   */
+  Partition * GetPartition (void) const;
+  /**
+   * Insert an event in the event list of a partition.
+   *
+   * \param p The partition.
+   * \param ts The time of the event.
+   * \param context The context of the event.
+   * \param event The event.
+   * \return The uid of the event.
+   */
+  uint32_t Insert (Partition *p, uint64_t ts, uint32_t context, EventImpl *event);
+  /**
+   * Find the partitions of the nodes, and the lookahead.
+   */
+  void PrepareRun (void);
+  /**
+   * Process the windows of a partition until all the partitions are
+   * finished.
+   *
+   * \param p The partition.
+   */
+  void RunPartition (Partition *p);
+  /**
+   * Insert the events handed to a partition by the other ones.
+   *
+   * \param p The partition.
+   */
+  void ReceiveEvents (Partition *p);
+  /**
+   * Process the next event of a partition.
+   *
+   * \param p The partition.
+   */
+  void ProcessOneEvent (Partition *p);
+  /**
+   * Wait until all the partitions have reached the barrier.
+   *
+   * \param p The partition of the calling thread.
+   */
+  void Barrier (Partition *p);
+  /** Stop the partition of the calling thread. */
+  void StopPartition (void);
+  /**
+   * Stop all the partitions at a time, or at the end of the current
+   * window if it is later and there are other partitions.  Called while
+   * the simulation runs.
+   *
+   * \param ts The time of the stop.
+   */
+  void RequestStop (uint64_t ts);
+
+  typedef std::list<EventId> DestroyEvents;
+
+  uint32_t m_nPartitions;                 //!< The number of partitions.
+  std::vector<Partition> m_partitions;    //!< The partitions.
+  /** The queue of the events sent by partition i to partition j, at i * n + j. */
+  std::vector<SpscQueue<RemoteEvent> *> m_queues;
+  /** The time of the next event of each partition, at the start of a window. */
+  std::atomic<uint64_t> *m_nextTs;
+  std::atomic<uint32_t> m_barrierCount;   //!< The partitions still expected at the barrier.
+  std::atomic<bool> m_barrierSense;       //!< The phase of the last completed barrier.
+  /**
+   * The time at which all the partitions stop, requested while the
+   * simulation runs.  It is read at the start of the windows, and is
+   * never before the end of the window in which it is requested.
+   */
+  std::atomic<uint64_t> m_stopTs;
+  bool m_stop;                            //!< Whether the partitions have been stopped.
+  bool m_running;                         //!< Whether Run is in progress.
+  uint64_t m_lookahead;                   //!< The lookahead, in time steps.
+  uint64_t m_nWindows;                    //!< The number of windows of the last run.
+  std::vector<uint32_t> m_nodePartitions; //!< The partition of each node.
+  std::vector<Node *> m_nodes;            //!< The nodes, while the simulation runs.
+  DestroyEvents m_destroyEvents;          //!< The destroy events.
+  SystemMutex m_destroyMutex;             //!< Protect the destroy events.
+};
+
+} // namespace ns3
+
+#endif /* NS3_THREADED_SIMULATOR_IMPL_H */
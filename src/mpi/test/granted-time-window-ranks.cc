@@ -0,0 +1,164 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ * The ranks of the distributed simulation run by the
+ * granted-time-window test suite, with mpiexec.
+ *
+ * The nodes form a ring of point-to-point links, and node i belongs to
+ * rank i modulo the number of ranks, so that all the links are remote
+ * as soon as there are several ranks.  Each node sends a burst of
+ * packets to the next node of the ring, which forwards them a few
+ * times.  The bursts start at different times, so that the next events
+ * of the ranks are apart, and the packets have the same size, so that
+ * the batches of packets hold the same number of packets.  The packets
+ * sent on a link during a granted time window are much larger than the
+ * 64 KB at which a batch of packets used to be sent while the window
+ * was processed.
+ *
+ * Each rank prints, for each of its nodes, the number of packets
+ * received, their bytes and the sum of their reception times, which do
+ * not depend on the number of ranks.
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mpi-interface.h"
+#include "ns3/point-to-point-helper.h"
+
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+/** The number of nodes of the ring. */
+static const uint32_t N_NODES = 6;
+/** The number of packets sent by each node. */
+static const uint32_t N_PACKETS = 2000;
+/** The number of times a packet is forwarded. */
+static const uint8_t N_HOPS = 3;
+
+/** The device of each node to the next node of the ring. */
+static std::vector<Ptr<NetDevice> > g_nextDevices;
+/** The number of packets received by each node. */
+static std::vector<uint64_t> g_packets;
+/** The bytes received by each node. */
+static std::vector<uint64_t> g_bytes;
+/** The sum of the reception times of each node, in nanoseconds. */
+static std::vector<uint64_t> g_times;
+
+/**
+ * Send a packet to the next node of the ring.
+ *
+ * \param [in] node The sending node.
+ * \param [in] size The size of the packet.
+ * \param [in] hops The number of times the packet has been forwarded.
+ */
+static void
+Send (uint32_t node, uint32_t size, uint8_t hops)
+{
+  std::vector<uint8_t> data (size, 0);
+  data[0] = hops;
+  Ptr<Packet> packet = Create<Packet> (&data[0], size);
+  Ptr<NetDevice> device = g_nextDevices[node];
+  device->Send (packet, device->GetBroadcast (), 0x0800);
+}
+
+/**
+ * Record a received packet, and forward it.
+ *
+ * \param [in] device The receiving device.
+ * \param [in] packet The packet.
+ */
+static void
+Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t, const Address &,
+         const Address &, NetDevice::PacketType)
+{
+  uint32_t node = device->GetNode ()->GetId ();
+  g_packets[node]++;
+  g_bytes[node] += packet->GetSize ();
+  g_times[node] += Simulator::Now ().GetNanoSeconds ();
+  uint8_t hops;
+  packet->CopyData (&hops, 1);
+  if (device != g_nextDevices[node] && hops < N_HOPS)
+    {
+      Send (node, packet->GetSize (), hops + 1);
+    }
+}
+
+int
+main (int argc, char *argv[])
+{
+  CommandLine cmd;
+  cmd.Parse (argc, argv);
+
+  GlobalValue::Bind ("SimulatorImplementationType",
+                     StringValue ("ns3::DistributedSimulatorImpl"));
+  MpiInterface::Enable (&argc, &argv);
+  uint32_t systemId = MpiInterface::GetSystemId ();
+  uint32_t systemCount = MpiInterface::GetSize ();
+
+  NodeContainer nodes;
+  for (uint32_t i = 0; i < N_NODES; ++i)
+    {
+      nodes.Add (CreateObject<Node> (i % systemCount));
+    }
+
+  PointToPointHelper link;
+  link.SetDeviceAttribute ("DataRate", StringValue ("40Gbps"));
+  link.SetChannelAttribute ("Delay", StringValue ("1ms"));
+  g_nextDevices.resize (N_NODES);
+  for (uint32_t i = 0; i < N_NODES; ++i)
+    {
+      NetDeviceContainer devices = link.Install (nodes.Get (i), nodes.Get ((i + 1) % N_NODES));
+      g_nextDevices[i] = devices.Get (0);
+    }
+  g_packets.assign (N_NODES, 0);
+  g_bytes.assign (N_NODES, 0);
+  g_times.assign (N_NODES, 0);
+
+  for (uint32_t i = 0; i < N_NODES; ++i)
+    {
+      Ptr<Node> node = nodes.Get (i);
+      if (node->GetSystemId () != systemId)
+        {
+          continue;
+        }
+      for (uint32_t d = 0; d < node->GetNDevices (); ++d)
+        {
+          node->RegisterProtocolHandler (MakeCallback (&Receive), 0x0800, node->GetDevice (d));
+        }
+      for (uint32_t k = 0; k < N_PACKETS; ++k)
+        {
+          Simulator::ScheduleWithContext (i, MicroSeconds (1700 * i + k), &Send, i, 1000, 0);
+        }
+    }
+
+  Simulator::Run ();
+
+  for (uint32_t i = 0; i < N_NODES; ++i)
+    {
+      if (nodes.Get (i)->GetSystemId () == systemId)
+        {
+          std::cout << "node " << i << ": " << g_packets[i] << " packets, "
+                    << g_bytes[i] << " bytes, " << g_times[i] << " ns" << std::endl;
+        }
+    }
+
+  g_nextDevices.clear ();
+  Simulator::Destroy ();
+  MpiInterface::Disable ();
+  return 0;
+}
@@ -0,0 +1,127 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup mpi-tests
+ * DistributedSimulatorImpl test suite.
+ */
+
+using namespace ns3;
+
+/**
+ * \ingroup mpi-tests
+ * Check that the packets sent between the ranks while the rounds of the
+ * LBTS computation progress are received at their time.
+ *
+ * The ranks, run with mpiexec by granted-time-window-ranks.cc, send
+ * several hundred kilobytes to each other during each window.  Their
+ * results must not depend on the number of ranks.
+ */
+class GrantedTimeWindowBatchTestCase : public TestCase
+{
+public:
+  GrantedTimeWindowBatchTestCase ();
+  virtual ~GrantedTimeWindowBatchTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Run the ranks.
+   *
+   * \param [in] ranks The number of ranks.
+   * \param [out] lines The lines printed by the ranks, sorted.
+   * \returns The exit status of mpiexec.
+   */
+  int RunRanks (uint32_t ranks, std::vector<std::string> &lines);
+};
+
+GrantedTimeWindowBatchTestCase::GrantedTimeWindowBatchTestCase ()
+  : TestCase ("Receive the packets sent during the LBTS rounds at their time")
+{
+}
+
+GrantedTimeWindowBatchTestCase::~GrantedTimeWindowBatchTestCase ()
+{
+}
+
+int
+GrantedTimeWindowBatchTestCase::RunRanks (uint32_t ranks, std::vector<std::string> &lines)
+{
+  std::ostringstream name;
+  name << "ranks-" << ranks << ".txt";
+  std::string output = CreateTempDirFilename (name.str ());
+  std::ostringstream command;
+  command << NS3_MPIEXEC << " -n " << ranks << " " << NS3_MPI_TEST_RANKS
+          << " > \"" << output << "\"";
+  int status = std::system (command.str ().c_str ());
+
+  // the lines of the ranks are interleaved
+  lines.clear ();
+  std::ifstream file (output.c_str ());
+  std::string line;
+  while (std::getline (file, line))
+    {
+      lines.push_back (line);
+    }
+  std::sort (lines.begin (), lines.end ());
+  return status;
+}
+
+void
+GrantedTimeWindowBatchTestCase::DoRun (void)
+{
+  std::vector<std::string> reference;
+  NS_TEST_ASSERT_MSG_EQ (RunRanks (1, reference), 0, "The rank failed");
+  NS_TEST_ASSERT_MSG_EQ (reference.size (), 6, "Nodes missing from the output");
+
+  uint32_t ranks[] = { 2, 3 };
+  for (uint32_t i = 0; i < sizeof (ranks) / sizeof (ranks[0]); ++i)
+    {
+      std::vector<std::string> lines;
+      NS_TEST_ASSERT_MSG_EQ (RunRanks (ranks[i], lines), 0, "The ranks failed with " << ranks[i] << " ranks");
+      NS_TEST_ASSERT_MSG_EQ ((lines == reference), true, "Results differ with " << ranks[i] << " ranks");
+    }
+}
+
+
+/**
+ * \ingroup mpi-tests
+ * DistributedSimulatorImpl test suite.
+ */
+class GrantedTimeWindowTestSuite : public TestSuite
+{
+public:
+  GrantedTimeWindowTestSuite ();
+};
+
+GrantedTimeWindowTestSuite::GrantedTimeWindowTestSuite ()
+  : TestSuite ("mpi-granted-time-window", SYSTEM)
+{
+  AddTestCase (new GrantedTimeWindowBatchTestCase, TestCase::QUICK);
+}
+
+/** Static variable for test initialization. */
+static GrantedTimeWindowTestSuite g_grantedTimeWindowTestSuite;
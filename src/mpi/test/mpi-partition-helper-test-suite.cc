@@ -0,0 +1,391 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/nstime.h"
+#include "ns3/mpi-partition-helper.h"
+
+#include <algorithm>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup mpi-tests
+ * MpiPartitionHelper test suite.
+ */
+
+using namespace ns3;
+
+/**
+ * \ingroup mpi-tests
+ * Build a ring of point-to-point links.
+ *
+ * \param [in,out] partition The helper.
+ * \param [in] n The number of nodes of the ring.
+ * \param [in] delay The delay of the links.
+ */
+static void
+AddRing (MpiPartitionHelper &partition, uint32_t n, Time delay)
+{
+  uint32_t first = partition.AddNodes (n);
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      partition.AddLink (first + i, first + (i + 1) % n, delay);
+    }
+}
+
+/**
+ * \ingroup mpi-tests
+ * Check the cut size of rings, whose optimal cut is known: a ring split
+ * into k ranks of consecutive nodes has k links between ranks.
+ */
+class MpiPartitionRingTestCase : public TestCase
+{
+public:
+  MpiPartitionRingTestCase ();
+  virtual ~MpiPartitionRingTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+MpiPartitionRingTestCase::MpiPartitionRingTestCase ()
+  : TestCase ("Check the cut size of a ring")
+{
+}
+
+MpiPartitionRingTestCase::~MpiPartitionRingTestCase ()
+{
+}
+
+void
+MpiPartitionRingTestCase::DoRun (void)
+{
+  uint32_t ranks[] = { 1, 2, 3, 4 };
+  for (uint32_t i = 0; i < sizeof (ranks) / sizeof (ranks[0]); ++i)
+    {
+      MpiPartitionHelper partition;
+      AddRing (partition, 12, MilliSeconds (1));
+      partition.Partition (ranks[i]);
+      NS_TEST_EXPECT_MSG_EQ (partition.GetCutSize (), (ranks[i] == 1 ? 0 : ranks[i]),
+                             "Wrong cut size with " << ranks[i] << " ranks");
+      for (uint32_t rank = 0; rank < ranks[i]; ++rank)
+        {
+          NS_TEST_EXPECT_MSG_EQ_TOL (partition.GetLoad (rank), 12.0 / ranks[i], 1e-9,
+                                     "Unbalanced rank " << rank << " with " << ranks[i] << " ranks");
+        }
+    }
+
+  // without any link between ranks, there is no lookahead
+  MpiPartitionHelper partition;
+  AddRing (partition, 12, MilliSeconds (1));
+  partition.Partition (1);
+  NS_TEST_EXPECT_MSG_EQ (partition.GetLookahead (), Time::Max (), "Lookahead without remote links");
+}
+
+/**
+ * \ingroup mpi-tests
+ * Check that the nodes joined by a local link are in the same rank.
+ */
+class MpiPartitionLocalLinkTestCase : public TestCase
+{
+public:
+  MpiPartitionLocalLinkTestCase ();
+  virtual ~MpiPartitionLocalLinkTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+MpiPartitionLocalLinkTestCase::MpiPartitionLocalLinkTestCase ()
+  : TestCase ("Check that the local links are never cut")
+{
+}
+
+MpiPartitionLocalLinkTestCase::~MpiPartitionLocalLinkTestCase ()
+{
+}
+
+void
+MpiPartitionLocalLinkTestCase::DoRun (void)
+{
+  // local links across the ring, which the best cuts of the ring split
+  uint32_t pairs[][2] = { { 0, 6 }, { 3, 9 }, { 1, 2 }, { 10, 4 } };
+  uint32_t nPairs = sizeof (pairs) / sizeof (pairs[0]);
+  uint32_t ranks[] = { 2, 3, 4 };
+  for (uint32_t i = 0; i < sizeof (ranks) / sizeof (ranks[0]); ++i)
+    {
+      MpiPartitionHelper partition;
+      AddRing (partition, 12, MilliSeconds (1));
+      for (uint32_t j = 0; j < nPairs; ++j)
+        {
+          partition.AddLocalLink (pairs[j][0], pairs[j][1]);
+        }
+      partition.SetImbalance (0.5);
+      partition.Partition (ranks[i]);
+      for (uint32_t j = 0; j < nPairs; ++j)
+        {
+          NS_TEST_EXPECT_MSG_EQ (partition.GetSystemId (pairs[j][0]), partition.GetSystemId (pairs[j][1]),
+                                 "Local link " << pairs[j][0] << "-" << pairs[j][1]
+                                 << " split with " << ranks[i] << " ranks");
+        }
+    }
+}
+
+/**
+ * \ingroup mpi-tests
+ * Check that the lookahead is the smallest delay of the links between
+ * ranks, and that the short links are kept inside the ranks.
+ */
+class MpiPartitionLookaheadTestCase : public TestCase
+{
+public:
+  MpiPartitionLookaheadTestCase ();
+  virtual ~MpiPartitionLookaheadTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+MpiPartitionLookaheadTestCase::MpiPartitionLookaheadTestCase ()
+  : TestCase ("Check the lookahead")
+{
+}
+
+MpiPartitionLookaheadTestCase::~MpiPartitionLookaheadTestCase ()
+{
+}
+
+void
+MpiPartitionLookaheadTestCase::DoRun (void)
+{
+  // four rings of four nodes with 1 ms links, joined into a ring by
+  // 10 ms links
+  MpiPartitionHelper partition;
+  std::vector<Time> delays;
+  std::vector<std::pair<uint32_t, uint32_t> > links;
+  for (uint32_t cluster = 0; cluster < 4; ++cluster)
+    {
+      AddRing (partition, 4, MilliSeconds (1));
+      for (uint32_t i = 0; i < 4; ++i)
+        {
+          links.push_back (std::make_pair (4 * cluster + i, 4 * cluster + (i + 1) % 4));
+          delays.push_back (MilliSeconds (1));
+        }
+    }
+  for (uint32_t cluster = 0; cluster < 4; ++cluster)
+    {
+      uint32_t a = 4 * cluster;
+      uint32_t b = 4 * ((cluster + 1) % 4) + 2;
+      partition.AddLink (a, b, MilliSeconds (10 + cluster));
+      links.push_back (std::make_pair (a, b));
+      delays.push_back (MilliSeconds (10 + cluster));
+    }
+
+  uint32_t ranks[] = { 2, 4 };
+  for (uint32_t i = 0; i < sizeof (ranks) / sizeof (ranks[0]); ++i)
+    {
+      partition.Partition (ranks[i]);
+      Time lookahead = Time::Max ();
+      uint32_t cut = 0;
+      for (uint32_t j = 0; j < links.size (); ++j)
+        {
+          if (partition.GetSystemId (links[j].first) != partition.GetSystemId (links[j].second))
+            {
+              lookahead = std::min (lookahead, delays[j]);
+              cut++;
+            }
+        }
+      NS_TEST_EXPECT_MSG_EQ (partition.GetLookahead (), lookahead,
+                             "Lookahead is not the smallest delay of the links between ranks");
+      NS_TEST_EXPECT_MSG_EQ (partition.GetCutSize (), cut, "Wrong cut size");
+      NS_TEST_EXPECT_MSG_EQ ((partition.GetLookahead () >= MilliSeconds (10)), true,
+                             "A short link is cut with " << ranks[i] << " ranks");
+      NS_TEST_EXPECT_MSG_EQ (partition.GetCutSize (), (ranks[i] == 2 ? 2 : 4),
+                             "Wrong cut size with " << ranks[i] << " ranks");
+    }
+}
+
+/**
+ * \ingroup mpi-tests
+ * Check that the load of each rank is within the allowed imbalance.
+ */
+class MpiPartitionBalanceTestCase : public TestCase
+{
+public:
+  MpiPartitionBalanceTestCase ();
+  virtual ~MpiPartitionBalanceTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+MpiPartitionBalanceTestCase::MpiPartitionBalanceTestCase ()
+  : TestCase ("Check the load of the ranks")
+{
+}
+
+MpiPartitionBalanceTestCase::~MpiPartitionBalanceTestCase ()
+{
+}
+
+void
+MpiPartitionBalanceTestCase::DoRun (void)
+{
+  // a star of stars, the hubs being heavier than the leaves
+  MpiPartitionHelper partition;
+  uint32_t core = partition.AddNode (4);
+  double total = 4;
+  for (uint32_t i = 0; i < 6; ++i)
+    {
+      uint32_t hub = partition.AddNode (3);
+      partition.AddLink (core, hub, MilliSeconds (5));
+      uint32_t leaves = partition.AddNodes (5, 1 + i % 3);
+      for (uint32_t j = 0; j < 5; ++j)
+        {
+          partition.AddLink (hub, leaves + j, MilliSeconds (1 + j));
+        }
+      total += 3 + 5 * (1 + i % 3);
+    }
+
+  double imbalances[] = { 0.1, 0.25 };
+  uint32_t ranks[] = { 2, 3, 4 };
+  for (uint32_t i = 0; i < sizeof (imbalances) / sizeof (imbalances[0]); ++i)
+    {
+      partition.SetImbalance (imbalances[i]);
+      for (uint32_t j = 0; j < sizeof (ranks) / sizeof (ranks[0]); ++j)
+        {
+          partition.Partition (ranks[j]);
+          double sum = 0;
+          for (uint32_t rank = 0; rank < ranks[j]; ++rank)
+            {
+              NS_TEST_EXPECT_MSG_LT_OR_EQ (partition.GetLoad (rank),
+                                           (1 + imbalances[i]) * total / ranks[j] + 1e-9,
+                                           "Rank " << rank << " overloaded with " << ranks[j]
+                                           << " ranks and an imbalance of " << imbalances[i]);
+              sum += partition.GetLoad (rank);
+            }
+          NS_TEST_EXPECT_MSG_EQ_TOL (sum, total, 1e-9, "Nodes missing from the ranks");
+        }
+    }
+}
+
+/**
+ * \ingroup mpi-tests
+ * Check that the same topology is always partitioned the same way.
+ */
+class MpiPartitionDeterminismTestCase : public TestCase
+{
+public:
+  MpiPartitionDeterminismTestCase ();
+  virtual ~MpiPartitionDeterminismTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Build a topology.
+   *
+   * \param [out] partition The helper.
+   */
+  void Build (MpiPartitionHelper &partition) const;
+};
+
+MpiPartitionDeterminismTestCase::MpiPartitionDeterminismTestCase ()
+  : TestCase ("Check that the partition is deterministic")
+{
+}
+
+MpiPartitionDeterminismTestCase::~MpiPartitionDeterminismTestCase ()
+{
+}
+
+void
+MpiPartitionDeterminismTestCase::Build (MpiPartitionHelper &partition) const
+{
+  // a grid with links of several delays, and equal weights that leave
+  // ties to break
+  const uint32_t side = 5;
+  partition.AddNodes (side * side);
+  for (uint32_t row = 0; row < side; ++row)
+    {
+      for (uint32_t column = 0; column < side; ++column)
+        {
+          uint32_t node = row * side + column;
+          if (column + 1 < side)
+            {
+              partition.AddLink (node, node + 1, MilliSeconds (1 + (row + column) % 3));
+            }
+          if (row + 1 < side)
+            {
+              partition.AddLink (node, node + side, MilliSeconds (1 + (row * column) % 2));
+            }
+        }
+    }
+  partition.AddLocalLink (0, 24);
+}
+
+void
+MpiPartitionDeterminismTestCase::DoRun (void)
+{
+  for (uint32_t ranks = 2; ranks <= 4; ++ranks)
+    {
+      MpiPartitionHelper first;
+      Build (first);
+      first.Partition (ranks);
+      MpiPartitionHelper second;
+      Build (second);
+      second.Partition (ranks);
+      std::vector<uint32_t> systemIds;
+      for (uint32_t i = 0; i < first.GetNNodes (); ++i)
+        {
+          systemIds.push_back (first.GetSystemId (i));
+          NS_TEST_EXPECT_MSG_EQ (second.GetSystemId (i), first.GetSystemId (i),
+                                 "Node " << i << " moved between two helpers with " << ranks << " ranks");
+        }
+
+      // partitioning again gives the same ranks
+      first.Partition (ranks);
+      for (uint32_t i = 0; i < first.GetNNodes (); ++i)
+        {
+          NS_TEST_EXPECT_MSG_EQ (first.GetSystemId (i), systemIds[i],
+                                 "Node " << i << " moved when partitioning again with " << ranks << " ranks");
+        }
+    }
+}
+
+
+/**
+ * \ingroup mpi-tests
+ * MpiPartitionHelper test suite.
+ */
+class MpiPartitionHelperTestSuite : public TestSuite
+{
+public:
+  MpiPartitionHelperTestSuite ();
+};
+
+MpiPartitionHelperTestSuite::MpiPartitionHelperTestSuite ()
+  : TestSuite ("mpi-partition-helper", UNIT)
+{
+  AddTestCase (new MpiPartitionRingTestCase, TestCase::QUICK);
+  AddTestCase (new MpiPartitionLocalLinkTestCase, TestCase::QUICK);
+  AddTestCase (new MpiPartitionLookaheadTestCase, TestCase::QUICK);
+  AddTestCase (new MpiPartitionBalanceTestCase, TestCase::QUICK);
+  AddTestCase (new MpiPartitionDeterminismTestCase, TestCase::QUICK);
+}
+
+/** Static variable for test initialization. */
+static MpiPartitionHelperTestSuite g_mpiPartitionHelperTestSuite;
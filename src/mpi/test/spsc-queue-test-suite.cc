@@ -0,0 +1,183 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/system-thread.h"
+#include "ns3/callback.h"
+
+#include "../model/spsc-queue.h"
+
+/**
+ * \file
+ * \ingroup mpi-tests
+ * SpscQueue test suite.
+ */
+
+/**
+ * \ingroup mpi
+ * \defgroup mpi-tests Mpi module tests
+ */
+
+using namespace ns3;
+
+/**
+ * \ingroup mpi-tests
+ * Check the order of the items in a single thread, across blocks.
+ */
+class SpscQueueOrderTestCase : public TestCase
+{
+public:
+  SpscQueueOrderTestCase ();
+  virtual ~SpscQueueOrderTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SpscQueueOrderTestCase::SpscQueueOrderTestCase ()
+  : TestCase ("Check the order of the items in a single thread")
+{
+}
+
+SpscQueueOrderTestCase::~SpscQueueOrderTestCase ()
+{
+}
+
+void
+SpscQueueOrderTestCase::DoRun (void)
+{
+  SpscQueue<uint32_t> queue;
+  uint32_t item = 0;
+  NS_TEST_ASSERT_MSG_EQ (queue.Pop (item), false, "Item popped from an empty queue");
+
+  // fill several blocks before popping
+  for (uint32_t i = 0; i < 1000; ++i)
+    {
+      queue.Push (i);
+    }
+  for (uint32_t i = 0; i < 1000; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (queue.Pop (item), true, "Item missing");
+      NS_TEST_ASSERT_MSG_EQ (item, i, "Items out of order");
+    }
+  NS_TEST_ASSERT_MSG_EQ (queue.Pop (item), false, "Item popped from an empty queue");
+
+  // alternate pushes and pops across the end of the blocks
+  uint32_t pushed = 0;
+  uint32_t popped = 0;
+  for (uint32_t round = 0; round < 100; ++round)
+    {
+      for (uint32_t i = 0; i < 7; ++i)
+        {
+          queue.Push (pushed++);
+        }
+      for (uint32_t i = 0; i < 5; ++i)
+        {
+          NS_TEST_ASSERT_MSG_EQ (queue.Pop (item), true, "Item missing");
+          NS_TEST_ASSERT_MSG_EQ (item, popped++, "Items out of order");
+        }
+    }
+  while (queue.Pop (item))
+    {
+      NS_TEST_ASSERT_MSG_EQ (item, popped++, "Items out of order");
+    }
+  NS_TEST_ASSERT_MSG_EQ (popped, pushed, "Items lost");
+}
+
+
+/**
+ * \ingroup mpi-tests
+ * Check that the items pushed by a thread are all popped by another,
+ * in order.
+ */
+class SpscQueueThreadsTestCase : public TestCase
+{
+public:
+  SpscQueueThreadsTestCase ();
+  virtual ~SpscQueueThreadsTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /** Push the items, in the producer thread. */
+  void Produce (void);
+
+  SpscQueue<uint64_t> m_queue;  //!< The queue.
+  uint64_t m_n;                 //!< The number of items.
+};
+
+SpscQueueThreadsTestCase::SpscQueueThreadsTestCase ()
+  : TestCase ("Check the items passed from a thread to another"),
+    m_n (1000000)
+{
+}
+
+SpscQueueThreadsTestCase::~SpscQueueThreadsTestCase ()
+{
+}
+
+void
+SpscQueueThreadsTestCase::Produce (void)
+{
+  for (uint64_t i = 0; i < m_n; ++i)
+    {
+      m_queue.Push (i);
+    }
+}
+
+void
+SpscQueueThreadsTestCase::DoRun (void)
+{
+  Ptr<SystemThread> producer = Create<SystemThread> (MakeCallback (&SpscQueueThreadsTestCase::Produce, this));
+  producer->Start ();
+
+  uint64_t expected = 0;
+  bool ordered = true;
+  while (expected < m_n)
+    {
+      uint64_t item;
+      if (m_queue.Pop (item))
+        {
+          ordered = ordered && item == expected;
+          ++expected;
+        }
+    }
+  producer->Join ();
+
+  NS_TEST_ASSERT_MSG_EQ (ordered, true, "Items out of order");
+  uint64_t item;
+  NS_TEST_ASSERT_MSG_EQ (m_queue.Pop (item), false, "Item popped from an empty queue");
+}
+
+
+/**
+ * \ingroup mpi-tests
+ * SpscQueue test suite.
+ */
+class SpscQueueTestSuite : public TestSuite
+{
+public:
+  SpscQueueTestSuite ();
+};
+
+SpscQueueTestSuite::SpscQueueTestSuite ()
+  : TestSuite ("spsc-queue", UNIT)
+{
+  AddTestCase (new SpscQueueOrderTestCase, TestCase::QUICK);
+  AddTestCase (new SpscQueueThreadsTestCase, TestCase::QUICK);
+}
+
+/** Static variable for test initialization. */
+static SpscQueueTestSuite g_spscQueueTestSuite;
@@ -0,0 +1,440 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/object-factory.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/nstime.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+
+#include "../model/threaded-simulator-impl.h"
+
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup mpi-tests
+ * ThreadedSimulatorImpl test suite.
+ */
+
+using namespace ns3;
+
+/**
+ * \ingroup mpi-tests
+ * Messages passed between the nodes of a ring, run by a
+ * ThreadedSimulatorImpl.
+ *
+ * Each message received by a node is recorded, and causes a message to
+ * a node and after a delay both drawn from its value.  The records of a
+ * node are only written by the thread of its partition.
+ */
+class ThreadedSimulatorMessages
+{
+public:
+  /** A message received by a node. */
+  struct Record
+  {
+    uint32_t node;   //!< The receiving node.
+    uint64_t ts;     //!< The time of reception.
+    uint32_t from;   //!< The sending node.
+    uint32_t value;  //!< The value of the message.
+    /**
+     * Compare two records.
+     * \param [in] o The other record.
+     * \returns \c true if this record is before \p o.
+     */
+    bool operator < (const Record &o) const;
+    /**
+     * Compare two records.
+     * \param [in] o The other record.
+     * \returns \c true if the records are equal.
+     */
+    bool operator == (const Record &o) const;
+  };
+
+  /** How the simulation is stopped. */
+  enum StopMode
+  {
+    NO_STOP,      //!< Run until the messages are all received.
+    STOP,         //!< Simulator::Stop without delay, from an event.
+    STOP_LATER    //!< Simulator::Stop with a delay, from an event.
+  };
+
+  /**
+   * Run the simulation.
+   *
+   * \param [in] threads The number of threads.
+   * \param [in] mode How the simulation is stopped.
+   */
+  void Run (uint32_t threads, StopMode mode);
+
+  /** The nodes. */
+  static const uint32_t N_NODES = 8;
+  /** The delay of the links between the nodes, in microseconds. */
+  static const uint32_t LINK_DELAY = 1000;
+  /** The time of the stop request, in microseconds. */
+  static const uint32_t STOP_TIME = 10000;
+  /** The delay of Simulator::Stop (Time), in microseconds. */
+  static const uint32_t STOP_DELAY = 5000;
+
+  /** The records of all the nodes, sorted. */
+  std::vector<Record> m_records;
+  /** The number of messages received at another time than expected. */
+  uint32_t m_lateMessages;
+  /** The number of messages received by another partition than the one of their node. */
+  uint32_t m_misplacedMessages;
+  /** The number of packets whose uid has another system id than the partition. */
+  uint32_t m_misnumberedPackets;
+
+private:
+  /**
+   * Receive a message.
+   *
+   * \param [in] node The receiving node.
+   * \param [in] from The sending node.
+   * \param [in] value The value of the message.
+   * \param [in] hops The number of messages before this one.
+   * \param [in] ts The expected time of reception.
+   */
+  void Receive (uint32_t node, uint32_t from, uint32_t value, uint32_t hops, uint64_t ts);
+  /**
+   * Send a message.
+   *
+   * \param [in] node The sending node.
+   * \param [in] value The value of the previous message.
+   * \param [in] hops The number of messages before this one.
+   */
+  void Send (uint32_t node, uint32_t value, uint32_t hops);
+  /** Request the stop, in the partition of the first node. */
+  void RequestStop (void);
+
+  StopMode m_mode;                                //!< How the simulation is stopped.
+  uint32_t m_threads;                             //!< The number of threads.
+  std::vector<std::vector<Record> > m_nodeRecords; //!< The records of each node.
+  std::vector<uint32_t> m_nodeErrors;              //!< The errors found by each node, by kind.
+};
+
+bool
+ThreadedSimulatorMessages::Record::operator < (const Record &o) const
+{
+  if (node != o.node)
+    {
+      return node < o.node;
+    }
+  if (ts != o.ts)
+    {
+      return ts < o.ts;
+    }
+  if (from != o.from)
+    {
+      return from < o.from;
+    }
+  return value < o.value;
+}
+
+bool
+ThreadedSimulatorMessages::Record::operator == (const Record &o) const
+{
+  return node == o.node && ts == o.ts && from == o.from && value == o.value;
+}
+
+void
+ThreadedSimulatorMessages::Receive (uint32_t node, uint32_t from, uint32_t value, uint32_t hops, uint64_t ts)
+{
+  uint32_t *errors = &m_nodeErrors[3 * node];
+  if (static_cast<uint64_t> (Simulator::Now ().GetTimeStep ()) != ts || Simulator::GetContext () != node)
+    {
+      errors[0]++;
+    }
+  if (Simulator::GetSystemId () != node % m_threads)
+    {
+      errors[1]++;
+    }
+  Ptr<Packet> packet = Create<Packet> (value % 1500);
+  if ((packet->GetUid () >> 32) != Simulator::GetSystemId ())
+    {
+      errors[2]++;
+    }
+  Record record;
+  record.node = node;
+  record.ts = ts;
+  record.from = from;
+  record.value = value;
+  m_nodeRecords[node].push_back (record);
+  if (hops < 100)
+    {
+      Send (node, value, hops + 1);
+    }
+}
+
+void
+ThreadedSimulatorMessages::Send (uint32_t node, uint32_t value, uint32_t hops)
+{
+  uint32_t next = value * 1103515245U + 12345U;
+  uint32_t to = (next >> 8) % N_NODES;
+  Time delay = MicroSeconds (LINK_DELAY + (next >> 16) % 500);
+  uint64_t ts = (Simulator::Now () + delay).GetTimeStep ();
+  Simulator::ScheduleWithContext (to, delay, &ThreadedSimulatorMessages::Receive, this,
+                                  to, node, next, hops, ts);
+}
+
+void
+ThreadedSimulatorMessages::RequestStop (void)
+{
+  if (m_mode == STOP)
+    {
+      Simulator::Stop ();
+    }
+  else
+    {
+      Simulator::Stop (MicroSeconds (STOP_DELAY));
+    }
+}
+
+void
+ThreadedSimulatorMessages::Run (uint32_t threads, StopMode mode)
+{
+  m_mode = mode;
+  m_threads = threads;
+  ObjectFactory factory;
+  factory.SetTypeId (ThreadedSimulatorImpl::GetTypeId ());
+  factory.Set ("Threads", UintegerValue (threads));
+  Simulator::SetImplementation (factory.Create<SimulatorImpl> ());
+
+  // a ring of links, whose delay is the lookahead between the partitions
+  std::vector<Ptr<Node> > nodes;
+  for (uint32_t i = 0; i < N_NODES; ++i)
+    {
+      nodes.push_back (CreateObject<Node> (i % threads));
+    }
+  for (uint32_t i = 0; i < N_NODES; ++i)
+    {
+      Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+      channel->SetAttribute ("Delay", TimeValue (MicroSeconds (LINK_DELAY)));
+      for (uint32_t j = 0; j < 2; ++j)
+        {
+          Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+          device->SetAttribute ("PointToPointMode", BooleanValue (true));
+          device->SetChannel (channel);
+          nodes[(i + j) % N_NODES]->AddDevice (device);
+        }
+    }
+
+  m_nodeRecords.assign (N_NODES, std::vector<Record> ());
+  m_nodeErrors.assign (3 * N_NODES, 0);
+  for (uint32_t i = 0; i < N_NODES; ++i)
+    {
+      for (uint32_t j = 0; j < 4; ++j)
+        {
+          uint64_t ts = MicroSeconds (10 * j + i).GetTimeStep ();
+          Simulator::ScheduleWithContext (i, TimeStep (ts), &ThreadedSimulatorMessages::Receive, this,
+                                          i, i, 4 * i + j, 0, ts);
+        }
+    }
+  if (mode != NO_STOP)
+    {
+      Simulator::ScheduleWithContext (0, MicroSeconds (STOP_TIME), &ThreadedSimulatorMessages::RequestStop, this);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  m_records.clear ();
+  for (uint32_t i = 0; i < N_NODES; ++i)
+    {
+      m_records.insert (m_records.end (), m_nodeRecords[i].begin (), m_nodeRecords[i].end ());
+    }
+  std::sort (m_records.begin (), m_records.end ());
+  m_lateMessages = 0;
+  m_misplacedMessages = 0;
+  m_misnumberedPackets = 0;
+  for (uint32_t i = 0; i < N_NODES; ++i)
+    {
+      m_lateMessages += m_nodeErrors[3 * i];
+      m_misplacedMessages += m_nodeErrors[3 * i + 1];
+      m_misnumberedPackets += m_nodeErrors[3 * i + 2];
+    }
+}
+
+/**
+ * \ingroup mpi-tests
+ * Check that the events scheduled on the nodes of other partitions are
+ * run by these partitions at their time, and that the results do not
+ * depend on the number of threads.
+ */
+class ThreadedSimulatorDeliveryTestCase : public TestCase
+{
+public:
+  ThreadedSimulatorDeliveryTestCase ();
+  virtual ~ThreadedSimulatorDeliveryTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ThreadedSimulatorDeliveryTestCase::ThreadedSimulatorDeliveryTestCase ()
+  : TestCase ("Deliver the events across partitions, whatever the number of threads")
+{
+}
+
+ThreadedSimulatorDeliveryTestCase::~ThreadedSimulatorDeliveryTestCase ()
+{
+}
+
+void
+ThreadedSimulatorDeliveryTestCase::DoRun (void)
+{
+  ThreadedSimulatorMessages reference;
+  reference.Run (1, ThreadedSimulatorMessages::NO_STOP);
+  NS_TEST_ASSERT_MSG_EQ (reference.m_records.size (), 8 * 4 * 101, "Messages lost with a single thread");
+  NS_TEST_ASSERT_MSG_EQ (reference.m_lateMessages, 0, "Messages received at the wrong time");
+
+  uint32_t threads[] = { 2, 3, 4, 8 };
+  for (uint32_t i = 0; i < sizeof (threads) / sizeof (threads[0]); ++i)
+    {
+      for (uint32_t repeat = 0; repeat < 3; ++repeat)
+        {
+          std::ostringstream oss;
+          oss << " with " << threads[i] << " threads";
+          ThreadedSimulatorMessages messages;
+          messages.Run (threads[i], ThreadedSimulatorMessages::NO_STOP);
+          NS_TEST_ASSERT_MSG_EQ (messages.m_lateMessages, 0, "Messages received at the wrong time" << oss.str ());
+          NS_TEST_ASSERT_MSG_EQ (messages.m_misplacedMessages, 0, "Messages received by the wrong partition" << oss.str ());
+          NS_TEST_ASSERT_MSG_EQ (messages.m_misnumberedPackets, 0, "Packet uids of the wrong partition" << oss.str ());
+          NS_TEST_ASSERT_MSG_EQ ((messages.m_records == reference.m_records), true,
+                                 "Messages differ from a single thread" << oss.str ());
+        }
+    }
+}
+
+
+/**
+ * \ingroup mpi-tests
+ * Check that Simulator::Stop, called while the simulation runs, stops
+ * all the partitions at the same time.
+ */
+class ThreadedSimulatorStopTestCase : public TestCase
+{
+public:
+  ThreadedSimulatorStopTestCase ();
+  virtual ~ThreadedSimulatorStopTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ThreadedSimulatorStopTestCase::ThreadedSimulatorStopTestCase ()
+  : TestCase ("Stop all the partitions at the same time")
+{
+}
+
+ThreadedSimulatorStopTestCase::~ThreadedSimulatorStopTestCase ()
+{
+}
+
+void
+ThreadedSimulatorStopTestCase::DoRun (void)
+{
+  ThreadedSimulatorMessages reference;
+  reference.Run (1, ThreadedSimulatorMessages::NO_STOP);
+
+  uint32_t threads[] = { 1, 2, 4 };
+  for (uint32_t i = 0; i < sizeof (threads) / sizeof (threads[0]); ++i)
+    {
+      std::ostringstream oss;
+      oss << " with " << threads[i] << " threads";
+
+      // a delay of at least the lookahead stops at the requested time
+      uint64_t stopTs = MicroSeconds (ThreadedSimulatorMessages::STOP_TIME +
+                                      ThreadedSimulatorMessages::STOP_DELAY).GetTimeStep ();
+      std::vector<ThreadedSimulatorMessages::Record> expected;
+      for (std::size_t j = 0; j < reference.m_records.size (); ++j)
+        {
+          if (reference.m_records[j].ts < stopTs)
+            {
+              expected.push_back (reference.m_records[j]);
+            }
+        }
+      ThreadedSimulatorMessages messages;
+      messages.Run (threads[i], ThreadedSimulatorMessages::STOP_LATER);
+      NS_TEST_ASSERT_MSG_EQ ((messages.m_records == expected), true,
+                             "Not stopped at the requested time" << oss.str ());
+
+      // without delay, the partitions stop at the end of the window
+      messages.Run (threads[i], ThreadedSimulatorMessages::STOP);
+      uint64_t lastTs = 0;
+      for (std::size_t j = 0; j < messages.m_records.size (); ++j)
+        {
+          lastTs = std::max (lastTs, messages.m_records[j].ts);
+        }
+      uint64_t requestTs = MicroSeconds (ThreadedSimulatorMessages::STOP_TIME).GetTimeStep ();
+      uint64_t windowEndTs = MicroSeconds (ThreadedSimulatorMessages::STOP_TIME +
+                                           ThreadedSimulatorMessages::LINK_DELAY).GetTimeStep ();
+      std::size_t beforeRequest = 0;
+      for (std::size_t j = 0; j < reference.m_records.size (); ++j)
+        {
+          if (reference.m_records[j].ts < requestTs)
+            {
+              ++beforeRequest;
+            }
+        }
+      NS_TEST_ASSERT_MSG_GT_OR_EQ (messages.m_records.size (), beforeRequest,
+                                   "Stopped before the request" << oss.str ());
+      NS_TEST_ASSERT_MSG_LT (lastTs, windowEndTs, "Stopped after the end of the window" << oss.str ());
+      expected.clear ();
+      for (std::size_t j = 0; j < reference.m_records.size (); ++j)
+        {
+          if (reference.m_records[j].ts <= lastTs)
+            {
+              expected.push_back (reference.m_records[j]);
+            }
+        }
+      NS_TEST_ASSERT_MSG_EQ ((messages.m_records == expected), true,
+                             "Partitions stopped at different times" << oss.str ());
+
+      ThreadedSimulatorMessages again;
+      again.Run (threads[i], ThreadedSimulatorMessages::STOP);
+      NS_TEST_ASSERT_MSG_EQ ((again.m_records == messages.m_records), true,
+                             "Stop depends on the scheduling of the threads" << oss.str ());
+    }
+}
+
+
+/**
+ * \ingroup mpi-tests
+ * ThreadedSimulatorImpl test suite.
+ */
+class ThreadedSimulatorImplTestSuite : public TestSuite
+{
+public:
+  ThreadedSimulatorImplTestSuite ();
+};
+
+ThreadedSimulatorImplTestSuite::ThreadedSimulatorImplTestSuite ()
+  : TestSuite ("mpi-threaded-simulator", UNIT)
+{
+  AddTestCase (new ThreadedSimulatorDeliveryTestCase, TestCase::QUICK);
+  AddTestCase (new ThreadedSimulatorStopTestCase, TestCase::QUICK);
+}
+
+/** Static variable for test initialization. */
+static ThreadedSimulatorImplTestSuite g_threadedSimulatorImplTestSuite;
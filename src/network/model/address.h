@@ -23,6 +23,7 @@
 
 #include <stdint.h>
 #include <ostream>
+#include <functional>
 #include "ns3/attribute.h"
 #include "ns3/attribute-helper.h"
 #include "ns3/tag-buffer.h"
@@ -283,6 +284,25 @@ bool operator < (const Address &a, const Address &b);
 std::ostream& operator<< (std::ostream& os, const Address & address);
 std::istream& operator>> (std::istream& is, Address & address);
 
+/**
+ * \ingroup address
+ *
+ * \brief Class providing an hash for addresses
+ *
+ * Only the length and the value of the address are hashed: two addresses
+ * which compare equal may have different types, when one of them has a type
+ * of zero.
+ */
+class AddressHash : public std::unary_function<Address, size_t> {
+public:
+  /**
+   * Returns the hash of the address
+   * \param x the address
+   * \return the hash
+   */
+  size_t operator() (Address const &x) const;
+};
+
 
 } // namespace ns3
 
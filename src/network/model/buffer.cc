@@ -20,6 +20,9 @@
 #include "buffer.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #define LOG_INTERNAL_STATE(y)                                                                    \
   NS_LOG_LOGIC (y << "start="<<m_start<<", end="<<m_end<<", zero start="<<m_zeroAreaStart<<              \
@@ -43,6 +46,81 @@ static struct Zeroes
   const uint32_t size;  //!< buffer size
 } g_zeroes; //!< Zero-filled buffer
 
+/**
+ * \ingroup packet
+ * \brief Fold a one's complement sum to 16 bits.
+ * \param sum the sum
+ * \return the folded sum
+ */
+inline uint16_t
+FoldChecksum (uint64_t sum)
+{
+  while (sum >> 16)
+    {
+      sum = (sum & 0xffff) + (sum >> 16);
+    }
+  return sum;
+}
+
+/**
+ * \ingroup packet
+ * \brief Compute the one's complement sum of a contiguous memory area.
+ *
+ * The bytes are summed as the 16-bit words read by
+ * Buffer::Iterator::ReadU16, that is with the first byte of each pair
+ * as the least significant one, and a trailing odd byte is added as
+ * the least significant byte of a last word.  The sum relies on the
+ * byte order independence of the one's complement sum (RFC 1071): the
+ * words are loaded 32 or 128 bits at a time in the host byte order,
+ * and the result is swapped on big endian hosts.
+ *
+ * \param data the memory area
+ * \param size the size of the memory area
+ * \return the folded sum
+ */
+uint16_t
+SumChecksumBytes (const uint8_t *data, uint32_t size)
+{
+  uint64_t sum = 0;
+  uint32_t j = 0;
+#ifdef __SSE2__
+  // two 64-bit lanes, each accumulating 32-bit words, cannot overflow
+  __m128i zero = _mm_setzero_si128 ();
+  __m128i acc = zero;
+  for (; j + 16 <= size; j += 16)
+    {
+      __m128i v = _mm_loadu_si128 (reinterpret_cast<const __m128i *> (data + j));
+      acc = _mm_add_epi64 (acc, _mm_unpacklo_epi32 (v, zero));
+      acc = _mm_add_epi64 (acc, _mm_unpackhi_epi32 (v, zero));
+    }
+  uint64_t lanes[2];
+  _mm_storeu_si128 (reinterpret_cast<__m128i *> (lanes), acc);
+  sum = lanes[0] + lanes[1];
+#endif
+  for (; j + 4 <= size; j += 4)
+    {
+      uint32_t word;
+      std::memcpy (&word, data + j, 4);
+      sum += word;
+    }
+  uint16_t folded = FoldChecksum (sum);
+  const uint16_t one = 1;
+  if (*reinterpret_cast<const uint8_t *> (&one) == 0)
+    {
+      folded = (folded >> 8) | (folded << 8);
+    }
+  sum = folded;
+  for (; j + 2 <= size; j += 2)
+    {
+      sum += data[j] | (data[j + 1] << 8);
+    }
+  if (j < size)
+    {
+      sum += data[j];
+    }
+  return FoldChecksum (sum);
+}
+
 }
 
 namespace ns3 {
@@ -51,6 +129,7 @@ NS_LOG_COMPONENT_DEFINE ("Buffer");
 
 
 uint32_t Buffer::g_recommendedStart = 0;
+bool Buffer::g_threaded = false;
 #ifdef BUFFER_FREE_LIST
 /* The following macros are pretty evil but they are needed to allow us to
  * keep track of 3 possible states for the g_freeList variable:
@@ -99,6 +178,11 @@ Buffer::Recycle (struct Buffer::Data *data)
 {
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
+  if (g_threaded)
+    {
+      Buffer::Deallocate (data);
+      return;
+    }
   NS_ASSERT (!IS_UNINITIALIZED (g_freeList));
   g_maxSize = std::max (g_maxSize, data->m_size);
   /* feed into free list */
@@ -120,6 +204,10 @@ Buffer::Create (uint32_t dataSize)
 {
   NS_LOG_FUNCTION (dataSize);
   /* try to find a buffer correctly sized. */
+  if (g_threaded)
+    {
+      return Buffer::Allocate (dataSize);
+    }
   if (IS_UNINITIALIZED (g_freeList))
     {
       g_freeList = new Buffer::FreeList ();
@@ -185,6 +273,13 @@ Buffer::Deallocate (struct Buffer::Data *data)
   delete [] buf;
 }
 
+void
+Buffer::SetThreaded (bool threaded)
+{
+  NS_LOG_FUNCTION (threaded);
+  g_threaded = threaded;
+}
+
 Buffer::Buffer ()
 {
   NS_LOG_FUNCTION (this);
@@ -270,7 +365,10 @@ Buffer::operator = (Buffer const&o)
       m_data = o.m_data;
       m_data->m_count++;
     }
-  g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
+  if (!g_threaded)
+    {
+      g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
+    }
   m_maxZeroAreaStart = o.m_maxZeroAreaStart;
   m_zeroAreaStart = o.m_zeroAreaStart;
   m_zeroAreaEnd = o.m_zeroAreaEnd;
@@ -284,7 +382,10 @@ Buffer::~Buffer ()
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (CheckInternalState ());
-  g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
+  if (!g_threaded)
+    {
+      g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
+    }
   m_data->m_count--;
   if (m_data->m_count == 0) 
     {
@@ -530,6 +631,25 @@ Buffer::CreateFragment (uint32_t start, uint32_t length) const
   return tmp;
 }
 
+Buffer
+Buffer::DeepCopy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (CheckInternalState ());
+  Buffer tmp (0, false);
+  tmp.m_data = Buffer::Create (m_data->m_size);
+  memcpy (tmp.m_data->m_data + m_start, m_data->m_data + m_start, GetInternalSize ());
+  tmp.m_maxZeroAreaStart = m_zeroAreaStart;
+  tmp.m_zeroAreaStart = m_zeroAreaStart;
+  tmp.m_zeroAreaEnd = m_zeroAreaEnd;
+  tmp.m_start = m_start;
+  tmp.m_end = m_end;
+  tmp.m_data->m_dirtyStart = m_start;
+  tmp.m_data->m_dirtyEnd = m_end;
+  NS_ASSERT (tmp.CheckInternalState ());
+  return tmp;
+}
+
 Buffer 
 Buffer::CreateFullCopy (void) const
 {
@@ -1144,17 +1264,47 @@ Buffer::Iterator::CalculateIpChecksum (uint16_t size, uint32_t initialChecksum)
 {
   NS_LOG_FUNCTION (this << size << initialChecksum);
   /* see RFC 1071 to understand this code. */
-  uint32_t sum = initialChecksum;
-
-  for (int j = 0; j < size/2; j++)
-    sum += ReadU16 ();
-
-  if (size & 1)
-    sum += ReadU8 ();
+  NS_ASSERT_MSG (m_current + size <= m_dataEnd, GetReadErrorMessage ());
+  uint64_t sum = initialChecksum;
+  uint32_t start = m_current;
+  uint32_t end = m_current + size;
+
+  // Sum the data before and after the zero area separately.  The zero
+  // area adds nothing, but a segment which starts at an odd offset from
+  // the start of the sum has its bytes swapped.
+  if (m_current < m_zeroStart)
+    {
+      uint32_t segmentEnd = std::min (end, m_zeroStart);
+      sum += SumChecksumBytes (&m_data[m_current], segmentEnd - m_current);
+      m_current = segmentEnd;
+    }
+  if (m_current < end && m_current < m_zeroEnd)
+    {
+      m_current = std::min (end, m_zeroEnd);
+    }
+  if (m_current < end)
+    {
+      uint16_t segment = SumChecksumBytes (&m_data[m_current - (m_zeroEnd - m_zeroStart)],
+                                           end - m_current);
+      if ((m_current - start) & 1)
+        {
+          segment = (segment >> 8) | (segment << 8);
+        }
+      sum += segment;
+      m_current = end;
+    }
+  return ~FoldChecksum (sum);
+}
 
-  while (sum >> 16)
-    sum = (sum & 0xffff) + (sum >> 16);
-  return ~sum;
+uint16_t
+Buffer::Iterator::UpdateIpChecksum (uint16_t checksum, uint16_t oldWord, uint16_t newWord)
+{
+  NS_LOG_FUNCTION (checksum << oldWord << newWord);
+  /* RFC 1624, eqn. 3: HC' = ~(~HC + ~m + m') */
+  uint32_t sum = static_cast<uint16_t> (~checksum);
+  sum += static_cast<uint16_t> (~oldWord);
+  sum += newWord;
+  return ~FoldChecksum (sum);
 }
 
 uint32_t 
@@ -365,12 +365,30 @@ public:
 
     /**
      * \brief Calculate the checksum.
+     *
+     * The data is summed a memory block at a time rather than a 16-bit
+     * word at a time, with SSE2 instructions when they are available.
+     *
      * \param size size of the buffer.
      * \param initialChecksum initial value
      * \return checksum
      */
     uint16_t CalculateIpChecksum (uint16_t size, uint32_t initialChecksum);
 
+    /**
+     * \brief Update a checksum after a change of one of the 16-bit words
+     * it covers (RFC 1624).
+     *
+     * The words are in the byte order of ReadU16 and WriteU16, which is
+     * the byte order of the checksums returned by CalculateIpChecksum.
+     *
+     * \param checksum the checksum before the change
+     * \param oldWord the word before the change
+     * \param newWord the word after the change
+     * \return the checksum after the change
+     */
+    static uint16_t UpdateIpChecksum (uint16_t checksum, uint16_t oldWord, uint16_t newWord);
+
     /**
      * \returns the size of the underlying buffer we are iterating
      */
@@ -554,6 +572,17 @@ private:
    */
   Buffer CreateFragment (uint32_t start, uint32_t length) const;
 
+  /**
+   * \brief Create a copy of the buffer which shares no data with it.
+   *
+   * Unlike the copy constructor, the bytes are copied into a new
+   * internal buffer, so the copy can be handed to another thread
+   * while this buffer is still used.  The zero area is kept virtual.
+   *
+   * \returns a copy of the buffer
+   */
+  Buffer DeepCopy (void) const;
+
   /**
    * \return an Iterator which points to the
    * start of this Buffer.
@@ -641,6 +670,18 @@ private:
    */
   Buffer (uint32_t dataSize, bool initialize);
   ~Buffer ();
+
+  /**
+   * \brief Set whether the buffers are used by several threads
+   *
+   * While set, the buffer data is allocated from and released to the
+   * heap rather than the free list, and the heuristic which places the
+   * zero area of new buffers is no longer updated, so that the threads
+   * share no state.  Must not be called while other threads use buffers.
+   *
+   * \param threaded true if the buffers are used by several threads
+   */
+  static void SetThreaded (bool threaded);
 private:
   /**
    * This data structure is variable-sized through its last member whose size
@@ -768,6 +809,12 @@ private:
    */
   static uint32_t g_recommendedStart;
 
+  /**
+   * Whether the buffers are used by several threads.
+   * \see SetThreaded
+   */
+  static bool g_threaded;
+
   /**
    * offset to the start of the virtual zero area from the start
    * of m_data->m_data
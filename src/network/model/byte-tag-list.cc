@@ -45,6 +45,12 @@ struct ByteTagListData {
   uint8_t data[4]; //!< data
 };
 
+/**
+ * Whether the tag lists are used by several threads.
+ * \see ByteTagList::SetThreaded
+ */
+static bool g_threaded = false;
+
 #ifdef USE_FREE_LIST
 /**
  * \ingroup packet
@@ -251,6 +257,24 @@ ByteTagList::RemoveAll (void)
   m_used = 0;
 }
 
+ByteTagList
+ByteTagList::DeepCopy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  ByteTagList copy;
+  copy.m_minStart = m_minStart;
+  copy.m_maxEnd = m_maxEnd;
+  copy.m_adjustment = m_adjustment;
+  if (m_data != 0)
+    {
+      copy.m_data = copy.Allocate (m_used);
+      std::memcpy (&copy.m_data->data, &m_data->data, m_used);
+      copy.m_data->dirty = m_used;
+      copy.m_used = m_used;
+    }
+  return copy;
+}
+
 ByteTagList::Iterator 
 ByteTagList::BeginAll (void) const
 {
@@ -345,7 +369,7 @@ struct ByteTagListData *
 ByteTagList::Allocate (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
-  while (!g_freeList.empty ())
+  while (!g_threaded && !g_freeList.empty ())
     {
       struct ByteTagListData *data = g_freeList.back ();
       g_freeList.pop_back ();
@@ -375,11 +399,15 @@ ByteTagList::Deallocate (struct ByteTagListData *data)
     {
       return;
     }
-  g_maxSize = std::max (g_maxSize, data->size);
+  if (!g_threaded)
+    {
+      g_maxSize = std::max (g_maxSize, data->size);
+    }
   data->count--;
   if (data->count == 0)
     {
-      if (g_freeList.size () > FREE_LIST_SIZE ||
+      if (g_threaded ||
+          g_freeList.size () > FREE_LIST_SIZE ||
           data->size < g_maxSize)
         {
           uint8_t *buffer = (uint8_t *)data;
@@ -424,5 +452,11 @@ ByteTagList::Deallocate (struct ByteTagListData *data)
 
 #endif /* USE_FREE_LIST */
 
+void
+ByteTagList::SetThreaded (bool threaded)
+{
+  NS_LOG_FUNCTION (threaded);
+  g_threaded = threaded;
+}
 
 } // namespace ns3
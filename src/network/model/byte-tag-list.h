@@ -188,6 +188,13 @@ private:
    */ 
   void RemoveAll (void);
 
+  /**
+   * \brief Create a copy of the list which shares no data with it.
+   *
+   * \returns a copy of the list, with its own tag byte buffer
+   */
+  ByteTagList DeepCopy (void) const;
+
   /**
    * \param offsetStart the offset which uniquely identifies the first data byte 
    *        present in the byte buffer associated to this ByteTagList.
@@ -225,6 +232,17 @@ private:
    */
   void AddAtStart (int32_t prependOffset);
 
+  /**
+   * \brief Set whether the tag lists are used by several threads
+   *
+   * While set, the tag data is allocated from and released to the heap
+   * rather than the free list.  Must not be called while other threads
+   * use tag lists.
+   *
+   * \param threaded true if the tag lists are used by several threads
+   */
+  static void SetThreaded (bool threaded);
+
 private:
   /**
    * \brief Returns an iterator pointing to the very first tag in this list.
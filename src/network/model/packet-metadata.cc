@@ -17,6 +17,7 @@
  *
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
+#include <algorithm>
 #include <utility>
 #include <list>
 #include "ns3/assert.h"
@@ -33,6 +34,7 @@ NS_LOG_COMPONENT_DEFINE ("PacketMetadata");
 
 bool PacketMetadata::m_enable = false;
 bool PacketMetadata::m_enableChecking = false;
+bool PacketMetadata::m_threaded = false;
 bool PacketMetadata::m_metadataSkipped = false;
 uint32_t PacketMetadata::m_maxSize = 0;
 uint16_t PacketMetadata::m_chunkUid = 0;
@@ -70,6 +72,13 @@ PacketMetadata::EnableChecking (void)
   m_enableChecking = true;
 }
 
+void
+PacketMetadata::SetThreaded (bool threaded)
+{
+  NS_LOG_FUNCTION (threaded);
+  m_threaded = threaded;
+}
+
 void
 PacketMetadata::ReserveCopy (uint32_t size)
 {
@@ -571,6 +580,10 @@ PacketMetadata::Create (uint32_t size)
 {
   NS_LOG_FUNCTION (size);
   NS_LOG_LOGIC ("create size="<<size<<", max="<<m_maxSize);
+  if (m_threaded)
+    {
+      return PacketMetadata::Allocate (std::max (size, m_maxSize));
+    }
   if (size > m_maxSize)
     {
       m_maxSize = size;
@@ -596,7 +609,7 @@ void
 PacketMetadata::Recycle (struct PacketMetadata::Data *data)
 {
   NS_LOG_FUNCTION (data);
-  if (!m_enable)
+  if (!m_enable || m_threaded)
     {
       PacketMetadata::Deallocate (data);
       return;
@@ -650,6 +663,20 @@ PacketMetadata::CreateFragment (uint32_t start, uint32_t end) const
   return fragment;
 }
 
+PacketMetadata
+PacketMetadata::DeepCopy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  PacketMetadata copy = *this;
+  struct PacketMetadata::Data *data = PacketMetadata::Create (m_used);
+  memcpy (data->m_data, m_data->m_data, m_used);
+  data->m_dirtyEnd = m_used;
+  // this object still holds a reference to the shared data.
+  copy.m_data->m_count--;
+  copy.m_data = data;
+  return copy;
+}
+
 void 
 PacketMetadata::AddHeader (const Header &header, uint32_t size)
 {
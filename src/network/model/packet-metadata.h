@@ -159,6 +159,16 @@ private:
    * \brief Enable the packet metadata checking
    */
   static void EnableChecking (void);
+  /**
+   * \brief Set whether the metadata is used by several threads
+   *
+   * While set, the metadata storage is allocated from and released to
+   * the heap rather than the free list.  Must not be called while
+   * other threads use packets.
+   *
+   * \param threaded true if the metadata is used by several threads
+   */
+  static void SetThreaded (bool threaded);
 
   /**
    * \brief Constructor
@@ -179,6 +189,12 @@ private:
   inline PacketMetadata &operator = (PacketMetadata const& o);
   inline ~PacketMetadata ();
 
+  /**
+   * \brief Create a copy of the metadata which shares no data with it
+   * \return a copy which owns its metadata storage
+   */
+  PacketMetadata DeepCopy (void) const;
+
   /**
    * \brief Add an header
    * \param header header to add
@@ -659,6 +675,7 @@ public:
   static DataFreeList m_freeList; //!< the metadata data storage
   static bool m_enable; //!< Enable the packet metadata
   static bool m_enableChecking; //!< Enable the packet metadata checking
+  static bool m_threaded; //!< Whether the metadata is used by several threads
 
   /**
    * Set to true when adding metadata to a packet is skipped because
@@ -300,5 +300,24 @@ PacketTagList::Head (void) const
   return m_next;
 }
 
+PacketTagList
+PacketTagList::DeepCopy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  PacketTagList copy;
+  struct TagData **prevNext = &copy.m_next;
+  for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
+    {
+      struct TagData * tag = CreateTagData (cur->size);
+      tag->tid = cur->tid;
+      tag->count = 1;
+      tag->next = 0;
+      memcpy (tag->data, cur->data, tag->size);
+      *prevNext = tag;
+      prevNext = &tag->next;
+    }
+  return copy;
+}
+
 } /* namespace ns3 */
 
@@ -217,6 +217,12 @@ public:
    * \returns pointer to head of tag list
    */
   const struct PacketTagList::TagData *Head (void) const;
+  /**
+   * Create a copy of the list which shares no TagData with it.
+   *
+   * \returns a copy of the list
+   */
+  PacketTagList DeepCopy (void) const;
 
 private:
   /**
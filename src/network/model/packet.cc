@@ -23,6 +23,7 @@
 #include "ns3/simulator.h"
 #include <string>
 #include <cstdarg>
+#include <vector>
 
 namespace ns3 {
 
@@ -30,6 +31,16 @@ NS_LOG_COMPONENT_DEFINE ("Packet");
 
 uint32_t Packet::m_globalUid = 0;
 
+/** Whether several threads use packets. */
+static bool g_threaded = false;
+/**
+ * The uid counters of the system ids while several threads use packets,
+ * each on its own cache line.
+ */
+static std::vector<uint32_t> g_threadUids;
+/** The distance between the uid counters of two system ids. */
+static const uint32_t UID_STRIDE = 64 / sizeof (uint32_t);
+
 TypeId 
 ByteTagIterator::Item::GetTypeId (void) const
 {
@@ -126,20 +137,39 @@ Packet::Copy (void) const
   return Ptr<Packet> (new Packet (*this), false);
 }
 
+Ptr<Packet>
+Packet::DeepCopy (void) const
+{
+  Ptr<Packet> copy = Ptr<Packet> (new Packet (m_buffer.DeepCopy (),
+                                              m_byteTagList.DeepCopy (),
+                                              m_packetTagList.DeepCopy (),
+                                              m_metadata.DeepCopy ()), false);
+  if (m_nixVector)
+    {
+      copy->m_nixVector = m_nixVector->Copy ();
+    }
+  return copy;
+}
+
+uint64_t
+Packet::AllocateUid (void)
+{
+  uint64_t systemId = Simulator::GetSystemId ();
+  if (!g_threaded)
+    {
+      return systemId << 32 | m_globalUid++;
+    }
+  NS_ASSERT (systemId * UID_STRIDE < g_threadUids.size ());
+  return systemId << 32 | g_threadUids[systemId * UID_STRIDE]++;
+}
+
 Packet::Packet ()
   : m_buffer (),
     m_byteTagList (),
     m_packetTagList (),
-    /* The upper 32 bits of the packet id in 
-     * metadata is for the system id. For non-
-     * distributed simulations, this is simply 
-     * zero.  The lower 32 bits are for the 
-     * global UID
-     */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, 0),
+    m_metadata (AllocateUid (), 0),
     m_nixVector (0)
 {
-  m_globalUid++;
 }
 
 Packet::Packet (const Packet &o)
@@ -172,16 +202,9 @@ Packet::Packet (uint32_t size)
   : m_buffer (size),
     m_byteTagList (),
     m_packetTagList (),
-    /* The upper 32 bits of the packet id in 
-     * metadata is for the system id. For non-
-     * distributed simulations, this is simply 
-     * zero.  The lower 32 bits are for the 
-     * global UID
-     */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
+    m_metadata (AllocateUid (), size),
     m_nixVector (0)
 {
-  m_globalUid++;
 }
 Packet::Packet (uint8_t const *buffer, uint32_t size, bool magic)
   : m_buffer (0, false),
@@ -198,16 +221,9 @@ Packet::Packet (uint8_t const*buffer, uint32_t size)
   : m_buffer (),
     m_byteTagList (),
     m_packetTagList (),
-    /* The upper 32 bits of the packet id in 
-     * metadata is for the system id. For non-
-     * distributed simulations, this is simply 
-     * zero.  The lower 32 bits are for the 
-     * global UID
-     */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
+    m_metadata (AllocateUid (), size),
     m_nixVector (0)
 {
-  m_globalUid++;
   m_buffer.AddAtStart (size);
   Buffer::Iterator i = m_buffer.Begin ();
   i.Write (buffer, size);
@@ -544,6 +560,36 @@ Packet::EnableChecking (void)
   PacketMetadata::EnableChecking ();
 }
 
+void
+Packet::EnableThreads (uint32_t threads)
+{
+  NS_LOG_FUNCTION (threads);
+  NS_ASSERT (!g_threaded && threads > 0);
+  // the counters of the other system ids are kept from the previous
+  // runs, so that their uids stay unique
+  if (g_threadUids.size () < threads * UID_STRIDE)
+    {
+      g_threadUids.resize (threads * UID_STRIDE, 0);
+    }
+  g_threadUids[0] = m_globalUid;
+  g_threaded = true;
+  Buffer::SetThreaded (true);
+  ByteTagList::SetThreaded (true);
+  PacketMetadata::SetThreaded (true);
+}
+
+void
+Packet::DisableThreads (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  NS_ASSERT (g_threaded);
+  m_globalUid = g_threadUids[0];
+  g_threaded = false;
+  Buffer::SetThreaded (false);
+  ByteTagList::SetThreaded (false);
+  PacketMetadata::SetThreaded (false);
+}
+
 uint32_t Packet::GetSerializedSize (void) const
 {
   uint32_t size = 0;
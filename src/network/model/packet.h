@@ -424,6 +424,18 @@ public:
    */
   Ptr<Packet> Copy (void) const;
 
+  /**
+   * \brief performs a deep copy of the packet.
+   *
+   * \returns a copy of the packet which shares no data with it.
+   *
+   * The bytes, the tags, the metadata and the nix-vector of the
+   * packet are copied, so the copy can be handed to another thread
+   * while the original packet is still used by this one, even though
+   * the reference counts of the packet data are not atomic.
+   */
+  Ptr<Packet> DeepCopy (void) const;
+
   /**
    * \brief Returns the packet's Uid.
    *
@@ -501,6 +513,24 @@ public:
    * errors will be detected and will abort the program.
    */
   static void EnableChecking (void);
+  /**
+   * \brief Prepare the packets to be used by several threads.
+   *
+   * Until DisableThreads is called, the packet storage bypasses its
+   * free lists and each system id has its own counter of packet uids,
+   * so that threads with distinct system ids share no state through
+   * the packets they create.  The system ids must be smaller than
+   * \p threads.  Must be called before the other threads start.
+   *
+   * \param [in] threads the number of threads.
+   */
+  static void EnableThreads (uint32_t threads);
+  /**
+   * \brief Go back to packets used by a single thread.
+   *
+   * Must be called once the other threads have stopped.
+   */
+  static void DisableThreads (void);
 
   /**
    * \brief Returns number of bytes required for packet
@@ -719,6 +749,17 @@ private:
    */
   uint32_t Deserialize (uint8_t const*buffer, uint32_t size);
 
+  /**
+   * \brief Allocate the uid of a new packet.
+   *
+   * The upper 32 bits of the packet id in metadata is for the system
+   * id.  For non-distributed simulations, this is simply zero.  The
+   * lower 32 bits are for the global UID.
+   *
+   * \returns the packet uid.
+   */
+  static uint64_t AllocateUid (void);
+
   Buffer m_buffer;                //!< the packet buffer (it's actual contents)
   ByteTagList m_byteTagList;      //!< the ByteTag list
   PacketTagList m_packetTagList;  //!< the packet's Tag list
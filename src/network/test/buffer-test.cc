@@ -361,6 +361,106 @@ BufferTest::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (val1, val2, "Bad ReadNtohU16()");
 }
 //-----------------------------------------------------------------------------
+/**
+ * Check the checksum of buffers with a zero area against a word by word
+ * reference, for all the parities of the start, zero area and end.
+ */
+class BufferChecksumTest : public TestCase {
+private:
+  /**
+   * Compute the checksum of a buffer area one byte at a time.
+   * \param i the start of the area
+   * \param size the size of the area
+   * \return the checksum
+   */
+  uint16_t ReferenceChecksum (Buffer::Iterator i, uint32_t size);
+public:
+  virtual void DoRun (void);
+  BufferChecksumTest ();
+};
+
+BufferChecksumTest::BufferChecksumTest ()
+  : TestCase ("Buffer checksum") {
+}
+
+uint16_t
+BufferChecksumTest::ReferenceChecksum (Buffer::Iterator i, uint32_t size)
+{
+  uint32_t sum = 0;
+  for (uint32_t j = 0; j < size; j++)
+    {
+      uint32_t byte = i.ReadU8 ();
+      sum += (j & 1) ? (byte << 8) : byte;
+    }
+  while (sum >> 16)
+    {
+      sum = (sum & 0xffff) + (sum >> 16);
+    }
+  return ~sum;
+}
+
+void
+BufferChecksumTest::DoRun (void)
+{
+  for (uint32_t zeroes = 0; zeroes < 4; zeroes++)
+    {
+      for (uint32_t head = 0; head < 40; head += 13)
+        {
+          for (uint32_t tail = 0; tail < 70; tail += 23)
+            {
+              // the zero area lies between the head and the tail
+              Buffer buffer (zeroes);
+              buffer.AddAtStart (head);
+              buffer.AddAtEnd (tail);
+              Buffer::Iterator i = buffer.Begin ();
+              for (uint32_t j = 0; j < head; j++)
+                {
+                  i.WriteU8 (0xf0 + j);
+                }
+              i.Next (zeroes);
+              for (uint32_t j = 0; j < tail; j++)
+                {
+                  i.WriteU8 (0xff - 3 * j);
+                }
+              for (uint32_t offset = 0; offset < 3 && offset <= buffer.GetSize (); offset++)
+                {
+                  uint32_t size = buffer.GetSize () - offset;
+                  Buffer::Iterator start = buffer.Begin ();
+                  start.Next (offset);
+                  Buffer::Iterator it = start;
+                  uint16_t checksum = it.CalculateIpChecksum (size);
+                  NS_TEST_EXPECT_MSG_EQ (checksum, ReferenceChecksum (start, size),
+                                         "Bad checksum with head=" << head << " zeroes=" << zeroes <<
+                                         " tail=" << tail << " offset=" << offset);
+                  NS_TEST_EXPECT_MSG_EQ (it.IsEnd (), true, "The iterator should be at the end");
+                }
+            }
+        }
+    }
+
+  // incremental update of a 16-bit word
+  Buffer buffer (0);
+  buffer.AddAtStart (20);
+  Buffer::Iterator i = buffer.Begin ();
+  for (uint32_t j = 0; j < 20; j++)
+    {
+      i.WriteU8 (0x80 + 7 * j);
+    }
+  i = buffer.Begin ();
+  uint16_t checksum = i.CalculateIpChecksum (20);
+  for (uint32_t word = 0; word < 0x10000; word += 0x3fff)
+    {
+      i = buffer.Begin ();
+      i.Next (8);
+      uint16_t old = i.ReadU16 ();
+      i.Prev (2);
+      i.WriteU16 (word);
+      checksum = Buffer::Iterator::UpdateIpChecksum (checksum, old, word);
+      i = buffer.Begin ();
+      NS_TEST_EXPECT_MSG_EQ (checksum, i.CalculateIpChecksum (20), "Bad incremental checksum");
+    }
+}
+//-----------------------------------------------------------------------------
 class BufferTestSuite : public TestSuite
 {
 public:
@@ -371,6 +471,7 @@ BufferTestSuite::BufferTestSuite ()
   : TestSuite ("buffer", UNIT)
 {
   AddTestCase (new BufferTest, TestCase::QUICK);
+  AddTestCase (new BufferChecksumTest, TestCase::QUICK);
 }
 
 static BufferTestSuite g_bufferTestSuite;
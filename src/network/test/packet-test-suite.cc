@@ -23,6 +23,7 @@
 #include "ns3/unused.h"
 #include <limits>     // std:numeric_limits
 #include <string>
+#include <cstring>
 #include <cstdarg>
 #include <iostream>
 #include <iomanip>
@@ -640,6 +641,31 @@ PacketTest::DoRun (void)
     CHECK (tmp, 1, E (25, 0, 50));
   }
 
+  /* Test DeepCopy, which shares no data with the original packet */
+  {
+    Ptr<Packet> tmp = Create<Packet> (100);
+    tmp->AddHeader (ATestHeader<10> ());
+    tmp->AddByteTag (ATestTag<25> ());
+    tmp->AddPacketTag (ATestTag<5> ());
+    Ptr<Packet> copy = tmp->DeepCopy ();
+    CHECK (copy, 1, E (25, 0, 110));
+    NS_TEST_EXPECT_MSG_EQ (copy->GetUid (), tmp->GetUid (), "DeepCopy changed the uid");
+    ATestTag<5> tag;
+    NS_TEST_EXPECT_MSG_EQ (copy->PeekPacketTag (tag), true, "DeepCopy lost the packet tag");
+    uint8_t original[110];
+    uint8_t copied[110];
+    tmp->CopyData (original, 110);
+    copy->CopyData (copied, 110);
+    NS_TEST_EXPECT_MSG_EQ (copy->GetSize (), 110, "DeepCopy changed the size");
+    NS_TEST_EXPECT_MSG_EQ (memcmp (original, copied, 110), 0, "DeepCopy changed the bytes");
+    ATestHeader<10> header;
+    copy->RemoveHeader (header);
+    NS_TEST_EXPECT_MSG_EQ (header.m_error, false, "DeepCopy corrupted the header");
+    copy->RemovePacketTag (tag);
+    CHECK (tmp, 1, E (25, 0, 110));
+    NS_TEST_EXPECT_MSG_EQ (tmp->PeekPacketTag (tag), true, "The original packet lost its tag");
+  }
+
   /* Test ALargeTestTag */
   {
     Ptr<Packet> tmp = Create<Packet> (0);
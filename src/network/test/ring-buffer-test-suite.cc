@@ -0,0 +1,214 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/ring-buffer.h"
+#include "ns3/drop-tail-queue.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Check the FIFO order of a RingBuffer while it wraps around and grows.
+ */
+class RingBufferFifoTestCase : public TestCase
+{
+public:
+  RingBufferFifoTestCase ();
+  virtual void DoRun (void);
+};
+
+RingBufferFifoTestCase::RingBufferFifoTestCase ()
+  : TestCase ("Check the FIFO order across wrap-around and growth")
+{
+}
+
+void
+RingBufferFifoTestCase::DoRun (void)
+{
+  RingBuffer<uint32_t> rb;
+  NS_TEST_EXPECT_MSG_EQ (rb.IsEmpty (), true, "A new ring buffer should be empty");
+  NS_TEST_EXPECT_MSG_EQ (rb.GetCapacity (), 0, "A new ring buffer should not allocate");
+
+  // keep 5 items in the buffer, so that the head wraps around many times
+  uint32_t next = 0;
+  uint32_t expected = 0;
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      rb.PushBack (next++);
+    }
+  uint32_t capacity = rb.GetCapacity ();
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      rb.PushBack (next++);
+      NS_TEST_EXPECT_MSG_EQ (rb.Front (), expected, "Unexpected head of the buffer");
+      rb.PopFront ();
+      expected++;
+    }
+  NS_TEST_EXPECT_MSG_EQ (rb.GetCapacity (), capacity, "The buffer should not grow at steady occupancy");
+  NS_TEST_EXPECT_MSG_EQ (rb.GetSize (), 5, "Unexpected number of items");
+
+  // grow while wrapped, and check that iterators survive
+  RingBuffer<uint32_t>::ConstIterator first = rb.Begin ();
+  for (uint32_t i = 0; i < 50; i++)
+    {
+      rb.PushBack (next++);
+    }
+  NS_TEST_EXPECT_MSG_GT (rb.GetCapacity (), capacity, "The buffer should have grown");
+  NS_TEST_EXPECT_MSG_EQ (*first, expected, "The iterator should survive the growth");
+  NS_TEST_EXPECT_MSG_EQ (rb.Back (), next - 1, "Unexpected tail of the buffer");
+  for (RingBuffer<uint32_t>::ConstIterator it = rb.Begin (); it != rb.End (); it++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (*it, expected, "Unexpected item");
+      expected++;
+    }
+  NS_TEST_EXPECT_MSG_EQ (expected, next, "Some items are missing");
+
+  rb.PushFront (1000);
+  NS_TEST_EXPECT_MSG_EQ (rb.Front (), 1000, "The item should have been prepended");
+  rb.Clear ();
+  NS_TEST_EXPECT_MSG_EQ (rb.IsEmpty (), true, "The buffer should be empty");
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Check insertion and removal in the middle of a RingBuffer, and the
+ * validity of the iterators to the following items.
+ */
+class RingBufferInsertEraseTestCase : public TestCase
+{
+public:
+  RingBufferInsertEraseTestCase ();
+  virtual void DoRun (void);
+};
+
+RingBufferInsertEraseTestCase::RingBufferInsertEraseTestCase ()
+  : TestCase ("Check insertion and removal at arbitrary positions")
+{
+}
+
+void
+RingBufferInsertEraseTestCase::DoRun (void)
+{
+  RingBuffer<uint32_t> rb;
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      rb.PushBack (i);
+    }
+
+  // remove the odd items while browsing the buffer
+  for (RingBuffer<uint32_t>::ConstIterator it = rb.Begin (); it != rb.End (); )
+    {
+      if (*it % 2)
+        {
+          RingBuffer<uint32_t>::ConstIterator curr = it++;
+          RingBuffer<uint32_t>::ConstIterator ret = rb.Erase (curr);
+          NS_TEST_EXPECT_MSG_EQ ((ret == it), true, "Erase should return the following item");
+        }
+      else
+        {
+          it++;
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (rb.GetSize (), 5, "Unexpected number of items");
+  uint32_t expected = 0;
+  for (RingBuffer<uint32_t>::ConstIterator it = rb.Begin (); it != rb.End (); it++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (*it, expected, "Unexpected item");
+      expected += 2;
+    }
+
+  // insert 5 before 6, and check that the iterator to 6 is still valid
+  RingBuffer<uint32_t>::ConstIterator six = rb.Begin ();
+  while (*six != 6)
+    {
+      six++;
+    }
+  RingBuffer<uint32_t>::ConstIterator five = rb.Insert (six, 5);
+  NS_TEST_EXPECT_MSG_EQ (*five, 5, "Insert should return the new item");
+  NS_TEST_EXPECT_MSG_EQ (*six, 6, "The iterator to the following item should be valid");
+  five--;
+  NS_TEST_EXPECT_MSG_EQ (*five, 4, "Unexpected item before the inserted one");
+
+  rb.Insert (rb.End (), 10);
+  rb.Insert (rb.Begin (), 1000);
+  uint32_t items[] = { 1000, 0, 2, 4, 5, 6, 8, 10 };
+  uint32_t i = 0;
+  for (RingBuffer<uint32_t>::ConstIterator it = rb.Begin (); it != rb.End (); it++, i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (*it, items[i], "Unexpected item");
+    }
+  NS_TEST_EXPECT_MSG_EQ (i, 8, "Unexpected number of items");
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Check that a queue with preallocated storage releases the removed items.
+ */
+class RingBufferQueuePreallocateTestCase : public TestCase
+{
+public:
+  RingBufferQueuePreallocateTestCase ();
+  virtual void DoRun (void);
+};
+
+RingBufferQueuePreallocateTestCase::RingBufferQueuePreallocateTestCase ()
+  : TestCase ("Check that packets released by a queue are not held by its storage")
+{
+}
+
+void
+RingBufferQueuePreallocateTestCase::DoRun (void)
+{
+  Ptr<DropTailQueue<Packet> > queue = CreateObject<DropTailQueue<Packet> > ();
+  queue->SetAttribute ("MaxPackets", UintegerValue (1000));
+  queue->SetAttribute ("Preallocate", BooleanValue (true));
+
+  Ptr<Packet> p = Create<Packet> (100);
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (p), true, "The packet should be enqueued");
+    }
+  NS_TEST_EXPECT_MSG_EQ (p->GetReferenceCount (), 1001, "The queue should hold 1000 references");
+  queue->Flush ();
+  NS_TEST_EXPECT_MSG_EQ (p->GetReferenceCount (), 1, "The queue should hold no reference");
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * RingBuffer TestSuite
+ */
+static class RingBufferTestSuite : public TestSuite
+{
+public:
+  RingBufferTestSuite ()
+    : TestSuite ("ring-buffer", UNIT)
+  {
+    AddTestCase (new RingBufferFifoTestCase (), TestCase::QUICK);
+    AddTestCase (new RingBufferInsertEraseTestCase (), TestCase::QUICK);
+    AddTestCase (new RingBufferQueuePreallocateTestCase (), TestCase::QUICK);
+  }
+} g_ringBufferTestSuite;
@@ -166,7 +166,8 @@ TypeId NetDeviceQueueInterface::GetTypeId (void)
 
 NetDeviceQueueInterface::NetDeviceQueueInterface ()
   : m_numTxQueues (1),
-    m_lateTxQueuesCreation (false)
+    m_lateTxQueuesCreation (false),
+    m_segmentationOffload (false)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -194,6 +195,7 @@ NetDeviceQueueInterface::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
   m_txQueuesVector.clear ();
+  m_segmentationCallbacks.clear ();
   Object::DoDispose ();
 }
 
@@ -249,4 +251,36 @@ NetDeviceQueueInterface::GetSelectQueueCallback (void) const
   return m_selectQueueCallback;
 }
 
+void
+NetDeviceQueueInterface::SetSegmentationOffload (bool offload)
+{
+  NS_LOG_FUNCTION (this << offload);
+  m_segmentationOffload = offload;
+}
+
+bool
+NetDeviceQueueInterface::GetSegmentationOffload (void) const
+{
+  return m_segmentationOffload;
+}
+
+void
+NetDeviceQueueInterface::SetSegmentationCallback (uint16_t protocol, SegmentationCallback cb)
+{
+  NS_LOG_FUNCTION (this << protocol);
+  m_segmentationCallbacks[protocol] = cb;
+}
+
+std::list<Ptr<Packet> >
+NetDeviceQueueInterface::Segment (uint16_t protocol, Ptr<Packet> packet) const
+{
+  NS_LOG_FUNCTION (this << protocol << packet);
+  std::map<uint16_t, SegmentationCallback>::const_iterator it = m_segmentationCallbacks.find (protocol);
+  if (it == m_segmentationCallbacks.end () || it->second.IsNull ())
+    {
+      return std::list<Ptr<Packet> > ();
+    }
+  return it->second (packet);
+}
+
 } // namespace ns3
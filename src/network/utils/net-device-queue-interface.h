@@ -21,6 +21,8 @@
 #define NET_DEVICE_QUEUE_INTERFACE_H
 
 #include <vector>
+#include <list>
+#include <map>
 #include "ns3/callback.h"
 #include "ns3/object.h"
 #include "ns3/ptr.h"
@@ -313,6 +315,48 @@ public:
    */
   SelectQueueCallback GetSelectQueueCallback (void) const;
 
+  /**
+   * \brief Set the segmentation offload flag.
+   * \param offload true if the device splits oversized packets
+   *
+   * A netdevice which calls Segment on the packets larger than its MTU
+   * must call this method from within its NotifyNewAggregate method, so that
+   * the upper layers can hand it packets carrying several segments at once.
+   * This is the analogous to the NETIF_F_TSO feature of the Linux kernel.
+   */
+  void SetSegmentationOffload (bool offload);
+
+  /**
+   * \brief Get the segmentation offload flag.
+   * \return true if the device splits oversized packets
+   */
+  bool GetSegmentationOffload (void) const;
+
+  /// Callback invoked to split a packet into packets which fit the device MTU
+  typedef Callback< std::list<Ptr<Packet> >, Ptr<Packet> > SegmentationCallback;
+
+  /**
+   * \brief Set the segmentation callback of a network protocol.
+   * \param protocol the EtherType of the network protocol
+   * \param cb the callback to set.
+   *
+   * Called by the network protocols to set the method used to split the
+   * packets (starting with the network header) they sent to the device.
+   */
+  void SetSegmentationCallback (uint16_t protocol, SegmentationCallback cb);
+
+  /**
+   * \brief Split a packet into packets which fit the device MTU.
+   * \param protocol the EtherType of the network protocol
+   * \param packet the packet, starting with the network header
+   * \return the packets to transmit, or an empty list if the packet
+   *         cannot be split
+   *
+   * Called by a netdevice which set the segmentation offload flag when it
+   * dequeues a packet larger than its MTU.
+   */
+  std::list<Ptr<Packet> > Segment (uint16_t protocol, Ptr<Packet> packet) const;
+
   /**
    * \brief Connect the traced callbacks of a queue to the static methods of the
    *        NetDeviceQueue class to support flow control and dynamic queue limits
@@ -333,6 +377,8 @@ private:
   SelectQueueCallback m_selectQueueCallback;   //!< Select queue callback
   uint8_t m_numTxQueues;   //!< Number of transmission queues to create
   bool m_lateTxQueuesCreation;   //!< True if a device wants to create the TX queues by itself
+  bool m_segmentationOffload;   //!< True if the device splits oversized packets
+  std::map<uint16_t, SegmentationCallback> m_segmentationCallbacks;   //!< Segmentation callbacks, by protocol
 };
 
 
@@ -17,6 +17,7 @@
  */
 
 #include "ns3/abort.h"
+#include "ns3/boolean.h"
 #include "ns3/enum.h"
 #include "ns3/uinteger.h"
 #include "ns3/trace-source-accessor.h"
@@ -54,6 +55,14 @@ QueueBase::GetTypeId (void)
                    MakeUintegerAccessor (&QueueBase::SetMaxBytes,
                                          &QueueBase::GetMaxBytes),
                    MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Preallocate",
+                   "Whether to reserve the storage for the items on the first enqueue, "
+                   "so that the queue never allocates memory afterwards. In bytes mode, "
+                   "room is reserved for MaxBytes/64 items, 64 bytes being the minimum "
+                   "Ethernet frame size.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&QueueBase::m_preallocate),
+                   MakeBooleanChecker ())
     .AddTraceSource ("PacketsInQueue",
                      "Number of packets currently stored in the queue",
                      MakeTraceSourceAccessor (&QueueBase::m_nPackets),
@@ -77,7 +86,8 @@ QueueBase::QueueBase () :
   m_nTotalDroppedPackets (0),
   m_nTotalDroppedPacketsBeforeEnqueue (0),
   m_nTotalDroppedPacketsAfterDequeue (0),
-  m_mode (QUEUE_MODE_PACKETS)
+  m_mode (QUEUE_MODE_PACKETS),
+  m_preallocate (false)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -29,9 +29,9 @@
 #include "ns3/traced-value.h"
 #include "ns3/unused.h"
 #include "ns3/log.h"
+#include "ns3/ring-buffer.h"
 #include <string>
 #include <sstream>
-#include <list>
 
 namespace ns3 {
 
@@ -253,6 +253,7 @@ private:
   uint32_t m_maxPackets;              //!< max packets in the queue
   uint32_t m_maxBytes;                //!< max bytes in the queue
   QueueMode m_mode;                   //!< queue mode (packets or bytes)
+  bool m_preallocate;                 //!< reserve the item storage on first enqueue
 
   template <typename Item>
   friend class Queue;
@@ -330,7 +331,7 @@ public:
 
 protected:
 
-  typedef typename std::list<Ptr<Item> >::const_iterator ConstIterator;
+  typedef typename RingBuffer<Ptr<Item> >::ConstIterator ConstIterator;
 
   /**
    * \brief Get a const iterator which refers to the first item in the queue.
@@ -414,7 +415,7 @@ protected:
   void DropAfterDequeue (Ptr<Item> item);
 
 private:
-  std::list<Ptr<Item> > m_packets;          //!< the items in the queue
+  RingBuffer<Ptr<Item> > m_packets;         //!< the items in the queue
 
   /// Traced callback: fired when a packet is enqueued
   TracedCallback<Ptr<const Item> > m_traceEnqueue;
@@ -498,7 +499,12 @@ Queue<Item>::DoEnqueue (ConstIterator pos, Ptr<Item> item)
       return false;
     }
 
-  m_packets.insert (pos, item);
+  if (m_preallocate && m_packets.GetCapacity () == 0)
+    {
+      m_packets.Reserve (m_mode == QUEUE_MODE_PACKETS ? m_maxPackets : m_maxBytes / 64);
+    }
+
+  m_packets.Insert (pos, item);
 
   uint32_t size = item->GetSize ();
   m_nBytes += size;
@@ -526,7 +532,7 @@ Queue<Item>::DoDequeue (ConstIterator pos)
     }
 
   Ptr<Item> item = *pos;
-  m_packets.erase (pos);
+  m_packets.Erase (pos);
 
   if (item != 0)
     {
@@ -555,7 +561,7 @@ Queue<Item>::DoRemove (ConstIterator pos)
     }
 
   Ptr<Item> item = *pos;
-  m_packets.erase (pos);
+  m_packets.Erase (pos);
 
   if (item != 0)
     {
@@ -599,13 +605,13 @@ Queue<Item>::DoPeek (ConstIterator pos) const
 template <typename Item>
 typename Queue<Item>::ConstIterator Queue<Item>::Head (void) const
 {
-  return m_packets.cbegin ();
+  return m_packets.Begin ();
 }
 
 template <typename Item>
 typename Queue<Item>::ConstIterator Queue<Item>::Tail (void) const
 {
-  return m_packets.cend ();
+  return m_packets.End ();
 }
 
 template <typename Item>
@@ -0,0 +1,506 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include "ns3/assert.h"
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup network
+ *
+ * \brief A contiguous double-ended FIFO container.
+ *
+ * Items are stored in a circular array whose capacity is a power of
+ * two. The array is grown by doubling when full and is never shrunk,
+ * so a container used at a steady occupancy does not allocate memory.
+ *
+ * Positions are absolute 32-bit counters which are masked with the
+ * capacity on access. As a consequence, iterators survive the growth
+ * of the array. Insertion and removal at an arbitrary position move
+ * the items which precede that position, hence:
+ *
+ * - Insert (pos, item) leaves \p pos and every iterator following it
+ *   valid; iterators preceding \p pos are invalidated. Inserting at
+ *   End () appends the item and invalidates no iterator other than
+ *   End () itself, which then refers to the new item;
+ * - Erase (pos) leaves every iterator following \p pos valid; \p pos
+ *   and the iterators preceding it are invalidated.
+ *
+ * This allows removing items while browsing the container:
+ *
+ * \code
+ *   for (auto it = rb.Begin (); it != rb.End (); )
+ *     {
+ *       auto curr = it++;
+ *       rb.Erase (curr);
+ *     }
+ * \endcode
+ *
+ * Removed slots are reset to a default-constructed T, so that the
+ * container does not hold references to removed items.
+ *
+ * \tparam T \explicit The type of the stored items. It must be default
+ *           constructible and copy assignable.
+ */
+template <typename T>
+class RingBuffer
+{
+public:
+  /**
+   * \brief Const iterator over the items of a RingBuffer.
+   */
+  class ConstIterator
+  {
+public:
+    ConstIterator ();
+    /**
+     * \returns a reference to the item.
+     */
+    const T & operator* (void) const;
+    /**
+     * \returns a pointer to the item.
+     */
+    const T * operator-> (void) const;
+    /**
+     * Move to the next item.
+     * \returns this iterator.
+     */
+    ConstIterator & operator++ (void);
+    /**
+     * Move to the next item.
+     * \returns an iterator to the current item.
+     */
+    ConstIterator operator++ (int);
+    /**
+     * Move to the previous item.
+     * \returns this iterator.
+     */
+    ConstIterator & operator-- (void);
+    /**
+     * Move to the previous item.
+     * \returns an iterator to the current item.
+     */
+    ConstIterator operator-- (int);
+    /**
+     * \param o the other iterator
+     * \returns true if both iterators refer to the same position.
+     */
+    bool operator== (const ConstIterator &o) const;
+    /**
+     * \param o the other iterator
+     * \returns true if the iterators refer to different positions.
+     */
+    bool operator!= (const ConstIterator &o) const;
+
+private:
+    friend class RingBuffer<T>;
+    /**
+     * \param buffer the container
+     * \param pos the absolute position
+     */
+    ConstIterator (const RingBuffer<T> *buffer, uint32_t pos);
+
+    const RingBuffer<T> *m_buffer; //!< the container
+    uint32_t m_pos;                //!< the absolute position
+  };
+
+  RingBuffer ();
+
+  /**
+   * \returns the number of items in the container.
+   */
+  uint32_t GetSize (void) const;
+  /**
+   * \returns true if the container holds no item.
+   */
+  bool IsEmpty (void) const;
+  /**
+   * \returns the number of items which can be stored without growing.
+   */
+  uint32_t GetCapacity (void) const;
+  /**
+   * \brief Make room for at least \p n items.
+   *
+   * \param n the number of items
+   */
+  void Reserve (uint32_t n);
+
+  /**
+   * \returns an iterator to the first item.
+   */
+  ConstIterator Begin (void) const;
+  /**
+   * \returns an iterator past the last item.
+   */
+  ConstIterator End (void) const;
+  /**
+   * \returns the first item. The container must not be empty.
+   */
+  const T & Front (void) const;
+  /**
+   * \returns the last item. The container must not be empty.
+   */
+  const T & Back (void) const;
+
+  /**
+   * \param item the item to append
+   */
+  void PushBack (const T &item);
+  /**
+   * \param item the item to prepend
+   */
+  void PushFront (const T &item);
+  /**
+   * \brief Remove the first item. The container must not be empty.
+   */
+  void PopFront (void);
+  /**
+   * \brief Insert an item before the given position.
+   *
+   * \param pos the position
+   * \param item the item to insert
+   * \returns an iterator to the inserted item.
+   */
+  ConstIterator Insert (ConstIterator pos, const T &item);
+  /**
+   * \brief Remove the item at the given position.
+   *
+   * \param pos the position of the item
+   * \returns an iterator to the item which followed the removed one.
+   */
+  ConstIterator Erase (ConstIterator pos);
+  /**
+   * \brief Remove all the items, keeping the allocated memory.
+   */
+  void Clear (void);
+
+private:
+  /**
+   * \param pos an absolute position
+   * \returns a reference to the slot holding that position.
+   */
+  T & Slot (uint32_t pos);
+  /**
+   * \param pos an absolute position
+   * \returns a reference to the slot holding that position.
+   */
+  const T & Slot (uint32_t pos) const;
+  /**
+   * \brief Double the capacity, or allocate the initial array.
+   */
+  void Grow (void);
+  /**
+   * \brief Move the items to an array of the given capacity.
+   * \param capacity the new capacity, a power of two
+   */
+  void Reallocate (uint32_t capacity);
+
+  std::vector<T> m_data; //!< the circular array
+  uint32_t m_mask;       //!< the capacity minus one
+  uint32_t m_head;       //!< absolute position of the first item
+  uint32_t m_size;       //!< the number of items
+};
+
+
+/***************************************************
+ *  Implementation of the templates declared above.
+ ***************************************************/
+
+template <typename T>
+RingBuffer<T>::ConstIterator::ConstIterator ()
+  : m_buffer (0),
+    m_pos (0)
+{
+}
+
+template <typename T>
+RingBuffer<T>::ConstIterator::ConstIterator (const RingBuffer<T> *buffer, uint32_t pos)
+  : m_buffer (buffer),
+    m_pos (pos)
+{
+}
+
+template <typename T>
+const T &
+RingBuffer<T>::ConstIterator::operator* (void) const
+{
+  return m_buffer->Slot (m_pos);
+}
+
+template <typename T>
+const T *
+RingBuffer<T>::ConstIterator::operator-> (void) const
+{
+  return &m_buffer->Slot (m_pos);
+}
+
+template <typename T>
+typename RingBuffer<T>::ConstIterator &
+RingBuffer<T>::ConstIterator::operator++ (void)
+{
+  m_pos++;
+  return *this;
+}
+
+template <typename T>
+typename RingBuffer<T>::ConstIterator
+RingBuffer<T>::ConstIterator::operator++ (int)
+{
+  ConstIterator tmp = *this;
+  m_pos++;
+  return tmp;
+}
+
+template <typename T>
+typename RingBuffer<T>::ConstIterator &
+RingBuffer<T>::ConstIterator::operator-- (void)
+{
+  m_pos--;
+  return *this;
+}
+
+template <typename T>
+typename RingBuffer<T>::ConstIterator
+RingBuffer<T>::ConstIterator::operator-- (int)
+{
+  ConstIterator tmp = *this;
+  m_pos--;
+  return tmp;
+}
+
+template <typename T>
+bool
+RingBuffer<T>::ConstIterator::operator== (const ConstIterator &o) const
+{
+  return m_pos == o.m_pos && m_buffer == o.m_buffer;
+}
+
+template <typename T>
+bool
+RingBuffer<T>::ConstIterator::operator!= (const ConstIterator &o) const
+{
+  return !(*this == o);
+}
+
+template <typename T>
+RingBuffer<T>::RingBuffer ()
+  : m_mask (0),
+    m_head (0),
+    m_size (0)
+{
+}
+
+template <typename T>
+uint32_t
+RingBuffer<T>::GetSize (void) const
+{
+  return m_size;
+}
+
+template <typename T>
+bool
+RingBuffer<T>::IsEmpty (void) const
+{
+  return m_size == 0;
+}
+
+template <typename T>
+uint32_t
+RingBuffer<T>::GetCapacity (void) const
+{
+  return m_data.size ();
+}
+
+template <typename T>
+void
+RingBuffer<T>::Reserve (uint32_t n)
+{
+  if (n <= m_data.size ())
+    {
+      return;
+    }
+  uint32_t capacity = 1;
+  while (capacity < n)
+    {
+      NS_ASSERT_MSG (capacity < 0x80000000U, "RingBuffer capacity overflow");
+      capacity <<= 1;
+    }
+  Reallocate (capacity);
+}
+
+template <typename T>
+typename RingBuffer<T>::ConstIterator
+RingBuffer<T>::Begin (void) const
+{
+  return ConstIterator (this, m_head);
+}
+
+template <typename T>
+typename RingBuffer<T>::ConstIterator
+RingBuffer<T>::End (void) const
+{
+  return ConstIterator (this, m_head + m_size);
+}
+
+template <typename T>
+const T &
+RingBuffer<T>::Front (void) const
+{
+  NS_ASSERT (m_size > 0);
+  return Slot (m_head);
+}
+
+template <typename T>
+const T &
+RingBuffer<T>::Back (void) const
+{
+  NS_ASSERT (m_size > 0);
+  return Slot (m_head + m_size - 1);
+}
+
+template <typename T>
+void
+RingBuffer<T>::PushBack (const T &item)
+{
+  if (m_size == m_data.size ())
+    {
+      Grow ();
+    }
+  Slot (m_head + m_size) = item;
+  m_size++;
+}
+
+template <typename T>
+void
+RingBuffer<T>::PushFront (const T &item)
+{
+  if (m_size == m_data.size ())
+    {
+      Grow ();
+    }
+  m_head--;
+  Slot (m_head) = item;
+  m_size++;
+}
+
+template <typename T>
+void
+RingBuffer<T>::PopFront (void)
+{
+  NS_ASSERT (m_size > 0);
+  Slot (m_head) = T ();
+  m_head++;
+  m_size--;
+}
+
+template <typename T>
+typename RingBuffer<T>::ConstIterator
+RingBuffer<T>::Insert (ConstIterator pos, const T &item)
+{
+  NS_ASSERT (pos.m_buffer == this);
+  NS_ASSERT (pos.m_pos - m_head <= m_size);
+  if (pos.m_pos == m_head + m_size)
+    {
+      PushBack (item);
+      return ConstIterator (this, pos.m_pos);
+    }
+  if (m_size == m_data.size ())
+    {
+      Grow ();
+    }
+  // shift the items preceding pos one slot towards the front
+  for (uint32_t i = m_head; i != pos.m_pos; i++)
+    {
+      Slot (i - 1) = Slot (i);
+    }
+  m_head--;
+  m_size++;
+  Slot (pos.m_pos - 1) = item;
+  return ConstIterator (this, pos.m_pos - 1);
+}
+
+template <typename T>
+typename RingBuffer<T>::ConstIterator
+RingBuffer<T>::Erase (ConstIterator pos)
+{
+  NS_ASSERT (pos.m_buffer == this);
+  NS_ASSERT (pos.m_pos - m_head < m_size);
+  // shift the items preceding pos one slot towards the back
+  for (uint32_t i = pos.m_pos; i != m_head; i--)
+    {
+      Slot (i) = Slot (i - 1);
+    }
+  Slot (m_head) = T ();
+  m_head++;
+  m_size--;
+  return ConstIterator (this, pos.m_pos + 1);
+}
+
+template <typename T>
+void
+RingBuffer<T>::Clear (void)
+{
+  while (m_size > 0)
+    {
+      PopFront ();
+    }
+}
+
+template <typename T>
+T &
+RingBuffer<T>::Slot (uint32_t pos)
+{
+  return m_data[pos & m_mask];
+}
+
+template <typename T>
+const T &
+RingBuffer<T>::Slot (uint32_t pos) const
+{
+  return m_data[pos & m_mask];
+}
+
+template <typename T>
+void
+RingBuffer<T>::Grow (void)
+{
+  NS_ASSERT_MSG (m_data.size () < 0x80000000U, "RingBuffer capacity overflow");
+  Reallocate (m_data.empty () ? 8 : 2 * m_data.size ());
+}
+
+template <typename T>
+void
+RingBuffer<T>::Reallocate (uint32_t capacity)
+{
+  std::vector<T> data (capacity);
+  uint32_t mask = capacity - 1;
+  // keep every item at its absolute position, so iterators stay valid
+  for (uint32_t i = m_head; i != m_head + m_size; i++)
+    {
+      data[i & mask] = Slot (i);
+    }
+  m_data.swap (data);
+  m_mask = mask;
+}
+
+} // namespace ns3
+
+#endif /* RING_BUFFER_H */
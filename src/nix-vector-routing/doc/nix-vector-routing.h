@@ -48,5 +48,26 @@
  * nix-vector and transmits the packet through the corresponding 
  * net-device.  This continues until the packet reaches the destination.
  *
+ * The breadth-first searches do not walk the nodes and channels
+ * themselves: they run on a compact snapshot of the adjacency of all the
+ * nodes, stored as flat arrays, which is built on the first search and
+ * rebuilt after the caches are flushed or nodes are added.  The snapshot
+ * also maps each address to its node.  The state of the interfaces and
+ * links is still checked during each search.  Topology changes which are
+ * not notified to the routing protocols (e.g., a device added without an
+ * Ipv4 interface) require a call to
+ * ns3::Ipv4NixVectorRouting::FlushGlobalNixRoutingCache.
+ *
+ * Each node caches the nix-vectors and routes by destination address.
+ * The MaxCacheSize attribute bounds the number of cached destinations, the
+ * least recently used being evicted first, and
+ * ns3::Ipv4NixVectorRouting::GetCacheMemoryUsage estimates the memory used
+ * by a cache.  When the caches are flushed, each node flushes its own
+ * cache when it next uses it.
+ *
+ * ns3::Ipv4NixVectorRouting::PrecomputeNixVectors computes, before the
+ * simulation, the nix-vectors from a set of nodes to all the addresses,
+ * with a breadth-first search per source spread over several threads.
+ *
  */
 
@@ -18,13 +18,18 @@
  * Authors: Josh Pelkey <jpelkey@gatech.edu>
  */
 
-#include <queue>
+#include <algorithm>
 #include <iomanip>
 
 #include "ns3/log.h"
 #include "ns3/abort.h"
 #include "ns3/names.h"
+#include "ns3/uinteger.h"
 #include "ns3/ipv4-list-routing.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#endif
 
 #include "ipv4-nix-vector-routing.h"
 
@@ -34,7 +39,69 @@ NS_LOG_COMPONENT_DEFINE ("Ipv4NixVectorRouting");
 
 NS_OBJECT_ENSURE_REGISTERED (Ipv4NixVectorRouting);
 
-bool Ipv4NixVectorRouting::g_isCacheDirty = false;
+uint32_t Ipv4NixVectorRouting::g_epoch = 0;
+Ipv4NixVectorRouting::Topology Ipv4NixVectorRouting::g_topology;
+const uint32_t Ipv4NixVectorRouting::NO_NODE;
+const uint32_t Ipv4NixVectorRouting::NO_NIX;
+
+/**
+ * \ingroup nix-vector-routing
+ * \brief Breadth first searches of a range of sources, run by
+ * Ipv4NixVectorRouting::PrecomputeNixVectors, possibly in its own thread
+ *
+ * The task only reads the snapshot of the topology and the state of the
+ * ports, and builds new nix-vectors, so that several tasks can run
+ * concurrently.
+ */
+class Ipv4NixVectorRouting::PrecomputeTask
+{
+public:
+  /// Nix-vectors to the addresses of the topology
+  typedef std::vector<std::pair<Ipv4Address, Ptr<NixVector> > > NixVectors_t;
+
+  const std::vector<uint32_t> *m_sources; //!< Source node ids
+  const std::vector<uint8_t> *m_portUp;   //!< State of each port
+  uint32_t m_begin;                       //!< First source of the task
+  uint32_t m_end;                         //!< Past the last source of the task
+  std::vector<NixVectors_t> *m_results;   //!< Nix-vectors of each source, from m_begin
+
+  /// Run the breadth first searches
+  void Run (void)
+  {
+    const Topology &topology = Ipv4NixVectorRouting::g_topology;
+    std::vector<uint32_t> parentVector;
+    std::vector<Ptr<NixVector> > byNode;
+    for (uint32_t i = m_begin; i < m_end; i++)
+      {
+        uint32_t source = (*m_sources)[i];
+        NixVectors_t &nixVectors = (*m_results)[i - m_begin];
+        Ipv4NixVectorRouting::BFS (source, NO_NODE, parentVector, NO_NODE, m_portUp);
+        // the addresses of a node share its nix-vector
+        byNode.assign (parentVector.size (), 0);
+        for (std::map<Ipv4Address, uint32_t>::const_iterator it = topology.m_addresses.begin ();
+             it != topology.m_addresses.end (); it++)
+          {
+            uint32_t dest = it->second;
+            if (dest == source || it->first.IsLocalhost () || parentVector[dest] == NO_NODE)
+              {
+                continue;
+              }
+            if (byNode[dest] == 0)
+              {
+                byNode[dest] = Create<NixVector> ();
+                Ipv4NixVectorRouting::BuildNixVector (parentVector, source, dest, byNode[dest]);
+              }
+            nixVectors.push_back (std::make_pair (it->first, byNode[dest]));
+          }
+      }
+  }
+};
+
+Ipv4NixVectorRouting::Topology::Topology ()
+  : m_valid (false),
+    m_epoch (0)
+{
+}
 
 TypeId 
 Ipv4NixVectorRouting::GetTypeId (void)
@@ -43,12 +110,22 @@ Ipv4NixVectorRouting::GetTypeId (void)
     .SetParent<Ipv4RoutingProtocol> ()
     .SetGroupName ("NixVectorRouting")
     .AddConstructor<Ipv4NixVectorRouting> ()
+    .AddAttribute ("MaxCacheSize",
+                   "The maximum number of destinations whose nix-vector and "
+                   "route are cached by the node, the least recently used "
+                   "being evicted first. A value of 0 means no limit.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&Ipv4NixVectorRouting::m_maxCacheSize),
+                   MakeUintegerChecker<uint32_t> ())
   ;
   return tid;
 }
 
 Ipv4NixVectorRouting::Ipv4NixVectorRouting ()
-  : m_totalNeighbors (0)
+  : m_cacheEpoch (g_epoch),
+    m_cacheBytes (0),
+    m_maxCacheSize (0),
+    m_totalNeighbors (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -75,6 +152,12 @@ Ipv4NixVectorRouting::DoDispose ()
 
   m_node = 0;
   m_ipv4 = 0;
+  FlushCache ();
+
+  // the topology snapshot refers to the nodes by index, so it must not
+  // outlive them
+  g_epoch++;
+  g_topology = Topology ();
 
   Ipv4RoutingProtocol::DoDispose ();
 }
@@ -92,33 +175,100 @@ void
 Ipv4NixVectorRouting::FlushGlobalNixRoutingCache (void) const
 {
   NS_LOG_FUNCTION_NOARGS ();
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+  // each node flushes its caches when it next uses them
+  g_epoch++;
+}
+
+void
+Ipv4NixVectorRouting::FlushCache (void) const
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  m_cacheList.clear ();
+  m_cache.clear ();
+  m_cacheBytes = 0;
+}
+
+uint32_t
+Ipv4NixVectorRouting::GetNCacheEntries (void) const
+{
+  CheckCacheStateAndFlush ();
+  return m_cache.size ();
+}
+
+uint64_t
+Ipv4NixVectorRouting::GetCacheMemoryUsage (void) const
+{
+  CheckCacheStateAndFlush ();
+  return m_cacheBytes;
+}
+
+uint32_t
+Ipv4NixVectorRouting::GetEntrySize (const CacheEntry &entry)
+{
+  // the nodes of the list and of the map are accounted for with
+  // the pointers which link them
+  uint32_t size = sizeof (CacheList_t::value_type) + 2 * sizeof (void *)
+    + sizeof (CacheMap_t::value_type) + 3 * sizeof (void *);
+  if (entry.m_nixVector != 0)
     {
-      Ptr<Node> node = *i;
-      Ptr<Ipv4NixVectorRouting> rp = node->GetObject<Ipv4NixVectorRouting> ();
-      if (!rp)
-        {
-          continue;
-        }
-      NS_LOG_LOGIC ("Flushing Nix caches.");
-      rp->FlushNixCache ();
-      rp->FlushIpv4RouteCache ();
+      size += sizeof (NixVector) + entry.m_nixVector->GetSerializedSize ();
     }
+  if (entry.m_route != 0)
+    {
+      size += sizeof (Ipv4Route);
+    }
+  return size;
+}
+
+Ipv4NixVectorRouting::CacheList_t::iterator
+Ipv4NixVectorRouting::FindCacheEntry (Ipv4Address address) const
+{
+  CacheMap_t::iterator it = m_cache.find (address);
+  if (it == m_cache.end ())
+    {
+      return m_cacheList.end ();
+    }
+  m_cacheList.splice (m_cacheList.begin (), m_cacheList, it->second);
+  return it->second;
+}
+
+Ipv4NixVectorRouting::CacheList_t::iterator
+Ipv4NixVectorRouting::InsertCacheEntry (Ipv4Address address)
+{
+  CacheList_t::iterator entry = FindCacheEntry (address);
+  if (entry != m_cacheList.end ())
+    {
+      return entry;
+    }
+  m_cacheList.push_front (std::make_pair (address, CacheEntry ()));
+  m_cache[address] = m_cacheList.begin ();
+  m_cacheBytes += GetEntrySize (CacheEntry ());
+  while (m_maxCacheSize > 0 && m_cache.size () > m_maxCacheSize)
+    {
+      NS_LOG_LOGIC ("Evicting " << m_cacheList.back ().first << " from the cache");
+      m_cacheBytes -= GetEntrySize (m_cacheList.back ().second);
+      m_cache.erase (m_cacheList.back ().first);
+      m_cacheList.pop_back ();
+    }
+  return m_cacheList.begin ();
 }
 
 void
-Ipv4NixVectorRouting::FlushNixCache (void) const
+Ipv4NixVectorRouting::CacheNixVector (Ipv4Address address, Ptr<NixVector> nixVector)
 {
-  NS_LOG_FUNCTION_NOARGS ();
-  m_nixCache.clear ();
+  CacheList_t::iterator entry = InsertCacheEntry (address);
+  m_cacheBytes -= GetEntrySize (entry->second);
+  entry->second.m_nixVector = nixVector;
+  m_cacheBytes += GetEntrySize (entry->second);
 }
 
 void
-Ipv4NixVectorRouting::FlushIpv4RouteCache (void) const
+Ipv4NixVectorRouting::CacheIpv4Route (Ipv4Address address, Ptr<Ipv4Route> route)
 {
-  NS_LOG_FUNCTION_NOARGS ();
-  m_ipv4RouteCache.clear ();
+  CacheList_t::iterator entry = InsertCacheEntry (address);
+  m_cacheBytes -= GetEntrySize (entry->second);
+  entry->second.m_route = route;
+  m_cacheBytes += GetEntrySize (entry->second);
 }
 
 Ptr<NixVector>
@@ -126,22 +276,26 @@ Ipv4NixVectorRouting::GetNixVector (Ptr<Node> source, Ipv4Address dest, Ptr<NetD
 {
   NS_LOG_FUNCTION_NOARGS ();
 
+  UpdateTopology ();
+
   Ptr<NixVector> nixVector = Create<NixVector> ();
 
   // not in cache, must build the nix vector
   // First, we have to figure out the nodes 
   // associated with these IPs
-  Ptr<Node> destNode = GetNodeByIp (dest);
-  if (destNode == 0)
+  std::map<Ipv4Address, uint32_t>::const_iterator it = g_topology.m_addresses.find (dest);
+  if (it == g_topology.m_addresses.end ())
     {
+      NS_LOG_ERROR ("Couldn't find dest node given the IP" << dest);
       NS_LOG_ERROR ("No routing path exists");
       return 0;
     }
+  uint32_t destId = it->second;
 
   // if source == dest, then we have a special case
   /// \internal
   /// Do not process packets to self (see \bugid{1308})
-  if (source == destNode)
+  if (source->GetId () == destId)
     {
       NS_LOG_DEBUG ("Do not process packets to self");
       return 0;
@@ -150,11 +304,29 @@ Ipv4NixVectorRouting::GetNixVector (Ptr<Node> source, Ipv4Address dest, Ptr<NetD
     {
       // otherwise proceed as normal 
       // and build the nix vector
-      std::vector< Ptr<Node> > parentVector;
+      uint32_t oifPort = NO_NODE;
+      if (oif)
+        {
+          for (uint32_t port = g_topology.m_portOffsets[source->GetId ()];
+               port < g_topology.m_portOffsets[source->GetId () + 1]; port++)
+            {
+              if (g_topology.m_portDevices[port] == oif->GetIfIndex ())
+                {
+                  oifPort = port;
+                }
+            }
+          if (oifPort == NO_NODE)
+            {
+              NS_LOG_ERROR ("No routing path exists through " << oif);
+              return 0;
+            }
+        }
 
-      BFS (NodeList::GetNNodes (), source, destNode, parentVector, oif);
+      std::vector<uint32_t> parentVector;
 
-      if (BuildNixVector (parentVector, source->GetId (), destNode->GetId (), nixVector))
+      BFS (source->GetId (), destId, parentVector, oifPort, 0);
+
+      if (BuildNixVector (parentVector, source->GetId (), destId, nixVector))
         {
           return nixVector;
         }
@@ -173,11 +345,11 @@ Ipv4NixVectorRouting::GetNixVectorInCache (Ipv4Address address)
 
   CheckCacheStateAndFlush ();
 
-  NixMap_t::iterator iter = m_nixCache.find (address);
-  if (iter != m_nixCache.end ())
+  CacheList_t::iterator entry = FindCacheEntry (address);
+  if (entry != m_cacheList.end () && entry->second.m_nixVector)
     {
       NS_LOG_LOGIC ("Found Nix-vector in cache.");
-      return iter->second;
+      return entry->second.m_nixVector;
     }
 
   // not in cache
@@ -191,11 +363,11 @@ Ipv4NixVectorRouting::GetIpv4RouteInCache (Ipv4Address address)
 
   CheckCacheStateAndFlush ();
 
-  Ipv4RouteMap_t::iterator iter = m_ipv4RouteCache.find (address);
-  if (iter != m_ipv4RouteCache.end ())
+  CacheList_t::iterator entry = FindCacheEntry (address);
+  if (entry != m_cacheList.end () && entry->second.m_route)
     {
       NS_LOG_LOGIC ("Found Ipv4Route in cache.");
-      return iter->second;
+      return entry->second.m_route;
     }
 
   // not in cache
@@ -230,75 +402,39 @@ Ipv4NixVectorRouting::BuildNixVectorLocal (Ptr<NixVector> nixVector)
 }
 
 bool
-Ipv4NixVectorRouting::BuildNixVector (const std::vector< Ptr<Node> > & parentVector, uint32_t source, uint32_t dest, Ptr<NixVector> nixVector)
+Ipv4NixVectorRouting::BuildNixVector (const std::vector<uint32_t> & parentVector, uint32_t source, uint32_t dest, Ptr<NixVector> nixVector)
 {
-  NS_LOG_FUNCTION_NOARGS ();
-
   if (source == dest)
     {
       return true;
     }
 
-  if (parentVector.at (dest) == 0)
+  if (parentVector.at (dest) == NO_NODE)
     {
       return false;
     }
 
-  Ptr<Node> parentNode = parentVector.at (dest);
-
-  uint32_t numberOfDevices = parentNode->GetNDevices ();
-  uint32_t destId = 0;
-  uint32_t totalNeighbors = 0;
-
-  // scan through the net devices on the parent node
-  // and then look at the nodes adjacent to them
-  for (uint32_t i = 0; i < numberOfDevices; i++)
+  // walk up the parent vector, from the destination to the source,
+  // adding the neighbor index of each node at its parent
+  for (uint32_t node = dest; node != source; node = parentVector[node])
     {
-      // Get a net device from the node
-      // as well as the channel, and figure
-      // out the adjacent net devices
-      Ptr<NetDevice> localNetDevice = parentNode->GetDevice (i);
-      if (localNetDevice->IsBridge ())
-        {
-          continue;
-        }
-      Ptr<Channel> channel = localNetDevice->GetChannel ();
-      if (channel == 0)
+      uint32_t parent = parentVector[node];
+
+      // scan through the neighbors of the parent node.  If several
+      // links lead to the node, the last one is taken
+      uint32_t destId = 0;
+      uint32_t first = g_topology.m_neighborOffsets[g_topology.m_portOffsets[parent]];
+      uint32_t last = g_topology.m_neighborOffsets[g_topology.m_portOffsets[parent + 1]];
+      for (uint32_t i = first; i < last; i++)
         {
-          continue;
-        }
-
-      // this function takes in the local net dev, and channnel, and
-      // writes to the netDeviceContainer the adjacent net devs
-      NetDeviceContainer netDeviceContainer;
-      GetAdjacentNetDevices (localNetDevice, channel, netDeviceContainer);
-
-      // Finally we can get the adjacent nodes
-      // and scan through them.  If we find the 
-      // node that matches "dest" then we can add 
-      // the index  to the nix vector.
-      // the index corresponds to the neighbor index
-      uint32_t offset = 0;
-      for (NetDeviceContainer::Iterator iter = netDeviceContainer.Begin (); iter != netDeviceContainer.End (); iter++)
-        {
-          Ptr<Node> remoteNode = (*iter)->GetNode ();
-
-          if (remoteNode->GetId () == dest)
+          if (g_topology.m_neighborNodes[i] == node && g_topology.m_nixIndices[i] != NO_NIX)
             {
-              destId = totalNeighbors + offset;
+              destId = g_topology.m_nixIndices[i];
             }
-          offset += 1;
         }
-
-      totalNeighbors += netDeviceContainer.GetN ();
+      uint32_t totalNeighbors = g_topology.m_nixNeighbors[parent];
+      nixVector->AddNeighborIndex (destId, nixVector->BitCount (totalNeighbors));
     }
-  NS_LOG_LOGIC ("Adding Nix: " << destId << " with " 
-                               << nixVector->BitCount (totalNeighbors) << " bits, for node " << parentNode->GetId ());
-  nixVector->AddNeighborIndex (destId, nixVector->BitCount (totalNeighbors));
-
-  // recurse through parent vector, grabbing the path 
-  // and building the nix vector
-  BuildNixVector (parentVector, source, (parentVector.at (dest))->GetId (), nixVector);
   return true;
 }
 
@@ -342,32 +478,173 @@ Ipv4NixVectorRouting::GetAdjacentNetDevices (Ptr<NetDevice> netDevice, Ptr<Chann
     }
 }
 
-Ptr<Node>
-Ipv4NixVectorRouting::GetNodeByIp (Ipv4Address dest)
-{ 
+void
+Ipv4NixVectorRouting::UpdateTopology (void)
+{
+  uint32_t nNodes = NodeList::GetNNodes ();
+  if (g_topology.m_valid && g_topology.m_epoch == g_epoch
+      && g_topology.m_nixNeighbors.size () == nNodes)
+    {
+      return;
+    }
+
   NS_LOG_FUNCTION_NOARGS ();
+  NS_LOG_LOGIC ("Building the topology snapshot of " << nNodes << " nodes");
+
+  g_topology = Topology ();
+  g_topology.m_portOffsets.reserve (nNodes + 1);
+  g_topology.m_nixNeighbors.reserve (nNodes);
+  for (uint32_t n = 0; n < nNodes; n++)
+    {
+      Ptr<Node> node = NodeList::GetNode (n);
+      Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
 
-  NodeContainer allNodes = NodeContainer::GetGlobal ();
-  Ptr<Node> destNode;
+      // the first node owning an address is the one it is routed to
+      if (ipv4)
+        {
+          for (uint32_t i = 0; i < ipv4->GetNInterfaces (); i++)
+            {
+              for (uint32_t j = 0; j < ipv4->GetNAddresses (i); j++)
+                {
+                  g_topology.m_addresses.insert (std::make_pair (ipv4->GetAddress (i, j).GetLocal (), n));
+                }
+            }
+        }
 
-  for (NodeContainer::Iterator i = allNodes.Begin (); i != allNodes.End (); ++i)
+      g_topology.m_portOffsets.push_back (g_topology.m_portNodes.size ());
+      uint32_t totalNeighbors = 0;
+      for (uint32_t i = 0; i < node->GetNDevices (); i++)
+        {
+          Ptr<NetDevice> localNetDevice = node->GetDevice (i);
+          Ptr<Channel> channel = localNetDevice->GetChannel ();
+          if (channel == 0)
+            {
+              continue;
+            }
+          g_topology.m_portNodes.push_back (n);
+          g_topology.m_portDevices.push_back (i);
+          g_topology.m_portInterfaces.push_back (ipv4 ? ipv4->GetInterfaceForDevice (localNetDevice) : -1);
+          g_topology.m_neighborOffsets.push_back (g_topology.m_neighborNodes.size ());
+
+          NetDeviceContainer netDeviceContainer;
+          GetAdjacentNetDevices (localNetDevice, channel, netDeviceContainer);
+          for (NetDeviceContainer::Iterator iter = netDeviceContainer.Begin (); iter != netDeviceContainer.End (); iter++)
+            {
+              g_topology.m_neighborNodes.push_back ((*iter)->GetNode ()->GetId ());
+              // the neighbors reached through a bridge device get no
+              // neighbor index
+              g_topology.m_nixIndices.push_back (localNetDevice->IsBridge () ? NO_NIX : totalNeighbors++);
+            }
+        }
+      g_topology.m_nixNeighbors.push_back (totalNeighbors);
+    }
+  g_topology.m_portOffsets.push_back (g_topology.m_portNodes.size ());
+  g_topology.m_neighborOffsets.push_back (g_topology.m_neighborNodes.size ());
+  g_topology.m_epoch = g_epoch;
+  g_topology.m_valid = true;
+}
+
+bool
+Ipv4NixVectorRouting::IsPortUp (uint32_t port)
+{
+  Ptr<Node> node = NodeList::GetNode (g_topology.m_portNodes[port]);
+  if (g_topology.m_portInterfaces[port] >= 0)
     {
-      Ptr<Node> node = *i;
       Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-      if (ipv4->GetInterfaceForAddress (dest) != -1)
+      if (!(ipv4->IsUp (g_topology.m_portInterfaces[port])))
         {
-          destNode = node;
-          break;
+          NS_LOG_LOGIC ("Ipv4Interface is down");
+          return false;
         }
     }
+  if (!(node->GetDevice (g_topology.m_portDevices[port])->IsLinkUp ()))
+    {
+      NS_LOG_LOGIC ("Link is down.");
+      return false;
+    }
+  return true;
+}
+
+void
+Ipv4NixVectorRouting::PrecomputeNixVectors (NodeContainer sources, uint32_t nThreads)
+{
+  NS_LOG_FUNCTION (sources.GetN () << nThreads);
+  NS_ABORT_MSG_IF (nThreads == 0, "At least one thread is needed");
+
+  UpdateTopology ();
 
-  if (!destNode)
+  // the state of the ports is read once, so that the searches
+  // do not touch the nodes
+  uint32_t nPorts = g_topology.m_portNodes.size ();
+  std::vector<uint8_t> portUp (nPorts);
+  for (uint32_t port = 0; port < nPorts; port++)
     {
-      NS_LOG_ERROR ("Couldn't find dest node given the IP" << dest);
-      return 0;
+      portUp[port] = IsPortUp (port);
+    }
+
+  std::vector<uint32_t> sourceIds;
+  std::vector<Ptr<Ipv4NixVectorRouting> > routers;
+  for (NodeContainer::Iterator i = sources.Begin (); i != sources.End (); i++)
+    {
+      Ptr<Ipv4NixVectorRouting> rp = (*i)->GetObject<Ipv4NixVectorRouting> ();
+      if (rp)
+        {
+          sourceIds.push_back ((*i)->GetId ());
+          routers.push_back (rp);
+        }
     }
 
-  return destNode;
+  // the sources are processed in batches, to bound the memory used by
+  // the nix-vectors which are waiting to be cached
+  uint32_t batchSize = nThreads * 8;
+  for (uint32_t start = 0; start < sourceIds.size (); start += batchSize)
+    {
+      uint32_t count = std::min<uint32_t> (batchSize, sourceIds.size () - start);
+      std::vector<PrecomputeTask> tasks (nThreads);
+      std::vector<std::vector<PrecomputeTask::NixVectors_t> > results (nThreads);
+      for (uint32_t t = 0; t < nThreads; t++)
+        {
+          tasks[t].m_sources = &sourceIds;
+          tasks[t].m_portUp = &portUp;
+          tasks[t].m_begin = start + count * t / nThreads;
+          tasks[t].m_end = start + count * (t + 1) / nThreads;
+          results[t].resize (tasks[t].m_end - tasks[t].m_begin);
+          tasks[t].m_results = &results[t];
+        }
+
+#ifdef HAVE_PTHREAD_H
+      std::vector<Ptr<SystemThread> > threads;
+      for (uint32_t t = 1; t < nThreads; t++)
+        {
+          threads.push_back (Create<SystemThread> (MakeCallback (&PrecomputeTask::Run, &tasks[t])));
+          threads.back ()->Start ();
+        }
+      tasks[0].Run ();
+      for (uint32_t t = 0; t < threads.size (); t++)
+        {
+          threads[t]->Join ();
+        }
+#else
+      for (uint32_t t = 0; t < nThreads; t++)
+        {
+          tasks[t].Run ();
+        }
+#endif
+
+      for (uint32_t t = 0; t < nThreads; t++)
+        {
+          for (uint32_t i = tasks[t].m_begin; i < tasks[t].m_end; i++)
+            {
+              Ptr<Ipv4NixVectorRouting> rp = routers[i];
+              rp->CheckCacheStateAndFlush ();
+              const PrecomputeTask::NixVectors_t &nixVectors = results[t][i - tasks[t].m_begin];
+              for (PrecomputeTask::NixVectors_t::const_iterator it = nixVectors.begin (); it != nixVectors.end (); it++)
+                {
+                  rp->CacheNixVector (it->first, it->second);
+                }
+            }
+        }
+    }
 }
 
 uint32_t
@@ -402,7 +679,7 @@ Ipv4NixVectorRouting::FindTotalNeighbors (void)
 }
 
 Ptr<BridgeNetDevice>
-Ipv4NixVectorRouting::NetDeviceIsBridged (Ptr<NetDevice> nd) const
+Ipv4NixVectorRouting::NetDeviceIsBridged (Ptr<NetDevice> nd)
 {
   NS_LOG_FUNCTION (nd);
 
@@ -510,7 +787,7 @@ Ipv4NixVectorRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<
       nixVectorInCache = GetNixVector (m_node, header.GetDestination (), oif);
 
       // cache it
-      m_nixCache.insert (NixMap_t::value_type (header.GetDestination (), nixVectorInCache));
+      CacheNixVector (header.GetDestination (), nixVectorInCache);
     }
 
   // path exists
@@ -544,13 +821,8 @@ Ipv4NixVectorRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<
           // not in cache or a different specified output
           // device is to be used
 
-          // first, make sure we erase existing (incorrect)
-          // rtentry from the map
-          if (rtentry)
-            {
-              m_ipv4RouteCache.erase (header.GetDestination ());
-            }
-
+          // the existing (incorrect) rtentry, if any, is
+          // replaced in the cache below
           NS_LOG_LOGIC ("Ipv4Route not in cache, build: ");
           Ipv4Address gatewayIp;
           uint32_t index = FindNetDeviceForNixIndex (nodeIndex, gatewayIp);
@@ -588,7 +860,7 @@ Ipv4NixVectorRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<
           sockerr = Socket::ERROR_NOTERROR;
 
           // add rtentry to cache
-          m_ipv4RouteCache.insert (Ipv4RouteMap_t::value_type (header.GetDestination (), rtentry));
+          CacheIpv4Route (header.GetDestination (), rtentry);
         }
 
       NS_LOG_LOGIC ("Nix-vector contents: " << *nixVectorInCache << " : Remaining bits: " << nixVectorForPacket->GetRemainingBits ());
@@ -680,7 +952,7 @@ Ipv4NixVectorRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header,
       rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIndex));
 
       // add rtentry to cache
-      m_ipv4RouteCache.insert (Ipv4RouteMap_t::value_type (header.GetDestination (), rtentry));
+      CacheIpv4Route (header.GetDestination (), rtentry);
     }
 
   NS_LOG_LOGIC ("At Node " << m_node->GetId () << ", Extracting " << numberOfBits <<
@@ -708,39 +980,51 @@ Ipv4NixVectorRouting::PrintRoutingTable (Ptr<OutputStreamWrapper> stream, Time::
       << ", Local time: " << GetObject<Node> ()->GetLocalTime ().As (unit)
       << ", Nix Routing" << std::endl;
 
+  bool header = true;
   *os << "NixCache:" << std::endl;
-  if (m_nixCache.size () > 0)
+  for (CacheMap_t::const_iterator it = m_cache.begin (); it != m_cache.end (); it++)
     {
-      *os << "Destination     NixVector" << std::endl;
-      for (NixMap_t::const_iterator it = m_nixCache.begin (); it != m_nixCache.end (); it++)
+      Ptr<NixVector> nixVector = it->second->second.m_nixVector;
+      if (nixVector)
         {
+          if (header)
+            {
+              *os << "Destination     NixVector" << std::endl;
+              header = false;
+            }
           std::ostringstream dest;
           dest << it->first;
           *os << std::setiosflags (std::ios::left) << std::setw (16) << dest.str ();
-          *os << *(it->second) << std::endl;
+          *os << *nixVector << std::endl;
         }
     }
+  header = true;
   *os << "Ipv4RouteCache:" << std::endl;
-  if (m_ipv4RouteCache.size () > 0)
+  for (CacheMap_t::const_iterator it = m_cache.begin (); it != m_cache.end (); it++)
     {
-      *os << "Destination     Gateway         Source            OutputDevice" << std::endl;
-      for (Ipv4RouteMap_t::const_iterator it = m_ipv4RouteCache.begin (); it != m_ipv4RouteCache.end (); it++)
+      Ptr<Ipv4Route> route = it->second->second.m_route;
+      if (route)
         {
+          if (header)
+            {
+              *os << "Destination     Gateway         Source            OutputDevice" << std::endl;
+              header = false;
+            }
           std::ostringstream dest, gw, src;
-          dest << it->second->GetDestination ();
+          dest << route->GetDestination ();
           *os << std::setiosflags (std::ios::left) << std::setw (16) << dest.str ();
-          gw << it->second->GetGateway ();
+          gw << route->GetGateway ();
           *os << std::setiosflags (std::ios::left) << std::setw (16) << gw.str ();
-          src << it->second->GetSource ();
+          src << route->GetSource ();
           *os << std::setiosflags (std::ios::left) << std::setw (16) << src.str ();
           *os << "  ";
-          if (Names::FindName (it->second->GetOutputDevice ()) != "")
+          if (Names::FindName (route->GetOutputDevice ()) != "")
             {
-              *os << Names::FindName (it->second->GetOutputDevice ());
+              *os << Names::FindName (route->GetOutputDevice ());
             }
           else
             {
-              *os << it->second->GetOutputDevice ()->GetIfIndex ();
+              *os << route->GetOutputDevice ()->GetIfIndex ();
             }
           *os << std::endl;
         }
@@ -752,179 +1036,106 @@ Ipv4NixVectorRouting::PrintRoutingTable (Ptr<OutputStreamWrapper> stream, Time::
 void
 Ipv4NixVectorRouting::NotifyInterfaceUp (uint32_t i)
 {
-  g_isCacheDirty = true;
+  g_epoch++;
 }
 void
 Ipv4NixVectorRouting::NotifyInterfaceDown (uint32_t i)
 {
-  g_isCacheDirty = true;
+  g_epoch++;
 }
 void
 Ipv4NixVectorRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
-  g_isCacheDirty = true;
+  g_epoch++;
 }
 void
 Ipv4NixVectorRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
-  g_isCacheDirty = true;
+  g_epoch++;
 }
 
 bool
-Ipv4NixVectorRouting::BFS (uint32_t numberOfNodes, Ptr<Node> source, 
-                           Ptr<Node> dest, std::vector< Ptr<Node> > & parentVector,
-                           Ptr<NetDevice> oif)
+Ipv4NixVectorRouting::BFS (uint32_t source, uint32_t dest,
+                           std::vector<uint32_t> & parentVector,
+                           uint32_t oifPort,
+                           const std::vector<uint8_t> *portUp)
 {
-  NS_LOG_FUNCTION_NOARGS ();
+  NS_LOG_FUNCTION (source << dest);
 
-  NS_LOG_LOGIC ("Going from Node " << source->GetId () << " to Node " << dest->GetId ());
-  std::queue< Ptr<Node> > greyNodeList;  // discovered nodes with unexplored children
+  // discovered nodes, those before head have had their children explored
+  std::vector<uint32_t> greyNodeList;
 
   // reset the parent vector
-  parentVector.clear ();
-  parentVector.reserve (sizeof (Ptr<Node>)*numberOfNodes);
-  parentVector.insert (parentVector.begin (), sizeof (Ptr<Node>)*numberOfNodes, 0); // initialize to 0
+  parentVector.assign (g_topology.m_nixNeighbors.size (), NO_NODE);
 
   // Add the source node to the queue, set its parent to itself 
-  greyNodeList.push (source);
-  parentVector.at (source->GetId ()) = source;
+  greyNodeList.push_back (source);
+  parentVector[source] = source;
 
   // BFS loop
-  while (greyNodeList.size () != 0)
+  for (uint32_t head = 0; head < greyNodeList.size (); head++)
     {
-      Ptr<Node> currNode = greyNodeList.front ();
-      Ptr<Ipv4> ipv4 = currNode->GetObject<Ipv4> ();
- 
+      uint32_t currNode = greyNodeList[head];
+
       if (currNode == dest) 
         {
-          NS_LOG_LOGIC ("Made it to Node " << currNode->GetId ());
           return true;
         }
 
+      uint32_t firstPort = g_topology.m_portOffsets[currNode];
+      uint32_t lastPort = g_topology.m_portOffsets[currNode + 1];
+
       // if this is the first iteration of the loop and a 
       // specific output interface was given, make sure 
       // we go this way
-      if (currNode == source && oif)
+      if (currNode == source && oifPort != NO_NODE)
         {
-          // make sure that we can go this way
-          if (ipv4)
+          if (!(portUp ? (*portUp)[oifPort] : IsPortUp (oifPort)))
             {
-              uint32_t interfaceIndex = (ipv4)->GetInterfaceForDevice (oif);
-              if (!(ipv4->IsUp (interfaceIndex)))
-                {
-                  NS_LOG_LOGIC ("Ipv4Interface is down");
-                  return false;
-                }
-            }
-          if (!(oif->IsLinkUp ()))
-            {
-              NS_LOG_LOGIC ("Link is down.");
-              return false;
-            }
-          Ptr<Channel> channel = oif->GetChannel ();
-          if (channel == 0)
-            { 
               return false;
             }
+          firstPort = oifPort;
+          lastPort = oifPort + 1;
+        }
 
-          // this function takes in the local net dev, and channnel, and
-          // writes to the netDeviceContainer the adjacent net devs
-          NetDeviceContainer netDeviceContainer;
-          GetAdjacentNetDevices (oif, channel, netDeviceContainer);
+      // Iterate over the current node's adjacent vertices
+      // and push them into the queue
+      for (uint32_t port = firstPort; port < lastPort; port++)
+        {
+          // make sure that we can go this way
+          if (port != oifPort && !(portUp ? (*portUp)[port] : IsPortUp (port)))
+            {
+              continue;
+            }
 
-          // Finally we can get the adjacent nodes
-          // and scan through them.  We push them
-          // to the greyNode queue, if they aren't 
-          // already there.
-          for (NetDeviceContainer::Iterator iter = netDeviceContainer.Begin (); iter != netDeviceContainer.End (); iter++)
+          for (uint32_t i = g_topology.m_neighborOffsets[port]; i < g_topology.m_neighborOffsets[port + 1]; i++)
             {
-              Ptr<Node> remoteNode = (*iter)->GetNode ();
+              uint32_t remoteNode = g_topology.m_neighborNodes[i];
 
               // check to see if this node has been pushed before
               // by checking to see if it has a parent
-              // if it doesn't (null or 0), then set its parent and 
+              // if it doesn't, then set its parent and 
               // push to the queue
-              if (parentVector.at (remoteNode->GetId ()) == 0)
-                {
-                  parentVector.at (remoteNode->GetId ()) = currNode;
-                  greyNodeList.push (remoteNode);
-                }
-            }
-        }
-      else
-        {
-          // Iterate over the current node's adjacent vertices
-          // and push them into the queue
-          for (uint32_t i = 0; i < (currNode->GetNDevices ()); i++)
-            {
-              // Get a net device from the node
-              // as well as the channel, and figure
-              // out the adjacent net device
-              Ptr<NetDevice> localNetDevice = currNode->GetDevice (i);
-
-              // make sure that we can go this way
-              if (ipv4)
-                {
-                  uint32_t interfaceIndex = (ipv4)->GetInterfaceForDevice (currNode->GetDevice (i));
-                  if (!(ipv4->IsUp (interfaceIndex)))
-                    {
-                      NS_LOG_LOGIC ("Ipv4Interface is down");
-                      continue;
-                    }
-                }
-              if (!(localNetDevice->IsLinkUp ()))
-                {
-                  NS_LOG_LOGIC ("Link is down.");
-                  continue;
-                }
-              Ptr<Channel> channel = localNetDevice->GetChannel ();
-              if (channel == 0)
-                { 
-                  continue;
-                }
-
-              // this function takes in the local net dev, and channnel, and
-              // writes to the netDeviceContainer the adjacent net devs
-              NetDeviceContainer netDeviceContainer;
-              GetAdjacentNetDevices (localNetDevice, channel, netDeviceContainer);
-
-              // Finally we can get the adjacent nodes
-              // and scan through them.  We push them
-              // to the greyNode queue, if they aren't 
-              // already there.
-              for (NetDeviceContainer::Iterator iter = netDeviceContainer.Begin (); iter != netDeviceContainer.End (); iter++)
+              if (parentVector[remoteNode] == NO_NODE)
                 {
-                  Ptr<Node> remoteNode = (*iter)->GetNode ();
-
-                  // check to see if this node has been pushed before
-                  // by checking to see if it has a parent
-                  // if it doesn't (null or 0), then set its parent and 
-                  // push to the queue
-                  if (parentVector.at (remoteNode->GetId ()) == 0)
-                    {
-                      parentVector.at (remoteNode->GetId ()) = currNode;
-                      greyNodeList.push (remoteNode);
-                    }
+                  parentVector[remoteNode] = currNode;
+                  greyNodeList.push_back (remoteNode);
                 }
             }
         }
-
-      // Pop off the head grey node.  We have all its children.
-      // It is now black.
-      greyNodeList.pop ();
     }
 
   // Didn't find the dest...
-  return false;
+  return dest == NO_NODE;
 }
 
 void 
 Ipv4NixVectorRouting::CheckCacheStateAndFlush (void) const
 {
-  if (g_isCacheDirty)
+  if (m_cacheEpoch != g_epoch)
     {
-      FlushGlobalNixRoutingCache ();
-      g_isCacheDirty = false;
+      FlushCache ();
+      m_cacheEpoch = g_epoch;
     }
 }
 
@@ -22,6 +22,8 @@
 #define IPV4_NIX_VECTOR_ROUTING_H
 
 #include <map>
+#include <list>
+#include <vector>
 
 #include "ns3/channel.h"
 #include "ns3/node-container.h"
@@ -71,8 +73,8 @@ public:
 
   /**
    * @brief Called when run-time link topology change occurs
-   * which iterates through the node list and flushes any
-   * nix vector caches
+   * to flush all the nix vector caches and the topology snapshot.
+   * Each node flushes its caches when it next uses them.
    *
    * \internal
    * \c const is used here due to need to potentially flush the cache
@@ -81,23 +83,108 @@ public:
    */
   void FlushGlobalNixRoutingCache (void) const;
 
+  /**
+   * @brief Precompute the nix-vectors from the given nodes to all the
+   * addresses of the topology and store them in the caches of the nodes
+   *
+   * The breadth-first searches run on the compact snapshot of the topology
+   * and are spread over \p nThreads threads.  Only the nodes which use
+   * nix-vector routing are considered.  Each cache keeps at most
+   * MaxCacheSize entries, if set.
+   *
+   * @param sources the source nodes, e.g., NodeContainer::GetGlobal ()
+   *        for all the pairs of nodes
+   * @param nThreads the number of threads to use
+   */
+  static void PrecomputeNixVectors (NodeContainer sources, uint32_t nThreads = 1);
+
+  /**
+   * @brief Get the number of destinations in the cache of this node
+   * @return the number of cache entries
+   */
+  uint32_t GetNCacheEntries (void) const;
+
+  /**
+   * @brief Get an estimate of the memory used by the cache of this node
+   * @return the number of bytes used by the cached nix-vectors and routes
+   */
+  uint64_t GetCacheMemoryUsage (void) const;
+
 private:
 
-  /* flushes the cache which stores nix-vector based on
-   * destination IP */
-  void FlushNixCache (void) const;
+  /// Cached routing information for a destination
+  struct CacheEntry
+  {
+    Ptr<NixVector> m_nixVector; //!< Nix-vector to the destination, if any
+    Ptr<Ipv4Route> m_route;     //!< Route to the destination, if any
+  };
+
+  /// Cache entries, the most recently used first
+  typedef std::list<std::pair<Ipv4Address, CacheEntry> > CacheList_t;
+  /// Map of destination to cache entry
+  typedef std::map<Ipv4Address, CacheList_t::iterator> CacheMap_t;
 
-  /* flushes the cache which stores the Ipv4 route
-   * based on the destination IP */
-  void FlushIpv4RouteCache (void) const;
+  /**
+   * \brief Compact snapshot of the adjacency of all the nodes
+   *
+   * The ports (net devices attached to a channel) of node \c n are
+   * \c m_portOffsets[n] to \c m_portOffsets[n+1] - 1, and the neighbors
+   * reached through port \c p are \c m_neighborOffsets[p] to
+   * \c m_neighborOffsets[p+1] - 1, in the order in which the neighbor
+   * indexes of the nix-vectors are assigned.
+   */
+  struct Topology
+  {
+    Topology ();
+
+    bool m_valid;    //!< Whether the snapshot has been built
+    uint32_t m_epoch; //!< Cache epoch at which the snapshot was built
+    std::vector<uint32_t> m_portOffsets;     //!< First port of each node, plus the total
+    std::vector<uint32_t> m_portNodes;       //!< Node of each port
+    std::vector<uint32_t> m_portDevices;     //!< Device index of each port on its node
+    std::vector<int32_t> m_portInterfaces;   //!< Ipv4 interface of each port, or -1
+    std::vector<uint32_t> m_neighborOffsets; //!< First neighbor of each port, plus the total
+    std::vector<uint32_t> m_neighborNodes;   //!< Node of each neighbor
+    std::vector<uint32_t> m_nixIndices;      //!< Neighbor index of each neighbor, or NO_NIX
+    std::vector<uint32_t> m_nixNeighbors;    //!< Number of neighbor indexes of each node
+    std::map<Ipv4Address, uint32_t> m_addresses; //!< Node owning each address
+  };
+
+  /// Node, port or neighbor index meaning none
+  static const uint32_t NO_NODE = 0xffffffff;
+  /// Neighbor index of the neighbors reached through a bridge device
+  static const uint32_t NO_NIX = 0xffffffff;
+
+  class PrecomputeTask;
+
+  /* flushes the cache which stores the nix-vectors and
+   * the Ipv4 routes based on destination IP */
+  void FlushCache (void) const;
+
+  /* finds the cache entry of a destination, if any, and
+   * marks it as the most recently used */
+  CacheList_t::iterator FindCacheEntry (Ipv4Address address) const;
+
+  /* finds or creates the cache entry of a destination,
+   * evicting the least recently used entries if needed */
+  CacheList_t::iterator InsertCacheEntry (Ipv4Address address);
+
+  /* stores a nix-vector in the cache */
+  void CacheNixVector (Ipv4Address address, Ptr<NixVector> nixVector);
+
+  /* stores an Ipv4Route in the cache */
+  void CacheIpv4Route (Ipv4Address address, Ptr<Ipv4Route> route);
+
+  /* estimates the memory used by a cache entry */
+  static uint32_t GetEntrySize (const CacheEntry &entry);
 
   /* upon a run-time topology change caches are
    * flushed and the total number of neighbors is
    * reset to zero */
   void ResetTotalNeighbors (void);
 
-  /*  takes in the source node and dest IP and calls GetNodeByIp,
-   *  BFS, accounting for any output interface specified, and finally
+  /*  takes in the source node and dest IP, looks up the dest node
+   *  in the topology snapshot, calls BFS, accounting for any output interface specified, and finally
    *  BuildNixVector to return the built nix-vector */
   Ptr<NixVector> GetNixVector (Ptr<Node>, Ipv4Address, Ptr<NetDevice>);
 
@@ -109,14 +196,17 @@ private:
 
   /* given a net-device returns all the adjacent net-devices,
    * essentially getting the neighbors on that channel */
-  void GetAdjacentNetDevices (Ptr<NetDevice>, Ptr<Channel>, NetDeviceContainer &);
+  static void GetAdjacentNetDevices (Ptr<NetDevice>, Ptr<Channel>, NetDeviceContainer &);
 
-  /* iterates through the node list and finds the one
-   * corresponding to the given Ipv4Address */
-  Ptr<Node> GetNodeByIp (Ipv4Address);
+  /* rebuilds the snapshot of the topology if the caches have
+   * been flushed or nodes added since it was built */
+  static void UpdateTopology (void);
 
-  /* Recurses the parent vector, created by BFS and actually builds the nixvector */
-  bool BuildNixVector (const std::vector< Ptr<Node> > & parentVector, uint32_t source, uint32_t dest, Ptr<NixVector> nixVector);
+  /* tells whether the Ipv4 interface and the link of a port are up */
+  static bool IsPortUp (uint32_t port);
+
+  /* Walks up the parent vector, created by BFS, and actually builds the nixvector */
+  static bool BuildNixVector (const std::vector<uint32_t> & parentVector, uint32_t source, uint32_t dest, Ptr<NixVector> nixVector);
 
   /* special variation of BuildNixVector for when a node is sending to itself */
   bool BuildNixVectorLocal (Ptr<NixVector> nixVector);
@@ -126,26 +216,26 @@ private:
   uint32_t FindTotalNeighbors (void);
 
   /* determine if the netdevice is bridged */
-  Ptr<BridgeNetDevice> NetDeviceIsBridged (Ptr<NetDevice> nd) const;
+  static Ptr<BridgeNetDevice> NetDeviceIsBridged (Ptr<NetDevice> nd);
 
 
   /* Nix index is with respect to the neighbors.  The net-device index must be
    * derived from this */
   uint32_t FindNetDeviceForNixIndex (uint32_t nodeIndex, Ipv4Address & gatewayIp);
 
-  /* Breadth first search algorithm
-   * Param1: total number of nodes
-   * Param2: Source Node
-   * Param3: Dest Node
-   * Param4: (returned) Parent vector for retracing routes
-   * Param5: specific output interface to use from source node, if not null
+  /* Breadth first search algorithm over the topology snapshot
+   * Param1: Source Node id
+   * Param2: Dest Node id, or NO_NODE to reach all the nodes
+   * Param3: (returned) Parent vector for retracing routes
+   * Param4: specific output port to use from source node, or NO_NODE
+   * Param5: state of each port, or null to check the ports on the fly
    * Returns: false if dest not found, true o.w.
    */
-  bool BFS (uint32_t numberOfNodes,
-            Ptr<Node> source,
-            Ptr<Node> dest,
-            std::vector< Ptr<Node> > & parentVector,
-            Ptr<NetDevice> oif);
+  static bool BFS (uint32_t source,
+                   uint32_t dest,
+                   std::vector<uint32_t> & parentVector,
+                   uint32_t oifPort,
+                   const std::vector<uint8_t> *portUp);
 
   void DoDispose (void);
 
@@ -167,16 +257,29 @@ private:
   void CheckCacheStateAndFlush (void) const;
 
   /* 
-   * Flag to mark when caches are dirty and need to be flushed.  
-   * Used for lazy cleanup of caches when there are many topology changes.
+   * Epoch of the caches, incremented when they become dirty.  Each
+   * node flushes its own caches lazily, when it finds that the epoch
+   * has changed since its last flush.
    */
-  static bool g_isCacheDirty;
+  static uint32_t g_epoch;
+
+  /* Snapshot of the topology used by the breadth first searches */
+  static Topology g_topology;
+
+  /* Cache stores nix-vectors and Ipv4Routes based on destination ip */
+  mutable CacheList_t m_cacheList;
+
+  /* Index of the cache entries by destination ip */
+  mutable CacheMap_t m_cache;
+
+  /* Epoch of the caches at the last flush */
+  mutable uint32_t m_cacheEpoch;
 
-  /* Cache stores nix-vectors based on destination ip */
-  mutable NixMap_t m_nixCache;
+  /* Estimated memory used by the cache entries */
+  mutable uint64_t m_cacheBytes;
 
-  /* Cache stores Ipv4Routes based on destination ip */
-  mutable Ipv4RouteMap_t m_ipv4RouteCache;
+  /* Maximum number of cache entries, 0 for no limit */
+  uint32_t m_maxCacheSize;
 
   Ptr<Ipv4> m_ipv4;
   Ptr<Node> m_node;
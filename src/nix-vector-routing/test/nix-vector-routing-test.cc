@@ -0,0 +1,384 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-nix-vector-helper.h"
+#include "ns3/ipv4-nix-vector-routing.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/output-stream-wrapper.h"
+#include "ns3/socket.h"
+#include <sstream>
+
+using namespace ns3;
+
+/**
+ * \ingroup nix-vector-routing
+ * \defgroup nix-vector-routing-test Nix-vector routing tests
+ */
+
+/**
+ * \ingroup nix-vector-routing-test
+ * \ingroup tests
+ *
+ * \brief Base class of the nix-vector routing tests, which builds a
+ * topology of point-to-point links, with two parallel links and a
+ * shared channel
+ */
+class NixVectorRoutingTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   * \param name the name of the test case
+   */
+  NixVectorRoutingTestCase (std::string name);
+
+protected:
+  /// Build the topology
+  void BuildTopology (void);
+
+  /**
+   * \brief Connect nodes to a shared channel
+   * \param nodes the nodes
+   */
+  void Connect (NodeContainer nodes);
+
+  /**
+   * \brief Get the route from a node to an address
+   * \param from the source node
+   * \param to the destination address
+   * \return the route
+   */
+  Ptr<Ipv4Route> RouteOutput (Ptr<Node> from, Ipv4Address to);
+
+  /**
+   * \brief Print the routing table of a node
+   * \param node the node
+   * \return the routing table
+   */
+  std::string PrintRoutingTable (Ptr<Node> node);
+
+  static const uint32_t N_NODES = 8; //!< Number of nodes
+  NodeContainer m_nodes;             //!< The nodes
+  Ipv4AddressHelper m_address;       //!< Address allocator
+  std::vector<Ipv4Address> m_addresses; //!< An address of each node
+  uint32_t m_hops[N_NODES][N_NODES]; //!< Shortest number of hops between the nodes
+};
+
+NixVectorRoutingTestCase::NixVectorRoutingTestCase (std::string name)
+  : TestCase (name)
+{
+}
+
+void
+NixVectorRoutingTestCase::Connect (NodeContainer nodes)
+{
+  SimpleNetDeviceHelper simple;
+  Ipv4InterfaceContainer interfaces = m_address.Assign (simple.Install (nodes));
+  m_address.NewNetwork ();
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      for (uint32_t j = 0; j < nodes.GetN (); j++)
+        {
+          if (i != j)
+            {
+              m_hops[nodes.Get (i)->GetId () - m_nodes.Get (0)->GetId ()]
+                    [nodes.Get (j)->GetId () - m_nodes.Get (0)->GetId ()] = 1;
+            }
+        }
+      m_addresses[nodes.Get (i)->GetId () - m_nodes.Get (0)->GetId ()] = interfaces.GetAddress (i);
+    }
+}
+
+void
+NixVectorRoutingTestCase::BuildTopology (void)
+{
+  m_nodes.Create (N_NODES);
+  InternetStackHelper internet;
+  internet.SetRoutingHelper (Ipv4NixVectorHelper ());
+  internet.Install (m_nodes);
+
+  m_address.SetBase ("10.1.0.0", "255.255.255.0");
+  m_addresses.resize (N_NODES);
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      for (uint32_t j = 0; j < N_NODES; j++)
+        {
+          m_hops[i][j] = (i == j ? 0 : N_NODES);
+        }
+    }
+
+  // a ring, with a chord, a parallel link and a shared channel
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      Connect (NodeContainer (m_nodes.Get (i), m_nodes.Get ((i + 1) % N_NODES)));
+    }
+  Connect (NodeContainer (m_nodes.Get (0), m_nodes.Get (1)));
+  Connect (NodeContainer (m_nodes.Get (1), m_nodes.Get (5)));
+  NodeContainer shared (m_nodes.Get (2), m_nodes.Get (4));
+  shared.Add (m_nodes.Get (7));
+  Connect (shared);
+
+  // Floyd-Warshall
+  for (uint32_t k = 0; k < N_NODES; k++)
+    {
+      for (uint32_t i = 0; i < N_NODES; i++)
+        {
+          for (uint32_t j = 0; j < N_NODES; j++)
+            {
+              m_hops[i][j] = std::min (m_hops[i][j], m_hops[i][k] + m_hops[k][j]);
+            }
+        }
+    }
+}
+
+Ptr<Ipv4Route>
+NixVectorRoutingTestCase::RouteOutput (Ptr<Node> from, Ipv4Address to)
+{
+  Ptr<Ipv4RoutingProtocol> routing = from->GetObject<Ipv4NixVectorRouting> ();
+  Ipv4Header header;
+  header.SetDestination (to);
+  Socket::SocketErrno sockerr;
+  return routing->RouteOutput (Create<Packet> (), header, 0, sockerr);
+}
+
+std::string
+NixVectorRoutingTestCase::PrintRoutingTable (Ptr<Node> node)
+{
+  std::ostringstream oss;
+  Ptr<OutputStreamWrapper> stream = Create<OutputStreamWrapper> (&oss);
+  Ptr<Ipv4RoutingProtocol> routing = node->GetObject<Ipv4NixVectorRouting> ();
+  routing->PrintRoutingTable (stream);
+  return oss.str ();
+}
+
+/**
+ * \ingroup nix-vector-routing-test
+ * \ingroup tests
+ *
+ * \brief Send a packet between each pair of nodes and check that it
+ * arrives after the shortest number of hops
+ */
+class NixVectorRoutingPathTestCase : public NixVectorRoutingTestCase
+{
+public:
+  NixVectorRoutingPathTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Receive the packets of a node
+   * \param socket the receiving socket
+   */
+  void Receive (Ptr<Socket> socket);
+
+  /**
+   * \brief Send a packet
+   * \param socket the sending socket
+   * \param to the destination
+   */
+  void Send (Ptr<Socket> socket, Ipv4Address to);
+
+  uint32_t m_received;   //!< Number of packets received
+};
+
+NixVectorRoutingPathTestCase::NixVectorRoutingPathTestCase ()
+  : NixVectorRoutingTestCase ("Nix-vector routing along the shortest paths"),
+    m_received (0)
+{
+}
+
+void
+NixVectorRoutingPathTestCase::Receive (Ptr<Socket> socket)
+{
+  Ptr<Packet> p;
+  Address from;
+  while ((p = socket->RecvFrom (from)))
+    {
+      SocketIpTtlTag ttl;
+      NS_TEST_ASSERT_MSG_EQ (p->RemovePacketTag (ttl), true, "No TTL tag");
+      uint32_t src = 0;
+      uint32_t dst = socket->GetNode ()->GetId () - m_nodes.Get (0)->GetId ();
+      Ipv4Address fromAddress = InetSocketAddress::ConvertFrom (from).GetIpv4 ();
+      for (uint32_t i = 0; i < N_NODES; i++)
+        {
+          Ptr<Ipv4> ipv4 = m_nodes.Get (i)->GetObject<Ipv4> ();
+          if (ipv4->GetInterfaceForAddress (fromAddress) != -1)
+            {
+              src = i;
+            }
+        }
+      NS_TEST_EXPECT_MSG_EQ (64u - ttl.GetTtl () + 1, m_hops[src][dst],
+                             "Packet from node " << src << " to node " << dst << " not on a shortest path");
+      m_received++;
+    }
+}
+
+void
+NixVectorRoutingPathTestCase::Send (Ptr<Socket> socket, Ipv4Address to)
+{
+  socket->SendTo (Create<Packet> (100), 0, InetSocketAddress (to, 9));
+}
+
+void
+NixVectorRoutingPathTestCase::DoRun (void)
+{
+  BuildTopology ();
+
+  std::vector<Ptr<Socket> > sockets;
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      Ptr<Socket> socket = Socket::CreateSocket (m_nodes.Get (i), UdpSocketFactory::GetTypeId ());
+      socket->Bind (InetSocketAddress (Ipv4Address::GetAny (), 9));
+      socket->SetIpRecvTtl (true);
+      socket->SetRecvCallback (MakeCallback (&NixVectorRoutingPathTestCase::Receive, this));
+      sockets.push_back (socket);
+    }
+  double t = 1.0;
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      for (uint32_t j = 0; j < N_NODES; j++)
+        {
+          if (i != j)
+            {
+              Simulator::Schedule (Seconds (t), &NixVectorRoutingPathTestCase::Send, this,
+                                   sockets[i], m_addresses[j]);
+              t += 0.01;
+            }
+        }
+    }
+
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_received, N_NODES * (N_NODES - 1), "Not all packets received");
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup nix-vector-routing-test
+ * \ingroup tests
+ *
+ * \brief Check that the precomputed nix-vectors are those computed on
+ * demand, and the bound on the size of the caches
+ */
+class NixVectorRoutingCacheTestCase : public NixVectorRoutingTestCase
+{
+public:
+  NixVectorRoutingCacheTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+NixVectorRoutingCacheTestCase::NixVectorRoutingCacheTestCase ()
+  : NixVectorRoutingTestCase ("Nix-vector routing caches")
+{
+}
+
+void
+NixVectorRoutingCacheTestCase::DoRun (void)
+{
+  BuildTopology ();
+
+  // on demand
+  std::vector<std::string> tables;
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      for (uint32_t j = 0; j < N_NODES; j++)
+        {
+          if (i != j)
+            {
+              NS_TEST_EXPECT_MSG_NE (RouteOutput (m_nodes.Get (i), m_addresses[j]), 0,
+                                     "No route from node " << i << " to node " << j);
+            }
+        }
+      tables.push_back (PrintRoutingTable (m_nodes.Get (i)));
+    }
+
+  // precomputed, the routes being added to the caches on demand
+  Ptr<Ipv4NixVectorRouting> routing = m_nodes.Get (0)->GetObject<Ipv4NixVectorRouting> ();
+  routing->FlushGlobalNixRoutingCache ();
+  NS_TEST_EXPECT_MSG_EQ (routing->GetNCacheEntries (), 0, "Cache not flushed");
+  NS_TEST_EXPECT_MSG_EQ (routing->GetCacheMemoryUsage (), 0, "Cache memory not released");
+  Ipv4NixVectorRouting::PrecomputeNixVectors (m_nodes, 3);
+  NS_TEST_EXPECT_MSG_GT (routing->GetNCacheEntries (), N_NODES - 1, "Nix-vectors not precomputed");
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      for (uint32_t j = 0; j < N_NODES; j++)
+        {
+          if (i != j)
+            {
+              RouteOutput (m_nodes.Get (i), m_addresses[j]);
+            }
+        }
+      std::string table = PrintRoutingTable (m_nodes.Get (i));
+      // the precomputed caches also hold the other addresses of the nodes
+      for (uint32_t pos = 0; pos < tables[i].size (); )
+        {
+          uint32_t end = tables[i].find ('\n', pos);
+          std::string line = tables[i].substr (pos, end - pos);
+          NS_TEST_EXPECT_MSG_NE (table.find (line), std::string::npos,
+                                 "Node " << i << " lacks the precomputed entry: " << line);
+          pos = end + 1;
+        }
+    }
+
+  // bounded cache
+  uint64_t unbounded = routing->GetCacheMemoryUsage ();
+  routing->SetAttribute ("MaxCacheSize", UintegerValue (3));
+  routing->FlushGlobalNixRoutingCache ();
+  for (uint32_t j = 1; j < N_NODES; j++)
+    {
+      RouteOutput (m_nodes.Get (0), m_addresses[j]);
+    }
+  NS_TEST_EXPECT_MSG_EQ (routing->GetNCacheEntries (), 3, "Cache not bounded");
+  NS_TEST_EXPECT_MSG_LT (routing->GetCacheMemoryUsage (), unbounded, "Cache memory not bounded");
+  std::ostringstream last;
+  last << m_addresses[N_NODES - 1];
+  std::ostringstream first;
+  first << m_addresses[1];
+  std::string table = PrintRoutingTable (m_nodes.Get (0));
+  NS_TEST_EXPECT_MSG_NE (table.find (last.str ()), std::string::npos, "Most recent entry evicted");
+  NS_TEST_EXPECT_MSG_EQ (table.find (first.str () + " "), std::string::npos, "Least recent entry kept");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup nix-vector-routing-test
+ * \ingroup tests
+ *
+ * \brief Nix-vector routing TestSuite
+ */
+class NixVectorRoutingTestSuite : public TestSuite
+{
+public:
+  NixVectorRoutingTestSuite ()
+    : TestSuite ("nix-vector-routing", UNIT)
+  {
+    AddTestCase (new NixVectorRoutingPathTestCase, TestCase::QUICK);
+    AddTestCase (new NixVectorRoutingCacheTestCase, TestCase::QUICK);
+  }
+};
+
+static NixVectorRoutingTestSuite g_nixVectorRoutingTestSuite; //!< Static variable for test initialization
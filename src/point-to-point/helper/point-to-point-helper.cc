@@ -239,7 +239,7 @@ PointToPointHelper::Install (Ptr<Node> a, Ptr<Node> b)
   Ptr<Queue<Packet> > queueB = m_queueFactory.Create<Queue<Packet> > ();
   devB->SetQueue (queueB);
   // If MPI is enabled, we need to see if both nodes have the same system id 
-  // (rank), and the rank is the same as this instance.  If both are true, 
+  // (rank), and the rank is simulated by this instance.  If both are true, 
   //use a normal p2p channel, otherwise use a remote channel
   bool useNormalChannel = true;
   Ptr<PointToPointChannel> channel = 0;
@@ -248,8 +248,7 @@ PointToPointHelper::Install (Ptr<Node> a, Ptr<Node> b)
     {
       uint32_t n1SystemId = a->GetSystemId ();
       uint32_t n2SystemId = b->GetSystemId ();
-      uint32_t currSystemId = MpiInterface::GetSystemId ();
-      if (n1SystemId != currSystemId || n2SystemId != currSystemId) 
+      if (n1SystemId != n2SystemId || !MpiInterface::IsLocal (n1SystemId))
         {
           useNormalChannel = false;
         }
@@ -106,6 +106,57 @@ PointToPointChannel::TransmitStart (
   return true;
 }
 
+bool
+PointToPointChannel::TransmitTrain (
+  const std::vector<Ptr<Packet> > &packets,
+  Ptr<PointToPointNetDevice> src,
+  const std::vector<Time> &txEnds)
+{
+  NS_LOG_FUNCTION (this << packets.size () << src);
+  NS_ASSERT (!packets.empty () && packets.size () == txEnds.size ());
+
+  NS_ASSERT (m_link[0].m_state != INITIALIZING);
+  NS_ASSERT (m_link[1].m_state != INITIALIZING);
+
+  uint32_t wire = src == m_link[0].m_src ? 0 : 1;
+
+  Ptr<Train> train = Create<Train> ();
+  train->m_dst = m_link[wire].m_dst;
+  train->m_packets = packets;
+  train->m_arrivals.reserve (txEnds.size ());
+  for (uint32_t i = 0; i < txEnds.size (); i++)
+    {
+      train->m_arrivals.push_back (txEnds[i] - txEnds[0]);
+      // Call the tx anim callback on the net device
+      m_txrxPointToPoint (packets[i], src, m_link[wire].m_dst, txEnds[i], txEnds[i] + m_delay);
+    }
+  train->m_next = 0;
+
+  Simulator::ScheduleWithContext (m_link[wire].m_dst->GetNode ()->GetId (),
+                                  txEnds[0] + m_delay, &PointToPointChannel::DeliverTrain,
+                                  this, train);
+  return true;
+}
+
+void
+PointToPointChannel::DeliverTrain (Ptr<Train> train)
+{
+  NS_LOG_FUNCTION (this << train->m_next);
+
+  uint32_t i = train->m_next++;
+  Ptr<Packet> p = train->m_packets[i];
+  train->m_packets[i] = 0;
+  // the next delivery is scheduled before the packet is received, so that
+  // it precedes the events which the receiver schedules at the same time,
+  // as it would if the packets had been transmitted one by one
+  if (train->m_next < train->m_packets.size ())
+    {
+      Simulator::Schedule (train->m_arrivals[i + 1] - train->m_arrivals[i],
+                           &PointToPointChannel::DeliverTrain, this, train);
+    }
+  train->m_dst->Receive (p);
+}
+
 uint32_t 
 PointToPointChannel::GetNDevices (void) const
 {
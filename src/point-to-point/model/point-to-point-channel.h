@@ -20,11 +20,13 @@
 #define POINT_TO_POINT_CHANNEL_H
 
 #include <list>
+#include <vector>
 #include "ns3/channel.h"
 #include "ns3/ptr.h"
 #include "ns3/nstime.h"
 #include "ns3/data-rate.h"
 #include "ns3/traced-callback.h"
+#include "ns3/simple-ref-count.h"
 
 namespace ns3 {
 
@@ -80,6 +82,23 @@ public:
    */
   virtual bool TransmitStart (Ptr<Packet> p, Ptr<PointToPointNetDevice> src, Time txTime);
 
+  /**
+   * \brief Transmit a train of back-to-back packets over this channel
+   *
+   * The packets are delivered to the destination device by a single chained
+   * event, each at the time at which it would have been delivered if
+   * transmitted on its own by TransmitStart.
+   *
+   * \param packets the packets to transmit, in transmission order
+   * \param src Source PointToPointNetDevice
+   * \param txEnds the time, relative to now, at which the transmission of
+   *        each packet ends
+   * \returns true if successful (currently always true)
+   */
+  virtual bool TransmitTrain (const std::vector<Ptr<Packet> > &packets,
+                              Ptr<PointToPointNetDevice> src,
+                              const std::vector<Time> &txEnds);
+
   /**
    * \brief Get number of devices on this channel
    * \returns number of devices on this channel
@@ -152,6 +171,24 @@ private:
   Time          m_delay;    //!< Propagation delay
   int32_t       m_nDevices; //!< Devices of this channel
 
+  /**
+   * \brief A train of packets propagating on a wire
+   */
+  struct Train : public SimpleRefCount<Train>
+  {
+    Ptr<PointToPointNetDevice> m_dst;     //!< Receiving NetDevice
+    std::vector<Ptr<Packet> > m_packets;  //!< Packets of the train
+    std::vector<Time> m_arrivals;         //!< Arrival time of each packet, relative to the first one
+    uint32_t m_next;                      //!< Index of the next packet to deliver
+  };
+
+  /**
+   * \brief Deliver the next packet of a train and schedule the delivery
+   * of the following one
+   * \param train the train
+   */
+  void DeliverTrain (Ptr<Train> train);
+
   /**
    * The trace source for the packet transmission animation events that the 
    * device can fire.
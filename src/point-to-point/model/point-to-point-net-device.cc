@@ -68,6 +68,14 @@ PointToPointNetDevice::GetTypeId (void)
                    TimeValue (Seconds (0.0)),
                    MakeTimeAccessor (&PointToPointNetDevice::m_tInterframeGap),
                    MakeTimeChecker ())
+    .AddAttribute ("MaxTrainSize",
+                   "The maximum number of back-to-back packets waiting in the "
+                   "transmit queue which are transmitted as a train, with a "
+                   "single transmit complete event. A value of 1 disables "
+                   "packet trains.",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&PointToPointNetDevice::m_maxTrainSize),
+                   MakeUintegerChecker<uint32_t> (1))
 
     //
     // Transmit queueing discipline for the device which includes its own set
@@ -178,7 +186,8 @@ PointToPointNetDevice::PointToPointNetDevice ()
     m_txMachineState (READY),
     m_channel (0),
     m_linkUp (false),
-    m_currentPkt (0)
+    m_currentPkt (0),
+    m_maxTrainSize (1)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -236,6 +245,8 @@ PointToPointNetDevice::NotifyNewAggregate (void)
       if (ndqi != 0)
         {
           m_queueInterface = ndqi;
+          // packets larger than the MTU are split when dequeued
+          m_queueInterface->SetSegmentationOffload (true);
         }
     }
   NetDevice::NotifyNewAggregate ();
@@ -249,6 +260,8 @@ PointToPointNetDevice::DoDispose ()
   m_channel = 0;
   m_receiveErrorModel = 0;
   m_currentPkt = 0;
+  m_pendingFrames.clear ();
+  m_train.clear ();
   m_queue = 0;
   m_queueInterface = 0;
   NetDevice::DoDispose ();
@@ -284,6 +297,11 @@ PointToPointNetDevice::TransmitStart (Ptr<Packet> p)
   m_currentPkt = p;
   m_phyTxBeginTrace (m_currentPkt);
 
+  if (m_maxTrainSize > 1 && (!m_pendingFrames.empty () || !m_queue->IsEmpty ()))
+    {
+      return TransmitTrain ();
+    }
+
   Time txTime = m_bps.CalculateBytesTxTime (p->GetSize ());
   Time txCompleteTime = txTime + m_tInterframeGap;
 
@@ -316,8 +334,13 @@ PointToPointNetDevice::TransmitComplete (void)
 
   m_phyTxEndTrace (m_currentPkt);
   m_currentPkt = 0;
+  for (uint32_t i = 1; i < m_train.size (); i++)
+    {
+      m_phyTxEndTrace (m_train[i]);
+    }
+  m_train.clear ();
 
-  Ptr<Packet> p = m_queue->Dequeue ();
+  Ptr<Packet> p = DequeueFrame ();
   if (p == 0)
     {
       NS_LOG_LOGIC ("No pending packets in device queue after tx complete");
@@ -332,6 +355,94 @@ PointToPointNetDevice::TransmitComplete (void)
   TransmitStart (p);
 }
 
+bool
+PointToPointNetDevice::TransmitTrain (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  //
+  // The packets waiting behind the current one are dequeued now and go out
+  // back to back.  The channel is told the time at which the transmission
+  // of each of them ends, and a single event is scheduled for the time at
+  // which the whole train has been transmitted.
+  //
+  m_train.push_back (m_currentPkt);
+  while (m_train.size () < m_maxTrainSize)
+    {
+      Ptr<Packet> p = DequeueFrame ();
+      if (p == 0)
+        {
+          break;
+        }
+      m_snifferTrace (p);
+      m_promiscSnifferTrace (p);
+      m_phyTxBeginTrace (p);
+      m_train.push_back (p);
+    }
+
+  std::vector<Time> txEnds;
+  txEnds.reserve (m_train.size ());
+  Time elapsed = Seconds (0);
+  for (uint32_t i = 0; i < m_train.size (); i++)
+    {
+      elapsed += m_bps.CalculateBytesTxTime (m_train[i]->GetSize ());
+      txEnds.push_back (elapsed);
+      elapsed += m_tInterframeGap;
+    }
+
+  NS_LOG_LOGIC ("Schedule TransmitCompleteEvent in " << elapsed.GetSeconds () << "sec for a train of "
+                << m_train.size () << " packets");
+  Simulator::Schedule (elapsed, &PointToPointNetDevice::TransmitComplete, this);
+
+  bool result = m_channel->TransmitTrain (m_train, this, txEnds);
+  if (result == false)
+    {
+      for (uint32_t i = 0; i < m_train.size (); i++)
+        {
+          m_phyTxDropTrace (m_train[i]);
+        }
+    }
+  return result;
+}
+
+Ptr<Packet>
+PointToPointNetDevice::DequeueFrame (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (!m_pendingFrames.empty ())
+    {
+      Ptr<Packet> frame = m_pendingFrames.front ();
+      m_pendingFrames.pop_front ();
+      return frame;
+    }
+
+  Ptr<Packet> p = m_queue->Dequeue ();
+  if (p == 0 || m_queueInterface == 0 || p->GetSize () <= m_mtu + PppHeader ().GetSerializedSize ())
+    {
+      return p;
+    }
+
+  // split a packet larger than the MTU, e.g., a TCP super-segment. The
+  // packet is copied since trace sinks may hold the dequeued one
+  Ptr<Packet> packet = p->Copy ();
+  uint16_t protocol;
+  ProcessHeader (packet, protocol);
+  m_pendingFrames = m_queueInterface->Segment (protocol, packet);
+  if (m_pendingFrames.empty ())
+    {
+      return p;
+    }
+  NS_LOG_LOGIC ("Split a packet of size " << p->GetSize () << " into " << m_pendingFrames.size () << " frames");
+  for (std::list<Ptr<Packet> >::iterator it = m_pendingFrames.begin (); it != m_pendingFrames.end (); it++)
+    {
+      AddHeader (*it, protocol);
+    }
+  Ptr<Packet> frame = m_pendingFrames.front ();
+  m_pendingFrames.pop_front ();
+  return frame;
+}
+
 bool
 PointToPointNetDevice::Attach (Ptr<PointToPointChannel> ch)
 {
@@ -577,7 +688,7 @@ PointToPointNetDevice::Send (
       // 
       if (m_txMachineState == READY)
         {
-          packet = m_queue->Dequeue ();
+          packet = DequeueFrame ();
           m_snifferTrace (packet);
           m_promiscSnifferTrace (packet);
           bool ret = TransmitStart (packet);
@@ -20,6 +20,8 @@
 #define POINT_TO_POINT_NET_DEVICE_H
 
 #include <cstring>
+#include <list>
+#include <vector>
 #include "ns3/address.h"
 #include "ns3/node.h"
 #include "ns3/net-device.h"
@@ -279,6 +281,32 @@ private:
    */
   void TransmitComplete (void);
 
+  /**
+   * \brief Start sending a train of back-to-back packets down the wire.
+   *
+   * The packets waiting in the device queue behind m_currentPkt, up to
+   * MaxTrainSize packets in total, are dequeued and handed to the channel
+   * at once, which delivers each of them at the same time as if they were
+   * transmitted one by one. A single TransmitComplete event is scheduled
+   * at the end of the train.
+   *
+   * \see PointToPointChannel::TransmitTrain ()
+   * \returns true if success, false on failure
+   */
+  bool TransmitTrain (void);
+
+  /**
+   * \brief Get the next frame to transmit.
+   *
+   * Frames left over from the split of a packet larger than the MTU come
+   * first. Otherwise, a packet is dequeued and, if larger than the MTU,
+   * split into frames by the network protocol through the
+   * NetDeviceQueueInterface.
+   *
+   * \returns the next frame, or 0 if there is nothing to transmit
+   */
+  Ptr<Packet> DequeueFrame (void);
+
   /**
    * \brief Make the link up and running
    *
@@ -461,6 +489,9 @@ private:
   uint32_t m_mtu;
 
   Ptr<Packet> m_currentPkt; //!< Current packet processed
+  std::list<Ptr<Packet> > m_pendingFrames; //!< Frames left over from the split of a packet
+  uint32_t m_maxTrainSize; //!< Maximum number of packets transmitted as a train
+  std::vector<Ptr<Packet> > m_train; //!< Packets of the train being transmitted
 
   /**
    * \brief PPP to Ethernet protocol number mapping
@@ -45,7 +45,8 @@ PointToPointRemoteChannel::GetTypeId (void)
 }
 
 PointToPointRemoteChannel::PointToPointRemoteChannel ()
-  : PointToPointChannel ()
+  : PointToPointChannel (),
+    m_source (0)
 {
 }
 
@@ -53,6 +54,32 @@ PointToPointRemoteChannel::~PointToPointRemoteChannel ()
 {
 }
 
+void
+PointToPointRemoteChannel::DoInitialize (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (GetNDevices () == 2, "Remote channel initialized before both devices are attached");
+  m_source = PeekPointer (GetSource (0));
+  for (uint32_t wire = 0; wire < 2; wire++)
+    {
+      Ptr<PointToPointNetDevice> dst = GetDestination (wire);
+      m_dstNode[wire] = dst->GetNode ()->GetId ();
+      m_dstIfIndex[wire] = dst->GetIfIndex ();
+    }
+  PointToPointChannel::DoInitialize ();
+}
+
+uint32_t
+PointToPointRemoteChannel::GetWire (Ptr<PointToPointNetDevice> src)
+{
+  // PointToPointChannel::IsInitialized only checks the state of the wires
+  if (!Object::IsInitialized ())
+    {
+      Initialize ();
+    }
+  return PeekPointer (src) == m_source ? 0 : 1;
+}
+
 bool
 PointToPointRemoteChannel::TransmitStart (
   Ptr<Packet> p,
@@ -62,18 +89,30 @@ PointToPointRemoteChannel::TransmitStart (
   NS_LOG_FUNCTION (this << p << src);
   NS_LOG_LOGIC ("UID is " << p->GetUid () << ")");
 
-  IsInitialized ();
+  uint32_t wire = GetWire (src);
 
-  uint32_t wire = src == GetSource (0) ? 0 : 1;
-  Ptr<PointToPointNetDevice> dst = GetDestination (wire);
-
-#ifdef NS3_MPI
   // Calculate the rxTime (absolute)
   Time rxTime = Simulator::Now () + txTime + GetDelay ();
-  MpiInterface::SendPacket (p, rxTime, dst->GetNode ()->GetId (), dst->GetIfIndex ());
-#else
-  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
-#endif
+  MpiInterface::SendPacket (p, rxTime, m_dstNode[wire], m_dstIfIndex[wire]);
+  return true;
+}
+
+bool
+PointToPointRemoteChannel::TransmitTrain (
+  const std::vector<Ptr<Packet> > &packets,
+  Ptr<PointToPointNetDevice> src,
+  const std::vector<Time> &txEnds)
+{
+  NS_LOG_FUNCTION (this << packets.size () << src);
+
+  uint32_t wire = GetWire (src);
+
+  for (uint32_t i = 0; i < packets.size (); i++)
+    {
+      // Calculate the rxTime (absolute)
+      Time rxTime = Simulator::Now () + txEnds[i] + GetDelay ();
+      MpiInterface::SendPacket (packets[i], rxTime, m_dstNode[wire], m_dstIfIndex[wire]);
+    }
   return true;
 }
 
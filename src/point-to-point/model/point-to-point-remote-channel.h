@@ -68,6 +68,44 @@ public:
    */
   virtual bool TransmitStart (Ptr<Packet> p, Ptr<PointToPointNetDevice> src,
                               Time txTime);
+
+  /**
+   * \brief Transmit a train of back-to-back packets
+   *
+   * Each packet is sent to the remote system with its own receive time.
+   *
+   * \param packets the packets to transmit, in transmission order
+   * \param src Source PointToPointNetDevice
+   * \param txEnds the time, relative to now, at which the transmission of
+   *        each packet ends
+   * \returns true if successful (currently always true)
+   */
+  virtual bool TransmitTrain (const std::vector<Ptr<Packet> > &packets,
+                              Ptr<PointToPointNetDevice> src,
+                              const std::vector<Time> &txEnds);
+
+protected:
+  /**
+   * \brief Look up the destination of each wire
+   *
+   * The destinations are kept as ids, so that transmitting does not
+   * touch the reference counts of the remote node and device, which
+   * may belong to another thread of a ThreadedSimulatorImpl.
+   */
+  virtual void DoInitialize (void);
+
+private:
+  /**
+   * \brief Get the wire on which a device transmits
+   *
+   * \param src Source PointToPointNetDevice
+   * \returns the index of the wire
+   */
+  uint32_t GetWire (Ptr<PointToPointNetDevice> src);
+
+  PointToPointNetDevice *m_source;  //!< The source of the first wire
+  uint32_t m_dstNode[2];            //!< The id of the destination node of each wire
+  uint32_t m_dstIfIndex[2];         //!< The interface index of the destination of each wire
 };
 
 } // namespace ns3
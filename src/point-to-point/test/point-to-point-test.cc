@@ -24,6 +24,9 @@
 #include "ns3/point-to-point-net-device.h"
 #include "ns3/point-to-point-channel.h"
 #include "ns3/net-device-queue-interface.h"
+#include "ns3/data-rate.h"
+#include "ns3/uinteger.h"
+#include <vector>
 
 using namespace ns3;
 
@@ -101,6 +104,236 @@ PointToPointTest::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \brief Test the lazy split of packets larger than the MTU
+ *
+ * A packet of 3500 bytes is split by the segmentation callback in frames
+ * of at most 1500 bytes when dequeued, which must be received one by one
+ * at the time their own transmission completes.
+ */
+class PointToPointSegmentationTest : public TestCase
+{
+public:
+  PointToPointSegmentationTest ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Split a packet into fragments of at most 1500 bytes
+   * \param packet the packet
+   * \return the fragments
+   */
+  static std::list<Ptr<Packet> > Split (Ptr<Packet> packet);
+
+  /**
+   * \brief Receive a frame
+   * \param device the receiving device
+   * \param packet the packet
+   * \param protocol the protocol number
+   * \param from the sender address
+   * \return true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  std::vector<uint32_t> m_sizes; //!< Sizes of the received packets
+  std::vector<Time> m_times;     //!< Reception times
+};
+
+PointToPointSegmentationTest::PointToPointSegmentationTest ()
+  : TestCase ("PointToPoint split of packets larger than the MTU")
+{
+}
+
+std::list<Ptr<Packet> >
+PointToPointSegmentationTest::Split (Ptr<Packet> packet)
+{
+  std::list<Ptr<Packet> > fragments;
+  for (uint32_t offset = 0; offset < packet->GetSize (); offset += 1500)
+    {
+      fragments.push_back (packet->CreateFragment (offset, std::min<uint32_t> (1500, packet->GetSize () - offset)));
+    }
+  return fragments;
+}
+
+bool
+PointToPointSegmentationTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from)
+{
+  m_sizes.push_back (packet->GetSize ());
+  m_times.push_back (Simulator::Now ());
+  return true;
+}
+
+void
+PointToPointSegmentationTest::DoRun (void)
+{
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+
+  devA->SetDataRate (DataRate ("8Mbps"));
+  devA->Attach (channel);
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+  devB->Attach (channel);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+
+  a->AddDevice (devA);
+  b->AddDevice (devB);
+  devB->SetReceiveCallback (MakeCallback (&PointToPointSegmentationTest::Receive, this));
+
+  Ptr<NetDeviceQueueInterface> ifaceA = CreateObject<NetDeviceQueueInterface> ();
+  devA->AggregateObject (ifaceA);
+  ifaceA->CreateTxQueues ();
+  ifaceA->SetSegmentationCallback (0x800, MakeCallback (&PointToPointSegmentationTest::Split));
+  NS_TEST_EXPECT_MSG_EQ (ifaceA->GetSegmentationOffload (), true, "Segmentation offload not declared");
+
+  Simulator::Schedule (Seconds (1.0), &PointToPointNetDevice::Send, devA,
+                       Create<Packet> (3500), devB->GetAddress (), 0x800);
+  Simulator::Schedule (Seconds (1.0), &PointToPointNetDevice::Send, devA,
+                       Create<Packet> (100), devB->GetAddress (), 0x800);
+
+  Simulator::Run ();
+
+  // the frames are sent back to back, each with a PPP header of 2 bytes
+  uint32_t sizes[] = { 1500, 1500, 500, 100 };
+  Time expected = Seconds (1.0);
+  NS_TEST_EXPECT_MSG_EQ (m_sizes.size (), 4, "Unexpected number of frames");
+  for (uint32_t i = 0; i < 4 && i < m_sizes.size (); i++)
+    {
+      expected += DataRate ("8Mbps").CalculateBytesTxTime (sizes[i] + 2);
+      NS_TEST_EXPECT_MSG_EQ (m_sizes[i], sizes[i], "Unexpected size of frame " << i);
+      NS_TEST_EXPECT_MSG_EQ (m_times[i], expected, "Unexpected time of frame " << i);
+    }
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Test the transmission of back-to-back packets as trains
+ *
+ * The same packets are sent with and without packet trains, and must be
+ * received at the same times, in the same order.
+ */
+class PointToPointTrainTest : public TestCase
+{
+public:
+  PointToPointTrainTest ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Send packets of various sizes over a link and record their reception
+   * \param maxTrainSize the value of the MaxTrainSize attribute of the sender
+   */
+  void RunLink (uint32_t maxTrainSize);
+
+  /**
+   * \brief Receive a frame
+   * \param device the receiving device
+   * \param packet the packet
+   * \param protocol the protocol number
+   * \param from the sender address
+   * \return true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  /**
+   * \brief Count the packets whose transmission ended
+   * \param packet the packet
+   */
+  void TxEnd (Ptr<const Packet> packet);
+
+  std::vector<uint32_t> m_sizes; //!< Sizes of the received packets
+  std::vector<Time> m_times;     //!< Reception times
+  uint32_t m_txEnd;              //!< Number of packets whose transmission ended
+};
+
+PointToPointTrainTest::PointToPointTrainTest ()
+  : TestCase ("PointToPoint packet trains"),
+    m_txEnd (0)
+{
+}
+
+bool
+PointToPointTrainTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from)
+{
+  m_sizes.push_back (packet->GetSize ());
+  m_times.push_back (Simulator::Now ());
+  return true;
+}
+
+void
+PointToPointTrainTest::TxEnd (Ptr<const Packet> packet)
+{
+  m_txEnd++;
+}
+
+void
+PointToPointTrainTest::RunLink (uint32_t maxTrainSize)
+{
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+  channel->SetAttribute ("Delay", TimeValue (MilliSeconds (2)));
+
+  devA->SetDataRate (DataRate ("10Mbps"));
+  devA->SetInterframeGap (MicroSeconds (1));
+  devA->SetAttribute ("MaxTrainSize", UintegerValue (maxTrainSize));
+  devA->Attach (channel);
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+  devA->TraceConnectWithoutContext ("PhyTxEnd", MakeCallback (&PointToPointTrainTest::TxEnd, this));
+  devB->Attach (channel);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+
+  a->AddDevice (devA);
+  b->AddDevice (devB);
+  devB->SetReceiveCallback (MakeCallback (&PointToPointTrainTest::Receive, this));
+
+  // a burst which queues up behind the first packet, then a packet which
+  // arrives while the burst is being transmitted
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      Simulator::Schedule (Seconds (1.0), &PointToPointNetDevice::Send, devA,
+                           Create<Packet> (100 + 137 * i), devB->GetAddress (), 0x800);
+    }
+  Simulator::Schedule (Seconds (1.001), &PointToPointNetDevice::Send, devA,
+                       Create<Packet> (1000), devB->GetAddress (), 0x800);
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+PointToPointTrainTest::DoRun (void)
+{
+  RunLink (1);
+  std::vector<uint32_t> sizes = m_sizes;
+  std::vector<Time> times = m_times;
+  uint32_t txEnd = m_txEnd;
+  NS_TEST_ASSERT_MSG_EQ (sizes.size (), 11, "Unexpected number of packets without trains");
+
+  m_sizes.clear ();
+  m_times.clear ();
+  m_txEnd = 0;
+  RunLink (4);
+  NS_TEST_ASSERT_MSG_EQ (m_sizes.size (), sizes.size (), "Unexpected number of packets with trains");
+  NS_TEST_EXPECT_MSG_EQ (m_txEnd, txEnd, "Unexpected number of PhyTxEnd traces");
+  for (uint32_t i = 0; i < sizes.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_sizes[i], sizes[i], "Unexpected size of packet " << i);
+      NS_TEST_EXPECT_MSG_EQ (m_times[i], times[i], "Unexpected time of packet " << i);
+    }
+}
+
 /**
  * \brief TestSuite for PointToPoint module
  */
@@ -117,6 +350,8 @@ PointToPointTestSuite::PointToPointTestSuite ()
   : TestSuite ("devices-point-to-point", UNIT)
 {
   AddTestCase (new PointToPointTest, TestCase::QUICK);
+  AddTestCase (new PointToPointSegmentationTest, TestCase::QUICK);
+  AddTestCase (new PointToPointTrainTest, TestCase::QUICK);
 }
 
 static PointToPointTestSuite g_pointToPointTestSuite; //!< The testsuite
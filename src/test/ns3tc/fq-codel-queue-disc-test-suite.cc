@@ -485,6 +485,82 @@ FqCoDelQueueDiscUDPFlowsSeparation::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * This class tests that the CoDel algorithm is run on each flow queue
+ */
+class FqCoDelQueueDiscCoDelDrop : public TestCase
+{
+public:
+  FqCoDelQueueDiscCoDelDrop ();
+  virtual ~FqCoDelQueueDiscCoDelDrop ();
+
+private:
+  virtual void DoRun (void);
+  void AddPacket (Ptr<FqCoDelQueueDisc> queue, Ipv4Header hdr);
+  void Dequeue (Ptr<FqCoDelQueueDisc> queue, uint32_t expectedDrops);
+};
+
+FqCoDelQueueDiscCoDelDrop::FqCoDelQueueDiscCoDelDrop ()
+  : TestCase ("Test CoDel drops in a flow queue")
+{
+}
+
+FqCoDelQueueDiscCoDelDrop::~FqCoDelQueueDiscCoDelDrop ()
+{
+}
+
+void
+FqCoDelQueueDiscCoDelDrop::AddPacket (Ptr<FqCoDelQueueDisc> queue, Ipv4Header hdr)
+{
+  Ptr<Packet> p = Create<Packet> (1000);
+  Address dest;
+  Ptr<Ipv4QueueDiscItem> item = Create<Ipv4QueueDiscItem> (p, dest, 0, hdr);
+  queue->Enqueue (item);
+}
+
+void
+FqCoDelQueueDiscCoDelDrop::Dequeue (Ptr<FqCoDelQueueDisc> queue, uint32_t expectedDrops)
+{
+  Ptr<QueueDiscItem> item = queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_NE (item, 0, "a packet should have been dequeued");
+  NS_TEST_EXPECT_MSG_EQ (StaticCast<FqCoDelFlowQueueDisc> (queue->GetQueueDiscClass (0)->GetQueueDisc ())->GetDropCount (), expectedDrops, "unexpected number of CoDel drops");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetTotalDroppedPackets (), expectedDrops, "CoDel drops must be reported by the queue disc");
+}
+
+void
+FqCoDelQueueDiscCoDelDrop::DoRun (void)
+{
+  Ptr<FqCoDelQueueDisc> queueDisc = CreateObjectWithAttributes<FqCoDelQueueDisc> ();
+  Ptr<FqCoDelIpv4PacketFilter> ipv4Filter = CreateObject<FqCoDelIpv4PacketFilter> ();
+  queueDisc->AddPacketFilter (ipv4Filter);
+
+  queueDisc->SetQuantum (1500);
+  queueDisc->Initialize ();
+
+  Ipv4Header hdr;
+  hdr.SetPayloadSize (1000);
+  hdr.SetSource (Ipv4Address ("10.10.1.1"));
+  hdr.SetDestination (Ipv4Address ("10.10.1.2"));
+  hdr.SetProtocol (7);
+
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      AddPacket (queueDisc, hdr);
+    }
+
+  // The sojourn time of the first packet goes above target: no drop yet, the
+  // flow has to stay above target for at least an interval
+  Simulator::Schedule (Seconds (0.2), &FqCoDelQueueDiscCoDelDrop::Dequeue, this, queueDisc, 0);
+  // An interval later, CoDel drops the head packet and enters the dropping state
+  Simulator::Schedule (Seconds (0.4), &FqCoDelQueueDiscCoDelDrop::Dequeue, this, queueDisc, 1);
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->QueueDisc::GetNPackets (), 7, "unexpected number of packets in the queue disc");
+  NS_TEST_ASSERT_MSG_EQ (queueDisc->GetQueueDiscClass (0)->GetQueueDisc ()->GetNPackets (), 7, "unexpected number of packets in the flow queue");
+
+  Simulator::Destroy ();
+}
+
 class FqCoDelQueueDiscTestSuite : public TestSuite
 {
 public:
@@ -499,6 +575,7 @@ FqCoDelQueueDiscTestSuite::FqCoDelQueueDiscTestSuite ()
   AddTestCase (new FqCoDelQueueDiscDeficit, TestCase::QUICK);
   AddTestCase (new FqCoDelQueueDiscTCPFlowsSeparation, TestCase::QUICK);
   AddTestCase (new FqCoDelQueueDiscUDPFlowsSeparation, TestCase::QUICK);
+  AddTestCase (new FqCoDelQueueDiscCoDelDrop, TestCase::QUICK);
 }
 
 static FqCoDelQueueDiscTestSuite fqCoDelQueueDiscTestSuite;
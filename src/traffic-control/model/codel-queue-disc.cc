@@ -145,78 +145,11 @@ CoDelTimestampTag::GetTxTime (void) const
   return TimeStep (m_creationTime);
 }
 
-NS_OBJECT_ENSURE_REGISTERED (CoDelQueueDisc);
-
-TypeId CoDelQueueDisc::GetTypeId (void)
-{
-  static TypeId tid = TypeId ("ns3::CoDelQueueDisc")
-    .SetParent<QueueDisc> ()
-    .SetGroupName ("TrafficControl")
-    .AddConstructor<CoDelQueueDisc> ()
-    .AddAttribute ("Mode",
-                   "Whether to use Bytes (see MaxBytes) or Packets (see MaxPackets) as the maximum queue size metric.",
-                   EnumValue (QUEUE_DISC_MODE_BYTES),
-                   MakeEnumAccessor (&CoDelQueueDisc::SetMode),
-                   MakeEnumChecker (QUEUE_DISC_MODE_BYTES, "QUEUE_DISC_MODE_BYTES",
-                                    QUEUE_DISC_MODE_PACKETS, "QUEUE_DISC_MODE_PACKETS"))
-    .AddAttribute ("MaxPackets",
-                   "The maximum number of packets accepted by this CoDelQueueDisc.",
-                   UintegerValue (DEFAULT_CODEL_LIMIT),
-                   MakeUintegerAccessor (&CoDelQueueDisc::m_maxPackets),
-                   MakeUintegerChecker<uint32_t> ())
-    .AddAttribute ("MaxBytes",
-                   "The maximum number of bytes accepted by this CoDelQueueDisc.",
-                   UintegerValue (1500 * DEFAULT_CODEL_LIMIT),
-                   MakeUintegerAccessor (&CoDelQueueDisc::m_maxBytes),
-                   MakeUintegerChecker<uint32_t> ())
-    .AddAttribute ("MinBytes",
-                   "The CoDel algorithm minbytes parameter.",
-                   UintegerValue (1500),
-                   MakeUintegerAccessor (&CoDelQueueDisc::m_minBytes),
-                   MakeUintegerChecker<uint32_t> ())
-    .AddAttribute ("Interval",
-                   "The CoDel algorithm interval",
-                   StringValue ("100ms"),
-                   MakeTimeAccessor (&CoDelQueueDisc::m_interval),
-                   MakeTimeChecker ())
-    .AddAttribute ("Target",
-                   "The CoDel algorithm target queue delay",
-                   StringValue ("5ms"),
-                   MakeTimeAccessor (&CoDelQueueDisc::m_target),
-                   MakeTimeChecker ())
-    .AddTraceSource ("Count",
-                     "CoDel count",
-                     MakeTraceSourceAccessor (&CoDelQueueDisc::m_count),
-                     "ns3::TracedValueCallback::Uint32")
-    .AddTraceSource ("DropCount",
-                     "CoDel drop count",
-                     MakeTraceSourceAccessor (&CoDelQueueDisc::m_dropCount),
-                     "ns3::TracedValueCallback::Uint32")
-    .AddTraceSource ("LastCount",
-                     "CoDel lastcount",
-                     MakeTraceSourceAccessor (&CoDelQueueDisc::m_lastCount),
-                     "ns3::TracedValueCallback::Uint32")
-    .AddTraceSource ("DropState",
-                     "Dropping state",
-                     MakeTraceSourceAccessor (&CoDelQueueDisc::m_dropping),
-                     "ns3::TracedValueCallback::Bool")
-    .AddTraceSource ("Sojourn",
-                     "Time in the queue",
-                     MakeTraceSourceAccessor (&CoDelQueueDisc::m_sojourn),
-                     "ns3::Time::TracedValueCallback")
-    .AddTraceSource ("DropNext",
-                     "Time until next packet drop",
-                     MakeTraceSourceAccessor (&CoDelQueueDisc::m_dropNext),
-                     "ns3::TracedValueCallback::Uint32")
-  ;
-
-  return tid;
-}
-
-CoDelQueueDisc::CoDelQueueDisc ()
-  : QueueDisc (),
-    m_maxBytes (),
-    m_count (0),
+CoDelAlgorithm::CoDelAlgorithm ()
+  : m_minBytes (1500),
+    m_interval (MilliSeconds (100)),
+    m_target (MilliSeconds (5)),
+    m_dropStateCount (0),
     m_dropCount (0),
     m_lastCount (0),
     m_dropping (false),
@@ -227,24 +160,23 @@ CoDelQueueDisc::CoDelQueueDisc ()
     m_state2 (0),
     m_state3 (0),
     m_states (0),
-    m_dropOverLimit (0),
     m_sojourn (0)
 {
   NS_LOG_FUNCTION (this);
 }
 
-CoDelQueueDisc::~CoDelQueueDisc ()
+CoDelAlgorithm::~CoDelAlgorithm ()
 {
   NS_LOG_FUNCTION (this);
 }
 
 void
-CoDelQueueDisc::NewtonStep (void)
+CoDelAlgorithm::NewtonStep (void)
 {
   NS_LOG_FUNCTION (this);
   uint32_t invsqrt = ((uint32_t) m_recInvSqrt) << REC_INV_SQRT_SHIFT;
   uint32_t invsqrt2 = ((uint64_t) invsqrt * invsqrt) >> 32;
-  uint64_t val = (3ll << 32) - ((uint64_t) m_count * invsqrt2);
+  uint64_t val = (3ll << 32) - ((uint64_t) m_dropStateCount * invsqrt2);
 
   val >>= 2; /* avoid overflow */
   val = (val * invsqrt) >> (32 - 2 + 1);
@@ -252,68 +184,16 @@ CoDelQueueDisc::NewtonStep (void)
 }
 
 uint32_t
-CoDelQueueDisc::ControlLaw (uint32_t t)
+CoDelAlgorithm::ControlLaw (uint32_t t)
 {
   NS_LOG_FUNCTION (this);
   return t + ReciprocalDivide (Time2CoDel (m_interval), m_recInvSqrt << REC_INV_SQRT_SHIFT);
 }
 
-void
-CoDelQueueDisc::SetMode (QueueDiscMode mode)
-{
-  NS_LOG_FUNCTION (mode);
-  m_mode = mode;
-}
-
-CoDelQueueDisc::QueueDiscMode
-CoDelQueueDisc::GetMode (void)
-{
-  NS_LOG_FUNCTION (this);
-  return m_mode;
-}
-
 bool
-CoDelQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
-{
-  NS_LOG_FUNCTION (this << item);
-  Ptr<Packet> p = item->GetPacket ();
-
-  if (m_mode == QUEUE_DISC_MODE_PACKETS && (GetInternalQueue (0)->GetNPackets () + 1 > m_maxPackets))
-    {
-      NS_LOG_LOGIC ("Queue full (at max packets) -- droppping pkt");
-      Drop (item);
-      ++m_dropOverLimit;
-      return false;
-    }
-
-  if (m_mode == QUEUE_DISC_MODE_BYTES && (GetInternalQueue (0)->GetNBytes () + item->GetSize () > m_maxBytes))
-    {
-      NS_LOG_LOGIC ("Queue full (packet would exceed max bytes) -- droppping pkt");
-      Drop (item);
-      ++m_dropOverLimit;
-      return false;
-    }
-
-  // Tag packet with current time for DoDequeue() to compute sojourn time
-  CoDelTimestampTag tag;
-  p->AddPacketTag (tag);
-
-  bool retval = GetInternalQueue (0)->Enqueue (item);
-
-  // If Queue::Enqueue fails, QueueDisc::Drop is called by the internal queue
-  // because QueueDisc::AddInternalQueue sets the drop callback
-
-  NS_LOG_LOGIC ("Number packets " << GetInternalQueue (0)->GetNPackets ());
-  NS_LOG_LOGIC ("Number bytes " << GetInternalQueue (0)->GetNBytes ());
-
-  return retval;
-}
-
-bool
-CoDelQueueDisc::OkToDrop (Ptr<QueueDiscItem> item, uint32_t now)
+CoDelAlgorithm::OkToDrop (Ptr<QueueDiscItem> item, Time tstamp, uint32_t now)
 {
   NS_LOG_FUNCTION (this);
-  CoDelTimestampTag tag;
   bool okToDrop;
 
   if (!item)
@@ -322,16 +202,13 @@ CoDelQueueDisc::OkToDrop (Ptr<QueueDiscItem> item, uint32_t now)
       return false;
     }
 
-  bool found = item->GetPacket ()->RemovePacketTag (tag);
-  NS_ASSERT_MSG (found, "found a packet without an input timestamp tag");
-  NS_UNUSED (found);    //silence compiler warning
-  Time delta = Simulator::Now () - tag.GetTxTime ();
+  Time delta = Simulator::Now () - tstamp;
   NS_LOG_INFO ("Sojourn time " << delta.GetSeconds ());
   m_sojourn = delta;
   uint32_t sojournTime = Time2CoDel (delta);
 
   if (CoDelTimeBefore (sojournTime, Time2CoDel (m_target))
-      || GetInternalQueue (0)->GetNBytes () < m_minBytes)
+      || CoDelGetNBytes () < m_minBytes)
     {
       // went below so we'll stay below for at least q->interval
       NS_LOG_LOGIC ("Sojourn time is below target or number of bytes in queue is less than minBytes; packet should not be dropped");
@@ -357,11 +234,12 @@ CoDelQueueDisc::OkToDrop (Ptr<QueueDiscItem> item, uint32_t now)
 }
 
 Ptr<QueueDiscItem>
-CoDelQueueDisc::DoDequeue (void)
+CoDelAlgorithm::CoDelDequeue (void)
 {
   NS_LOG_FUNCTION (this);
 
-  Ptr<QueueDiscItem> item = GetInternalQueue (0)->Dequeue ();
+  Time tstamp;
+  Ptr<QueueDiscItem> item = CoDelPop (tstamp);
   if (!item)
     {
       // Leave dropping state when queue is empty
@@ -372,11 +250,9 @@ CoDelQueueDisc::DoDequeue (void)
   uint32_t now = CoDelGetTime ();
 
   NS_LOG_LOGIC ("Popped " << item);
-  NS_LOG_LOGIC ("Number packets remaining " << GetInternalQueue (0)->GetNPackets ());
-  NS_LOG_LOGIC ("Number bytes remaining " << GetInternalQueue (0)->GetNBytes ());
 
   // Determine if item should be dropped
-  bool okToDrop = OkToDrop (item, now);
+  bool okToDrop = OkToDrop (item, tstamp, now);
 
   if (m_dropping)
     { // In the dropping state (sojourn time has gone above target and hasn't come down yet)
@@ -400,21 +276,14 @@ CoDelQueueDisc::DoDequeue (void)
               // rates so high that the next drop should happen now,
               // hence the while loop.
               NS_LOG_LOGIC ("Sojourn time is still above target and it's time for next drop; dropping " << item);
-              Drop (item);
+              CoDelDrop (item);
 
               ++m_dropCount;
-              ++m_count;
+              ++m_dropStateCount;
               NewtonStep ();
-              item = GetInternalQueue (0)->Dequeue ();
-
-              if (item)
-                {
-                  NS_LOG_LOGIC ("Popped " << item);
-                  NS_LOG_LOGIC ("Number packets remaining " << GetInternalQueue (0)->GetNPackets ());
-                  NS_LOG_LOGIC ("Number bytes remaining " << GetInternalQueue (0)->GetNBytes ());
-                }
+              item = CoDelPop (tstamp);
 
-              if (!OkToDrop (item, now))
+              if (!OkToDrop (item, tstamp, now))
                 {
                   /* leave dropping state */
                   NS_LOG_LOGIC ("Leaving dropping state");
@@ -440,18 +309,11 @@ CoDelQueueDisc::DoDequeue (void)
           // Drop the first packet and enter dropping state unless the queue is empty
           NS_LOG_LOGIC ("Sojourn time goes above target, dropping the first packet " << item << " and entering the dropping state");
           ++m_dropCount;
-          Drop (item);
+          CoDelDrop (item);
 
-          item = GetInternalQueue (0)->Dequeue ();
+          item = CoDelPop (tstamp);
 
-          if (item)
-            {
-              NS_LOG_LOGIC ("Popped " << item);
-              NS_LOG_LOGIC ("Number packets remaining " << GetInternalQueue (0)->GetNPackets ());
-              NS_LOG_LOGIC ("Number bytes remaining " << GetInternalQueue (0)->GetNBytes ());
-            }
-
-          OkToDrop (item, now);
+          OkToDrop (item, tstamp, now);
           m_dropping = true;
           ++m_state3;
           /*
@@ -459,18 +321,18 @@ CoDelQueueDisc::DoDequeue (void)
            * assume that the drop rate that controlled the queue on the
            * last cycle is a good starting point to control it now.
            */
-          int delta = m_count - m_lastCount;
+          int delta = m_dropStateCount - m_lastCount;
           if (delta > 1 && CoDelTimeBefore (now - m_dropNext, 16 * Time2CoDel (m_interval)))
             {
-              m_count = delta;
+              m_dropStateCount = delta;
               NewtonStep ();
             }
           else
             {
-              m_count = 1;
+              m_dropStateCount = 1;
               m_recInvSqrt = ~0U >> REC_INV_SQRT_SHIFT;
             }
-          m_lastCount = m_count;
+          m_lastCount = m_dropStateCount;
           NS_LOG_LOGIC ("Running ControlLaw for input now: " << (double)now);
           m_dropNext = ControlLaw (now);
           NS_LOG_LOGIC ("Scheduled next drop at " << (double)m_dropNext / 1000000 << " now " << (double)now / 1000000);
@@ -480,6 +342,213 @@ CoDelQueueDisc::DoDequeue (void)
   return item;
 }
 
+bool
+CoDelAlgorithm::CoDelTimeAfter (uint32_t a, uint32_t b)
+{
+  return  ((int)(a) - (int)(b) > 0);
+}
+
+bool
+CoDelAlgorithm::CoDelTimeAfterEq (uint32_t a, uint32_t b)
+{
+  return ((int)(a) - (int)(b) >= 0);
+}
+
+bool
+CoDelAlgorithm::CoDelTimeBefore (uint32_t a, uint32_t b)
+{
+  return  ((int)(a) - (int)(b) < 0);
+}
+
+bool
+CoDelAlgorithm::CoDelTimeBeforeEq (uint32_t a, uint32_t b)
+{
+  return ((int)(a) - (int)(b) <= 0);
+}
+
+uint32_t
+CoDelAlgorithm::Time2CoDel (Time t)
+{
+  return (t.GetNanoSeconds () >> CODEL_SHIFT);
+}
+
+
+NS_OBJECT_ENSURE_REGISTERED (CoDelQueueDisc);
+
+TypeId CoDelQueueDisc::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CoDelQueueDisc")
+    .SetParent<QueueDisc> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<CoDelQueueDisc> ()
+    .AddAttribute ("Mode",
+                   "Whether to use Bytes (see MaxBytes) or Packets (see MaxPackets) as the maximum queue size metric.",
+                   EnumValue (QUEUE_DISC_MODE_BYTES),
+                   MakeEnumAccessor (&CoDelQueueDisc::SetMode),
+                   MakeEnumChecker (QUEUE_DISC_MODE_BYTES, "QUEUE_DISC_MODE_BYTES",
+                                    QUEUE_DISC_MODE_PACKETS, "QUEUE_DISC_MODE_PACKETS"))
+    .AddAttribute ("MaxPackets",
+                   "The maximum number of packets accepted by this CoDelQueueDisc.",
+                   UintegerValue (DEFAULT_CODEL_LIMIT),
+                   MakeUintegerAccessor (&CoDelQueueDisc::m_maxPackets),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxBytes",
+                   "The maximum number of bytes accepted by this CoDelQueueDisc.",
+                   UintegerValue (1500 * DEFAULT_CODEL_LIMIT),
+                   MakeUintegerAccessor (&CoDelQueueDisc::m_maxBytes),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MinBytes",
+                   "The CoDel algorithm minbytes parameter.",
+                   UintegerValue (1500),
+                   MakeUintegerAccessor (&CoDelQueueDisc::m_minBytes),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Interval",
+                   "The CoDel algorithm interval",
+                   StringValue ("100ms"),
+                   MakeTimeAccessor (&CoDelQueueDisc::m_interval),
+                   MakeTimeChecker ())
+    .AddAttribute ("Target",
+                   "The CoDel algorithm target queue delay",
+                   StringValue ("5ms"),
+                   MakeTimeAccessor (&CoDelQueueDisc::m_target),
+                   MakeTimeChecker ())
+    .AddTraceSource ("Count",
+                     "CoDel count",
+                     MakeTraceSourceAccessor (&CoDelQueueDisc::m_dropStateCount),
+                     "ns3::TracedValueCallback::Uint32")
+    .AddTraceSource ("DropCount",
+                     "CoDel drop count",
+                     MakeTraceSourceAccessor (&CoDelQueueDisc::m_dropCount),
+                     "ns3::TracedValueCallback::Uint32")
+    .AddTraceSource ("LastCount",
+                     "CoDel lastcount",
+                     MakeTraceSourceAccessor (&CoDelQueueDisc::m_lastCount),
+                     "ns3::TracedValueCallback::Uint32")
+    .AddTraceSource ("DropState",
+                     "Dropping state",
+                     MakeTraceSourceAccessor (&CoDelQueueDisc::m_dropping),
+                     "ns3::TracedValueCallback::Bool")
+    .AddTraceSource ("Sojourn",
+                     "Time in the queue",
+                     MakeTraceSourceAccessor (&CoDelQueueDisc::m_sojourn),
+                     "ns3::Time::TracedValueCallback")
+    .AddTraceSource ("DropNext",
+                     "Time until next packet drop",
+                     MakeTraceSourceAccessor (&CoDelQueueDisc::m_dropNext),
+                     "ns3::TracedValueCallback::Uint32")
+  ;
+
+  return tid;
+}
+
+CoDelQueueDisc::CoDelQueueDisc ()
+  : QueueDisc (),
+    CoDelAlgorithm (),
+    m_maxBytes (),
+    m_dropOverLimit (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+CoDelQueueDisc::~CoDelQueueDisc ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+CoDelQueueDisc::SetMode (QueueDiscMode mode)
+{
+  NS_LOG_FUNCTION (mode);
+  m_mode = mode;
+}
+
+CoDelQueueDisc::QueueDiscMode
+CoDelQueueDisc::GetMode (void)
+{
+  NS_LOG_FUNCTION (this);
+  return m_mode;
+}
+
+bool
+CoDelQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+  Ptr<Packet> p = item->GetPacket ();
+
+  if (m_mode == QUEUE_DISC_MODE_PACKETS && (GetInternalQueue (0)->GetNPackets () + 1 > m_maxPackets))
+    {
+      NS_LOG_LOGIC ("Queue full (at max packets) -- droppping pkt");
+      Drop (item);
+      ++m_dropOverLimit;
+      return false;
+    }
+
+  if (m_mode == QUEUE_DISC_MODE_BYTES && (GetInternalQueue (0)->GetNBytes () + item->GetSize () > m_maxBytes))
+    {
+      NS_LOG_LOGIC ("Queue full (packet would exceed max bytes) -- droppping pkt");
+      Drop (item);
+      ++m_dropOverLimit;
+      return false;
+    }
+
+  // Tag packet with current time for DoDequeue() to compute sojourn time
+  CoDelTimestampTag tag;
+  p->AddPacketTag (tag);
+
+  bool retval = GetInternalQueue (0)->Enqueue (item);
+
+  // If Queue::Enqueue fails, QueueDisc::Drop is called by the internal queue
+  // because QueueDisc::AddInternalQueue sets the drop callback
+
+  NS_LOG_LOGIC ("Number packets " << GetInternalQueue (0)->GetNPackets ());
+  NS_LOG_LOGIC ("Number bytes " << GetInternalQueue (0)->GetNBytes ());
+
+  return retval;
+}
+
+Ptr<QueueDiscItem>
+CoDelQueueDisc::DoDequeue (void)
+{
+  NS_LOG_FUNCTION (this);
+  return CoDelDequeue ();
+}
+
+Ptr<QueueDiscItem>
+CoDelQueueDisc::CoDelPop (Time &tstamp)
+{
+  NS_LOG_FUNCTION (this);
+
+  Ptr<QueueDiscItem> item = GetInternalQueue (0)->Dequeue ();
+  if (!item)
+    {
+      return 0;
+    }
+
+  CoDelTimestampTag tag;
+  bool found = item->GetPacket ()->RemovePacketTag (tag);
+  NS_ASSERT_MSG (found, "found a packet without an input timestamp tag");
+  NS_UNUSED (found);    //silence compiler warning
+  tstamp = tag.GetTxTime ();
+
+  NS_LOG_LOGIC ("Number packets remaining " << GetInternalQueue (0)->GetNPackets ());
+  NS_LOG_LOGIC ("Number bytes remaining " << GetInternalQueue (0)->GetNBytes ());
+
+  return item;
+}
+
+uint32_t
+CoDelQueueDisc::CoDelGetNBytes (void) const
+{
+  return GetInternalQueue (0)->GetNBytes ();
+}
+
+void
+CoDelQueueDisc::CoDelDrop (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+  Drop (item);
+}
+
 uint32_t
 CoDelQueueDisc::GetQueueSize (void)
 {
@@ -547,36 +616,6 @@ CoDelQueueDisc::DoPeek (void) const
   return item;
 }
 
-bool
-CoDelQueueDisc::CoDelTimeAfter (uint32_t a, uint32_t b)
-{
-  return  ((int)(a) - (int)(b) > 0);
-}
-
-bool
-CoDelQueueDisc::CoDelTimeAfterEq (uint32_t a, uint32_t b)
-{
-  return ((int)(a) - (int)(b) >= 0);
-}
-
-bool
-CoDelQueueDisc::CoDelTimeBefore (uint32_t a, uint32_t b)
-{
-  return  ((int)(a) - (int)(b) < 0);
-}
-
-bool
-CoDelQueueDisc::CoDelTimeBeforeEq (uint32_t a, uint32_t b)
-{
-  return ((int)(a) - (int)(b) <= 0);
-}
-
-uint32_t
-CoDelQueueDisc::Time2CoDel (Time t)
-{
-  return (t.GetNanoSeconds () >> CODEL_SHIFT);
-}
-
 bool
 CoDelQueueDisc::CheckConfig (void)
 {
@@ -52,13 +52,150 @@ static const int  CODEL_SHIFT = 10;
 
 class TraceContainer;
 
+/**
+ * \ingroup traffic-control
+ *
+ * \brief The CoDel algorithm, run on a FIFO queue of packets
+ *
+ * This class keeps the state of the CoDel algorithm and implements its
+ * dequeue routine, which is shared by CoDelQueueDisc and by the queue discs
+ * of the FqCoDel flow queues. The subclasses give access to their packets by
+ * implementing CoDelPop, CoDelGetNBytes and CoDelDrop, and export the traced
+ * values of the state as trace sources.
+ */
+class CoDelAlgorithm
+{
+public:
+  /**
+   * \brief CoDelAlgorithm Constructor
+   */
+  CoDelAlgorithm ();
+
+  virtual ~CoDelAlgorithm ();
+
+protected:
+  /**
+   * \brief Remove a packet from queue based on the current state
+   * If we are in dropping state, check if we could leave the dropping state
+   * or if we should perform next drop
+   * If we are not currently in dropping state, check if we need to enter the state
+   * and drop the first packet
+   *
+   * \returns The packet that is examined
+   */
+  Ptr<QueueDiscItem> CoDelDequeue (void);
+
+  /**
+   * \brief Calculate the reciprocal square root of m_dropStateCount by using Newton's method
+   *  http://en.wikipedia.org/wiki/Methods_of_computing_square_roots#Iterative_methods_for_reciprocal_square_roots
+   * m_recInvSqrt (new) = (m_recInvSqrt (old) / 2) * (3 - m_dropStateCount * m_recInvSqrt^2)
+   */
+  void NewtonStep (void);
+
+  /**
+   * \brief Determine the time for next drop
+   * CoDel control law is t + m_interval/sqrt(m_dropStateCount).
+   * Here, we use m_recInvSqrt calculated by Newton's method in NewtonStep() to avoid
+   * both sqrt() and divide operations
+   *
+   * \param t Current next drop time
+   * \returns The new next drop time:
+   */
+  uint32_t ControlLaw (uint32_t t);
+
+  /**
+   * \brief Determine whether a packet is OK to be dropped. The packet
+   * may not be actually dropped (depending on the drop state)
+   *
+   * \param item The packet that is considered
+   * \param tstamp The time the packet was enqueued
+   * \param now The current time represented as 32-bit unsigned integer (us)
+   * \returns True if it is OK to drop the packet (sojourn time above target for at least interval)
+   */
+  bool OkToDrop (Ptr<QueueDiscItem> item, Time tstamp, uint32_t now);
+
+  /**
+   * Check if CoDel time a is successive to b
+   * @param a left operand
+   * @param b right operand
+   * @return true if a is greater than b
+   */
+  static bool CoDelTimeAfter (uint32_t a, uint32_t b);
+  /**
+   * Check if CoDel time a is successive or equal to b
+   * @param a left operand
+   * @param b right operand
+   * @return true if a is greater than or equal to b
+   */
+  static bool CoDelTimeAfterEq (uint32_t a, uint32_t b);
+  /**
+   * Check if CoDel time a is preceding b
+   * @param a left operand
+   * @param b right operand
+   * @return true if a is less than to b
+   */
+  static bool CoDelTimeBefore (uint32_t a, uint32_t b);
+  /**
+   * Check if CoDel time a is preceding or equal to b
+   * @param a left operand
+   * @param b right operand
+   * @return true if a is less than or equal to b
+   */
+  static bool CoDelTimeBeforeEq (uint32_t a, uint32_t b);
+
+  /**
+   * Return the unsigned 32-bit integer representation of the input Time
+   * object. Units are microseconds
+   * @param t the input Time Object
+   * @return the unsigned 32-bit integer representation
+   */
+  static uint32_t Time2CoDel (Time t);
+
+  uint32_t m_minBytes;                    //!< Minimum bytes in queue to allow a packet drop
+  Time m_interval;                        //!< 100 ms sliding minimum time window width
+  Time m_target;                          //!< 5 ms target queue delay
+  TracedValue<uint32_t> m_dropStateCount; //!< Number of packets dropped since entering drop state
+  TracedValue<uint32_t> m_dropCount;      //!< Number of dropped packets according CoDel algorithm
+  TracedValue<uint32_t> m_lastCount;      //!< Last number of packets dropped since entering drop state
+  TracedValue<bool> m_dropping;           //!< True if in dropping state
+  uint16_t m_recInvSqrt;                  //!< Reciprocal inverse square root
+  uint32_t m_firstAboveTime;              //!< Time to declare sojourn time above target
+  TracedValue<uint32_t> m_dropNext;       //!< Time to drop next packet
+  uint32_t m_state1;                      //!< Number of times packet sojourn goes above target for interval
+  uint32_t m_state2;                      //!< Number of times we perform next drop while in dropping state
+  uint32_t m_state3;                      //!< Number of times we enter drop state and drop the fist packet
+  uint32_t m_states;                      //!< Total number of times we are in state 1, state 2, or state 3
+  TracedValue<Time> m_sojourn;            //!< Time in queue
+
+private:
+  /**
+   * \brief Remove the packet at the head of the queue
+   *
+   * \param [out] tstamp The time the packet was enqueued
+   * \returns The packet, or 0 if the queue is empty
+   */
+  virtual Ptr<QueueDiscItem> CoDelPop (Time &tstamp) = 0;
+  /**
+   * \brief Get the number of bytes left in the queue
+   *
+   * \returns The number of bytes left in the queue
+   */
+  virtual uint32_t CoDelGetNBytes (void) const = 0;
+  /**
+   * \brief Drop a packet removed from the queue
+   *
+   * \param item The packet to drop
+   */
+  virtual void CoDelDrop (Ptr<QueueDiscItem> item) = 0;
+};
+
 /**
  * \ingroup traffic-control
  *
  * \brief A CoDel packet queue disc
  */
 
-class CoDelQueueDisc : public QueueDisc
+class CoDelQueueDisc : public QueueDisc, public CoDelAlgorithm
 {
 public:
   /**
@@ -157,104 +294,25 @@ private:
 
   /**
    * \brief Remove a packet from queue based on the current state
-   * If we are in dropping state, check if we could leave the dropping state
-   * or if we should perform next drop
-   * If we are not currently in dropping state, check if we need to enter the state
-   * and drop the first packet
    *
    * \returns The packet that is examined
+   * \see CoDelAlgorithm::CoDelDequeue
    */
   virtual Ptr<QueueDiscItem> DoDequeue (void);
 
   virtual Ptr<const QueueDiscItem> DoPeek (void) const;
   virtual bool CheckConfig (void);
 
-  /**
-   * \brief Calculate the reciprocal square root of m_count by using Newton's method
-   *  http://en.wikipedia.org/wiki/Methods_of_computing_square_roots#Iterative_methods_for_reciprocal_square_roots
-   * m_recInvSqrt (new) = (m_recInvSqrt (old) / 2) * (3 - m_count * m_recInvSqrt^2)
-   */
-  void NewtonStep (void);
-
-  /**
-   * \brief Determine the time for next drop
-   * CoDel control law is t + m_interval/sqrt(m_count).
-   * Here, we use m_recInvSqrt calculated by Newton's method in NewtonStep() to avoid
-   * both sqrt() and divide operations
-   *
-   * \param t Current next drop time
-   * \returns The new next drop time:
-   */
-  uint32_t ControlLaw (uint32_t t);
-
-  /**
-   * \brief Determine whether a packet is OK to be dropped. The packet
-   * may not be actually dropped (depending on the drop state)
-   *
-   * \param item The packet that is considered
-   * \param now The current time represented as 32-bit unsigned integer (us)
-   * \returns True if it is OK to drop the packet (sojourn time above target for at least interval)
-   */
-  bool OkToDrop (Ptr<QueueDiscItem> item, uint32_t now);
-
-  /**
-   * Check if CoDel time a is successive to b
-   * @param a left operand
-   * @param b right operand
-   * @return true if a is greater than b
-   */
-  bool CoDelTimeAfter (uint32_t a, uint32_t b);
-  /**
-   * Check if CoDel time a is successive or equal to b
-   * @param a left operand
-   * @param b right operand
-   * @return true if a is greater than or equal to b
-   */
-  bool CoDelTimeAfterEq (uint32_t a, uint32_t b);
-  /**
-   * Check if CoDel time a is preceding b
-   * @param a left operand
-   * @param b right operand
-   * @return true if a is less than to b
-   */
-  bool CoDelTimeBefore (uint32_t a, uint32_t b);
-  /**
-   * Check if CoDel time a is preceding or equal to b
-   * @param a left operand
-   * @param b right operand
-   * @return true if a is less than or equal to b
-   */
-  bool CoDelTimeBeforeEq (uint32_t a, uint32_t b);
-
-  /**
-   * Return the unsigned 32-bit integer representation of the input Time
-   * object. Units are microseconds
-   * @param t the input Time Object
-   * @return the unsigned 32-bit integer representation
-   */
-  uint32_t Time2CoDel (Time t);
+  virtual Ptr<QueueDiscItem> CoDelPop (Time &tstamp);
+  virtual uint32_t CoDelGetNBytes (void) const;
+  virtual void CoDelDrop (Ptr<QueueDiscItem> item);
 
   virtual void InitializeParams (void);
 
   uint32_t m_maxPackets;                  //!< Max # of packets accepted by the queue
   uint32_t m_maxBytes;                    //!< Max # of bytes accepted by the queue
-  uint32_t m_minBytes;                    //!< Minimum bytes in queue to allow a packet drop
-  Time m_interval;                        //!< 100 ms sliding minimum time window width
-  Time m_target;                          //!< 5 ms target queue delay
-  TracedValue<uint32_t> m_count;          //!< Number of packets dropped since entering drop state
-  TracedValue<uint32_t> m_dropCount;      //!< Number of dropped packets according CoDel algorithm
-  TracedValue<uint32_t> m_lastCount;      //!< Last number of packets dropped since entering drop state
-  TracedValue<bool> m_dropping;           //!< True if in dropping state
-  uint16_t m_recInvSqrt;                  //!< Reciprocal inverse square root
-  uint32_t m_firstAboveTime;              //!< Time to declare sojourn time above target
-  TracedValue<uint32_t> m_dropNext;       //!< Time to drop next packet
-  uint32_t m_state1;                      //!< Number of times packet sojourn goes above target for interval
-  uint32_t m_state2;                      //!< Number of times we perform next drop while in dropping state
-  uint32_t m_state3;                      //!< Number of times we enter drop state and drop the fist packet
-  uint32_t m_states;                      //!< Total number of times we are in state 1, state 2, or state 3
   uint32_t m_dropOverLimit;               //!< The number of packets dropped due to full queue
   QueueDiscMode m_mode;                   //!< The operating mode (Bytes or packets)
-  TracedValue<Time> m_sojourn;            //!< Time in queue
 };
 
 } // namespace ns3
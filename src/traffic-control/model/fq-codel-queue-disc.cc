@@ -21,7 +21,8 @@
 
 #include "ns3/log.h"
 #include "ns3/string.h"
-#include "ns3/queue.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
 #include "fq-codel-queue-disc.h"
 #include "codel-queue-disc.h"
 #include "ns3/net-device-queue-interface.h"
@@ -44,7 +45,8 @@ TypeId FqCoDelFlow::GetTypeId (void)
 
 FqCoDelFlow::FqCoDelFlow ()
   : m_deficit (0),
-    m_status (INACTIVE)
+    m_status (INACTIVE),
+    m_next (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -90,6 +92,167 @@ FqCoDelFlow::GetStatus (void) const
 }
 
 
+NS_OBJECT_ENSURE_REGISTERED (FqCoDelFlowQueueDisc);
+
+TypeId FqCoDelFlowQueueDisc::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FqCoDelFlowQueueDisc")
+    .SetParent<QueueDisc> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<FqCoDelFlowQueueDisc> ()
+    .AddTraceSource ("Count",
+                     "CoDel count",
+                     MakeTraceSourceAccessor (&FqCoDelFlowQueueDisc::m_dropStateCount),
+                     "ns3::TracedValueCallback::Uint32")
+    .AddTraceSource ("DropCount",
+                     "CoDel drop count",
+                     MakeTraceSourceAccessor (&FqCoDelFlowQueueDisc::m_dropCount),
+                     "ns3::TracedValueCallback::Uint32")
+    .AddTraceSource ("LastCount",
+                     "CoDel lastcount",
+                     MakeTraceSourceAccessor (&FqCoDelFlowQueueDisc::m_lastCount),
+                     "ns3::TracedValueCallback::Uint32")
+    .AddTraceSource ("DropState",
+                     "Dropping state",
+                     MakeTraceSourceAccessor (&FqCoDelFlowQueueDisc::m_dropping),
+                     "ns3::TracedValueCallback::Bool")
+    .AddTraceSource ("Sojourn",
+                     "Time in the queue",
+                     MakeTraceSourceAccessor (&FqCoDelFlowQueueDisc::m_sojourn),
+                     "ns3::Time::TracedValueCallback")
+    .AddTraceSource ("DropNext",
+                     "Time until next packet drop",
+                     MakeTraceSourceAccessor (&FqCoDelFlowQueueDisc::m_dropNext),
+                     "ns3::TracedValueCallback::Uint32")
+  ;
+  return tid;
+}
+
+FqCoDelFlowQueueDisc::FqCoDelFlowQueueDisc ()
+  : QueueDisc (),
+    CoDelAlgorithm (),
+    m_storedBytes (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+FqCoDelFlowQueueDisc::~FqCoDelFlowQueueDisc ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+FqCoDelFlowQueueDisc::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_packets.Clear ();
+  m_storedBytes = 0;
+  QueueDisc::DoDispose ();
+}
+
+uint32_t
+FqCoDelFlowQueueDisc::GetDropCount (void) const
+{
+  return m_dropCount;
+}
+
+void
+FqCoDelFlowQueueDisc::SetCoDelParameters (Time interval, Time target, uint32_t minBytes)
+{
+  NS_LOG_FUNCTION (this << interval << target << minBytes);
+  m_interval = interval;
+  m_target = target;
+  m_minBytes = minBytes;
+}
+
+uint32_t
+FqCoDelFlowQueueDisc::DropHead (void)
+{
+  NS_LOG_FUNCTION (this);
+  Time tstamp;
+  Ptr<QueueDiscItem> item = CoDelPop (tstamp);
+  NS_ASSERT (item != 0);
+  Drop (item);
+  return item->GetSize ();
+}
+
+bool
+FqCoDelFlowQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+  Entry entry;
+  entry.item = item;
+  entry.tstamp = Simulator::Now ();
+  m_packets.PushBack (entry);
+  m_storedBytes += item->GetSize ();
+  return true;
+}
+
+Ptr<QueueDiscItem>
+FqCoDelFlowQueueDisc::DoDequeue (void)
+{
+  NS_LOG_FUNCTION (this);
+  return CoDelDequeue ();
+}
+
+Ptr<const QueueDiscItem>
+FqCoDelFlowQueueDisc::DoPeek (void) const
+{
+  NS_LOG_FUNCTION (this);
+  if (m_packets.IsEmpty ())
+    {
+      return 0;
+    }
+  return m_packets.Front ().item;
+}
+
+bool
+FqCoDelFlowQueueDisc::CheckConfig (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (GetNQueueDiscClasses () > 0 || GetNPacketFilters () > 0 || GetNInternalQueues () > 0)
+    {
+      NS_LOG_ERROR ("FqCoDelFlowQueueDisc cannot have classes, packet filters or internal queues");
+      return false;
+    }
+  return true;
+}
+
+void
+FqCoDelFlowQueueDisc::InitializeParams (void)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+Ptr<QueueDiscItem>
+FqCoDelFlowQueueDisc::CoDelPop (Time &tstamp)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_packets.IsEmpty ())
+    {
+      return 0;
+    }
+  Ptr<QueueDiscItem> item = m_packets.Front ().item;
+  tstamp = m_packets.Front ().tstamp;
+  m_packets.PopFront ();
+  m_storedBytes -= item->GetSize ();
+  return item;
+}
+
+uint32_t
+FqCoDelFlowQueueDisc::CoDelGetNBytes (void) const
+{
+  return m_storedBytes;
+}
+
+void
+FqCoDelFlowQueueDisc::CoDelDrop (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+  Drop (item);
+}
+
+
 NS_OBJECT_ENSURE_REGISTERED (FqCoDelQueueDisc);
 
 TypeId FqCoDelQueueDisc::GetTypeId (void)
@@ -108,6 +271,11 @@ TypeId FqCoDelQueueDisc::GetTypeId (void)
                    StringValue ("5ms"),
                    MakeStringAccessor (&FqCoDelQueueDisc::m_target),
                    MakeStringChecker ())
+    .AddAttribute ("MinBytes",
+                   "The CoDel algorithm minbytes parameter for each FQCoDel queue",
+                   UintegerValue (1500),
+                   MakeUintegerAccessor (&FqCoDelQueueDisc::m_minBytes),
+                   MakeUintegerChecker<uint32_t> ())
     .AddAttribute ("PacketLimit",
                    "The hard limit on the real queue size, measured in packets",
                    UintegerValue (10 * 1024),
@@ -132,6 +300,8 @@ FqCoDelQueueDisc::FqCoDelQueueDisc ()
     m_overlimitDroppedPackets (0)
 {
   NS_LOG_FUNCTION (this);
+  m_newFlows.head = m_newFlows.tail = 0;
+  m_oldFlows.head = m_oldFlows.tail = 0;
 }
 
 FqCoDelQueueDisc::~FqCoDelQueueDisc ()
@@ -139,6 +309,16 @@ FqCoDelQueueDisc::~FqCoDelQueueDisc ()
   NS_LOG_FUNCTION (this);
 }
 
+void
+FqCoDelQueueDisc::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_newFlows.head = m_newFlows.tail = 0;
+  m_oldFlows.head = m_oldFlows.tail = 0;
+  m_flowTable.clear ();
+  QueueDisc::DoDispose ();
+}
+
 void
 FqCoDelQueueDisc::SetQuantum (uint32_t quantum)
 {
@@ -152,6 +332,34 @@ FqCoDelQueueDisc::GetQuantum (void) const
   return m_quantum;
 }
 
+void
+FqCoDelQueueDisc::PushBack (FlowList &list, FqCoDelFlow *flow)
+{
+  flow->m_next = 0;
+  if (list.tail == 0)
+    {
+      list.head = flow;
+    }
+  else
+    {
+      list.tail->m_next = flow;
+    }
+  list.tail = flow;
+}
+
+void
+FqCoDelQueueDisc::PopFront (FlowList &list)
+{
+  NS_ASSERT (list.head != 0);
+  FqCoDelFlow *flow = list.head;
+  list.head = flow->m_next;
+  if (list.head == 0)
+    {
+      list.tail = 0;
+    }
+  flow->m_next = 0;
+}
+
 bool
 FqCoDelQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
 {
@@ -168,33 +376,31 @@ FqCoDelQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
 
   uint32_t h = ret % m_flows;
 
-  Ptr<FqCoDelFlow> flow;
-  if (m_flowsIndices.find (h) == m_flowsIndices.end ())
+  FqCoDelFlow *flow = PeekPointer (m_flowTable[h]);
+  if (flow == 0)
     {
       NS_LOG_DEBUG ("Creating a new flow queue with index " << h);
-      flow = m_flowFactory.Create<FqCoDelFlow> ();
-      Ptr<QueueDisc> qd = m_queueDiscFactory.Create<QueueDisc> ();
+      Ptr<FqCoDelFlow> newFlow = CreateObject<FqCoDelFlow> ();
+      Ptr<FqCoDelFlowQueueDisc> qd = CreateObject<FqCoDelFlowQueueDisc> ();
+      qd->SetCoDelParameters (m_codelInterval, m_codelTarget, m_minBytes);
       qd->Initialize ();
-      flow->SetQueueDisc (qd);
-      AddQueueDiscClass (flow);
+      newFlow->SetQueueDisc (qd);
+      AddQueueDiscClass (newFlow);
 
-      m_flowsIndices[h] = GetNQueueDiscClasses () - 1;
-    }
-  else
-    {
-      flow = StaticCast<FqCoDelFlow> (GetQueueDiscClass (m_flowsIndices[h]));
+      m_flowTable[h] = newFlow;
+      flow = PeekPointer (newFlow);
     }
 
   if (flow->GetStatus () == FqCoDelFlow::INACTIVE)
     {
       flow->SetStatus (FqCoDelFlow::NEW_FLOW);
       flow->SetDeficit (m_quantum);
-      m_newFlows.push_back (flow);
+      PushBack (m_newFlows, flow);
     }
 
   flow->GetQueueDisc ()->Enqueue (item);
 
-  NS_LOG_DEBUG ("Packet enqueued into flow " << h << "; flow index " << m_flowsIndices[h]);
+  NS_LOG_DEBUG ("Packet enqueued into flow " << h);
 
   if (GetNPackets () > m_limit)
     {
@@ -209,23 +415,23 @@ FqCoDelQueueDisc::DoDequeue (void)
 {
   NS_LOG_FUNCTION (this);
 
-  Ptr<FqCoDelFlow> flow;
+  FqCoDelFlow *flow = 0;
   Ptr<QueueDiscItem> item;
 
   do
     {
       bool found = false;
 
-      while (!found && !m_newFlows.empty ())
+      while (!found && m_newFlows.head != 0)
         {
-          flow = m_newFlows.front ();
+          flow = m_newFlows.head;
 
           if (flow->GetDeficit () <= 0)
             {
               flow->IncreaseDeficit (m_quantum);
               flow->SetStatus (FqCoDelFlow::OLD_FLOW);
-              m_oldFlows.push_back (flow);
-              m_newFlows.pop_front ();
+              PopFront (m_newFlows);
+              PushBack (m_oldFlows, flow);
             }
           else
             {
@@ -234,15 +440,15 @@ FqCoDelQueueDisc::DoDequeue (void)
             }
         }
 
-      while (!found && !m_oldFlows.empty ())
+      while (!found && m_oldFlows.head != 0)
         {
-          flow = m_oldFlows.front ();
+          flow = m_oldFlows.head;
 
           if (flow->GetDeficit () <= 0)
             {
               flow->IncreaseDeficit (m_quantum);
-              m_oldFlows.push_back (flow);
-              m_oldFlows.pop_front ();
+              PopFront (m_oldFlows);
+              PushBack (m_oldFlows, flow);
             }
           else
             {
@@ -262,16 +468,16 @@ FqCoDelQueueDisc::DoDequeue (void)
       if (!item)
         {
           NS_LOG_DEBUG ("Could not get a packet from the selected flow queue");
-          if (!m_newFlows.empty ())
+          if (m_newFlows.head != 0)
             {
               flow->SetStatus (FqCoDelFlow::OLD_FLOW);
-              m_oldFlows.push_back (flow);
-              m_newFlows.pop_front ();
+              PopFront (m_newFlows);
+              PushBack (m_oldFlows, flow);
             }
           else
             {
               flow->SetStatus (FqCoDelFlow::INACTIVE);
-              m_oldFlows.pop_front ();
+              PopFront (m_oldFlows);
             }
         }
       else
@@ -290,17 +496,17 @@ FqCoDelQueueDisc::DoPeek (void) const
 {
   NS_LOG_FUNCTION (this);
 
-  Ptr<FqCoDelFlow> flow;
+  FqCoDelFlow *flow;
 
-  if (!m_newFlows.empty ())
+  if (m_newFlows.head != 0)
     {
-      flow = m_newFlows.front ();
+      flow = m_newFlows.head;
     }
   else
     {
-      if (!m_oldFlows.empty ())
+      if (m_oldFlows.head != 0)
         {
-          flow = m_oldFlows.front ();
+          flow = m_oldFlows.head;
         }
       else
         {
@@ -351,13 +557,12 @@ FqCoDelQueueDisc::InitializeParams (void)
       NS_LOG_DEBUG ("Setting the quantum to the MTU of the device: " << m_quantum);
     }
 
-  m_flowFactory.SetTypeId ("ns3::FqCoDelFlow");
+  m_codelInterval = Time (m_interval);
+  m_codelTarget = Time (m_target);
 
-  m_queueDiscFactory.SetTypeId ("ns3::CoDelQueueDisc");
-  m_queueDiscFactory.Set ("Mode", EnumValue (CoDelQueueDisc::QUEUE_DISC_MODE_PACKETS));
-  m_queueDiscFactory.Set ("MaxPackets", UintegerValue (m_limit + 1));
-  m_queueDiscFactory.Set ("Interval", StringValue (m_interval));
-  m_queueDiscFactory.Set ("Target", StringValue (m_target));
+  // flow queues are created the first time a packet is classified into them
+  m_flowTable.clear ();
+  m_flowTable.resize (m_flows);
 }
 
 uint32_t
@@ -382,13 +587,11 @@ FqCoDelQueueDisc::FqCoDelDrop (void)
 
   /* Our goal is to drop half of this fat flow backlog */
   uint32_t len = 0, count = 0, threshold = maxBacklog >> 1;
-  qd = GetQueueDiscClass (index)->GetQueueDisc ();
-  Ptr<QueueDiscItem> item;
+  Ptr<FqCoDelFlowQueueDisc> flowQd = StaticCast<FqCoDelFlowQueueDisc> (GetQueueDiscClass (index)->GetQueueDisc ());
 
   do
     {
-      item = qd->GetInternalQueue (0)->Remove ();
-      len += item->GetSize ();
+      len += flowQd->DropHead ();
     } while (++count < m_dropBatchSize && len < threshold);
 
   m_overlimitDroppedPackets += count;
@@ -23,9 +23,9 @@
 #define FQ_CODEL_QUEUE_DISC
 
 #include "ns3/queue-disc.h"
-#include "ns3/object-factory.h"
-#include <list>
-#include <map>
+#include "ns3/ring-buffer.h"
+#include "codel-queue-disc.h"
+#include <vector>
 
 namespace ns3 {
 
@@ -87,8 +87,88 @@ public:
   FlowStatus GetStatus (void) const;
 
 private:
+  friend class FqCoDelQueueDisc;
+
   int32_t m_deficit;    //!< the deficit for this flow
   FlowStatus m_status;  //!< the status of this flow
+  FqCoDelFlow *m_next;  //!< the next flow in the list of new or old flows
+};
+
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief The queue disc attached to the flow queues of the FqCoDel queue disc
+ *
+ * It stores the packets classified into a flow queue, along with their
+ * enqueue time, and runs the CoDel algorithm on them. Unlike a
+ * CoDelQueueDisc, it has no internal queue, does not tag the packets and
+ * takes its CoDel parameters from the FqCoDel queue disc, so that it is
+ * cheap to create. It provides the trace sources of the CoDel state of
+ * CoDelQueueDisc.
+ */
+
+class FqCoDelFlowQueueDisc : public QueueDisc, public CoDelAlgorithm {
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  /**
+   * \brief FqCoDelFlowQueueDisc constructor
+   */
+  FqCoDelFlowQueueDisc ();
+
+  virtual ~FqCoDelFlowQueueDisc ();
+
+  /**
+   * \brief Get the number of packets dropped according to the CoDel algorithm
+   *
+   * \returns The number of dropped packets
+   */
+  uint32_t GetDropCount (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  friend class FqCoDelQueueDisc;
+
+  /**
+   * \brief A packet stored in the flow queue, along with its enqueue time
+   */
+  struct Entry
+  {
+    Ptr<QueueDiscItem> item;    //!< the stored packet
+    Time tstamp;                //!< the time the packet was enqueued
+  };
+
+  /**
+   * \brief Set the parameters of the CoDel algorithm
+   * \param interval the CoDel interval
+   * \param target the CoDel target queue delay
+   * \param minBytes the CoDel minbytes parameter
+   */
+  void SetCoDelParameters (Time interval, Time target, uint32_t minBytes);
+  /**
+   * \brief Drop the packet at the head of the flow queue, regardless of CoDel
+   * \return the size of the dropped packet
+   */
+  uint32_t DropHead (void);
+
+  virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
+  virtual Ptr<QueueDiscItem> DoDequeue (void);
+  virtual Ptr<const QueueDiscItem> DoPeek (void) const;
+  virtual bool CheckConfig (void);
+  virtual void InitializeParams (void);
+
+  virtual Ptr<QueueDiscItem> CoDelPop (Time &tstamp);
+  virtual uint32_t CoDelGetNBytes (void) const;
+  virtual void CoDelDrop (Ptr<QueueDiscItem> item);
+
+  RingBuffer<Entry> m_packets; //!< the packets stored in the flow queue
+  uint32_t m_storedBytes;      //!< the number of bytes stored in m_packets
 };
 
 
@@ -126,6 +206,9 @@ public:
     */
    uint32_t GetQuantum (void) const;
 
+protected:
+  virtual void DoDispose (void);
+
 private:
   virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
   virtual Ptr<QueueDiscItem> DoDequeue (void);
@@ -133,6 +216,27 @@ private:
   virtual bool CheckConfig (void);
   virtual void InitializeParams (void);
 
+  /**
+   * \brief A FIFO list of flows, linked through FqCoDelFlow::m_next
+   */
+  struct FlowList
+  {
+    FqCoDelFlow *head;          //!< the first flow of the list
+    FqCoDelFlow *tail;          //!< the last flow of the list
+  };
+
+  /**
+   * \brief Append a flow to a list of flows
+   * \param list the list of flows
+   * \param flow the flow to append
+   */
+  static void PushBack (FlowList &list, FqCoDelFlow *flow);
+  /**
+   * \brief Remove the first flow of a non-empty list of flows
+   * \param list the list of flows
+   */
+  static void PopFront (FlowList &list);
+
   /**
    * \brief Drop a packet from the head of the queue with the largest current byte count
    * \return the index of the queue with the largest current byte count
@@ -141,6 +245,7 @@ private:
 
   std::string m_interval;    //!< CoDel interval attribute
   std::string m_target;      //!< CoDel target attribute
+  uint32_t m_minBytes;       //!< CoDel minbytes attribute
   uint32_t m_limit;          //!< Maximum number of packets in the queue disc
   uint32_t m_quantum;        //!< Deficit assigned to flows at each round
   uint32_t m_flows;          //!< Number of flow queues
@@ -148,13 +253,14 @@ private:
 
   uint32_t m_overlimitDroppedPackets; //!< Number of overlimit dropped packets
 
-  std::list<Ptr<FqCoDelFlow> > m_newFlows;    //!< The list of new flows
-  std::list<Ptr<FqCoDelFlow> > m_oldFlows;    //!< The list of old flows
+  Time m_codelInterval;      //!< CoDel interval of the flow queues
+  Time m_codelTarget;        //!< CoDel target of the flow queues
 
-  std::map<uint32_t, uint32_t> m_flowsIndices;    //!< Map with the index of class for each flow
+  FlowList m_newFlows;    //!< The list of new flows
+  FlowList m_oldFlows;    //!< The list of old flows
 
-  ObjectFactory m_flowFactory;         //!< Factory to create a new flow
-  ObjectFactory m_queueDiscFactory;    //!< Factory to create a new queue
+  /// Flow queues indexed by the flow hash, 0 until a packet is classified into them
+  std::vector<Ptr<FqCoDelFlow> > m_flowTable;
 };
 
 } // namespace ns3
@@ -383,10 +383,10 @@ CoDelQueueDiscNewtonStepTest::DoRun (void)
   Ptr<CoDelQueueDisc> queue = CreateObject<CoDelQueueDisc> ();
 
   // Spot check a few points in the expected operational range of
-  // CoDelQueueDisc's m_count and m_recInvSqrt variables
+  // CoDelQueueDisc's m_dropStateCount and m_recInvSqrt variables
   uint32_t count = 2;
   uint16_t recInvSqrt = 65535;
-  queue->m_count = count;
+  queue->m_dropStateCount = count;
   queue->m_recInvSqrt = recInvSqrt;
   queue->NewtonStep ();
   // Test that ns-3 value is exactly the same as the Linux value
@@ -395,7 +395,7 @@ CoDelQueueDiscNewtonStepTest::DoRun (void)
 
   count = 4;
   recInvSqrt = 36864;
-  queue->m_count = count;
+  queue->m_dropStateCount = count;
   queue->m_recInvSqrt = recInvSqrt;
   queue->NewtonStep ();
   // Test that ns-3 value is exactly the same as the Linux value
@@ -0,0 +1,152 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program can be used to benchmark the IPv4 forwarding path, by
+// sending UDP packets along a chain of routers, with and without checksums.
+// Sample usage:  ./waf --run 'bench-ipv4-forwarding --hops=16 --n=100000'
+
+#include "ns3/abort.h"
+#include "ns3/command-line.h"
+#include "ns3/simulator.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/global-value.h"
+#include "ns3/boolean.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/socket.h"
+#include "ns3/packet.h"
+#include <iomanip>
+#include <iostream>
+
+using namespace ns3;
+
+#define LOG(x)   std::cout << x << std::endl
+
+/// Number of packets received at the end of the chain
+static uint32_t g_received = 0;
+
+/**
+ * Read all the packets available on the receiving socket.
+ * \param [in] socket The socket.
+ */
+static void
+Receive (Ptr<Socket> socket)
+{
+  while (socket->Recv ())
+    {
+      g_received++;
+    }
+}
+
+/**
+ * Send a packet and schedule the next one.
+ * \param [in] socket The sending socket.
+ * \param [in] size The packet size.
+ * \param [in] left The number of packets left to send.
+ */
+static void
+SendNext (Ptr<Socket> socket, uint32_t size, uint32_t left)
+{
+  socket->Send (Create<Packet> (size));
+  if (left > 1)
+    {
+      Simulator::Schedule (MicroSeconds (1), &SendNext, socket, size, left - 1);
+    }
+}
+
+/**
+ * Send \p n packets along a chain of \p hops routers and time the simulation.
+ *
+ * \param [in] name The label to print.
+ * \param [in] hops The number of routers between the source and the sink.
+ * \param [in] n The number of packets.
+ * \param [in] size The UDP payload size.
+ * \param [in] checksum Whether to enable the checksums.
+ */
+static void
+RunChain (std::string name, uint32_t hops, uint32_t n, uint32_t size, bool checksum)
+{
+  GlobalValue::Bind ("ChecksumEnabled", BooleanValue (checksum));
+
+  NodeContainer nodes;
+  nodes.Create (hops + 2);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+
+  SimpleNetDeviceHelper simple;
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.0.0.0", "255.255.255.0");
+  Ipv4InterfaceContainer last;
+  for (uint32_t i = 0; i + 1 < nodes.GetN (); i++)
+    {
+      NetDeviceContainer link = simple.Install (NodeContainer (nodes.Get (i), nodes.Get (i + 1)));
+      last = ipv4.Assign (link);
+      ipv4.NewNetwork ();
+    }
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  uint16_t port = 9;
+  Ptr<Socket> sink = Socket::CreateSocket (nodes.Get (hops + 1), UdpSocketFactory::GetTypeId ());
+  sink->Bind (InetSocketAddress (Ipv4Address::GetAny (), port));
+  sink->SetRecvCallback (MakeCallback (&Receive));
+  Ptr<Socket> source = Socket::CreateSocket (nodes.Get (0), UdpSocketFactory::GetTypeId ());
+  source->Connect (InetSocketAddress (last.GetAddress (1), port));
+  // a first packet resolves the addresses along the chain, so that ARP
+  // does not drop the packets which follow
+  Simulator::Schedule (Seconds (0), &SendNext, source, size, 1);
+  Simulator::Schedule (Seconds (1), &SendNext, source, size, n);
+
+  g_received = 0;
+  SystemWallClockMs time;
+  time.Start ();
+  Simulator::Run ();
+  double elapsed = time.End () / 1000.0;
+  Simulator::Destroy ();
+
+  NS_ABORT_MSG_UNLESS (g_received == n + 1, "Received " << g_received << " packets out of " << n + 1);
+  LOG (std::left << std::setw (16) << name <<
+       std::setw (14) << elapsed <<
+       (elapsed * 1e9 / n / (hops + 1)));
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t hops = 8;
+  uint32_t n = 100000;
+  uint32_t size = 1000;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the IPv4 forwarding path along a chain of routers.");
+  cmd.AddValue ("hops", "number of routers between the source and the sink", hops);
+  cmd.AddValue ("n", "number of packets", n);
+  cmd.AddValue ("size", "UDP payload size", size);
+  cmd.Parse (argc, argv);
+
+  LOG ("routers: " << hops);
+  LOG ("packets: " << n);
+  LOG ("size:    " << size);
+  LOG ("");
+  LOG (std::left << std::setw (16) << "Checksums" <<
+       std::setw (14) << "Time (s)" <<
+       "Per (ns/packet/link)");
+  RunChain ("disabled", hops, n, size, false);
+  RunChain ("enabled", hops, n, size, true);
+  return 0;
+}
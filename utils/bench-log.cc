@@ -0,0 +1,185 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <iomanip>
+#include <iostream>
+#include <streambuf>
+#include <string>
+
+#include "ns3/core-module.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("BenchLog");
+
+#define LOG(x)   std::cout << x << std::endl
+
+/**
+ * Define the functions logging \p n messages of each level, named
+ * after the level and \p suffix.  The log levels compiled into them
+ * are those of NS_LOG_COMPILED_LEVELS where the macro is used.
+ *
+ * \param [in] suffix The suffix of the function names.
+ */
+#define BENCH_LOG_LEVELS(suffix)                                        \
+  void Error ## suffix (uint32_t n)                                     \
+  {                                                                     \
+    for (uint32_t i = 0; i < n; ++i) { NS_LOG_ERROR ("error " << i); }  \
+  }                                                                     \
+  void Warn ## suffix (uint32_t n)                                      \
+  {                                                                     \
+    for (uint32_t i = 0; i < n; ++i) { NS_LOG_WARN ("warn " << i); }    \
+  }                                                                     \
+  void Debug ## suffix (uint32_t n)                                     \
+  {                                                                     \
+    for (uint32_t i = 0; i < n; ++i) { NS_LOG_DEBUG ("debug " << i); }  \
+  }                                                                     \
+  void Info ## suffix (uint32_t n)                                      \
+  {                                                                     \
+    for (uint32_t i = 0; i < n; ++i) { NS_LOG_INFO ("info " << i); }    \
+  }                                                                     \
+  void Function ## suffix (uint32_t n)                                  \
+  {                                                                     \
+    for (uint32_t i = 0; i < n; ++i) { NS_LOG_FUNCTION (&n << i); }     \
+  }                                                                     \
+  void Logic ## suffix (uint32_t n)                                     \
+  {                                                                     \
+    for (uint32_t i = 0; i < n; ++i) { NS_LOG_LOGIC ("logic " << i); }  \
+  }
+
+/** The log calls, with the levels of the build. */
+BENCH_LOG_LEVELS (Compiled)
+
+#undef NS_LOG_COMPILED_LEVELS
+/** Remove all the log levels from the following functions. */
+#define NS_LOG_COMPILED_LEVELS ns3::LOG_NONE
+
+/** The log calls, removed at compile time. */
+BENCH_LOG_LEVELS (Removed)
+
+/** A stream buffer discarding its output. */
+class NullBuffer : public std::streambuf
+{
+protected:
+  virtual int overflow (int c)
+  {
+    return c;
+  }
+  virtual std::streamsize xsputn (const char *s, std::streamsize n)
+  {
+    return n;
+  }
+};
+
+/** A function logging a number of messages of one level. */
+typedef void (*LogCalls)(uint32_t n);
+
+/**
+ * Time the calls of \p calls.
+ *
+ * \param [in] calls The function logging the messages.
+ * \param [in] n The number of messages.
+ * \returns The time per message, in ns.
+ */
+double
+TimeCalls (LogCalls calls, uint32_t n)
+{
+  SystemWallClockMs time;
+  time.Start ();
+  (*calls)(n);
+  return time.End () * 1e6 / n;
+}
+
+/**
+ * Time the messages of one log level, removed at compile time,
+ * disabled at run time, written on std::clog and recorded by the
+ * binary backend.
+ *
+ * \param [in] name The log level name.
+ * \param [in] level The log level.
+ * \param [in] removed The function with the log level removed.
+ * \param [in] compiled The function with the log level compiled.
+ * \param [in] checks The number of messages removed or disabled.
+ * \param [in] calls The number of messages logged.
+ * \param [in] file The binary log file.
+ */
+void
+RunLevel (std::string name, enum LogLevel level,
+          LogCalls removed, LogCalls compiled,
+          uint32_t checks, uint32_t calls, std::string file)
+{
+  double removedTime = TimeCalls (removed, checks);
+  double disabledTime = TimeCalls (compiled, checks);
+
+  LogComponentEnable ("BenchLog", LogLevel (level | LOG_PREFIX_ALL));
+
+  NullBuffer null;
+  std::streambuf *clog = std::clog.rdbuf (&null);
+  double textTime = TimeCalls (compiled, calls);
+  std::clog.rdbuf (clog);
+
+  LogBinaryEnable (file);
+  double binaryTime = TimeCalls (compiled, calls);
+  LogBinaryDisable ();
+
+  LogComponentDisable ("BenchLog", LogLevel (level | LOG_PREFIX_ALL));
+
+  LOG (std::left << std::setw (12) << name <<
+       std::setw (14) << removedTime <<
+       std::setw (14) << disabledTime <<
+       std::setw (14) << textTime <<
+       binaryTime);
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t checks = 100000000;
+  uint32_t calls = 100000;
+  std::string file = "/dev/null";
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the cost per call of the logging macros of each level:\n"
+             "removed at compile time by NS_LOG_COMPILED_LEVELS, compiled but\n"
+             "disabled at run time, enabled with all prefixes on a discarded\n"
+             "std::clog, and enabled with the binary backend.");
+  cmd.AddValue ("checks", "number of calls removed or disabled", checks);
+  cmd.AddValue ("calls", "number of calls enabled", calls);
+  cmd.AddValue ("file", "the binary log file", file);
+  cmd.Parse (argc, argv);
+
+#ifndef NS3_LOG_ENABLE
+  LOG ("Logging is not compiled into this build; configure with --enable-logs.");
+#endif
+  // Create the simulator, which sets the time and node printers.
+  Simulator::Now ();
+
+  LOG ("checks: " << checks << ", calls: " << calls);
+  LOG ("");
+  LOG (std::left << std::setw (12) << "Level" <<
+       std::setw (14) << "Removed (ns)" <<
+       std::setw (14) << "Disabled (ns)" <<
+       std::setw (14) << "Text (ns)" <<
+       "Binary (ns)");
+  RunLevel ("error", LOG_ERROR, &ErrorRemoved, &ErrorCompiled, checks, calls, file);
+  RunLevel ("warn", LOG_WARN, &WarnRemoved, &WarnCompiled, checks, calls, file);
+  RunLevel ("debug", LOG_DEBUG, &DebugRemoved, &DebugCompiled, checks, calls, file);
+  RunLevel ("info", LOG_INFO, &InfoRemoved, &InfoCompiled, checks, calls, file);
+  RunLevel ("function", LOG_FUNCTION, &FunctionRemoved, &FunctionCompiled, checks, calls, file);
+  RunLevel ("logic", LOG_LOGIC, &LogicRemoved, &LogicCompiled, checks, calls, file);
+
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,174 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program can be used to benchmark the computation of the nix-vectors
+// on a grid of nodes: on demand, for random pairs of nodes, and precomputed
+// from a set of sources with one or more threads.
+// Sample usage:  ./waf --run 'bench-nix-vector-routing --side=100 --threads=4'
+
+#include "ns3/command-line.h"
+#include "ns3/simulator.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/uinteger.h"
+#include "ns3/config.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/ipv4-nix-vector-helper.h"
+#include "ns3/ipv4-nix-vector-routing.h"
+#include <iomanip>
+#include <iostream>
+
+using namespace ns3;
+
+#define LOG(x)   std::cout << x << std::endl
+
+/**
+ * Build a grid of \p side by \p side nodes using nix-vector routing.
+ *
+ * \param [in] side The number of nodes on a side of the grid.
+ * \param [in] maxCacheSize The maximum number of cache entries per node.
+ * \param [out] addresses An address of each node.
+ * \return The nodes.
+ */
+static NodeContainer
+BuildGrid (uint32_t side, uint32_t maxCacheSize, std::vector<Ipv4Address> &addresses)
+{
+  NodeContainer nodes;
+  nodes.Create (side * side);
+  Config::SetDefault ("ns3::Ipv4NixVectorRouting::MaxCacheSize", UintegerValue (maxCacheSize));
+  Ipv4NixVectorHelper nix;
+  InternetStackHelper internet;
+  internet.SetRoutingHelper (nix);
+  internet.Install (nodes);
+
+  SimpleNetDeviceHelper simple;
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.0.0.0", "255.255.255.252");
+  addresses.resize (nodes.GetN ());
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      uint32_t neighbors[] = { i + 1, i + side };
+      for (uint32_t k = 0; k < 2; k++)
+        {
+          if ((k == 0 && (i + 1) % side == 0) || neighbors[k] >= nodes.GetN ())
+            {
+              continue;
+            }
+          Ipv4InterfaceContainer link = ipv4.Assign (simple.Install (NodeContainer (nodes.Get (i), nodes.Get (neighbors[k]))));
+          addresses[i] = link.GetAddress (0);
+          addresses[neighbors[k]] = link.GetAddress (1);
+          ipv4.NewNetwork ();
+        }
+    }
+  return nodes;
+}
+
+/**
+ * Get the route from a node to an address.
+ *
+ * \param [in] node The source node.
+ * \param [in] to The destination address.
+ */
+static void
+RouteOutput (Ptr<Node> node, Ipv4Address to)
+{
+  Ptr<Ipv4RoutingProtocol> routing = node->GetObject<Ipv4NixVectorRouting> ();
+  Ipv4Header header;
+  header.SetDestination (to);
+  Socket::SocketErrno sockerr;
+  routing->RouteOutput (Create<Packet> (), header, 0, sockerr);
+}
+
+/**
+ * Add the cache memory of all the nodes.
+ *
+ * \param [in] nodes The nodes.
+ * \return The memory used by the caches, in bytes.
+ */
+static uint64_t
+CacheMemory (NodeContainer nodes)
+{
+  uint64_t bytes = 0;
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      bytes += nodes.Get (i)->GetObject<Ipv4NixVectorRouting> ()->GetCacheMemoryUsage ();
+    }
+  return bytes;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t side = 100;
+  uint32_t pairs = 1000;
+  uint32_t sources = 16;
+  uint32_t threads = 4;
+  uint32_t maxCacheSize = 0;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the computation of nix-vectors on a grid of nodes.");
+  cmd.AddValue ("side", "number of nodes on a side of the grid", side);
+  cmd.AddValue ("pairs", "number of random pairs of nodes routed on demand", pairs);
+  cmd.AddValue ("sources", "number of sources whose nix-vectors are precomputed", sources);
+  cmd.AddValue ("threads", "number of threads of the precomputation", threads);
+  cmd.AddValue ("cache", "maximum number of cache entries per node, 0 for no limit", maxCacheSize);
+  cmd.Parse (argc, argv);
+
+  std::vector<Ipv4Address> addresses;
+  NodeContainer nodes = BuildGrid (side, maxCacheSize, addresses);
+  LOG ("nodes:   " << nodes.GetN ());
+  LOG ("");
+  LOG (std::left << std::setw (24) << "Computation" <<
+       std::setw (14) << "Time (s)" <<
+       "Cache (bytes)");
+
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  SystemWallClockMs time;
+  time.Start ();
+  for (uint32_t i = 0; i < pairs; i++)
+    {
+      uint32_t source = random->GetInteger (0, nodes.GetN () - 1);
+      uint32_t dest = random->GetInteger (0, nodes.GetN () - 1);
+      RouteOutput (nodes.Get (source), addresses[dest]);
+    }
+  double elapsed = time.End () / 1000.0;
+  LOG (std::left << std::setw (24) << "on demand" <<
+       std::setw (14) << elapsed <<
+       CacheMemory (nodes));
+
+  NodeContainer precomputed;
+  for (uint32_t i = 0; i < sources && i < nodes.GetN (); i++)
+    {
+      precomputed.Add (nodes.Get (i * nodes.GetN () / sources));
+    }
+  uint32_t steps[] = { 1, threads };
+  for (uint32_t k = 0; k < 2; k++)
+    {
+      nodes.Get (0)->GetObject<Ipv4NixVectorRouting> ()->FlushGlobalNixRoutingCache ();
+      time.Start ();
+      Ipv4NixVectorRouting::PrecomputeNixVectors (precomputed, steps[k]);
+      elapsed = time.End () / 1000.0;
+      std::ostringstream label;
+      label << "precomputed, " << steps[k] << " thr.";
+      LOG (std::left << std::setw (24) << label.str () <<
+           std::setw (14) << elapsed <<
+           CacheMemory (nodes));
+    }
+
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,168 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "ns3/core-module.h"
+
+using namespace ns3;
+
+#define LOG(x)   std::cout << x << std::endl
+
+/**
+ * Build the TypeId name of a BenchObject.
+ *
+ * \param [in] i The hierarchy index.
+ * \param [in] d The depth in the hierarchy.
+ * \returns The TypeId name.
+ */
+std::string
+BenchObjectName (int i, int d)
+{
+  std::ostringstream oss;
+  oss << "ns3::BenchObject" << i << "_" << d;
+  return oss.str ();
+}
+
+/**
+ * A family of Object classes used to build deep aggregates.
+ *
+ * BenchObject<I,0> derives directly from Object; BenchObject<I,D>
+ * derives from BenchObject<I,D-1>, so every level adds one TypeId
+ * to the parent chain that GetObject has to resolve.
+ */
+template <int I, int D>
+class BenchObject : public BenchObject<I, D - 1>
+{
+public:
+  /**
+   * Register this type.
+   * \return The TypeId.
+   */
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId (BenchObjectName (I, D).c_str ())
+      .template SetParent<BenchObject<I, D - 1> > ()
+      .SetGroupName ("Core")
+      .HideFromDocumentation ()
+      .template AddConstructor<BenchObject<I, D> > ();
+    return tid;
+  }
+};
+
+/** The root of a BenchObject hierarchy. */
+template <int I>
+class BenchObject<I, 0> : public Object
+{
+public:
+  /**
+   * Register this type.
+   * \return The TypeId.
+   */
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId (BenchObjectName (I, 0).c_str ())
+      .SetParent<Object> ()
+      .SetGroupName ("Core")
+      .HideFromDocumentation ()
+      .template AddConstructor<BenchObject<I, 0> > ();
+    return tid;
+  }
+};
+
+/**
+ * Time \p iterations lookups of T through every aggregate in \p aggregates.
+ *
+ * \tparam T \explicit The type to look up.
+ * \param [in] name The label to print.
+ * \param [in] aggregates The aggregates to query.
+ * \param [in] iterations The number of lookups per aggregate.
+ */
+template <typename T>
+void
+RunLookups (std::string name, const std::vector<Ptr<Object> > &aggregates,
+            uint32_t iterations)
+{
+  SystemWallClockMs time;
+  uint64_t found = 0;
+  time.Start ();
+  for (uint32_t i = 0; i < iterations; ++i)
+    {
+      for (std::vector<Ptr<Object> >::const_iterator it = aggregates.begin ();
+           it != aggregates.end (); ++it)
+        {
+          if ((*it)->GetObject<T> () != 0)
+            {
+              found++;
+            }
+        }
+    }
+  double elapsed = time.End () / 1000.0;
+  uint64_t lookups = static_cast<uint64_t> (iterations) * aggregates.size ();
+  LOG (std::left << std::setw (24) << name <<
+       std::setw (14) << elapsed <<
+       std::setw (14) << (elapsed > 0 ? lookups / elapsed : 0) <<
+       std::setw (14) << (elapsed * 1e9 / lookups) <<
+       found);
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t nAggregates = 1000;
+  uint32_t iterations = 10000;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark Object::GetObject on aggregates of five objects,\n"
+             "each with a four-level deep TypeId hierarchy.");
+  cmd.AddValue ("aggregates", "number of aggregates to query", nAggregates);
+  cmd.AddValue ("iterations", "number of lookups per aggregate", iterations);
+  cmd.Parse (argc, argv);
+
+  std::vector<Ptr<Object> > aggregates;
+  for (uint32_t i = 0; i < nAggregates; ++i)
+    {
+      Ptr<Object> o = CreateObject<BenchObject<0, 3> > ();
+      o->AggregateObject (CreateObject<BenchObject<1, 3> > ());
+      o->AggregateObject (CreateObject<BenchObject<2, 3> > ());
+      o->AggregateObject (CreateObject<BenchObject<3, 3> > ());
+      o->AggregateObject (CreateObject<BenchObject<4, 3> > ());
+      aggregates.push_back (o);
+    }
+
+  LOG ("aggregates: " << nAggregates);
+  LOG ("iterations: " << iterations);
+  LOG ("");
+  LOG (std::left << std::setw (24) << "Lookup" <<
+       std::setw (14) << "Time (s)" <<
+       std::setw (14) << "Rate (op/s)" <<
+       std::setw (14) << "Per (ns/op)" <<
+       "Found");
+  RunLookups<BenchObject<0, 3> > ("first, exact", aggregates, iterations);
+  RunLookups<BenchObject<4, 3> > ("last, exact", aggregates, iterations);
+  RunLookups<BenchObject<4, 0> > ("last, ancestor", aggregates, iterations);
+  RunLookups<BenchObject<2, 1> > ("middle, ancestor", aggregates, iterations);
+  RunLookups<BenchObject<5, 0> > ("missing", aggregates, iterations);
+
+  for (std::vector<Ptr<Object> >::iterator it = aggregates.begin ();
+       it != aggregates.end (); ++it)
+    {
+      (*it)->Dispose ();
+    }
+  return 0;
+}
@@ -0,0 +1,103 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program can be used to benchmark the enqueue/dequeue throughput
+// of a DropTailQueue kept at a given occupancy.
+// Sample usage:  ./waf --run 'bench-queue --n=10000000 --occupancy=100'
+
+#include "ns3/abort.h"
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/drop-tail-queue.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+#define LOG(x)   std::cout << x << std::endl
+
+/**
+ * Fill a queue up to \p occupancy packets, then time \p n pairs of
+ * enqueue and dequeue operations.
+ *
+ * \param [in] name The label to print.
+ * \param [in] n The number of enqueue/dequeue pairs.
+ * \param [in] occupancy The number of packets kept in the queue.
+ * \param [in] preallocate Whether to set the Preallocate attribute.
+ */
+static void
+RunQueue (std::string name, uint32_t n, uint32_t occupancy, bool preallocate)
+{
+  Ptr<DropTailQueue<Packet> > queue = CreateObject<DropTailQueue<Packet> > ();
+  queue->SetAttribute ("MaxPackets", UintegerValue (occupancy + 1));
+  queue->SetAttribute ("Preallocate", BooleanValue (preallocate));
+
+  // use a small pool of packets, so that the benchmark measures the
+  // queue rather than the packet allocator
+  std::vector<Ptr<Packet> > packets;
+  for (uint32_t i = 0; i < occupancy + 1; i++)
+    {
+      packets.push_back (Create<Packet> (1000));
+    }
+
+  SystemWallClockMs time;
+  time.Start ();
+  for (uint32_t i = 0; i < occupancy; i++)
+    {
+      queue->Enqueue (packets[i]);
+    }
+  uint32_t next = occupancy;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      queue->Enqueue (packets[next]);
+      Ptr<Packet> p = queue->Dequeue ();
+      next = (next + 1) % packets.size ();
+    }
+  double elapsed = time.End () / 1000.0;
+
+  NS_ABORT_MSG_UNLESS (queue->GetNPackets () == occupancy, "Unexpected queue size");
+  NS_ABORT_MSG_UNLESS (queue->GetTotalDroppedPackets () == 0, "Unexpected drops");
+  LOG (std::left << std::setw (16) << name <<
+       std::setw (14) << elapsed <<
+       std::setw (14) << (elapsed > 0 ? n / elapsed : 0) <<
+       (elapsed * 1e9 / n));
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 10000000;
+  uint32_t occupancy = 100;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the enqueue/dequeue throughput of a DropTailQueue.");
+  cmd.AddValue ("n", "number of enqueue/dequeue pairs", n);
+  cmd.AddValue ("occupancy", "number of packets kept in the queue", occupancy);
+  cmd.Parse (argc, argv);
+
+  LOG ("pairs:     " << n);
+  LOG ("occupancy: " << occupancy);
+  LOG ("");
+  LOG (std::left << std::setw (16) << "Queue" <<
+       std::setw (14) << "Time (s)" <<
+       std::setw (14) << "Rate (op/s)" <<
+       "Per (ns/op)");
+  RunQueue ("growing", n, occupancy, false);
+  RunQueue ("preallocated", n, occupancy, true);
+  return 0;
+}
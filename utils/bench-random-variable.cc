@@ -0,0 +1,137 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "ns3/core-module.h"
+
+using namespace ns3;
+
+#define LOG(x)   std::cout << x << std::endl
+
+/**
+ * Time \p samples values of a random variable, one GetValue at a time
+ * and then by blocks with GetValues.
+ *
+ * \param [in] name The label to print.
+ * \param [in] x The random variable.
+ * \param [in] samples The number of values.
+ */
+void
+RunSamples (std::string name, Ptr<RandomVariableStream> x, uint32_t samples)
+{
+  SystemWallClockMs time;
+  double sum = 0;
+  time.Start ();
+  for (uint32_t i = 0; i < samples; ++i)
+    {
+      sum += x->GetValue ();
+    }
+  double elapsed = time.End () / 1000.0;
+
+  std::vector<double> block (1024);
+  time.Start ();
+  for (uint32_t i = 0; i < samples; i += block.size ())
+    {
+      uint32_t n = std::min<uint32_t> (block.size (), samples - i);
+      x->GetValues (&block[0], n);
+    }
+  double bulkElapsed = time.End () / 1000.0;
+
+  LOG (std::left << std::setw (30) << name <<
+       std::setw (14) << elapsed <<
+       std::setw (14) << (elapsed > 0 ? samples / elapsed : 0) <<
+       std::setw (14) << (elapsed * 1e9 / samples) <<
+       std::setw (14) << (bulkElapsed * 1e9 / samples) <<
+       sum / samples);
+}
+
+/**
+ * Create a random variable with its default attributes and time
+ * \p samples values of it.
+ *
+ * \param [in] type The TypeId name of the random variable.
+ * \param [in] samples The number of values.
+ */
+void
+RunType (std::string type, uint32_t samples)
+{
+  ObjectFactory factory (type);
+  Ptr<RandomVariableStream> x = factory.Create<RandomVariableStream> ();
+  RunSamples (type.substr (5), x, samples);
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t samples = 1000000;
+  uint32_t zipfN = 1000000;
+  uint32_t empiricalPoints = 1000;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark GetValue and GetValues of each RandomVariableStream subclass.\n"
+             "The Zipf and empirical distributions are set up, and their\n"
+             "tables computed, by a first value before the timing starts.");
+  cmd.AddValue ("samples", "number of values of each random variable", samples);
+  cmd.AddValue ("zipf", "N value of the Zipf distribution", zipfN);
+  cmd.AddValue ("empirical", "number of points of the empirical distribution", empiricalPoints);
+  cmd.Parse (argc, argv);
+
+  LOG ("samples: " << samples);
+  LOG ("");
+  LOG (std::left << std::setw (30) << "Random variable" <<
+       std::setw (14) << "Time (s)" <<
+       std::setw (14) << "Rate (op/s)" <<
+       std::setw (14) << "Per (ns/op)" <<
+       std::setw (14) << "Bulk (ns/op)" <<
+       "Mean");
+  RunType ("ns3::UniformRandomVariable", samples);
+  RunType ("ns3::ConstantRandomVariable", samples);
+  RunType ("ns3::SequentialRandomVariable", samples);
+  RunType ("ns3::ExponentialRandomVariable", samples);
+  RunType ("ns3::ParetoRandomVariable", samples);
+  RunType ("ns3::WeibullRandomVariable", samples);
+  RunType ("ns3::NormalRandomVariable", samples);
+  RunType ("ns3::LogNormalRandomVariable", samples);
+  RunType ("ns3::GammaRandomVariable", samples);
+  RunType ("ns3::ErlangRandomVariable", samples);
+  RunType ("ns3::TriangularRandomVariable", samples);
+  RunType ("ns3::ZetaRandomVariable", samples);
+
+  Ptr<ZipfRandomVariable> zipf = CreateObject<ZipfRandomVariable> ();
+  zipf->SetAttribute ("N", IntegerValue (zipfN));
+  zipf->SetAttribute ("Alpha", DoubleValue (1.0));
+  zipf->GetValue ();
+  RunSamples ("ZipfRandomVariable", zipf, samples);
+
+  Ptr<DeterministicRandomVariable> deterministic = CreateObject<DeterministicRandomVariable> ();
+  double values[] = { 1.0, 2.0, 3.0, 4.0 };
+  deterministic->SetValueArray (values, 4);
+  RunSamples ("DeterministicRandomVariable", deterministic, samples);
+
+  Ptr<EmpiricalRandomVariable> empirical = CreateObject<EmpiricalRandomVariable> ();
+  for (uint32_t i = 0; i <= empiricalPoints; ++i)
+    {
+      double c = static_cast<double> (i) / empiricalPoints;
+      empirical->CDF (i, c * c);
+    }
+  empirical->GetValue ();
+  RunSamples ("EmpiricalRandomVariable", empirical, samples);
+
+  return 0;
+}
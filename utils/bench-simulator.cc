@@ -51,7 +51,8 @@ public:
   Bench (const uint32_t population, const uint32_t total)
     : m_population (population),
       m_total (total),
-      m_count (0)
+      m_count (0),
+      m_cancel (0)
   {
   }
 
@@ -82,16 +83,30 @@ public:
     m_total = total;
   }
 
+  /**
+   * Set the number of timers each event cancels and reschedules
+   * \param cancel the number of timers
+   */
+  void SetCancel (const uint32_t cancel)
+  {
+    m_cancel = cancel;
+    m_timers.resize (cancel);
+  }
+
   /// Run function
   void RunBench (void);
 private:
   /// callback function
   void Cb (void);
+  /// timer expiration function
+  void Timeout (void);
 
   Ptr<RandomVariableStream> m_rand; ///< random variable
   uint32_t m_population; ///< population
   uint32_t m_total; ///< total
   uint32_t m_count; ///< count 
+  uint32_t m_cancel; ///< number of timers rescheduled by each event
+  std::vector<EventId> m_timers; ///< the timers
 };
 
 void
@@ -141,9 +156,21 @@ Bench::Cb (void)
 
   Time after = NanoSeconds (m_rand->GetValue ());
   Simulator::Schedule (after, &Bench::Cb, this);
+  // like retransmission timers, the timers are rescheduled long before
+  // they expire, which leaves cancelled events in the event list
+  for (uint32_t i = 0; i < m_cancel; ++i)
+    {
+      m_timers[i].Cancel ();
+      m_timers[i] = Simulator::Schedule (MilliSeconds (1), &Bench::Timeout, this);
+    }
   ++m_count;
 }
 
+void
+Bench::Timeout (void)
+{
+}
+
 
 Ptr<RandomVariableStream>
 GetRandomStream (std::string filename)
@@ -211,6 +238,8 @@ int main (int argc, char *argv[])
   uint32_t pop   =  100000;
   uint32_t total = 1000000;
   uint32_t runs  =       1;
+  uint32_t cancel =      0;
+  double compact =     0.5;
   std::string filename = "";
 
   CommandLine cmd;
@@ -230,6 +259,8 @@ int main (int argc, char *argv[])
   cmd.AddValue ("pop",   "event population size (default 1E5)",         pop);
   cmd.AddValue ("total", "total number of events to run (default 1E6)", total);
   cmd.AddValue ("runs",  "number of runs (default 1)",    runs);
+  cmd.AddValue ("cancel", "timers cancelled and rescheduled by each event (default 0)", cancel);
+  cmd.AddValue ("compact", "fraction of cancelled events compacted, 1 to disable (default 0.5)", compact);
   cmd.AddValue ("file",  "file of relative event times",  filename);
   cmd.AddValue ("prec",  "printed output precision",      g_fwidth);
   cmd.Parse (argc, argv);
@@ -249,6 +280,7 @@ int main (int argc, char *argv[])
     {
       factory.SetTypeId ("ns3::ListScheduler");
     }
+  factory.Set ("CompactionThreshold", DoubleValue (compact));
   Simulator::SetScheduler (factory);
 
   LOGME (std::setprecision (g_fwidth - 6));
@@ -258,9 +290,12 @@ int main (int argc, char *argv[])
   LOGME ("population: " << pop);
   LOGME ("total events: " << total);
   LOGME ("runs: " << runs);
+  LOGME ("cancelled timers per event: " << cancel);
+  LOGME ("compaction threshold: " << compact);
 
   Bench *bench = new Bench (pop, total);
   bench->SetRandomStream (GetRandomStream (filename));
+  bench->SetCancel (cancel);
 
   // table header
   LOG ("");
@@ -300,6 +335,13 @@ int main (int argc, char *argv[])
     }
 
   LOG ("");
+  Ptr<DefaultSimulatorImpl> impl = DynamicCast<DefaultSimulatorImpl> (Simulator::GetImplementation ());
+  if (impl != 0)
+    {
+      Ptr<Scheduler> scheduler = impl->GetScheduler ();
+      LOGME ("compactions: " << scheduler->GetCompactions ());
+      LOGME ("cancelled events compacted: " << scheduler->GetCompacted ());
+    }
   Simulator::Destroy ();
   delete bench;
   return 0;
@@ -0,0 +1,164 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program can be used to benchmark how the cost of a TCP connection
+// grows with the number of connections open on the same server node.
+// The number of connections is doubled at each step, up to --connections.
+// Sample usage:  ./waf --run 'bench-tcp-connections --connections=100000'
+
+#include "ns3/abort.h"
+#include "ns3/command-line.h"
+#include "ns3/simulator.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/socket.h"
+#include "ns3/packet.h"
+#include <iomanip>
+#include <iostream>
+
+using namespace ns3;
+
+#define LOG(x)   std::cout << x << std::endl
+
+/// Number of bytes received by the server
+static uint64_t g_received = 0;
+
+/// Maximum number of connections opened by a single client node
+static const uint32_t CONNECTIONS_PER_CLIENT = 16000;
+
+/**
+ * Read all the data available on a server socket.
+ * \param [in] socket The socket.
+ */
+static void
+ServerReceive (Ptr<Socket> socket)
+{
+  Ptr<Packet> p;
+  while ((p = socket->Recv ()))
+    {
+      g_received += p->GetSize ();
+    }
+}
+
+/**
+ * Set up a connection accepted by the server.
+ * \param [in] socket The socket of the new connection.
+ * \param [in] from The address of the client.
+ */
+static void
+ServerAccept (Ptr<Socket> socket, const Address &from)
+{
+  socket->SetRecvCallback (MakeCallback (&ServerReceive));
+}
+
+/**
+ * Send the data of a client once its connection is established.
+ * \param [in] bytes The number of bytes to send.
+ * \param [in] socket The client socket.
+ */
+static void
+ClientConnected (uint32_t bytes, Ptr<Socket> socket)
+{
+  socket->Send (Create<Packet> (bytes));
+}
+
+/**
+ * Open \p n connections to a single server port and time the simulation.
+ *
+ * \param [in] n The number of connections.
+ * \param [in] bytes The number of bytes sent on each connection.
+ */
+static void
+RunConnections (uint32_t n, uint32_t bytes)
+{
+  uint32_t nClients = (n + CONNECTIONS_PER_CLIENT - 1) / CONNECTIONS_PER_CLIENT;
+  NodeContainer server;
+  server.Create (1);
+  NodeContainer clients;
+  clients.Create (nClients);
+  NodeContainer all (server, clients);
+
+  SimpleNetDeviceHelper simple;
+  NetDeviceContainer devices = simple.Install (all);
+  InternetStackHelper internet;
+  internet.Install (all);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.0.0.0", "255.0.0.0");
+  Ipv4InterfaceContainer interfaces = ipv4.Assign (devices);
+
+  uint16_t port = 5000;
+  Ptr<Socket> listener = Socket::CreateSocket (server.Get (0), TcpSocketFactory::GetTypeId ());
+  listener->Bind (InetSocketAddress (Ipv4Address::GetAny (), port));
+  listener->Listen ();
+  listener->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                               MakeCallback (&ServerAccept));
+
+  // spread the connection attempts over one second
+  InetSocketAddress remote (interfaces.GetAddress (0), port);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Socket> socket = Socket::CreateSocket (clients.Get (i / CONNECTIONS_PER_CLIENT),
+                                                 TcpSocketFactory::GetTypeId ());
+      socket->Bind ();
+      socket->SetConnectCallback (MakeBoundCallback (&ClientConnected, bytes),
+                                  MakeNullCallback<void, Ptr<Socket> > ());
+      Simulator::Schedule (Seconds (1.0 * i / n), &Socket::Connect, socket, remote);
+    }
+
+  g_received = 0;
+  Simulator::Stop (Seconds (10));
+  SystemWallClockMs time;
+  time.Start ();
+  Simulator::Run ();
+  double elapsed = time.End () / 1000.0;
+  Simulator::Destroy ();
+
+  NS_ABORT_MSG_UNLESS (g_received == static_cast<uint64_t> (n) * bytes,
+                       "Received " << g_received << " bytes out of " << static_cast<uint64_t> (n) * bytes);
+  LOG (std::left << std::setw (14) << n <<
+       std::setw (14) << elapsed <<
+       (elapsed * 1e6 / n));
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t connections = 16000;
+  uint32_t first = 1000;
+  uint32_t bytes = 1000;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the cost of TCP connections sharing a server port,\n"
+             "doubling their number at each step.");
+  cmd.AddValue ("connections", "maximum number of connections", connections);
+  cmd.AddValue ("first", "number of connections of the first step", first);
+  cmd.AddValue ("bytes", "number of bytes sent on each connection", bytes);
+  cmd.Parse (argc, argv);
+
+  LOG ("bytes per connection: " << bytes);
+  LOG ("");
+  LOG (std::left << std::setw (14) << "Connections" <<
+       std::setw (14) << "Time (s)" <<
+       "Per (us/connection)");
+  for (uint32_t n = first; n <= connections; n *= 2)
+    {
+      RunConnections (n, bytes);
+    }
+  return 0;
+}
@@ -0,0 +1,284 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ns3/core-module.h"
+
+using namespace ns3;
+
+#define LOG(x)   std::cout << x << std::endl
+
+/** The operands of the timed operations. */
+struct Operands
+{
+  std::vector<double> seconds;     //!< Values in seconds.
+  std::vector<uint64_t> integers;  //!< Values in integer units.
+  std::vector<Time> times;         //!< Times.
+  std::vector<int64_t> scales;     //!< Integer scale factors.
+};
+
+/** An operation timed on all the operands. */
+typedef int64_t (*Operation)(const Operands & operands);
+
+/** \returns The sum of the Seconds of all the values. */
+int64_t
+FromSeconds (const Operands & operands)
+{
+  int64_t sum = 0;
+  for (std::size_t i = 0; i < operands.seconds.size (); ++i)
+    {
+      sum += Seconds (operands.seconds[i]).GetTimeStep ();
+    }
+  return sum;
+}
+
+/** \returns The sum of the MicroSeconds of all the integers. */
+int64_t
+FromMicroSeconds (const Operands & operands)
+{
+  int64_t sum = 0;
+  for (std::size_t i = 0; i < operands.integers.size (); ++i)
+    {
+      sum += MicroSeconds (operands.integers[i]).GetTimeStep ();
+    }
+  return sum;
+}
+
+/** \returns The sum of the PicoSeconds of all the integers. */
+int64_t
+FromPicoSeconds (const Operands & operands)
+{
+  int64_t sum = 0;
+  for (std::size_t i = 0; i < operands.integers.size (); ++i)
+    {
+      sum += PicoSeconds (operands.integers[i]).GetTimeStep ();
+    }
+  return sum;
+}
+
+/** \returns The number of Times smaller than their successor. */
+int64_t
+Compare (const Operands & operands)
+{
+  int64_t count = 0;
+  for (std::size_t i = 1; i < operands.times.size (); ++i)
+    {
+      count += operands.times[i - 1] < operands.times[i];
+    }
+  return count;
+}
+
+/** \returns The sum of all the Times. */
+int64_t
+Add (const Operands & operands)
+{
+  Time sum;
+  for (std::size_t i = 0; i < operands.times.size (); ++i)
+    {
+      sum += operands.times[i];
+    }
+  return sum.GetTimeStep ();
+}
+
+/** \returns The sum of the Times multiplied by integers. */
+int64_t
+Scale (const Operands & operands)
+{
+  Time sum;
+  for (std::size_t i = 0; i < operands.times.size (); ++i)
+    {
+      sum += operands.times[i] * operands.scales[i];
+    }
+  return sum.GetTimeStep ();
+}
+
+/** \returns The sum of the Times divided by integers. */
+int64_t
+Divide (const Operands & operands)
+{
+  Time sum;
+  for (std::size_t i = 0; i < operands.times.size (); ++i)
+    {
+      sum += operands.times[i] / operands.scales[i];
+    }
+  return sum.GetTimeStep ();
+}
+
+/** \returns The sum of the Times scaled by doubles. */
+int64_t
+ScaleDouble (const Operands & operands)
+{
+  Time sum;
+  for (std::size_t i = 0; i < operands.times.size (); ++i)
+    {
+      sum += Seconds (operands.times[i].GetSeconds () * 1.5);
+    }
+  return sum.GetTimeStep ();
+}
+
+/** \returns The sum of the GetSeconds of all the Times, truncated. */
+int64_t
+ToSeconds (const Operands & operands)
+{
+  double sum = 0;
+  for (std::size_t i = 0; i < operands.times.size (); ++i)
+    {
+      sum += operands.times[i].GetSeconds ();
+    }
+  return static_cast<int64_t> (sum);
+}
+
+/** \returns The sum of the GetMicroSeconds of all the Times. */
+int64_t
+ToMicroSeconds (const Operands & operands)
+{
+  int64_t sum = 0;
+  for (std::size_t i = 0; i < operands.times.size (); ++i)
+    {
+      sum += operands.times[i].GetMicroSeconds ();
+    }
+  return sum;
+}
+
+/**
+ * \returns The sum of the transmission times of the integers, as
+ * bytes, at 10 Mb/s, computed as by DataRate::CalculateBytesTxTime.
+ */
+int64_t
+TxTime (const Operands & operands)
+{
+  const double bps = 10e6;
+  int64_t sum = 0;
+  for (std::size_t i = 0; i < operands.integers.size (); ++i)
+    {
+      sum += Seconds (static_cast<double> (operands.integers[i]) * 8 / bps).GetTimeStep ();
+    }
+  return sum;
+}
+
+/**
+ * Time an operation.
+ *
+ * \param [in] name The label to print.
+ * \param [in] operation The operation.
+ * \param [in] operands The operands.
+ * \param [in] runs The number of times to run \p operation.
+ */
+void
+Run (std::string name, Operation operation, const Operands & operands, uint32_t runs)
+{
+  SystemWallClockMs time;
+  int64_t check = 0;
+  time.Start ();
+  for (uint32_t i = 0; i < runs; ++i)
+    {
+      check += (*operation)(operands);
+    }
+  double elapsed = time.End () / 1000.0;
+  double n = static_cast<double> (runs) * operands.times.size ();
+
+  LOG (std::left << std::setw (20) << name <<
+       std::setw (14) << elapsed <<
+       std::setw (14) << (elapsed * 1e9 / n) <<
+       check);
+}
+
+/**
+ * Time all the operations.
+ *
+ * \param [in] operands The operands.
+ * \param [in] runs The number of times to run each operation.
+ * \param [in] resolution The time resolution name.
+ */
+void
+RunAll (const Operands & operands, uint32_t runs, std::string resolution)
+{
+  LOG ("resolution: " << resolution << ", size: " << operands.times.size () << ", runs: " << runs);
+  LOG ("");
+  LOG (std::left << std::setw (20) << "Operation" <<
+       std::setw (14) << "Time (s)" <<
+       std::setw (14) << "Per (ns/op)" <<
+       "Check");
+  Run ("Seconds (double)", &FromSeconds, operands, runs);
+  Run ("MicroSeconds", &FromMicroSeconds, operands, runs);
+  Run ("PicoSeconds", &FromPicoSeconds, operands, runs);
+  Run ("operator <", &Compare, operands, runs);
+  Run ("operator +=", &Add, operands, runs);
+  Run ("operator * int", &Scale, operands, runs);
+  Run ("operator / int", &Divide, operands, runs);
+  Run ("scale by double", &ScaleDouble, operands, runs);
+  Run ("GetSeconds", &ToSeconds, operands, runs);
+  Run ("GetMicroSeconds", &ToMicroSeconds, operands, runs);
+  Run ("bytes tx time", &TxTime, operands, runs);
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t size = 10000;
+  uint32_t runs = 1000;
+  std::string resolution = "ns";
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the construction, comparison, scaling and conversion\n"
+             "of Time values.");
+  cmd.AddValue ("size", "number of operands", size);
+  cmd.AddValue ("runs", "number of runs over the operands", runs);
+  cmd.AddValue ("resolution", "time resolution: fs, ps, ns, us or ms", resolution);
+  cmd.Parse (argc, argv);
+
+  if (resolution == "fs")
+    {
+      Time::SetResolution (Time::FS);
+    }
+  else if (resolution == "ps")
+    {
+      Time::SetResolution (Time::PS);
+    }
+  else if (resolution == "us")
+    {
+      Time::SetResolution (Time::US);
+    }
+  else if (resolution == "ms")
+    {
+      Time::SetResolution (Time::MS);
+    }
+  else if (resolution != "ns")
+    {
+      NS_FATAL_ERROR ("Unknown resolution " << resolution);
+    }
+
+  Ptr<UniformRandomVariable> uniform = CreateObject<UniformRandomVariable> ();
+  Operands operands;
+  for (uint32_t i = 0; i < size; ++i)
+    {
+      operands.seconds.push_back (uniform->GetValue (0, 10));
+      operands.integers.push_back (uniform->GetInteger (1, 1500));
+      operands.times.push_back (MicroSeconds (uniform->GetInteger (0, 10000000)));
+      operands.scales.push_back (uniform->GetInteger (1, 100));
+    }
+
+  // Time the operations in an event, as Times created before
+  // Simulator::Run are recorded in case the resolution changes.
+  Simulator::Schedule (Seconds (0), &RunAll, operands, runs, resolution);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  return 0;
+}
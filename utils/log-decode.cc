@@ -0,0 +1,57 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <fstream>
+#include <iostream>
+
+#include "ns3/core-module.h"
+
+using namespace ns3;
+
+int main (int argc, char *argv[])
+{
+  std::string file;
+  std::string output;
+
+  CommandLine cmd;
+  cmd.Usage ("Print the messages of a binary log file, recorded with\n"
+             "NS_LOG='binary=<file>:...', as they would have been logged\n"
+             "on std::clog.");
+  cmd.AddValue ("file", "the binary log file", file);
+  cmd.AddValue ("output", "the text file to write, instead of the standard output", output);
+  cmd.Parse (argc, argv);
+
+  if (file.empty ())
+    {
+      NS_FATAL_ERROR ("No binary log file; use --file=<file>");
+    }
+  std::ifstream is (file.c_str (), std::ios::in | std::ios::binary);
+  if (!is.good ())
+    {
+      NS_FATAL_ERROR ("Could not open \"" << file << "\"");
+    }
+
+  if (output.empty ())
+    {
+      LogBinaryDecode (is, std::cout);
+    }
+  else
+    {
+      std::ofstream os (output.c_str ());
+      LogBinaryDecode (is, os);
+    }
+  return 0;
+}